@@ -123,6 +123,43 @@ extern "C"
 	*/
 	extern IOTHUB_CLIENT_RESULT IoTHubClient_GetSendStatus(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATUS *iotHubClientStatus);
 
+	/**
+	* @brief	This function returns how many events, and how many bytes of content,
+	* 			are waiting to be confirmed. See ::IoTHubClient_LL_GetOutboundQueueSize.
+	*
+	* @param	iotHubClientHandle		The handle created by a call to the create function.
+	* @param	messageCount			Receives the number of events.
+	* @param	byteCount				Receives the number of bytes.
+	*
+	* @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+	*/
+	extern IOTHUB_CLIENT_RESULT IoTHubClient_GetOutboundQueueSize(IOTHUB_CLIENT_HANDLE iotHubClientHandle, size_t* messageCount, size_t* byteCount);
+
+	/**
+	* @brief	This function copies the metrics of the client without taking its lock,
+	* 			so it never waits for the worker thread. See ::IoTHubClient_LL_GetMetrics.
+	*
+	* @param	iotHubClientHandle		The handle created by a call to the create function.
+	* @param	snapshot				Receives the metrics.
+	*
+	* @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+	*/
+	extern IOTHUB_CLIENT_RESULT IoTHubClient_GetMetrics(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot);
+
+	/**
+	* @brief	Sets up a callback that receives the confirmations of many events in one call.
+	* 			See ::IoTHubClient_LL_SetEventConfirmationBatchCallback. The callback is called
+	* 			from the worker thread.
+	*
+	* @param	iotHubClientHandle		The handle created by a call to the create function.
+	* @param	batchCallback			The callback, @c NULL turns the batching off.
+	* @param	userContextCallback		User specified context that will be provided to the
+	* 									callback. This can be @c NULL.
+	*
+	* @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+	*/
+	extern IOTHUB_CLIENT_RESULT IoTHubClient_SetEventConfirmationBatchCallback(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_BATCH_CALLBACK batchCallback, void* userContextCallback);
+
 	/**
 	* @brief	Sets up the message callback to be invoked when IoT Hub issues a
 	* 			message to the device. This is a blocking call.
@@ -158,8 +195,8 @@ extern "C"
     extern IOTHUB_CLIENT_RESULT IoTHubClient_SetConnectionStatusCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK connectionStatusCallback, void* userContextCallback);
 
     /**
-    * @brief	Sets up the connection status callback to be invoked representing the status of
-    * the connection to IOT Hub. This is a blocking call.
+    * @brief	Sets the policy used by the transport to reconnect to IoT Hub. By default the
+    * transport uses ::IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER with no time limit.
     *
     * @param	iotHubClientHandle		   	        The handle created by a call to the create function.
     * @param	retryPolicy                  	   	The policy to use to reconnect to IoT Hub when a
@@ -172,11 +209,11 @@ extern "C"
     *
     * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
     */
-    extern IOTHUB_CLIENT_RESULT IoTHubClient_SetRetryPolicy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitinSeconds);
+    extern IOTHUB_CLIENT_RESULT IoTHubClient_SetRetryPolicy(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitinSeconds);
 
     /**
-    * @brief	Sets up the connection status callback to be invoked representing the status of
-    * the connection to IOT Hub. This is a blocking call.
+    * @brief	Retrieves the policy set by the last call to the SetRetryPolicy function,
+    * or the default policy.
     *
     * @param	iotHubClientHandle		   	        The handle created by a call to the create function.
     * @param	retryPolicy                  	   	Out parameter containing the policy to use to reconnect to IoT Hub.
@@ -188,7 +225,7 @@ extern "C"
     *
     * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
     */
-    extern IOTHUB_CLIENT_RESULT IoTHubClient_GetRetryPolicy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY* retryPolicy, size_t* retryTimeoutLimitinSeconds);
+    extern IOTHUB_CLIENT_RESULT IoTHubClient_GetRetryPolicy(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY* retryPolicy, size_t* retryTimeoutLimitinSeconds);
 
 	/**
 	* @brief	This function returns in the out parameter @p lastMessageReceiveTime
@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_allocations.h
+*	@brief The allocation functions that account the memory of the SDK per module.
+*
+*	@details These functions are not called by name. When the SDK is built with the
+*			 use_allocation_tags CMake option, every source of iothub_client and of the
+*			 serializer is compiled with malloc, calloc and realloc defined as the functions
+*			 of its ::IOTHUB_CLIENT_ALLOCATION_TAG, and with free defined as
+*			 ::iothub_client_free_tagged (see tagAllocations in the top CMakeLists.txt).
+*			 Every accounted block is a block of the C runtime that keeps its size and its tag
+*			 in a small trailer, at the end of its usable size. ::iothub_client_free_tagged also
+*			 frees the blocks that the SDK gets from the shared utility, without accounting them,
+*			 and an accounted block freed with the plain free stays accounted. The blocks that
+*			 the SDK hands over to the application, which frees them with its own free, are
+*			 allocated with IOTHUB_CLIENT_MALLOC_CALLER_OWNED instead: they are counted as
+*			 allocations, but neither as memory of the tag nor as leaks.
+*
+*			 When the environment variable IOTHUB_CLIENT_ALLOCATION_REPORT is "1" at the first
+*			 accounted allocation, the memory that is still allocated, the peak and the number
+*			 of allocations of every tag are written to stderr when the process exits. With
+*			 "strict", the process also exits with EXIT_FAILURE when a block is still allocated,
+*			 which makes a test suite fail on a leak.
+*/
+
+#ifndef IOTHUB_CLIENT_ALLOCATIONS_H
+#define IOTHUB_CLIENT_ALLOCATIONS_H
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C"
+{
+#else
+#include <stddef.h>
+#endif
+
+#define IOTHUB_CLIENT_ALLOCATION_REPORT_VARIABLE "IOTHUB_CLIENT_ALLOCATION_REPORT"
+
+#define DECLARE_TAGGED_ALLOCATION_FUNCTIONS(name)                                        \
+    extern void* iothub_client_malloc_##name(size_t size);                              \
+    extern void* iothub_client_calloc_##name(size_t nmemb, size_t size);                \
+    extern void* iothub_client_realloc_##name(void* ptr, size_t size);                  \
+    extern void* iothub_client_malloc_caller_owned_##name(size_t size);
+
+DECLARE_TAGGED_ALLOCATION_FUNCTIONS(client)
+DECLARE_TAGGED_ALLOCATION_FUNCTIONS(message)
+DECLARE_TAGGED_ALLOCATION_FUNCTIONS(queue)
+DECLARE_TAGGED_ALLOCATION_FUNCTIONS(transport)
+DECLARE_TAGGED_ALLOCATION_FUNCTIONS(upload)
+DECLARE_TAGGED_ALLOCATION_FUNCTIONS(serializer)
+
+/*frees the blocks of every tag, and the blocks that were not accounted*/
+extern void iothub_client_free_tagged(void* ptr);
+
+/*tagAllocations defines it as iothub_client_malloc_caller_owned_<tag>, it is the plain malloc otherwise*/
+#ifndef IOTHUB_CLIENT_MALLOC_CALLER_OWNED
+#define IOTHUB_CLIENT_MALLOC_CALLER_OWNED malloc
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_ALLOCATIONS_H */
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_callback_dispatcher.h
+*	@brief A thread that runs the application callbacks of IoTHubClient.
+*
+*	@details The worker thread (or the thread of a shared transport) posts
+*			 items while it holds the client lock and goes back to network
+*			 work at once; the dispatcher thread runs the items, oldest
+*			 first, without holding any lock of the client. Posting does
+*			 not allocate: the item is embedded in the structure that
+*			 carries the callback, see containingRecord.
+*/
+
+#ifndef IOTHUB_CLIENT_CALLBACK_DISPATCHER_H
+#define IOTHUB_CLIENT_CALLBACK_DISPATCHER_H
+
+#include "iothub_client_ingress_queue.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+struct CALLBACK_DISPATCHER_ITEM_TAG;
+
+/*runs on the dispatcher thread (or on the thread that calls callback_dispatcher_destroy), can free the item*/
+typedef void(*CALLBACK_DISPATCHER_FUNCTION)(struct CALLBACK_DISPATCHER_ITEM_TAG* item);
+
+typedef struct CALLBACK_DISPATCHER_ITEM_TAG
+{
+    INGRESS_QUEUE_ENTRY entry;
+    CALLBACK_DISPATCHER_FUNCTION function;
+} CALLBACK_DISPATCHER_ITEM;
+
+typedef struct CALLBACK_DISPATCHER_INSTANCE_TAG* CALLBACK_DISPATCHER_HANDLE;
+
+/**
+* @brief	Creates a dispatcher and starts its thread.
+*/
+MOCKABLE_FUNCTION(, CALLBACK_DISPATCHER_HANDLE, callback_dispatcher_create);
+
+/**
+* @brief	Stops the thread, runs the items that are still posted on the calling thread and frees the dispatcher.
+*			Shall not be called from an item.
+*/
+MOCKABLE_FUNCTION(, void, callback_dispatcher_destroy, CALLBACK_DISPATCHER_HANDLE, dispatcher);
+
+/**
+* @brief	Queues @p item; @p function will be called with it on the dispatcher thread. Can be called from any thread.
+*
+* @return	0 on success, non-zero if an argument is NULL.
+*/
+MOCKABLE_FUNCTION(, int, callback_dispatcher_post, CALLBACK_DISPATCHER_HANDLE, dispatcher, CALLBACK_DISPATCHER_ITEM*, item, CALLBACK_DISPATCHER_FUNCTION, function);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_CALLBACK_DISPATCHER_H */
@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_compression.h
+*	@brief Compression stage for the bodies of outbound events.
+*
+*	@details The codec is an LZ77 coder that writes the LZ4 block format, so
+*			 a service can decode the bodies with any LZ4 library
+*			 (LZ4_decompress_safe_usingDict). The body is prefixed with its
+*			 uncompressed size. An optional shared dictionary, for example
+*			 a concatenation of typical messages, is seen by the coder as
+*			 data sent just before every body, which is what makes small
+*			 JSON messages compress. The stage runs in the LL client before
+*			 any transport serializes the event.
+*/
+
+#ifndef IOTHUB_CLIENT_COMPRESSION_H
+#define IOTHUB_CLIENT_COMPRESSION_H
+
+#include "iothub_message.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C"
+{
+#else
+#include <stddef.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/*application property added to compressed events and its value*/
+#define COMPRESSION_CONTENT_ENCODING_PROPERTY   "content-encoding"
+#define COMPRESSION_CONTENT_ENCODING            "lz4-block"
+/*application property added to compressed events when a dictionary id is given*/
+#define COMPRESSION_DICTIONARY_PROPERTY         "content-dictionary"
+/*only the last COMPRESSION_MAX_DICTIONARY_SIZE bytes of a dictionary can be referenced*/
+#define COMPRESSION_MAX_DICTIONARY_SIZE         65535
+/*size of the uncompressed size that prefixes every compressed body*/
+#define COMPRESSION_HEADER_SIZE                 4
+
+typedef struct COMPRESSION_INSTANCE_TAG* COMPRESSION_HANDLE;
+
+/**
+* @brief	Creates a compressor.
+*
+* @param	dictionary      The shared dictionary, can be NULL. It is copied.
+* @param	dictionarySize  The size of the dictionary, 0 if there is none.
+*
+* @return	A @c COMPRESSION_HANDLE or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, COMPRESSION_HANDLE, compression_create, const unsigned char*, dictionary, size_t, dictionarySize);
+
+MOCKABLE_FUNCTION(, void, compression_destroy, COMPRESSION_HANDLE, compression);
+
+/**
+* @brief	Returns the size of the biggest compressed body for a body of @p size bytes.
+*/
+MOCKABLE_FUNCTION(, size_t, compression_get_bound, size_t, size);
+
+/**
+* @brief	Compresses @p size bytes of @p source into @p destination.
+*
+* @param	destinationSize     In: the capacity of @p destination. Out: the size of the compressed body.
+*
+* @return	0 on success, non-zero if the arguments are invalid or the compressed body does not fit.
+*/
+MOCKABLE_FUNCTION(, int, compression_compress, COMPRESSION_HANDLE, compression, const unsigned char*, source, size_t, size, unsigned char*, destination, size_t*, destinationSize);
+
+/**
+* @brief	Decompresses a body produced by compression_compress with the same dictionary.
+*
+* @param	destinationSize     In: the capacity of @p destination. Out: the size of the uncompressed body.
+*
+* @return	0 on success, non-zero if the body is corrupt or does not fit in @p destination.
+*/
+MOCKABLE_FUNCTION(, int, compression_decompress, COMPRESSION_HANDLE, compression, const unsigned char*, source, size_t, size, unsigned char*, destination, size_t*, destinationSize);
+
+/**
+* @brief	Makes the copy of an event that is handed to the transport. The copy has the compressed
+*			body, the properties, message id, correlation id and priority of the event, and the
+*			content-encoding property. If compressing does not make the body smaller the copy is
+*			a plain clone of the event.
+*
+* @param	dictionaryId    Value of the content-dictionary property, can be NULL.
+*
+* @return	The copy or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, compression_compress_message, COMPRESSION_HANDLE, compression, IOTHUB_MESSAGE_HANDLE, message, const char*, dictionaryId);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_COMPRESSION_H */
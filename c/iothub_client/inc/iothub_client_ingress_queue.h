@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_ingress_queue.h
+*	@brief Multiple producer, single consumer queue that hands events from
+*		   application threads to the worker thread of IoTHubClient.
+*
+*	@details Producers push with a compare-and-swap on the head of an
+*			 intrusive list and never wait for the worker thread, even while
+*			 it is blocked in IoTHubClient_LL_DoWork. The consumer takes the
+*			 whole list with one exchange and walks it in the order the
+*			 entries were pushed. Platforms without pointer atomics use a
+*			 lock that is held only for the pointer updates.
+*/
+
+#ifndef IOTHUB_CLIENT_INGRESS_QUEUE_H
+#define IOTHUB_CLIENT_INGRESS_QUEUE_H
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C"
+{
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/*an entry is embedded in the structure that is queued, see containingRecord*/
+typedef struct INGRESS_QUEUE_ENTRY_TAG
+{
+    struct INGRESS_QUEUE_ENTRY_TAG* next;
+} INGRESS_QUEUE_ENTRY;
+
+typedef struct INGRESS_QUEUE_INSTANCE_TAG* INGRESS_QUEUE_HANDLE;
+
+/*called by ingress_queue_drain for every entry, the entry is no longer in the queue and can be freed*/
+typedef void(*INGRESS_QUEUE_ENTRY_CALLBACK)(INGRESS_QUEUE_ENTRY* entry, void* context);
+
+MOCKABLE_FUNCTION(, INGRESS_QUEUE_HANDLE, ingress_queue_create);
+
+/**
+* @brief	Destroys the queue. Entries that were not drained are not touched, drain them first.
+*/
+MOCKABLE_FUNCTION(, void, ingress_queue_destroy, INGRESS_QUEUE_HANDLE, queue);
+
+/**
+* @brief	Adds @p entry to the queue. Can be called from any thread and does not block.
+*
+* @return	0 on success, non-zero if an argument is NULL.
+*/
+MOCKABLE_FUNCTION(, int, ingress_queue_push, INGRESS_QUEUE_HANDLE, queue, INGRESS_QUEUE_ENTRY*, entry);
+
+/**
+* @brief	Removes all the entries from the queue and calls @p callback for each of them, oldest first.
+*			Only one thread at a time shall drain a queue.
+*
+* @return	The number of entries given to @p callback.
+*/
+MOCKABLE_FUNCTION(, size_t, ingress_queue_drain, INGRESS_QUEUE_HANDLE, queue, INGRESS_QUEUE_ENTRY_CALLBACK, callback, void*, context);
+
+/**
+* @brief	Returns true when there is no entry in the queue (or @p queue is NULL).
+*/
+MOCKABLE_FUNCTION(, bool, ingress_queue_is_empty, INGRESS_QUEUE_HANDLE, queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_INGRESS_QUEUE_H */
@@ -30,7 +30,8 @@
     IOTHUB_CLIENT_INVALID_ARG,            \
     IOTHUB_CLIENT_ERROR,                  \
     IOTHUB_CLIENT_INVALID_SIZE,           \
-    IOTHUB_CLIENT_INDEFINITE_TIME         \
+    IOTHUB_CLIENT_INDEFINITE_TIME,        \
+    IOTHUB_CLIENT_QUEUE_FULL              \
 
 /** @brief Enumeration specifying the status of calls to various APIs in this module.
 */
@@ -56,6 +57,7 @@ DEFINE_ENUM(IOTHUB_CLIENT_STATUS, IOTHUB_CLIENT_STATUS_VALUES);
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "iothub_message.h"
 #include "iothub_transport_ll.h"
+#include "iothub_client_metrics.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -132,8 +134,39 @@ extern "C"
     */
     DEFINE_ENUM(IOTHUB_CLIENT_RETRY_POLICY, IOTHUB_CLIENT_RETRY_POLICY_VALUES);
 
+#define IOTHUB_CLIENT_QUEUE_OVERFLOW_POLICY_VALUES \
+    IOTHUB_CLIENT_QUEUE_OVERFLOW_REJECT,           \
+    IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST,      \
+    IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK
+
+    /** @brief Enumeration specifying what happens to an event that does not fit
+    *		   in the outbound queue bounded by ::OPTION_OUTBOUND_QUEUE_LIMITS.
+    */
+    DEFINE_ENUM(IOTHUB_CLIENT_QUEUE_OVERFLOW_POLICY, IOTHUB_CLIENT_QUEUE_OVERFLOW_POLICY_VALUES);
+
+#define IOTHUB_CLIENT_COMPRESSION_ALGORITHM_VALUES \
+    IOTHUB_CLIENT_COMPRESSION_NONE,                \
+    IOTHUB_CLIENT_COMPRESSION_LZ4
+
+    /** @brief Enumeration specifying how ::OPTION_COMPRESSION compresses the bodies of the events.
+    *		   @c IOTHUB_CLIENT_COMPRESSION_NONE turns the compression off.
+    */
+    DEFINE_ENUM(IOTHUB_CLIENT_COMPRESSION_ALGORITHM, IOTHUB_CLIENT_COMPRESSION_ALGORITHM_VALUES);
+
 	
 	typedef void(*IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK)(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback);
+
+    /** @brief	The confirmation of one event, as given to an ::IOTHUB_CLIENT_EVENT_CONFIRMATION_BATCH_CALLBACK.
+    */
+    typedef struct IOTHUB_CLIENT_EVENT_CONFIRMATION_TAG
+    {
+        void* userContextCallback; /*the userContextCallback of ::IoTHubClient_LL_SendEventAsync*/
+        IOTHUB_CLIENT_CONFIRMATION_RESULT result;
+    } IOTHUB_CLIENT_EVENT_CONFIRMATION;
+
+    /** @brief	Receives the confirmations of the events that completed together, oldest first. The array is only valid during the call.
+    */
+    typedef void(*IOTHUB_CLIENT_EVENT_CONFIRMATION_BATCH_CALLBACK)(const IOTHUB_CLIENT_EVENT_CONFIRMATION* confirmations, size_t confirmationCount, void* userContextCallback);
     typedef void(*IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK)(IOTHUB_CLIENT_CONNECTION_STATUS result, IOTHUB_CLIENT_CONNECTION_STATUS_REASON reason, void* userContextCallback);
 	typedef IOTHUBMESSAGE_DISPOSITION_RESULT (*IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC)(IOTHUB_MESSAGE_HANDLE message, void* userContextCallback);
 	typedef const TRANSPORT_PROVIDER*(*IOTHUB_CLIENT_TRANSPORT_PROVIDER)(void);
@@ -191,11 +224,63 @@ extern "C"
 		const char* deviceSasToken;
 	} IOTHUB_CLIENT_DEVICE_CONFIG;
 
+	/** @brief	This struct captures the bounds of the outbound queue, the value of ::OPTION_OUTBOUND_QUEUE_LIMITS. */
+	typedef struct IOTHUB_CLIENT_QUEUE_LIMITS_TAG
+	{
+		/** @brief	Maximum number of events accepted and not yet confirmed, 0 means no limit. */
+		size_t maxMessages;
+
+		/** @brief	Maximum number of content bytes of the events accepted and not yet confirmed, 0 means no limit. */
+		size_t maxBytes;
+
+		/** @brief	@c IOTHUB_CLIENT_QUEUE_OVERFLOW_REJECT fails the send with @c IOTHUB_CLIENT_QUEUE_FULL,
+		*	@c IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST completes the oldest events not yet handed to the transport
+		*	with @c IOTHUB_CLIENT_CONFIRMATION_ERROR to make room, @c IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK makes
+		*	@c IoTHubClient_SendEventAsync wait for room (@c IoTHubClient_LL_SendEventAsync behaves as REJECT). */
+		IOTHUB_CLIENT_QUEUE_OVERFLOW_POLICY overflowPolicy;
+
+		/** @brief	@c IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK only: how long @c IoTHubClient_SendEventAsync waits for room. */
+		size_t blockTimeoutInMilliseconds;
+	} IOTHUB_CLIENT_QUEUE_LIMITS;
+
+	/** @brief	This struct captures the share of the bandwidth each priority lane gets while several
+	*	lanes have events waiting, the value of ::OPTION_PRIORITY_WEIGHTS. A lane with weight 4 sends
+	*	4 events for every event of a lane with weight 1. Weights go from 1 to 1000. By default the weights
+	*	are 1 for @c IOTHUB_MESSAGE_PRIORITY_LOW, 4 for @c IOTHUB_MESSAGE_PRIORITY_NORMAL and 16 for
+	*	@c IOTHUB_MESSAGE_PRIORITY_HIGH. */
+	typedef struct IOTHUB_CLIENT_PRIORITY_WEIGHTS_TAG
+	{
+		size_t low;
+		size_t normal;
+		size_t high;
+	} IOTHUB_CLIENT_PRIORITY_WEIGHTS;
+
+	/** @brief	This struct captures the compression of the bodies of the events, the value of ::OPTION_COMPRESSION.
+	*	A compressed event carries the "content-encoding" property set to "lz4-block" and, if a dictionary id is
+	*	given, the "content-dictionary" property. Its body is the uncompressed size (4 bytes, little endian)
+	*	followed by an LZ4 block, see iothub_client_compression.h. */
+	typedef struct IOTHUB_CLIENT_COMPRESSION_CONFIG_TAG
+	{
+		IOTHUB_CLIENT_COMPRESSION_ALGORITHM algorithm;
+
+		/** @brief	Shared dictionary, for example a concatenation of typical messages, can be NULL. It is copied,
+		*	only its last 64KB are used. The receiver needs the same dictionary. */
+		const unsigned char* dictionary;
+		size_t dictionarySize;
+
+		/** @brief	Sent in the "content-dictionary" property so that the receiver picks the right dictionary, can be NULL. */
+		const char* dictionaryId;
+
+		/** @brief	Events with a smaller body are sent as they are. */
+		size_t minimumSize;
+	} IOTHUB_CLIENT_COMPRESSION_CONFIG;
+
 	/** @brief	This struct captures IoTHub transport configuration. */
 	struct IOTHUBTRANSPORT_CONFIG_TAG
 	{
 		const IOTHUB_CLIENT_CONFIG* upperConfig;
 		PDLIST_ENTRY waitingToSend;
+		IOTHUB_CLIENT_METRICS* metrics; /*where the transport counts its TRANSPORT_* metrics, can be NULL*/
 	};
 
 
@@ -265,7 +350,10 @@ extern "C"
 	* 										message. The user can specify a @c NULL value here to
 	* 										indicate that no callback is required.
 	* @param	userContextCallback			User specified context that will be provided to the
-	* 										callback. This can be @c NULL.
+	* 										callback. This can be @c NULL. When eventConfirmationCallback
+	* 										is @c NULL and a batch callback is set (see
+	* 										::IoTHubClient_LL_SetEventConfirmationBatchCallback), a non-NULL
+	* 										value is given to the batch callback instead.
 	*
 	*			@b NOTE: The application behavior is undefined if the user calls
 	*			the ::IoTHubClient_LL_Destroy function from within any callback.
@@ -288,6 +376,58 @@ extern "C"
 	*/
 	extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetSendStatus(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATUS *iotHubClientStatus);
 
+	/**
+	* @brief	This function returns how many events, and how many bytes of content,
+	* 			have been accepted by ::IoTHubClient_LL_SendEventAsync and not confirmed yet.
+	* 			Producers can use it to slow down before the limits are hit.
+	*
+	* @param	iotHubClientHandle		The handle created by a call to the create function.
+	* @param	messageCount			Receives the number of events.
+	* @param	byteCount				Receives the number of bytes.
+	*
+	* @return	IOTHUB_CLIENT_OK upon success or an error code upon failure. The events are only
+	* 			counted once ::OPTION_OUTBOUND_QUEUE_LIMITS or ::OPTION_PERSISTENT_QUEUE is set, before
+	* 			that the function returns IOTHUB_CLIENT_ERROR.
+	*/
+	extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetOutboundQueueSize(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, size_t* messageCount, size_t* byteCount);
+
+	/**
+	* @brief	This function copies the metrics of the client: how many events are queued and
+	* 			in flight, how they were confirmed, how long the confirmations took and what the
+	* 			transport sent and received. It does not take any lock, so it can be called from
+	* 			any thread while the client works, for instance to answer a scrape.
+	*
+	* @param	iotHubClientHandle		The handle created by a call to the create function.
+	* @param	snapshot				Receives the metrics, see ::IOTHUB_CLIENT_METRIC and
+	* 									::IOTHUB_CLIENT_HISTOGRAM. When the client was created with
+	* 									a shared transport the TRANSPORT_* values are 0, they are
+	* 									given by ::IoTHubTransport_GetMetrics for all the clients
+	* 									of the transport.
+	*
+	* @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+	*/
+	extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetMetrics(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot);
+
+	/**
+	* @brief	Sets up a callback that receives the confirmations of many events in one call,
+	* 			instead of one ::IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK call per event. The events
+	* 			that use it are sent with a @c NULL eventConfirmationCallback and a non-NULL
+	* 			userContextCallback, which the batch callback receives with the result of the event.
+	* 			The confirmations gathered during one call of the client (a completion reported by
+	* 			the transport, ::IoTHubClient_LL_DoWork, ::IoTHubClient_LL_SendEventAsync or
+	* 			::IoTHubClient_LL_Destroy) are given in one call at its end.
+	*
+	* @param	iotHubClientHandle		The handle created by a call to the create function.
+	* @param	batchCallback			The callback, @c NULL turns the batching off. The events
+	* 									sent for the batch callback and not confirmed yet are then
+	* 									not reported.
+	* @param	userContextCallback		User specified context that will be provided to the
+	* 									callback. This can be @c NULL.
+	*
+	* @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+	*/
+	extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetEventConfirmationBatchCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_BATCH_CALLBACK batchCallback, void* userContextCallback);
+
 	/**
 	* @brief	Sets up the message callback to be invoked when IoT Hub issues a
 	* 			message to the device. This is a blocking call.
@@ -323,14 +463,17 @@ extern "C"
     extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetConnectionStatusCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK connectionStatusCallback, void* userContextCallback);
 
     /**
-    * @brief	Sets up the connection status callback to be invoked representing the status of
-    * the connection to IOT Hub. This is a blocking call.
+    * @brief	Sets the policy used by the transport to reconnect to IoT Hub. By default the
+    * transport uses ::IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER with no time limit.
     *
     * @param	iotHubClientHandle		   	        The handle created by a call to the create function.
     * @param	retryPolicy                  	   	The policy to use to reconnect to IoT Hub when a
     *                                               connection drops.
     * @param	retryTimeoutLimitinSeconds			Maximum amount of time(seconds) to attempt reconnection when a
-    *                                               connection drops to IOT Hub.
+    *                                               connection drops to IOT Hub, 0 for no limit.
+    *
+    *			The policy belongs to the transport, so it cannot be set on a handle created
+    *			with ::IoTHubClient_LL_CreateWithTransport: the call returns IOTHUB_CLIENT_ERROR.
     *
     *			@b NOTE: The application behavior is undefined if the user calls
     *			the ::IoTHubClient_LL_Destroy function from within any callback.
@@ -341,8 +484,8 @@ extern "C"
 
 
     /**
-    * @brief	Sets up the connection status callback to be invoked representing the status of
-    * the connection to IOT Hub. This is a blocking call.
+    * @brief	Retrieves the policy set by the last call to the SetRetryPolicy function,
+    * or the default policy.
     *
     * @param	iotHubClientHandle		   	        The handle created by a call to the create function.
     * @param	retryPolicy                  	   	Out parameter containing the policy to use to reconnect to IoT Hub.
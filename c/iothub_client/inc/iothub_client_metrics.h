@@ -0,0 +1,212 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_metrics.h
+*	@brief Counters, gauges and histograms kept by IoTHubClient_LL and the
+*		   transports.
+*
+*	@details The metrics live in the structure of the client or of the shared
+*			 transport, so keeping them allocates nothing. Every update is one
+*			 atomic operation and a snapshot can be taken from any thread,
+*			 without the lock of the client. Compilers without 64 bit atomics
+*			 use plain reads and writes: the updates of an object are already
+*			 serialized by the lock of the client or of the transport, only a
+*			 snapshot taken at the same time can see a torn value.
+*
+*			 The memory of the SDK modules is accounted apart, see
+*			 ::iothub_client_metrics_get_allocations.
+*/
+
+#ifndef IOTHUB_CLIENT_METRICS_H
+#define IOTHUB_CLIENT_METRICS_H
+
+#include "azure_c_shared_utility/macro_utils.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C"
+{
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/*the first three are gauges, the others only grow*/
+#define IOTHUB_CLIENT_METRIC_VALUES                             \
+    IOTHUB_CLIENT_METRIC_EVENTS_QUEUED,                         \
+    IOTHUB_CLIENT_METRIC_EVENTS_IN_FLIGHT,                      \
+    IOTHUB_CLIENT_METRIC_OUTBOUND_QUEUE_BYTES,                  \
+    IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_OK,                   \
+    IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_BECAUSE_DESTROY,      \
+    IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_MESSAGE_TIMEOUT,      \
+    IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_ERROR,                \
+    IOTHUB_CLIENT_METRIC_MESSAGES_RECEIVED,                     \
+    IOTHUB_CLIENT_METRIC_TRANSPORT_EVENTS_SENT,                 \
+    IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_SENT,                  \
+    IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_RECEIVED,              \
+    IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS,                    \
+    IOTHUB_CLIENT_METRIC_TRANSPORT_AUTH_REFRESHES               \
+
+/** @brief	The values of ::IOTHUB_CLIENT_METRICS_SNAPSHOT.
+*
+*			- EVENTS_QUEUED: events in memory that no transport has taken yet.
+*			- EVENTS_IN_FLIGHT: events taken by the transport and not confirmed yet.
+*			- OUTBOUND_QUEUE_BYTES: the bytes of ::IoTHubClient_LL_GetOutboundQueueSize, 0 unless
+*			  ::OPTION_OUTBOUND_QUEUE_LIMITS is set.
+*			- EVENTS_CONFIRMED_*: events confirmed to the application, one per ::IOTHUB_CLIENT_CONFIRMATION_RESULT.
+*			- MESSAGES_RECEIVED: messages given to the message callback.
+*			- TRANSPORT_*: kept by the transport. An event sent again is counted again. The bytes are
+*			  those of the message bodies; the protocol framing and TLS are not counted, and AMQP,
+*			  whose bodies are encoded by uAMQP, counts no bytes.
+*/
+DEFINE_ENUM(IOTHUB_CLIENT_METRIC, IOTHUB_CLIENT_METRIC_VALUES);
+
+#define IOTHUB_CLIENT_METRIC_COUNT (IOTHUB_CLIENT_METRIC_TRANSPORT_AUTH_REFRESHES + 1)
+
+#define IOTHUB_CLIENT_HISTOGRAM_VALUES                          \
+    IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS,            \
+    IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE             \
+
+/** @brief	The histograms of ::IOTHUB_CLIENT_METRICS_SNAPSHOT.
+*
+*			- CONFIRMATION_LATENCY_MS: from the moment an event was queued to the moment the
+*			  transport confirmed it, both read from the tick counter of the client.
+*			- CONFIRMATION_BATCH_SIZE: how many events the transport confirmed together.
+*/
+DEFINE_ENUM(IOTHUB_CLIENT_HISTOGRAM, IOTHUB_CLIENT_HISTOGRAM_VALUES);
+
+#define IOTHUB_CLIENT_HISTOGRAM_COUNT (IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE + 1)
+
+/*bucket 0 counts the values 0, bucket i the values from 2^(i-1) to 2^i-1, the last bucket everything above*/
+#define IOTHUB_CLIENT_HISTOGRAM_BUCKET_COUNT 20
+
+/** @brief	A copy of the metrics, taken by ::IoTHubClient_LL_GetMetrics, ::IoTHubClient_GetMetrics
+*			or ::IoTHubTransport_GetMetrics.
+*/
+typedef struct IOTHUB_CLIENT_METRICS_SNAPSHOT_TAG
+{
+    /** @brief	Indexed by ::IOTHUB_CLIENT_METRIC. */
+    uint64_t values[IOTHUB_CLIENT_METRIC_COUNT];
+
+    /** @brief	Indexed by ::IOTHUB_CLIENT_HISTOGRAM, then by bucket. */
+    uint64_t buckets[IOTHUB_CLIENT_HISTOGRAM_COUNT][IOTHUB_CLIENT_HISTOGRAM_BUCKET_COUNT];
+
+    /** @brief	The sum of the values recorded in each histogram. */
+    uint64_t sums[IOTHUB_CLIENT_HISTOGRAM_COUNT];
+} IOTHUB_CLIENT_METRICS_SNAPSHOT;
+
+/*the live metrics, embedded in the structure of the client or of the transport*/
+typedef struct IOTHUB_CLIENT_METRICS_TAG
+{
+    volatile uint64_t values[IOTHUB_CLIENT_METRIC_COUNT];
+    volatile uint64_t buckets[IOTHUB_CLIENT_HISTOGRAM_COUNT][IOTHUB_CLIENT_HISTOGRAM_BUCKET_COUNT];
+    volatile uint64_t sums[IOTHUB_CLIENT_HISTOGRAM_COUNT];
+} IOTHUB_CLIENT_METRICS;
+
+/**
+* @brief	Sets all the metrics to 0.
+*/
+MOCKABLE_FUNCTION(, void, iothub_client_metrics_init, IOTHUB_CLIENT_METRICS*, metrics);
+
+/**
+* @brief	Adds @p value to a counter. Does nothing if @p metrics is NULL.
+*/
+MOCKABLE_FUNCTION(, void, iothub_client_metrics_add, IOTHUB_CLIENT_METRICS*, metrics, IOTHUB_CLIENT_METRIC, metric, uint64_t, value);
+
+/**
+* @brief	Sets a gauge to @p value. Does nothing if @p metrics is NULL.
+*/
+MOCKABLE_FUNCTION(, void, iothub_client_metrics_set, IOTHUB_CLIENT_METRICS*, metrics, IOTHUB_CLIENT_METRIC, metric, uint64_t, value);
+
+/**
+* @brief	Counts @p value in its bucket of @p histogram and adds it to the sum. Does nothing if @p metrics is NULL.
+*/
+MOCKABLE_FUNCTION(, void, iothub_client_metrics_record, IOTHUB_CLIENT_METRICS*, metrics, IOTHUB_CLIENT_HISTOGRAM, histogram, uint64_t, value);
+
+/**
+* @brief	Copies the metrics to @p snapshot. Can be called from any thread.
+*
+* @return	0 on success, non-zero if an argument is NULL.
+*/
+MOCKABLE_FUNCTION(, int, iothub_client_metrics_get_snapshot, const IOTHUB_CLIENT_METRICS*, metrics, IOTHUB_CLIENT_METRICS_SNAPSHOT*, snapshot);
+
+/**
+* @brief	Writes @p snapshot in the Prometheus text format, for instance to answer a scrape.
+*			Like snprintf, it writes at most @p destinationSize characters including the
+*			terminating '\0' and returns the length of the whole text, so a call with a
+*			@c NULL destination gives the size to allocate.
+*
+* @return	The length of the text without the terminating '\0', 0 if @p snapshot is NULL.
+*/
+MOCKABLE_FUNCTION(, size_t, iothub_client_metrics_format, const IOTHUB_CLIENT_METRICS_SNAPSHOT*, snapshot, char*, destination, size_t, destinationSize);
+
+#define IOTHUB_CLIENT_ALLOCATION_TAG_VALUES                     \
+    IOTHUB_CLIENT_ALLOCATION_TAG_CLIENT,                        \
+    IOTHUB_CLIENT_ALLOCATION_TAG_MESSAGE,                       \
+    IOTHUB_CLIENT_ALLOCATION_TAG_QUEUE,                         \
+    IOTHUB_CLIENT_ALLOCATION_TAG_TRANSPORT,                     \
+    IOTHUB_CLIENT_ALLOCATION_TAG_UPLOAD,                        \
+    IOTHUB_CLIENT_ALLOCATION_TAG_SERIALIZER                     \
+
+/** @brief	The modules whose memory is accounted when the SDK is built with use_allocation_tags.
+*
+*			- CLIENT: IoTHubClient_LL, IoTHubClient, the shared transport handle, the callback
+*			  dispatcher, the metrics and the trace hooks.
+*			- MESSAGE: IoTHubMessage.
+*			- QUEUE: the ingress queue, the persistent queue and the compression of its records.
+*			- TRANSPORT: the HTTP, AMQP and MQTT transports, the SAS token cache and the retry control.
+*			- UPLOAD: upload to blob.
+*			- SERIALIZER: the serializer library.
+*
+*			Only the memory that these sources allocate themselves is accounted: what the shared
+*			utility, uAMQP or umqtt allocate on their behalf (STRING_HANDLE, BUFFER_HANDLE, MAP_HANDLE...)
+*			is not.
+*/
+DEFINE_ENUM(IOTHUB_CLIENT_ALLOCATION_TAG, IOTHUB_CLIENT_ALLOCATION_TAG_VALUES);
+
+#define IOTHUB_CLIENT_ALLOCATION_TAG_COUNT (IOTHUB_CLIENT_ALLOCATION_TAG_SERIALIZER + 1)
+
+/** @brief	The memory of every ::IOTHUB_CLIENT_ALLOCATION_TAG, taken by ::iothub_client_metrics_get_allocations.
+*			All the arrays are indexed by ::IOTHUB_CLIENT_ALLOCATION_TAG.
+*/
+typedef struct IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT_TAG
+{
+    /** @brief	The bytes allocated and not freed yet. */
+    uint64_t currentBytes[IOTHUB_CLIENT_ALLOCATION_TAG_COUNT];
+
+    /** @brief	The highest value that currentBytes has had. */
+    uint64_t peakBytes[IOTHUB_CLIENT_ALLOCATION_TAG_COUNT];
+
+    /** @brief	The blocks allocated and not freed yet, without the blocks handed over to the application. */
+    uint64_t liveBlocks[IOTHUB_CLIENT_ALLOCATION_TAG_COUNT];
+
+    /** @brief	The calls to malloc, calloc and realloc that returned a block. */
+    uint64_t allocations[IOTHUB_CLIENT_ALLOCATION_TAG_COUNT];
+} IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT;
+
+/**
+* @brief	Copies the memory accounted for every ::IOTHUB_CLIENT_ALLOCATION_TAG to @p snapshot.
+*			Can be called from any thread.
+*
+* @return	0 on success, non-zero if @p snapshot is NULL or if the SDK was built without
+*			use_allocation_tags.
+*/
+MOCKABLE_FUNCTION(, int, iothub_client_metrics_get_allocations, IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT*, snapshot);
+
+/**
+* @brief	Writes @p snapshot in the Prometheus text format, with one "tag" label per
+*			::IOTHUB_CLIENT_ALLOCATION_TAG. Writes and returns like ::iothub_client_metrics_format,
+*			so the two texts can be concatenated to answer the same scrape.
+*
+* @return	The length of the text without the terminating '\0', 0 if @p snapshot is NULL.
+*/
+MOCKABLE_FUNCTION(, size_t, iothub_client_metrics_format_allocations, const IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT*, snapshot, char*, destination, size_t, destinationSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_METRICS_H */
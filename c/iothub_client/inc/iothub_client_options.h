@@ -28,6 +28,20 @@ extern "C"
     static const char* OPTION_SAS_TOKEN_LIFETIME = "sas_token_lifetime";
     static const char* OPTION_SAS_TOKEN_REFRESH_TIME = "sas_token_refresh_time";
     static const char* OPTION_CBS_REQUEST_TIMEOUT = "cbs_request_timeout";
+    static const char* OPTION_SAS_TOKEN_REUSE_PERCENT = "sas_token_reuse_percent";
+
+    /*value is a const PERSISTENT_QUEUE_CONFIG*, see iothub_client_persistent_queue.h*/
+    static const char* OPTION_PERSISTENT_QUEUE = "persistent_queue";
+    /*value is a const IOTHUB_CLIENT_QUEUE_LIMITS*, see iothub_client_ll.h*/
+    static const char* OPTION_OUTBOUND_QUEUE_LIMITS = "outbound_queue_limits";
+    /*value is a const IOTHUB_CLIENT_PRIORITY_WEIGHTS*, see iothub_client_ll.h*/
+    static const char* OPTION_PRIORITY_WEIGHTS = "priority_weights";
+    /*value is a const IOTHUB_CLIENT_COMPRESSION_CONFIG*, see iothub_client_ll.h*/
+    static const char* OPTION_COMPRESSION = "compression";
+    /*value is a const bool*, handled by IoTHubClient_SetOption only, see iothub_client_ingress_queue.h. Not with the REJECT or BLOCK policy of OPTION_PERSISTENT_QUEUE or OPTION_OUTBOUND_QUEUE_LIMITS*/
+    static const char* OPTION_SEND_INGRESS_QUEUE = "send_ingress_queue";
+    /*value is a const bool*, handled by IoTHubClient_SetOption only, see iothub_client_callback_dispatcher.h*/
+    static const char* OPTION_CALLBACK_DISPATCHER = "callback_dispatcher";
 
     static const char* OPTION_MIN_POLLING_TIME = "MinimumPollingTime";
     static const char* OPTION_BATCHING = "Batching";
@@ -0,0 +1,144 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_persistent_queue.h
+*	@brief Durable outbound queue used by IoTHubClient_LL for store-and-forward telemetry.
+*
+*	@details The queue is an append-only log of records split in segment files
+*			 kept in one directory. Every record gets a sequence number. Records
+*			 are acknowledged one by one, but the space is given back a segment
+*			 at a time: a segment file is removed once all of its records have
+*			 been acknowledged. Records that were never acknowledged are found
+*			 again when the queue is created on the same directory after a
+*			 restart, so delivery is at least once.
+*/
+
+#ifndef IOTHUB_CLIENT_PERSISTENT_QUEUE_H
+#define IOTHUB_CLIENT_PERSISTENT_QUEUE_H
+
+#include "azure_c_shared_utility/macro_utils.h"
+#include "iothub_message.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C"
+{
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/*size of a segment file when PERSISTENT_QUEUE_CONFIG::segmentSize is 0*/
+#define PERSISTENT_QUEUE_DEFAULT_SEGMENT_SIZE               (1024 * 1024)
+/*maximum number of persisted messages IoTHubClient_LL keeps in memory when PERSISTENT_QUEUE_CONFIG::maxMessagesInMemory is 0*/
+#define PERSISTENT_QUEUE_DEFAULT_MAX_MESSAGES_IN_MEMORY     100
+
+#define PERSISTENT_QUEUE_OVERFLOW_POLICY_VALUES \
+    PERSISTENT_QUEUE_OVERFLOW_REJECT,           \
+    PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST,      \
+    PERSISTENT_QUEUE_OVERFLOW_BLOCK
+
+DEFINE_ENUM(PERSISTENT_QUEUE_OVERFLOW_POLICY, PERSISTENT_QUEUE_OVERFLOW_POLICY_VALUES);
+
+#define PERSISTENT_QUEUE_RESULT_VALUES  \
+    PERSISTENT_QUEUE_OK,                \
+    PERSISTENT_QUEUE_FULL,              \
+    PERSISTENT_QUEUE_EMPTY,             \
+    PERSISTENT_QUEUE_ERROR
+
+DEFINE_ENUM(PERSISTENT_QUEUE_RESULT, PERSISTENT_QUEUE_RESULT_VALUES);
+
+typedef struct PERSISTENT_QUEUE_CONFIG_TAG
+{
+    /*existing directory where the segment files and the manifest are kept. The directory belongs to one queue.*/
+    const char* directory;
+    /*maximum number of bytes kept on disk (records and their headers), 0 means no limit*/
+    size_t maxBytes;
+    /*maximum number of records kept on disk, 0 means no limit*/
+    size_t maxMessages;
+    /*a segment is sealed once it is this big, 0 means PERSISTENT_QUEUE_DEFAULT_SEGMENT_SIZE*/
+    size_t segmentSize;
+    /*what happens when a record does not fit*/
+    PERSISTENT_QUEUE_OVERFLOW_POLICY overflowPolicy;
+    /*PERSISTENT_QUEUE_OVERFLOW_BLOCK only: how long IoTHubClient_SendEventAsync waits for room*/
+    size_t blockTimeoutInMilliseconds;
+    /*how many persisted messages IoTHubClient_LL hands to the transport at once, 0 means PERSISTENT_QUEUE_DEFAULT_MAX_MESSAGES_IN_MEMORY*/
+    size_t maxMessagesInMemory;
+} PERSISTENT_QUEUE_CONFIG;
+
+typedef struct PERSISTENT_QUEUE_INSTANCE_TAG* PERSISTENT_QUEUE_HANDLE;
+
+/**
+* @brief	Opens the queue kept in config->directory, recovering the records
+*			left there by a previous run. A torn or corrupted record ends its
+*			segment. New records always go to a new segment.
+*
+* @return	A @c PERSISTENT_QUEUE_HANDLE or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, PERSISTENT_QUEUE_HANDLE, persistent_queue_create, const PERSISTENT_QUEUE_CONFIG*, config);
+
+/**
+* @brief	Closes the queue. Records that were not acknowledged stay on disk.
+*/
+MOCKABLE_FUNCTION(, void, persistent_queue_destroy, PERSISTENT_QUEUE_HANDLE, handle);
+
+/**
+* @brief	Appends a record and flushes it to the operating system.
+*
+* @param	sequenceNumber  Receives the sequence number of the record.
+*
+* @return	PERSISTENT_QUEUE_OK, PERSISTENT_QUEUE_FULL when the record does not
+*			fit under the limits and the policy is not PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST,
+*			or PERSISTENT_QUEUE_ERROR.
+*/
+MOCKABLE_FUNCTION(, PERSISTENT_QUEUE_RESULT, persistent_queue_append, PERSISTENT_QUEUE_HANDLE, handle, const unsigned char*, record, size_t, size, uint64_t*, sequenceNumber);
+
+/**
+* @brief	Reads the first record whose sequence number is at least fromSequenceNumber.
+*			Reading consecutive records is sequential on disk.
+*
+* @param	record          Receives a copy of the record, to be freed by the caller.
+*
+* @return	PERSISTENT_QUEUE_OK, PERSISTENT_QUEUE_EMPTY when there is no such record, or PERSISTENT_QUEUE_ERROR.
+*/
+MOCKABLE_FUNCTION(, PERSISTENT_QUEUE_RESULT, persistent_queue_read, PERSISTENT_QUEUE_HANDLE, handle, uint64_t, fromSequenceNumber, unsigned char**, record, size_t*, size, uint64_t*, sequenceNumber);
+
+/**
+* @brief	Acknowledges a record. Every record shall be acknowledged at most once.
+*			The leading segments whose records are all acknowledged are removed.
+*
+* @return	0 on success, non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, persistent_queue_ack, PERSISTENT_QUEUE_HANDLE, handle, uint64_t, sequenceNumber);
+
+/**
+* @brief	Gets the sequence number of the oldest record kept and the one the next record will get.
+*/
+MOCKABLE_FUNCTION(, int, persistent_queue_get_range, PERSISTENT_QUEUE_HANDLE, handle, uint64_t*, firstSequenceNumber, uint64_t*, nextSequenceNumber);
+
+/**
+* @brief	Gets the number of records and of bytes kept on disk, the quantities the limits apply to.
+*/
+MOCKABLE_FUNCTION(, int, persistent_queue_get_usage, PERSISTENT_QUEUE_HANDLE, handle, size_t*, messageCount, size_t*, byteCount);
+
+/**
+* @brief	Appends an IoT Hub message: its content, content type, message id,
+*			correlation id and properties.
+*/
+MOCKABLE_FUNCTION(, PERSISTENT_QUEUE_RESULT, persistent_queue_append_message, PERSISTENT_QUEUE_HANDLE, handle, IOTHUB_MESSAGE_HANDLE, message, uint64_t*, sequenceNumber);
+
+/**
+* @brief	Reads back a message appended by persistent_queue_append_message.
+*
+* @param	message         Receives a new message, to be destroyed by the caller.
+*/
+MOCKABLE_FUNCTION(, PERSISTENT_QUEUE_RESULT, persistent_queue_read_message, PERSISTENT_QUEUE_HANDLE, handle, uint64_t, fromSequenceNumber, IOTHUB_MESSAGE_HANDLE*, message, uint64_t*, sequenceNumber);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_PERSISTENT_QUEUE_H */
@@ -40,6 +40,9 @@ typedef struct IOTHUB_MESSAGE_LIST_TAG
     void* context; 
     DLIST_ENTRY entry;
     uint64_t ms_timesOutAfter; /* a value of "0" means "no timeout", if the IOTHUBCLIENT_LL's handle tickcounter > msTimesOutAfer then the message shall timeout*/
+    IOTHUB_MESSAGE_PRIORITY priority; /*the lane of the event, events of different lanes are not batched together*/
+    uint64_t fairShareTag; /*waitingToSend is kept sorted by this tag, see InsertInFairShareOrder*/
+    uint64_t ms_queuedAt; /*tick read when the event was queued, for IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS*/
 }IOTHUB_MESSAGE_LIST;
 
 
@@ -0,0 +1,78 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_retry_control.h
+*	@brief Retry engine shared by the IoTHub client transports.
+*
+*	@details The transports ask the retry control whether a (re)connection attempt
+*			 may be made now. The answer follows the IOTHUB_CLIENT_RETRY_POLICY set
+*			 by the application through IoTHubClient_LL_SetRetryPolicy and stops once
+*			 retryTimeoutLimitinSeconds have passed since the first failure.
+*			 The jitter is seeded per instance (mixing in the device id) so that devices
+*			 dropped by the same outage do not come back in lockstep.
+*/
+
+#ifndef IOTHUB_CLIENT_RETRY_CONTROL_H
+#define IOTHUB_CLIENT_RETRY_CONTROL_H
+
+#include "azure_c_shared_utility/macro_utils.h"
+#include "iothub_client_ll.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C"
+{
+#else
+#include <stddef.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#define RETRY_ACTION_VALUES     \
+    RETRY_ACTION_RETRY_NOW,     \
+    RETRY_ACTION_RETRY_LATER,   \
+    RETRY_ACTION_STOP_RETRYING
+
+DEFINE_ENUM(RETRY_ACTION, RETRY_ACTION_VALUES)
+
+typedef struct RETRY_CONTROL_INSTANCE_TAG* RETRY_CONTROL_HANDLE;
+
+/**
+* @brief	Creates a retry control.
+*
+* @param	retryPolicy                 The policy deciding how long to wait between attempts.
+* @param	retryTimeoutLimitInSeconds  How long to keep retrying after the first failure, 0 for no limit.
+* @param	deviceId                    Mixed into the jitter seed, can be NULL.
+*
+* @return	A @c RETRY_CONTROL_HANDLE or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, RETRY_CONTROL_HANDLE, retry_control_create, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds, const char*, deviceId);
+
+MOCKABLE_FUNCTION(, void, retry_control_destroy, RETRY_CONTROL_HANDLE, retryControlHandle);
+
+/**
+* @brief	Replaces the policy and the timeout limit and resets the retry state.
+*
+* @return	0 on success, non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, retry_control_set_policy, RETRY_CONTROL_HANDLE, retryControlHandle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds);
+
+/**
+* @brief	Decides whether an attempt may be made now. The first call after a create or
+*			a reset always answers RETRY_ACTION_RETRY_NOW. Every RETRY_ACTION_RETRY_NOW
+*			answer counts as an attempt and starts the wait before the next one.
+*
+* @return	0 on success (@p retryAction is set), non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, retry_control_should_retry, RETRY_CONTROL_HANDLE, retryControlHandle, RETRY_ACTION*, retryAction);
+
+/**
+* @brief	Marks the last attempt as successful: the attempt count and the timeout start over.
+*/
+MOCKABLE_FUNCTION(, void, retry_control_reset, RETRY_CONTROL_HANDLE, retryControlHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_RETRY_CONTROL_H */
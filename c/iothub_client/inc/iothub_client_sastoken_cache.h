@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_sastoken_cache.h
+*	@brief SAS token cache shared by the IoTHub client transports.
+*
+*	@details A cache is created once per device key. It decodes the key and
+*			 absorbs the HMAC-SHA256 inner and outer pads up front, so producing
+*			 a new token only hashes the string to sign. A token is handed out
+*			 again until reusePercent of its lifetime has passed, which keeps
+*			 reconnect storms from re-signing on every attempt.
+*/
+
+#ifndef IOTHUB_CLIENT_SASTOKEN_CACHE_H
+#define IOTHUB_CLIENT_SASTOKEN_CACHE_H
+
+#include "azure_c_shared_utility/strings.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C"
+{
+#else
+#include <stddef.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/*lifetime of the tokens when sastoken_cache_set_lifetime is never called*/
+#define SASTOKEN_CACHE_DEFAULT_LIFETIME_IN_SECONDS  3600
+/*a token is handed out again until this percent of its lifetime has passed*/
+#define SASTOKEN_CACHE_DEFAULT_REUSE_PERCENT        50
+
+typedef struct SASTOKEN_CACHE_INSTANCE_TAG* SASTOKEN_CACHE_HANDLE;
+
+/**
+* @brief	Creates a SAS token cache.
+*
+* @param	key         The base64 encoded device key.
+* @param	scope       The resource the tokens give access to (the "sr" field).
+* @param	keyName     The "skn" field, can be NULL or empty.
+*
+* @return	A @c SASTOKEN_CACHE_HANDLE or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, SASTOKEN_CACHE_HANDLE, sastoken_cache_create, STRING_HANDLE, key, STRING_HANDLE, scope, STRING_HANDLE, keyName);
+
+MOCKABLE_FUNCTION(, void, sastoken_cache_destroy, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle);
+
+/**
+* @brief	Sets the lifetime of the tokens and the percent of it during which a token is reused.
+*			The cached token, if any, is dropped.
+*
+* @return	0 on success, non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, sastoken_cache_set_lifetime, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle, size_t, lifetimeInSeconds, size_t, reusePercent);
+
+/**
+* @brief	Returns the cached token, or signs a new one if there is none or if it is too old.
+*			The token is owned by the cache and stays valid until the next call on the cache,
+*			so the calls of the caller on the cache shall be serialized.
+*
+* @param	creationTime    Receives the time the token was signed, in seconds since the epoch. Can be NULL.
+*
+* @return	The token or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, const char*, sastoken_cache_get_token, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle, size_t*, creationTime);
+
+/**
+* @brief	Same as sastoken_cache_get_token, but returns a copy of the token made under the lock of
+*			the cache. Use it when the cache can be called from several threads at once.
+*
+* @param	creationTime    Receives the time the token was signed, in seconds since the epoch. Can be NULL.
+*
+* @return	A copy of the token, to be freed with STRING_delete, or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, STRING_HANDLE, sastoken_cache_copy_token, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle, size_t*, creationTime);
+
+/**
+* @brief	Drops the cached token so that the next sastoken_cache_get_token signs a new one.
+*/
+MOCKABLE_FUNCTION(, void, sastoken_cache_invalidate, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_SASTOKEN_CACHE_H */
@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_trace.h
+*	@brief Per-message trace hooks of IoTHubClient_LL and the transports, and a
+*		   recorder that keeps the last events and writes them as a Chrome trace.
+*
+*	@details The hooks are compiled only when USE_MESSAGE_TRACE is defined (cmake
+*			 option use_message_trace). Without it ::IOTHUB_CLIENT_TRACE_MESSAGE
+*			 and ::IOTHUB_CLIENT_TRACE_MESSAGE_LIST expand to nothing, so the
+*			 client does not even read the clock. With it, every event costs a
+*			 read of the trace callback and, when one is set, a read of the
+*			 monotonic clock and the call of the callback.
+*/
+
+#ifndef IOTHUB_CLIENT_TRACE_H
+#define IOTHUB_CLIENT_TRACE_H
+
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
+#include "iothub_message.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C"
+{
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#define IOTHUB_CLIENT_TRACE_STAGE_VALUES        \
+    IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE,          \
+    IOTHUB_CLIENT_TRACE_STAGE_DEQUEUE,          \
+    IOTHUB_CLIENT_TRACE_STAGE_SERIALIZE,        \
+    IOTHUB_CLIENT_TRACE_STAGE_WRITE,            \
+    IOTHUB_CLIENT_TRACE_STAGE_ACK,              \
+    IOTHUB_CLIENT_TRACE_STAGE_CALLBACK          \
+
+/** @brief	The stages of an event, in the order they happen.
+*
+*			- ENQUEUE: ::IoTHubClient_LL_SendEventAsync queued the event.
+*			- DEQUEUE: the transport took the event from the waiting list.
+*			- SERIALIZE: the transport built the protocol message (for HTTP, the request body).
+*			- WRITE: the transport handed the message to the protocol layer.
+*			- ACK: the service acknowledged the event (for HTTP, the response of the request).
+*			- CALLBACK: the confirmation callback of the event is about to be called.
+*/
+DEFINE_ENUM(IOTHUB_CLIENT_TRACE_STAGE, IOTHUB_CLIENT_TRACE_STAGE_VALUES);
+
+/** @brief	Called for every stage of every event while set. @p timestampUs comes from
+*			::iothub_client_trace_get_time_us. The callback runs in the thread of the client
+*			and may be called for several clients at the same time.
+*/
+typedef void(*IOTHUB_CLIENT_TRACE_CALLBACK)(IOTHUB_CLIENT_TRACE_STAGE stage, IOTHUB_MESSAGE_HANDLE message, uint64_t timestampUs, void* context);
+
+typedef struct IOTHUB_CLIENT_TRACE_RECORDER_TAG* IOTHUB_CLIENT_TRACE_RECORDER_HANDLE;
+
+/**
+* @brief	Sets the trace callback of the process, NULL stops the tracing. Like the
+*			logging function, it is meant to be set once, before the clients are created.
+*/
+MOCKABLE_FUNCTION(, void, iothub_client_trace_set_callback, IOTHUB_CLIENT_TRACE_CALLBACK, callback, void*, context);
+
+/**
+* @brief	Reports @p stage of @p message to the trace callback, if one is set.
+*/
+MOCKABLE_FUNCTION(, void, iothub_client_trace_message, IOTHUB_CLIENT_TRACE_STAGE, stage, IOTHUB_MESSAGE_HANDLE, message);
+
+/**
+* @brief	Reports @p stage of every IOTHUB_MESSAGE_LIST of @p list to the trace callback
+*			with the same timestamp, if one is set.
+*/
+MOCKABLE_FUNCTION(, void, iothub_client_trace_message_list, IOTHUB_CLIENT_TRACE_STAGE, stage, PDLIST_ENTRY, list);
+
+/**
+* @brief	A monotonic clock in microseconds, from an unspecified origin.
+*/
+MOCKABLE_FUNCTION(, uint64_t, iothub_client_trace_get_time_us);
+
+/**
+* @brief	Creates a recorder that keeps the last @p capacity events. Pass
+*			::iothub_client_trace_recorder_callback and the recorder to
+*			::iothub_client_trace_set_callback to record.
+*
+* @return	A handle to the recorder, NULL if @p capacity is 0 or on failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_TRACE_RECORDER_HANDLE, iothub_client_trace_recorder_create, size_t, capacity);
+
+/**
+* @brief	Destroys the recorder. The trace callback must not use it anymore.
+*/
+MOCKABLE_FUNCTION(, void, iothub_client_trace_recorder_destroy, IOTHUB_CLIENT_TRACE_RECORDER_HANDLE, recorder);
+
+/**
+* @brief	An ::IOTHUB_CLIENT_TRACE_CALLBACK whose @p context is a recorder. When the
+*			recorder is full the oldest event is overwritten.
+*/
+MOCKABLE_FUNCTION(, void, iothub_client_trace_recorder_callback, IOTHUB_CLIENT_TRACE_STAGE, stage, IOTHUB_MESSAGE_HANDLE, message, uint64_t, timestampUs, void*, context);
+
+/**
+* @brief	Writes the recorded events, oldest first, in the Chrome trace event format
+*			(chrome://tracing, Perfetto). Every event is an async event of the message;
+*			ENQUEUE also begins and CALLBACK also ends a "message" span. Like snprintf,
+*			it writes at most @p destinationSize characters including the terminating
+*			'\0' and returns the length of the whole text, so a call with a @c NULL
+*			destination gives the size to allocate.
+*
+* @return	The length of the text without the terminating '\0', 0 if @p recorder is NULL.
+*/
+MOCKABLE_FUNCTION(, size_t, iothub_client_trace_recorder_format, IOTHUB_CLIENT_TRACE_RECORDER_HANDLE, recorder, char*, destination, size_t, destinationSize);
+
+#ifdef USE_MESSAGE_TRACE
+#define IOTHUB_CLIENT_TRACE_MESSAGE(stage, message) iothub_client_trace_message(stage, message)
+#define IOTHUB_CLIENT_TRACE_MESSAGE_LIST(stage, list) iothub_client_trace_message_list(stage, list)
+#else
+#define IOTHUB_CLIENT_TRACE_MESSAGE(stage, message)
+#define IOTHUB_CLIENT_TRACE_MESSAGE_LIST(stage, list)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_TRACE_H */
@@ -41,6 +41,18 @@ IOTHUBMESSAGE_UNKNOWN \
   */
 DEFINE_ENUM(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_CONTENT_TYPE_VALUES);
 
+#define IOTHUB_MESSAGE_PRIORITY_VALUES \
+IOTHUB_MESSAGE_PRIORITY_LOW, \
+IOTHUB_MESSAGE_PRIORITY_NORMAL, \
+IOTHUB_MESSAGE_PRIORITY_HIGH \
+
+/** @brief Enumeration specifying the lane in which an event waits to be
+  * sent. The lanes are drained in weighted fair order, see
+  * @c OPTION_PRIORITY_WEIGHTS. Messages are created with
+  * @c IOTHUB_MESSAGE_PRIORITY_NORMAL.
+  */
+DEFINE_ENUM(IOTHUB_MESSAGE_PRIORITY, IOTHUB_MESSAGE_PRIORITY_VALUES);
+
 typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG* IOTHUB_MESSAGE_HANDLE;
 
 /**
@@ -166,6 +178,28 @@ MOCKABLE_FUNCTION(, const char*, IoTHubMessage_GetCorrelationId, IOTHUB_MESSAGE_
 */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_SetCorrelationId, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, const char*, correlationId);
 
+/**
+* @brief   Sets the priority of the message. The priority is local to the
+*          device: it decides how soon the event is sent, it is not sent
+*          to the hub.
+*
+* @param   iotHubMessageHandle Handle to the message.
+* @param   priority The lane of the message.
+*
+* @return  Returns IOTHUB_MESSAGE_OK if the priority was set successfully
+*          or an error code otherwise.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_SetPriority, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, IOTHUB_MESSAGE_PRIORITY, priority);
+
+/**
+* @brief   Gets the priority of the message.
+*
+* @param   iotHubMessageHandle Handle to the message.
+*
+* @return  The priority of the message.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_PRIORITY, IoTHubMessage_GetPriority, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
+
 /**
  * @brief   Frees all resources associated with the given message handle.
  *
@@ -44,6 +44,7 @@ extern "C"
 	typedef void (*pfIoTHubTransport_Unsubscribe)(IOTHUB_DEVICE_HANDLE handle);
 	typedef void (*pfIoTHubTransport_DoWork)(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle);
 	typedef IOTHUB_CLIENT_RESULT(*pfIoTHubTransport_GetSendStatus)(IOTHUB_DEVICE_HANDLE handle, IOTHUB_CLIENT_STATUS *iotHubClientStatus);
+	typedef int(*pfIoTHubTransport_SetRetryPolicy)(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds);
 
 #define TRANSPORT_PROVIDER_FIELDS                            \
 pfIoTHubTransport_GetHostname IoTHubTransport_GetHostname;   \
@@ -55,7 +56,8 @@ pfIotHubTransport_Unregister IoTHubTransport_Unregister;     \
 pfIoTHubTransport_Subscribe IoTHubTransport_Subscribe;       \
 pfIoTHubTransport_Unsubscribe IoTHubTransport_Unsubscribe;   \
 pfIoTHubTransport_DoWork IoTHubTransport_DoWork;             \
-pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus  /*there's an intentional missing ; on this line*/ \
+pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus;  \
+pfIoTHubTransport_SetRetryPolicy IoTHubTransport_SetRetryPolicy  /*there's an intentional missing ; on this line*/ \
 
 	struct TRANSPORT_PROVIDER_TAG
 	{
@@ -24,6 +24,7 @@ extern TRANSPORT_LL_HANDLE	IoTHubTransport_GetLLTransport(TRANSPORT_HANDLE trans
 extern IOTHUB_CLIENT_RESULT IoTHubTransport_StartWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_HANDLE clientHandle);
 extern bool					IoTHubTransport_SignalEndWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_HANDLE clientHandle);
 extern void					IoTHubTransport_JoinWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_HANDLE clientHandle);
+extern IOTHUB_CLIENT_RESULT IoTHubTransport_GetMetrics(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot);
 
 #ifdef __cplusplus
 }
@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <stddef.h>
+#include <string.h>
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "iothub_client.h"
 #include "iothub_client_ll.h"
@@ -18,6 +19,26 @@
 #include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
+#include "iothub_client_options.h"
+#include "iothub_client_persistent_queue.h"
+#include "iothub_client_ingress_queue.h"
+#include "iothub_client_callback_dispatcher.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
+
+/*how often a blocked IoTHubClient_SendEventAsync looks for room in the persistent queue*/
+#define SEND_BLOCK_POLL_IN_MILLISECONDS 10
+
+/*
+ * ingressQueue, workerThreadStarted and callbackDispatcher are written once, under LockHandle, and read without it by IoTHubClient_SendEventAsync.
+ * They are stored with release and loaded with acquire semantics, so a sender that sees them also sees the queue, the thread and the dispatcher.
+ * Without pointer atomics the sender reads them under LockHandle, like the other functions.
+ */
+#if defined(_MSC_VER)
+#include <windows.h>
+#define IOTHUB_CLIENT_USE_INTERLOCKED
+#elif defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7))))
+#define IOTHUB_CLIENT_USE_ATOMIC_BUILTINS
+#endif
 
 typedef struct IOTHUB_CLIENT_INSTANCE_TAG
 {
@@ -26,6 +47,12 @@ typedef struct IOTHUB_CLIENT_INSTANCE_TAG
     THREAD_HANDLE ThreadHandle;
     LOCK_HANDLE LockHandle;
     sig_atomic_t StopThread;
+    size_t sendBlockTimeoutInMilliseconds; /*0 unless the policy of the persistent queue or of the outbound queue limits, whichever was set last, is the blocking one*/
+    bool persistentQueueRefusesEvents; /*the policy of the persistent queue answers IOTHUB_CLIENT_QUEUE_FULL instead of making room*/
+    bool outboundQueueRefusesEvents; /*the policy of the outbound queue limits answers IOTHUB_CLIENT_QUEUE_FULL instead of making room*/
+    INGRESS_QUEUE_HANDLE volatile ingressQueue; /*NULL unless OPTION_SEND_INGRESS_QUEUE is on, then kept until IoTHubClient_Destroy*/
+    volatile long workerThreadStarted; /*lets IoTHubClient_SendEventAsync skip the lock once ThreadHandle is set*/
+    CALLBACK_DISPATCHER_HANDLE volatile callbackDispatcher; /*NULL unless OPTION_CALLBACK_DISPATCHER is on, then kept until IoTHubClient_Destroy*/
 #ifndef DONT_USE_UPLOADTOBLOB
     SINGLYLINKEDLIST_HANDLE savedDataToBeCleaned; /*list containing UPLOADTOBLOB_SAVED_DATA*/
 #endif
@@ -46,6 +73,25 @@ typedef struct UPLOADTOBLOB_SAVED_DATA_TAG
 }UPLOADTOBLOB_SAVED_DATA;
 #endif
 
+/*an event that IoTHubClient_SendEventAsync put in the ingress queue*/
+typedef struct IOTHUB_CLIENT_INGRESS_EVENT_TAG
+{
+    INGRESS_QUEUE_ENTRY entry;
+    IOTHUB_MESSAGE_HANDLE eventMessageHandle; /*a clone owned by this structure*/
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback;
+    void* userContextCallback;
+} IOTHUB_CLIENT_INGRESS_EVENT;
+
+/*an event confirmation that the lower layer reported, waiting for the callback dispatcher thread*/
+typedef struct IOTHUB_CLIENT_DISPATCHED_CONFIRMATION_TAG
+{
+    CALLBACK_DISPATCHER_ITEM item;
+    CALLBACK_DISPATCHER_HANDLE callbackDispatcher;
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback;
+    void* userContextCallback;
+    IOTHUB_CLIENT_CONFIRMATION_RESULT result;
+} IOTHUB_CLIENT_DISPATCHED_CONFIRMATION;
+
 /*used by unittests only*/
 const size_t IoTHubClient_ThreadTerminationOffset = offsetof(IOTHUB_CLIENT_INSTANCE, StopThread);
 
@@ -98,6 +144,174 @@ static void garbageCollectorImpl(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
 }
 #endif
 
+static void RunEventConfirmation(CALLBACK_DISPATCHER_ITEM* item)
+{
+    IOTHUB_CLIENT_DISPATCHED_CONFIRMATION* confirmation = containingRecord(item, IOTHUB_CLIENT_DISPATCHED_CONFIRMATION, item);
+    confirmation->eventConfirmationCallback(confirmation->result, confirmation->userContextCallback);
+    free(confirmation);
+}
+
+/*the confirmation callback given to the LL client when the callback dispatcher is on, called with the lock held*/
+static void DispatchEventConfirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    IOTHUB_CLIENT_DISPATCHED_CONFIRMATION* confirmation = (IOTHUB_CLIENT_DISPATCHED_CONFIRMATION*)userContextCallback;
+    confirmation->result = result;
+    /*Codes_SRS_IOTHUBCLIENT_02_108: [ When the LL client confirms a dispatched event, the confirmation shall be posted to the callback dispatcher by calling callback_dispatcher_post, and the application's eventConfirmationCallback shall be called with the result from the callback dispatcher thread. ]*/
+    if (callback_dispatcher_post(confirmation->callbackDispatcher, &confirmation->item, RunEventConfirmation) != 0)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_02_109: [ If callback_dispatcher_post fails, the application's eventConfirmationCallback shall be called right away. ]*/
+        LogError("unable to callback_dispatcher_post, calling the confirmation callback on this thread");
+        RunEventConfirmation(&confirmation->item);
+    }
+}
+
+/*called with the lock held, moves one event from the ingress queue to the outbound queue of the LL client*/
+static void SendIngressEvent(INGRESS_QUEUE_ENTRY* entry, void* context)
+{
+    IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)context;
+    IOTHUB_CLIENT_INGRESS_EVENT* ingressEvent = containingRecord(entry, IOTHUB_CLIENT_INGRESS_EVENT, entry);
+
+    if (IoTHubClient_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, ingressEvent->eventMessageHandle, ingressEvent->eventConfirmationCallback, ingressEvent->userContextCallback) != IOTHUB_CLIENT_OK)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_02_101: [ If IoTHubClient_LL_SendEventAsync fails for an event from the ingress queue, the event's eventConfirmationCallback (if any) shall be called with IOTHUB_CLIENT_CONFIRMATION_ERROR. ]*/
+        LogError("unable to IoTHubClient_LL_SendEventAsync an event from the ingress queue");
+        if (ingressEvent->eventConfirmationCallback != NULL)
+        {
+            ingressEvent->eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, ingressEvent->userContextCallback);
+        }
+    }
+
+    /*IoTHubClient_LL_SendEventAsync made its own copy*/
+    IoTHubMessage_Destroy(ingressEvent->eventMessageHandle);
+    free(ingressEvent);
+}
+
+#if defined(IOTHUB_CLIENT_USE_INTERLOCKED)
+static void publishIngressQueue(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, INGRESS_QUEUE_HANDLE ingressQueue)
+{
+    (void)InterlockedExchangePointer((PVOID volatile*)&iotHubClientInstance->ingressQueue, ingressQueue);
+}
+
+static INGRESS_QUEUE_HANDLE loadIngressQueue(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    return (INGRESS_QUEUE_HANDLE)InterlockedCompareExchangePointer((PVOID volatile*)&iotHubClientInstance->ingressQueue, NULL, NULL);
+}
+
+static void publishCallbackDispatcher(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, CALLBACK_DISPATCHER_HANDLE callbackDispatcher)
+{
+    (void)InterlockedExchangePointer((PVOID volatile*)&iotHubClientInstance->callbackDispatcher, callbackDispatcher);
+}
+
+static CALLBACK_DISPATCHER_HANDLE loadCallbackDispatcher(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    return (CALLBACK_DISPATCHER_HANDLE)InterlockedCompareExchangePointer((PVOID volatile*)&iotHubClientInstance->callbackDispatcher, NULL, NULL);
+}
+
+static void publishWorkerThreadStarted(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    (void)InterlockedExchange(&iotHubClientInstance->workerThreadStarted, 1);
+}
+
+static bool isWorkerThreadStarted(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    return InterlockedCompareExchange(&iotHubClientInstance->workerThreadStarted, 0, 0) != 0;
+}
+#elif defined(IOTHUB_CLIENT_USE_ATOMIC_BUILTINS)
+static void publishIngressQueue(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, INGRESS_QUEUE_HANDLE ingressQueue)
+{
+    __atomic_store_n(&iotHubClientInstance->ingressQueue, ingressQueue, __ATOMIC_RELEASE);
+}
+
+static INGRESS_QUEUE_HANDLE loadIngressQueue(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    return __atomic_load_n(&iotHubClientInstance->ingressQueue, __ATOMIC_ACQUIRE);
+}
+
+static void publishCallbackDispatcher(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, CALLBACK_DISPATCHER_HANDLE callbackDispatcher)
+{
+    __atomic_store_n(&iotHubClientInstance->callbackDispatcher, callbackDispatcher, __ATOMIC_RELEASE);
+}
+
+static CALLBACK_DISPATCHER_HANDLE loadCallbackDispatcher(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    return __atomic_load_n(&iotHubClientInstance->callbackDispatcher, __ATOMIC_ACQUIRE);
+}
+
+static void publishWorkerThreadStarted(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    __atomic_store_n(&iotHubClientInstance->workerThreadStarted, 1, __ATOMIC_RELEASE);
+}
+
+static bool isWorkerThreadStarted(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    return __atomic_load_n(&iotHubClientInstance->workerThreadStarted, __ATOMIC_ACQUIRE) != 0;
+}
+#else
+static void publishIngressQueue(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, INGRESS_QUEUE_HANDLE ingressQueue)
+{
+    iotHubClientInstance->ingressQueue = ingressQueue;
+}
+
+static INGRESS_QUEUE_HANDLE loadIngressQueue(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    INGRESS_QUEUE_HANDLE result;
+    if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+    {
+        /*the send goes through the lock, which fails there too*/
+        LogError("Could not acquire lock");
+        result = NULL;
+    }
+    else
+    {
+        result = iotHubClientInstance->ingressQueue;
+        (void)Unlock(iotHubClientInstance->LockHandle);
+    }
+    return result;
+}
+
+static void publishCallbackDispatcher(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, CALLBACK_DISPATCHER_HANDLE callbackDispatcher)
+{
+    iotHubClientInstance->callbackDispatcher = callbackDispatcher;
+}
+
+static CALLBACK_DISPATCHER_HANDLE loadCallbackDispatcher(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    CALLBACK_DISPATCHER_HANDLE result;
+    if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+    {
+        /*the send goes through the lock, which fails there too*/
+        LogError("Could not acquire lock");
+        result = NULL;
+    }
+    else
+    {
+        result = iotHubClientInstance->callbackDispatcher;
+        (void)Unlock(iotHubClientInstance->LockHandle);
+    }
+    return result;
+}
+
+static void publishWorkerThreadStarted(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    iotHubClientInstance->workerThreadStarted = 1;
+}
+
+static bool isWorkerThreadStarted(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    /*the lock is taken to start the thread every time*/
+    (void)iotHubClientInstance;
+    return false;
+}
+#endif
+
+static void DrainIngressQueue(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    if (iotHubClientInstance->ingressQueue != NULL)
+    {
+        (void)ingress_queue_drain(iotHubClientInstance->ingressQueue, SendIngressEvent, iotHubClientInstance);
+    }
+}
+
 static int ScheduleWork_Thread(void* threadArgument)
 {
     IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)threadArgument;
@@ -116,6 +330,8 @@ static int ScheduleWork_Thread(void* threadArgument)
             {
                 /* Codes_SRS_IOTHUBCLIENT_01_037: [The thread created by IoTHubClient_SendEvent or IoTHubClient_SetMessageCallback shall call IoTHubClient_LL_DoWork every 1 ms.] */
                 /* Codes_SRS_IOTHUBCLIENT_01_039: [All calls to IoTHubClient_LL_DoWork shall be protected by the lock created in IotHubClient_Create.] */
+                /*Codes_SRS_IOTHUBCLIENT_02_100: [ Before calling IoTHubClient_LL_DoWork, the thread shall drain the ingress queue (if any) and pass every event, oldest first, to IoTHubClient_LL_SendEventAsync, then destroy the clone of the event. ]*/
+                DrainIngressQueue(iotHubClientInstance);
                 IoTHubClient_LL_DoWork(iotHubClientInstance->IoTHubClientLLHandle);
 
 #ifndef DONT_USE_UPLOADTOBLOB
@@ -150,6 +366,7 @@ static IOTHUB_CLIENT_RESULT StartWorkerThreadIfNeeded(IOTHUB_CLIENT_INSTANCE* io
             }
             else
             {
+                publishWorkerThreadStarted(iotHubClientInstance);
                 result = IOTHUB_CLIENT_OK;
             }
         }
@@ -234,6 +451,12 @@ IOTHUB_CLIENT_HANDLE IoTHubClient_CreateFromConnectionString(const char* connect
                     {
                         result->ThreadHandle = NULL;
                         result->TransportHandle = NULL;
+                        result->sendBlockTimeoutInMilliseconds = 0;
+                        result->persistentQueueRefusesEvents = false;
+                        result->outboundQueueRefusesEvents = false;
+                        result->ingressQueue = NULL;
+                        result->workerThreadStarted = 0;
+                        result->callbackDispatcher = NULL;
                     }
                 }
             }
@@ -292,6 +515,12 @@ IOTHUB_CLIENT_HANDLE IoTHubClient_Create(const IOTHUB_CLIENT_CONFIG* config)
                 {
                     result->TransportHandle = NULL;
                     result->ThreadHandle = NULL;
+                    result->sendBlockTimeoutInMilliseconds = 0;
+                    result->persistentQueueRefusesEvents = false;
+                    result->outboundQueueRefusesEvents = false;
+                    result->ingressQueue = NULL;
+                    result->workerThreadStarted = 0;
+                    result->callbackDispatcher = NULL;
                 }
             }
         }
@@ -336,6 +565,12 @@ IOTHUB_CLIENT_HANDLE IoTHubClient_CreateWithTransport(TRANSPORT_HANDLE transport
             {
                 result->ThreadHandle = NULL;
                 result->TransportHandle = transportHandle;
+                result->sendBlockTimeoutInMilliseconds = 0;
+                result->persistentQueueRefusesEvents = false;
+                result->outboundQueueRefusesEvents = false;
+                result->ingressQueue = NULL;
+                result->workerThreadStarted = 0;
+                result->callbackDispatcher = NULL;
                 /*Codes_SRS_IOTHUBCLIENT_17_005: [ IoTHubClient_CreateWithTransport shall call IoTHubTransport_GetLock to get the transport lock to be used later for serializing IoTHubClient calls. ]*/
                 LOCK_HANDLE transportLock = IoTHubTransport_GetLock(transportHandle);
                 result->LockHandle = transportLock;
@@ -453,6 +688,13 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
             okToJoin = IoTHubTransport_SignalEndWorkerThread(iotHubClientInstance->TransportHandle, iotHubClientHandle);
         }
 
+        /*Codes_SRS_IOTHUBCLIENT_02_102: [ IoTHubClient_Destroy shall drain the ingress queue (if any) into the IoTHubClient_LL instance before destroying it, so that the events get their callbacks, and destroy the ingress queue. ]*/
+        if (iotHubClientInstance->ingressQueue != NULL)
+        {
+            DrainIngressQueue(iotHubClientInstance);
+            ingress_queue_destroy(iotHubClientInstance->ingressQueue);
+        }
+
         /* Codes_SRS_IOTHUBCLIENT_01_006: [That includes destroying the IoTHubClient_LL instance by calling IoTHubClient_LL_Destroy.] */
         IoTHubClient_LL_Destroy(iotHubClientInstance->IoTHubClientLLHandle);
 
@@ -487,6 +729,12 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
             }
         }
 
+        /*Codes_SRS_IOTHUBCLIENT_02_113: [ IoTHubClient_Destroy shall destroy the callback dispatcher (if any) by calling callback_dispatcher_destroy after IoTHubClient_LL_Destroy and after the worker thread was joined, so that every dispatched callback runs. ]*/
+        if (iotHubClientInstance->callbackDispatcher != NULL)
+        {
+            callback_dispatcher_destroy(iotHubClientInstance->callbackDispatcher);
+        }
+
         if (iotHubClientInstance->TransportHandle == NULL)
         {
             /* Codes_SRS_IOTHUBCLIENT_01_032: [If the lock was allocated in IoTHubClient_Create, it shall be also freed..] */
@@ -497,20 +745,97 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
     }
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+static IOTHUB_CLIENT_RESULT SendEventThroughIngressQueue(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, INGRESS_QUEUE_HANDLE ingressQueue, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
+    IOTHUB_CLIENT_INGRESS_EVENT* ingressEvent;
 
-    if (iotHubClientHandle == NULL)
+    if (eventMessageHandle == NULL)
     {
-        /* Codes_SRS_IOTHUBCLIENT_01_011: [If iotHubClientHandle is NULL, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_INVALID_ARG.] */
+        /*Codes_SRS_IOTHUBCLIENT_02_096: [ If the ingress queue is on and eventMessageHandle is NULL, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
         result = IOTHUB_CLIENT_INVALID_ARG;
-        LogError("NULL iothubClientHandle");
+        LogError("NULL eventMessageHandle");
     }
     else
     {
-        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+        /*Codes_SRS_IOTHUBCLIENT_02_097: [ If the ingress queue is on, IoTHubClient_SendEventAsync shall take the lock only to start the worker thread, the first time. ]*/
+        if (isWorkerThreadStarted(iotHubClientInstance))
+        {
+            result = IOTHUB_CLIENT_OK;
+        }
+        else if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            /* Codes_SRS_IOTHUBCLIENT_01_026: [If acquiring the lock fails, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR.] */
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            /* Codes_SRS_IOTHUBCLIENT_01_009: [IoTHubClient_SendEventAsync shall start the worker thread if it was not previously started.] */
+            if (StartWorkerThreadIfNeeded(iotHubClientInstance) != IOTHUB_CLIENT_OK)
+            {
+                /* Codes_SRS_IOTHUBCLIENT_01_010: [If starting the thread fails, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR.] */
+                result = IOTHUB_CLIENT_ERROR;
+                LogError("Could not start worker thread");
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_OK;
+            }
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+
+        if (result != IOTHUB_CLIENT_OK)
+        {
+            /*already logged*/
+        }
+        else if ((ingressEvent = (IOTHUB_CLIENT_INGRESS_EVENT*)malloc(sizeof(IOTHUB_CLIENT_INGRESS_EVENT))) == NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_02_099: [ If any failure occurs while queuing the event, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR. ]*/
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("unable to malloc");
+        }
+        /*Codes_SRS_IOTHUBCLIENT_02_098: [ If the ingress queue is on, IoTHubClient_SendEventAsync shall clone eventMessageHandle by calling IoTHubMessage_Clone, push the clone, eventConfirmationCallback and userContextCallback to the ingress queue and return IOTHUB_CLIENT_OK. ]*/
+        else if ((ingressEvent->eventMessageHandle = IoTHubMessage_Clone(eventMessageHandle)) == NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_02_099: [ If any failure occurs while queuing the event, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR. ]*/
+            free(ingressEvent);
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("unable to IoTHubMessage_Clone");
+        }
+        else
+        {
+            ingressEvent->eventConfirmationCallback = eventConfirmationCallback;
+            ingressEvent->userContextCallback = userContextCallback;
+            if (ingress_queue_push(ingressQueue, &ingressEvent->entry) != 0)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_02_099: [ If any failure occurs while queuing the event, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR. ]*/
+                IoTHubMessage_Destroy(ingressEvent->eventMessageHandle);
+                free(ingressEvent);
+                result = IOTHUB_CLIENT_ERROR;
+                LogError("unable to ingress_queue_push");
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+    }
 
+    return result;
+}
+
+static IOTHUB_CLIENT_RESULT SendEvent(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+    INGRESS_QUEUE_HANDLE ingressQueue = loadIngressQueue(iotHubClientInstance);
+
+    if (ingressQueue != NULL)
+    {
+        result = SendEventThroughIngressQueue(iotHubClientInstance, ingressQueue, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+    }
+    else
+    {
         /* Codes_SRS_IOTHUBCLIENT_01_025: [IoTHubClient_SendEventAsync shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
         if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
         {
@@ -520,6 +845,8 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClie
         }
         else
         {
+            bool isLocked = true;
+
             /* Codes_SRS_IOTHUBCLIENT_01_009: [IoTHubClient_SendEventAsync shall start the worker thread if it was not previously started.] */
             if ((result = StartWorkerThreadIfNeeded(iotHubClientInstance)) != IOTHUB_CLIENT_OK)
             {
@@ -529,19 +856,93 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClie
             }
             else
             {
+                size_t waited = 0;
+
                 /* Codes_SRS_IOTHUBCLIENT_01_012: [IoTHubClient_SendEventAsync shall call IoTHubClient_LL_SendEventAsync, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameters eventMessageHandle, eventConfirmationCallback and userContextCallback.] */
                 /* Codes_SRS_IOTHUBCLIENT_01_013: [When IoTHubClient_LL_SendEventAsync is called, IoTHubClient_SendEventAsync shall return the result of IoTHubClient_LL_SendEventAsync.] */
                 result = IoTHubClient_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+
+                /*Codes_SRS_IOTHUBCLIENT_02_086: [ If IoTHubClient_LL_SendEventAsync returns IOTHUB_CLIENT_QUEUE_FULL and the persistent queue policy is PERSISTENT_QUEUE_OVERFLOW_BLOCK, IoTHubClient_SendEventAsync shall release the lock, let the worker thread make room and try again until blockTimeoutInMilliseconds have passed. ]*/
+                /*Codes_SRS_IOTHUBCLIENT_02_088: [ If IoTHubClient_LL_SendEventAsync returns IOTHUB_CLIENT_QUEUE_FULL and the outbound queue limits policy is IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK, IoTHubClient_SendEventAsync shall release the lock, let the worker thread make room and try again until blockTimeoutInMilliseconds have passed. ]*/
+                while ((result == IOTHUB_CLIENT_QUEUE_FULL) && (waited < iotHubClientInstance->sendBlockTimeoutInMilliseconds))
+                {
+                    (void)Unlock(iotHubClientInstance->LockHandle);
+                    ThreadAPI_Sleep(SEND_BLOCK_POLL_IN_MILLISECONDS);
+                    waited += SEND_BLOCK_POLL_IN_MILLISECONDS;
+                    if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+                    {
+                        /* Codes_SRS_IOTHUBCLIENT_01_026: [If acquiring the lock fails, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR.] */
+                        LogError("Could not acquire lock");
+                        isLocked = false;
+                        result = IOTHUB_CLIENT_ERROR;
+                    }
+                    else
+                    {
+                        result = IoTHubClient_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+                    }
+                }
             }
 
             /* Codes_SRS_IOTHUBCLIENT_01_025: [IoTHubClient_SendEventAsync shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
-            (void)Unlock(iotHubClientInstance->LockHandle);
+            if (isLocked)
+            {
+                (void)Unlock(iotHubClientInstance->LockHandle);
+            }
+        }
+    }
+
+    return result;
+}
+
+static IOTHUB_CLIENT_RESULT SendEventWithDispatchedConfirmation(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, CALLBACK_DISPATCHER_HANDLE callbackDispatcher, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+    IOTHUB_CLIENT_DISPATCHED_CONFIRMATION* confirmation;
+
+    /*Codes_SRS_IOTHUBCLIENT_02_107: [ If the callback dispatcher is on and eventConfirmationCallback is not NULL, IoTHubClient_SendEventAsync shall allocate a structure that remembers eventConfirmationCallback and userContextCallback and send the event with a confirmation callback of its own and that structure, which is freed if sending fails. ]*/
+    if ((confirmation = (IOTHUB_CLIENT_DISPATCHED_CONFIRMATION*)malloc(sizeof(IOTHUB_CLIENT_DISPATCHED_CONFIRMATION))) == NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_02_114: [ If allocating that structure fails, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR. ]*/
+        result = IOTHUB_CLIENT_ERROR;
+        LogError("unable to malloc");
+    }
+    else
+    {
+        confirmation->callbackDispatcher = callbackDispatcher;
+        confirmation->eventConfirmationCallback = eventConfirmationCallback;
+        confirmation->userContextCallback = userContextCallback;
+        if ((result = SendEvent(iotHubClientInstance, eventMessageHandle, DispatchEventConfirmation, confirmation)) != IOTHUB_CLIENT_OK)
+        {
+            free(confirmation);
         }
     }
 
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+    CALLBACK_DISPATCHER_HANDLE callbackDispatcher;
+
+    if (iotHubClientHandle == NULL)
+    {
+        /* Codes_SRS_IOTHUBCLIENT_01_011: [If iotHubClientHandle is NULL, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_INVALID_ARG.] */
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else if ((eventConfirmationCallback != NULL) && ((callbackDispatcher = loadCallbackDispatcher((IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle)) != NULL))
+    {
+        result = SendEventWithDispatchedConfirmation((IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle, callbackDispatcher, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+    }
+    else
+    {
+        result = SendEvent((IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_GetSendStatus(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATUS *iotHubClientStatus)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -569,6 +970,12 @@ IOTHUB_CLIENT_RESULT IoTHubClient_GetSendStatus(IOTHUB_CLIENT_HANDLE iotHubClien
             /* Codes_SRS_IOTHUBCLIENT_01_024: [Otherwise, IoTHubClient_GetSendStatus shall return the result of IoTHubClient_LL_GetSendStatus.] */
             result = IoTHubClient_LL_GetSendStatus(iotHubClientInstance->IoTHubClientLLHandle, iotHubClientStatus);
 
+            /*Codes_SRS_IOTHUBCLIENT_02_103: [ If IoTHubClient_LL_GetSendStatus succeeds and the ingress queue (if any) is not empty, IoTHubClient_GetSendStatus shall set iotHubClientStatus to IOTHUB_CLIENT_SEND_STATUS_BUSY. ]*/
+            if ((result == IOTHUB_CLIENT_OK) && (iotHubClientInstance->ingressQueue != NULL) && !ingress_queue_is_empty(iotHubClientInstance->ingressQueue))
+            {
+                *iotHubClientStatus = IOTHUB_CLIENT_SEND_STATUS_BUSY;
+            }
+
             /* Codes_SRS_IOTHUBCLIENT_01_033: [IoTHubClient_GetSendStatus shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
             (void)Unlock(iotHubClientInstance->LockHandle);
         }
@@ -577,6 +984,91 @@ IOTHUB_CLIENT_RESULT IoTHubClient_GetSendStatus(IOTHUB_CLIENT_HANDLE iotHubClien
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_GetOutboundQueueSize(IOTHUB_CLIENT_HANDLE iotHubClientHandle, size_t* messageCount, size_t* byteCount)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_02_089: [ If iotHubClientHandle is NULL, IoTHubClient_GetOutboundQueueSize shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_02_091: [ If acquiring the lock fails, IoTHubClient_GetOutboundQueueSize shall return IOTHUB_CLIENT_ERROR. ]*/
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_02_090: [ IoTHubClient_GetOutboundQueueSize shall call IoTHubClient_LL_GetOutboundQueueSize under the lock created in IoTHubClient_Create, passing messageCount and byteCount, and return what IoTHubClient_LL_GetOutboundQueueSize returns. ]*/
+            result = IoTHubClient_LL_GetOutboundQueueSize(iotHubClientInstance->IoTHubClientLLHandle, messageCount, byteCount);
+
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_GetMetrics(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_02_118: [ If iotHubClientHandle is NULL, IoTHubClient_GetMetrics shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        /*Codes_SRS_IOTHUBCLIENT_02_119: [ IoTHubClient_GetMetrics shall call IoTHubClient_LL_GetMetrics without taking the lock created in IoTHubClient_Create, passing snapshot, and return what IoTHubClient_LL_GetMetrics returns. ]*/
+        result = IoTHubClient_LL_GetMetrics(iotHubClientInstance->IoTHubClientLLHandle, snapshot);
+    }
+
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_SetEventConfirmationBatchCallback(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_BATCH_CALLBACK batchCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_02_115: [ If iotHubClientHandle is NULL, IoTHubClient_SetEventConfirmationBatchCallback shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_02_117: [ If acquiring the lock fails, IoTHubClient_SetEventConfirmationBatchCallback shall return IOTHUB_CLIENT_ERROR. ]*/
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_02_116: [ IoTHubClient_SetEventConfirmationBatchCallback shall call IoTHubClient_LL_SetEventConfirmationBatchCallback under the lock created in IoTHubClient_Create, passing batchCallback and userContextCallback, and return what IoTHubClient_LL_SetEventConfirmationBatchCallback returns. ]*/
+            result = IoTHubClient_LL_SetEventConfirmationBatchCallback(iotHubClientInstance->IoTHubClientLLHandle, batchCallback, userContextCallback);
+
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_SetMessageCallback(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -609,6 +1101,7 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetMessageCallback(IOTHUB_CLIENT_HANDLE iotHub
             }
             else
             {
+                /*Codes_SRS_IOTHUBCLIENT_02_121: [ The message callback shall run on the thread that calls IoTHubClient_LL_DoWork, also when the callback dispatcher is on, so that its disposition reaches the service. ]*/
                 /* Codes_SRS_IOTHUBCLIENT_01_017: [IoTHubClient_SetMessageCallback shall call IoTHubClient_LL_SetMessageCallback, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameters messageCallback and userContextCallback.] */
                 result = IoTHubClient_LL_SetMessageCallback(iotHubClientInstance->IoTHubClientLLHandle, messageCallback, userContextCallback);
             }
@@ -633,22 +1126,68 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetConnectionStatusCallback(IOTHUB_CLIENT_LL_H
     
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_SetRetryPolicy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitinSeconds)
+IOTHUB_CLIENT_RESULT IoTHubClient_SetRetryPolicy(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitinSeconds)
 {
-    IOTHUB_CLIENT_RESULT result = IOTHUB_CLIENT_OK;
-    (void)iotHubClientHandle;
-    (void)retryPolicy;
-    (void)retryTimeoutLimitinSeconds;
+    IOTHUB_CLIENT_RESULT result;
+
+    /* Codes_SRS_IOTHUBCLIENT_02_075: [ If iotHubClientHandle is NULL, IoTHubClient_SetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if (iotHubClientHandle == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        /* Codes_SRS_IOTHUBCLIENT_02_081: [ IoTHubClient_SetRetryPolicy shall be made thread-safe by using the lock created in IoTHubClient_Create. ]*/
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            /* Codes_SRS_IOTHUBCLIENT_02_082: [ If acquiring the lock fails, IoTHubClient_SetRetryPolicy shall return IOTHUB_CLIENT_ERROR. ]*/
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            /* Codes_SRS_IOTHUBCLIENT_02_076: [ IoTHubClient_SetRetryPolicy shall call IoTHubClient_LL_SetRetryPolicy, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameters retryPolicy and retryTimeoutLimitinSeconds. ]*/
+            /* Codes_SRS_IOTHUBCLIENT_02_077: [ When IoTHubClient_LL_SetRetryPolicy is called, IoTHubClient_SetRetryPolicy shall return the result of IoTHubClient_LL_SetRetryPolicy. ]*/
+            result = IoTHubClient_LL_SetRetryPolicy(iotHubClientInstance->IoTHubClientLLHandle, retryPolicy, retryTimeoutLimitinSeconds);
+            Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
 
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_GetRetryPolicy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY * retryPolicy, size_t * retryTimeoutLimitinSeconds)
+IOTHUB_CLIENT_RESULT IoTHubClient_GetRetryPolicy(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY * retryPolicy, size_t * retryTimeoutLimitinSeconds)
 {
-    IOTHUB_CLIENT_RESULT result = IOTHUB_CLIENT_OK;
-    (void)iotHubClientHandle;
-    (void)retryPolicy;
-    (void)retryTimeoutLimitinSeconds;
+    IOTHUB_CLIENT_RESULT result;
+
+    /* Codes_SRS_IOTHUBCLIENT_02_078: [ If iotHubClientHandle is NULL, IoTHubClient_GetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if (iotHubClientHandle == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        /* Codes_SRS_IOTHUBCLIENT_02_083: [ IoTHubClient_GetRetryPolicy shall be made thread-safe by using the lock created in IoTHubClient_Create. ]*/
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            /* Codes_SRS_IOTHUBCLIENT_02_084: [ If acquiring the lock fails, IoTHubClient_GetRetryPolicy shall return IOTHUB_CLIENT_ERROR. ]*/
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            /* Codes_SRS_IOTHUBCLIENT_02_079: [ IoTHubClient_GetRetryPolicy shall call IoTHubClient_LL_GetRetryPolicy, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameters retryPolicy and retryTimeoutLimitinSeconds. ]*/
+            /* Codes_SRS_IOTHUBCLIENT_02_080: [ When IoTHubClient_LL_GetRetryPolicy is called, IoTHubClient_GetRetryPolicy shall return the result of IoTHubClient_LL_GetRetryPolicy. ]*/
+            result = IoTHubClient_LL_GetRetryPolicy(iotHubClientInstance->IoTHubClientLLHandle, retryPolicy, retryTimeoutLimitinSeconds);
+            Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
 
     return result;
 }
@@ -688,6 +1227,26 @@ IOTHUB_CLIENT_RESULT IoTHubClient_GetLastMessageReceiveTime(IOTHUB_CLIENT_HANDLE
     return result;
 }
 
+/*true for the queue options whose policy answers IOTHUB_CLIENT_QUEUE_FULL when the queue is full. IoTHubClient_SendEventAsync returns before
+the ingress queue reaches the LL client, so with the ingress queue on that answer could only become a late IOTHUB_CLIENT_CONFIRMATION_ERROR*/
+static bool RefusesEventsWhenFull(const char* optionName, const void* value)
+{
+    bool result;
+    if (strcmp(optionName, OPTION_PERSISTENT_QUEUE) == 0)
+    {
+        result = (((const PERSISTENT_QUEUE_CONFIG*)value)->overflowPolicy != PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST);
+    }
+    else if (strcmp(optionName, OPTION_OUTBOUND_QUEUE_LIMITS) == 0)
+    {
+        result = (((const IOTHUB_CLIENT_QUEUE_LIMITS*)value)->overflowPolicy != IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST);
+    }
+    else
+    {
+        result = false;
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_SetOption(IOTHUB_CLIENT_HANDLE iotHubClientHandle, const char* optionName, const void* value)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -716,12 +1275,119 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetOption(IOTHUB_CLIENT_HANDLE iotHubClientHan
         }
         else
         {
+            if (strcmp(optionName, OPTION_SEND_INGRESS_QUEUE) == 0)
+            {
+                if (*(const bool*)value)
+                {
+                    if (iotHubClientInstance->TransportHandle != NULL)
+                    {
+                        /*Codes_SRS_IOTHUBCLIENT_02_093: [ If optionName is OPTION_SEND_INGRESS_QUEUE, value points to true and the transport is shared, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+                        result = IOTHUB_CLIENT_INVALID_ARG;
+                        LogError("the ingress queue is not available when the transport is shared");
+                    }
+                    else if (iotHubClientInstance->ingressQueue != NULL)
+                    {
+                        result = IOTHUB_CLIENT_OK;
+                    }
+                    else if (iotHubClientInstance->persistentQueueRefusesEvents || iotHubClientInstance->outboundQueueRefusesEvents)
+                    {
+                        /*Codes_SRS_IOTHUBCLIENT_02_122: [ If optionName is OPTION_SEND_INGRESS_QUEUE, value points to true and the policy of the persistent queue or of the outbound queue limits is REJECT or BLOCK, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+                        result = IOTHUB_CLIENT_INVALID_ARG;
+                        LogError("the ingress queue cannot report IOTHUB_CLIENT_QUEUE_FULL, use the DROP_OLDEST policy with it");
+                    }
+                    else
+                    {
+                        /*Codes_SRS_IOTHUBCLIENT_02_092: [ If optionName is OPTION_SEND_INGRESS_QUEUE and value points to true, IoTHubClient_SetOption shall create the ingress queue by calling ingress_queue_create (if it does not exist yet), shall not call IoTHubClient_LL_SetOption and shall return IOTHUB_CLIENT_OK. ]*/
+                        INGRESS_QUEUE_HANDLE ingressQueue = ingress_queue_create();
+                        if (ingressQueue == NULL)
+                        {
+                            /*Codes_SRS_IOTHUBCLIENT_02_094: [ If ingress_queue_create fails, IoTHubClient_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+                            result = IOTHUB_CLIENT_ERROR;
+                            LogError("unable to ingress_queue_create");
+                        }
+                        else
+                        {
+                            publishIngressQueue(iotHubClientInstance, ingressQueue);
+                            result = IOTHUB_CLIENT_OK;
+                        }
+                    }
+                }
+                else
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_02_095: [ If optionName is OPTION_SEND_INGRESS_QUEUE and value points to false, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG if the ingress queue is on and IOTHUB_CLIENT_OK otherwise. ]*/
+                    if (iotHubClientInstance->ingressQueue != NULL)
+                    {
+                        result = IOTHUB_CLIENT_INVALID_ARG;
+                        LogError("the ingress queue cannot be turned off, other threads may be pushing to it");
+                    }
+                    else
+                    {
+                        result = IOTHUB_CLIENT_OK;
+                    }
+                }
+            }
+            else if (strcmp(optionName, OPTION_CALLBACK_DISPATCHER) == 0)
+            {
+                if (*(const bool*)value)
+                {
+                    if (iotHubClientInstance->callbackDispatcher != NULL)
+                    {
+                        result = IOTHUB_CLIENT_OK;
+                    }
+                    else
+                    {
+                        /*Codes_SRS_IOTHUBCLIENT_02_104: [ If optionName is OPTION_CALLBACK_DISPATCHER and value points to true, IoTHubClient_SetOption shall create the callback dispatcher by calling callback_dispatcher_create (if it does not exist yet), shall not call IoTHubClient_LL_SetOption and shall return IOTHUB_CLIENT_OK. ]*/
+                        CALLBACK_DISPATCHER_HANDLE callbackDispatcher = callback_dispatcher_create();
+                        if (callbackDispatcher == NULL)
+                        {
+                            /*Codes_SRS_IOTHUBCLIENT_02_105: [ If callback_dispatcher_create fails, IoTHubClient_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+                            result = IOTHUB_CLIENT_ERROR;
+                            LogError("unable to callback_dispatcher_create");
+                        }
+                        else
+                        {
+                            publishCallbackDispatcher(iotHubClientInstance, callbackDispatcher);
+                            result = IOTHUB_CLIENT_OK;
+                        }
+                    }
+                }
+                else if (iotHubClientInstance->callbackDispatcher != NULL)
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_02_106: [ If optionName is OPTION_CALLBACK_DISPATCHER and value points to false, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG if the callback dispatcher is on and IOTHUB_CLIENT_OK otherwise. ]*/
+                    result = IOTHUB_CLIENT_INVALID_ARG;
+                    LogError("the callback dispatcher cannot be turned off, the LL client has callbacks that use it");
+                }
+                else
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_02_106: [ If optionName is OPTION_CALLBACK_DISPATCHER and value points to false, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG if the callback dispatcher is on and IOTHUB_CLIENT_OK otherwise. ]*/
+                    result = IOTHUB_CLIENT_OK;
+                }
+            }
+            else if ((iotHubClientInstance->ingressQueue != NULL) && RefusesEventsWhenFull(optionName, value))
+            {
+                /*Codes_SRS_IOTHUBCLIENT_02_123: [ If the ingress queue is on and optionName is OPTION_PERSISTENT_QUEUE or OPTION_OUTBOUND_QUEUE_LIMITS with the REJECT or BLOCK policy, IoTHubClient_SetOption shall not call IoTHubClient_LL_SetOption and shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+                result = IOTHUB_CLIENT_INVALID_ARG;
+                LogError("the ingress queue cannot report IOTHUB_CLIENT_QUEUE_FULL, use the DROP_OLDEST policy with it");
+            }
             /*Codes_SRS_IOTHUBCLIENT_02_038: [If optionName doesn't match one of the options handled by this module then IoTHubClient_SetOption shall call IoTHubClient_LL_SetOption passing the same parameters and return what IoTHubClient_LL_SetOption returns.] */
-            result = IoTHubClient_LL_SetOption(iotHubClientInstance->IoTHubClientLLHandle, optionName, value);
-            if (result != IOTHUB_CLIENT_OK)
+            else if ((result = IoTHubClient_LL_SetOption(iotHubClientInstance->IoTHubClientLLHandle, optionName, value)) != IOTHUB_CLIENT_OK)
             {
                 LogError("IoTHubClient_LL_SetOption failed");
             }
+            else if (strcmp(optionName, OPTION_PERSISTENT_QUEUE) == 0)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_02_085: [ If optionName is OPTION_PERSISTENT_QUEUE and IoTHubClient_LL_SetOption succeeds, IoTHubClient_SetOption shall remember blockTimeoutInMilliseconds when the policy is PERSISTENT_QUEUE_OVERFLOW_BLOCK. ]*/
+                const PERSISTENT_QUEUE_CONFIG* persistentQueueConfig = (const PERSISTENT_QUEUE_CONFIG*)value;
+                iotHubClientInstance->sendBlockTimeoutInMilliseconds = (persistentQueueConfig->overflowPolicy == PERSISTENT_QUEUE_OVERFLOW_BLOCK) ? persistentQueueConfig->blockTimeoutInMilliseconds : 0;
+                iotHubClientInstance->persistentQueueRefusesEvents = RefusesEventsWhenFull(optionName, value);
+            }
+            else if (strcmp(optionName, OPTION_OUTBOUND_QUEUE_LIMITS) == 0)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_02_087: [ If optionName is OPTION_OUTBOUND_QUEUE_LIMITS and IoTHubClient_LL_SetOption succeeds, IoTHubClient_SetOption shall remember blockTimeoutInMilliseconds when the policy is IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK. ]*/
+                const IOTHUB_CLIENT_QUEUE_LIMITS* limits = (const IOTHUB_CLIENT_QUEUE_LIMITS*)value;
+                iotHubClientInstance->sendBlockTimeoutInMilliseconds = (limits->overflowPolicy == IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK) ? limits->blockTimeoutInMilliseconds : 0;
+                iotHubClientInstance->outboundQueueRefusesEvents = RefusesEventsWhenFull(optionName, value);
+            }
 
             Unlock(iotHubClientInstance->LockHandle);
         }
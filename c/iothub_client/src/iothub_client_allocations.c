@@ -0,0 +1,379 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*gballoc.h is not included on purpose: this file is the allocator of the tagged sources and calls the C runtime*/
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/xlogging.h"
+
+#ifdef USE_ALLOCATION_TAGS
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#define getUsableSize malloc_size
+#else
+#include <malloc.h>
+#define getUsableSize malloc_usable_size
+#endif
+#endif
+
+#include "iothub_client_metrics.h"
+#include "iothub_client_allocations.h"
+
+#ifdef USE_ALLOCATION_TAGS
+
+/*
+ * Every accounted block is a block of the C runtime that ends with a trailer of 16 bytes keeping its size and its tag,
+ * at the end of the usable size that the C runtime reports for it. The pointer given to the SDK is the one of the C
+ * runtime, so nothing is ever read outside of a block: the blocks of the C runtime that the SDK gets from the shared
+ * utility are told from the accounted ones by the check word of the trailer, made of the address of the trailer and of
+ * the size, and an accounted block freed with the plain free stays accounted. The check word is cleared when the block
+ * is freed or reallocated. The counters of every tag are updated with atomic additions, so allocating and freeing never
+ * wait on another thread.
+ *
+ * The blocks that the SDK hands over to the application (the buffer of SERIALIZE, the records of the persistent queue)
+ * are allocated with IOTHUB_CLIENT_MALLOC_CALLER_OWNED: they have no trailer and are counted as allocations of their
+ * tag, but not as memory of the tag, so that the application freeing them with free is not reported as a leak.
+ *
+ * The counters have the size of a pointer so that the atomics are lock free on every target; on a 32 bit target the
+ * number of allocations wraps after 2^32.
+ */
+#if defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7))))
+#define ALLOCATIONS_USE_ATOMIC_BUILTINS
+#elif defined(__GNUC__)
+#define ALLOCATIONS_USE_SYNC_BUILTINS
+#else
+#error "use_allocation_tags needs the atomic builtins of gcc or clang"
+#endif
+
+#define ALLOCATION_CHECK_MAGIC 0x9E3779B9U
+#define ALLOCATION_CHECK_MARK 0x80000000U
+
+typedef struct ALLOCATION_TRAILER_TAG
+{
+    uint64_t size;
+    uint32_t tag;
+    uint32_t check;
+} ALLOCATION_TRAILER;
+
+typedef struct ALLOCATION_COUNTERS_TAG
+{
+    volatile size_t currentBytes;
+    volatile size_t peakBytes;
+    volatile size_t liveBlocks;
+    volatile size_t allocations;
+} ALLOCATION_COUNTERS;
+
+typedef enum ALLOCATION_REPORT_TAG
+{
+    ALLOCATION_REPORT_NONE,
+    ALLOCATION_REPORT_AT_EXIT,
+    ALLOCATION_REPORT_STRICT
+} ALLOCATION_REPORT;
+
+static ALLOCATION_COUNTERS counters[IOTHUB_CLIENT_ALLOCATION_TAG_COUNT];
+static volatile size_t reportChecked;
+static ALLOCATION_REPORT report;
+
+static const char* const TAG_NAMES[IOTHUB_CLIENT_ALLOCATION_TAG_COUNT] = { "client", "message", "queue", "transport", "upload", "serializer" };
+
+#if defined(ALLOCATIONS_USE_ATOMIC_BUILTINS)
+static size_t loadCounter(volatile size_t* counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static size_t addToCounter(volatile size_t* counter, size_t value)
+{
+    return __atomic_add_fetch(counter, value, __ATOMIC_RELAXED);
+}
+
+static void subtractFromCounter(volatile size_t* counter, size_t value)
+{
+    (void)__atomic_sub_fetch(counter, value, __ATOMIC_RELAXED);
+}
+
+static bool replaceCounter(volatile size_t* counter, size_t expected, size_t desired)
+{
+    return __atomic_compare_exchange_n(counter, &expected, desired, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED) ? true : false;
+}
+#else
+static size_t loadCounter(volatile size_t* counter)
+{
+    return __sync_fetch_and_add(counter, 0);
+}
+
+static size_t addToCounter(volatile size_t* counter, size_t value)
+{
+    return __sync_add_and_fetch(counter, value);
+}
+
+static void subtractFromCounter(volatile size_t* counter, size_t value)
+{
+    (void)__sync_sub_and_fetch(counter, value);
+}
+
+static bool replaceCounter(volatile size_t* counter, size_t expected, size_t desired)
+{
+    return __sync_bool_compare_and_swap(counter, expected, desired) ? true : false;
+}
+#endif
+
+static uint32_t getCheck(const unsigned char* location, uint64_t size)
+{
+    return ((uint32_t)((uintptr_t)location >> 3) ^ (uint32_t)size ^ ALLOCATION_CHECK_MAGIC) | ALLOCATION_CHECK_MARK;
+}
+
+static unsigned char* getTrailerLocation(void* ptr)
+{
+    size_t usableSize = getUsableSize(ptr);
+    return (usableSize < sizeof(ALLOCATION_TRAILER)) ? NULL : (unsigned char*)ptr + usableSize - sizeof(ALLOCATION_TRAILER);
+}
+
+static void setTrailer(void* ptr, size_t size, IOTHUB_CLIENT_ALLOCATION_TAG tag)
+{
+    unsigned char* location = getTrailerLocation(ptr);
+    ALLOCATION_TRAILER trailer;
+    trailer.size = size;
+    trailer.tag = (uint32_t)tag;
+    trailer.check = getCheck(location, trailer.size);
+    /*the usable size of a block can be anything, so the trailer is not aligned*/
+    (void)memcpy(location, &trailer, sizeof(trailer));
+}
+
+static void clearTrailer(void* ptr)
+{
+    uint32_t check = 0;
+    (void)memcpy(getTrailerLocation(ptr) + offsetof(ALLOCATION_TRAILER, check), &check, sizeof(check));
+}
+
+/*returns false when ptr is a block of the C runtime*/
+static bool getTrailer(void* ptr, ALLOCATION_TRAILER* trailer)
+{
+    unsigned char* location = getTrailerLocation(ptr);
+    bool result;
+    if (location == NULL)
+    {
+        result = false;
+    }
+    else
+    {
+        (void)memcpy(trailer, location, sizeof(ALLOCATION_TRAILER));
+        result = (trailer->check == getCheck(location, trailer->size)) && (trailer->tag < IOTHUB_CLIENT_ALLOCATION_TAG_COUNT);
+    }
+    return result;
+}
+
+static void addBlock(IOTHUB_CLIENT_ALLOCATION_TAG tag, size_t size)
+{
+    size_t current = addToCounter(&counters[tag].currentBytes, size);
+    size_t peak = loadCounter(&counters[tag].peakBytes);
+    (void)addToCounter(&counters[tag].liveBlocks, 1);
+    (void)addToCounter(&counters[tag].allocations, 1);
+    while ((current > peak) && !replaceCounter(&counters[tag].peakBytes, peak, current))
+    {
+        peak = loadCounter(&counters[tag].peakBytes);
+    }
+}
+
+static void removeBlock(const ALLOCATION_TRAILER* trailer)
+{
+    subtractFromCounter(&counters[trailer->tag].currentBytes, (size_t)trailer->size);
+    subtractFromCounter(&counters[trailer->tag].liveBlocks, 1);
+}
+
+static void reportAllocations(void)
+{
+    size_t leakedBlocks = 0;
+    size_t i;
+
+    (void)fprintf(stderr, "iothub_client allocations at exit:\n%-12s %14s %14s %14s %14s\n", "tag", "leaked bytes", "leaked blocks", "peak bytes", "allocations");
+    for (i = 0; i < IOTHUB_CLIENT_ALLOCATION_TAG_COUNT; i++)
+    {
+        size_t liveBlocks = loadCounter(&counters[i].liveBlocks);
+        (void)fprintf(stderr, "%-12s %14llu %14llu %14llu %14llu\n", TAG_NAMES[i],
+            (unsigned long long)loadCounter(&counters[i].currentBytes), (unsigned long long)liveBlocks,
+            (unsigned long long)loadCounter(&counters[i].peakBytes), (unsigned long long)loadCounter(&counters[i].allocations));
+        leakedBlocks += liveBlocks;
+    }
+
+    if ((report == ALLOCATION_REPORT_STRICT) && (leakedBlocks > 0))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_010: [ When IOTHUB_CLIENT_ALLOCATION_REPORT is "strict" and a block is still accounted at exit, the process shall exit with EXIT_FAILURE. ]*/
+        (void)fprintf(stderr, "%llu block(s) allocated by iothub_client were not freed\n", (unsigned long long)leakedBlocks);
+        (void)fflush(stderr);
+        _Exit(EXIT_FAILURE);
+    }
+}
+
+static void checkReport(void)
+{
+    /*only the first allocation reads the environment, the others do not wait for it*/
+    if ((loadCounter(&reportChecked) == 0) && replaceCounter(&reportChecked, 0, 1))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_009: [ At the first accounted allocation, when the environment variable IOTHUB_CLIENT_ALLOCATION_REPORT is "1" or "strict", the memory still allocated, the peak and the allocations of every tag shall be written to stderr when the process exits. ]*/
+        const char* mode = getenv(IOTHUB_CLIENT_ALLOCATION_REPORT_VARIABLE);
+        if (mode != NULL)
+        {
+            report = (strcmp(mode, "strict") == 0) ? ALLOCATION_REPORT_STRICT : (strcmp(mode, "1") == 0) ? ALLOCATION_REPORT_AT_EXIT : ALLOCATION_REPORT_NONE;
+            if ((report != ALLOCATION_REPORT_NONE) && (atexit(reportAllocations) != 0))
+            {
+                report = ALLOCATION_REPORT_NONE;
+            }
+        }
+    }
+}
+
+static void* taggedAllocated(void* result, size_t size, IOTHUB_CLIENT_ALLOCATION_TAG tag)
+{
+    if (result != NULL)
+    {
+        checkReport();
+        setTrailer(result, size, tag);
+        addBlock(tag, size);
+    }
+    return result;
+}
+
+static void* taggedMalloc(IOTHUB_CLIENT_ALLOCATION_TAG tag, size_t size)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_001: [ iothub_client_malloc_<tag> shall call malloc and, when it returns a block, add its size to the memory of the tag and count one allocation. ]*/
+    return (size > SIZE_MAX - sizeof(ALLOCATION_TRAILER)) ? NULL : taggedAllocated(malloc(size + sizeof(ALLOCATION_TRAILER)), size, tag);
+}
+
+static void* taggedCalloc(IOTHUB_CLIENT_ALLOCATION_TAG tag, size_t nmemb, size_t size)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_002: [ iothub_client_calloc_<tag> shall call calloc and, when it returns a block, add nmemb * size to the memory of the tag and count one allocation. ]*/
+    return ((size != 0) && (nmemb > (SIZE_MAX - sizeof(ALLOCATION_TRAILER)) / size)) ? NULL : taggedAllocated(calloc(1, nmemb * size + sizeof(ALLOCATION_TRAILER)), nmemb * size, tag);
+}
+
+static void* taggedRealloc(IOTHUB_CLIENT_ALLOCATION_TAG tag, void* ptr, size_t size)
+{
+    void* result;
+    ALLOCATION_TRAILER previous;
+
+    if (ptr == NULL)
+    {
+        result = taggedMalloc(tag, size);
+    }
+    else if (!getTrailer(ptr, &previous))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_006: [ When ptr was not allocated by a tagged function, iothub_client_realloc_<tag> and iothub_client_free_tagged shall call realloc and free without accounting the block. ]*/
+        result = realloc(ptr, size);
+    }
+    else if (size > SIZE_MAX - sizeof(ALLOCATION_TRAILER))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_004: [ When realloc fails, the previous block shall stay accounted to its tag. ]*/
+        result = NULL;
+    }
+    else
+    {
+        /*realloc can leave the trailer where a block of the C runtime will be*/
+        clearTrailer(ptr);
+        result = realloc(ptr, size + sizeof(ALLOCATION_TRAILER));
+        if (result == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_004: [ When realloc fails, the previous block shall stay accounted to its tag. ]*/
+            setTrailer(ptr, (size_t)previous.size, (IOTHUB_CLIENT_ALLOCATION_TAG)previous.tag);
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_003: [ iothub_client_realloc_<tag> shall call realloc, remove the previous block from the memory of its tag and, when realloc returns a block, add its size to the memory of the reallocating tag and count one allocation. ]*/
+            removeBlock(&previous);
+            (void)taggedAllocated(result, size, tag);
+        }
+    }
+    return result;
+}
+
+static void* callerOwnedMalloc(IOTHUB_CLIENT_ALLOCATION_TAG tag, size_t size)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_012: [ iothub_client_malloc_caller_owned_<tag> shall call malloc and, when it returns a block, count one allocation of the tag without adding the block to the memory of the tag, so that the block can be freed with free and is not reported at exit. ]*/
+    void* result = malloc(size);
+    if (result != NULL)
+    {
+        checkReport();
+        (void)addToCounter(&counters[tag].allocations, 1);
+    }
+    return result;
+}
+
+#define DEFINE_TAGGED_ALLOCATION_FUNCTIONS(name, tag)                                   \
+    void* iothub_client_malloc_##name(size_t size)                                      \
+    {                                                                                   \
+        return taggedMalloc(tag, size);                                                 \
+    }                                                                                   \
+    void* iothub_client_calloc_##name(size_t nmemb, size_t size)                        \
+    {                                                                                   \
+        return taggedCalloc(tag, nmemb, size);                                          \
+    }                                                                                   \
+    void* iothub_client_realloc_##name(void* ptr, size_t size)                          \
+    {                                                                                   \
+        return taggedRealloc(tag, ptr, size);                                           \
+    }                                                                                   \
+    void* iothub_client_malloc_caller_owned_##name(size_t size)                         \
+    {                                                                                   \
+        return callerOwnedMalloc(tag, size);                                            \
+    }
+
+DEFINE_TAGGED_ALLOCATION_FUNCTIONS(client, IOTHUB_CLIENT_ALLOCATION_TAG_CLIENT)
+DEFINE_TAGGED_ALLOCATION_FUNCTIONS(message, IOTHUB_CLIENT_ALLOCATION_TAG_MESSAGE)
+DEFINE_TAGGED_ALLOCATION_FUNCTIONS(queue, IOTHUB_CLIENT_ALLOCATION_TAG_QUEUE)
+DEFINE_TAGGED_ALLOCATION_FUNCTIONS(transport, IOTHUB_CLIENT_ALLOCATION_TAG_TRANSPORT)
+DEFINE_TAGGED_ALLOCATION_FUNCTIONS(upload, IOTHUB_CLIENT_ALLOCATION_TAG_UPLOAD)
+DEFINE_TAGGED_ALLOCATION_FUNCTIONS(serializer, IOTHUB_CLIENT_ALLOCATION_TAG_SERIALIZER)
+
+void iothub_client_free_tagged(void* ptr)
+{
+    ALLOCATION_TRAILER trailer;
+    if ((ptr != NULL) && getTrailer(ptr, &trailer))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_005: [ iothub_client_free_tagged shall remove the block from the memory of its tag and then call free. ]*/
+        removeBlock(&trailer);
+        clearTrailer(ptr);
+    }
+
+    /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_006: [ When ptr was not allocated by a tagged function, iothub_client_realloc_<tag> and iothub_client_free_tagged shall call realloc and free without accounting the block. ]*/
+    free(ptr);
+}
+
+int iothub_client_metrics_get_allocations(IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT* snapshot)
+{
+    int result;
+    if (snapshot == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_007: [ If snapshot is NULL, iothub_client_metrics_get_allocations shall fail and return a non-zero value. ]*/
+        LogError("invalid argument IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT* snapshot=NULL");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t i;
+
+        /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_008: [ iothub_client_metrics_get_allocations shall read the current bytes, peak bytes, live blocks and allocations of every tag and return 0. ]*/
+        for (i = 0; i < IOTHUB_CLIENT_ALLOCATION_TAG_COUNT; i++)
+        {
+            snapshot->currentBytes[i] = loadCounter(&counters[i].currentBytes);
+            snapshot->peakBytes[i] = loadCounter(&counters[i].peakBytes);
+            snapshot->liveBlocks[i] = loadCounter(&counters[i].liveBlocks);
+            snapshot->allocations[i] = loadCounter(&counters[i].allocations);
+        }
+        result = 0;
+    }
+    return result;
+}
+
+#else
+
+int iothub_client_metrics_get_allocations(IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT* snapshot)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_011: [ When the SDK is built without use_allocation_tags, iothub_client_metrics_get_allocations shall fail and return a non-zero value. ]*/
+    (void)snapshot;
+    LogError("iothub_client was built without use_allocation_tags");
+    return __LINE__;
+}
+
+#endif
@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
+
+#include "iothub_client_callback_dispatcher.h"
+
+/*how long the dispatcher thread sleeps when it found nothing to run*/
+#define CALLBACK_DISPATCHER_IDLE_SLEEP_IN_MILLISECONDS 1
+
+typedef struct CALLBACK_DISPATCHER_INSTANCE_TAG
+{
+    INGRESS_QUEUE_HANDLE queue;
+    THREAD_HANDLE thread;
+    CALLBACK_DISPATCHER_ITEM stopItem; /*posted by callback_dispatcher_destroy, so the stop request is ordered like any other item*/
+    int stopThread; /*only touched by the dispatcher thread*/
+} CALLBACK_DISPATCHER_INSTANCE;
+
+static void RunItem(INGRESS_QUEUE_ENTRY* entry, void* context)
+{
+    CALLBACK_DISPATCHER_ITEM* item = containingRecord(entry, CALLBACK_DISPATCHER_ITEM, entry);
+    (void)context;
+    item->function(item);
+}
+
+static void StopThread(CALLBACK_DISPATCHER_ITEM* item)
+{
+    CALLBACK_DISPATCHER_INSTANCE* dispatcher = containingRecord(item, CALLBACK_DISPATCHER_INSTANCE, stopItem);
+    dispatcher->stopThread = 1;
+}
+
+static int DispatcherThread(void* threadArgument)
+{
+    CALLBACK_DISPATCHER_INSTANCE* dispatcher = (CALLBACK_DISPATCHER_INSTANCE*)threadArgument;
+
+    /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_004: [ The thread shall take all the posted items and call their function, in the order the items were posted, and sleep 1 ms when there was none, until it runs the stop request of callback_dispatcher_destroy. ]*/
+    while (!dispatcher->stopThread)
+    {
+        if (ingress_queue_drain(dispatcher->queue, RunItem, NULL) == 0)
+        {
+            ThreadAPI_Sleep(CALLBACK_DISPATCHER_IDLE_SLEEP_IN_MILLISECONDS);
+        }
+    }
+
+    return 0;
+}
+
+CALLBACK_DISPATCHER_HANDLE callback_dispatcher_create(void)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_001: [ callback_dispatcher_create shall allocate a dispatcher, create its queue by calling ingress_queue_create and start its thread by calling ThreadAPI_Create. ]*/
+    CALLBACK_DISPATCHER_INSTANCE* result = (CALLBACK_DISPATCHER_INSTANCE*)malloc(sizeof(CALLBACK_DISPATCHER_INSTANCE));
+    if (result == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_002: [ If any failure occurs, callback_dispatcher_create shall free what it allocated and return NULL. ]*/
+        LogError("unable to malloc");
+    }
+    else
+    {
+        result->stopThread = 0;
+        if ((result->queue = ingress_queue_create()) == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_002: [ If any failure occurs, callback_dispatcher_create shall free what it allocated and return NULL. ]*/
+            LogError("unable to ingress_queue_create");
+            free(result);
+            result = NULL;
+        }
+        else if (ThreadAPI_Create(&result->thread, DispatcherThread, result) != THREADAPI_OK)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_002: [ If any failure occurs, callback_dispatcher_create shall free what it allocated and return NULL. ]*/
+            LogError("unable to ThreadAPI_Create");
+            ingress_queue_destroy(result->queue);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_003: [ Otherwise callback_dispatcher_create shall return a non-NULL handle. ]*/
+        }
+    }
+    return result;
+}
+
+void callback_dispatcher_destroy(CALLBACK_DISPATCHER_HANDLE dispatcher)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_005: [ If dispatcher is NULL, callback_dispatcher_destroy shall do nothing. ]*/
+    if (dispatcher != NULL)
+    {
+        int notUsed;
+
+        /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_006: [ callback_dispatcher_destroy shall post a stop request after the items already posted and join the thread by calling ThreadAPI_Join. ]*/
+        (void)callback_dispatcher_post(dispatcher, &dispatcher->stopItem, StopThread);
+        if (ThreadAPI_Join(dispatcher->thread, &notUsed) != THREADAPI_OK)
+        {
+            LogError("unable to ThreadAPI_Join");
+        }
+
+        /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_007: [ callback_dispatcher_destroy shall call the function of every item still posted, on the calling thread, so that every item runs exactly once. ]*/
+        (void)ingress_queue_drain(dispatcher->queue, RunItem, NULL);
+
+        /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_008: [ callback_dispatcher_destroy shall destroy the queue and free the dispatcher. ]*/
+        ingress_queue_destroy(dispatcher->queue);
+        free(dispatcher);
+    }
+}
+
+int callback_dispatcher_post(CALLBACK_DISPATCHER_HANDLE dispatcher, CALLBACK_DISPATCHER_ITEM* item, CALLBACK_DISPATCHER_FUNCTION function)
+{
+    int result;
+    if ((dispatcher == NULL) || (item == NULL) || (function == NULL))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_009: [ If dispatcher, item or function is NULL, callback_dispatcher_post shall fail and return a non-zero value. ]*/
+        LogError("invalid arguments CALLBACK_DISPATCHER_HANDLE dispatcher=%p, CALLBACK_DISPATCHER_ITEM* item=%p, CALLBACK_DISPATCHER_FUNCTION function=%p", dispatcher, item, function);
+        result = __LINE__;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_010: [ callback_dispatcher_post shall remember function in item, push item to the queue by calling ingress_queue_push and return what ingress_queue_push returns. ]*/
+        item->function = function;
+        result = ingress_queue_push(dispatcher->queue, &item->entry);
+    }
+    return result;
+}
@@ -0,0 +1,592 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include <stdint.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/map.h"
+
+#include "iothub_client_compression.h"
+
+/*
+ * A compressed body is {uint32 little endian uncompressed size} followed by an LZ4 block:
+ *  - a sequence is a token {4 bits literal length, 4 bits match length - 4}, the literal length continued with 255 bytes
+ *    if it is 15, the literals, a uint16 little endian offset, the match length continued with 255 bytes if it is 15
+ *  - the last sequence has only literals, the last 5 bytes are always literals and no match starts in the last 12 bytes
+ *  - an offset can go back into the dictionary, the dictionary is the data "before" the body
+ */
+#define MIN_MATCH                   4
+#define LAST_LITERALS               5
+#define MATCH_FIND_LIMIT            12
+#define MAX_OFFSET                  65535
+#define RUN_MASK                    15
+#define HASH_LOG                    12
+#define HASH_SIZE                   (1 << HASH_LOG)
+#define NO_POSITION                 UINT32_MAX
+/*every 64 bytes without a match the coder skips one more byte, incompressible data goes by quickly*/
+#define SKIP_STRENGTH               6
+
+typedef struct COMPRESSION_INSTANCE_TAG
+{
+    unsigned char* window; /*the dictionary followed by the body being compressed*/
+    size_t windowCapacity;
+    size_t dictionarySize;
+    uint32_t dictionaryTable[HASH_SIZE]; /*positions of the dictionary, computed once*/
+    uint32_t table[HASH_SIZE];
+} COMPRESSION_INSTANCE;
+
+static uint32_t read32(const unsigned char* source)
+{
+    return (uint32_t)source[0] | ((uint32_t)source[1] << 8) | ((uint32_t)source[2] << 16) | ((uint32_t)source[3] << 24);
+}
+
+static uint32_t hash32(uint32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - HASH_LOG);
+}
+
+COMPRESSION_HANDLE compression_create(const unsigned char* dictionary, size_t dictionarySize)
+{
+    COMPRESSION_INSTANCE* result;
+    /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_001: [ If dictionary is NULL and dictionarySize is not 0, compression_create shall fail and return NULL. ]*/
+    if ((dictionary == NULL) && (dictionarySize != 0))
+    {
+        LogError("invalid arguments const unsigned char* dictionary=%p, size_t dictionarySize=%lu", dictionary, (unsigned long)dictionarySize);
+        result = NULL;
+    }
+    else if ((result = (COMPRESSION_INSTANCE*)malloc(sizeof(COMPRESSION_INSTANCE))) == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_003: [ If any failure occurs, compression_create shall fail and return NULL. ]*/
+        LogError("unable to malloc");
+    }
+    else
+    {
+        size_t i;
+
+        /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_002: [ compression_create shall copy the last COMPRESSION_MAX_DICTIONARY_SIZE bytes of the dictionary and hash its positions once. ]*/
+        if (dictionarySize > COMPRESSION_MAX_DICTIONARY_SIZE)
+        {
+            dictionary += dictionarySize - COMPRESSION_MAX_DICTIONARY_SIZE;
+            dictionarySize = COMPRESSION_MAX_DICTIONARY_SIZE;
+        }
+        result->dictionarySize = dictionarySize;
+        result->windowCapacity = 0;
+        result->window = NULL;
+        for (i = 0; i < HASH_SIZE; i++)
+        {
+            result->dictionaryTable[i] = NO_POSITION;
+        }
+
+        if (dictionarySize > 0)
+        {
+            result->windowCapacity = dictionarySize;
+            if ((result->window = (unsigned char*)malloc(dictionarySize)) == NULL)
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_003: [ If any failure occurs, compression_create shall fail and return NULL. ]*/
+                LogError("unable to malloc the dictionary");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                (void)memcpy(result->window, dictionary, dictionarySize);
+                for (i = 0; i + MIN_MATCH <= dictionarySize; i++)
+                {
+                    result->dictionaryTable[hash32(read32(result->window + i))] = (uint32_t)i;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+void compression_destroy(COMPRESSION_HANDLE compression)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_004: [ If compression is NULL, compression_destroy shall do nothing. ]*/
+    if (compression != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_005: [ compression_destroy shall free the dictionary and the instance. ]*/
+        free(compression->window);
+        free(compression);
+    }
+}
+
+size_t compression_get_bound(size_t size)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_006: [ compression_get_bound shall return COMPRESSION_HEADER_SIZE + size + size / 255 + 16. ]*/
+    return COMPRESSION_HEADER_SIZE + size + size / 255 + 16;
+}
+
+/*writes a length that did not fit in the 4 bits of the token, returns the new position or NULL if it does not fit*/
+static unsigned char* writeLength(unsigned char* op, const unsigned char* oend, size_t length)
+{
+    while ((op != NULL) && (length >= 255))
+    {
+        if (op >= oend)
+        {
+            op = NULL;
+        }
+        else
+        {
+            *op++ = 255;
+            length -= 255;
+        }
+    }
+    if (op != NULL)
+    {
+        if (op >= oend)
+        {
+            op = NULL;
+        }
+        else
+        {
+            *op++ = (unsigned char)length;
+        }
+    }
+    return op;
+}
+
+/*writes literals [anchor, anchor + literalLength) and, if matchLength is not 0, the match. Returns the new position or NULL if it does not fit*/
+static unsigned char* writeSequence(unsigned char* op, const unsigned char* oend, const unsigned char* anchor, size_t literalLength, size_t offset, size_t matchLength)
+{
+    unsigned char* token = op;
+    if (op >= oend)
+    {
+        op = NULL;
+    }
+    else
+    {
+        op++;
+        *token = (unsigned char)(((literalLength >= RUN_MASK) ? RUN_MASK : literalLength) << 4);
+        if (literalLength >= RUN_MASK)
+        {
+            op = writeLength(op, oend, literalLength - RUN_MASK);
+        }
+        if ((op != NULL) && ((size_t)(oend - op) < literalLength))
+        {
+            op = NULL;
+        }
+        if (op != NULL)
+        {
+            if (literalLength > 0)
+            {
+                (void)memcpy(op, anchor, literalLength);
+                op += literalLength;
+            }
+            if (matchLength != 0)
+            {
+                size_t code = matchLength - MIN_MATCH;
+                if ((size_t)(oend - op) < 2)
+                {
+                    op = NULL;
+                }
+                else
+                {
+                    *op++ = (unsigned char)(offset & 0xFF);
+                    *op++ = (unsigned char)(offset >> 8);
+                    *token |= (unsigned char)((code >= RUN_MASK) ? RUN_MASK : code);
+                    if (code >= RUN_MASK)
+                    {
+                        op = writeLength(op, oend, code - RUN_MASK);
+                    }
+                }
+            }
+        }
+    }
+    return op;
+}
+
+int compression_compress(COMPRESSION_HANDLE compression, const unsigned char* source, size_t size, unsigned char* destination, size_t* destinationSize)
+{
+    int result;
+    /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_007: [ If compression, destination or destinationSize is NULL, or source is NULL and size is not 0, compression_compress shall fail and return a non-zero value. ]*/
+    if ((compression == NULL) || (destination == NULL) || (destinationSize == NULL) || ((source == NULL) && (size != 0)) || (size > UINT32_MAX - COMPRESSION_MAX_DICTIONARY_SIZE))
+    {
+        LogError("invalid arguments COMPRESSION_HANDLE compression=%p, const unsigned char* source=%p, size_t size=%lu, unsigned char* destination=%p, size_t* destinationSize=%p",
+            compression, source, (unsigned long)size, destination, destinationSize);
+        result = __LINE__;
+    }
+    else if (*destinationSize < COMPRESSION_HEADER_SIZE)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_009: [ If the compressed body does not fit in *destinationSize bytes, compression_compress shall fail and return a non-zero value. ]*/
+        result = __LINE__;
+    }
+    else
+    {
+        /*the body is copied after the dictionary so that a match can start in the dictionary and go on in the body*/
+        size_t windowSize = compression->dictionarySize + size;
+        if (windowSize > compression->windowCapacity)
+        {
+            unsigned char* newWindow = (unsigned char*)realloc(compression->window, windowSize);
+            if (newWindow != NULL)
+            {
+                compression->window = newWindow;
+                compression->windowCapacity = windowSize;
+            }
+        }
+
+        if (windowSize > compression->windowCapacity)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_010: [ If any other failure occurs, compression_compress shall fail and return a non-zero value. ]*/
+            LogError("unable to grow the window to %lu bytes", (unsigned long)windowSize);
+            result = __LINE__;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_008: [ compression_compress shall write the uncompressed size followed by the LZ4 block of the body, matches may reference the dictionary, and set *destinationSize to the size written. ]*/
+            const unsigned char* window = compression->window;
+            const unsigned char* oend = destination + *destinationSize;
+            unsigned char* op = destination + COMPRESSION_HEADER_SIZE;
+            size_t base = compression->dictionarySize;
+            size_t end = base + size;
+            size_t anchor = base;
+            size_t ip = base;
+
+            if (size > 0)
+            {
+                (void)memcpy(compression->window + base, source, size);
+            }
+            (void)memcpy(compression->table, compression->dictionaryTable, sizeof(compression->table));
+            destination[0] = (unsigned char)(size & 0xFF);
+            destination[1] = (unsigned char)((size >> 8) & 0xFF);
+            destination[2] = (unsigned char)((size >> 16) & 0xFF);
+            destination[3] = (unsigned char)((size >> 24) & 0xFF);
+
+            while ((op != NULL) && (ip + MATCH_FIND_LIMIT <= end))
+            {
+                uint32_t sequence = read32(window + ip);
+                uint32_t h = hash32(sequence);
+                uint32_t ref = compression->table[h];
+                compression->table[h] = (uint32_t)ip;
+
+                if ((ref != NO_POSITION) && (ip - ref <= MAX_OFFSET) && (read32(window + ref) == sequence))
+                {
+                    size_t matchStart = ip;
+                    size_t matchLength = MIN_MATCH;
+                    size_t refStart = ref;
+
+                    while ((matchStart > anchor) && (refStart > 0) && (window[matchStart - 1] == window[refStart - 1]))
+                    {
+                        matchStart--;
+                        refStart--;
+                        matchLength++;
+                    }
+                    while ((matchStart + matchLength < end - LAST_LITERALS) &&
+                        (window[refStart + matchLength] == window[matchStart + matchLength]))
+                    {
+                        matchLength++;
+                    }
+
+                    op = writeSequence(op, oend, window + anchor, matchStart - anchor, matchStart - refStart, matchLength);
+                    ip = matchStart + matchLength;
+                    anchor = ip;
+                    if (ip + MATCH_FIND_LIMIT <= end)
+                    {
+                        compression->table[hash32(read32(window + ip - 2))] = (uint32_t)(ip - 2);
+                    }
+                }
+                else
+                {
+                    ip += 1 + ((ip - anchor) >> SKIP_STRENGTH);
+                }
+            }
+
+            if (op != NULL)
+            {
+                op = writeSequence(op, oend, window + anchor, end - anchor, 0, 0);
+            }
+
+            if (op == NULL)
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_009: [ If the compressed body does not fit in *destinationSize bytes, compression_compress shall fail and return a non-zero value. ]*/
+                result = __LINE__;
+            }
+            else
+            {
+                *destinationSize = (size_t)(op - destination);
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+/*reads a length continued with 255 bytes, returns non-zero if the body ends first*/
+static int readLength(const unsigned char** ip, const unsigned char* iend, size_t* length)
+{
+    int result = 0;
+    unsigned char byte;
+    do
+    {
+        if (*ip >= iend)
+        {
+            result = __LINE__;
+            break;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return result;
+}
+
+int compression_decompress(COMPRESSION_HANDLE compression, const unsigned char* source, size_t size, unsigned char* destination, size_t* destinationSize)
+{
+    int result;
+    /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_011: [ If compression, source, destination or destinationSize is NULL, compression_decompress shall fail and return a non-zero value. ]*/
+    if ((compression == NULL) || (source == NULL) || (destination == NULL) || (destinationSize == NULL))
+    {
+        LogError("invalid arguments COMPRESSION_HANDLE compression=%p, const unsigned char* source=%p, unsigned char* destination=%p, size_t* destinationSize=%p",
+            compression, source, destination, destinationSize);
+        result = __LINE__;
+    }
+    else if (size < COMPRESSION_HEADER_SIZE + 1)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_013: [ If the body is corrupt, compression_decompress shall fail and return a non-zero value. ]*/
+        LogError("the body is too short to be compressed");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t expectedSize = (size_t)read32(source);
+        if (expectedSize > *destinationSize)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_014: [ If the uncompressed body does not fit in *destinationSize bytes, compression_decompress shall fail and return a non-zero value. ]*/
+            LogError("the body needs %lu bytes, only %lu are available", (unsigned long)expectedSize, (unsigned long)*destinationSize);
+            result = __LINE__;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_012: [ compression_decompress shall decode the LZ4 block, resolving the offsets that go back beyond the start of the body in the dictionary, and set *destinationSize to the uncompressed size. ]*/
+            const unsigned char* ip = source + COMPRESSION_HEADER_SIZE;
+            const unsigned char* iend = source + size;
+            unsigned char* op = destination;
+            unsigned char* oend = destination + expectedSize;
+            const unsigned char* dictionaryEnd = compression->window + compression->dictionarySize;
+
+            result = 0;
+            while (result == 0)
+            {
+                unsigned char token;
+                size_t literalLength;
+                size_t matchLength;
+                size_t offset;
+
+                if (ip >= iend)
+                {
+                    result = __LINE__;
+                    break;
+                }
+                token = *ip++;
+                literalLength = token >> 4;
+                if ((literalLength == RUN_MASK) && (readLength(&ip, iend, &literalLength) != 0))
+                {
+                    result = __LINE__;
+                    break;
+                }
+                if (((size_t)(iend - ip) < literalLength) || ((size_t)(oend - op) < literalLength))
+                {
+                    result = __LINE__;
+                    break;
+                }
+                (void)memcpy(op, ip, literalLength);
+                ip += literalLength;
+                op += literalLength;
+
+                if (ip == iend)
+                {
+                    /*the last sequence has no match*/
+                    break;
+                }
+
+                if ((size_t)(iend - ip) < 2)
+                {
+                    result = __LINE__;
+                    break;
+                }
+                offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+                ip += 2;
+                matchLength = token & RUN_MASK;
+                if ((matchLength == RUN_MASK) && (readLength(&ip, iend, &matchLength) != 0))
+                {
+                    result = __LINE__;
+                    break;
+                }
+                matchLength += MIN_MATCH;
+
+                if ((offset == 0) || (offset > (size_t)(op - destination) + compression->dictionarySize) || ((size_t)(oend - op) < matchLength))
+                {
+                    result = __LINE__;
+                    break;
+                }
+
+                if (offset > (size_t)(op - destination))
+                {
+                    /*the match starts in the dictionary and may go on in the body*/
+                    size_t inDictionary = offset - (size_t)(op - destination);
+                    const unsigned char* match = dictionaryEnd - inDictionary;
+                    size_t fromDictionary = (inDictionary < matchLength) ? inDictionary : matchLength;
+                    (void)memcpy(op, match, fromDictionary);
+                    op += fromDictionary;
+                    matchLength -= fromDictionary;
+                }
+
+                {
+                    /*byte by byte, the match can overlap what it produces*/
+                    const unsigned char* match = op - offset;
+                    while (matchLength > 0)
+                    {
+                        *op++ = *match++;
+                        matchLength--;
+                    }
+                }
+            }
+
+            if ((result == 0) && (op != oend))
+            {
+                result = __LINE__;
+            }
+
+            if (result != 0)
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_013: [ If the body is corrupt, compression_decompress shall fail and return a non-zero value. ]*/
+                LogError("the compressed body is corrupt");
+            }
+            else
+            {
+                *destinationSize = expectedSize;
+            }
+        }
+    }
+    return result;
+}
+
+static int copyMessageFields(IOTHUB_MESSAGE_HANDLE source, IOTHUB_MESSAGE_HANDLE destination, const char* dictionaryId)
+{
+    int result;
+    MAP_HANDLE sourceProperties;
+    MAP_HANDLE destinationProperties;
+    const char*const* keys;
+    const char*const* values;
+    size_t propertyCount;
+    const char* messageId = IoTHubMessage_GetMessageId(source);
+    const char* correlationId = IoTHubMessage_GetCorrelationId(source);
+
+    if (((sourceProperties = IoTHubMessage_Properties(source)) == NULL) ||
+        ((destinationProperties = IoTHubMessage_Properties(destination)) == NULL) ||
+        (Map_GetInternals(sourceProperties, &keys, &values, &propertyCount) != MAP_OK))
+    {
+        LogError("unable to get the message properties");
+        result = __LINE__;
+    }
+    else if (((messageId != NULL) && (IoTHubMessage_SetMessageId(destination, messageId) != IOTHUB_MESSAGE_OK)) ||
+        ((correlationId != NULL) && (IoTHubMessage_SetCorrelationId(destination, correlationId) != IOTHUB_MESSAGE_OK)) ||
+        (IoTHubMessage_SetPriority(destination, IoTHubMessage_GetPriority(source)) != IOTHUB_MESSAGE_OK))
+    {
+        LogError("unable to copy the message id, the correlation id or the priority");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t i;
+        result = 0;
+        for (i = 0; (i < propertyCount) && (result == 0); i++)
+        {
+            if (Map_AddOrUpdate(destinationProperties, keys[i], values[i]) != MAP_OK)
+            {
+                LogError("unable to copy the property %s", keys[i]);
+                result = __LINE__;
+            }
+        }
+        if ((result == 0) &&
+            ((Map_AddOrUpdate(destinationProperties, COMPRESSION_CONTENT_ENCODING_PROPERTY, COMPRESSION_CONTENT_ENCODING) != MAP_OK) ||
+            ((dictionaryId != NULL) && (Map_AddOrUpdate(destinationProperties, COMPRESSION_DICTIONARY_PROPERTY, dictionaryId) != MAP_OK))))
+        {
+            LogError("unable to mark the content encoding");
+            result = __LINE__;
+        }
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_HANDLE compression_compress_message(COMPRESSION_HANDLE compression, IOTHUB_MESSAGE_HANDLE message, const char* dictionaryId)
+{
+    IOTHUB_MESSAGE_HANDLE result;
+    /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_015: [ If compression or message is NULL, compression_compress_message shall fail and return NULL. ]*/
+    if ((compression == NULL) || (message == NULL))
+    {
+        LogError("invalid arguments COMPRESSION_HANDLE compression=%p, IOTHUB_MESSAGE_HANDLE message=%p", compression, message);
+        result = NULL;
+    }
+    else
+    {
+        IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message);
+        const unsigned char* content = NULL;
+        size_t contentSize = 0;
+
+        if (contentType == IOTHUBMESSAGE_BYTEARRAY)
+        {
+            if (IoTHubMessage_GetByteArray(message, &content, &contentSize) != IOTHUB_MESSAGE_OK)
+            {
+                contentType = IOTHUBMESSAGE_UNKNOWN;
+            }
+        }
+        else if (contentType == IOTHUBMESSAGE_STRING)
+        {
+            const char* text = IoTHubMessage_GetString(message);
+            if (text == NULL)
+            {
+                contentType = IOTHUBMESSAGE_UNKNOWN;
+            }
+            else
+            {
+                content = (const unsigned char*)text;
+                contentSize = strlen(text);
+            }
+        }
+
+        if ((contentType != IOTHUBMESSAGE_BYTEARRAY) && (contentType != IOTHUBMESSAGE_STRING))
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_017: [ If the content of the message cannot be read or compressing does not make it smaller, compression_compress_message shall return a clone of the message made with IoTHubMessage_Clone. ]*/
+            result = IoTHubMessage_Clone(message);
+        }
+        else
+        {
+            size_t compressedSize = compression_get_bound(contentSize);
+            unsigned char* compressed = (unsigned char*)malloc(compressedSize);
+            if (compressed == NULL)
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_018: [ If any other failure occurs, compression_compress_message shall fail and return NULL. ]*/
+                LogError("unable to malloc");
+                result = NULL;
+            }
+            else
+            {
+                if ((compression_compress(compression, content, contentSize, compressed, &compressedSize) != 0) ||
+                    (compressedSize >= contentSize))
+                {
+                    /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_017: [ If the content of the message cannot be read or compressing does not make it smaller, compression_compress_message shall return a clone of the message made with IoTHubMessage_Clone. ]*/
+                    result = IoTHubMessage_Clone(message);
+                }
+                /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_016: [ compression_compress_message shall create a message from the compressed content, copy the properties, the message id, the correlation id and the priority of message, and add the COMPRESSION_CONTENT_ENCODING_PROPERTY property and, if dictionaryId is not NULL, the COMPRESSION_DICTIONARY_PROPERTY property. ]*/
+                else if ((result = IoTHubMessage_CreateFromByteArray(compressed, compressedSize)) == NULL)
+                {
+                    /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_018: [ If any other failure occurs, compression_compress_message shall fail and return NULL. ]*/
+                    LogError("unable to IoTHubMessage_CreateFromByteArray");
+                }
+                else if (copyMessageFields(message, result, dictionaryId) != 0)
+                {
+                    /*Codes_SRS_IOTHUB_CLIENT_COMPRESSION_02_018: [ If any other failure occurs, compression_compress_message shall fail and return NULL. ]*/
+                    IoTHubMessage_Destroy(result);
+                    result = NULL;
+                }
+                free(compressed);
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,217 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "iothub_client_ingress_queue.h"
+
+/*
+ * The queue is a stack: producers push on the head with a compare-and-swap, the consumer swaps the head with NULL and
+ * reverses what it got, so the entries come out in the order they were pushed. Taking the whole stack at once is what
+ * keeps the compare-and-swap free of the ABA problem: no entry leaves the stack while a producer can still see it.
+ * Define INGRESS_QUEUE_USE_LOCK to use the lock even when the compiler has pointer atomics.
+ */
+#if !defined(INGRESS_QUEUE_USE_LOCK)
+#if defined(_MSC_VER)
+#include <windows.h>
+#define INGRESS_QUEUE_USE_INTERLOCKED
+#elif defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7))))
+#define INGRESS_QUEUE_USE_ATOMIC_BUILTINS
+#else
+#define INGRESS_QUEUE_USE_LOCK
+#endif
+#endif
+
+#ifdef INGRESS_QUEUE_USE_LOCK
+#include "azure_c_shared_utility/lock.h"
+#endif
+
+typedef struct INGRESS_QUEUE_INSTANCE_TAG
+{
+    INGRESS_QUEUE_ENTRY* volatile head; /*most recently pushed entry*/
+#ifdef INGRESS_QUEUE_USE_LOCK
+    LOCK_HANDLE lock;
+#endif
+} INGRESS_QUEUE_INSTANCE;
+
+#if defined(INGRESS_QUEUE_USE_INTERLOCKED)
+static INGRESS_QUEUE_ENTRY* loadHead(INGRESS_QUEUE_INSTANCE* queue)
+{
+    return (INGRESS_QUEUE_ENTRY*)InterlockedCompareExchangePointer((PVOID volatile*)&queue->head, NULL, NULL);
+}
+
+static bool tryReplaceHead(INGRESS_QUEUE_INSTANCE* queue, INGRESS_QUEUE_ENTRY* expected, INGRESS_QUEUE_ENTRY* desired)
+{
+    return InterlockedCompareExchangePointer((PVOID volatile*)&queue->head, desired, expected) == expected;
+}
+
+static INGRESS_QUEUE_ENTRY* takeHead(INGRESS_QUEUE_INSTANCE* queue)
+{
+    return (INGRESS_QUEUE_ENTRY*)InterlockedExchangePointer((PVOID volatile*)&queue->head, NULL);
+}
+#elif defined(INGRESS_QUEUE_USE_ATOMIC_BUILTINS)
+static INGRESS_QUEUE_ENTRY* loadHead(INGRESS_QUEUE_INSTANCE* queue)
+{
+    return __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+}
+
+static bool tryReplaceHead(INGRESS_QUEUE_INSTANCE* queue, INGRESS_QUEUE_ENTRY* expected, INGRESS_QUEUE_ENTRY* desired)
+{
+    /*release: the consumer that takes the head sees everything written to the entry before the push*/
+    return __atomic_compare_exchange_n(&queue->head, &expected, desired, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED) ? true : false;
+}
+
+static INGRESS_QUEUE_ENTRY* takeHead(INGRESS_QUEUE_INSTANCE* queue)
+{
+    return __atomic_exchange_n(&queue->head, NULL, __ATOMIC_ACQUIRE);
+}
+#else
+static INGRESS_QUEUE_ENTRY* loadHead(INGRESS_QUEUE_INSTANCE* queue)
+{
+    INGRESS_QUEUE_ENTRY* result;
+    (void)Lock(queue->lock);
+    result = queue->head;
+    (void)Unlock(queue->lock);
+    return result;
+}
+
+static bool tryReplaceHead(INGRESS_QUEUE_INSTANCE* queue, INGRESS_QUEUE_ENTRY* expected, INGRESS_QUEUE_ENTRY* desired)
+{
+    bool result;
+    (void)Lock(queue->lock);
+    if (queue->head == expected)
+    {
+        queue->head = desired;
+        result = true;
+    }
+    else
+    {
+        result = false;
+    }
+    (void)Unlock(queue->lock);
+    return result;
+}
+
+static INGRESS_QUEUE_ENTRY* takeHead(INGRESS_QUEUE_INSTANCE* queue)
+{
+    INGRESS_QUEUE_ENTRY* result;
+    (void)Lock(queue->lock);
+    result = queue->head;
+    queue->head = NULL;
+    (void)Unlock(queue->lock);
+    return result;
+}
+#endif
+
+INGRESS_QUEUE_HANDLE ingress_queue_create(void)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_001: [ ingress_queue_create shall allocate an empty queue and return a non-NULL handle to it. ]*/
+    INGRESS_QUEUE_INSTANCE* result = (INGRESS_QUEUE_INSTANCE*)malloc(sizeof(INGRESS_QUEUE_INSTANCE));
+    if (result == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_002: [ If any failure occurs, ingress_queue_create shall fail and return NULL. ]*/
+        LogError("unable to malloc");
+    }
+    else
+    {
+        result->head = NULL;
+#ifdef INGRESS_QUEUE_USE_LOCK
+        if ((result->lock = Lock_Init()) == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_002: [ If any failure occurs, ingress_queue_create shall fail and return NULL. ]*/
+            LogError("unable to Lock_Init");
+            free(result);
+            result = NULL;
+        }
+#endif
+    }
+    return result;
+}
+
+void ingress_queue_destroy(INGRESS_QUEUE_HANDLE queue)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_003: [ If queue is NULL, ingress_queue_destroy shall do nothing. ]*/
+    if (queue != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_004: [ ingress_queue_destroy shall free the queue and shall not touch the entries that are still in it. ]*/
+#ifdef INGRESS_QUEUE_USE_LOCK
+        Lock_Deinit(queue->lock);
+#endif
+        free(queue);
+    }
+}
+
+int ingress_queue_push(INGRESS_QUEUE_HANDLE queue, INGRESS_QUEUE_ENTRY* entry)
+{
+    int result;
+    /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_005: [ If queue or entry is NULL, ingress_queue_push shall fail and return a non-zero value. ]*/
+    if ((queue == NULL) || (entry == NULL))
+    {
+        LogError("invalid arguments INGRESS_QUEUE_HANDLE queue=%p, INGRESS_QUEUE_ENTRY* entry=%p", queue, entry);
+        result = __LINE__;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_006: [ ingress_queue_push shall link entry in front of the current head and make it the head with a compare-and-swap, retrying with the new head when another producer got there first, and return 0. ]*/
+        INGRESS_QUEUE_ENTRY* head = loadHead(queue);
+        do
+        {
+            entry->next = head;
+            if (tryReplaceHead(queue, head, entry))
+            {
+                break;
+            }
+            head = loadHead(queue);
+        } while (1);
+        result = 0;
+    }
+    return result;
+}
+
+size_t ingress_queue_drain(INGRESS_QUEUE_HANDLE queue, INGRESS_QUEUE_ENTRY_CALLBACK callback, void* context)
+{
+    size_t result;
+    /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_007: [ If queue or callback is NULL, ingress_queue_drain shall return 0. ]*/
+    if ((queue == NULL) || (callback == NULL))
+    {
+        LogError("invalid arguments INGRESS_QUEUE_HANDLE queue=%p, INGRESS_QUEUE_ENTRY_CALLBACK callback=%p", queue, callback);
+        result = 0;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_008: [ ingress_queue_drain shall take all the entries from the queue with one exchange of the head with NULL. ]*/
+        INGRESS_QUEUE_ENTRY* newest = takeHead(queue);
+        INGRESS_QUEUE_ENTRY* oldest = NULL;
+
+        /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_009: [ ingress_queue_drain shall call callback with every taken entry and context, in the order the entries were pushed, and return the number of entries. ]*/
+        while (newest != NULL)
+        {
+            INGRESS_QUEUE_ENTRY* next = newest->next;
+            newest->next = oldest;
+            oldest = newest;
+            newest = next;
+        }
+
+        result = 0;
+        while (oldest != NULL)
+        {
+            /*the callback can free the entry*/
+            INGRESS_QUEUE_ENTRY* next = oldest->next;
+            callback(oldest, context);
+            oldest = next;
+            result++;
+        }
+    }
+    return result;
+}
+
+bool ingress_queue_is_empty(INGRESS_QUEUE_HANDLE queue)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_010: [ ingress_queue_is_empty shall return true if queue is NULL or has no entry, false otherwise. ]*/
+    return (queue == NULL) || (loadHead(queue) == NULL);
+}
@@ -6,16 +6,22 @@
 #include <crtdbg.h>
 #endif
 #include <string.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/string_tokenizer.h"
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
 
 #include "iothub_client_ll.h"
 #include "iothub_client_private.h"
 #include "iothub_client_version.h"
 #include "iothub_transport_ll.h"
+#include "iothub_client_options.h"
+#include "iothub_client_persistent_queue.h"
+#include "iothub_client_compression.h"
+#include "iothub_client_trace.h"
 
 #ifndef DONT_USE_UPLOADTOBLOB
 #include "iothub_client_ll_uploadtoblob.h"
@@ -23,6 +29,9 @@
 
 #define LOG_ERROR_RESULT LogError("result = %s", ENUM_TO_STRING(IOTHUB_CLIENT_RESULT, result));
 #define INDEFINITE_TIME ((time_t)(-1))
+/*keep in sync with the transports, which create their retry control with the same default*/
+#define DEFAULT_RETRY_POLICY IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER
+#define DEFAULT_RETRY_TIMEOUT_IN_SECONDS 0
 
 DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
 DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_CONFIRMATION_RESULT, IOTHUB_CLIENT_CONFIRMATION_RESULT_VALUES);
@@ -44,9 +53,54 @@ typedef struct IOTHUB_CLIENT_LL_HANDLE_DATA_TAG
 #ifndef DONT_USE_UPLOADTOBLOB
     IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE uploadToBlobHandle;
 #endif
-
+    PERSISTENT_QUEUE_HANDLE persistentQueue; /*NULL unless OPTION_PERSISTENT_QUEUE was set*/
+    DLIST_ENTRY persistedNotLoaded; /*PERSISTED_MESSAGE_CONTEXTs of the messages of this run that are still only on disk*/
+    uint64_t nextPersistedToLoad; /*sequence number of the next record to move to waitingToSend*/
+    uint64_t firstPersistedOfThisRun; /*the records before it were left by a previous run and have no callback*/
+    size_t persistedMessagesInMemory;
+    size_t maxPersistedMessagesInMemory;
+    bool isOutboundQueueBounded; /*false until OPTION_OUTBOUND_QUEUE_LIMITS is set, events are only counted from then on*/
+    IOTHUB_CLIENT_QUEUE_LIMITS outboundQueueLimits;
+    size_t outboundMessageCount; /*events accepted and not confirmed yet, wherever they are (waitingToSend or the transport)*/
+    size_t outboundByteCount;
+    IOTHUB_CLIENT_PRIORITY_WEIGHTS priorityWeights;
+    uint64_t laneFairShareTag[3]; /*tag of the last event queued in each lane, indexed by IOTHUB_MESSAGE_PRIORITY*/
+    uint64_t lastFairShareTag; /*virtual time when waitingToSend is empty*/
+    COMPRESSION_HANDLE compression; /*NULL unless OPTION_COMPRESSION was set*/
+    char* compressionDictionaryId;
+    size_t compressionMinimumSize;
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_BATCH_CALLBACK confirmationBatchCallback; /*NULL unless IoTHubClient_LL_SetEventConfirmationBatchCallback was called*/
+    void* confirmationBatchUserContext;
+    IOTHUB_CLIENT_EVENT_CONFIRMATION* confirmationBatch; /*the confirmations gathered during the current call, kept from one batch to the next*/
+    size_t confirmationBatchCount;
+    size_t confirmationBatchCapacity;
+    IOTHUB_CLIENT_METRICS metrics; /*also given to the transport when it is not shared, see IoTHubClient_LL_GetMetrics*/
+    size_t eventsWaiting; /*events in waitingToSend, counted again after every call of the transport's _DoWork*/
+    size_t eventsOutstanding; /*events inserted in waitingToSend and not completed yet*/
 }IOTHUB_CLIENT_LL_HANDLE_DATA;
 
+/*context of the messages that go through the persistent queue, it wraps the user callback so that the record is acknowledged whichever way the transport completes the message*/
+typedef struct PERSISTED_MESSAGE_CONTEXT_TAG
+{
+    DLIST_ENTRY entry;
+    IOTHUB_CLIENT_LL_HANDLE_DATA* handleData;
+    uint64_t sequenceNumber;
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK callback;
+    void* context;
+    uint64_t ms_timesOutAfter;
+    uint64_t ms_queuedAt;
+}PERSISTED_MESSAGE_CONTEXT;
+
+/*an event sent while OPTION_OUTBOUND_QUEUE_LIMITS is set. The IOTHUB_MESSAGE_LIST comes first so that freeing the list entry, as the transports do, frees the whole allocation*/
+typedef struct BOUNDED_MESSAGE_TAG
+{
+    IOTHUB_MESSAGE_LIST messageList;
+    IOTHUB_CLIENT_LL_HANDLE_DATA* handleData;
+    size_t size;
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK callback;
+    void* context;
+}BOUNDED_MESSAGE;
+
 static const char HOSTNAME_TOKEN[] = "HostName";
 static const char DEVICEID_TOKEN[] = "DeviceId";
 static const char X509_TOKEN[] = "x509";
@@ -55,6 +109,16 @@ static const char DEVICEKEY_TOKEN[] = "SharedAccessKey";
 static const char DEVICESAS_TOKEN[] = "SharedAccessSignature";
 static const char PROTOCOL_GATEWAY_HOST[] = "GatewayHostName";
 
+/*one event of a lane advances that lane's tag by FAIR_SHARE_TAG_UNIT/weight, 720720 is divisible by every weight up to 16*/
+#define FAIR_SHARE_TAG_UNIT 720720
+#define DEFAULT_PRIORITY_WEIGHT_LOW 1
+#define DEFAULT_PRIORITY_WEIGHT_NORMAL 4
+#define DEFAULT_PRIORITY_WEIGHT_HIGH 16
+#define MAX_PRIORITY_WEIGHT 1000
+/*capacity of the first array of batched confirmations, it doubles when full*/
+#define INITIAL_CONFIRMATION_BATCH_CAPACITY 16
+#define MS_QUEUED_AT_UNKNOWN UINT64_MAX /*the tick counter could not be read, the confirmation latency of the event is not recorded*/
+
 IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateFromConnectionString(const char* connectionString, IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol)
 {
     IOTHUB_CLIENT_LL_HANDLE result = NULL;
@@ -293,6 +357,137 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateFromConnectionString(const char* c
     return result;
 }
 
+static void InitFairShare(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    handleData->priorityWeights.low = DEFAULT_PRIORITY_WEIGHT_LOW;
+    handleData->priorityWeights.normal = DEFAULT_PRIORITY_WEIGHT_NORMAL;
+    handleData->priorityWeights.high = DEFAULT_PRIORITY_WEIGHT_HIGH;
+    handleData->laneFairShareTag[IOTHUB_MESSAGE_PRIORITY_LOW] = 0;
+    handleData->laneFairShareTag[IOTHUB_MESSAGE_PRIORITY_NORMAL] = 0;
+    handleData->laneFairShareTag[IOTHUB_MESSAGE_PRIORITY_HIGH] = 0;
+    handleData->lastFairShareTag = 0;
+}
+
+static void InitMetrics(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    iothub_client_metrics_init(&(handleData->metrics));
+    handleData->eventsWaiting = 0;
+    handleData->eventsOutstanding = 0;
+}
+
+/*an event that leaves waitingToSend without going through the transport*/
+static void ForgetWaitingEvent(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    if (handleData->eventsWaiting > 0)
+    {
+        handleData->eventsWaiting--;
+    }
+    if (handleData->eventsOutstanding > 0)
+    {
+        handleData->eventsOutstanding--;
+    }
+}
+
+static void PublishQueueMetrics(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    iothub_client_metrics_set(&(handleData->metrics), IOTHUB_CLIENT_METRIC_EVENTS_QUEUED, handleData->eventsWaiting);
+    iothub_client_metrics_set(&(handleData->metrics), IOTHUB_CLIENT_METRIC_EVENTS_IN_FLIGHT, (handleData->eventsOutstanding > handleData->eventsWaiting) ? (handleData->eventsOutstanding - handleData->eventsWaiting) : 0);
+    iothub_client_metrics_set(&(handleData->metrics), IOTHUB_CLIENT_METRIC_OUTBOUND_QUEUE_BYTES, handleData->isOutboundQueueBounded ? handleData->outboundByteCount : 0);
+}
+
+static void OnBoundedMessageComplete(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback);
+static void OnPersistedMessageComplete(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback);
+
+/*gives the confirmations gathered so far to the batch callback, in one call*/
+static void FlushConfirmations(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    if (handleData->confirmationBatchCount > 0)
+    {
+        IOTHUB_CLIENT_EVENT_CONFIRMATION* confirmations = handleData->confirmationBatch;
+        size_t count = handleData->confirmationBatchCount;
+        size_t capacity = handleData->confirmationBatchCapacity;
+
+        /*the callback can send events, which can complete others: those start a batch of their own*/
+        handleData->confirmationBatch = NULL;
+        handleData->confirmationBatchCount = 0;
+        handleData->confirmationBatchCapacity = 0;
+        if (handleData->confirmationBatchCallback != NULL)
+        {
+            handleData->confirmationBatchCallback(confirmations, count, handleData->confirmationBatchUserContext);
+        }
+
+        if (handleData->confirmationBatch == NULL)
+        {
+            handleData->confirmationBatch = confirmations;
+            handleData->confirmationBatchCapacity = capacity;
+        }
+        else
+        {
+            free(confirmations);
+        }
+    }
+}
+
+/*completes one event: calls its callback, or keeps its confirmation for the batch callback when it was sent without one*/
+static void ConfirmEvent(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK callback, void* context, IOTHUB_CLIENT_CONFIRMATION_RESULT result)
+{
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_165: [ Every event confirmed to the application, whichever way, shall be counted once in IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_OK, _BECAUSE_DESTROY, _MESSAGE_TIMEOUT or _ERROR, according to its result. ]*/
+    if ((callback != OnBoundedMessageComplete) && (callback != OnPersistedMessageComplete)) /*those call ConfirmEvent again with the callback of the application*/
+    {
+        switch (result)
+        {
+        case IOTHUB_CLIENT_CONFIRMATION_OK:
+            iothub_client_metrics_add(&(handleData->metrics), IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_OK, 1);
+            break;
+        case IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY:
+            iothub_client_metrics_add(&(handleData->metrics), IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_BECAUSE_DESTROY, 1);
+            break;
+        case IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT:
+            iothub_client_metrics_add(&(handleData->metrics), IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_MESSAGE_TIMEOUT, 1);
+            break;
+        default:
+            iothub_client_metrics_add(&(handleData->metrics), IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_ERROR, 1);
+            break;
+        }
+    }
+
+    if (callback != NULL)
+    {
+        callback(result, context);
+    }
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_159: [ When an event sent without eventConfirmationCallback and with a non-NULL userContextCallback is completed, whichever way, and a batch callback is set, its userContextCallback and result shall be added to the batch of the current call instead. ]*/
+    else if ((context != NULL) && (handleData->confirmationBatchCallback != NULL))
+    {
+        if (handleData->confirmationBatchCount == handleData->confirmationBatchCapacity)
+        {
+            size_t newCapacity = (handleData->confirmationBatchCapacity == 0) ? INITIAL_CONFIRMATION_BATCH_CAPACITY : (handleData->confirmationBatchCapacity * 2);
+            IOTHUB_CLIENT_EVENT_CONFIRMATION* newBatch = (IOTHUB_CLIENT_EVENT_CONFIRMATION*)realloc(handleData->confirmationBatch, newCapacity * sizeof(IOTHUB_CLIENT_EVENT_CONFIRMATION));
+            if (newBatch != NULL)
+            {
+                handleData->confirmationBatch = newBatch;
+                handleData->confirmationBatchCapacity = newCapacity;
+            }
+        }
+
+        if (handleData->confirmationBatchCount < handleData->confirmationBatchCapacity)
+        {
+            handleData->confirmationBatch[handleData->confirmationBatchCount].userContextCallback = context;
+            handleData->confirmationBatch[handleData->confirmationBatchCount].result = result;
+            handleData->confirmationBatchCount++;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_161: [ If the batch cannot grow, the batch so far and then the confirmation of the event alone shall be given to the batch callback. ]*/
+            IOTHUB_CLIENT_EVENT_CONFIRMATION single;
+            LogError("unable to realloc, the confirmation is not batched");
+            FlushConfirmations(handleData);
+            single.userContextCallback = context;
+            single.result = result;
+            handleData->confirmationBatchCallback(&single, 1, handleData->confirmationBatchUserContext);
+        }
+    }
+}
+
 static void setTransportProtocol(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, TRANSPORT_PROVIDER* protocol)
 {
     handleData->IoTHubTransport_GetHostname = protocol->IoTHubTransport_GetHostname;
@@ -305,6 +500,7 @@ static void setTransportProtocol(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, TRANS
     handleData->IoTHubTransport_Unsubscribe = protocol->IoTHubTransport_Unsubscribe;
     handleData->IoTHubTransport_DoWork = protocol->IoTHubTransport_DoWork;
     handleData->IoTHubTransport_GetSendStatus = protocol->IoTHubTransport_GetSendStatus;
+    handleData->IoTHubTransport_SetRetryPolicy = protocol->IoTHubTransport_SetRetryPolicy;
 
 }
 
@@ -361,13 +557,20 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_Create(const IOTHUB_CLIENT_CONFIG* confi
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_004: [Otherwise IoTHubClient_LL_Create shall initialize a new DLIST (further called "waitingToSend") containing records with fields of the following types: IOTHUB_MESSAGE_HANDLE, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, void*.]*/
                     IOTHUBTRANSPORT_CONFIG lowerLayerConfig;
                     DList_InitializeListHead(&(handleData->waitingToSend));
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_162: [ IoTHubClient_LL_Create and IoTHubClient_LL_CreateWithTransport shall start all the metrics of the client at 0. ]*/
+                    InitMetrics(handleData);
                     setTransportProtocol(handleData, (TRANSPORT_PROVIDER*)config->protocol());
                     handleData->messageCallback = NULL;
                     handleData->messageUserContextCallback = NULL;
                     handleData->lastMessageReceiveTime = INDEFINITE_TIME;
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_114: [ By default the retry policy shall be IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER with no timeout limit (retryTimeoutinSeconds 0). ]*/
+                    handleData->retryPolicy = DEFAULT_RETRY_POLICY;
+                    handleData->retryTimeoutinSeconds = DEFAULT_RETRY_TIMEOUT_IN_SECONDS;
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_006: [IoTHubClient_LL_Create shall populate a structure of type IOTHUBTRANSPORT_CONFIG with the information from config parameter and the previous DLIST and shall pass that to the underlying layer _Create function.]*/
                     lowerLayerConfig.upperConfig = config;
                     lowerLayerConfig.waitingToSend = &(handleData->waitingToSend);
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_163: [ IoTHubClient_LL_Create shall give the metrics of the client to the transport in the metrics field of IOTHUBTRANSPORT_CONFIG. ]*/
+                    lowerLayerConfig.metrics = &(handleData->metrics);
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_007: [If the underlaying layer _Create function fails them IoTHubClient_LL_Create shall fail and return NULL.] */
                     if ((handleData->transportHandle = handleData->IoTHubTransport_Create(&lowerLayerConfig)) == NULL)
                     {
@@ -406,6 +609,22 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_Create(const IOTHUB_CLIENT_CONFIG* confi
                             handleData->isSharedTransport = false;
                             /*Codes_SRS_IOTHUBCLIENT_LL_02_042: [ By default, messages shall not timeout. ]*/
                             handleData->currentMessageTimeout = 0;
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_117: [ By default, messages shall not be persisted. ]*/
+                            handleData->persistentQueue = NULL;
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_132: [ By default, the outbound queue shall not be bounded. ]*/
+                            handleData->isOutboundQueueBounded = false;
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_144: [ By default, the priority weights shall be 1 for IOTHUB_MESSAGE_PRIORITY_LOW, 4 for IOTHUB_MESSAGE_PRIORITY_NORMAL and 16 for IOTHUB_MESSAGE_PRIORITY_HIGH. ]*/
+                            InitFairShare(handleData);
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_149: [ By default, the events shall not be compressed. ]*/
+                            handleData->compression = NULL;
+                            handleData->compressionDictionaryId = NULL;
+                            handleData->compressionMinimumSize = 0;
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_155: [ By default, there shall be no batch confirmation callback. ]*/
+                            handleData->confirmationBatchCallback = NULL;
+                            handleData->confirmationBatchUserContext = NULL;
+                            handleData->confirmationBatch = NULL;
+                            handleData->confirmationBatchCount = 0;
+                            handleData->confirmationBatchCapacity = 0;
                             result = handleData;
                         }
                     }
@@ -512,10 +731,15 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateWithTransport(const IOTHUB_CLIENT_
                         {
                             /*Codes_SRS_IOTHUBCLIENT_LL_17_004: [IoTHubClient_LL_CreateWithTransport shall initialize a new DLIST (further called "waitingToSend") containing records with fields of the following types: IOTHUB_MESSAGE_HANDLE, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, void*.]*/
                             DList_InitializeListHead(&(handleData->waitingToSend));
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_162: [ IoTHubClient_LL_Create and IoTHubClient_LL_CreateWithTransport shall start all the metrics of the client at 0. ]*/
+                            InitMetrics(handleData);
                             
                             handleData->messageCallback = NULL;
                             handleData->messageUserContextCallback = NULL;
                             handleData->lastMessageReceiveTime = INDEFINITE_TIME;
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_114: [ By default the retry policy shall be IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER with no timeout limit (retryTimeoutinSeconds 0). ]*/
+                            handleData->retryPolicy = DEFAULT_RETRY_POLICY;
+                            handleData->retryTimeoutinSeconds = DEFAULT_RETRY_TIMEOUT_IN_SECONDS;
                             
 
                             IOTHUB_DEVICE_CONFIG deviceConfig;
@@ -542,6 +766,22 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateWithTransport(const IOTHUB_CLIENT_
                                 handleData->isSharedTransport = true;
                                 /*Codes_SRS_IOTHUBCLIENT_LL_02_042: [ By default, messages shall not timeout. ]*/
                                 handleData->currentMessageTimeout = 0;
+                                /*Codes_SRS_IOTHUBCLIENT_LL_02_117: [ By default, messages shall not be persisted. ]*/
+                                handleData->persistentQueue = NULL;
+                                /*Codes_SRS_IOTHUBCLIENT_LL_02_132: [ By default, the outbound queue shall not be bounded. ]*/
+                                handleData->isOutboundQueueBounded = false;
+                                /*Codes_SRS_IOTHUBCLIENT_LL_02_144: [ By default, the priority weights shall be 1 for IOTHUB_MESSAGE_PRIORITY_LOW, 4 for IOTHUB_MESSAGE_PRIORITY_NORMAL and 16 for IOTHUB_MESSAGE_PRIORITY_HIGH. ]*/
+                                InitFairShare(handleData);
+                                /*Codes_SRS_IOTHUBCLIENT_LL_02_149: [ By default, the events shall not be compressed. ]*/
+                                handleData->compression = NULL;
+                                handleData->compressionDictionaryId = NULL;
+                                handleData->compressionMinimumSize = 0;
+                                /*Codes_SRS_IOTHUBCLIENT_LL_02_155: [ By default, there shall be no batch confirmation callback. ]*/
+                                handleData->confirmationBatchCallback = NULL;
+                                handleData->confirmationBatchUserContext = NULL;
+                                handleData->confirmationBatch = NULL;
+                                handleData->confirmationBatchCount = 0;
+                                handleData->confirmationBatchCapacity = 0;
                                 result = handleData;
                             }
                         }
@@ -576,13 +816,32 @@ void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
         {
             IOTHUB_MESSAGE_LIST* temp = containingRecord(unsend, IOTHUB_MESSAGE_LIST, entry);
             /*Codes_SRS_IOTHUBCLIENT_LL_02_033: [Otherwise, IoTHubClient_LL_Destroy shall complete all the event message callbacks that are in the waitingToSend list with the result IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY.] */
-            if (temp->callback != NULL)
-            {
-                temp->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, temp->context);
-            }
+            ConfirmEvent(handleData, temp->callback, temp->context, IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY);
             IoTHubMessage_Destroy(temp->messageHandle);
             free(temp);
         }
+        if (handleData->persistentQueue != NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_128: [ IoTHubClient_LL_Destroy shall complete the persisted messages not yet handed to the transport with IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY and close the persistent queue, leaving the messages that were not acknowledged on disk. ]*/
+            while ((unsend = DList_RemoveHeadList(&(handleData->persistedNotLoaded))) != &(handleData->persistedNotLoaded))
+            {
+                PERSISTED_MESSAGE_CONTEXT* persisted = containingRecord(unsend, PERSISTED_MESSAGE_CONTEXT, entry);
+                ConfirmEvent(handleData, persisted->callback, persisted->context, IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY);
+                free(persisted);
+            }
+            persistent_queue_destroy(handleData->persistentQueue);
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_160: [ At the end of IoTHubClient_LL_SendComplete, IoTHubClient_LL_DoWork, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_Destroy, the confirmations added to the batch (if any) shall be given to the batch callback in one call, oldest first. ]*/
+        FlushConfirmations(handleData);
+        if (handleData->confirmationBatch != NULL)
+        {
+            free(handleData->confirmationBatch);
+        }
+        if (handleData->compression != NULL)
+        {
+            compression_destroy(handleData->compression);
+            free(handleData->compressionDictionaryId);
+        }
         /*Codes_SRS_IOTHUBCLIENT_LL_17_011: [IoTHubClient_LL_Destroy  shall free the resources allocated by IoTHubClient (if any).] */
         tickcounter_destroy(handleData->tickCounter);
 #ifndef DONT_USE_UPLOADTOBLOB
@@ -594,29 +853,331 @@ void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 
 /*Codes_SRS_IOTHUBCLIENT_LL_02_044: [ Messages already delivered to IoTHubClient_LL shall not have their timeouts modified by a new call to IoTHubClient_LL_SetOption. ]*/
 /*returns 0 on success, any other value is error*/
-static int attach_ms_timesOutAfter(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST *newEntry)
+/*reads the tick counter once per event, for both its timeout and its confirmation latency*/
+static int attach_ms_timestamps(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, uint64_t* ms_timesOutAfter, uint64_t* ms_queuedAt)
 {
     int result;
-    /*Codes_SRS_IOTHUBCLIENT_LL_02_043: [ Calling IoTHubClient_LL_SetOption with value set to "0" shall disable the timeout mechanism for all new messages. ]*/
-    if (handleData->currentMessageTimeout == 0)
+    uint64_t nowTick;
+    if (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) != 0)
     {
-        newEntry->ms_timesOutAfter = 0; /*do not timeout*/
-        result = 0;
+        *ms_queuedAt = MS_QUEUED_AT_UNKNOWN;
+        if (handleData->currentMessageTimeout == 0)
+        {
+            LogError("unable to get the current relative tickcount, the confirmation latency of the event is not recorded");
+            *ms_timesOutAfter = 0;
+            result = 0;
+        }
+        else
+        {
+            result = __LINE__;
+            LogError("unable to get the current relative tickcount");
+        }
     }
     else
     {
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_043: [ Calling IoTHubClient_LL_SetOption with value set to "0" shall disable the timeout mechanism for all new messages. ]*/
         /*Codes_SRS_IOTHUBCLIENT_LL_02_039: [ "messageTimeout" - once IoTHubClient_LL_SendEventAsync is called the message shall timeout after value miliseconds. Value is a pointer to a uint64. ]*/
-        if (tickcounter_get_current_ms(handleData->tickCounter, &newEntry->ms_timesOutAfter) != 0)
+        *ms_timesOutAfter = (handleData->currentMessageTimeout == 0) ? 0 : nowTick + handleData->currentMessageTimeout;
+        *ms_queuedAt = nowTick;
+        result = 0;
+    }
+    return result;
+}
+
+/*completes the persisted messages of this run that the queue dropped to make room (PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST)*/
+static void CompleteDroppedPersistedMessages(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    uint64_t firstSequenceNumber;
+    uint64_t nextSequenceNumber;
+    if (persistent_queue_get_range(handleData->persistentQueue, &firstSequenceNumber, &nextSequenceNumber) != 0)
+    {
+        LogError("unable to persistent_queue_get_range");
+    }
+    else
+    {
+        if (handleData->nextPersistedToLoad < firstSequenceNumber)
         {
-            result = __LINE__;
-            LogError("unable to get the current relative tickcount");
+            handleData->nextPersistedToLoad = firstSequenceNumber;
         }
-        else
+
+        while (handleData->persistedNotLoaded.Flink != &(handleData->persistedNotLoaded))
+        {
+            PERSISTED_MESSAGE_CONTEXT* persisted = containingRecord(handleData->persistedNotLoaded.Flink, PERSISTED_MESSAGE_CONTEXT, entry);
+            if (persisted->sequenceNumber >= firstSequenceNumber)
+            {
+                break;
+            }
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_124: [ The messages dropped by the persistent queue to make room shall be completed with IOTHUB_CLIENT_CONFIRMATION_ERROR. ]*/
+            (void)DList_RemoveEntryList(&(persisted->entry));
+            ConfirmEvent(handleData, persisted->callback, persisted->context, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+            free(persisted);
+        }
+    }
+}
+
+static size_t GetMessageContentSize(IOTHUB_MESSAGE_HANDLE message)
+{
+    size_t result;
+    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message);
+    if (contentType == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        const unsigned char* buffer;
+        if (IoTHubMessage_GetByteArray(message, &buffer, &result) != IOTHUB_MESSAGE_OK)
         {
-            newEntry->ms_timesOutAfter += handleData->currentMessageTimeout;
             result = 0;
         }
     }
+    else if (contentType == IOTHUBMESSAGE_STRING)
+    {
+        const char* content = IoTHubMessage_GetString(message);
+        result = (content == NULL) ? 0 : strlen(content);
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+/*the copy of the event that is handed to the transport*/
+static IOTHUB_MESSAGE_HANDLE CloneEventMessage(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE eventMessageHandle)
+{
+    IOTHUB_MESSAGE_HANDLE result;
+    if ((handleData->compression != NULL) && (GetMessageContentSize(eventMessageHandle) >= handleData->compressionMinimumSize))
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_153: [ If compression is set and the content of the event is at least minimumSize bytes, IoTHubClient_LL_SendEventAsync shall hand to the transport, or to the persistent queue, the copy made by compression_compress_message instead of a clone. ]*/
+        result = compression_compress_message(handleData->compression, eventMessageHandle, handleData->compressionDictionaryId);
+    }
+    else
+    {
+        result = IoTHubMessage_Clone(eventMessageHandle);
+    }
+    return result;
+}
+
+static IOTHUB_CLIENT_RESULT PersistEvent(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+    PERSISTED_MESSAGE_CONTEXT* persisted = (PERSISTED_MESSAGE_CONTEXT*)malloc(sizeof(PERSISTED_MESSAGE_CONTEXT));
+    if (persisted == NULL)
+    {
+        result = IOTHUB_CLIENT_ERROR;
+        LOG_ERROR_RESULT;
+    }
+    else if (attach_ms_timestamps(handleData, &(persisted->ms_timesOutAfter), &(persisted->ms_queuedAt)) != 0)
+    {
+        result = IOTHUB_CLIENT_ERROR;
+        LOG_ERROR_RESULT;
+        free(persisted);
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_154: [ If compression is set, IoTHubClient_LL_SendEventAsync shall append to the persistent queue the compressed copy of the event and destroy the copy afterwards. ]*/
+        IOTHUB_MESSAGE_HANDLE compressed = (handleData->compression != NULL) ? CloneEventMessage(handleData, eventMessageHandle) : NULL;
+        PERSISTENT_QUEUE_RESULT appendResult;
+        if ((handleData->compression != NULL) && (compressed == NULL))
+        {
+            appendResult = PERSISTENT_QUEUE_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_121: [ If a persistent queue is set, IoTHubClient_LL_SendEventAsync shall append the message to it with persistent_queue_append_message instead of cloning it. ]*/
+            appendResult = persistent_queue_append_message(handleData->persistentQueue, (compressed != NULL) ? compressed : eventMessageHandle, &(persisted->sequenceNumber));
+            if (compressed != NULL)
+            {
+                IoTHubMessage_Destroy(compressed);
+            }
+        }
+
+        if (appendResult == PERSISTENT_QUEUE_FULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_122: [ If persistent_queue_append_message returns PERSISTENT_QUEUE_FULL, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_QUEUE_FULL. ]*/
+            result = IOTHUB_CLIENT_QUEUE_FULL;
+            LOG_ERROR_RESULT;
+            free(persisted);
+        }
+        else if (appendResult != PERSISTENT_QUEUE_OK)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_123: [ If persistent_queue_append_message fails, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+            result = IOTHUB_CLIENT_ERROR;
+            LOG_ERROR_RESULT;
+            free(persisted);
+        }
+        else
+        {
+            persisted->handleData = handleData;
+            persisted->callback = eventConfirmationCallback;
+            persisted->context = userContextCallback;
+            DList_InsertTailList(&(handleData->persistedNotLoaded), &(persisted->entry));
+            CompleteDroppedPersistedMessages(handleData);
+            result = IOTHUB_CLIENT_OK;
+        }
+    }
+    return result;
+}
+
+static size_t GetPriorityWeight(const IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_PRIORITY priority)
+{
+    return (priority == IOTHUB_MESSAGE_PRIORITY_LOW) ? handleData->priorityWeights.low :
+        (priority == IOTHUB_MESSAGE_PRIORITY_HIGH) ? handleData->priorityWeights.high :
+        handleData->priorityWeights.normal;
+}
+
+/*waitingToSend is kept sorted by a start-time fair queueing tag: every lane advances its own tag by FAIR_SHARE_TAG_UNIT/weight per event,
+starting from the tag of the event the transport will take next. The transports take events from the head, so all of them drain the lanes
+in proportion to their weights without knowing about lanes. The insertion walks back only over the events with a greater tag, none when a single
+priority is used, and the list never needs sorting again since tags do not change and the transports give events back at the head*/
+static void InsertInFairShareOrder(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* newEntry)
+{
+    IOTHUB_MESSAGE_PRIORITY priority = IoTHubMessage_GetPriority(newEntry->messageHandle);
+    uint64_t virtualTime;
+    DLIST_ENTRY* previous;
+
+    if ((priority != IOTHUB_MESSAGE_PRIORITY_LOW) && (priority != IOTHUB_MESSAGE_PRIORITY_HIGH))
+    {
+        priority = IOTHUB_MESSAGE_PRIORITY_NORMAL;
+    }
+
+    virtualTime = (handleData->waitingToSend.Flink != &(handleData->waitingToSend)) ?
+        containingRecord(handleData->waitingToSend.Flink, IOTHUB_MESSAGE_LIST, entry)->fairShareTag :
+        handleData->lastFairShareTag;
+    if (handleData->laneFairShareTag[priority] < virtualTime)
+    {
+        handleData->laneFairShareTag[priority] = virtualTime;
+    }
+    handleData->laneFairShareTag[priority] += FAIR_SHARE_TAG_UNIT / GetPriorityWeight(handleData, priority);
+    if (handleData->lastFairShareTag < handleData->laneFairShareTag[priority])
+    {
+        handleData->lastFairShareTag = handleData->laneFairShareTag[priority];
+    }
+
+    newEntry->priority = priority;
+    newEntry->fairShareTag = handleData->laneFairShareTag[priority];
+
+    /*events with the same tag keep the order in which they were sent*/
+    previous = handleData->waitingToSend.Blink;
+    while ((previous != &(handleData->waitingToSend)) && (containingRecord(previous, IOTHUB_MESSAGE_LIST, entry)->fairShareTag > newEntry->fairShareTag))
+    {
+        previous = previous->Blink;
+    }
+    DList_InsertTailList(previous->Flink, &(newEntry->entry));
+    IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE, newEntry->messageHandle);
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_164: [ Every event inserted in waitingToSend shall be counted in IOTHUB_CLIENT_METRIC_EVENTS_QUEUED right away. ]*/
+    handleData->eventsWaiting++;
+    handleData->eventsOutstanding++;
+    PublishQueueMetrics(handleData);
+}
+
+static bool FitsInOutboundQueue(const IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, size_t size)
+{
+    return
+        ((handleData->outboundQueueLimits.maxMessages == 0) || (handleData->outboundMessageCount < handleData->outboundQueueLimits.maxMessages)) &&
+        ((handleData->outboundQueueLimits.maxBytes == 0) || (handleData->outboundByteCount + size <= handleData->outboundQueueLimits.maxBytes));
+}
+
+/*installed as the callback of every event counted in the outbound queue, whichever way it is completed*/
+static void OnBoundedMessageComplete(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    BOUNDED_MESSAGE* bounded = (BOUNDED_MESSAGE*)userContextCallback;
+    IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = bounded->handleData;
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_138: [ When an event counted in the outbound queue is completed, whichever way, it shall stop being counted before the user callback is called. ]*/
+    handleData->outboundMessageCount--;
+    handleData->outboundByteCount -= bounded->size;
+    ConfirmEvent(handleData, bounded->callback, bounded->context, result);
+}
+
+/*drops the oldest counted events the transport has not taken yet until size fits, lowest lane first, returns 0 if it fits*/
+static int MakeRoomInOutboundQueue(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, size_t size)
+{
+    static const IOTHUB_MESSAGE_PRIORITY lanes[] = { IOTHUB_MESSAGE_PRIORITY_LOW, IOTHUB_MESSAGE_PRIORITY_NORMAL, IOTHUB_MESSAGE_PRIORITY_HIGH };
+    size_t i;
+    for (i = 0; (i < sizeof(lanes) / sizeof(lanes[0])) && !FitsInOutboundQueue(handleData, size); i++)
+    {
+        DLIST_ENTRY* current = handleData->waitingToSend.Flink;
+        while (!FitsInOutboundQueue(handleData, size) && (current != &(handleData->waitingToSend)))
+        {
+            IOTHUB_MESSAGE_LIST* oldest = containingRecord(current, IOTHUB_MESSAGE_LIST, entry);
+            PDLIST_ENTRY theNext = current->Flink;
+            if ((oldest->callback == OnBoundedMessageComplete) && (oldest->priority == lanes[i]))
+            {
+                (void)DList_RemoveEntryList(current);
+                ForgetWaitingEvent(handleData);
+                oldest->callback(IOTHUB_CLIENT_CONFIRMATION_ERROR, oldest->context);
+                IoTHubMessage_Destroy(oldest->messageHandle);
+                free(oldest);
+            }
+            current = theNext;
+        }
+    }
+    return FitsInOutboundQueue(handleData, size) ? 0 : __LINE__;
+}
+
+static IOTHUB_CLIENT_RESULT SendBoundedEvent(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+    size_t size = GetMessageContentSize(eventMessageHandle);
+
+    if ((handleData->outboundQueueLimits.maxBytes != 0) && (size > handleData->outboundQueueLimits.maxBytes))
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_134: [ If the content of the event alone is bigger than maxBytes, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_QUEUE_FULL. ]*/
+        LogError("an event of %lu bytes can never fit in an outbound queue of %lu bytes", (unsigned long)size, (unsigned long)handleData->outboundQueueLimits.maxBytes);
+        result = IOTHUB_CLIENT_QUEUE_FULL;
+    }
+    else if (!FitsInOutboundQueue(handleData, size) && (handleData->outboundQueueLimits.overflowPolicy != IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST))
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_135: [ If the event does not fit under maxMessages and maxBytes and the policy is IOTHUB_CLIENT_QUEUE_OVERFLOW_REJECT or IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_QUEUE_FULL. ]*/
+        result = IOTHUB_CLIENT_QUEUE_FULL;
+    }
+    else
+    {
+        BOUNDED_MESSAGE* newEntry = (BOUNDED_MESSAGE*)malloc(sizeof(BOUNDED_MESSAGE));
+        if (newEntry == NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_014: [If cloning and/or adding the information fails for any reason, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR.] */
+            result = IOTHUB_CLIENT_ERROR;
+            LOG_ERROR_RESULT;
+        }
+        else if (attach_ms_timestamps(handleData, &(newEntry->messageList.ms_timesOutAfter), &(newEntry->messageList.ms_queuedAt)) != 0)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LOG_ERROR_RESULT;
+            free(newEntry);
+        }
+        else if ((newEntry->messageList.messageHandle = CloneEventMessage(handleData, eventMessageHandle)) == NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_014: [If cloning and/or adding the information fails for any reason, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR.] */
+            result = IOTHUB_CLIENT_ERROR;
+            LOG_ERROR_RESULT;
+            free(newEntry);
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_136: [ If the event does not fit and the policy is IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST, IoTHubClient_LL_SendEventAsync shall complete the counted events still in waitingToSend with IOTHUB_CLIENT_CONFIRMATION_ERROR until the event fits, the events of the lowest priority first and the oldest first within a priority. ]*/
+        else if (MakeRoomInOutboundQueue(handleData, size) != 0)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_137: [ If the event still does not fit because the transport holds the other events, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_QUEUE_FULL. ]*/
+            LogError("the events in the outbound queue are all in flight, none can be dropped");
+            IoTHubMessage_Destroy(newEntry->messageList.messageHandle);
+            free(newEntry);
+            result = IOTHUB_CLIENT_QUEUE_FULL;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_133: [ If the outbound queue is bounded, IoTHubClient_LL_SendEventAsync shall count the event and the size of its content, and complete it through a callback that stops counting it before calling eventConfirmationCallback. ]*/
+            newEntry->handleData = handleData;
+            newEntry->size = size;
+            newEntry->callback = eventConfirmationCallback;
+            newEntry->context = userContextCallback;
+            newEntry->messageList.callback = OnBoundedMessageComplete;
+            newEntry->messageList.context = newEntry;
+            handleData->outboundMessageCount++;
+            handleData->outboundByteCount += size;
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_145: [ IoTHubClient_LL_SendEventAsync shall insert the event in waitingToSend in weighted fair order: each priority advances its own tag by the inverse of its weight per event, starting no earlier than the tag of the first event in waitingToSend, and the event is inserted after all events with a tag not greater than its own. ]*/
+            InsertInFairShareOrder(handleData, &(newEntry->messageList));
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_015: [Otherwise IoTHubClient_LL_SendEventAsync shall succeed and return IOTHUB_CLIENT_OK.] */
+            result = IOTHUB_CLIENT_OK;
+        }
+    }
     return result;
 }
 
@@ -628,12 +1189,27 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
         (iotHubClientHandle == NULL) ||
         (eventMessageHandle == NULL) ||
         /*Codes_SRS_IOTHUBCLIENT_LL_02_012: [IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter eventConfirmationCallback is NULL and userContextCallback is not NULL.] */
-        ((eventConfirmationCallback == NULL) && (userContextCallback != NULL))
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_158: [ If a batch callback is set, IoTHubClient_LL_SendEventAsync shall accept a NULL eventConfirmationCallback with a non-NULL userContextCallback. ]*/
+        ((eventConfirmationCallback == NULL) && (userContextCallback != NULL) && (iotHubClientHandle->confirmationBatchCallback == NULL))
         )
     {
         result = IOTHUB_CLIENT_INVALID_ARG;
         LOG_ERROR_RESULT;
     }
+    else if (iotHubClientHandle->persistentQueue != NULL)
+    {
+        result = PersistEvent(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+        /*the persistent queue can drop old messages to make room*/
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_160: [ At the end of IoTHubClient_LL_SendComplete, IoTHubClient_LL_DoWork, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_Destroy, the confirmations added to the batch (if any) shall be given to the batch callback in one call, oldest first. ]*/
+        FlushConfirmations(iotHubClientHandle);
+    }
+    else if (iotHubClientHandle->isOutboundQueueBounded)
+    {
+        result = SendBoundedEvent(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+        /*IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST completes old events to make room*/
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_160: [ At the end of IoTHubClient_LL_SendComplete, IoTHubClient_LL_DoWork, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_Destroy, the confirmations added to the batch (if any) shall be given to the batch callback in one call, oldest first. ]*/
+        FlushConfirmations(iotHubClientHandle);
+    }
     else
     {
         IOTHUB_MESSAGE_LIST *newEntry = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
@@ -646,7 +1222,7 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
         {
             IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
 
-            if (attach_ms_timesOutAfter(handleData, newEntry) != 0)
+            if (attach_ms_timestamps(handleData, &(newEntry->ms_timesOutAfter), &(newEntry->ms_queuedAt)) != 0)
             {
                 result = IOTHUB_CLIENT_ERROR;
                 LOG_ERROR_RESULT;
@@ -655,7 +1231,7 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
             else
             {
                 /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
-                if ((newEntry->messageHandle = IoTHubMessage_Clone(eventMessageHandle)) == NULL)
+                if ((newEntry->messageHandle = CloneEventMessage(handleData, eventMessageHandle)) == NULL)
                 {
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_014: [If cloning and/or adding the information fails for any reason, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR.] */
                     result = IOTHUB_CLIENT_ERROR;
@@ -667,7 +1243,8 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
                     newEntry->callback = eventConfirmationCallback;
                     newEntry->context = userContextCallback;
-                    DList_InsertTailList(&(iotHubClientHandle->waitingToSend), &(newEntry->entry));
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_145: [ IoTHubClient_LL_SendEventAsync shall insert the event in waitingToSend in weighted fair order: each priority advances its own tag by the inverse of its weight per event, starting no earlier than the tag of the first event in waitingToSend, and the event is inserted after all events with a tag not greater than its own. ]*/
+                    InsertInFairShareOrder(handleData, newEntry);
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_015: [Otherwise IoTHubClient_LL_SendEventAsync shall succeed and return IOTHUB_CLIENT_OK.] */
                     result = IOTHUB_CLIENT_OK;
                 }
@@ -737,10 +1314,9 @@ static void DoTimeouts(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
             {
                 PDLIST_ENTRY theNext = currentItemInWaitingToSend->Flink; /*need to save the next item, because the below operations are destructive*/
                 DList_RemoveEntryList(currentItemInWaitingToSend);
-                if (fullEntry->callback != NULL)
-                {
-                    fullEntry->callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->context);
-                }
+                ForgetWaitingEvent(handleData);
+                IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_CALLBACK, fullEntry->messageHandle);
+                ConfirmEvent(handleData, fullEntry->callback, fullEntry->context, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT);
                 IoTHubMessage_Destroy(fullEntry->messageHandle); /*because it has been cloned*/
                 free(fullEntry);
                 currentItemInWaitingToSend = theNext;
@@ -750,6 +1326,146 @@ static void DoTimeouts(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
                 currentItemInWaitingToSend = currentItemInWaitingToSend->Flink;
             }
         }
+
+        if (handleData->persistentQueue != NULL)
+        {
+            DLIST_ENTRY* currentPersisted = handleData->persistedNotLoaded.Flink;
+            while (currentPersisted != &(handleData->persistedNotLoaded))
+            {
+                PERSISTED_MESSAGE_CONTEXT* persisted = containingRecord(currentPersisted, PERSISTED_MESSAGE_CONTEXT, entry);
+                PDLIST_ENTRY theNext = currentPersisted->Flink;
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_125: [ Persisted messages not yet handed to the transport shall time out like the others, and their record shall be acknowledged. ]*/
+                if ((persisted->ms_timesOutAfter != 0) && (persisted->ms_timesOutAfter < nowTick))
+                {
+                    (void)DList_RemoveEntryList(currentPersisted);
+                    ConfirmEvent(handleData, persisted->callback, persisted->context, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT);
+                    (void)persistent_queue_ack(handleData->persistentQueue, persisted->sequenceNumber);
+                    free(persisted);
+                }
+                currentPersisted = theNext;
+            }
+        }
+    }
+}
+
+/*installed as the callback of every persisted message in waitingToSend, whichever transport completes it*/
+static void OnPersistedMessageComplete(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    PERSISTED_MESSAGE_CONTEXT* persisted = (PERSISTED_MESSAGE_CONTEXT*)userContextCallback;
+    IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = persisted->handleData;
+
+    handleData->persistedMessagesInMemory--;
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_127: [ When a persisted message is completed with any result but IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY its record shall be acknowledged with persistent_queue_ack before the user callback is called. ]*/
+    if (result != IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY)
+    {
+        if (persistent_queue_ack(handleData->persistentQueue, persisted->sequenceNumber) != 0)
+        {
+            LogError("unable to persistent_queue_ack, the message will be sent again after a restart");
+        }
+    }
+    ConfirmEvent(handleData, persisted->callback, persisted->context, result);
+    free(persisted);
+}
+
+/*moves persisted messages from disk to waitingToSend, keeping at most maxPersistedMessagesInMemory of them in memory*/
+static void LoadPersistedMessages(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    while (handleData->persistedMessagesInMemory < handleData->maxPersistedMessagesInMemory)
+    {
+        IOTHUB_MESSAGE_HANDLE message = NULL;
+        uint64_t sequenceNumber = 0;
+        PERSISTED_MESSAGE_CONTEXT* persisted = NULL;
+        PERSISTENT_QUEUE_RESULT readResult = persistent_queue_read_message(handleData->persistentQueue, handleData->nextPersistedToLoad, &message, &sequenceNumber);
+
+        if ((readResult == PERSISTENT_QUEUE_EMPTY) ||
+            ((readResult != PERSISTENT_QUEUE_OK) && (sequenceNumber < handleData->nextPersistedToLoad)))
+        {
+            /*nothing left, or the record could not even be located: retry at the next DoWork*/
+            break;
+        }
+        handleData->nextPersistedToLoad = sequenceNumber + 1;
+
+        /*the records of this run come in the order of persistedNotLoaded, a message whose record is gone was lost*/
+        while (handleData->persistedNotLoaded.Flink != &(handleData->persistedNotLoaded))
+        {
+            PERSISTED_MESSAGE_CONTEXT* head = containingRecord(handleData->persistedNotLoaded.Flink, PERSISTED_MESSAGE_CONTEXT, entry);
+            if (head->sequenceNumber > sequenceNumber)
+            {
+                break;
+            }
+            (void)DList_RemoveEntryList(&(head->entry));
+            if (head->sequenceNumber == sequenceNumber)
+            {
+                persisted = head;
+                break;
+            }
+            ConfirmEvent(handleData, head->callback, head->context, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+            free(head);
+        }
+
+        if (readResult != PERSISTENT_QUEUE_OK)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_126: [ A persisted message that cannot be read back shall be acknowledged and completed with IOTHUB_CLIENT_CONFIRMATION_ERROR. ]*/
+            LogError("persisted message %llu cannot be read back, it is dropped", (unsigned long long)sequenceNumber);
+            (void)persistent_queue_ack(handleData->persistentQueue, sequenceNumber);
+            if (persisted != NULL)
+            {
+                ConfirmEvent(handleData, persisted->callback, persisted->context, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+            }
+            free(persisted);
+        }
+        else if ((persisted == NULL) && (sequenceNumber >= handleData->firstPersistedOfThisRun))
+        {
+            /*the message of this run timed out before it could be loaded, its record is already acknowledged*/
+            IoTHubMessage_Destroy(message);
+        }
+        else
+        {
+            IOTHUB_MESSAGE_LIST* newEntry = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
+            if ((persisted == NULL) &&
+                ((persisted = (PERSISTED_MESSAGE_CONTEXT*)malloc(sizeof(PERSISTED_MESSAGE_CONTEXT))) != NULL))
+            {
+                /*a record left by a previous run, nobody is waiting for its confirmation*/
+                persisted->sequenceNumber = sequenceNumber;
+                persisted->callback = NULL;
+                persisted->context = NULL;
+                persisted->ms_timesOutAfter = 0;
+                persisted->ms_queuedAt = MS_QUEUED_AT_UNKNOWN;
+            }
+
+            if ((newEntry == NULL) || (persisted == NULL))
+            {
+                /*the record stays on disk, it will be loaded again after a restart*/
+                LogError("unable to malloc, persisted message %llu is not sent", (unsigned long long)sequenceNumber);
+                handleData->nextPersistedToLoad = sequenceNumber;
+                if (persisted != NULL)
+                {
+                    if (sequenceNumber >= handleData->firstPersistedOfThisRun)
+                    {
+                        DList_InsertHeadList(&(handleData->persistedNotLoaded), &(persisted->entry));
+                    }
+                    else
+                    {
+                        free(persisted);
+                    }
+                }
+                free(newEntry);
+                IoTHubMessage_Destroy(message);
+                break;
+            }
+            else
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_120: [ IoTHubClient_LL_DoWork shall move persisted messages to waitingToSend, oldest first, keeping at most maxMessagesInMemory of them in memory. ]*/
+                persisted->handleData = handleData;
+                newEntry->messageHandle = message;
+                newEntry->callback = OnPersistedMessageComplete;
+                newEntry->context = persisted;
+                newEntry->ms_timesOutAfter = persisted->ms_timesOutAfter;
+                newEntry->ms_queuedAt = persisted->ms_queuedAt;
+                InsertInFairShareOrder(handleData, newEntry);
+                handleData->persistedMessagesInMemory++;
+            }
+        }
     }
 }
 
@@ -760,9 +1476,28 @@ void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
     {
         IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
         DoTimeouts(handleData);
+        if (handleData->persistentQueue != NULL)
+        {
+            LoadPersistedMessages(handleData);
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_146: [ IoTHubClient_LL_DoWork shall not reorder waitingToSend: the tag of an event is fixed when it is inserted, a change of the weights does not move the events already waiting and the transports give events back at the head of waitingToSend. ]*/
 
         /*Codes_SRS_IOTHUBCLIENT_LL_02_021: [Otherwise, IoTHubClient_LL_DoWork shall invoke the underlaying layer's _DoWork function.]*/
         handleData->IoTHubTransport_DoWork(handleData->transportHandle, iotHubClientHandle);
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_166: [ After the underlaying layer's _DoWork function, IoTHubClient_LL_DoWork shall set IOTHUB_CLIENT_METRIC_EVENTS_QUEUED to the number of events in waitingToSend, IOTHUB_CLIENT_METRIC_EVENTS_IN_FLIGHT to the number of events taken by the transport and not completed yet and IOTHUB_CLIENT_METRIC_OUTBOUND_QUEUE_BYTES to the byte count of the outbound queue, 0 if it is not bounded. ]*/
+        handleData->eventsWaiting = 0;
+        {
+            DLIST_ENTRY* current;
+            for (current = handleData->waitingToSend.Flink; current != &(handleData->waitingToSend); current = current->Flink)
+            {
+                handleData->eventsWaiting++;
+            }
+        }
+        PublishQueueMetrics(handleData);
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_160: [ At the end of IoTHubClient_LL_SendComplete, IoTHubClient_LL_DoWork, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_Destroy, the confirmations added to the batch (if any) shall be given to the batch callback in one call, oldest first. ]*/
+        FlushConfirmations(handleData);
     }
 }
 
@@ -779,10 +1514,111 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetSendStatus(IOTHUB_CLIENT_LL_HANDLE iotHu
     else
     {
         IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        uint64_t firstSequenceNumber;
+        uint64_t nextSequenceNumber;
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_129: [ If persisted messages are still waiting to be handed to the transport, IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY. ]*/
+        if ((handleData->persistentQueue != NULL) &&
+            ((handleData->persistedNotLoaded.Flink != &(handleData->persistedNotLoaded)) ||
+            ((persistent_queue_get_range(handleData->persistentQueue, &firstSequenceNumber, &nextSequenceNumber) == 0) && (handleData->nextPersistedToLoad < nextSequenceNumber))))
+        {
+            *iotHubClientStatus = IOTHUB_CLIENT_SEND_STATUS_BUSY;
+            result = IOTHUB_CLIENT_OK;
+        }
+        else
+        {
+            /* Codes_SRS_IOTHUBCLIENT_09_008: [IoTHubClient_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_IDLE if there is currently no items to be sent] */
+            /* Codes_SRS_IOTHUBCLIENT_09_009: [IoTHubClient_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY if there are currently items to be sent] */
+            result = handleData->IoTHubTransport_GetSendStatus(handleData->deviceHandle, iotHubClientStatus);
+        }
+    }
+
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetOutboundQueueSize(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, size_t* messageCount, size_t* byteCount)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_139: [ If iotHubClientHandle, messageCount or byteCount is NULL, IoTHubClient_LL_GetOutboundQueueSize shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if ((iotHubClientHandle == NULL) || (messageCount == NULL) || (byteCount == NULL))
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        if (handleData->persistentQueue != NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_140: [ If a persistent queue is set, IoTHubClient_LL_GetOutboundQueueSize shall return the number of records and of bytes the persistent queue keeps on disk, as returned by persistent_queue_get_usage. ]*/
+            if (persistent_queue_get_usage(handleData->persistentQueue, messageCount, byteCount) != 0)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_141: [ If persistent_queue_get_usage fails, IoTHubClient_LL_GetOutboundQueueSize shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                result = IOTHUB_CLIENT_ERROR;
+                LOG_ERROR_RESULT;
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (handleData->isOutboundQueueBounded)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_142: [ Otherwise, if the outbound queue is bounded, IoTHubClient_LL_GetOutboundQueueSize shall return the number of counted events not confirmed yet and the size of their content. ]*/
+            *messageCount = handleData->outboundMessageCount;
+            *byteCount = handleData->outboundByteCount;
+            result = IOTHUB_CLIENT_OK;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_143: [ Otherwise IoTHubClient_LL_GetOutboundQueueSize shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+            LogError("the events are not counted, set OPTION_OUTBOUND_QUEUE_LIMITS first");
+            result = IOTHUB_CLIENT_ERROR;
+        }
+    }
+
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetMetrics(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_170: [ If iotHubClientHandle or snapshot is NULL, IoTHubClient_LL_GetMetrics shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if ((iotHubClientHandle == NULL) || (snapshot == NULL))
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_171: [ Otherwise IoTHubClient_LL_GetMetrics shall copy the metrics of the client to snapshot by calling iothub_client_metrics_get_snapshot and return IOTHUB_CLIENT_OK. ]*/
+        (void)iothub_client_metrics_get_snapshot(&(handleData->metrics), snapshot);
+        result = IOTHUB_CLIENT_OK;
+    }
+
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetEventConfirmationBatchCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_BATCH_CALLBACK batchCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
 
-        /* Codes_SRS_IOTHUBCLIENT_09_008: [IoTHubClient_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_IDLE if there is currently no items to be sent] */
-        /* Codes_SRS_IOTHUBCLIENT_09_009: [IoTHubClient_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY if there are currently items to be sent] */
-        result = handleData->IoTHubTransport_GetSendStatus(handleData->deviceHandle, iotHubClientStatus);
+    if (iotHubClientHandle == NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_156: [ If iotHubClientHandle is NULL, IoTHubClient_LL_SetEventConfirmationBatchCallback shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_157: [ Otherwise IoTHubClient_LL_SetEventConfirmationBatchCallback shall remember batchCallback and userContextCallback, a NULL batchCallback turning the batching off, and return IOTHUB_CLIENT_OK. ]*/
+        handleData->confirmationBatchCallback = batchCallback;
+        handleData->confirmationBatchUserContext = userContextCallback;
+        result = IOTHUB_CLIENT_OK;
     }
 
     return result;
@@ -803,18 +1639,47 @@ void IoTHubClient_LL_SendComplete(IOTHUB_CLIENT_LL_HANDLE handle, PDLIST_ENTRY c
     {
         /*Codes_SRS_IOTHUBCLIENT_LL_02_027: [If parameter result is IOTHUB_CLIENT_CONFIRMATION_ERROR then IoTHubClient_LL_SendComplete shall call all the non-NULL callbacks with the result parameter set to IOTHUB_CLIENT_CONFIRMATION_ERROR and the context set to the context passed originally in the SendEventAsync call.] */
         /*Codes_SRS_IOTHUBCLIENT_LL_02_025: [If parameter result is IOTHUB_CLIENT_CONFIRMATION_OK then IoTHubClient_LL_SendComplete shall call all the non-NULL callbacks with the result parameter set to IOTHUB_CLIENT_CONFIRMATION_OK and the context set to the context passed originally in the SendEventAsync call.]*/
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)handle;
         PDLIST_ENTRY oldest;
+        size_t completedCount = 0;
+        uint64_t nowTick = 0;
+        bool hasNowTick = false;
         while ((oldest = DList_RemoveHeadList(completed)) != completed)
         {
             IOTHUB_MESSAGE_LIST* messageList = (IOTHUB_MESSAGE_LIST*)containingRecord(oldest, IOTHUB_MESSAGE_LIST, entry);
-            /*Codes_SRS_IOTHUBCLIENT_LL_02_026: [If any callback is NULL then there shall not be a callback call.]*/
-            if (messageList->callback != NULL)
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_167: [ IoTHubClient_LL_SendComplete shall record in IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, for every event, the milliseconds between the tick read when the event was queued and the tick read when the event is completed. ]*/
+            if (completedCount == 0)
             {
-                messageList->callback(result, messageList->context);
+                hasNowTick = (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) == 0);
+                if (!hasNowTick)
+                {
+                    LogError("unable to get the current relative tickcount, the confirmation latency is not recorded");
+                }
+            }
+            if (hasNowTick && (messageList->ms_queuedAt != MS_QUEUED_AT_UNKNOWN) && (nowTick >= messageList->ms_queuedAt))
+            {
+                iothub_client_metrics_record(&(handleData->metrics), IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, nowTick - messageList->ms_queuedAt);
             }
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_172: [ IoTHubClient_LL_SendComplete, through which every transport completes the events it took, shall remove every completed event from IOTHUB_CLIENT_METRIC_EVENTS_IN_FLIGHT right away. ]*/
+            if (handleData->eventsOutstanding > 0)
+            {
+                handleData->eventsOutstanding--;
+            }
+            completedCount++;
+            IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_CALLBACK, messageList->messageHandle);
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_026: [If any callback is NULL then there shall not be a callback call.]*/
+            ConfirmEvent(handleData, messageList->callback, messageList->context, result);
             IoTHubMessage_Destroy(messageList->messageHandle);
             free(messageList);
         }
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_168: [ IoTHubClient_LL_SendComplete shall record the number of events it completed in IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE, unless there was none. ]*/
+        if (completedCount > 0)
+        {
+            iothub_client_metrics_record(&(handleData->metrics), IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE, completedCount);
+        }
+        PublishQueueMetrics(handleData);
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_160: [ At the end of IoTHubClient_LL_SendComplete, IoTHubClient_LL_DoWork, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_Destroy, the confirmations added to the batch (if any) shall be given to the batch callback in one call, oldest first. ]*/
+        FlushConfirmations(handleData);
     }
 }
 
@@ -833,6 +1698,8 @@ IOTHUBMESSAGE_DISPOSITION_RESULT IoTHubClient_LL_MessageCallback(IOTHUB_CLIENT_L
 
         /* Codes_SRS_IOTHUBCLIENT_LL_09_004: [IoTHubClient_LL_GetLastMessageReceiveTime shall return lastMessageReceiveTime in localtime] */
         handleData->lastMessageReceiveTime = get_time(NULL);
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_169: [ IoTHubClient_LL_MessageCallback shall add 1 to IOTHUB_CLIENT_METRIC_MESSAGES_RECEIVED. ]*/
+        iothub_client_metrics_add(&(handleData->metrics), IOTHUB_CLIENT_METRIC_MESSAGES_RECEIVED, 1);
 
         /*Codes_SRS_IOTHUBCLIENT_LL_02_030: [IoTHubClient_LL_MessageCallback shall invoke the last callback function (the parameter messageCallback to IoTHubClient_LL_SetMessageCallback) passing the message and the passed userContextCallback.]*/
         if (handleData->messageCallback != NULL)
@@ -870,20 +1737,67 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetConnectionStatusCallback(IOTHUB_CLIENT_L
 
 IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetRetryPolicy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitinSeconds)
 {
-    IOTHUB_CLIENT_RESULT result = IOTHUB_CLIENT_OK;
-    (void)iotHubClientHandle;
-    (void)retryPolicy;
-    (void)retryTimeoutLimitinSeconds;
+    IOTHUB_CLIENT_RESULT result;
+    IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+
+    /* Codes_SRS_IOTHUBCLIENT_LL_25_116: [**IoTHubClient_LL_SetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL iotHubClientHandle**]*/
+    if (handleData == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    /* Codes_SRS_IOTHUBCLIENT_LL_02_111: [ If retryPolicy is not one of the IOTHUB_CLIENT_RETRY_POLICY values then IoTHubClient_LL_SetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    else if ((int)retryPolicy < (int)IOTHUB_CLIENT_RETRY_NONE || (int)retryPolicy > (int)IOTHUB_CLIENT_RETRY_RANDOM)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    /* Codes_SRS_IOTHUBCLIENT_LL_02_174: [ If iotHubClientHandle was created on a shared transport then IoTHubClient_LL_SetRetryPolicy shall fail and return IOTHUB_CLIENT_ERROR, because the policy of the transport is the policy of every device on it. ]*/
+    else if (handleData->isSharedTransport)
+    {
+        LogError("the retry policy cannot be set per device on a shared transport");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    /* Codes_SRS_IOTHUBCLIENT_LL_02_173: [ For every policy, a retryTimeoutLimitinSeconds of 0 shall mean no time limit. ]*/
+    /* Codes_SRS_IOTHUBCLIENT_LL_02_112: [ IoTHubClient_LL_SetRetryPolicy shall pass the policy and the timeout limit to the transport by calling _SetRetryPolicy. ]*/
+    else if (handleData->IoTHubTransport_SetRetryPolicy(handleData->transportHandle, retryPolicy, retryTimeoutLimitinSeconds) != 0)
+    {
+        /* Codes_SRS_IOTHUBCLIENT_LL_02_113: [ If _SetRetryPolicy fails then IoTHubClient_LL_SetRetryPolicy shall return IOTHUB_CLIENT_ERROR. ]*/
+        result = IOTHUB_CLIENT_ERROR;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUBCLIENT_LL_25_118: [**IoTHubClient_LL_SetRetryPolicy shall save connection retry policies specified by the user to retryPolicy in struct IOTHUB_CLIENT_LL_HANDLE_DATA**]*/
+        /* Codes_SRS_IOTHUBCLIENT_LL_25_119: [**IoTHubClient_LL_SetRetryPolicy shall save retryTimeoutLimitinSeconds in seconds to retryTimeout in struct IOTHUB_CLIENT_LL_HANDLE_DATA**]*/
+        handleData->retryPolicy = retryPolicy;
+        handleData->retryTimeoutinSeconds = retryTimeoutLimitinSeconds;
+        result = IOTHUB_CLIENT_OK;
+    }
 
     return result;
 }
 
 IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetRetryPolicy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY* retryPolicy, size_t* retryTimeoutLimitinSeconds)
 {
-    IOTHUB_CLIENT_RESULT result = IOTHUB_CLIENT_OK;
-    (void)iotHubClientHandle;
-    (void)retryPolicy;
-    (void)retryTimeoutLimitinSeconds;
+    IOTHUB_CLIENT_RESULT result;
+    IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+
+    /* Codes_SRS_IOTHUBCLIENT_LL_25_120: [**IoTHubClient_LL_GetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL iotHubClientHandle or retryPolicy or retryTimeoutLimitinSeconds parameters**]*/
+    if ((handleData == NULL) || (retryPolicy == NULL) || (retryTimeoutLimitinSeconds == NULL))
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUBCLIENT_LL_25_121: [**IoTHubClient_LL_GetRetryPolicy shall retrieve connection retry policy from retryPolicy in struct IOTHUB_CLIENT_LL_HANDLE_DATA**]*/
+        /* Codes_SRS_IOTHUBCLIENT_LL_25_122: [**IoTHubClient_LL_GetRetryPolicy shall retrieve retryTimeoutLimit in seconds from retryTimeoutinSeconds in struct IOTHUB_CLIENT_LL_HANDLE_DATA**]*/
+        /* Codes_SRS_IOTHUBCLIENT_LL_25_123: [**If user did not set the policy and timeout values by calling IoTHubClient_LL_SetRetryPolicy then IoTHubClient_LL_GetRetryPolicy shall return default values**]*/
+        *retryPolicy = handleData->retryPolicy;
+        *retryTimeoutLimitinSeconds = handleData->retryTimeoutinSeconds;
+        result = IOTHUB_CLIENT_OK;
+    }
 
     return result;
 }
@@ -947,6 +1861,137 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubCli
             handleData->currentMessageTimeout = *(const uint64_t*)value;
             result = IOTHUB_CLIENT_OK;
         }
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_118: [ OPTION_PERSISTENT_QUEUE - value is a pointer to a PERSISTENT_QUEUE_CONFIG. IoTHubClient_LL_SetOption shall create the persistent queue with persistent_queue_create, recovering the messages a previous run left in the directory. ]*/
+        else if (strcmp(optionName, OPTION_PERSISTENT_QUEUE) == 0)
+        {
+            const PERSISTENT_QUEUE_CONFIG* persistentQueueConfig = (const PERSISTENT_QUEUE_CONFIG*)value;
+            uint64_t firstSequenceNumber;
+
+            if (handleData->persistentQueue != NULL)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_119: [ If the persistent queue is already set or persistent_queue_create fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+                LogError("the persistent queue can be set only once");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if ((handleData->persistentQueue = persistent_queue_create(persistentQueueConfig)) == NULL)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_119: [ If the persistent queue is already set or persistent_queue_create fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+                LogError("unable to persistent_queue_create");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if (persistent_queue_get_range(handleData->persistentQueue, &firstSequenceNumber, &(handleData->firstPersistedOfThisRun)) != 0)
+            {
+                LogError("unable to persistent_queue_get_range");
+                persistent_queue_destroy(handleData->persistentQueue);
+                handleData->persistentQueue = NULL;
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                DList_InitializeListHead(&(handleData->persistedNotLoaded));
+                handleData->nextPersistedToLoad = firstSequenceNumber;
+                handleData->persistedMessagesInMemory = 0;
+                handleData->maxPersistedMessagesInMemory = (persistentQueueConfig->maxMessagesInMemory == 0) ? PERSISTENT_QUEUE_DEFAULT_MAX_MESSAGES_IN_MEMORY : persistentQueueConfig->maxMessagesInMemory;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_130: [ OPTION_OUTBOUND_QUEUE_LIMITS - value is a pointer to an IOTHUB_CLIENT_QUEUE_LIMITS. IoTHubClient_LL_SetOption shall copy the limits, the events sent from then on are counted against them. ]*/
+        else if (strcmp(optionName, OPTION_OUTBOUND_QUEUE_LIMITS) == 0)
+        {
+            const IOTHUB_CLIENT_QUEUE_LIMITS* limits = (const IOTHUB_CLIENT_QUEUE_LIMITS*)value;
+            if ((limits->overflowPolicy != IOTHUB_CLIENT_QUEUE_OVERFLOW_REJECT) &&
+                (limits->overflowPolicy != IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST) &&
+                (limits->overflowPolicy != IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK))
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_131: [ If overflowPolicy is not an IOTHUB_CLIENT_QUEUE_OVERFLOW_POLICY value, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+                LogError("invalid overflow policy %d", (int)limits->overflowPolicy);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                if (!handleData->isOutboundQueueBounded)
+                {
+                    handleData->outboundMessageCount = 0;
+                    handleData->outboundByteCount = 0;
+                    handleData->isOutboundQueueBounded = true;
+                }
+                handleData->outboundQueueLimits = *limits;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_147: [ OPTION_PRIORITY_WEIGHTS - value is a pointer to an IOTHUB_CLIENT_PRIORITY_WEIGHTS. IoTHubClient_LL_SetOption shall copy the weights, the events sent from then on are ordered by them. ]*/
+        else if (strcmp(optionName, OPTION_PRIORITY_WEIGHTS) == 0)
+        {
+            const IOTHUB_CLIENT_PRIORITY_WEIGHTS* weights = (const IOTHUB_CLIENT_PRIORITY_WEIGHTS*)value;
+            if ((weights->low == 0) || (weights->low > MAX_PRIORITY_WEIGHT) ||
+                (weights->normal == 0) || (weights->normal > MAX_PRIORITY_WEIGHT) ||
+                (weights->high == 0) || (weights->high > MAX_PRIORITY_WEIGHT))
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_148: [ If any weight is 0 or greater than 1000, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+                LogError("priority weights go from 1 to %d", MAX_PRIORITY_WEIGHT);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                handleData->priorityWeights = *weights;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_150: [ OPTION_COMPRESSION - value is a pointer to an IOTHUB_CLIENT_COMPRESSION_CONFIG. IoTHubClient_LL_SetOption shall create a compressor with compression_create for IOTHUB_CLIENT_COMPRESSION_LZ4 and destroy the current compressor, if any, for IOTHUB_CLIENT_COMPRESSION_NONE. ]*/
+        else if (strcmp(optionName, OPTION_COMPRESSION) == 0)
+        {
+            const IOTHUB_CLIENT_COMPRESSION_CONFIG* config = (const IOTHUB_CLIENT_COMPRESSION_CONFIG*)value;
+            if (
+                ((config->algorithm != IOTHUB_CLIENT_COMPRESSION_NONE) && (config->algorithm != IOTHUB_CLIENT_COMPRESSION_LZ4)) ||
+                ((config->dictionary == NULL) && (config->dictionarySize != 0))
+                )
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_151: [ If the algorithm is unknown or dictionary is NULL and dictionarySize is not 0, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+                LogError("invalid compression config");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if (config->algorithm == IOTHUB_CLIENT_COMPRESSION_NONE)
+            {
+                if (handleData->compression != NULL)
+                {
+                    compression_destroy(handleData->compression);
+                    free(handleData->compressionDictionaryId);
+                    handleData->compression = NULL;
+                    handleData->compressionDictionaryId = NULL;
+                }
+                result = IOTHUB_CLIENT_OK;
+            }
+            else
+            {
+                char* dictionaryId = NULL;
+                COMPRESSION_HANDLE compression;
+                if ((config->dictionaryId != NULL) && (mallocAndStrcpy_s(&dictionaryId, config->dictionaryId) != 0))
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_152: [ If creating the compressor fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current compressor. ]*/
+                    LogError("unable to copy the dictionary id");
+                    result = IOTHUB_CLIENT_ERROR;
+                }
+                else if ((compression = compression_create(config->dictionary, config->dictionarySize)) == NULL)
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_152: [ If creating the compressor fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current compressor. ]*/
+                    LogError("unable to compression_create");
+                    free(dictionaryId);
+                    result = IOTHUB_CLIENT_ERROR;
+                }
+                else
+                {
+                    if (handleData->compression != NULL)
+                    {
+                        compression_destroy(handleData->compression);
+                        free(handleData->compressionDictionaryId);
+                    }
+                    handleData->compression = compression;
+                    handleData->compressionDictionaryId = dictionaryId;
+                    handleData->compressionMinimumSize = config->minimumSize;
+                    result = IOTHUB_CLIENT_OK;
+                }
+            }
+        }
         else
         {
 
@@ -15,7 +15,7 @@
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/tickcounter.h"
-#include "azure_c_shared_utility/httpapiexsas.h"
+#include "azure_c_shared_utility/httpapiex.h"
 
 #include "iothub_client_ll.h"
 #include "iothub_client_options.h"
@@ -24,6 +24,7 @@
 #include "iothub_transport_ll.h"
 #include "parson.h"
 #include "iothub_client_ll_uploadtoblob.h"
+#include "iothub_client_sastoken_cache.h"
 #include "blob.h"
 
 
@@ -63,7 +64,7 @@ typedef struct IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA_TAG
     const char* hostname;                       /*needed for file upload*/
     AUTHORIZATION_SCHEME authorizationScheme;   /*needed for file upload*/
     union {
-        STRING_HANDLE deviceKey;    /*used when authorizationScheme is DEVICE_KEY*/
+        SASTOKEN_CACHE_HANDLE sasTokenCache; /*used when authorizationScheme is DEVICE_KEY*/
         STRING_HANDLE sas;          /*used when authorizationScheme is SAS_TOKEN*/
         UPLOADTOBLOB_X509_CREDENTIALS x509credentials; /*assumed to be used when both deviceKey and deviceSasToken are NULL*/
     } credentials;                              /*needed for file upload*/
@@ -123,10 +124,44 @@ IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE IoTHubClient_LL_UploadToBlob_Create(const I
                 else if ((config->deviceSasToken == NULL) && (config->deviceKey != NULL))
                 {
                     handleData->authorizationScheme = DEVICE_KEY;
-                    handleData->credentials.deviceKey = STRING_construct(config->deviceKey);
-                    if (handleData->credentials.deviceKey == NULL)
+                    handleData->credentials.sasTokenCache = NULL;
+                    STRING_HANDLE deviceKey = STRING_construct(config->deviceKey);
+                    if (deviceKey == NULL)
                     {
                         LogError("unable to STRING_construct");
+                    }
+                    else
+                    {
+                        STRING_HANDLE uriResource = STRING_construct(handleData->hostname);
+                        if (uriResource == NULL)
+                        {
+                            LogError("unable to STRING_construct");
+                        }
+                        else
+                        {
+                            if (!(
+                                (STRING_concat(uriResource, "/devices/") == 0) &&
+                                (STRING_concat_with_STRING(uriResource, handleData->deviceId) == 0)
+                                ))
+                            {
+                                LogError("unable to STRING_concat");
+                            }
+                            else
+                            {
+                                /*Codes_SRS_IOTHUBCLIENT_LL_02_115: [ If the credentials are a device key then IoTHubClient_LL_UploadToBlob_Create shall create a SAS token cache passing the device key, hostname + "/devices/" + deviceId as scope and NULL as key name. ]*/
+                                handleData->credentials.sasTokenCache = sastoken_cache_create(deviceKey, uriResource, NULL);
+                                if (handleData->credentials.sasTokenCache == NULL)
+                                {
+                                    LogError("unable to sastoken_cache_create");
+                                }
+                            }
+                            STRING_delete(uriResource);
+                        }
+                        STRING_delete(deviceKey);
+                    }
+
+                    if (handleData->credentials.sasTokenCache == NULL)
+                    {
                         free((void*)handleData->hostname);
                         STRING_delete(handleData->deviceId);
                         free(handleData);
@@ -151,6 +186,32 @@ IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE IoTHubClient_LL_UploadToBlob_Create(const I
     
 }
 
+/*the uploads run on threads of their own, without the lock of the client, so the token is copied out of the cache and freed once it is in the headers*/
+static int replaceAuthorizationWithCachedToken(SASTOKEN_CACHE_HANDLE sasTokenCache, HTTP_HEADERS_HANDLE requestHttpHeaders)
+{
+    int result;
+    STRING_HANDLE sasToken = sastoken_cache_copy_token(sasTokenCache, NULL);
+    if (sasToken == NULL)
+    {
+        LogError("unable to sastoken_cache_copy_token");
+        result = __LINE__;
+    }
+    else
+    {
+        if (HTTPHeaders_ReplaceHeaderNameValuePair(requestHttpHeaders, "Authorization", STRING_c_str(sasToken)) != HTTP_HEADERS_OK)
+        {
+            LogError("unable to HTTPHeaders_ReplaceHeaderNameValuePair");
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+        STRING_delete(sasToken);
+    }
+    return result;
+}
+
 /*returns 0 when correlationId, sasUri contain data*/
 static int IoTHubClient_LL_UploadToBlob_step1and2(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA* handleData, HTTPAPIEX_HANDLE iotHubHttpApiExHandle, HTTP_HEADERS_HANDLE requestHttpHeaders, const char* destinationFileName,
     STRING_HANDLE correlationId, STRING_HANDLE sasUri)
@@ -298,82 +359,46 @@ static int IoTHubClient_LL_UploadToBlob_step1and2(IOTHUB_CLIENT_LL_UPLOADTOBLOB_
                     }
                     case(DEVICE_KEY):
                     {
-                        /*Codes_SRS_IOTHUBCLIENT_LL_02_078: [ If the credentials used to create handle have "deviceKey" then IoTHubClient_LL_UploadToBlob shall create an HTTPAPIEX_SAS_HANDLE passing as arguments: ]*/
-                        STRING_HANDLE uriResource = STRING_construct(handleData->hostname);
-                        if (uriResource == NULL)
+                        /*Codes_SRS_IOTHUBCLIENT_LL_02_078: [ If the credentials used to create handle have "deviceKey" then IoTHubClient_LL_UploadToBlob shall replace the "Authorization" HTTP request header with a copy of the token returned by sastoken_cache_copy_token, and free the copy. ]*/
+                        if (replaceAuthorizationWithCachedToken(handleData->credentials.sasTokenCache, requestHttpHeaders) != 0)
                         {
-                            /*Codes_SRS_IOTHUBCLIENT_LL_02_089: [ If creating the HTTPAPIEX_SAS_HANDLE fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_089: [ If getting the SAS token or replacing the "Authorization" header fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
                             result = __LINE__;
-                            LogError("unable to STRING_construct");
                         }
                         else
                         {
-                            if (!(
-                                (STRING_concat(uriResource, "/devices/") == 0) &&
-                                (STRING_concat_with_STRING(uriResource, handleData->deviceId) == 0)
-                                ))
+                            unsigned int statusCode;
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_090: [ IoTHubClient_LL_UploadToBlob shall call HTTPAPIEX_ExecuteRequest passing as arguments: ]*/
+                            if (HTTPAPIEX_ExecuteRequest(
+                                iotHubHttpApiExHandle,          /*HTTPAPIEX_HANDLE handle - the created HTTPAPIEX_HANDLE*/
+                                HTTPAPI_REQUEST_GET,            /*HTTPAPI_REQUEST_TYPE requestType - HTTPAPI_REQUEST_GET*/
+                                STRING_c_str(relativePath),     /*const char* relativePath - the HTTP relative path*/
+                                requestHttpHeaders,             /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle - request HTTP headers*/
+                                NULL,                           /*BUFFER_HANDLE requestContent - NULL*/
+                                &statusCode,                    /*unsigned int* statusCode - the address of an unsigned int that will contain the HTTP status code*/
+                                NULL,                           /*HTTP_HEADERS_HANDLE responseHeadersHandle - NULL*/
+                                responseContent                 /*BUFFER_HANDLE responseContent - the HTTP response BUFFER_HANDLE - responseContent*/
+                            ) != HTTPAPIEX_OK)
                             {
-                                /*Codes_SRS_IOTHUBCLIENT_LL_02_089: [ If creating the HTTPAPIEX_SAS_HANDLE fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-                                LogError("unable to STRING_concat_with_STRING");
+                                /*Codes_SRS_IOTHUBCLIENT_LL_02_079: [ If HTTPAPIEX_ExecuteRequest fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                                LogError("unable to HTTPAPIEX_ExecuteRequest");
                                 result = __LINE__;
                             }
                             else
                             {
-                                STRING_HANDLE empty = STRING_new();
-                                if (empty == NULL)
+                                if (statusCode >= 300)
                                 {
-                                    LogError("unable to STRING_new");
+                                    /*Codes_SRS_IOTHUBCLIENT_LL_02_080: [ If status code is greater than or equal to 300 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
                                     result = __LINE__;
+                                    LogError("HTTP code was %u", statusCode);
                                 }
                                 else
                                 {
-                                    /*Codes_SRS_IOTHUBCLIENT_LL_02_089: [ If creating the HTTPAPIEX_SAS_HANDLE fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-                                    HTTPAPIEX_SAS_HANDLE sasHandle = HTTPAPIEX_SAS_Create(handleData->credentials.deviceKey, uriResource, empty);
-                                    if (sasHandle == NULL)
-                                    {
-                                        LogError("unable to HTTPAPIEX_SAS_Create");
-                                        result = __LINE__;
-                                    }
-                                    else
-                                    {
-                                        unsigned int statusCode;
-                                        /*Codes_SRS_IOTHUBCLIENT_LL_02_090: [ IoTHubClient_LL_UploadToBlob shall call HTTPAPIEX_SAS_ExecuteRequest passing as arguments: ]*/
-                                        if (HTTPAPIEX_SAS_ExecuteRequest(
-                                            sasHandle,                      /*HTTPAPIEX_SAS_HANDLE sasHandle - the created HTTPAPIEX_SAS_HANDLE*/
-                                            iotHubHttpApiExHandle,          /*HTTPAPIEX_HANDLE handle - the created HTTPAPIEX_HANDLE*/
-                                            HTTPAPI_REQUEST_GET,            /*HTTPAPI_REQUEST_TYPE requestType - HTTPAPI_REQUEST_GET*/
-                                            STRING_c_str(relativePath),     /*const char* relativePath - the HTTP relative path*/
-                                            requestHttpHeaders,             /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle - request HTTP headers*/
-                                            NULL,                           /*BUFFER_HANDLE requestContent - NULL*/
-                                            &statusCode,                    /*unsigned int* statusCode - the address of an unsigned int that will contain the HTTP status code*/
-                                            NULL,                           /*HTTP_HEADERS_HANDLE responseHeadersHandle - NULL*/
-                                            responseContent
-                                        ) != HTTPAPIEX_OK)
-                                        {
-                                            /*Codes_SRS_IOTHUBCLIENT_LL_02_079: [ If HTTPAPIEX_SAS_ExecuteRequest fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-                                            LogError("unable to HTTPAPIEX_SAS_ExecuteRequest");
-                                            result = __LINE__;
-                                        }
-                                        else
-                                        {
-                                            if (statusCode >= 300)
-                                            {
-                                                /*Codes_SRS_IOTHUBCLIENT_LL_02_080: [ If status code is greater than or equal to 300 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-                                                result = __LINE__;
-                                                LogError("HTTP code was %u", statusCode);
-                                            }
-                                            else
-                                            {
-                                                wasIoTHubRequestSuccess = 1;
-                                            }
-                                        }
-                                        HTTPAPIEX_SAS_Destroy(sasHandle);
-                                    }
-                                    STRING_delete(empty);
+                                    wasIoTHubRequestSuccess = 1;
                                 }
                             }
-                            STRING_delete(uriResource);
                         }
+                        break;
                     }
                     } /*switch*/
 
@@ -525,177 +550,141 @@ static int IoTHubClient_LL_UploadToBlob_step3(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HAND
     /*this POST "tries" to happen*/
 
     /*Codes_SRS_IOTHUBCLIENT_LL_02_085: [ IoTHubClient_LL_UploadToBlob shall use the same authorization as step 1. to prepare and perform a HTTP request with the following parameters: ]*/
-    STRING_HANDLE uriResource = STRING_construct(handleData->hostname);
-    if (uriResource == NULL)
+    STRING_HANDLE relativePathNotification = STRING_construct("/devices/");
+    if (relativePathNotification == NULL)
     {
-        LogError("unable to construct URI");
         result = __LINE__;
+        LogError("unable to STRING_construct");
     }
     else
     {
         if (!(
-            (STRING_concat(uriResource, "/devices/") == 0) &&
-            (STRING_concat_with_STRING(uriResource, handleData->deviceId) == 0) &&
-            (STRING_concat(uriResource, "/files/notifications") == 0)
+            (STRING_concat_with_STRING(relativePathNotification, handleData->deviceId) == 0) &&
+            (STRING_concat(relativePathNotification, "/files/notifications/") == 0) &&
+            (STRING_concat(relativePathNotification, STRING_c_str(correlationId)) == 0) &&
+            (STRING_concat(relativePathNotification, API_VERSION) == 0)
             ))
         {
-            LogError("unable to STRING_concat");
+            LogError("unable to STRING_concat_with_STRING");
             result = __LINE__;
         }
         else
         {
-            STRING_HANDLE relativePathNotification = STRING_construct("/devices/");
-            if (relativePathNotification == NULL)
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_086: [ If performing the HTTP request fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+            switch (handleData->authorizationScheme)
             {
+            default:
+            {
+                LogError("internal error: unknown authorization Scheme");
                 result = __LINE__;
-                LogError("unable to STRING_construct");
+                break;
             }
-            else
+            case (X509):
             {
-                if (!(
-                    (STRING_concat_with_STRING(relativePathNotification, handleData->deviceId) == 0) &&
-                    (STRING_concat(relativePathNotification, "/files/notifications/") == 0) &&
-                    (STRING_concat(relativePathNotification, STRING_c_str(correlationId)) == 0) &&
-                    (STRING_concat(relativePathNotification, API_VERSION) == 0)
-                    ))
+                unsigned int notificationStatusCode;
+                if (HTTPAPIEX_ExecuteRequest(
+                    iotHubHttpApiExHandle,
+                    HTTPAPI_REQUEST_POST,
+                    STRING_c_str(relativePathNotification),
+                    requestHttpHeaders,
+                    messageBody,
+                    &notificationStatusCode,
+                    NULL,
+                    NULL) != HTTPAPIEX_OK)
                 {
-                    LogError("unable to STRING_concat_with_STRING");
+                    LogError("unable to do HTTPAPIEX_ExecuteRequest");
                     result = __LINE__;
                 }
                 else
                 {
-                    /*Codes_SRS_IOTHUBCLIENT_LL_02_086: [ If performing the HTTP request fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-                    switch (handleData->authorizationScheme)
+                    if (notificationStatusCode >= 300)
                     {
-                    default:
+                        /*Codes_SRS_IOTHUBCLIENT_LL_02_087: [If the statusCode of the HTTP request is greater than or equal to 300 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR]*/
+                        LogError("server didn't like the notification request");
+                        result = __LINE__;
+                    }
+                    else
+                    {
+                        result = 0;
+                    }
+                }
+                break;
+            }
+            case (DEVICE_KEY):
+            {
+                /*the token of step 1 is handed out again by the cache unless it has aged meanwhile*/
+                if (replaceAuthorizationWithCachedToken(handleData->credentials.sasTokenCache, requestHttpHeaders) != 0)
+                {
+                    result = __LINE__;
+                }
+                else
+                {
+                    unsigned int statusCode;
+                    if (HTTPAPIEX_ExecuteRequest(
+                        iotHubHttpApiExHandle,                      /*HTTPAPIEX_HANDLE handle - the created HTTPAPIEX_HANDLE*/
+                        HTTPAPI_REQUEST_POST,                       /*HTTPAPI_REQUEST_TYPE requestType - HTTPAPI_REQUEST_POST*/
+                        STRING_c_str(relativePathNotification),     /*const char* relativePath - the HTTP relative path*/
+                        requestHttpHeaders,                         /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle - request HTTP headers*/
+                        messageBody,                                /*BUFFER_HANDLE requestContent*/
+                        &statusCode,                                /*unsigned int* statusCode - the address of an unsigned int that will contain the HTTP status code*/
+                        NULL,                                       /*HTTP_HEADERS_HANDLE responseHeadersHandle - NULL*/
+                        NULL
+                    ) != HTTPAPIEX_OK)
                     {
-                        LogError("internal error: unknown authorization Scheme");
+                        /*Codes_SRS_IOTHUBCLIENT_LL_02_079: [ If HTTPAPIEX_ExecuteRequest fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                        LogError("unable to HTTPAPIEX_ExecuteRequest");
                         result = __LINE__;
-                        break;
                     }
-                    case (X509):
+                    else
                     {
-                        unsigned int notificationStatusCode;
-                        if (HTTPAPIEX_ExecuteRequest(
-                            iotHubHttpApiExHandle,
-                            HTTPAPI_REQUEST_POST,
-                            STRING_c_str(relativePathNotification),
-                            requestHttpHeaders,
-                            messageBody,
-                            &notificationStatusCode,
-                            NULL,
-                            NULL) != HTTPAPIEX_OK)
+                        if (statusCode >= 300)
                         {
-                            LogError("unable to do HTTPAPIEX_ExecuteRequest");
+                            /*Codes_SRS_IOTHUBCLIENT_LL_02_087: [If the statusCode of the HTTP request is greater than or equal to 300 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR]*/
                             result = __LINE__;
+                            LogError("HTTP code was %u", statusCode);
                         }
                         else
                         {
-                            if (notificationStatusCode >= 300)
-                            {
-                                /*Codes_SRS_IOTHUBCLIENT_LL_02_087: [If the statusCode of the HTTP request is greater than or equal to 300 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR]*/
-                                LogError("server didn't like the notification request");
-                                result = __LINE__;
-                            }
-                            else
-                            {
-                                result = 0;
-                            }
+                            result = 0;
                         }
-                        break;
                     }
-                    case (DEVICE_KEY):
+                }
+                break;
+            }
+            case(SAS_TOKEN):
+            {
+                unsigned int notificationStatusCode;
+                if (HTTPAPIEX_ExecuteRequest(
+                    iotHubHttpApiExHandle,
+                    HTTPAPI_REQUEST_POST,
+                    STRING_c_str(relativePathNotification),
+                    requestHttpHeaders,
+                    messageBody,
+                    &notificationStatusCode,
+                    NULL,
+                    NULL) != HTTPAPIEX_OK)
+                {
+                    LogError("unable to do HTTPAPIEX_ExecuteRequest");
+                    result = __LINE__;
+                }
+                else
+                {
+                    if (notificationStatusCode >= 300)
                     {
-                        STRING_HANDLE empty = STRING_new();
-                        if (empty == NULL)
-                        {
-                            LogError("unable to STRING_new");
-                            result = __LINE__;
-                        }
-                        else
-                        {
-                            HTTPAPIEX_SAS_HANDLE sasHandle = HTTPAPIEX_SAS_Create(handleData->credentials.deviceKey, uriResource, empty);
-                            if (sasHandle == NULL)
-                            {
-                                LogError("unable to HTTPAPIEX_SAS_Create");
-                                result = __LINE__;
-                            }
-                            else
-                            {
-                                unsigned int statusCode;
-                                if (HTTPAPIEX_SAS_ExecuteRequest(
-                                    sasHandle,                      /*HTTPAPIEX_SAS_HANDLE sasHandle - the created HTTPAPIEX_SAS_HANDLE*/
-                                    iotHubHttpApiExHandle,          /*HTTPAPIEX_HANDLE handle - the created HTTPAPIEX_HANDLE*/
-                                    HTTPAPI_REQUEST_POST,            /*HTTPAPI_REQUEST_TYPE requestType - HTTPAPI_REQUEST_GET*/
-                                    STRING_c_str(relativePathNotification),     /*const char* relativePath - the HTTP relative path*/
-                                    requestHttpHeaders,             /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle - request HTTP headers*/
-                                    messageBody,                    /*BUFFER_HANDLE requestContent*/
-                                    &statusCode,                    /*unsigned int* statusCode - the address of an unsigned int that will contain the HTTP status code*/
-                                    NULL,                           /*HTTP_HEADERS_HANDLE responseHeadersHandle - NULL*/
-                                    NULL
-                                ) != HTTPAPIEX_OK)
-                                {
-                                    /*Codes_SRS_IOTHUBCLIENT_LL_02_079: [ If HTTPAPIEX_SAS_ExecuteRequest fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-                                    LogError("unable to HTTPAPIEX_SAS_ExecuteRequest");
-                                    result = __LINE__;
-                                    ;
-                                }
-                                else
-                                {
-                                    if (statusCode >= 300)
-                                    {
-                                        /*Codes_SRS_IOTHUBCLIENT_LL_02_087: [If the statusCode of the HTTP request is greater than or equal to 300 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR]*/
-                                        result = __LINE__;
-                                        LogError("HTTP code was %u", statusCode);
-                                    }
-                                    else
-                                    {
-                                        result = 0;
-                                    }
-                                }
-                                HTTPAPIEX_SAS_Destroy(sasHandle);
-                            }
-                            STRING_delete(empty);
-                        }
-                        break;
+                        /*Codes_SRS_IOTHUBCLIENT_LL_02_087: [If the statusCode of the HTTP request is greater than or equal to 300 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR]*/
+                        LogError("server didn't like the notification request");
+                        result = __LINE__;
                     }
-                    case(SAS_TOKEN):
+                    else
                     {
-                        unsigned int notificationStatusCode;
-                        if (HTTPAPIEX_ExecuteRequest(
-                            iotHubHttpApiExHandle,
-                            HTTPAPI_REQUEST_POST,
-                            STRING_c_str(relativePathNotification),
-                            requestHttpHeaders,
-                            messageBody,
-                            &notificationStatusCode,
-                            NULL,
-                            NULL) != HTTPAPIEX_OK)
-                        {
-                            LogError("unable to do HTTPAPIEX_ExecuteRequest");
-                            result = __LINE__;
-                        }
-                        else
-                        {
-                            if (notificationStatusCode >= 300)
-                            {
-                                /*Codes_SRS_IOTHUBCLIENT_LL_02_087: [If the statusCode of the HTTP request is greater than or equal to 300 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR]*/
-                                LogError("server didn't like the notification request");
-                                result = __LINE__;
-                            }
-                            else
-                            {
-                                result = 0;
-                            }
-                        }
-                        break;
+                        result = 0;
                     }
-                    } /*switch authorizationScheme*/
                 }
-                STRING_delete(relativePathNotification);
+                break;
             }
+            } /*switch authorizationScheme*/
         }
-        STRING_delete(uriResource);
+        STRING_delete(relativePathNotification);
     }
     return result;
 }
@@ -886,7 +875,8 @@ void IoTHubClient_LL_UploadToBlob_Destroy(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h
             }
             case(DEVICE_KEY):
             {
-                STRING_delete(handleData->credentials.deviceKey);
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_116: [ IoTHubClient_LL_UploadToBlob_Destroy shall destroy the SAS token cache. ]*/
+                sastoken_cache_destroy(handleData->credentials.sasTokenCache);
                 break;
             }
             case(X509):
@@ -0,0 +1,297 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "iothub_client_metrics.h"
+
+/*
+ * Every value has a single writer at a time (the client or the transport, under their lock), the atomics are there so
+ * that a snapshot can be taken from another thread without that lock. Define IOTHUB_CLIENT_METRICS_USE_PLAIN to use
+ * plain reads and writes even when the compiler has 64 bit atomics.
+ */
+#if !defined(IOTHUB_CLIENT_METRICS_USE_PLAIN)
+#if defined(_MSC_VER)
+#include <windows.h>
+#define IOTHUB_CLIENT_METRICS_USE_INTERLOCKED
+#elif defined(__GCC_ATOMIC_LLONG_LOCK_FREE) && (__GCC_ATOMIC_LLONG_LOCK_FREE == 2)
+#define IOTHUB_CLIENT_METRICS_USE_ATOMIC_BUILTINS
+#else
+#define IOTHUB_CLIENT_METRICS_USE_PLAIN
+#endif
+#endif
+
+#if defined(IOTHUB_CLIENT_METRICS_USE_INTERLOCKED)
+static void atomicAdd(volatile uint64_t* target, uint64_t value)
+{
+    (void)InterlockedExchangeAdd64((LONGLONG volatile*)target, (LONGLONG)value);
+}
+
+static void atomicStore(volatile uint64_t* target, uint64_t value)
+{
+    (void)InterlockedExchange64((LONGLONG volatile*)target, (LONGLONG)value);
+}
+
+static uint64_t atomicLoad(const volatile uint64_t* target)
+{
+    return (uint64_t)InterlockedCompareExchange64((LONGLONG volatile*)target, 0, 0);
+}
+#elif defined(IOTHUB_CLIENT_METRICS_USE_ATOMIC_BUILTINS)
+static void atomicAdd(volatile uint64_t* target, uint64_t value)
+{
+    (void)__atomic_fetch_add(target, value, __ATOMIC_RELAXED);
+}
+
+static void atomicStore(volatile uint64_t* target, uint64_t value)
+{
+    __atomic_store_n(target, value, __ATOMIC_RELAXED);
+}
+
+static uint64_t atomicLoad(const volatile uint64_t* target)
+{
+    return __atomic_load_n(target, __ATOMIC_RELAXED);
+}
+#else
+static void atomicAdd(volatile uint64_t* target, uint64_t value)
+{
+    *target += value;
+}
+
+static void atomicStore(volatile uint64_t* target, uint64_t value)
+{
+    *target = value;
+}
+
+static uint64_t atomicLoad(const volatile uint64_t* target)
+{
+    return *target;
+}
+#endif
+
+DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_METRIC, IOTHUB_CLIENT_METRIC_VALUES);
+DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_HISTOGRAM, IOTHUB_CLIENT_HISTOGRAM_VALUES);
+DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_ALLOCATION_TAG, IOTHUB_CLIENT_ALLOCATION_TAG_VALUES);
+
+#define METRIC_NAME_PREFIX "IOTHUB_CLIENT_METRIC_"
+#define HISTOGRAM_NAME_PREFIX "IOTHUB_CLIENT_HISTOGRAM_"
+#define ALLOCATION_TAG_NAME_PREFIX "IOTHUB_CLIENT_ALLOCATION_TAG_"
+#define EXPORTED_NAME_PREFIX "iothub_client_"
+#define MAX_EXPORTED_NAME_LENGTH 64
+
+static size_t getBucket(uint64_t value)
+{
+    size_t result = 0;
+    while ((value != 0) && (result < IOTHUB_CLIENT_HISTOGRAM_BUCKET_COUNT - 1))
+    {
+        value >>= 1;
+        result++;
+    }
+    return result;
+}
+
+void iothub_client_metrics_init(IOTHUB_CLIENT_METRICS* metrics)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_001: [ If metrics is NULL, iothub_client_metrics_init shall do nothing. ]*/
+    if (metrics != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_002: [ iothub_client_metrics_init shall set all the values, buckets and sums to 0. ]*/
+        (void)memset((void*)metrics, 0, sizeof(IOTHUB_CLIENT_METRICS));
+    }
+}
+
+void iothub_client_metrics_add(IOTHUB_CLIENT_METRICS* metrics, IOTHUB_CLIENT_METRIC metric, uint64_t value)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_003: [ If metrics is NULL or metric is not a IOTHUB_CLIENT_METRIC, iothub_client_metrics_add shall do nothing. ]*/
+    if ((metrics != NULL) && ((size_t)metric < IOTHUB_CLIENT_METRIC_COUNT))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_004: [ iothub_client_metrics_add shall add value to the value of metric with one atomic operation. ]*/
+        atomicAdd(&(metrics->values[metric]), value);
+    }
+}
+
+void iothub_client_metrics_set(IOTHUB_CLIENT_METRICS* metrics, IOTHUB_CLIENT_METRIC metric, uint64_t value)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_005: [ If metrics is NULL or metric is not a IOTHUB_CLIENT_METRIC, iothub_client_metrics_set shall do nothing. ]*/
+    if ((metrics != NULL) && ((size_t)metric < IOTHUB_CLIENT_METRIC_COUNT))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_006: [ iothub_client_metrics_set shall store value as the value of metric with one atomic operation. ]*/
+        atomicStore(&(metrics->values[metric]), value);
+    }
+}
+
+void iothub_client_metrics_record(IOTHUB_CLIENT_METRICS* metrics, IOTHUB_CLIENT_HISTOGRAM histogram, uint64_t value)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_007: [ If metrics is NULL or histogram is not a IOTHUB_CLIENT_HISTOGRAM, iothub_client_metrics_record shall do nothing. ]*/
+    if ((metrics != NULL) && ((size_t)histogram < IOTHUB_CLIENT_HISTOGRAM_COUNT))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_008: [ iothub_client_metrics_record shall add 1 to bucket 0 when value is 0, to bucket i when value is between 2^(i-1) and 2^i-1, or to the last bucket when value is bigger, and add value to the sum of histogram. ]*/
+        atomicAdd(&(metrics->buckets[histogram][getBucket(value)]), 1);
+        atomicAdd(&(metrics->sums[histogram]), value);
+    }
+}
+
+int iothub_client_metrics_get_snapshot(const IOTHUB_CLIENT_METRICS* metrics, IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot)
+{
+    int result;
+    if ((metrics == NULL) || (snapshot == NULL))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_009: [ If metrics or snapshot is NULL, iothub_client_metrics_get_snapshot shall fail and return a non-zero value. ]*/
+        LogError("invalid arguments const IOTHUB_CLIENT_METRICS* metrics=%p, IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot=%p", metrics, snapshot);
+        result = __LINE__;
+    }
+    else
+    {
+        size_t i;
+        size_t j;
+
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_010: [ iothub_client_metrics_get_snapshot shall copy every value, bucket and sum with an atomic read and return 0. ]*/
+        for (i = 0; i < IOTHUB_CLIENT_METRIC_COUNT; i++)
+        {
+            snapshot->values[i] = atomicLoad(&(metrics->values[i]));
+        }
+        for (i = 0; i < IOTHUB_CLIENT_HISTOGRAM_COUNT; i++)
+        {
+            for (j = 0; j < IOTHUB_CLIENT_HISTOGRAM_BUCKET_COUNT; j++)
+            {
+                snapshot->buckets[i][j] = atomicLoad(&(metrics->buckets[i][j]));
+            }
+            snapshot->sums[i] = atomicLoad(&(metrics->sums[i]));
+        }
+        result = 0;
+    }
+    return result;
+}
+
+/*appends like snprintf at the end of what was written so far, keeps counting when the destination is full*/
+static void appendText(char* destination, size_t destinationSize, size_t* length, const char* format, const char* name, const char* label, unsigned long long value)
+{
+    int written = (*length < destinationSize) ?
+        snprintf(destination + *length, destinationSize - *length, format, name, label, value) :
+        snprintf(NULL, 0, format, name, label, value);
+    if (written > 0)
+    {
+        *length += (size_t)written;
+    }
+}
+
+/*IOTHUB_CLIENT_METRIC_EVENTS_QUEUED becomes iothub_client_events_queued, IOTHUB_CLIENT_ALLOCATION_TAG_QUEUE becomes queue when exportedPrefix is ""*/
+static void makeExportedName(char* name, const char* exportedPrefix, const char* enumName, const char* enumPrefix)
+{
+    size_t i = 0;
+    const char* source = enumName + strlen(enumPrefix);
+    (void)strcpy(name, exportedPrefix);
+    i = strlen(name);
+    while ((*source != '\0') && (i < MAX_EXPORTED_NAME_LENGTH - 1))
+    {
+        name[i++] = (char)(((*source >= 'A') && (*source <= 'Z')) ? (*source - 'A' + 'a') : *source);
+        source++;
+    }
+    name[i] = '\0';
+}
+
+size_t iothub_client_metrics_format(const IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot, char* destination, size_t destinationSize)
+{
+    size_t result = 0;
+    if (snapshot == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_011: [ If snapshot is NULL, iothub_client_metrics_format shall return 0. ]*/
+        LogError("invalid argument const IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot=NULL");
+    }
+    else
+    {
+        char name[MAX_EXPORTED_NAME_LENGTH];
+        size_t i;
+
+        if (destination == NULL)
+        {
+            destinationSize = 0;
+        }
+        else if (destinationSize > 0)
+        {
+            destination[0] = '\0';
+        }
+
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_012: [ iothub_client_metrics_format shall write every value as a Prometheus gauge or counter named after its IOTHUB_CLIENT_METRIC in lower case, with iothub_client_ in place of IOTHUB_CLIENT_METRIC_. ]*/
+        for (i = 0; i < IOTHUB_CLIENT_METRIC_COUNT; i++)
+        {
+            makeExportedName(name, EXPORTED_NAME_PREFIX, ENUM_TO_STRING(IOTHUB_CLIENT_METRIC, (IOTHUB_CLIENT_METRIC)i), METRIC_NAME_PREFIX);
+            appendText(destination, destinationSize, &result, "# TYPE %s %s\n", name, (i <= IOTHUB_CLIENT_METRIC_OUTBOUND_QUEUE_BYTES) ? "gauge" : "counter", 0);
+            appendText(destination, destinationSize, &result, "%s%s %llu\n", name, "", (unsigned long long)snapshot->values[i]);
+        }
+
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_013: [ iothub_client_metrics_format shall write every histogram as a Prometheus histogram with cumulative buckets whose "le" label is 2^i-1 for bucket i and +Inf for the last one, followed by its _sum and _count. ]*/
+        for (i = 0; i < IOTHUB_CLIENT_HISTOGRAM_COUNT; i++)
+        {
+            unsigned long long cumulative = 0;
+            size_t j;
+            makeExportedName(name, EXPORTED_NAME_PREFIX, ENUM_TO_STRING(IOTHUB_CLIENT_HISTOGRAM, (IOTHUB_CLIENT_HISTOGRAM)i), HISTOGRAM_NAME_PREFIX);
+            appendText(destination, destinationSize, &result, "# TYPE %s %s\n", name, "histogram", 0);
+            for (j = 0; j < IOTHUB_CLIENT_HISTOGRAM_BUCKET_COUNT; j++)
+            {
+                char label[32];
+                cumulative += snapshot->buckets[i][j];
+                if (j < IOTHUB_CLIENT_HISTOGRAM_BUCKET_COUNT - 1)
+                {
+                    (void)snprintf(label, sizeof(label), "{le=\"%lu\"}", (unsigned long)((1UL << j) - 1));
+                }
+                else
+                {
+                    (void)strcpy(label, "{le=\"+Inf\"}");
+                }
+                appendText(destination, destinationSize, &result, "%s_bucket%s %llu\n", name, label, cumulative);
+            }
+            appendText(destination, destinationSize, &result, "%s_sum%s %llu\n", name, "", (unsigned long long)snapshot->sums[i]);
+            appendText(destination, destinationSize, &result, "%s_count%s %llu\n", name, "", cumulative);
+        }
+    }
+    return result;
+}
+
+size_t iothub_client_metrics_format_allocations(const IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT* snapshot, char* destination, size_t destinationSize)
+{
+    size_t result = 0;
+    if (snapshot == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_014: [ If snapshot is NULL, iothub_client_metrics_format_allocations shall return 0. ]*/
+        LogError("invalid argument const IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT* snapshot=NULL");
+    }
+    else
+    {
+        static const char* const names[] = { "iothub_client_allocated_bytes", "iothub_client_allocated_bytes_peak", "iothub_client_allocated_blocks", "iothub_client_allocations" };
+        const uint64_t* values[] = { snapshot->currentBytes, snapshot->peakBytes, snapshot->liveBlocks, snapshot->allocations };
+        size_t i;
+
+        if (destination == NULL)
+        {
+            destinationSize = 0;
+        }
+        else if (destinationSize > 0)
+        {
+            destination[0] = '\0';
+        }
+
+        /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_015: [ iothub_client_metrics_format_allocations shall write the currentBytes, peakBytes and liveBlocks of snapshot as the Prometheus gauges iothub_client_allocated_bytes, iothub_client_allocated_bytes_peak and iothub_client_allocated_blocks, and its allocations as the counter iothub_client_allocations. ]*/
+        for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+        {
+            size_t tag;
+            appendText(destination, destinationSize, &result, "# TYPE %s %s\n", names[i], (i < 3) ? "gauge" : "counter", 0);
+            for (tag = 0; tag < IOTHUB_CLIENT_ALLOCATION_TAG_COUNT; tag++)
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_METRICS_02_016: [ Every value shall have a tag label whose value is its IOTHUB_CLIENT_ALLOCATION_TAG in lower case without IOTHUB_CLIENT_ALLOCATION_TAG_. ]*/
+                char tagName[MAX_EXPORTED_NAME_LENGTH];
+                char label[MAX_EXPORTED_NAME_LENGTH + 8];
+                makeExportedName(tagName, "", ENUM_TO_STRING(IOTHUB_CLIENT_ALLOCATION_TAG, (IOTHUB_CLIENT_ALLOCATION_TAG)tag), ALLOCATION_TAG_NAME_PREFIX);
+                (void)snprintf(label, sizeof(label), "{tag=\"%s\"}", tagName);
+                appendText(destination, destinationSize, &result, "%s%s %llu\n", names[i], label, (unsigned long long)values[i][tag]);
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,1201 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
+#include "azure_c_shared_utility/map.h"
+
+#include "iothub_client_persistent_queue.h"
+#include "iothub_client_allocations.h"
+
+DEFINE_ENUM_STRINGS(PERSISTENT_QUEUE_RESULT, PERSISTENT_QUEUE_RESULT_VALUES);
+
+/*
+ * On disk, everything is little endian:
+ *  - segment file "segNNNNNNNNNN.log": header {magic "IQS1", reserved, uint64 first sequence number}, then the records
+ *  - record: header {magic "IQR1", uint32 size, uint32 crc32 of the payload}, then the payload
+ *  - "queue.manifest": two slots {magic "IQM1", uint32 crc32 of the rest, uint64 generation, uint64 head segment index,
+ *    uint64 first sequence number of the head segment}. Slots are written alternately, the valid one with the
+ *    highest generation wins, so a torn manifest write leaves the previous one usable.
+ */
+#define SEGMENT_MAGIC               0x31535149 /*"IQS1"*/
+#define RECORD_MAGIC                0x31525149 /*"IQR1"*/
+#define MANIFEST_MAGIC              0x314D5149 /*"IQM1"*/
+#define SEGMENT_HEADER_SIZE         16
+#define RECORD_HEADER_SIZE          12
+#define MANIFEST_SLOT_SIZE          32
+#define MANIFEST_FILE_NAME          "queue.manifest"
+#define SEGMENT_FILE_NAME_FORMAT    "%s/seg%010lu.log"
+/*"/seg" + 10 digits + ".log" + '\0'*/
+#define SEGMENT_FILE_NAME_EXTRA     19
+
+#define MESSAGE_FORMAT_VERSION      1
+#define MESSAGE_CONTENT_BYTEARRAY   0
+#define MESSAGE_CONTENT_STRING      1
+
+typedef struct SEGMENT_TAG
+{
+    DLIST_ENTRY entry;
+    size_t index;
+    uint64_t firstSequenceNumber;
+    size_t recordCount;
+    size_t ackedCount;
+    size_t byteCount; /*records and their headers*/
+} SEGMENT;
+
+typedef struct PERSISTENT_QUEUE_INSTANCE_TAG
+{
+    char* directory;
+    size_t maxBytes;
+    size_t maxMessages;
+    size_t segmentSize;
+    PERSISTENT_QUEUE_OVERFLOW_POLICY overflowPolicy;
+    DLIST_ENTRY segments;
+    size_t nextSegmentIndex;
+    uint64_t nextSequenceNumber;
+    size_t messageCount;
+    size_t byteCount;
+    uint64_t manifestGeneration;
+    /*the segment appends go to, NULL when the next append opens a new one*/
+    SEGMENT* activeSegment;
+    FILE* activeFile;
+    /*read cursor, so that reading consecutive records does not rescan the segment*/
+    SEGMENT* readSegment;
+    FILE* readFile;
+    long readOffset;
+    uint64_t readSequenceNumber;
+    uint32_t crcTable[256];
+} PERSISTENT_QUEUE_INSTANCE;
+
+static void put_uint32(unsigned char* destination, uint32_t value)
+{
+    destination[0] = (unsigned char)(value);
+    destination[1] = (unsigned char)(value >> 8);
+    destination[2] = (unsigned char)(value >> 16);
+    destination[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t get_uint32(const unsigned char* source)
+{
+    return (uint32_t)source[0] | ((uint32_t)source[1] << 8) | ((uint32_t)source[2] << 16) | ((uint32_t)source[3] << 24);
+}
+
+static void put_uint64(unsigned char* destination, uint64_t value)
+{
+    put_uint32(destination, (uint32_t)value);
+    put_uint32(destination + 4, (uint32_t)(value >> 32));
+}
+
+static uint64_t get_uint64(const unsigned char* source)
+{
+    return (uint64_t)get_uint32(source) | ((uint64_t)get_uint32(source + 4) << 32);
+}
+
+static void crc32_init_table(PERSISTENT_QUEUE_INSTANCE* queue)
+{
+    uint32_t i;
+    for (i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        int k;
+        for (k = 0; k < 8; k++)
+        {
+            c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+        }
+        queue->crcTable[i] = c;
+    }
+}
+
+/*crc starts at 0 and can be continued over several buffers*/
+static uint32_t crc32_update(const PERSISTENT_QUEUE_INSTANCE* queue, uint32_t crc, const unsigned char* buffer, size_t size)
+{
+    size_t i;
+    crc = ~crc;
+    for (i = 0; i < size; i++)
+    {
+        crc = queue->crcTable[(crc ^ buffer[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static char* make_file_name(const PERSISTENT_QUEUE_INSTANCE* queue, const char* fileName)
+{
+    char* result = (char*)malloc(strlen(queue->directory) + 1 + strlen(fileName) + 1);
+    if (result == NULL)
+    {
+        LogError("unable to malloc");
+    }
+    else
+    {
+        (void)sprintf(result, "%s/%s", queue->directory, fileName);
+    }
+    return result;
+}
+
+static char* make_segment_file_name(const PERSISTENT_QUEUE_INSTANCE* queue, size_t index)
+{
+    char* result = (char*)malloc(strlen(queue->directory) + SEGMENT_FILE_NAME_EXTRA);
+    if (result == NULL)
+    {
+        LogError("unable to malloc");
+    }
+    else
+    {
+        (void)sprintf(result, SEGMENT_FILE_NAME_FORMAT, queue->directory, (unsigned long)index);
+    }
+    return result;
+}
+
+static FILE* open_segment_file(const PERSISTENT_QUEUE_INSTANCE* queue, size_t index, const char* mode)
+{
+    FILE* result;
+    char* fileName = make_segment_file_name(queue, index);
+    if (fileName == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = fopen(fileName, mode);
+        free(fileName);
+    }
+    return result;
+}
+
+static void remove_segment_file(const PERSISTENT_QUEUE_INSTANCE* queue, size_t index)
+{
+    char* fileName = make_segment_file_name(queue, index);
+    if (fileName != NULL)
+    {
+        if (remove(fileName) != 0)
+        {
+            LogError("unable to remove %s, the file is left behind", fileName);
+        }
+        free(fileName);
+    }
+}
+
+static size_t read_manifest(PERSISTENT_QUEUE_INSTANCE* queue, uint64_t* headFirstSequenceNumber)
+{
+    size_t result = 0;
+    char* fileName = make_file_name(queue, MANIFEST_FILE_NAME);
+
+    *headFirstSequenceNumber = 1;
+    queue->manifestGeneration = 0;
+
+    if (fileName != NULL)
+    {
+        FILE* file = fopen(fileName, "rb");
+        if (file != NULL)
+        {
+            unsigned char slots[2 * MANIFEST_SLOT_SIZE];
+            size_t slotCount = fread(slots, 1, sizeof(slots), file) / MANIFEST_SLOT_SIZE;
+            size_t i;
+            for (i = 0; i < slotCount; i++)
+            {
+                const unsigned char* slot = slots + i * MANIFEST_SLOT_SIZE;
+                if ((get_uint32(slot) == MANIFEST_MAGIC) &&
+                    (get_uint32(slot + 4) == crc32_update(queue, 0, slot + 8, MANIFEST_SLOT_SIZE - 8)) &&
+                    (get_uint64(slot + 8) > queue->manifestGeneration))
+                {
+                    queue->manifestGeneration = get_uint64(slot + 8);
+                    result = (size_t)get_uint64(slot + 16);
+                    *headFirstSequenceNumber = get_uint64(slot + 24);
+                }
+            }
+            (void)fclose(file);
+        }
+        free(fileName);
+    }
+    return result;
+}
+
+/*the manifest is written before any segment file is removed, so it never points past a segment that still holds records*/
+static int write_manifest(PERSISTENT_QUEUE_INSTANCE* queue, size_t headIndex, uint64_t headFirstSequenceNumber)
+{
+    int result;
+    char* fileName = make_file_name(queue, MANIFEST_FILE_NAME);
+    if (fileName == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        FILE* file = fopen(fileName, "r+b");
+        if (file == NULL)
+        {
+            file = fopen(fileName, "wb");
+        }
+
+        if (file == NULL)
+        {
+            LogError("unable to open %s", fileName);
+            result = __LINE__;
+        }
+        else
+        {
+            uint64_t generation = queue->manifestGeneration + 1;
+            unsigned char slot[MANIFEST_SLOT_SIZE];
+            put_uint32(slot, MANIFEST_MAGIC);
+            put_uint64(slot + 8, generation);
+            put_uint64(slot + 16, headIndex);
+            put_uint64(slot + 24, headFirstSequenceNumber);
+            put_uint32(slot + 4, crc32_update(queue, 0, slot + 8, MANIFEST_SLOT_SIZE - 8));
+
+            if ((fseek(file, (long)((generation % 2) * MANIFEST_SLOT_SIZE), SEEK_SET) != 0) ||
+                (fwrite(slot, 1, sizeof(slot), file) != sizeof(slot)) ||
+                (fflush(file) != 0))
+            {
+                LogError("unable to write %s", fileName);
+                result = __LINE__;
+            }
+            else
+            {
+                queue->manifestGeneration = generation;
+                result = 0;
+            }
+            (void)fclose(file);
+        }
+        free(fileName);
+    }
+    return result;
+}
+
+static void close_read_cursor(PERSISTENT_QUEUE_INSTANCE* queue)
+{
+    if (queue->readFile != NULL)
+    {
+        (void)fclose(queue->readFile);
+        queue->readFile = NULL;
+    }
+    queue->readSegment = NULL;
+}
+
+static void seal_active_segment(PERSISTENT_QUEUE_INSTANCE* queue)
+{
+    if (queue->activeFile != NULL)
+    {
+        (void)fclose(queue->activeFile);
+        queue->activeFile = NULL;
+    }
+    queue->activeSegment = NULL;
+}
+
+static uint64_t get_first_sequence_number(const PERSISTENT_QUEUE_INSTANCE* queue)
+{
+    return (queue->segments.Flink == &queue->segments) ?
+        queue->nextSequenceNumber :
+        containingRecord(queue->segments.Flink, SEGMENT, entry)->firstSequenceNumber;
+}
+
+/*removes the oldest segment, acknowledged or not*/
+static int drop_head_segment(PERSISTENT_QUEUE_INSTANCE* queue)
+{
+    int result;
+    SEGMENT* head = containingRecord(queue->segments.Flink, SEGMENT, entry);
+    SEGMENT* next = (head->entry.Flink == &queue->segments) ? NULL : containingRecord(head->entry.Flink, SEGMENT, entry);
+
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_024: [ Before a segment file is removed the manifest shall be updated to point after it. ]*/
+    if (write_manifest(queue, (next == NULL) ? queue->nextSegmentIndex : next->index, (next == NULL) ? queue->nextSequenceNumber : next->firstSequenceNumber) != 0)
+    {
+        LogError("unable to update the manifest, segment %lu is kept", (unsigned long)head->index);
+        result = __LINE__;
+    }
+    else
+    {
+        if (head == queue->activeSegment)
+        {
+            seal_active_segment(queue);
+        }
+        if (head == queue->readSegment)
+        {
+            close_read_cursor(queue);
+        }
+        remove_segment_file(queue, head->index);
+        queue->messageCount -= head->recordCount;
+        queue->byteCount -= head->byteCount;
+        DList_RemoveEntryList(&head->entry);
+        free(head);
+        result = 0;
+    }
+    return result;
+}
+
+/*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_023: [ The leading sealed segments whose records are all acknowledged shall be removed. ]*/
+static void reclaim_acked_segments(PERSISTENT_QUEUE_INSTANCE* queue)
+{
+    while (queue->segments.Flink != &queue->segments)
+    {
+        SEGMENT* head = containingRecord(queue->segments.Flink, SEGMENT, entry);
+        if ((head == queue->activeSegment) ||
+            (head->ackedCount < head->recordCount) ||
+            (drop_head_segment(queue) != 0))
+        {
+            break;
+        }
+    }
+}
+
+/*scans a segment left by a previous run, the first torn or corrupted record ends it*/
+static SEGMENT* recover_segment(PERSISTENT_QUEUE_INSTANCE* queue, FILE* file, size_t index)
+{
+    SEGMENT* result = (SEGMENT*)malloc(sizeof(SEGMENT));
+    if (result == NULL)
+    {
+        LogError("unable to malloc");
+    }
+    else
+    {
+        unsigned char header[SEGMENT_HEADER_SIZE];
+        long fileSize;
+
+        result->index = index;
+        result->firstSequenceNumber = queue->nextSequenceNumber;
+        result->recordCount = 0;
+        result->ackedCount = 0;
+        result->byteCount = 0;
+
+        if ((fseek(file, 0, SEEK_END) != 0) ||
+            ((fileSize = ftell(file)) < 0) ||
+            (fseek(file, 0, SEEK_SET) != 0) ||
+            (fread(header, 1, sizeof(header), file) != sizeof(header)) ||
+            (get_uint32(header) != SEGMENT_MAGIC))
+        {
+            /*a segment torn while it was created holds no records*/
+            LogError("segment %lu has no valid header, it holds no records", (unsigned long)index);
+        }
+        else
+        {
+            long offset = SEGMENT_HEADER_SIZE;
+            if (get_uint64(header + 8) >= queue->nextSequenceNumber)
+            {
+                result->firstSequenceNumber = get_uint64(header + 8);
+            }
+
+            for (;;)
+            {
+                unsigned char recordHeader[RECORD_HEADER_SIZE];
+                unsigned char chunk[256];
+                uint32_t size;
+                uint32_t crc = 0;
+                uint32_t remaining;
+
+                if ((fread(recordHeader, 1, sizeof(recordHeader), file) != sizeof(recordHeader)) ||
+                    (get_uint32(recordHeader) != RECORD_MAGIC) ||
+                    ((size = get_uint32(recordHeader + 4)) > (uint32_t)(fileSize - offset - RECORD_HEADER_SIZE)))
+                {
+                    break;
+                }
+
+                remaining = size;
+                while (remaining > 0)
+                {
+                    size_t toRead = (remaining < sizeof(chunk)) ? remaining : sizeof(chunk);
+                    if (fread(chunk, 1, toRead, file) != toRead)
+                    {
+                        break;
+                    }
+                    crc = crc32_update(queue, crc, chunk, toRead);
+                    remaining -= (uint32_t)toRead;
+                }
+
+                if ((remaining != 0) || (crc != get_uint32(recordHeader + 8)))
+                {
+                    LogError("segment %lu ends with a corrupted record after %lu records", (unsigned long)index, (unsigned long)result->recordCount);
+                    break;
+                }
+
+                result->recordCount++;
+                result->byteCount += RECORD_HEADER_SIZE + size;
+                offset += RECORD_HEADER_SIZE + (long)size;
+            }
+        }
+
+        queue->nextSequenceNumber = result->firstSequenceNumber + result->recordCount;
+        queue->messageCount += result->recordCount;
+        queue->byteCount += result->byteCount;
+    }
+    return result;
+}
+
+static int recover(PERSISTENT_QUEUE_INSTANCE* queue)
+{
+    int result = 0;
+    size_t index = read_manifest(queue, &queue->nextSequenceNumber);
+    size_t orphan;
+    FILE* file;
+
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_007: [ Segment files before the head named by the manifest are leftovers of an interrupted reclaim and shall be removed. ]*/
+    for (orphan = index; orphan > 0; orphan--)
+    {
+        char* fileName = make_segment_file_name(queue, orphan - 1);
+        int removeResult = (fileName == NULL) ? -1 : remove(fileName);
+        free(fileName);
+        if (removeResult != 0)
+        {
+            break;
+        }
+    }
+
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_005: [ persistent_queue_create shall recover the segments starting at the head named by the manifest, up to the first missing segment file. ]*/
+    while ((file = open_segment_file(queue, index, "rb")) != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_006: [ A torn or corrupted record shall end its segment, the records before it are kept. ]*/
+        SEGMENT* segment = recover_segment(queue, file, index);
+        (void)fclose(file);
+        if (segment == NULL)
+        {
+            result = __LINE__;
+            break;
+        }
+        DList_InsertTailList(&queue->segments, &segment->entry);
+        index++;
+    }
+
+    queue->nextSegmentIndex = index;
+    return result;
+}
+
+static void free_segments(PERSISTENT_QUEUE_INSTANCE* queue)
+{
+    PDLIST_ENTRY entry;
+    while ((entry = DList_RemoveHeadList(&queue->segments)) != &queue->segments)
+    {
+        free(containingRecord(entry, SEGMENT, entry));
+    }
+}
+
+PERSISTENT_QUEUE_HANDLE persistent_queue_create(const PERSISTENT_QUEUE_CONFIG* config)
+{
+    PERSISTENT_QUEUE_INSTANCE* result;
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_001: [ If config or config->directory is NULL, or config->overflowPolicy is not a PERSISTENT_QUEUE_OVERFLOW_POLICY value, persistent_queue_create shall fail and return NULL. ]*/
+    if ((config == NULL) ||
+        (config->directory == NULL) ||
+        ((int)config->overflowPolicy < (int)PERSISTENT_QUEUE_OVERFLOW_REJECT) ||
+        ((int)config->overflowPolicy > (int)PERSISTENT_QUEUE_OVERFLOW_BLOCK))
+    {
+        LogError("invalid argument const PERSISTENT_QUEUE_CONFIG* config=%p", config);
+        result = NULL;
+    }
+    else
+    {
+        result = (PERSISTENT_QUEUE_INSTANCE*)malloc(sizeof(PERSISTENT_QUEUE_INSTANCE));
+        if (result == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_003: [ If any failure occurs, persistent_queue_create shall fail and return NULL. ]*/
+            LogError("unable to malloc");
+        }
+        else if ((result->directory = (char*)malloc(strlen(config->directory) + 1)) == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_003: [ If any failure occurs, persistent_queue_create shall fail and return NULL. ]*/
+            LogError("unable to malloc");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_002: [ persistent_queue_create shall copy the configuration, a segmentSize of 0 meaning PERSISTENT_QUEUE_DEFAULT_SEGMENT_SIZE. ]*/
+            (void)strcpy(result->directory, config->directory);
+            result->maxBytes = config->maxBytes;
+            result->maxMessages = config->maxMessages;
+            result->segmentSize = (config->segmentSize == 0) ? PERSISTENT_QUEUE_DEFAULT_SEGMENT_SIZE : config->segmentSize;
+            result->overflowPolicy = config->overflowPolicy;
+            DList_InitializeListHead(&result->segments);
+            result->messageCount = 0;
+            result->byteCount = 0;
+            result->activeSegment = NULL;
+            result->activeFile = NULL;
+            result->readSegment = NULL;
+            result->readFile = NULL;
+            result->readOffset = 0;
+            result->readSequenceNumber = 0;
+            crc32_init_table(result);
+
+            if (recover(result) != 0)
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_003: [ If any failure occurs, persistent_queue_create shall fail and return NULL. ]*/
+                LogError("unable to recover the queue in %s", config->directory);
+                free_segments(result);
+                free(result->directory);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_004: [ All the recovered segments are sealed, the first append shall open a new segment. ]*/
+                reclaim_acked_segments(result);
+            }
+        }
+    }
+    return result;
+}
+
+void persistent_queue_destroy(PERSISTENT_QUEUE_HANDLE handle)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_008: [ If handle is NULL, persistent_queue_destroy shall do nothing. ]*/
+    if (handle != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_009: [ persistent_queue_destroy shall close the files and free the queue, leaving the segment files on disk. ]*/
+        close_read_cursor(handle);
+        seal_active_segment(handle);
+        free_segments(handle);
+        free(handle->directory);
+        free(handle);
+    }
+}
+
+static int open_new_segment(PERSISTENT_QUEUE_INSTANCE* queue)
+{
+    int result;
+    SEGMENT* segment = (SEGMENT*)malloc(sizeof(SEGMENT));
+    if (segment == NULL)
+    {
+        LogError("unable to malloc");
+        result = __LINE__;
+    }
+    else
+    {
+        FILE* file = open_segment_file(queue, queue->nextSegmentIndex, "wb");
+        if (file == NULL)
+        {
+            LogError("unable to create segment %lu", (unsigned long)queue->nextSegmentIndex);
+            free(segment);
+            result = __LINE__;
+        }
+        else
+        {
+            unsigned char header[SEGMENT_HEADER_SIZE];
+            put_uint32(header, SEGMENT_MAGIC);
+            put_uint32(header + 4, 0);
+            put_uint64(header + 8, queue->nextSequenceNumber);
+            if ((fwrite(header, 1, sizeof(header), file) != sizeof(header)) ||
+                (fflush(file) != 0))
+            {
+                LogError("unable to write the header of segment %lu", (unsigned long)queue->nextSegmentIndex);
+                (void)fclose(file);
+                remove_segment_file(queue, queue->nextSegmentIndex);
+                free(segment);
+                result = __LINE__;
+            }
+            else
+            {
+                segment->index = queue->nextSegmentIndex++;
+                segment->firstSequenceNumber = queue->nextSequenceNumber;
+                segment->recordCount = 0;
+                segment->ackedCount = 0;
+                segment->byteCount = 0;
+                DList_InsertTailList(&queue->segments, &segment->entry);
+                queue->activeSegment = segment;
+                queue->activeFile = file;
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+static int record_fits(const PERSISTENT_QUEUE_INSTANCE* queue, size_t recordBytes)
+{
+    return
+        ((queue->maxMessages == 0) || (queue->messageCount < queue->maxMessages)) &&
+        ((queue->maxBytes == 0) || (queue->byteCount + recordBytes <= queue->maxBytes));
+}
+
+PERSISTENT_QUEUE_RESULT persistent_queue_append(PERSISTENT_QUEUE_HANDLE handle, const unsigned char* record, size_t size, uint64_t* sequenceNumber)
+{
+    PERSISTENT_QUEUE_RESULT result;
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_010: [ If handle or sequenceNumber is NULL, or record is NULL and size is not 0, or size does not fit in 32 bits, persistent_queue_append shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+    if ((handle == NULL) ||
+        (sequenceNumber == NULL) ||
+        ((record == NULL) && (size != 0)) ||
+        (size > (size_t)(UINT32_MAX - RECORD_HEADER_SIZE)))
+    {
+        LogError("invalid argument PERSISTENT_QUEUE_HANDLE handle=%p, const unsigned char* record=%p, size_t size=%lu, uint64_t* sequenceNumber=%p", handle, record, (unsigned long)size, sequenceNumber);
+        result = PERSISTENT_QUEUE_ERROR;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_011: [ If the record alone is bigger than maxBytes, persistent_queue_append shall return PERSISTENT_QUEUE_FULL. ]*/
+    else if ((handle->maxBytes != 0) && (RECORD_HEADER_SIZE + size > handle->maxBytes))
+    {
+        LogError("a record of %lu bytes can never fit in a queue of %lu bytes", (unsigned long)size, (unsigned long)handle->maxBytes);
+        result = PERSISTENT_QUEUE_FULL;
+    }
+    else
+    {
+        size_t recordBytes = RECORD_HEADER_SIZE + size;
+
+        reclaim_acked_segments(handle);
+
+        if (!record_fits(handle, recordBytes) && (handle->overflowPolicy == PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST))
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_013: [ If the policy is PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST, persistent_queue_append shall drop the oldest segments, acknowledged or not, until the record fits. ]*/
+            while (!record_fits(handle, recordBytes) &&
+                (handle->segments.Flink != &handle->segments) &&
+                (drop_head_segment(handle) == 0))
+            {
+                LogError("queue full, dropped the oldest segment");
+            }
+        }
+
+        if (!record_fits(handle, recordBytes))
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_012: [ If the record does not fit under maxMessages and maxBytes and the policy is PERSISTENT_QUEUE_OVERFLOW_REJECT or PERSISTENT_QUEUE_OVERFLOW_BLOCK, persistent_queue_append shall return PERSISTENT_QUEUE_FULL. ]*/
+            result = PERSISTENT_QUEUE_FULL;
+        }
+        /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_014: [ If there is no active segment, persistent_queue_append shall create a new segment file starting with the next sequence number. ]*/
+        else if ((handle->activeSegment == NULL) && (open_new_segment(handle) != 0))
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_016: [ If any failure occurs, persistent_queue_append shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+            result = PERSISTENT_QUEUE_ERROR;
+        }
+        else
+        {
+            unsigned char header[RECORD_HEADER_SIZE];
+            put_uint32(header, RECORD_MAGIC);
+            put_uint32(header + 4, (uint32_t)size);
+            put_uint32(header + 8, crc32_update(handle, 0, record, size));
+
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_015: [ persistent_queue_append shall write the record header and the record at the end of the active segment and flush them. ]*/
+            if ((fwrite(header, 1, sizeof(header), handle->activeFile) != sizeof(header)) ||
+                ((size > 0) && (fwrite(record, 1, size, handle->activeFile) != size)) ||
+                (fflush(handle->activeFile) != 0))
+            {
+                /*what was partially written is past the recorded end of the segment, sealing it keeps it from being followed by valid records*/
+                /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_016: [ If any failure occurs, persistent_queue_append shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+                LogError("unable to write to segment %lu", (unsigned long)handle->activeSegment->index);
+                seal_active_segment(handle);
+                result = PERSISTENT_QUEUE_ERROR;
+            }
+            else
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_017: [ persistent_queue_append shall give the record the next sequence number, starting at 1, and return PERSISTENT_QUEUE_OK. ]*/
+                *sequenceNumber = handle->nextSequenceNumber++;
+                handle->activeSegment->recordCount++;
+                handle->activeSegment->byteCount += recordBytes;
+                handle->messageCount++;
+                handle->byteCount += recordBytes;
+
+                /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_018: [ Once the active segment holds segmentSize bytes it shall be sealed. ]*/
+                if (SEGMENT_HEADER_SIZE + handle->activeSegment->byteCount >= handle->segmentSize)
+                {
+                    seal_active_segment(handle);
+                }
+                result = PERSISTENT_QUEUE_OK;
+            }
+        }
+    }
+    return result;
+}
+
+static int open_read_cursor(PERSISTENT_QUEUE_INSTANCE* queue, SEGMENT* segment)
+{
+    int result;
+    close_read_cursor(queue);
+    if ((queue->readFile = open_segment_file(queue, segment->index, "rb")) == NULL)
+    {
+        LogError("unable to open segment %lu", (unsigned long)segment->index);
+        result = __LINE__;
+    }
+    else
+    {
+        queue->readSegment = segment;
+        queue->readOffset = SEGMENT_HEADER_SIZE;
+        queue->readSequenceNumber = segment->firstSequenceNumber;
+        result = 0;
+    }
+    return result;
+}
+
+/*reads the record at the cursor, or only its header when record is NULL, and moves the cursor past it. The record is freed by the caller of persistent_queue_read*/
+static int read_at_cursor(PERSISTENT_QUEUE_INSTANCE* queue, unsigned char** record, size_t* size)
+{
+    int result;
+    unsigned char header[RECORD_HEADER_SIZE];
+    if ((fseek(queue->readFile, queue->readOffset, SEEK_SET) != 0) ||
+        (fread(header, 1, sizeof(header), queue->readFile) != sizeof(header)) ||
+        (get_uint32(header) != RECORD_MAGIC))
+    {
+        LogError("unable to read record %lu of segment %lu", (unsigned long)(queue->readSequenceNumber - queue->readSegment->firstSequenceNumber), (unsigned long)queue->readSegment->index);
+        result = __LINE__;
+    }
+    else
+    {
+        uint32_t recordSize = get_uint32(header + 4);
+        if (record == NULL)
+        {
+            result = 0;
+        }
+        else if ((*record = (unsigned char*)IOTHUB_CLIENT_MALLOC_CALLER_OWNED((recordSize == 0) ? 1 : recordSize)) == NULL)
+        {
+            LogError("unable to malloc");
+            result = __LINE__;
+        }
+        else if ((fread(*record, 1, recordSize, queue->readFile) != recordSize) ||
+            (crc32_update(queue, 0, *record, recordSize) != get_uint32(header + 8)))
+        {
+            LogError("record %lu of segment %lu is corrupted", (unsigned long)(queue->readSequenceNumber - queue->readSegment->firstSequenceNumber), (unsigned long)queue->readSegment->index);
+            free(*record);
+            *record = NULL;
+            result = __LINE__;
+        }
+        else
+        {
+            *size = recordSize;
+            result = 0;
+        }
+
+        if (result == 0)
+        {
+            queue->readOffset += RECORD_HEADER_SIZE + (long)recordSize;
+            queue->readSequenceNumber++;
+        }
+    }
+    return result;
+}
+
+/*places the cursor on the first record whose sequence number is at least fromSequenceNumber, returns non-zero if there is none*/
+static int seek_read_cursor(PERSISTENT_QUEUE_INSTANCE* queue, uint64_t fromSequenceNumber)
+{
+    int result;
+
+    if ((queue->readSegment == NULL) || (queue->readSequenceNumber > fromSequenceNumber))
+    {
+        PDLIST_ENTRY entry;
+        SEGMENT* found = NULL;
+        for (entry = queue->segments.Flink; entry != &queue->segments; entry = entry->Flink)
+        {
+            SEGMENT* segment = containingRecord(entry, SEGMENT, entry);
+            if (fromSequenceNumber < segment->firstSequenceNumber + segment->recordCount)
+            {
+                found = segment;
+                break;
+            }
+        }
+
+        result = ((found == NULL) || (open_read_cursor(queue, found) != 0)) ? __LINE__ : 0;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    while (result == 0)
+    {
+        if (queue->readSequenceNumber >= queue->readSegment->firstSequenceNumber + queue->readSegment->recordCount)
+        {
+            /*the segment is exhausted, the next one follows it*/
+            PDLIST_ENTRY next = queue->readSegment->entry.Flink;
+            if (next == &queue->segments)
+            {
+                close_read_cursor(queue);
+                result = __LINE__;
+            }
+            else if (open_read_cursor(queue, containingRecord(next, SEGMENT, entry)) != 0)
+            {
+                result = __LINE__;
+            }
+        }
+        else if (queue->readSequenceNumber < fromSequenceNumber)
+        {
+            if (read_at_cursor(queue, NULL, NULL) != 0)
+            {
+                close_read_cursor(queue);
+                result = __LINE__;
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+PERSISTENT_QUEUE_RESULT persistent_queue_read(PERSISTENT_QUEUE_HANDLE handle, uint64_t fromSequenceNumber, unsigned char** record, size_t* size, uint64_t* sequenceNumber)
+{
+    PERSISTENT_QUEUE_RESULT result;
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_019: [ If handle, record, size or sequenceNumber is NULL, persistent_queue_read shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+    if ((handle == NULL) ||
+        (record == NULL) ||
+        (size == NULL) ||
+        (sequenceNumber == NULL))
+    {
+        LogError("invalid argument PERSISTENT_QUEUE_HANDLE handle=%p, unsigned char** record=%p, size_t* size=%p, uint64_t* sequenceNumber=%p", handle, record, size, sequenceNumber);
+        result = PERSISTENT_QUEUE_ERROR;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_020: [ If there is no record with a sequence number of at least fromSequenceNumber, persistent_queue_read shall return PERSISTENT_QUEUE_EMPTY. ]*/
+    else if ((fromSequenceNumber >= handle->nextSequenceNumber) ||
+        (seek_read_cursor(handle, fromSequenceNumber) != 0))
+    {
+        result = PERSISTENT_QUEUE_EMPTY;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_021: [ persistent_queue_read shall return a copy of the first record whose sequence number is at least fromSequenceNumber, its size and its sequence number. ]*/
+        uint64_t readSequenceNumber = handle->readSequenceNumber;
+        if (read_at_cursor(handle, record, size) != 0)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_022: [ If the record cannot be read or its crc does not match, persistent_queue_read shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+            close_read_cursor(handle);
+            result = PERSISTENT_QUEUE_ERROR;
+        }
+        else
+        {
+            *sequenceNumber = readSequenceNumber;
+            result = PERSISTENT_QUEUE_OK;
+        }
+    }
+    return result;
+}
+
+int persistent_queue_ack(PERSISTENT_QUEUE_HANDLE handle, uint64_t sequenceNumber)
+{
+    int result;
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_025: [ If handle is NULL or sequenceNumber was never given to a record, persistent_queue_ack shall fail and return a non-zero value. ]*/
+    if ((handle == NULL) ||
+        (sequenceNumber == 0) ||
+        (sequenceNumber >= handle->nextSequenceNumber))
+    {
+        LogError("invalid argument PERSISTENT_QUEUE_HANDLE handle=%p, uint64_t sequenceNumber=%llu", handle, (unsigned long long)sequenceNumber);
+        result = __LINE__;
+    }
+    else
+    {
+        PDLIST_ENTRY entry;
+        for (entry = handle->segments.Flink; entry != &handle->segments; entry = entry->Flink)
+        {
+            SEGMENT* segment = containingRecord(entry, SEGMENT, entry);
+            if ((sequenceNumber >= segment->firstSequenceNumber) &&
+                (sequenceNumber < segment->firstSequenceNumber + segment->recordCount))
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_026: [ persistent_queue_ack shall count the record as acknowledged in its segment and reclaim the fully acknowledged leading segments. ]*/
+                segment->ackedCount++;
+                break;
+            }
+        }
+
+        /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_027: [ Acknowledging a record that was dropped shall succeed and do nothing. ]*/
+        reclaim_acked_segments(handle);
+        result = 0;
+    }
+    return result;
+}
+
+int persistent_queue_get_range(PERSISTENT_QUEUE_HANDLE handle, uint64_t* firstSequenceNumber, uint64_t* nextSequenceNumber)
+{
+    int result;
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_028: [ If handle, firstSequenceNumber or nextSequenceNumber is NULL, persistent_queue_get_range shall fail and return a non-zero value. ]*/
+    if ((handle == NULL) ||
+        (firstSequenceNumber == NULL) ||
+        (nextSequenceNumber == NULL))
+    {
+        LogError("invalid argument PERSISTENT_QUEUE_HANDLE handle=%p, uint64_t* firstSequenceNumber=%p, uint64_t* nextSequenceNumber=%p", handle, firstSequenceNumber, nextSequenceNumber);
+        result = __LINE__;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_029: [ persistent_queue_get_range shall return the sequence number of the oldest record kept and the one the next record will get. ]*/
+        *firstSequenceNumber = get_first_sequence_number(handle);
+        *nextSequenceNumber = handle->nextSequenceNumber;
+        result = 0;
+    }
+    return result;
+}
+
+int persistent_queue_get_usage(PERSISTENT_QUEUE_HANDLE handle, size_t* messageCount, size_t* byteCount)
+{
+    int result;
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_030: [ If handle, messageCount or byteCount is NULL, persistent_queue_get_usage shall fail and return a non-zero value. ]*/
+    if ((handle == NULL) ||
+        (messageCount == NULL) ||
+        (byteCount == NULL))
+    {
+        LogError("invalid argument PERSISTENT_QUEUE_HANDLE handle=%p, size_t* messageCount=%p, size_t* byteCount=%p", handle, messageCount, byteCount);
+        result = __LINE__;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_031: [ persistent_queue_get_usage shall return the number of records and of bytes kept on disk. ]*/
+        *messageCount = handle->messageCount;
+        *byteCount = handle->byteCount;
+        result = 0;
+    }
+    return result;
+}
+
+static size_t string_field_size(const char* value)
+{
+    return 4 + ((value == NULL) ? 0 : strlen(value) + 1);
+}
+
+static unsigned char* put_string_field(unsigned char* destination, const char* value)
+{
+    if (value == NULL)
+    {
+        put_uint32(destination, 0);
+        destination += 4;
+    }
+    else
+    {
+        size_t length = strlen(value) + 1;
+        put_uint32(destination, (uint32_t)length);
+        (void)memcpy(destination + 4, value, length);
+        destination += 4 + length;
+    }
+    return destination;
+}
+
+/*returns the string in place, NULL when absent; *isValid is cleared when the field runs past the record or is not terminated*/
+static const char* get_string_field(const unsigned char** source, const unsigned char* end, int* isValid)
+{
+    const char* result = NULL;
+    if (end - *source < 4)
+    {
+        *isValid = 0;
+    }
+    else
+    {
+        uint32_t length = get_uint32(*source);
+        *source += 4;
+        if (length > 0)
+        {
+            if (((size_t)(end - *source) < length) || ((*source)[length - 1] != '\0'))
+            {
+                *isValid = 0;
+            }
+            else
+            {
+                result = (const char*)*source;
+                *source += length;
+            }
+        }
+    }
+    return result;
+}
+
+static unsigned char* serialize_message(IOTHUB_MESSAGE_HANDLE message, size_t* size)
+{
+    unsigned char* result;
+    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message);
+    const unsigned char* content = NULL;
+    size_t contentSize = 0;
+    const char* const* keys = NULL;
+    const char* const* values = NULL;
+    size_t propertyCount = 0;
+    MAP_HANDLE properties;
+
+    if (contentType == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        if (IoTHubMessage_GetByteArray(message, &content, &contentSize) != IOTHUB_MESSAGE_OK)
+        {
+            LogError("unable to IoTHubMessage_GetByteArray");
+            contentType = IOTHUBMESSAGE_UNKNOWN;
+        }
+    }
+    else if (contentType == IOTHUBMESSAGE_STRING)
+    {
+        const char* text = IoTHubMessage_GetString(message);
+        if (text == NULL)
+        {
+            LogError("unable to IoTHubMessage_GetString");
+            contentType = IOTHUBMESSAGE_UNKNOWN;
+        }
+        else
+        {
+            content = (const unsigned char*)text;
+            contentSize = strlen(text) + 1;
+        }
+    }
+
+    if ((contentType != IOTHUBMESSAGE_BYTEARRAY) && (contentType != IOTHUBMESSAGE_STRING))
+    {
+        LogError("the message content cannot be persisted");
+        result = NULL;
+    }
+    else if (((properties = IoTHubMessage_Properties(message)) == NULL) ||
+        (Map_GetInternals(properties, &keys, &values, &propertyCount) != MAP_OK))
+    {
+        LogError("unable to get the message properties");
+        result = NULL;
+    }
+    else
+    {
+        const char* messageId = IoTHubMessage_GetMessageId(message);
+        const char* correlationId = IoTHubMessage_GetCorrelationId(message);
+        size_t i;
+
+        *size = 2 + 4 + contentSize + string_field_size(messageId) + string_field_size(correlationId) + 4;
+        for (i = 0; i < propertyCount; i++)
+        {
+            *size += string_field_size(keys[i]) + string_field_size(values[i]);
+        }
+
+        if ((result = (unsigned char*)malloc(*size)) == NULL)
+        {
+            LogError("unable to malloc");
+        }
+        else
+        {
+            unsigned char* current = result;
+            *current++ = MESSAGE_FORMAT_VERSION;
+            *current++ = (contentType == IOTHUBMESSAGE_BYTEARRAY) ? MESSAGE_CONTENT_BYTEARRAY : MESSAGE_CONTENT_STRING;
+            put_uint32(current, (uint32_t)contentSize);
+            current += 4;
+            if (contentSize > 0)
+            {
+                (void)memcpy(current, content, contentSize);
+                current += contentSize;
+            }
+            current = put_string_field(current, messageId);
+            current = put_string_field(current, correlationId);
+            put_uint32(current, (uint32_t)propertyCount);
+            current += 4;
+            for (i = 0; i < propertyCount; i++)
+            {
+                current = put_string_field(current, keys[i]);
+                current = put_string_field(current, values[i]);
+            }
+        }
+    }
+    return result;
+}
+
+static IOTHUB_MESSAGE_HANDLE deserialize_message(const unsigned char* record, size_t size)
+{
+    IOTHUB_MESSAGE_HANDLE result;
+    const unsigned char* end = record + size;
+    const unsigned char* current = record + 6;
+    uint32_t contentSize;
+
+    if ((size < 6) ||
+        (record[0] != MESSAGE_FORMAT_VERSION) ||
+        (record[1] > MESSAGE_CONTENT_STRING) ||
+        ((contentSize = get_uint32(record + 2)) > size - 6) ||
+        ((record[1] == MESSAGE_CONTENT_STRING) && ((contentSize == 0) || (current[contentSize - 1] != '\0'))))
+    {
+        LogError("the record is not a persisted message");
+        result = NULL;
+    }
+    else
+    {
+        result = (record[1] == MESSAGE_CONTENT_BYTEARRAY) ?
+            IoTHubMessage_CreateFromByteArray(current, contentSize) :
+            IoTHubMessage_CreateFromString((const char*)current);
+        if (result == NULL)
+        {
+            LogError("unable to create the message");
+        }
+        else
+        {
+            int isValid = 1;
+            const char* messageId;
+            const char* correlationId;
+            current += contentSize;
+
+            messageId = get_string_field(&current, end, &isValid);
+            correlationId = get_string_field(&current, end, &isValid);
+            if ((!isValid) ||
+                ((messageId != NULL) && (IoTHubMessage_SetMessageId(result, messageId) != IOTHUB_MESSAGE_OK)) ||
+                ((correlationId != NULL) && (IoTHubMessage_SetCorrelationId(result, correlationId) != IOTHUB_MESSAGE_OK)) ||
+                (end - current < 4))
+            {
+                isValid = 0;
+            }
+            else
+            {
+                uint32_t propertyCount = get_uint32(current);
+                MAP_HANDLE properties = IoTHubMessage_Properties(result);
+                uint32_t i;
+                current += 4;
+                for (i = 0; (i < propertyCount) && isValid; i++)
+                {
+                    const char* key = get_string_field(&current, end, &isValid);
+                    const char* value = get_string_field(&current, end, &isValid);
+                    if ((!isValid) ||
+                        (key == NULL) ||
+                        (value == NULL) ||
+                        (properties == NULL) ||
+                        (Map_AddOrUpdate(properties, key, value) != MAP_OK))
+                    {
+                        isValid = 0;
+                    }
+                }
+            }
+
+            if (!isValid)
+            {
+                LogError("unable to restore the persisted message");
+                IoTHubMessage_Destroy(result);
+                result = NULL;
+            }
+        }
+    }
+    return result;
+}
+
+PERSISTENT_QUEUE_RESULT persistent_queue_append_message(PERSISTENT_QUEUE_HANDLE handle, IOTHUB_MESSAGE_HANDLE message, uint64_t* sequenceNumber)
+{
+    PERSISTENT_QUEUE_RESULT result;
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_032: [ If handle, message or sequenceNumber is NULL, persistent_queue_append_message shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+    if ((handle == NULL) ||
+        (message == NULL) ||
+        (sequenceNumber == NULL))
+    {
+        LogError("invalid argument PERSISTENT_QUEUE_HANDLE handle=%p, IOTHUB_MESSAGE_HANDLE message=%p, uint64_t* sequenceNumber=%p", handle, message, sequenceNumber);
+        result = PERSISTENT_QUEUE_ERROR;
+    }
+    else
+    {
+        size_t size;
+        /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_033: [ persistent_queue_append_message shall serialize the content, the content type, the message id, the correlation id and the properties of the message and append them as one record. ]*/
+        unsigned char* record = serialize_message(message, &size);
+        if (record == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_034: [ If serializing the message fails, persistent_queue_append_message shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+            result = PERSISTENT_QUEUE_ERROR;
+        }
+        else
+        {
+            result = persistent_queue_append(handle, record, size, sequenceNumber);
+            free(record);
+        }
+    }
+    return result;
+}
+
+PERSISTENT_QUEUE_RESULT persistent_queue_read_message(PERSISTENT_QUEUE_HANDLE handle, uint64_t fromSequenceNumber, IOTHUB_MESSAGE_HANDLE* message, uint64_t* sequenceNumber)
+{
+    PERSISTENT_QUEUE_RESULT result;
+    /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_035: [ If handle, message or sequenceNumber is NULL, persistent_queue_read_message shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+    if ((handle == NULL) ||
+        (message == NULL) ||
+        (sequenceNumber == NULL))
+    {
+        LogError("invalid argument PERSISTENT_QUEUE_HANDLE handle=%p, IOTHUB_MESSAGE_HANDLE* message=%p, uint64_t* sequenceNumber=%p", handle, message, sequenceNumber);
+        result = PERSISTENT_QUEUE_ERROR;
+    }
+    else
+    {
+        unsigned char* record;
+        size_t size;
+        result = persistent_queue_read(handle, fromSequenceNumber, &record, &size, sequenceNumber);
+        if (result == PERSISTENT_QUEUE_OK)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_036: [ persistent_queue_read_message shall read the record like persistent_queue_read and rebuild the message from it. ]*/
+            if ((*message = deserialize_message(record, size)) == NULL)
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_037: [ If the message cannot be rebuilt, persistent_queue_read_message shall fail and return PERSISTENT_QUEUE_ERROR. The sequence number of the record is still returned. ]*/
+                result = PERSISTENT_QUEUE_ERROR;
+            }
+            free(record);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,283 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/agenttime.h"
+
+#include "iothub_client_retry_control.h"
+
+/*first wait of the backoff policies and step of the linear one*/
+#define RETRY_CONTROL_BASE_DELAY_IN_MS      1000
+/*wait of IOTHUB_CLIENT_RETRY_INTERVAL*/
+#define RETRY_CONTROL_INTERVAL_IN_MS        5000
+/*no policy waits longer than this between two attempts*/
+#define RETRY_CONTROL_MAX_DELAY_IN_MS       60000
+
+typedef struct RETRY_CONTROL_INSTANCE_TAG
+{
+    IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+    size_t retryTimeoutLimitInSeconds;
+    TICK_COUNTER_HANDLE tickCounter;
+    size_t attemptCount;
+    tickcounter_ms_t firstAttemptTime;
+    tickcounter_ms_t lastAttemptTime;
+    tickcounter_ms_t nextDelay;
+    uint32_t randomState;
+    bool isStopLogged;
+} RETRY_CONTROL_INSTANCE;
+
+static uint32_t getNextRandom(RETRY_CONTROL_INSTANCE* retryControl)
+{
+    /*xorshift32, private to the instance so that the application's rand() sequence is left alone*/
+    uint32_t x = retryControl->randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    retryControl->randomState = x;
+    return x;
+}
+
+static uint32_t createRandomSeed(RETRY_CONTROL_INSTANCE* retryControl, const char* deviceId)
+{
+    /*devices restarted by the same outage can have the same clock and the same heap layout, the device id is what tells them apart*/
+    uint32_t result = 2166136261u;
+    tickcounter_ms_t now;
+
+    if (deviceId != NULL)
+    {
+        const char* c;
+        for (c = deviceId; *c != '\0'; c++)
+        {
+            result = (result ^ (uint32_t)(unsigned char)*c) * 16777619u;
+        }
+    }
+
+    result ^= (uint32_t)(uintptr_t)retryControl;
+    result ^= (uint32_t)get_time(NULL);
+    if (tickcounter_get_current_ms(retryControl->tickCounter, &now) == 0)
+    {
+        result ^= (uint32_t)now;
+    }
+
+    return (result == 0) ? 0x9E3779B9u : result;
+}
+
+static tickcounter_ms_t getExponentialDelay(size_t attemptCount)
+{
+    tickcounter_ms_t result = RETRY_CONTROL_BASE_DELAY_IN_MS;
+    size_t i;
+
+    for (i = 1; (i < attemptCount) && (result < RETRY_CONTROL_MAX_DELAY_IN_MS); i++)
+    {
+        result *= 2;
+    }
+
+    return (result > RETRY_CONTROL_MAX_DELAY_IN_MS) ? RETRY_CONTROL_MAX_DELAY_IN_MS : result;
+}
+
+static tickcounter_ms_t getNextDelay(RETRY_CONTROL_INSTANCE* retryControl)
+{
+    tickcounter_ms_t result;
+
+    switch (retryControl->retryPolicy)
+    {
+        default:
+        case IOTHUB_CLIENT_RETRY_NONE:
+        case IOTHUB_CLIENT_RETRY_IMMEDIATE:
+        {
+            result = 0;
+            break;
+        }
+        case IOTHUB_CLIENT_RETRY_INTERVAL:
+        {
+            result = RETRY_CONTROL_INTERVAL_IN_MS;
+            break;
+        }
+        case IOTHUB_CLIENT_RETRY_LINEAR_BACKOFF:
+        {
+            result = (retryControl->attemptCount < (RETRY_CONTROL_MAX_DELAY_IN_MS / RETRY_CONTROL_BASE_DELAY_IN_MS)) ?
+                (tickcounter_ms_t)retryControl->attemptCount * RETRY_CONTROL_BASE_DELAY_IN_MS :
+                RETRY_CONTROL_MAX_DELAY_IN_MS;
+            break;
+        }
+        case IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF:
+        {
+            result = getExponentialDelay(retryControl->attemptCount);
+            break;
+        }
+        case IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER:
+        {
+            /*half of the wait is fixed, the other half is random: devices that failed together spread over the second half*/
+            tickcounter_ms_t delay = getExponentialDelay(retryControl->attemptCount);
+            result = (delay / 2) + (getNextRandom(retryControl) % ((delay / 2) + 1));
+            break;
+        }
+        case IOTHUB_CLIENT_RETRY_RANDOM:
+        {
+            result = getNextRandom(retryControl) % (RETRY_CONTROL_MAX_DELAY_IN_MS + 1);
+            break;
+        }
+    }
+
+    return result;
+}
+
+static void stopRetrying(RETRY_CONTROL_INSTANCE* retryControl, RETRY_ACTION* retryAction)
+{
+    /*transports ask on every DoWork, the log is written once per failure streak*/
+    if (!retryControl->isStopLogged)
+    {
+        LogError("retry policy exhausted after %lu attempts, no more attempts will be made", (unsigned long)retryControl->attemptCount);
+        retryControl->isStopLogged = true;
+    }
+    *retryAction = RETRY_ACTION_STOP_RETRYING;
+}
+
+static void recordAttempt(RETRY_CONTROL_INSTANCE* retryControl, tickcounter_ms_t now)
+{
+    if (retryControl->attemptCount == 0)
+    {
+        retryControl->firstAttemptTime = now;
+    }
+    retryControl->attemptCount++;
+    retryControl->lastAttemptTime = now;
+    retryControl->nextDelay = getNextDelay(retryControl);
+}
+
+RETRY_CONTROL_HANDLE retry_control_create(IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds, const char* deviceId)
+{
+    RETRY_CONTROL_INSTANCE* result;
+
+    /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_001: [ retry_control_create shall allocate memory for the retry control and create a tick counter. ]*/
+    if ((result = (RETRY_CONTROL_INSTANCE*)malloc(sizeof(RETRY_CONTROL_INSTANCE))) == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_002: [ If any failure occurs, retry_control_create shall fail and return NULL. ]*/
+        LogError("Failed allocating the retry control");
+    }
+    else if ((result->tickCounter = tickcounter_create()) == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_002: [ If any failure occurs, retry_control_create shall fail and return NULL. ]*/
+        LogError("Failed creating the tick counter of the retry control");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_003: [ retry_control_create shall seed the jitter from the device id, the instance address, the current time and the tick counter. ]*/
+        result->retryPolicy = retryPolicy;
+        result->retryTimeoutLimitInSeconds = retryTimeoutLimitInSeconds;
+        result->attemptCount = 0;
+        result->firstAttemptTime = 0;
+        result->lastAttemptTime = 0;
+        result->nextDelay = 0;
+        result->isStopLogged = false;
+        result->randomState = createRandomSeed(result, deviceId);
+    }
+
+    return result;
+}
+
+void retry_control_destroy(RETRY_CONTROL_HANDLE retryControlHandle)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_004: [ If retryControlHandle is NULL, retry_control_destroy shall do nothing. ]*/
+    if (retryControlHandle != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_005: [ retry_control_destroy shall destroy the tick counter and free the retry control. ]*/
+        tickcounter_destroy(retryControlHandle->tickCounter);
+        free(retryControlHandle);
+    }
+}
+
+int retry_control_set_policy(RETRY_CONTROL_HANDLE retryControlHandle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds)
+{
+    int result;
+
+    /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_006: [ If retryControlHandle is NULL, retry_control_set_policy shall fail and return a non-zero value. ]*/
+    if (retryControlHandle == NULL)
+    {
+        LogError("invalid arg retryControlHandle=%p", retryControlHandle);
+        result = __LINE__;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_007: [ retry_control_set_policy shall store the policy and the timeout limit, reset the retry state and return 0. ]*/
+        retryControlHandle->retryPolicy = retryPolicy;
+        retryControlHandle->retryTimeoutLimitInSeconds = retryTimeoutLimitInSeconds;
+        retry_control_reset(retryControlHandle);
+        result = 0;
+    }
+
+    return result;
+}
+
+int retry_control_should_retry(RETRY_CONTROL_HANDLE retryControlHandle, RETRY_ACTION* retryAction)
+{
+    int result;
+    tickcounter_ms_t now;
+
+    /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_008: [ If retryControlHandle or retryAction is NULL, retry_control_should_retry shall fail and return a non-zero value. ]*/
+    if ((retryControlHandle == NULL) || (retryAction == NULL))
+    {
+        LogError("invalid arg retryControlHandle=%p, retryAction=%p", retryControlHandle, retryAction);
+        result = __LINE__;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_009: [ If tickcounter_get_current_ms fails, retry_control_should_retry shall fail and return a non-zero value. ]*/
+    else if (tickcounter_get_current_ms(retryControlHandle->tickCounter, &now) != 0)
+    {
+        LogError("Failed reading the tick counter of the retry control");
+        result = __LINE__;
+    }
+    else
+    {
+        if (retryControlHandle->attemptCount == 0)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_010: [ The first call after retry_control_create or retry_control_reset shall set retryAction to RETRY_ACTION_RETRY_NOW. ]*/
+            recordAttempt(retryControlHandle, now);
+            *retryAction = RETRY_ACTION_RETRY_NOW;
+        }
+        else if (retryControlHandle->retryPolicy == IOTHUB_CLIENT_RETRY_NONE)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_011: [ If the policy is IOTHUB_CLIENT_RETRY_NONE, every following call shall set retryAction to RETRY_ACTION_STOP_RETRYING. ]*/
+            stopRetrying(retryControlHandle, retryAction);
+        }
+        else if ((retryControlHandle->retryTimeoutLimitInSeconds != 0) &&
+            (((now - retryControlHandle->firstAttemptTime) / 1000) >= retryControlHandle->retryTimeoutLimitInSeconds))
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_012: [ If retryTimeoutLimitInSeconds is not 0 and at least that many seconds have passed since the first attempt, retryAction shall be set to RETRY_ACTION_STOP_RETRYING. ]*/
+            stopRetrying(retryControlHandle, retryAction);
+        }
+        else if ((now - retryControlHandle->lastAttemptTime) >= retryControlHandle->nextDelay)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_013: [ If the wait computed by the policy has passed since the last attempt, retryAction shall be set to RETRY_ACTION_RETRY_NOW and the wait before the next attempt shall be computed. ]*/
+            recordAttempt(retryControlHandle, now);
+            *retryAction = RETRY_ACTION_RETRY_NOW;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_014: [ Otherwise retryAction shall be set to RETRY_ACTION_RETRY_LATER. ]*/
+            *retryAction = RETRY_ACTION_RETRY_LATER;
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+void retry_control_reset(RETRY_CONTROL_HANDLE retryControlHandle)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_015: [ retry_control_reset shall clear the attempt count so that the next retry_control_should_retry answers RETRY_ACTION_RETRY_NOW. ]*/
+    if (retryControlHandle != NULL)
+    {
+        retryControlHandle->attemptCount = 0;
+        retryControlHandle->nextDelay = 0;
+        retryControlHandle->isStopLogged = false;
+    }
+}
@@ -0,0 +1,431 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/sha.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/urlencode.h"
+
+#include "iothub_client_sastoken_cache.h"
+
+#define HMAC_INNER_PAD_BYTE 0x36
+#define HMAC_OUTER_PAD_BYTE 0x5C
+
+typedef struct SASTOKEN_CACHE_INSTANCE_TAG
+{
+    STRING_HANDLE scope;
+    STRING_HANDLE keyName;
+    /*SHA256 state after absorbing key^ipad and key^opad, copied for every signature*/
+    USHAContext innerContext;
+    USHAContext outerContext;
+    size_t lifetimeInSeconds;
+    size_t reusePercent;
+    STRING_HANDLE token;
+    size_t tokenCreationTime;
+    /*upload to blob runs on threads of its own, so the token and the lifetime are only touched under this lock*/
+    LOCK_HANDLE lock;
+} SASTOKEN_CACHE_INSTANCE;
+
+static int getSecondsSinceEpoch(size_t* seconds)
+{
+    int result;
+    time_t currentTime;
+
+    if ((currentTime = get_time(NULL)) == (time_t)-1)
+    {
+        LogError("get_time failed");
+        result = __LINE__;
+    }
+    else
+    {
+        *seconds = (size_t)get_difftime(currentTime, (time_t)0);
+        result = 0;
+    }
+    return result;
+}
+
+static int precomputePads(SASTOKEN_CACHE_INSTANCE* sasTokenCache, STRING_HANDLE key)
+{
+    int result;
+    BUFFER_HANDLE decodedKey;
+
+    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_002: [ sastoken_cache_create shall decode the key once and absorb the HMAC-SHA256 inner and outer pads into two SHA256 contexts. ]*/
+    if ((decodedKey = Base64_Decoder(STRING_c_str(key))) == NULL)
+    {
+        LogError("unable to decode the key");
+        result = __LINE__;
+    }
+    else
+    {
+        unsigned char keyBlock[SHA256_Message_Block_Size];
+        unsigned char pad[SHA256_Message_Block_Size];
+        const unsigned char* keyBytes = BUFFER_u_char(decodedKey);
+        size_t keyLength = BUFFER_length(decodedKey);
+        size_t i;
+
+        (void)memset(keyBlock, 0, sizeof(keyBlock));
+        result = 0;
+        if (keyLength > SHA256_Message_Block_Size)
+        {
+            /*as per RFC 2104, keys longer than a block are hashed first*/
+            USHAContext keyContext;
+            if ((USHAReset(&keyContext, SHA256) != shaSuccess) ||
+                (USHAInput(&keyContext, keyBytes, (unsigned int)keyLength) != shaSuccess) ||
+                (USHAResult(&keyContext, keyBlock) != shaSuccess))
+            {
+                LogError("unable to hash the key");
+                result = __LINE__;
+            }
+        }
+        else if (keyLength > 0)
+        {
+            (void)memcpy(keyBlock, keyBytes, keyLength);
+        }
+
+        if (result == 0)
+        {
+            for (i = 0; i < SHA256_Message_Block_Size; i++)
+            {
+                pad[i] = keyBlock[i] ^ HMAC_INNER_PAD_BYTE;
+            }
+            if ((USHAReset(&sasTokenCache->innerContext, SHA256) != shaSuccess) ||
+                (USHAInput(&sasTokenCache->innerContext, pad, SHA256_Message_Block_Size) != shaSuccess))
+            {
+                LogError("unable to absorb the inner pad");
+                result = __LINE__;
+            }
+            else
+            {
+                for (i = 0; i < SHA256_Message_Block_Size; i++)
+                {
+                    pad[i] = keyBlock[i] ^ HMAC_OUTER_PAD_BYTE;
+                }
+                if ((USHAReset(&sasTokenCache->outerContext, SHA256) != shaSuccess) ||
+                    (USHAInput(&sasTokenCache->outerContext, pad, SHA256_Message_Block_Size) != shaSuccess))
+                {
+                    LogError("unable to absorb the outer pad");
+                    result = __LINE__;
+                }
+            }
+            (void)memset(pad, 0, sizeof(pad));
+        }
+
+        /*the decoded key is not kept around*/
+        (void)memset(keyBlock, 0, sizeof(keyBlock));
+        (void)memset(BUFFER_u_char(decodedKey), 0, keyLength);
+        BUFFER_delete(decodedKey);
+    }
+    return result;
+}
+
+static STRING_HANDLE signToken(SASTOKEN_CACHE_INSTANCE* sasTokenCache, size_t expiryTime)
+{
+    STRING_HANDLE result;
+    char expiryText[32];
+    STRING_HANDLE toBeSigned;
+
+    (void)sprintf(expiryText, "%lu", (unsigned long)expiryTime);
+    if ((toBeSigned = STRING_construct_sprintf("%s\n%s", STRING_c_str(sasTokenCache->scope), expiryText)) == NULL)
+    {
+        LogError("unable to build the string to sign");
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_012: [ The signature shall be computed by continuing copies of the precomputed inner and outer SHA256 contexts. ]*/
+        USHAContext context = sasTokenCache->innerContext;
+        uint8_t innerDigest[SHA256HashSize];
+        uint8_t digest[SHA256HashSize];
+
+        if ((USHAInput(&context, (const uint8_t*)STRING_c_str(toBeSigned), (unsigned int)STRING_length(toBeSigned)) != shaSuccess) ||
+            (USHAResult(&context, innerDigest) != shaSuccess))
+        {
+            LogError("unable to compute the inner digest");
+            result = NULL;
+        }
+        else
+        {
+            STRING_HANDLE base64Signature;
+
+            context = sasTokenCache->outerContext;
+            if ((USHAInput(&context, innerDigest, SHA256HashSize) != shaSuccess) ||
+                (USHAResult(&context, digest) != shaSuccess))
+            {
+                LogError("unable to compute the outer digest");
+                result = NULL;
+            }
+            else if ((base64Signature = Base64_Encode_Bytes(digest, SHA256HashSize)) == NULL)
+            {
+                LogError("unable to Base64_Encode_Bytes");
+                result = NULL;
+            }
+            else
+            {
+                STRING_HANDLE urlEncodedSignature;
+                if ((urlEncodedSignature = URL_Encode(base64Signature)) == NULL)
+                {
+                    LogError("unable to URL_Encode");
+                    result = NULL;
+                }
+                else
+                {
+                    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_013: [ The token shall have the format "SharedAccessSignature sr=<scope>&sig=<signature>&se=<expiry>", followed by "&skn=<keyName>" when keyName is not empty. ]*/
+                    if ((sasTokenCache->keyName != NULL) && (STRING_length(sasTokenCache->keyName) > 0))
+                    {
+                        result = STRING_construct_sprintf("SharedAccessSignature sr=%s&sig=%s&se=%s&skn=%s", STRING_c_str(sasTokenCache->scope), STRING_c_str(urlEncodedSignature), expiryText, STRING_c_str(sasTokenCache->keyName));
+                    }
+                    else
+                    {
+                        result = STRING_construct_sprintf("SharedAccessSignature sr=%s&sig=%s&se=%s", STRING_c_str(sasTokenCache->scope), STRING_c_str(urlEncodedSignature), expiryText);
+                    }
+                    if (result == NULL)
+                    {
+                        LogError("unable to build the token");
+                    }
+                    STRING_delete(urlEncodedSignature);
+                }
+                STRING_delete(base64Signature);
+            }
+            (void)memset(innerDigest, 0, sizeof(innerDigest));
+        }
+        STRING_delete(toBeSigned);
+    }
+    return result;
+}
+
+SASTOKEN_CACHE_HANDLE sastoken_cache_create(STRING_HANDLE key, STRING_HANDLE scope, STRING_HANDLE keyName)
+{
+    SASTOKEN_CACHE_INSTANCE* result;
+
+    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_001: [ If key or scope is NULL, sastoken_cache_create shall fail and return NULL. ]*/
+    if ((key == NULL) || (scope == NULL))
+    {
+        LogError("invalid arguments STRING_HANDLE key=%p, STRING_HANDLE scope=%p", key, scope);
+        result = NULL;
+    }
+    else if ((result = (SASTOKEN_CACHE_INSTANCE*)malloc(sizeof(SASTOKEN_CACHE_INSTANCE))) == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_003: [ If any failure occurs, sastoken_cache_create shall fail and return NULL. ]*/
+        LogError("unable to malloc");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(SASTOKEN_CACHE_INSTANCE));
+        /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_004: [ The tokens shall live SASTOKEN_CACHE_DEFAULT_LIFETIME_IN_SECONDS and be reused during SASTOKEN_CACHE_DEFAULT_REUSE_PERCENT of their lifetime. ]*/
+        result->lifetimeInSeconds = SASTOKEN_CACHE_DEFAULT_LIFETIME_IN_SECONDS;
+        result->reusePercent = SASTOKEN_CACHE_DEFAULT_REUSE_PERCENT;
+
+        if ((result->scope = STRING_clone(scope)) == NULL)
+        {
+            LogError("unable to clone the scope");
+            free(result);
+            result = NULL;
+        }
+        else if ((keyName != NULL) && ((result->keyName = STRING_clone(keyName)) == NULL))
+        {
+            LogError("unable to clone the key name");
+            STRING_delete(result->scope);
+            free(result);
+            result = NULL;
+        }
+        else if (precomputePads(result, key) != 0)
+        {
+            STRING_delete(result->keyName);
+            STRING_delete(result->scope);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("unable to Lock_Init");
+            STRING_delete(result->keyName);
+            STRING_delete(result->scope);
+            (void)memset(result, 0, sizeof(SASTOKEN_CACHE_INSTANCE));
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            /*all is fine*/
+        }
+    }
+    return result;
+}
+
+void sastoken_cache_destroy(SASTOKEN_CACHE_HANDLE sasTokenCacheHandle)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_005: [ If sasTokenCacheHandle is NULL, sastoken_cache_destroy shall do nothing. ]*/
+    if (sasTokenCacheHandle != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_006: [ sastoken_cache_destroy shall free the cached token, the scope, the key name and the instance, and wipe the precomputed pads. ]*/
+        STRING_delete(sasTokenCacheHandle->token);
+        STRING_delete(sasTokenCacheHandle->keyName);
+        STRING_delete(sasTokenCacheHandle->scope);
+        (void)Lock_Deinit(sasTokenCacheHandle->lock);
+        (void)memset(sasTokenCacheHandle, 0, sizeof(SASTOKEN_CACHE_INSTANCE));
+        free(sasTokenCacheHandle);
+    }
+}
+
+int sastoken_cache_set_lifetime(SASTOKEN_CACHE_HANDLE sasTokenCacheHandle, size_t lifetimeInSeconds, size_t reusePercent)
+{
+    int result;
+
+    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_007: [ If sasTokenCacheHandle is NULL, lifetimeInSeconds is 0 or reusePercent is greater than 100, sastoken_cache_set_lifetime shall fail and return a non-zero value. ]*/
+    if ((sasTokenCacheHandle == NULL) || (lifetimeInSeconds == 0) || (reusePercent > 100))
+    {
+        LogError("invalid arguments SASTOKEN_CACHE_HANDLE sasTokenCacheHandle=%p, size_t lifetimeInSeconds=%lu, size_t reusePercent=%lu", sasTokenCacheHandle, (unsigned long)lifetimeInSeconds, (unsigned long)reusePercent);
+        result = __LINE__;
+    }
+    else if (Lock(sasTokenCacheHandle->lock) != LOCK_OK)
+    {
+        LogError("unable to Lock");
+        result = __LINE__;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_008: [ sastoken_cache_set_lifetime shall store lifetimeInSeconds and reusePercent, drop the cached token and return 0. ]*/
+        sasTokenCacheHandle->lifetimeInSeconds = lifetimeInSeconds;
+        sasTokenCacheHandle->reusePercent = reusePercent;
+        STRING_delete(sasTokenCacheHandle->token);
+        sasTokenCacheHandle->token = NULL;
+        (void)Unlock(sasTokenCacheHandle->lock);
+        result = 0;
+    }
+    return result;
+}
+
+/*called with the lock held, returns the cached token, signing a new one if needed*/
+static STRING_HANDLE getCachedToken(SASTOKEN_CACHE_INSTANCE* sasTokenCache, size_t* creationTime)
+{
+    STRING_HANDLE result;
+    size_t now;
+
+    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_010: [ If getting the current time fails, sastoken_cache_get_token shall fail and return NULL. ]*/
+    if (getSecondsSinceEpoch(&now) != 0)
+    {
+        result = NULL;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_011: [ If there is a cached token younger than reusePercent of its lifetime, sastoken_cache_get_token shall return it without signing. ]*/
+    else if ((sasTokenCache->token != NULL) &&
+        (now >= sasTokenCache->tokenCreationTime) &&
+        ((now - sasTokenCache->tokenCreationTime) * 100 < sasTokenCache->lifetimeInSeconds * sasTokenCache->reusePercent))
+    {
+        if (creationTime != NULL)
+        {
+            *creationTime = sasTokenCache->tokenCreationTime;
+        }
+        result = sasTokenCache->token;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_014: [ Otherwise sastoken_cache_get_token shall sign a new token expiring lifetimeInSeconds from now, cache it and return it. ]*/
+        STRING_HANDLE newToken = signToken(sasTokenCache, now + sasTokenCache->lifetimeInSeconds);
+        if (newToken == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_015: [ If signing fails, sastoken_cache_get_token shall fail and return NULL. ]*/
+            result = NULL;
+        }
+        else
+        {
+            STRING_delete(sasTokenCache->token);
+            sasTokenCache->token = newToken;
+            sasTokenCache->tokenCreationTime = now;
+            if (creationTime != NULL)
+            {
+                *creationTime = now;
+            }
+            result = newToken;
+        }
+    }
+    return result;
+}
+
+const char* sastoken_cache_get_token(SASTOKEN_CACHE_HANDLE sasTokenCacheHandle, size_t* creationTime)
+{
+    const char* result;
+
+    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_009: [ If sasTokenCacheHandle is NULL, sastoken_cache_get_token shall fail and return NULL. ]*/
+    if (sasTokenCacheHandle == NULL)
+    {
+        LogError("invalid argument SASTOKEN_CACHE_HANDLE sasTokenCacheHandle=NULL");
+        result = NULL;
+    }
+    else if (Lock(sasTokenCacheHandle->lock) != LOCK_OK)
+    {
+        LogError("unable to Lock");
+        result = NULL;
+    }
+    else
+    {
+        STRING_HANDLE token = getCachedToken(sasTokenCacheHandle, creationTime);
+        result = (token == NULL) ? NULL : STRING_c_str(token);
+        (void)Unlock(sasTokenCacheHandle->lock);
+    }
+    return result;
+}
+
+STRING_HANDLE sastoken_cache_copy_token(SASTOKEN_CACHE_HANDLE sasTokenCacheHandle, size_t* creationTime)
+{
+    STRING_HANDLE result;
+
+    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_018: [ If sasTokenCacheHandle is NULL, sastoken_cache_copy_token shall fail and return NULL. ]*/
+    if (sasTokenCacheHandle == NULL)
+    {
+        LogError("invalid argument SASTOKEN_CACHE_HANDLE sasTokenCacheHandle=NULL");
+        result = NULL;
+    }
+    else if (Lock(sasTokenCacheHandle->lock) != LOCK_OK)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_020: [ If any failure occurs, sastoken_cache_copy_token shall fail and return NULL. ]*/
+        LogError("unable to Lock");
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_019: [ sastoken_cache_copy_token shall get the token as sastoken_cache_get_token does and return a copy of it made under the lock of the cache, which the caller shall free with STRING_delete. ]*/
+        STRING_HANDLE token = getCachedToken(sasTokenCacheHandle, creationTime);
+        if (token == NULL)
+        {
+            result = NULL;
+        }
+        else if ((result = STRING_clone(token)) == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_020: [ If any failure occurs, sastoken_cache_copy_token shall fail and return NULL. ]*/
+            LogError("unable to STRING_clone the token");
+        }
+        (void)Unlock(sasTokenCacheHandle->lock);
+    }
+    return result;
+}
+
+void sastoken_cache_invalidate(SASTOKEN_CACHE_HANDLE sasTokenCacheHandle)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_016: [ If sasTokenCacheHandle is NULL, sastoken_cache_invalidate shall do nothing. ]*/
+    if (sasTokenCacheHandle != NULL)
+    {
+        if (Lock(sasTokenCacheHandle->lock) != LOCK_OK)
+        {
+            LogError("unable to Lock");
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_017: [ sastoken_cache_invalidate shall drop the cached token. ]*/
+            STRING_delete(sasTokenCacheHandle->token);
+            sasTokenCacheHandle->token = NULL;
+            (void)Unlock(sasTokenCacheHandle->lock);
+        }
+    }
+}
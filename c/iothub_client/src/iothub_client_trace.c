@@ -0,0 +1,321 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*clock_gettime and CLOCK_MONOTONIC are POSIX, the library is compiled as C99*/
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
+
+#include "iothub_client_trace.h"
+#include "iothub_client_private.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#if !defined(CLOCK_MONOTONIC)
+#include "azure_c_shared_utility/tickcounter.h"
+#endif
+#endif
+
+DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_TRACE_STAGE, IOTHUB_CLIENT_TRACE_STAGE_VALUES);
+
+#define TRACE_CATEGORY "iothub"
+#define MESSAGE_SPAN_NAME "message"
+
+/*the names of the events in the Chrome trace, indexed by IOTHUB_CLIENT_TRACE_STAGE*/
+static const char* const stageNames[] = { "enqueue", "dequeue", "serialize", "write", "ack", "callback" };
+
+static IOTHUB_CLIENT_TRACE_CALLBACK traceCallback = NULL;
+static void* traceCallbackContext = NULL;
+
+typedef struct TRACE_RECORDER_ENTRY_TAG
+{
+    IOTHUB_CLIENT_TRACE_STAGE stage;
+    IOTHUB_MESSAGE_HANDLE message;
+    uint64_t timestampUs;
+} TRACE_RECORDER_ENTRY;
+
+typedef struct IOTHUB_CLIENT_TRACE_RECORDER_TAG
+{
+    LOCK_HANDLE lock;
+    TRACE_RECORDER_ENTRY* entries;
+    size_t capacity;
+    size_t count;
+    size_t next; /*where the next entry is written, also the oldest entry once the recorder is full*/
+} IOTHUB_CLIENT_TRACE_RECORDER;
+
+void iothub_client_trace_set_callback(IOTHUB_CLIENT_TRACE_CALLBACK callback, void* context)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_001: [ iothub_client_trace_set_callback shall store callback and context, a NULL callback stops the tracing. ]*/
+    traceCallbackContext = context;
+    traceCallback = callback;
+}
+
+void iothub_client_trace_message(IOTHUB_CLIENT_TRACE_STAGE stage, IOTHUB_MESSAGE_HANDLE message)
+{
+    IOTHUB_CLIENT_TRACE_CALLBACK callback = traceCallback;
+    /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_002: [ If no callback is set, iothub_client_trace_message shall return without reading the clock. ]*/
+    if (callback != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_003: [ Otherwise iothub_client_trace_message shall call the callback with stage, message, the time of iothub_client_trace_get_time_us and the context. ]*/
+        callback(stage, message, iothub_client_trace_get_time_us(), traceCallbackContext);
+    }
+}
+
+void iothub_client_trace_message_list(IOTHUB_CLIENT_TRACE_STAGE stage, PDLIST_ENTRY list)
+{
+    IOTHUB_CLIENT_TRACE_CALLBACK callback = traceCallback;
+    /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_004: [ If no callback is set or list is NULL, iothub_client_trace_message_list shall return without reading the clock. ]*/
+    if ((callback != NULL) && (list != NULL))
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_005: [ Otherwise iothub_client_trace_message_list shall read the clock once and call the callback with stage and that time for the message of every IOTHUB_MESSAGE_LIST in list, in order. ]*/
+        uint64_t timestampUs = iothub_client_trace_get_time_us();
+        PDLIST_ENTRY current = list->Flink;
+        while (current != list)
+        {
+            IOTHUB_MESSAGE_LIST* item = containingRecord(current, IOTHUB_MESSAGE_LIST, entry);
+            callback(stage, item->messageHandle, timestampUs, traceCallbackContext);
+            current = current->Flink;
+        }
+    }
+}
+
+/*Codes_SRS_IOTHUB_CLIENT_TRACE_02_006: [ iothub_client_trace_get_time_us shall return the time of a monotonic clock in microseconds. ]*/
+#if defined(_WIN32)
+uint64_t iothub_client_trace_get_time_us(void)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    uint64_t result;
+    if (!QueryPerformanceFrequency(&frequency) || !QueryPerformanceCounter(&counter) || (frequency.QuadPart <= 0))
+    {
+        result = 0;
+    }
+    else
+    {
+        /*split so that counter * 1000000 cannot overflow*/
+        result = (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+            (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000 / (uint64_t)frequency.QuadPart;
+    }
+    return result;
+}
+#elif defined(CLOCK_MONOTONIC)
+uint64_t iothub_client_trace_get_time_us(void)
+{
+    struct timespec now;
+    uint64_t result;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+    }
+    return result;
+}
+#else
+/*platforms without a monotonic clock in time.h use the tickcounter of the adapter, with its millisecond resolution*/
+static TICK_COUNTER_HANDLE traceTickCounter = NULL;
+
+uint64_t iothub_client_trace_get_time_us(void)
+{
+    tickcounter_ms_t nowMs;
+    uint64_t result;
+    if ((traceTickCounter == NULL) && ((traceTickCounter = tickcounter_create()) == NULL))
+    {
+        result = 0;
+    }
+    else if (tickcounter_get_current_ms(traceTickCounter, &nowMs) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (uint64_t)nowMs * 1000;
+    }
+    return result;
+}
+#endif
+
+IOTHUB_CLIENT_TRACE_RECORDER_HANDLE iothub_client_trace_recorder_create(size_t capacity)
+{
+    IOTHUB_CLIENT_TRACE_RECORDER* result;
+    if (capacity == 0)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_007: [ If capacity is 0, iothub_client_trace_recorder_create shall fail and return NULL. ]*/
+        LogError("invalid argument size_t capacity=0");
+        result = NULL;
+    }
+    else if (capacity > SIZE_MAX / sizeof(TRACE_RECORDER_ENTRY))
+    {
+        LogError("capacity=%lu is too big", (unsigned long)capacity);
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_008: [ iothub_client_trace_recorder_create shall allocate the recorder and its capacity entries and create a lock. ]*/
+        result = (IOTHUB_CLIENT_TRACE_RECORDER*)malloc(sizeof(IOTHUB_CLIENT_TRACE_RECORDER));
+        if (result == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_009: [ If any of the above fails, iothub_client_trace_recorder_create shall fail and return NULL. ]*/
+            LogError("unable to malloc");
+            /*return as is*/
+        }
+        else if ((result->entries = (TRACE_RECORDER_ENTRY*)malloc(capacity * sizeof(TRACE_RECORDER_ENTRY))) == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_009: [ If any of the above fails, iothub_client_trace_recorder_create shall fail and return NULL. ]*/
+            LogError("unable to malloc");
+            free(result);
+            result = NULL;
+        }
+        else if ((result->lock = Lock_Init()) == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_009: [ If any of the above fails, iothub_client_trace_recorder_create shall fail and return NULL. ]*/
+            LogError("unable to Lock_Init");
+            free(result->entries);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->capacity = capacity;
+            result->count = 0;
+            result->next = 0;
+        }
+    }
+    return result;
+}
+
+void iothub_client_trace_recorder_destroy(IOTHUB_CLIENT_TRACE_RECORDER_HANDLE recorder)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_010: [ If recorder is NULL, iothub_client_trace_recorder_destroy shall do nothing. ]*/
+    if (recorder != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_011: [ iothub_client_trace_recorder_destroy shall deinit the lock and free the entries and the recorder. ]*/
+        (void)Lock_Deinit(recorder->lock);
+        free(recorder->entries);
+        free(recorder);
+    }
+}
+
+void iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE stage, IOTHUB_MESSAGE_HANDLE message, uint64_t timestampUs, void* context)
+{
+    IOTHUB_CLIENT_TRACE_RECORDER* recorder = (IOTHUB_CLIENT_TRACE_RECORDER*)context;
+    if (recorder == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_012: [ If context is NULL, iothub_client_trace_recorder_callback shall do nothing. ]*/
+        LogError("invalid argument void* context=NULL");
+    }
+    else if (Lock(recorder->lock) != LOCK_OK)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_014: [ If the lock cannot be taken, iothub_client_trace_recorder_callback shall drop the event. ]*/
+        LogError("unable to Lock");
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_013: [ iothub_client_trace_recorder_callback shall store stage, message and timestampUs under the lock of the recorder, overwriting the oldest event when the recorder is full. ]*/
+        TRACE_RECORDER_ENTRY* entry = &(recorder->entries[recorder->next]);
+        entry->stage = stage;
+        entry->message = message;
+        entry->timestampUs = timestampUs;
+        recorder->next = (recorder->next + 1) % recorder->capacity;
+        if (recorder->count < recorder->capacity)
+        {
+            recorder->count++;
+        }
+        (void)Unlock(recorder->lock);
+    }
+}
+
+/*appends like snprintf at the end of what was written so far, keeps counting when the destination is full*/
+static void appendEvent(char* destination, size_t destinationSize, size_t* length, bool isFirst, const char* name, const char* phase, const TRACE_RECORDER_ENTRY* entry)
+{
+    static const char* const format = "%s{\"name\":\"%s\",\"cat\":\"" TRACE_CATEGORY "\",\"ph\":\"%s\",\"id\":\"0x%llx\",\"ts\":%llu,\"pid\":1,\"tid\":1}";
+    const char* separator = isFirst ? "" : ",";
+    unsigned long long id = (unsigned long long)(uintptr_t)entry->message;
+    unsigned long long ts = (unsigned long long)entry->timestampUs;
+    int written = (*length < destinationSize) ?
+        snprintf(destination + *length, destinationSize - *length, format, separator, name, phase, id, ts) :
+        snprintf(NULL, 0, format, separator, name, phase, id, ts);
+    if (written > 0)
+    {
+        *length += (size_t)written;
+    }
+}
+
+static void appendText(char* destination, size_t destinationSize, size_t* length, const char* text)
+{
+    size_t textLength = strlen(text);
+    if (*length < destinationSize)
+    {
+        (void)snprintf(destination + *length, destinationSize - *length, "%s", text);
+    }
+    *length += textLength;
+}
+
+size_t iothub_client_trace_recorder_format(IOTHUB_CLIENT_TRACE_RECORDER_HANDLE recorder, char* destination, size_t destinationSize)
+{
+    size_t result = 0;
+    if (recorder == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_015: [ If recorder is NULL, iothub_client_trace_recorder_format shall return 0. ]*/
+        LogError("invalid argument IOTHUB_CLIENT_TRACE_RECORDER_HANDLE recorder=NULL");
+    }
+    else if (Lock(recorder->lock) != LOCK_OK)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_018: [ If the lock cannot be taken, iothub_client_trace_recorder_format shall return 0. ]*/
+        LogError("unable to Lock");
+    }
+    else
+    {
+        size_t oldest = (recorder->count < recorder->capacity) ? 0 : recorder->next;
+        size_t i;
+        bool isFirst = true;
+
+        if (destination == NULL)
+        {
+            destinationSize = 0;
+        }
+        else if (destinationSize > 0)
+        {
+            destination[0] = '\0';
+        }
+
+        /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_016: [ iothub_client_trace_recorder_format shall write the events oldest first as a Chrome trace {"traceEvents":[...]}, every event being an async instant event ("ph":"n") named after its stage in lower case, of category "iothub", whose id is the message handle and whose ts is its timestamp. ]*/
+        appendText(destination, destinationSize, &result, "{\"traceEvents\":[");
+        for (i = 0; i < recorder->count; i++)
+        {
+            const TRACE_RECORDER_ENTRY* entry = &(recorder->entries[(oldest + i) % recorder->capacity]);
+            const char* stageName = ((size_t)entry->stage < sizeof(stageNames) / sizeof(stageNames[0])) ? stageNames[entry->stage] : ENUM_TO_STRING(IOTHUB_CLIENT_TRACE_STAGE, entry->stage);
+
+            /*Codes_SRS_IOTHUB_CLIENT_TRACE_02_017: [ An ENQUEUE event shall be preceded by the begin ("ph":"b") and a CALLBACK event followed by the end ("ph":"e") of an async event named "message" with the same id and ts. ]*/
+            if (entry->stage == IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE)
+            {
+                appendEvent(destination, destinationSize, &result, isFirst, MESSAGE_SPAN_NAME, "b", entry);
+                isFirst = false;
+            }
+            appendEvent(destination, destinationSize, &result, isFirst, stageName, "n", entry);
+            isFirst = false;
+            if (entry->stage == IOTHUB_CLIENT_TRACE_STAGE_CALLBACK)
+            {
+                appendEvent(destination, destinationSize, &result, isFirst, MESSAGE_SPAN_NAME, "e", entry);
+            }
+        }
+        appendText(destination, destinationSize, &result, "]}");
+        (void)Unlock(recorder->lock);
+    }
+    return result;
+}
@@ -28,6 +28,7 @@ typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
     MAP_HANDLE properties;
     char* messageId;
     char* correlationId;
+    IOTHUB_MESSAGE_PRIORITY priority;
 }IOTHUB_MESSAGE_HANDLE_DATA;
 
 static bool ContainsOnlyUsAscii(const char* asciiValue)
@@ -122,6 +123,8 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char* byt
                 result->contentType = IOTHUBMESSAGE_BYTEARRAY;
                 result->messageId = NULL;
                 result->correlationId = NULL;
+                /*Codes_SRS_IOTHUBMESSAGE_02_033: [ The priority of a new message shall be IOTHUB_MESSAGE_PRIORITY_NORMAL. ]*/
+                result->priority = IOTHUB_MESSAGE_PRIORITY_NORMAL;
                 /*all is fine, return result*/
             }
         }
@@ -164,6 +167,8 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char* source)
             result->contentType = IOTHUBMESSAGE_STRING;
             result->messageId = NULL;
             result->correlationId = NULL;
+            /*Codes_SRS_IOTHUBMESSAGE_02_033: [ The priority of a new message shall be IOTHUB_MESSAGE_PRIORITY_NORMAL. ]*/
+            result->priority = IOTHUB_MESSAGE_PRIORITY_NORMAL;
         }
     }
     return result;
@@ -194,6 +199,8 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
         {
             result->messageId = NULL;
             result->correlationId = NULL;
+            /*Codes_SRS_IOTHUBMESSAGE_02_035: [ IoTHubMessage_Clone shall copy the priority. ]*/
+            result->priority = source->priority;
             if (source->messageId != NULL && mallocAndStrcpy_s(&result->messageId, source->messageId) != 0)
             {
                 LogError("unable to Copy messageId");
@@ -500,6 +507,44 @@ const char* IoTHubMessage_GetMessageId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle
     return result;
 }
 
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetPriority(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, IOTHUB_MESSAGE_PRIORITY priority)
+{
+    IOTHUB_MESSAGE_RESULT result;
+    /*Codes_SRS_IOTHUBMESSAGE_02_036: [ If iotHubMessageHandle is NULL or priority is not an IOTHUB_MESSAGE_PRIORITY value then IoTHubMessage_SetPriority shall return IOTHUB_MESSAGE_INVALID_ARG. ]*/
+    if ((iotHubMessageHandle == NULL) ||
+        ((priority != IOTHUB_MESSAGE_PRIORITY_LOW) && (priority != IOTHUB_MESSAGE_PRIORITY_NORMAL) && (priority != IOTHUB_MESSAGE_PRIORITY_HIGH)))
+    {
+        LogError("invalid arg passed to IoTHubMessage_SetPriority, iotHubMessageHandle=%p, priority=%d", iotHubMessageHandle, (int)priority);
+        result = IOTHUB_MESSAGE_INVALID_ARG;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_02_037: [ Otherwise IoTHubMessage_SetPriority shall set the priority of the message and return IOTHUB_MESSAGE_OK. ]*/
+        IOTHUB_MESSAGE_HANDLE_DATA* handleData = iotHubMessageHandle;
+        handleData->priority = priority;
+        result = IOTHUB_MESSAGE_OK;
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_PRIORITY IoTHubMessage_GetPriority(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    IOTHUB_MESSAGE_PRIORITY result;
+    /*Codes_SRS_IOTHUBMESSAGE_02_038: [ If iotHubMessageHandle is NULL then IoTHubMessage_GetPriority shall return IOTHUB_MESSAGE_PRIORITY_NORMAL. ]*/
+    if (iotHubMessageHandle == NULL)
+    {
+        LogError("invalid arg (NULL) passed to IoTHubMessage_GetPriority");
+        result = IOTHUB_MESSAGE_PRIORITY_NORMAL;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_02_034: [ IoTHubMessage_GetPriority shall return the priority of the message. ]*/
+        IOTHUB_MESSAGE_HANDLE_DATA* handleData = iotHubMessageHandle;
+        result = handleData->priority;
+    }
+    return result;
+}
+
 void IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
 {
     /*Codes_SRS_IOTHUBMESSAGE_01_004: [If iotHubMessageHandle is NULL, IoTHubMessage_Destroy shall do nothing.] */
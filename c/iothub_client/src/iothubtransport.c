@@ -28,6 +28,7 @@ typedef struct TRANSPORT_HANDLE_DATA_TAG
     sig_atomic_t stopThread;
 	TRANSPORT_PROVIDER_FIELDS;
 	VECTOR_HANDLE clients;
+	IOTHUB_CLIENT_METRICS metrics; /*the TRANSPORT_* metrics of the lower layer transport, for all its clients*/
 } TRANSPORT_HANDLE_DATA;
 
 /* Used for Unit test */
@@ -68,6 +69,9 @@ TRANSPORT_HANDLE  IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protoc
 			IOTHUBTRANSPORT_CONFIG transportLLConfig;
 			transportLLConfig.upperConfig = &upperConfig;
 			transportLLConfig.waitingToSend = NULL;
+			/*Codes_SRS_IOTHUBTRANSPORT_02_001: [ IoTHubTransport_Create shall start the metrics of the transport at 0 and give them to the lower layer transport in the metrics field of IOTHUBTRANSPORT_CONFIG. ]*/
+			iothub_client_metrics_init(&(result->metrics));
+			transportLLConfig.metrics = &(result->metrics);
 
 			/*Codes_SRS_IOTHUBTRANSPORT_17_005: [ IoTHubTransport_Create shall create the lower layer transport by calling the protocol's IoTHubTransport_Create function. ]*/
 			result->transportLLHandle = transportProtocol->IoTHubTransport_Create(&transportLLConfig);
@@ -119,6 +123,7 @@ TRANSPORT_HANDLE  IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protoc
 						result->IoTHubTransport_Unsubscribe = transportProtocol->IoTHubTransport_Unsubscribe;
 						result->IoTHubTransport_DoWork = transportProtocol->IoTHubTransport_DoWork;
 						result->IoTHubTransport_GetSendStatus = transportProtocol->IoTHubTransport_GetSendStatus;
+						result->IoTHubTransport_SetRetryPolicy = transportProtocol->IoTHubTransport_SetRetryPolicy;
 					}
 				}
 			}
@@ -373,3 +378,22 @@ void IoTHubTransport_JoinWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_C
 		wait_worker_thread(transportData);
 	}
 }
+
+IOTHUB_CLIENT_RESULT IoTHubTransport_GetMetrics(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot)
+{
+	IOTHUB_CLIENT_RESULT result;
+	if (transportHandle == NULL || snapshot == NULL)
+	{
+		/*Codes_SRS_IOTHUBTRANSPORT_02_002: [ If transportHandle or snapshot is NULL, IoTHubTransport_GetMetrics shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+		LogError("Invalid NULL argument, transportHandle [%p], snapshot [%p].", transportHandle, snapshot);
+		result = IOTHUB_CLIENT_INVALID_ARG;
+	}
+	else
+	{
+		TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
+		/*Codes_SRS_IOTHUBTRANSPORT_02_003: [ Otherwise IoTHubTransport_GetMetrics shall copy the metrics of the transport to snapshot by calling iothub_client_metrics_get_snapshot, without taking the transport lock, and return IOTHUB_CLIENT_OK. ]*/
+		(void)iothub_client_metrics_get_snapshot(&(transportData->metrics), snapshot);
+		result = IOTHUB_CLIENT_OK;
+	}
+	return result;
+}
@@ -16,7 +16,6 @@
 #include "iothub_client_options.h"
 #include "iothub_client_private.h"
 #include "azure_umqtt_c/mqtt_client.h"
-#include "azure_c_shared_utility/sastoken.h"
 #include "azure_c_shared_utility/tickcounter.h"
 
 #include "azure_c_shared_utility/tlsio.h"
@@ -24,6 +23,9 @@
 
 #include "azure_c_shared_utility/string_tokenizer.h"
 #include "iothub_client_version.h"
+#include "iothub_client_retry_control.h"
+#include "iothub_client_sastoken_cache.h"
+#include "iothub_client_trace.h"
 
 #include "iothubtransport_mqtt_common.h"
 
@@ -40,8 +42,6 @@
 #define SAS_TOKEN_DEFAULT_LEN       10
 #define RESEND_TIMEOUT_VALUE_MIN    1*60
 #define MAX_SEND_RECOUNT_LIMIT      2
-#define DEFAULT_CONNECTION_INTERVAL 30
-#define FAILED_CONN_BACKOFF_VALUE   5
 
 static const char* TOPIC_DEVICE_MSG = "devices/%s/messages/devicebound/#";
 static const char* TOPIC_DEVICE_DEVICE = "devices/%s/messages/events/";
@@ -107,6 +107,8 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
 
     // Authentication
     MQTT_TRANSPORT_CREDENTIALS transport_creds;
+    // Signs the device key tokens, NULL unless credential_type is DEVICE_KEY
+    SASTOKEN_CACHE_HANDLE sasTokenCache;
 
     MQTT_GET_IO_TRANSPORT get_io_transport;
 
@@ -134,8 +136,9 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
     bool isDestroyCalled;
     uint16_t keepAliveValue;
     uint64_t mqtt_connect_time;
-    size_t connectFailCount;
-    uint64_t connectTick;
+    // Age of the SAS token at connect time, in seconds (a cached token can be reused)
+    size_t sas_token_age_at_connect;
+    RETRY_CONTROL_HANDLE retryControl;
     bool log_trace;
     bool raw_trace;
 
@@ -146,6 +149,9 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
 
     // Telemetry specific
     DLIST_ENTRY telemetry_waitingForAck;
+
+    // Where the TRANSPORT_* metrics are counted, NULL when the upper layer does not keep them
+    IOTHUB_CLIENT_METRICS* metrics;
 } MQTTTRANSPORT_HANDLE_DATA, *PMQTTTRANSPORT_HANDLE_DATA;
 
 typedef struct MQTT_MESSAGE_DETAILS_LIST_TAG
@@ -253,6 +259,7 @@ static int publish_mqtt_telemetry_msg(PMQTTTRANSPORT_HANDLE_DATA transport_data,
         }
         else
         {
+            IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_SERIALIZE, mqttMsgEntry->iotHubMessageEntry->messageHandle);
             if (tickcounter_get_current_ms(g_msgTickCounter, &mqttMsgEntry->msgPublishTime) != 0)
             {
                 LogError("Failed retrieving tickcounter info");
@@ -266,6 +273,13 @@ static int publish_mqtt_telemetry_msg(PMQTTTRANSPORT_HANDLE_DATA transport_data,
                 }
                 else
                 {
+                    IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_WRITE, mqttMsgEntry->iotHubMessageEntry->messageHandle);
+                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_024: [ Every telemetry message published, a resend included, shall add 1 to IOTHUB_CLIENT_METRIC_TRANSPORT_EVENTS_SENT and the length of its payload to IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_SENT of the metrics given in IOTHUBTRANSPORT_CONFIG, if any. ] */
+                    if (transport_data->metrics != NULL)
+                    {
+                        iothub_client_metrics_add(transport_data->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_EVENTS_SENT, 1);
+                        iothub_client_metrics_add(transport_data->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_SENT, len);
+                    }
                     mqttMsgEntry->retryCount++;
                     result = 0;
                 }
@@ -404,6 +418,11 @@ static void mqtt_notification_callback(MQTT_MESSAGE_HANDLE msgHandle, void* call
 
             const APP_PAYLOAD* appPayload = mqttmessage_getApplicationMsg(msgHandle);
             IOTHUB_MESSAGE_HANDLE IoTHubMessage = IoTHubMessage_CreateFromByteArray(appPayload->message, appPayload->length);
+            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_025: [ Every message received shall add the length of its payload to IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_RECEIVED, if there are metrics. ] */
+            if (transportData->metrics != NULL)
+            {
+                iothub_client_metrics_add(transportData->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_RECEIVED, appPayload->length);
+            }
             if (IoTHubMessage == NULL)
             {
                 LogError("Failure: IotHub Message creation has failed.");
@@ -453,6 +472,7 @@ static void mqtt_operation_complete_callback(MQTT_CLIENT_HANDLE handle, MQTT_CLI
                         if (puback->packetId == mqttMsgEntry->packet_id)
                         {
                             (void)DList_RemoveEntryList(currentListEntry); //First remove the item from Waiting for Ack List.
+                            IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_ACK, mqttMsgEntry->iotHubMessageEntry->messageHandle);
                             sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_OK);
                             free(mqttMsgEntry);
                         }
@@ -474,6 +494,8 @@ static void mqtt_operation_complete_callback(MQTT_CLIENT_HANDLE handle, MQTT_CLI
                     {
                         // The connect packet has been acked
                         transport_data->currPacketState = CONNACK_TYPE;
+                        /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_012: [ When the CONNACK accepts the connection the retry control shall be reset. ] */
+                        retry_control_reset(transport_data->retryControl);
                     }
                     else
                     {
@@ -646,47 +668,46 @@ static int GetTransportProviderIfNecessary(PMQTTTRANSPORT_HANDLE_DATA transport_
 static int SendMqttConnectMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data)
 {
     int result;
+    const char* sasToken;
+    size_t sasTokenAge = 0;
 
-    // Not checking the success of this variable, if fail it will fail in the SASToken creation and return false;
-    STRING_HANDLE emptyKeyName = STRING_new();
-    if (emptyKeyName == NULL)
-    {
-        result = __LINE__;
-    }
-    else
+    switch (transport_data->transport_creds.credential_type)
     {
-        STRING_HANDLE sasToken = NULL;
-
-        switch (transport_data->transport_creds.credential_type)
+        case SAS_TOKEN_FROM_USER:
+            sasToken = STRING_c_str(transport_data->transport_creds.CREDENTIAL_VALUE.deviceSasToken);
+            break;
+        case DEVICE_KEY:
         {
-            case SAS_TOKEN_FROM_USER:
-                sasToken = STRING_clone(transport_data->transport_creds.CREDENTIAL_VALUE.deviceSasToken);
-                break;
-            case DEVICE_KEY:
+            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_021: [ When the credentials are a device key, the password shall be the token returned by sastoken_cache_get_token, so that a reconnect reuses a token that is young enough. ] */
+            size_t creationTime;
+            sasToken = sastoken_cache_get_token(transport_data->sasTokenCache, &creationTime);
+            if (sasToken != NULL)
             {
-                // Construct SAS token
                 size_t secSinceEpoch = (size_t)(difftime(get_time(NULL), EPOCH_TIME_T_VALUE) + 0);
-                size_t expiryTime = secSinceEpoch + SAS_TOKEN_DEFAULT_LIFETIME;
-
-                sasToken = SASToken_Create(transport_data->transport_creds.CREDENTIAL_VALUE.deviceKey, transport_data->devicesPath, emptyKeyName, expiryTime);
-                break;
+                sasTokenAge = (secSinceEpoch > creationTime) ? (secSinceEpoch - creationTime) : 0;
             }
-            case X509:
-            default:
-                // The assumption here is that x509 is in place, if not setup
-                // correctly the connection will be rejected.
-                sasToken = NULL;
-                break;
+            break;
         }
+        case X509:
+        default:
+            // The assumption here is that x509 is in place, if not setup
+            // correctly the connection will be rejected.
+            sasToken = NULL;
+            break;
+    }
 
+    if ((sasToken == NULL) && (transport_data->transport_creds.credential_type == DEVICE_KEY))
+    {
+        LogError("failure getting a SAS token.");
+        result = __LINE__;
+    }
+    else
+    {
         MQTT_CLIENT_OPTIONS options = { 0 };
         options.clientId = (char*)STRING_c_str(transport_data->device_id);
         options.willMessage = NULL;
         options.username = (char*)STRING_c_str(transport_data->configPassedThroughUsername);
-        if (sasToken != NULL)
-        {
-            options.password = (char*)STRING_c_str(sasToken);
-        }
+        options.password = (char*)sasToken;
         options.keepAliveInterval = transport_data->keepAliveValue;
         options.useCleanSession = false;
         options.qualityOfServiceValue = DELIVER_AT_LEAST_ONCE;
@@ -701,6 +722,12 @@ static int SendMqttConnectMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data)
             else
             {
                 (void)tickcounter_get_current_ms(g_msgTickCounter, &transport_data->mqtt_connect_time);
+                transport_data->sas_token_age_at_connect = sasTokenAge;
+                /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_026: [ Every successful call to mqtt_client_connect shall add 1 to IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS, if there are metrics. ] */
+                if (transport_data->metrics != NULL)
+                {
+                    iothub_client_metrics_add(transport_data->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS, 1);
+                }
                 result = 0;
             }
         }
@@ -708,8 +735,6 @@ static int SendMqttConnectMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data)
         {
             result = __LINE__;
         }
-        STRING_delete(emptyKeyName);
-        STRING_delete(sasToken);
     }
     return result;
 }
@@ -725,44 +750,26 @@ static int InitializeConnection(PMQTTTRANSPORT_HANDLE_DATA transport_data)
         // to back off the connecting to the server
         if (!transport_data->isConnected)
         {
-            // Default makeConnection as true if something goes wrong we'll make the connection
-            bool makeConnection = true;
-            // If we've failed for FAILED_CONN_BACKOFF_VALUE straight times them let's slow down connection
-            // to the service
-            if (transport_data->connectFailCount > FAILED_CONN_BACKOFF_VALUE)
+            RETRY_ACTION retryAction;
+
+            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_011: [ Before connecting IoTHubTransportMqtt_DoWork shall ask the retry control whether a connection attempt can be made now, and only connect when the answer is RETRY_ACTION_RETRY_NOW. ] */
+            if (retry_control_should_retry(transport_data->retryControl, &retryAction) != 0)
             {
-                uint64_t currentTick;
-                if (tickcounter_get_current_ms(g_msgTickCounter, &currentTick) == 0)
-                {
-                    if ( ((currentTick - transport_data->connectTick)/1000) <= DEFAULT_CONNECTION_INTERVAL)
-                    {
-                        result = __LINE__;
-                        makeConnection = false;
-                    }
-                }
+                LogError("failure querying the retry control");
+                result = __LINE__;
             }
-
-            if (makeConnection)
+            else if (retryAction != RETRY_ACTION_RETRY_NOW)
             {
-                if (tickcounter_get_current_ms(g_msgTickCounter, &transport_data->connectTick) != 0)
-                {
-                    transport_data->connectFailCount++;
-                    result = __LINE__;
-                }
-                else
-                {
-                    if (SendMqttConnectMsg(transport_data) != 0)
-                    {
-                        transport_data->connectFailCount++;
-                        result = __LINE__;
-                    }
-                    else
-                    {
-                        transport_data->connectFailCount = 0;
-                        transport_data->isConnected = true;
-                        result = 0;
-                    }
-                }
+                result = __LINE__;
+            }
+            else if (SendMqttConnectMsg(transport_data) != 0)
+            {
+                result = __LINE__;
+            }
+            else
+            {
+                transport_data->isConnected = true;
+                result = 0;
             }
         }
 
@@ -772,14 +779,18 @@ static int InitializeConnection(PMQTTTRANSPORT_HANDLE_DATA transport_data)
             uint64_t current_time;
             if (tickcounter_get_current_ms(g_msgTickCounter, &current_time) != 0)
             {
-                transport_data->connectFailCount++;
                 result = __LINE__;
             }
             else
             {
-                if ((current_time - transport_data->mqtt_connect_time) / 1000 > (SAS_TOKEN_DEFAULT_LIFETIME*SAS_REFRESH_MULTIPLIER))
+                if ((current_time - transport_data->mqtt_connect_time) / 1000 + transport_data->sas_token_age_at_connect > (SAS_TOKEN_DEFAULT_LIFETIME*SAS_REFRESH_MULTIPLIER))
                 {
                     (void)mqtt_client_disconnect(transport_data->mqttClient);
+                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_027: [ Every disconnect made to renew the SAS token shall add 1 to IOTHUB_CLIENT_METRIC_TRANSPORT_AUTH_REFRESHES, if there are metrics. ] */
+                    if (transport_data->metrics != NULL)
+                    {
+                        iothub_client_metrics_add(transport_data->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_AUTH_REFRESHES, 1);
+                    }
                     transport_data->isConnected = false;
                     transport_data->currPacketState = UNKNOWN_TYPE;
                     if (transport_data->topic_MqttMessage != NULL)
@@ -815,6 +826,14 @@ static int construct_credential_information(const IOTHUB_CLIENT_CONFIG* upperCon
             STRING_delete(transport_data->transport_creds.CREDENTIAL_VALUE.deviceKey);
             result = __LINE__;
         }
+        /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_020: [ If the credentials are a device key, IoTHubTransportMqtt_Create shall create a SAS token cache for the device key and the devices path. ] */
+        else if ((transport_data->sasTokenCache = sastoken_cache_create(transport_data->transport_creds.CREDENTIAL_VALUE.deviceKey, transport_data->devicesPath, NULL)) == NULL)
+        {
+            LogError("Could not create the SAS token cache for MQTT");
+            STRING_delete(transport_data->devicesPath);
+            STRING_delete(transport_data->transport_creds.CREDENTIAL_VALUE.deviceKey);
+            result = __LINE__;
+        }
         else
         {
             transport_data->transport_creds.credential_type = DEVICE_KEY;
@@ -832,6 +851,7 @@ static int construct_credential_information(const IOTHUB_CLIENT_CONFIG* upperCon
         {
             transport_data->transport_creds.credential_type = SAS_TOKEN_FROM_USER;
             transport_data->devicesPath = NULL;
+            transport_data->sasTokenCache = NULL;
             result = 0;
         }
     }
@@ -840,6 +860,7 @@ static int construct_credential_information(const IOTHUB_CLIENT_CONFIG* upperCon
         /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_041: [If both deviceKey and deviceSasToken fields are NULL then IoTHubTransportMqtt_Create shall assume a x509 authentication.] */
         transport_data->transport_creds.credential_type = X509;
         transport_data->devicesPath = NULL;
+        transport_data->sasTokenCache = NULL;
         result = 0;
     }
     return result;
@@ -873,6 +894,7 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
             if (state->transport_creds.credential_type == DEVICE_KEY)
             {
                 STRING_delete(state->transport_creds.CREDENTIAL_VALUE.deviceKey);
+                sastoken_cache_destroy(state->sasTokenCache);
             }
             else if (state->transport_creds.credential_type == SAS_TOKEN_FROM_USER)
             {
@@ -892,6 +914,7 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                 if (state->transport_creds.credential_type == DEVICE_KEY)
                 {
                     STRING_delete(state->transport_creds.CREDENTIAL_VALUE.deviceKey);
+                    sastoken_cache_destroy(state->sasTokenCache);
                 }
                 else if (state->transport_creds.credential_type == SAS_TOKEN_FROM_USER)
                 {
@@ -921,6 +944,7 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                     if (state->transport_creds.credential_type == DEVICE_KEY)
                     {
                         STRING_delete(state->transport_creds.CREDENTIAL_VALUE.deviceKey);
+                        sastoken_cache_destroy(state->sasTokenCache);
                     }
                     else if (state->transport_creds.credential_type == SAS_TOKEN_FROM_USER)
                     {
@@ -938,12 +962,35 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                     if (state->transport_creds.credential_type == DEVICE_KEY)
                     {
                         STRING_delete(state->transport_creds.CREDENTIAL_VALUE.deviceKey);
+                        sastoken_cache_destroy(state->sasTokenCache);
+                    }
+                    else if (state->transport_creds.credential_type == SAS_TOKEN_FROM_USER)
+                    {
+                        STRING_delete(state->transport_creds.CREDENTIAL_VALUE.deviceSasToken);
+                    }
+                    mqtt_client_deinit(state->mqttClient);
+                    STRING_delete(state->hostAddress);
+                    STRING_delete(state->topic_MqttEvent);
+                    STRING_delete(state->device_id);
+                    free(state);
+                    state = NULL;
+                }
+                /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_013: [ IoTHubTransportMqtt_Create shall create a retry control with the IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER policy and no timeout limit, seeded with the device id. ] */
+                else if ((state->retryControl = retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, upperConfig->deviceId)) == NULL)
+                {
+                    LogError("failure creating the retry control.");
+                    STRING_delete(state->devicesPath);
+                    if (state->transport_creds.credential_type == DEVICE_KEY)
+                    {
+                        STRING_delete(state->transport_creds.CREDENTIAL_VALUE.deviceKey);
+                        sastoken_cache_destroy(state->sasTokenCache);
                     }
                     else if (state->transport_creds.credential_type == SAS_TOKEN_FROM_USER)
                     {
                         STRING_delete(state->transport_creds.CREDENTIAL_VALUE.deviceSasToken);
                     }
                     mqtt_client_deinit(state->mqttClient);
+                    STRING_delete(state->configPassedThroughUsername);
                     STRING_delete(state->hostAddress);
                     STRING_delete(state->topic_MqttEvent);
                     STRING_delete(state->device_id);
@@ -964,8 +1011,7 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                     state->waitingToSend = waitingToSend;
                     state->currPacketState = CONNECT_TYPE;
                     state->keepAliveValue = DEFAULT_MQTT_KEEPALIVE;
-                    state->connectFailCount = 0;
-                    state->connectTick = 0;
+                    state->sas_token_age_at_connect = 0;
                     state->topic_MqttMessage = NULL;
                     state->topics_ToSubscribe = UNSUBSCRIBE_FROM_TOPIC;
                     state->log_trace = state->raw_trace = false;
@@ -1046,6 +1092,7 @@ TRANSPORT_LL_HANDLE IoTHubTransport_MQTT_Common_Create(const IOTHUBTRANSPORT_CON
         else
         {
             result->get_io_transport = get_io_transport;
+            result->metrics = config->metrics;
         }
     }
     /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_009: [If any error is encountered then IoTHubTransportMqtt_Create shall return NULL.] */
@@ -1088,6 +1135,7 @@ void IoTHubTransport_MQTT_Common_Destroy(TRANSPORT_LL_HANDLE handle)
                 STRING_delete(transport_data->transport_creds.CREDENTIAL_VALUE.deviceSasToken);
                 break;
             case DEVICE_KEY:
+                sastoken_cache_destroy(transport_data->sasTokenCache);
                 STRING_delete(transport_data->transport_creds.CREDENTIAL_VALUE.deviceKey);
                 STRING_delete(transport_data->devicesPath);
                 break;
@@ -1103,6 +1151,7 @@ void IoTHubTransport_MQTT_Common_Destroy(TRANSPORT_LL_HANDLE handle)
         STRING_delete(transport_data->device_id);
         STRING_delete(transport_data->hostAddress);
         STRING_delete(transport_data->configPassedThroughUsername);
+        retry_control_destroy(transport_data->retryControl);
         tickcounter_destroy(g_msgTickCounter);
         free(transport_data);
     }
@@ -1240,6 +1289,7 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
                     IOTHUB_MESSAGE_LIST* iothubMsgList = containingRecord(currentListEntry, IOTHUB_MESSAGE_LIST, entry);
                     DLIST_ENTRY savedFromCurrentListEntry;
                     savedFromCurrentListEntry.Flink = currentListEntry->Flink;
+                    IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_DEQUEUE, iothubMsgList->messageHandle);
 
                     /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_027: [IoTHubTransportMqtt_DoWork shall inspect the "waitingToSend" DLIST passed in config structure.] */
                     size_t messageLength;
@@ -1311,6 +1361,31 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_GetSendStatus(IOTHUB_DEVICE_HAN
     return result;
 }
 
+int IoTHubTransport_MQTT_Common_SetRetryPolicy(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds)
+{
+    int result;
+    PMQTTTRANSPORT_HANDLE_DATA transport_data = (PMQTTTRANSPORT_HANDLE_DATA)handle;
+
+    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_014: [ If handle is NULL then IoTHubTransportMqtt_SetRetryPolicy shall fail and return a non-zero value. ] */
+    if (transport_data == NULL)
+    {
+        LogError("Invalid handle parameter. NULL.");
+        result = __LINE__;
+    }
+    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_015: [ IoTHubTransportMqtt_SetRetryPolicy shall pass the policy and the timeout limit to the retry control and return what retry_control_set_policy returns. ] */
+    else if (retry_control_set_policy(transport_data->retryControl, retryPolicy, retryTimeoutLimitInSeconds) != 0)
+    {
+        LogError("failure setting the retry policy");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_SetOption(TRANSPORT_LL_HANDLE handle, const char* option, const void* value)
 {
     /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_021: [If any parameter is NULL then IoTHubTransportMqtt_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.] */
@@ -1356,6 +1431,27 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_SetOption(TRANSPORT_LL_HANDLE h
             }
             result = IOTHUB_CLIENT_OK;
         }
+        /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_022: [ If the option parameter is set to "sas_token_reuse_percent" then the value shall be a size_t* giving the percent of the SAS token lifetime during which the token is reused on reconnect. ] */
+        else if (strcmp(OPTION_SAS_TOKEN_REUSE_PERCENT, option) == 0)
+        {
+            if (transport_data->transport_creds.credential_type != DEVICE_KEY)
+            {
+                /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_023: [ If the credentials are not a device key, or if the value is not below the reconnect threshold of 80 percent, IoTHubTransportMqtt_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ] */
+                LogError("sas_token_reuse_percent specified, but authentication method is not a device key");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            /*a reused token must still be younger than the age at which the connection is dropped to refresh it*/
+            else if ((*((size_t*)value) >= (size_t)(SAS_REFRESH_MULTIPLIER * 100)) ||
+                (sastoken_cache_set_lifetime(transport_data->sasTokenCache, SAS_TOKEN_DEFAULT_LIFETIME, *((size_t*)value)) != 0))
+            {
+                LogError("invalid sas_token_reuse_percent");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_039: [If the option parameter is set to "x509certificate" then the value shall be a const char of the certificate to be used for x509.] */
         else if ((strcmp(OPTION_X509_CERT, option) == 0) && (transport_data->transport_creds.credential_type != X509))
         {
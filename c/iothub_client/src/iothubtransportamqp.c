@@ -13,7 +13,6 @@
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/platform.h"
-#include "azure_c_shared_utility/sastoken.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/urlencode.h"
 #include "azure_c_shared_utility/tlsio.h"
@@ -34,6 +33,9 @@
 #include "iothub_client_private.h"
 #include "iothubtransportamqp.h"
 #include "iothub_client_version.h"
+#include "iothub_client_retry_control.h"
+#include "iothub_client_sastoken_cache.h"
+#include "iothub_client_trace.h"
 
 #define INDEFINITE_TIME ((time_t)(-1))
 
@@ -120,6 +122,10 @@ typedef struct AMQP_TRANSPORT_STATE_CBS_TAG
     CBS_STATE cbs_state;
     // Time when the current SAS token was created, in seconds since epoch.
     size_t current_sas_token_create_time;
+    // Time when the current SAS token was handed to cbs_put_token(), in seconds since epoch.
+    size_t current_sas_token_put_time;
+    // Signs the SAS tokens when the credential is a device key, NULL otherwise.
+    SASTOKEN_CACHE_HANDLE sas_token_cache;
 }AMQP_TRANSPORT_STATE_CBS;
 
 typedef struct AMQP_TRANSPORT_STATE_TAG
@@ -155,6 +161,8 @@ typedef struct AMQP_TRANSPORT_STATE_TAG
     AMQP_MANAGEMENT_STATE connection_state;
     // Last time the AMQP connection establishment was initiated.
     size_t connection_establish_time;
+    // Decides when the connection can be (re)established.
+    RETRY_CONTROL_HANDLE retry_control;
     // AMQP session.
     SESSION_HANDLE session;
     // AMQP link used by the event sender.
@@ -182,8 +190,18 @@ typedef struct AMQP_TRANSPORT_STATE_TAG
 
     /*here are the options from the xio layer if any is saved*/
     OPTIONHANDLER_HANDLE xioOptions;
+
+    // Where the TRANSPORT_* metrics are counted, NULL when the upper layer does not keep them.
+    IOTHUB_CLIENT_METRICS* metrics;
 } AMQP_TRANSPORT_INSTANCE;
 
+// Context of one event handed to messagesender_send, the completion needs the client handle of the transport.
+typedef struct AMQP_EVENT_SEND_CONTEXT_TAG
+{
+    AMQP_TRANSPORT_INSTANCE* transport_state;
+    IOTHUB_MESSAGE_LIST* message;
+} AMQP_EVENT_SEND_CONTEXT;
+
 
 
 // Auxiliary functions
@@ -264,12 +282,14 @@ static void removeEventFromInProgressList(IOTHUB_MESSAGE_LIST* message)
     DList_InitializeListHead(&message->entry);
 }
 
+// Codes_SRS_IOTHUBTRANSPORTAMQP_02_029: [An event rolled back to waitingToSend shall be put back at its head, the events rolled back together keeping the order in which they were taken, so waitingToSend stays in the order the upper layer built.]
 static void rollEventBackToWaitList(IOTHUB_MESSAGE_LIST* message, AMQP_TRANSPORT_INSTANCE* transport_state)
 {
     removeEventFromInProgressList(message);
-    DList_InsertTailList(transport_state->waitingToSend, &message->entry);
+    DList_InsertHeadList(transport_state->waitingToSend, &message->entry);
 }
 
+/*walks from the newest so every event lands in front of the ones taken after it*/
 static void rollEventsBackToWaitList(AMQP_TRANSPORT_INSTANCE* transport_state)
 {
     PDLIST_ENTRY entry = transport_state->inProgress.Blink;
@@ -282,11 +302,12 @@ static void rollEventsBackToWaitList(AMQP_TRANSPORT_INSTANCE* transport_state)
     }
 }
 
-static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_result)
+static void completeEvent(AMQP_TRANSPORT_INSTANCE* transport_state, IOTHUB_MESSAGE_LIST* message, MESSAGE_SEND_RESULT send_result)
 {
-    IOTHUB_MESSAGE_LIST* message = (IOTHUB_MESSAGE_LIST*)context;
+    DLIST_ENTRY completed;
+    IOTHUB_CLIENT_CONFIRMATION_RESULT iot_hub_send_result;
 
-    IOTHUB_CLIENT_RESULT iot_hub_send_result;
+    IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_ACK, message->messageHandle);
 
     // Codes_SRS_IOTHUBTRANSPORTAMQP_09_142: [The callback 'on_message_send_complete' shall pass to the upper layer callback an IOTHUB_CLIENT_CONFIRMATION_OK if the result received is MESSAGE_SEND_OK] 
     if (send_result == MESSAGE_SEND_OK)
@@ -299,23 +320,26 @@ static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_res
         iot_hub_send_result = IOTHUB_CLIENT_CONFIRMATION_ERROR;
     }
 
-    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_102: [The callback 'on_message_send_complete' shall invoke the upper layer callback for message received if provided] 
-    if (message->callback != NULL)
-    {
-        message->callback(iot_hub_send_result, message->context);
-    }
-
-    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_100: [The callback 'on_message_send_complete' shall remove the target message from the in-progress list after the upper layer callback] 
+    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_100: [The callback 'on_message_send_complete' shall remove the target message from the in-progress list]
     if (isEventInInProgressList(message))
     {
         removeEventFromInProgressList(message);
     }
 
-    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_151: [The callback 'on_message_send_complete' shall destroy the message handle (IOTHUB_MESSAGE_HANDLE) using IoTHubMessage_Destroy()]
-    IoTHubMessage_Destroy(message->messageHandle);
+    // Codes_SRS_IOTHUBTRANSPORTAMQP_02_025: [The callback 'on_message_send_complete' shall complete the event by calling IoTHubClient_LL_SendComplete with a list that contains only the event, which calls the upper layer callback, destroys the message handle and frees the IOTHUB_MESSAGE_LIST instance]
+    DList_InitializeListHead(&completed);
+    DList_InsertTailList(&completed, &message->entry);
+    IoTHubClient_LL_SendComplete(transport_state->iothub_client_handle, &completed, iot_hub_send_result);
+}
+
+static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_result)
+{
+    AMQP_EVENT_SEND_CONTEXT* send_context = (AMQP_EVENT_SEND_CONTEXT*)context;
 
-    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_152: [The callback 'on_message_send_complete' shall destroy the IOTHUB_MESSAGE_LIST instance]
-    free(message);
+    completeEvent(send_context->transport_state, send_context->message, send_result);
+
+    // Codes_SRS_IOTHUBTRANSPORTAMQP_02_026: [The callback 'on_message_send_complete' shall free the context that was given to messagesender_send]
+    free(send_context);
 }
 
 static void on_put_token_complete(void* context, CBS_OPERATION_RESULT operation_result, unsigned int status_code, const char* status_description)
@@ -639,14 +663,19 @@ static int establishConnection(AMQP_TRANSPORT_INSTANCE* transport_state)
     {
         destroyConnection(transport_state);
     }
+    /*Codes_SRS_IOTHUBTRANSPORTAMQP_02_022: [ Every connection established shall add 1 to IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS of the metrics given in IOTHUBTRANSPORT_CONFIG, if any. ]*/
+    else if (transport_state->metrics != NULL)
+    {
+        iothub_client_metrics_add(transport_state->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS, 1);
+    }
 
     return result;
 }
 
-static int handSASTokenToCbs(AMQP_TRANSPORT_INSTANCE* transport_state, STRING_HANDLE sasToken, size_t sas_token_create_time)
+static int handSASTokenToCbs(AMQP_TRANSPORT_INSTANCE* transport_state, const char* sasToken, size_t sas_token_create_time, size_t currentTimeInSeconds)
 {
     int result;
-    if (cbs_put_token(transport_state->cbs.cbs, CBS_AUDIENCE, STRING_c_str(transport_state->devicesPath), STRING_c_str(sasToken), on_put_token_complete, transport_state) != RESULT_OK)
+    if (cbs_put_token(transport_state->cbs.cbs, CBS_AUDIENCE, STRING_c_str(transport_state->devicesPath), sasToken, on_put_token_complete, transport_state) != RESULT_OK)
     {
         LogError("Failed applying new SAS token to CBS.");
         result = __LINE__;
@@ -655,6 +684,12 @@ static int handSASTokenToCbs(AMQP_TRANSPORT_INSTANCE* transport_state, STRING_HA
     {
         transport_state->cbs.cbs_state = CBS_STATE_AUTH_IN_PROGRESS;
         transport_state->cbs.current_sas_token_create_time = sas_token_create_time;
+        transport_state->cbs.current_sas_token_put_time = currentTimeInSeconds;
+        /*Codes_SRS_IOTHUBTRANSPORTAMQP_02_023: [ Every SAS token handed to cbs_put_token shall add 1 to IOTHUB_CLIENT_METRIC_TRANSPORT_AUTH_REFRESHES, if there are metrics. ]*/
+        if (transport_state->metrics != NULL)
+        {
+            iothub_client_metrics_add(transport_state->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_AUTH_REFRESHES, 1);
+        }
         result = RESULT_OK;
     }
     return result;
@@ -672,9 +707,6 @@ static int startAuthentication(AMQP_TRANSPORT_INSTANCE* transport_state)
 	}
 	else
 	{
-		// Codes_SRS_IOTHUBTRANSPORTAMQP_09_083: [SAS tokens expiration time shall be calculated using the number of seconds since Epoch UTC (Jan 1st 1970 00h00m00s000 GMT) to now (GMT), plus the 'sas_token_lifetime'.]
-		size_t new_expiry_time = currentTimeInSeconds + (transport_state->cbs.sas_token_lifetime / 1000);
-
 		STRING_HANDLE newSASToken;
 
 		switch (transport_state->credential.credentialType)
@@ -687,26 +719,31 @@ static int startAuthentication(AMQP_TRANSPORT_INSTANCE* transport_state)
 			}
 			case DEVICE_KEY:
 			{
-				newSASToken = SASToken_Create(transport_state->credential.credential.deviceKey, transport_state->devicesPath, transport_state->cbs.sasTokenKeyName, new_expiry_time);
-				if (newSASToken == NULL)
+				const char* cachedSASToken;
+				size_t sasTokenCreateTime;
+
+				// Codes_SRS_IOTHUBTRANSPORTAMQP_02_017: [When refreshing a SAS token that was already put, startAuthentication shall invalidate the SAS token cache so that a new token is signed.]
+				if (transport_state->cbs.cbs_state != CBS_STATE_IDLE)
+				{
+					sastoken_cache_invalidate(transport_state->cbs.sas_token_cache);
+				}
+
+				// Codes_SRS_IOTHUBTRANSPORTAMQP_09_083: [SAS tokens expiration time shall be calculated using the number of seconds since Epoch UTC (Jan 1st 1970 00h00m00s000 GMT) to now (GMT), plus the 'sas_token_lifetime'.]
+				// Codes_SRS_IOTHUBTRANSPORTAMQP_02_018: [The SAS token shall be obtained from sastoken_cache_get_token, which reuses the cached token on reconnect as long as it is younger than 'sas_token_refresh_time'.]
+				cachedSASToken = sastoken_cache_get_token(transport_state->cbs.sas_token_cache, &sasTokenCreateTime);
+				if (cachedSASToken == NULL)
 				{
 					LogError("Could not generate a new SAS token for the CBS.");
 					result = RESULT_FAILURE;
 				}
+				else if (handSASTokenToCbs(transport_state, cachedSASToken, sasTokenCreateTime, currentTimeInSeconds) != 0)
+				{
+					LogError("unable to handSASTokenToCbs");
+					result = RESULT_FAILURE;
+				}
 				else
 				{
-					if (handSASTokenToCbs(transport_state, newSASToken, currentTimeInSeconds) != 0)
-					{
-						LogError("unable to handSASTokenToCbs");
-						result = RESULT_FAILURE;
-					}
-					else
-					{
-						result = RESULT_OK;
-					}
-
-					// Codes_SRS_IOTHUBTRANSPORTAMQP_09_145: [Each new SAS token created shall be deleted from memory immediately after sending it to CBS]
-					STRING_delete(newSASToken);
+					result = RESULT_OK;
 				}
 				break;
 			}
@@ -720,7 +757,7 @@ static int startAuthentication(AMQP_TRANSPORT_INSTANCE* transport_state)
 				}
 				else
 				{
-					if (handSASTokenToCbs(transport_state, newSASToken, currentTimeInSeconds) != 0)
+					if (handSASTokenToCbs(transport_state, STRING_c_str(newSASToken), currentTimeInSeconds, currentTimeInSeconds) != 0)
 					{
 						LogError("unable to handSASTokenToCbs");
 						result = RESULT_FAILURE;
@@ -751,7 +788,7 @@ static int verifyAuthenticationTimeout(AMQP_TRANSPORT_INSTANCE* transport_state)
 	}
 	else
 	{
-		result = ((currentTimeInSeconds - transport_state->cbs.current_sas_token_create_time) * 1000 >= transport_state->cbs.cbs_request_timeout) ? RESULT_TIMEOUT : RESULT_OK;
+		result = ((currentTimeInSeconds - transport_state->cbs.current_sas_token_put_time) * 1000 >= transport_state->cbs.cbs_request_timeout) ? RESULT_TIMEOUT : RESULT_OK;
 	}
 	return result;
 }
@@ -838,6 +875,11 @@ void on_event_sender_state_changed(void* context, MESSAGE_SENDER_STATE new_state
         {
             transport_state->connection_state = AMQP_MANAGEMENT_STATE_ERROR;
         }
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_02_011: [When the message sender instance changes its state to MESSAGE_SENDER_STATE_OPEN the retry control shall be reset]
+        else if (new_state != previous_state && new_state == MESSAGE_SENDER_STATE_OPEN)
+        {
+            retry_control_reset(transport_state->retry_control);
+        }
     }
 }
 
@@ -1034,6 +1076,7 @@ static int sendPendingEvents(AMQP_TRANSPORT_INSTANCE* transport_state)
 
         // Codes_SRS_IOTHUBTRANSPORTAMQP_09_086: [IoTHubTransportAMQP_DoWork shall move queued events to an "in-progress" list right before processing them for sending]
         trackEventInProgress(message, transport_state);
+        IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_DEQUEUE, message->messageHandle);
 
 		// Codes_SRS_IOTHUBTRANSPORTAMQP_09_193: [IoTHubTransportAMQP_DoWork shall get a MESSAGE_HANDLE instance out of the event's IOTHUB_MESSAGE_HANDLE instance by using message_create_from_iothub_message().]
 		if ((result = message_create_from_iothub_message(message->messageHandle, &amqp_message)) != RESULT_OK)
@@ -1042,15 +1085,41 @@ static int sendPendingEvents(AMQP_TRANSPORT_INSTANCE* transport_state)
 			result = __LINE__;
 			is_message_error = true;
 		}
-		// Codes_SRS_IOTHUBTRANSPORTAMQP_09_097: [IoTHubTransportAMQP_DoWork shall pass the MESSAGE_HANDLE intance to uAMQP for sending (along with on_message_send_complete callback) using messagesender_send()] 
-		else if (messagesender_send(transport_state->message_sender, amqp_message, on_message_send_complete, message) != RESULT_OK)
-        {
-            LogError("Failed sending the AMQP message.");
-			result = __LINE__;
-        }
         else
         {
-            result = RESULT_OK;
+            AMQP_EVENT_SEND_CONTEXT* send_context;
+
+            IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_SERIALIZE, message->messageHandle);
+            // Codes_SRS_IOTHUBTRANSPORTAMQP_02_027: [IoTHubTransportAMQP_DoWork shall allocate a context that holds the transport instance and the event for on_message_send_complete]
+            if ((send_context = (AMQP_EVENT_SEND_CONTEXT*)malloc(sizeof(AMQP_EVENT_SEND_CONTEXT))) == NULL)
+            {
+                // Codes_SRS_IOTHUBTRANSPORTAMQP_02_028: [If allocating the context fails, IoTHubTransportAMQP_DoWork notify the failure, roll back the event to waitToSend list and return]
+                LogError("Failed allocating the send context of the AMQP message.");
+                result = __LINE__;
+            }
+            else
+            {
+                send_context->transport_state = transport_state;
+                send_context->message = message;
+
+                // Codes_SRS_IOTHUBTRANSPORTAMQP_09_097: [IoTHubTransportAMQP_DoWork shall pass the MESSAGE_HANDLE intance to uAMQP for sending (along with on_message_send_complete callback) using messagesender_send()] 
+                if (messagesender_send(transport_state->message_sender, amqp_message, on_message_send_complete, send_context) != RESULT_OK)
+                {
+                    LogError("Failed sending the AMQP message.");
+                    free(send_context);
+                    result = __LINE__;
+                }
+                else
+                {
+                    IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_WRITE, message->messageHandle);
+                    /*Codes_SRS_IOTHUBTRANSPORTAMQP_02_024: [ Every event handed to messagesender_send shall add 1 to IOTHUB_CLIENT_METRIC_TRANSPORT_EVENTS_SENT, if there are metrics. ]*/
+                    if (transport_state->metrics != NULL)
+                    {
+                        iothub_client_metrics_add(transport_state->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_EVENTS_SENT, 1);
+                    }
+                    result = RESULT_OK;
+                }
+            }
         }
 
 		// Codes_SRS_IOTHUBTRANSPORTAMQP_09_194: [IoTHubTransportAMQP_DoWork shall destroy the MESSAGE_HANDLE instance after messagesender_send() is invoked.]
@@ -1066,7 +1135,7 @@ static int sendPendingEvents(AMQP_TRANSPORT_INSTANCE* transport_state)
             // Codes_SRS_IOTHUBTRANSPORTAMQP_09_091: [If IoTHubMessage_GetString() fails, IoTHubTransportAMQP_DoWork shall remove the event from the in-progress list and invoke the upper layer callback reporting the error] 
             if (is_message_error)
             {
-                on_message_send_complete(message, MESSAGE_SEND_ERROR);
+                completeEvent(transport_state, message, MESSAGE_SEND_ERROR);
             }
             else
             {
@@ -1113,6 +1182,24 @@ static void prepareForConnectionRetry(AMQP_TRANSPORT_INSTANCE* transport_state)
 }
 
 
+static bool isConnectionAttemptAllowed(AMQP_TRANSPORT_INSTANCE* transport_state)
+{
+    bool result;
+    RETRY_ACTION retry_action;
+
+    if (retry_control_should_retry(transport_state->retry_control, &retry_action) != 0)
+    {
+        LogError("Failed querying the retry control.");
+        result = false;
+    }
+    else
+    {
+        result = (retry_action == RETRY_ACTION_RETRY_NOW);
+    }
+
+    return result;
+}
+
 static void credential_destroy(AMQP_TRANSPORT_INSTANCE* transport_state)
 {
     switch (transport_state->credential.credentialType)
@@ -1134,6 +1221,7 @@ static void credential_destroy(AMQP_TRANSPORT_INSTANCE* transport_state)
     }
     case(DEVICE_KEY):
     {
+        sastoken_cache_destroy(transport_state->cbs.sas_token_cache);
         STRING_delete(transport_state->credential.credential.deviceKey);
         break;
     }
@@ -1230,6 +1318,7 @@ static TRANSPORT_LL_HANDLE IoTHubTransportAMQP_Create(const IOTHUBTRANSPORT_CONF
             transport_state->connection = NULL;
             transport_state->connection_state = AMQP_MANAGEMENT_STATE_IDLE;
             transport_state->connection_establish_time = 0;
+            transport_state->retry_control = NULL;
             transport_state->iothub_client_handle = NULL;
             transport_state->receive_messages = false;
             transport_state->message_receiver = NULL;
@@ -1246,6 +1335,8 @@ static TRANSPORT_LL_HANDLE IoTHubTransportAMQP_Create(const IOTHUBTRANSPORT_CONF
             transport_state->cbs.sasTokenKeyName = NULL;
             transport_state->cbs.cbs_state = CBS_STATE_IDLE;
             transport_state->cbs.current_sas_token_create_time = 0;
+            transport_state->cbs.current_sas_token_put_time = 0;
+            transport_state->cbs.sas_token_cache = NULL;
             transport_state->cbs.sasl_io = NULL;
             transport_state->cbs.sasl_mechanism = NULL;
 
@@ -1253,6 +1344,7 @@ static TRANSPORT_LL_HANDLE IoTHubTransportAMQP_Create(const IOTHUBTRANSPORT_CONF
 
             transport_state->waitingToSend = config->waitingToSend;
             DList_InitializeListHead(&transport_state->inProgress);
+            transport_state->metrics = config->metrics;
 
             transport_state->credential.credentialType = CREDENTIAL_NOT_BUILD;
 
@@ -1284,6 +1376,13 @@ static TRANSPORT_LL_HANDLE IoTHubTransportAMQP_Create(const IOTHUBTRANSPORT_CONF
                 LogError("Failed to allocate transport_state->messageReceiveAddress.");
                 cleanup_required = true;
             }
+            // Codes_SRS_IOTHUBTRANSPORTAMQP_02_012: [IoTHubTransportAMQP_Create shall create a retry control with the IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER policy and no timeout limit, seeded with the device id]
+            else if ((transport_state->retry_control = retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, config->upperConfig->deviceId)) == NULL)
+            {
+                // Codes_SRS_IOTHUBTRANSPORTAMQP_02_013: [If creating the retry control fails IoTHubTransportAMQP_Create shall fail and return NULL]
+                LogError("Failed to create the retry control.");
+                cleanup_required = true;
+            }
             else
             {
                 if (config->upperConfig->deviceSasToken != NULL)
@@ -1332,6 +1431,13 @@ static TRANSPORT_LL_HANDLE IoTHubTransportAMQP_Create(const IOTHUBTRANSPORT_CONF
                                 LogError("unable to STRING_construct for a deviceKey");
                                 cleanup_required = true;
                             }
+                            // Codes_SRS_IOTHUBTRANSPORTAMQP_02_019: [If the credential is a device key, IoTHubTransportAMQP_Create shall create a SAS token cache for the device key, devicesPath and sasTokenKeyName.]
+                            else if ((transport_state->cbs.sas_token_cache = sastoken_cache_create(transport_state->credential.credential.deviceKey, transport_state->devicesPath, transport_state->cbs.sasTokenKeyName)) == NULL)
+                            {
+                                LogError("unable to create the SAS token cache");
+                                STRING_delete(transport_state->credential.credential.deviceKey);
+                                cleanup_required = true;
+                            }
                             else
                             {
                                 transport_state->credential.credentialType = DEVICE_KEY;
@@ -1376,6 +1482,8 @@ static TRANSPORT_LL_HANDLE IoTHubTransportAMQP_Create(const IOTHUBTRANSPORT_CONF
                     STRING_delete(transport_state->devicesPath);
                 if (transport_state->iotHubHostFqdn != NULL)
                     STRING_delete(transport_state->iotHubHostFqdn);
+                if (transport_state->retry_control != NULL)
+                    retry_control_destroy(transport_state->retry_control);
 
                 free(transport_state);
                 transport_state = NULL;
@@ -1415,6 +1523,7 @@ static void IoTHubTransportAMQP_Destroy(TRANSPORT_LL_HANDLE handle)
         credential_destroy(transport_state);
         STRING_delete(transport_state->devicesPath);
         STRING_delete(transport_state->iotHubHostFqdn);
+        retry_control_destroy(transport_state->retry_control);
 
         // Codes_SRS_IOTHUBTRANSPORTAMQP_09_036 : [IoTHubTransportAMQP_Destroy shall return the remaining items in inProgress to waitingToSend list.]
         rollEventsBackToWaitList(transport_state);
@@ -1444,6 +1553,7 @@ static void IoTHubTransportAMQP_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
     else
     {
         bool trigger_connection_retry = false;
+        bool wait_for_connection_retry = false;
         AMQP_TRANSPORT_INSTANCE* transport_state = (AMQP_TRANSPORT_INSTANCE*)handle;
 
         // Codes_SRS_IOTHUBTRANSPORTAMQP_09_147: [IoTHubTransportAMQP_DoWork shall save a reference to the client handle in transport_state->iothub_client_handle]
@@ -1455,6 +1565,12 @@ static void IoTHubTransportAMQP_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
             LogError("An error occured on AMQP connection. The connection will be restablished.");
             trigger_connection_retry = true;
         }
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_02_014: [If the transport handle has a NULL connection, IoTHubTransportAMQP_DoWork shall ask the retry control whether the connection can be established now, and return without doing any work if it cannot]
+        else if (transport_state->connection == NULL &&
+            !isConnectionAttemptAllowed(transport_state))
+        {
+            wait_for_connection_retry = true;
+        }
         // Codes_SRS_IOTHUBTRANSPORTAMQP_09_055: [If the transport handle has a NULL connection, IoTHubTransportAMQP_DoWork shall instantiate and initialize the AMQP components and establish the connection] 
         else if (transport_state->connection == NULL &&
             establishConnection(transport_state) != RESULT_OK)
@@ -1558,7 +1674,7 @@ static void IoTHubTransportAMQP_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
         {
             prepareForConnectionRetry(transport_state);
         }
-        else
+        else if (!wait_for_connection_retry)
         {
             // Codes_SRS_IOTHUBTRANSPORTAMQP_09_103: [IoTHubTransportAMQP_DoWork shall invoke connection_dowork() on AMQP for triggering sending and receiving messages] 
             connection_dowork(transport_state->connection);
@@ -1638,6 +1754,38 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportAMQP_GetSendStatus(IOTHUB_DEVICE_HAND
     return result;
 }
 
+static IOTHUB_CLIENT_RESULT updateSasTokenCacheLifetime(AMQP_TRANSPORT_INSTANCE* transport_state)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (transport_state->credential.credentialType != DEVICE_KEY)
+    {
+        result = IOTHUB_CLIENT_OK;
+    }
+    else
+    {
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_02_020: [When "sas_token_lifetime" or "sas_token_refresh_time" are set and the credential is a device key, IotHubTransportAMQP_SetOption shall call sastoken_cache_set_lifetime with the lifetime in seconds and the refresh time as a percent of the lifetime.]
+        size_t lifetimeInSeconds = transport_state->cbs.sas_token_lifetime / 1000;
+        size_t reusePercent = (transport_state->cbs.sas_token_lifetime == 0) ? 0 : (size_t)(((unsigned long long)transport_state->cbs.sas_token_refresh_time * 100) / transport_state->cbs.sas_token_lifetime);
+        if (reusePercent > 100)
+        {
+            reusePercent = 100;
+        }
+
+        if (sastoken_cache_set_lifetime(transport_state->cbs.sas_token_cache, lifetimeInSeconds, reusePercent) != 0)
+        {
+            // Codes_SRS_IOTHUBTRANSPORTAMQP_02_021: [If sastoken_cache_set_lifetime fails, IotHubTransportAMQP_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.]
+            LogError("unable to apply a SAS token lifetime of %lu ms", (unsigned long)transport_state->cbs.sas_token_lifetime);
+            result = IOTHUB_CLIENT_INVALID_ARG;
+        }
+        else
+        {
+            result = IOTHUB_CLIENT_OK;
+        }
+    }
+    return result;
+}
+
 static IOTHUB_CLIENT_RESULT IoTHubTransportAMQP_SetOption(TRANSPORT_LL_HANDLE handle, const char* option, const void* value)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1662,13 +1810,13 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportAMQP_SetOption(TRANSPORT_LL_HANDLE ha
         if (strcmp(OPTION_SAS_TOKEN_LIFETIME, option) == 0)
         {
             transport_state->cbs.sas_token_lifetime = *((size_t*)value);
-            result = IOTHUB_CLIENT_OK;
+            result = updateSasTokenCacheLifetime(transport_state);
         }
         // Codes_SRS_IOTHUBTRANSPORTAMQP_09_049: [IotHubTransportAMQP_SetOption shall save and apply the value if the option name is "sas_token_refresh_time", returning IOTHUB_CLIENT_OK] 
         else if (strcmp(OPTION_SAS_TOKEN_REFRESH_TIME, option) == 0)
         {
             transport_state->cbs.sas_token_refresh_time = *((size_t*)value);
-            result = IOTHUB_CLIENT_OK;
+            result = updateSasTokenCacheLifetime(transport_state);
         }
         // Codes_SRS_IOTHUBTRANSPORTAMQP_09_148: [IotHubTransportAMQP_SetOption shall save and apply the value if the option name is "cbs_request_timeout", returning IOTHUB_CLIENT_OK] 
         else if (strcmp(OPTION_CBS_REQUEST_TIMEOUT, option) == 0)
@@ -1740,6 +1888,30 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportAMQP_SetOption(TRANSPORT_LL_HANDLE ha
     return result;
 }
 
+static int IoTHubTransportAMQP_SetRetryPolicy(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds)
+{
+    int result;
+
+    // Codes_SRS_IOTHUBTRANSPORTAMQP_02_015: [IoTHubTransportAMQP_SetRetryPolicy shall fail and return a non-zero value if the transport handle parameter is NULL]
+    if (handle == NULL)
+    {
+        LogError("Invalid handle (NULL).");
+        result = __LINE__;
+    }
+    // Codes_SRS_IOTHUBTRANSPORTAMQP_02_016: [IoTHubTransportAMQP_SetRetryPolicy shall pass the policy and the timeout limit to the retry control by calling retry_control_set_policy and return 0 on success, non-zero otherwise]
+    else if (retry_control_set_policy(((AMQP_TRANSPORT_INSTANCE*)handle)->retry_control, retryPolicy, retryTimeoutLimitInSeconds) != 0)
+    {
+        LogError("Failed setting the retry policy.");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
 static IOTHUB_DEVICE_HANDLE IoTHubTransportAMQP_Register(TRANSPORT_LL_HANDLE handle, const IOTHUB_DEVICE_CONFIG* device, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, PDLIST_ENTRY waitingToSend)
 {
 #ifdef NO_LOGGING
@@ -1851,7 +2023,8 @@ static TRANSPORT_PROVIDER thisTransportProvider = {
     IoTHubTransportAMQP_Subscribe,
     IoTHubTransportAMQP_Unsubscribe,
     IoTHubTransportAMQP_DoWork,
-    IoTHubTransportAMQP_GetSendStatus
+    IoTHubTransportAMQP_GetSendStatus,
+    IoTHubTransportAMQP_SetRetryPolicy
 };
 
 extern const TRANSPORT_PROVIDER* AMQP_Protocol(void)
@@ -43,7 +43,8 @@ static TRANSPORT_PROVIDER thisTransportProvider_WebSocketsOverTls = {
 	IoTHubTransportAMQP_Subscribe,
 	IoTHubTransportAMQP_Unsubscribe,
 	IoTHubTransportAMQP_DoWork,
-	IoTHubTransportAMQP_GetSendStatus
+	IoTHubTransportAMQP_GetSendStatus,
+	IoTHubTransportAMQP_SetRetryPolicy
 };
 
 extern const TRANSPORT_PROVIDER* AMQP_Protocol_over_WebSocketsTls(void)
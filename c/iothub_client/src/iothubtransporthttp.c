@@ -13,6 +13,8 @@
 #include "iothub_client_private.h"
 #include "iothub_transport_ll.h"
 #include "iothubtransporthttp.h"
+#include "iothub_client_retry_control.h"
+#include "iothub_client_trace.h"
 
 #include "azure_c_shared_utility/httpapiexsas.h"
 #include "azure_c_shared_utility/urlencode.h"
@@ -52,6 +54,9 @@ typedef struct HTTPTRANSPORT_HANDLE_DATA_TAG
     bool doBatchedTransfers;
     unsigned int getMinimumPollingTime;
     VECTOR_HANDLE perDeviceList;
+    RETRY_CONTROL_HANDLE retryControl;
+    bool isRetryPending; /*set when a request to the service failed, cleared by the next success*/
+    IOTHUB_CLIENT_METRICS* metrics; /*where the TRANSPORT_* metrics are counted, NULL when the upper layer does not keep them*/
 }HTTPTRANSPORT_HANDLE_DATA;
 
 typedef struct HTTPTRANSPORT_PERDEVICE_DATA_TAG
@@ -760,6 +765,68 @@ static bool create_perDeviceList(HTTPTRANSPORT_HANDLE_DATA* handleData)
     return result;
 }
 
+static void destroy_retryControl(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    retry_control_destroy(handleData->retryControl);
+    handleData->retryControl = NULL;
+}
+
+/*Codes_SRS_TRANSPORTMULTITHTTP_02_021: [ IoTHubTransportHttp_Create shall create a retry control with the IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER policy and no timeout limit. ]*/
+static bool create_retryControl(HTTPTRANSPORT_HANDLE_DATA* handleData, const IOTHUBTRANSPORT_CONFIG* config)
+{
+    bool result;
+    handleData->retryControl = retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, config->upperConfig->deviceId);
+    if (handleData->retryControl == NULL)
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_02_022: [ If creating the retry control fails, then IoTHubTransportHttp_Create shall fail and return NULL. ]*/
+        LogError("unable to create the retry control");
+        result = false;
+    }
+    else
+    {
+        handleData->isRetryPending = false;
+        result = true;
+    }
+    return result;
+}
+
+static void onRequestFailed(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    /*Codes_SRS_TRANSPORTMULTITHTTP_02_023: [ When a request to send events fails or completes with a http status code >=300, the following calls to IoTHubTransportHttp_DoWork shall do nothing until the retry control allows a new attempt. ]*/
+    if (!handleData->isRetryPending)
+    {
+        RETRY_ACTION retryAction;
+        /*the failed request is the first attempt, this starts the wait before the next one*/
+        (void)retry_control_should_retry(handleData->retryControl, &retryAction);
+        handleData->isRetryPending = true;
+    }
+}
+
+static void onRequestSucceeded(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    /*Codes_SRS_TRANSPORTMULTITHTTP_02_024: [ When a request to send events succeeds the retry control shall be reset. ]*/
+    if (handleData->isRetryPending)
+    {
+        retry_control_reset(handleData->retryControl);
+        handleData->isRetryPending = false;
+    }
+}
+
+/*Codes_SRS_TRANSPORTMULTITHTTP_02_029: [ Every request that sent events successfully shall add the number of events to IOTHUB_CLIENT_METRIC_TRANSPORT_EVENTS_SENT and the length of the body to IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_SENT of the metrics given in IOTHUBTRANSPORT_CONFIG, if any. ]*/
+static void countSentEvents(HTTPTRANSPORT_HANDLE_DATA* handleData, PDLIST_ENTRY sent, size_t byteCount)
+{
+    if (handleData->metrics != NULL)
+    {
+        size_t eventCount = 0;
+        PDLIST_ENTRY current;
+        for (current = sent->Flink; current != sent; current = current->Flink)
+        {
+            eventCount++;
+        }
+        iothub_client_metrics_add(handleData->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_EVENTS_SENT, eventCount);
+        iothub_client_metrics_add(handleData->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_SENT, byteCount);
+    }
+}
 
 static TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONFIG* config)
 {
@@ -808,16 +875,19 @@ static TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONF
             bool was_hostName_ok = create_hostName(result, config);
             bool was_httpApiExHandle_ok = was_hostName_ok && create_httpApiExHandle(result, config);
             bool was_perDeviceList_ok = was_httpApiExHandle_ok && create_perDeviceList(result);
+            bool was_retryControl_ok = was_perDeviceList_ok && create_retryControl(result, config);
 
 
-            if (was_perDeviceList_ok)
+            if (was_retryControl_ok)
             {
                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_011: [ Otherwise, IoTHubTransportHttp_Create shall succeed and return a non-NULL value. ]*/
                 result->doBatchedTransfers = false;
                 result->getMinimumPollingTime = DEFAULT_GETMINIMUMPOLLINGTIME;
+                result->metrics = config->metrics;
             }
             else
             {
+                if (was_perDeviceList_ok) destroy_perDeviceList(result);
                 if (was_httpApiExHandle_ok) destroy_httpApiExHandle(result);
                 if (was_hostName_ok) destroy_hostName(result);
 
@@ -851,6 +921,7 @@ static void IoTHubTransportHttp_Destroy(TRANSPORT_LL_HANDLE handle)
         destroy_hostName((HTTPTRANSPORT_HANDLE_DATA *) handle);
         destroy_httpApiExHandle((HTTPTRANSPORT_HANDLE_DATA *) handle);
         destroy_perDeviceList((HTTPTRANSPORT_HANDLE_DATA *)handle);
+        destroy_retryControl((HTTPTRANSPORT_HANDLE_DATA *)handle);
         free(handle);
     }
 }
@@ -1162,95 +1233,109 @@ static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData,
     else
     {
         bool isFirst = true;
-        PDLIST_ENTRY actual;
+        PDLIST_ENTRY actual = deviceData->waitingToSend->Flink;
+        IOTHUB_MESSAGE_PRIORITY batchPriority = IOTHUB_MESSAGE_PRIORITY_NORMAL;
         bool keepGoing = true; /*keepGoing gets sometimes to false from within the loop*/
                                /*either all the items enter the list or only some*/
         result = MAKE_PAYLOAD_OK; /*optimistically initializing it*/
-        while (keepGoing && ((actual = deviceData->waitingToSend->Flink) != deviceData->waitingToSend))
+        while (keepGoing && (actual != deviceData->waitingToSend))
         {
-            size_t messageSize;
-            STRING_HANDLE temp = make1EventJSONitem(actual, &messageSize);
-            if (isFirst)
+            PDLIST_ENTRY next = actual->Flink;
+            /*Codes_SRS_TRANSPORTMULTITHTTP_02_028: [ A batch shall only contain events of the priority of the first event in waitingToSend, it is built from the events of that priority across the whole of waitingToSend and the events of other priorities stay in waitingToSend. ]*/
+            if (!isFirst && (containingRecord(actual, IOTHUB_MESSAGE_LIST, entry)->priority != batchPriority))
             {
-                isFirst = false;
-                /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
-                if (temp == NULL) /*first item failed to create, nothing to send*/
-                {
-                    result = MAKE_PAYLOAD_ERROR;
-                    STRING_delete(*payload);
-                    *payload = NULL;
-                    keepGoing = false;
-                }
-                else
+                /*another lane, it stays in waitingToSend for a later batch*/
+            }
+            else
+            {
+                size_t messageSize;
+                STRING_HANDLE temp;
+                IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_DEQUEUE, containingRecord(actual, IOTHUB_MESSAGE_LIST, entry)->messageHandle);
+                temp = make1EventJSONitem(actual, &messageSize);
+                if (isFirst)
                 {
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_065: [If the oldest message in waitingToSend causes the message size to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_BATCHSTATE_FAILED.]*/
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_061: [The message size shall be limited to 255KB - 1 byte.]*/
-                    if (messageSize > MAXIMUM_MESSAGE_SIZE)
+                    isFirst = false;
+                    batchPriority = containingRecord(actual, IOTHUB_MESSAGE_LIST, entry)->priority;
+                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
+                    if (temp == NULL) /*first item failed to create, nothing to send*/
                     {
-                        PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                        DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                        result = MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT;
+                        result = MAKE_PAYLOAD_ERROR;
                         STRING_delete(*payload);
                         *payload = NULL;
                         keepGoing = false;
                     }
                     else
                     {
-                        if (STRING_concat_with_STRING(*payload, temp) != 0)
+                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_065: [If the oldest message in waitingToSend causes the message size to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_BATCHSTATE_FAILED.]*/
+                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_061: [The message size shall be limited to 255KB - 1 byte.]*/
+                        if (messageSize > MAXIMUM_MESSAGE_SIZE)
                         {
-                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
-                            result = MAKE_PAYLOAD_ERROR;
+                            (void)DList_RemoveEntryList(actual);
+                            DList_InsertTailList(&(deviceData->eventConfirmations), actual);
+                            result = MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT;
                             STRING_delete(*payload);
                             *payload = NULL;
                             keepGoing = false;
                         }
                         else
                         {
-                            /*first item was put nicely in the payload*/
-                            PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                            DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                            allMessagesSize += messageSize;
+                            if (STRING_concat_with_STRING(*payload, temp) != 0)
+                            {
+                                /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
+                                result = MAKE_PAYLOAD_ERROR;
+                                STRING_delete(*payload);
+                                *payload = NULL;
+                                keepGoing = false;
+                            }
+                            else
+                            {
+                                /*first item was put nicely in the payload*/
+                                (void)DList_RemoveEntryList(actual);
+                                DList_InsertTailList(&(deviceData->eventConfirmations), actual);
+                                allMessagesSize += messageSize;
+                            }
                         }
+                        STRING_delete(temp);
                     }
-                    STRING_delete(temp);
-                }
-            }
-            else
-            {
-                /*there is at least 1 item already in the payload*/
-                if (temp == NULL)
-                {
-                    /*there are multiple payloads encoded, the last one had an internal error, just go with those - closing the payload happens "after the loop"*/
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
-                    result = MAKE_PAYLOAD_OK;
-                    keepGoing = false;
                 }
                 else
                 {
-                    if (allMessagesSize + messageSize > MAXIMUM_MESSAGE_SIZE)
-                    {
-                        /*this item doesn't make it to the payload, but the payload is valid so far*/
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
-                        result = MAKE_PAYLOAD_OK;
-                        keepGoing = false;
-                    }
-                    else if (STRING_concat_with_STRING(*payload, temp) != 0)
+                    /*there is at least 1 item already in the payload*/
+                    if (temp == NULL)
                     {
-                        /*should still send what there is so far...*/
+                        /*there are multiple payloads encoded, the last one had an internal error, just go with those - closing the payload happens "after the loop"*/
                         /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
                         result = MAKE_PAYLOAD_OK;
                         keepGoing = false;
                     }
                     else
                     {
-                        /*cool, the payload made it there, let's continue... */
-                        PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                        DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                        allMessagesSize += messageSize;
+                        if (allMessagesSize + messageSize > MAXIMUM_MESSAGE_SIZE)
+                        {
+                            /*this item doesn't make it to the payload, but the payload is valid so far*/
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
+                            result = MAKE_PAYLOAD_OK;
+                            keepGoing = false;
+                        }
+                        else if (STRING_concat_with_STRING(*payload, temp) != 0)
+                        {
+                            /*should still send what there is so far...*/
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
+                            result = MAKE_PAYLOAD_OK;
+                            keepGoing = false;
+                        }
+                        else
+                        {
+                            /*cool, the payload made it there, let's continue... */
+                            (void)DList_RemoveEntryList(actual);
+                            DList_InsertTailList(&(deviceData->eventConfirmations), actual);
+                            allMessagesSize += messageSize;
+                        }
+                        STRING_delete(temp);
                     }
-                    STRING_delete(temp);
                 }
             }
+            actual = next;
         }
 
         /*closing the payload*/
@@ -1302,6 +1387,7 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                 {
                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_068: [Once a final payload has been obtained, IoTHubTransportHttp_DoWork shall call HTTPAPIEX_SAS_ExecuteRequest passing the following parameters:] */
                     BUFFER_HANDLE temp = BUFFER_new();
+                    IOTHUB_CLIENT_TRACE_MESSAGE_LIST(IOTHUB_CLIENT_TRACE_STAGE_SERIALIZE, &(deviceData->eventConfirmations));
                     if (temp == NULL)
                     {
                         LogError("unable to BUFFER_new");
@@ -1310,7 +1396,8 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                     }
                     else
                     {
-                        if (BUFFER_build(temp, (const unsigned char*)STRING_c_str(payload), STRING_length(payload)) != 0)
+                        size_t payloadLength = STRING_length(payload);
+                        if (BUFFER_build(temp, (const unsigned char*)STRING_c_str(payload), payloadLength) != 0)
                         {
                             LogError("unable to BUFFER_build");
                             //items go back to waitingToSend
@@ -1321,6 +1408,7 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                         {
                             unsigned int statusCode;
                             HTTPAPIEX_RESULT r;
+                            IOTHUB_CLIENT_TRACE_MESSAGE_LIST(IOTHUB_CLIENT_TRACE_STAGE_WRITE, &(deviceData->eventConfirmations));
                             if ((r = HTTPAPIEX_SAS_ExecuteRequest(
                                 deviceData->sasObject,
                                 handleData->httpApiExHandle,
@@ -1337,12 +1425,16 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                 //items go back to waitingToSend
                                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
                                 reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                                onRequestFailed(handleData);
                             }
                             else
                             {
                                 if (statusCode < 300)
                                 {
                                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_070: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClient_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list containing all the items batched, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The batched items shall be removed from waitingToSend.] */
+                                    onRequestSucceeded(handleData);
+                                    IOTHUB_CLIENT_TRACE_MESSAGE_LIST(IOTHUB_CLIENT_TRACE_STAGE_ACK, &(deviceData->eventConfirmations));
+                                    countSentEvents(handleData, &(deviceData->eventConfirmations), payloadLength);
                                     IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK);
                                 }
                                 else
@@ -1351,6 +1443,7 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
                                     LogError("unexpected HTTP status code (%u)", statusCode);
                                     reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                                    onRequestFailed(handleData);
                                 }
                             }
                         }
@@ -1389,6 +1482,7 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
             size_t originalMessageSize=0;
             IOTHUB_MESSAGE_LIST* message = containingRecord(deviceData->waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry);
             IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message->messageHandle);
+            IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_DEQUEUE, message->messageHandle);
 
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_073: [The message size is computed from the length of the payload + 384.]*/
             if (!(
@@ -1539,6 +1633,8 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                         {
                                             unsigned int statusCode = 0;
                                             HTTPAPIEX_RESULT r;
+                                            IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_SERIALIZE, message->messageHandle);
+                                            IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_WRITE, message->messageHandle);
                                             if (deviceData->deviceSasToken != NULL)
                                             {
                                                 /*Codes_SRS_TRANSPORTMULTITHTTP_03_001: [if a deviceSasToken exists, HTTPHeaders_ReplaceHeaderNameValuePair shall be invoked with "Authorization" as its second argument and STRING_c_str (deviceSasToken) as its third argument.]*/
@@ -1582,19 +1678,27 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                                     LogError("unable to HTTPAPIEX_SAS_ExecuteRequest");
                                                 }
                                             }
-                                            if (r == HTTPAPIEX_OK)
+                                            if (r != HTTPAPIEX_OK)
+                                            {
+                                                onRequestFailed(handleData);
+                                            }
+                                            else
                                             {
                                                 if (statusCode < 300)
                                                 {
                                                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_082: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClient_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list the item send, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The item shall be removed from waitingToSend.] */
+                                                    onRequestSucceeded(handleData);
+                                                    IOTHUB_CLIENT_TRACE_MESSAGE(IOTHUB_CLIENT_TRACE_STAGE_ACK, message->messageHandle);
                                                     PDLIST_ENTRY justSent = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
                                                     DList_InsertTailList(&(deviceData->eventConfirmations), justSent);
+                                                    countSentEvents(handleData, &(deviceData->eventConfirmations), originalMessageSize);
                                                     IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK); /*takes care of emptying the list too*/
                                                 }
                                                 else
                                                 {
                                                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_081: [If HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
                                                     LogError("unexpected HTTP status code (%u)", statusCode);
+                                                    onRequestFailed(handleData);
                                                 }
                                             }
                                         }
@@ -1903,7 +2007,13 @@ static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERD
                                 else
                                 {
                                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_089: [_DoWork shall assemble an IOTHUBMESSAGE_HANDLE from the received HTTP content (using the responseContent buffer).] */
-                                    IOTHUB_MESSAGE_HANDLE receivedMessage = IoTHubMessage_CreateFromByteArray(BUFFER_u_char(responseContent), BUFFER_length(responseContent));
+                                    size_t receivedLength = BUFFER_length(responseContent);
+                                    IOTHUB_MESSAGE_HANDLE receivedMessage = IoTHubMessage_CreateFromByteArray(BUFFER_u_char(responseContent), receivedLength);
+                                    /*Codes_SRS_TRANSPORTMULTITHTTP_02_030: [ Every message received shall add the length of its content to IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_RECEIVED, if there are metrics. ]*/
+                                    if (handleData->metrics != NULL)
+                                    {
+                                        iothub_client_metrics_add(handleData->metrics, IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_RECEIVED, receivedLength);
+                                    }
                                     if (receivedMessage == NULL)
                                     {
                                         /*Codes_SRS_TRANSPORTMULTITHTTP_17_092: [If assembling the message fails in any way, then _DoWork shall "abandon" the message.]*/
@@ -2023,13 +2133,44 @@ static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERD
     }
 }
 
+static bool isRequestAllowed(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    bool result;
+    if (!handleData->isRetryPending)
+    {
+        result = true;
+    }
+    else
+    {
+        RETRY_ACTION retryAction;
+        if (retry_control_should_retry(handleData->retryControl, &retryAction) != 0)
+        {
+            LogError("unable to query the retry control");
+            result = false;
+        }
+        else
+        {
+            result = (retryAction == RETRY_ACTION_RETRY_NOW);
+        }
+    }
+    return result;
+}
+
 static void IoTHubTransportHttp_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 {
     /*Codes_SRS_TRANSPORTMULTITHTTP_17_049: [ If handle is NULL, then IoTHubTransportHttp_DoWork shall do nothing. ]*/
     /*Codes_SRS_TRANSPORTMULTITHTTP_17_140: [ If iotHubClientHandle is NULL, then IoTHubTransportHttp_DoWork shall do nothing. ]*/
 
     (void)iotHubClientHandle; // use the perDevice handle.
-    if (handle != NULL)
+    if (handle == NULL)
+    {
+        LogError("Invalid Argument NULL call on DoWork.");
+    }
+    else if (!isRequestAllowed((HTTPTRANSPORT_HANDLE_DATA*)handle))
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_02_023: [ When a request to send events fails or completes with a http status code >=300, the following calls to IoTHubTransportHttp_DoWork shall do nothing until the retry control allows a new attempt. ]*/
+    }
+    else
     {
         HTTPTRANSPORT_HANDLE_DATA* handleData = (HTTPTRANSPORT_HANDLE_DATA*)handle;
         IOTHUB_DEVICE_HANDLE* listItem;
@@ -2046,10 +2187,6 @@ static void IoTHubTransportHttp_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
 
         }
     }
-    else
-    {
-        LogError("Invalid Argument NULL call on DoWork.");
-    }
 }
 
 static IOTHUB_CLIENT_RESULT IoTHubTransportHttp_GetSendStatus(IOTHUB_DEVICE_HANDLE handle, IOTHUB_CLIENT_STATUS *iotHubClientStatus)
@@ -2155,6 +2292,34 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportHttp_SetOption(TRANSPORT_LL_HANDLE ha
     return result;
 }
 
+static int IoTHubTransportHttp_SetRetryPolicy(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds)
+{
+    int result;
+    if (handle == NULL)
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_02_025: [ If handle is NULL then IoTHubTransportHttp_SetRetryPolicy shall fail and return a non-zero value. ]*/
+        LogError("invalid arg (handle is NULL)");
+        result = __LINE__;
+    }
+    else
+    {
+        HTTPTRANSPORT_HANDLE_DATA* handleData = (HTTPTRANSPORT_HANDLE_DATA*)handle;
+        /*Codes_SRS_TRANSPORTMULTITHTTP_02_026: [ IoTHubTransportHttp_SetRetryPolicy shall pass the policy and the timeout limit to the retry control by calling retry_control_set_policy and return 0 when it succeeds. ]*/
+        if (retry_control_set_policy(handleData->retryControl, retryPolicy, retryTimeoutLimitInSeconds) != 0)
+        {
+            /*Codes_SRS_TRANSPORTMULTITHTTP_02_027: [ If retry_control_set_policy fails then IoTHubTransportHttp_SetRetryPolicy shall fail and return a non-zero value. ]*/
+            LogError("unable to set the retry policy");
+            result = __LINE__;
+        }
+        else
+        {
+            handleData->isRetryPending = false;
+            result = 0;
+        }
+    }
+    return result;
+}
+
 static STRING_HANDLE IoTHubTransportHttp_GetHostname(TRANSPORT_LL_HANDLE handle)
 {
     STRING_HANDLE result;
@@ -2185,7 +2350,8 @@ static TRANSPORT_PROVIDER thisTransportProvider =
     IoTHubTransportHttp_Subscribe, /*pfIoTHubTransport_Subscribe IoTHubTransport_Subscribe;                                            */
     IoTHubTransportHttp_Unsubscribe, /*pfIoTHubTransport_Unsubscribe IoTHubTransport_Unsubscribe;                                        */
     IoTHubTransportHttp_DoWork, /*pfIoTHubTransport_DoWork IoTHubTransport_DoWork; */
-    IoTHubTransportHttp_GetSendStatus /* pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus */
+    IoTHubTransportHttp_GetSendStatus, /* pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus */
+    IoTHubTransportHttp_SetRetryPolicy /* pfIoTHubTransport_SetRetryPolicy IoTHubTransport_SetRetryPolicy */
 };
 
 const TRANSPORT_PROVIDER* HTTP_Protocol(void)
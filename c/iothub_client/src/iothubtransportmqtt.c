@@ -75,6 +75,12 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportMqtt_SetOption(TRANSPORT_LL_HANDLE ha
     return IoTHubTransport_MQTT_Common_SetOption(handle, option, value);
 }
 
+static int IoTHubTransportMqtt_SetRetryPolicy(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds)
+{
+    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_02_016: [ IoTHubTransportMqtt_SetRetryPolicy shall set the retry policy by calling into the IoTHubTransport_MQTT_Common_SetRetryPolicy function. ] */
+    return IoTHubTransport_MQTT_Common_SetRetryPolicy(handle, retryPolicy, retryTimeoutLimitInSeconds);
+}
+
 static IOTHUB_DEVICE_HANDLE IoTHubTransportMqtt_Register(TRANSPORT_LL_HANDLE handle, const IOTHUB_DEVICE_CONFIG* device, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, PDLIST_ENTRY waitingToSend)
 {
     /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_003: [ IoTHubTransportMqtt_Register shall register the TRANSPORT_LL_HANDLE by calling into the IoTHubMqttAbstract_Register function. ] */
@@ -103,7 +109,8 @@ static TRANSPORT_PROVIDER myfunc = {
     IoTHubTransportMqtt_Subscribe,
     IoTHubTransportMqtt_Unsubscribe,
     IoTHubTransportMqtt_DoWork,
-    IoTHubTransportMqtt_GetSendStatus
+    IoTHubTransportMqtt_GetSendStatus,
+    IoTHubTransportMqtt_SetRetryPolicy
 };
 
 /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_011: [ This function shall return a pointer to a structure of type TRANSPORT_PROVIDER having the following values for its fields:
@@ -113,7 +120,8 @@ IoTHubTransport_Destroy = IoTHubTransportMqtt_Destroy
 IoTHubTransport_Subscribe = IoTHubTransportMqtt_Subscribe
 IoTHubTransport_Unsubscribe = IoTHubTransportMqtt_Unsubscribe
 IoTHubTransport_DoWork = IoTHubTransportMqtt_DoWork
-IoTHubTransport_SetOption = IoTHubTransportMqtt_SetOption ] */
+IoTHubTransport_SetOption = IoTHubTransportMqtt_SetOption
+IoTHubTransport_SetRetryPolicy = IoTHubTransportMqtt_SetRetryPolicy ] */
 const TRANSPORT_PROVIDER* MQTT_Protocol(void)
 {
     return &myfunc;
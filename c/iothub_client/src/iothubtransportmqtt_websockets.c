@@ -77,6 +77,12 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportMqtt_WS_SetOption(TRANSPORT_LL_HANDLE
     return IoTHubTransport_MQTT_Common_SetOption(handle, option, value);
 }
 
+/* Codes_SRS_IOTHUB_MQTT_WEBSOCKET_TRANSPORT_02_001: [ IoTHubTransportMqtt_WS_SetRetryPolicy shall set the retry policy by calling into the IoTHubTransport_MQTT_Common_SetRetryPolicy function. ] */
+static int IoTHubTransportMqtt_WS_SetRetryPolicy(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds)
+{
+    return IoTHubTransport_MQTT_Common_SetRetryPolicy(handle, retryPolicy, retryTimeoutLimitInSeconds);
+}
+
 /* Codes_SRS_IOTHUB_MQTT_WEBSOCKET_TRANSPORT_07_003: [ IoTHubTransportMqtt_WS_Register shall register the TRANSPORT_LL_HANDLE by calling into the IoTHubMqttAbstract_Register function. ]*/
 static IOTHUB_DEVICE_HANDLE IoTHubTransportMqtt_WS_Register(TRANSPORT_LL_HANDLE handle, const IOTHUB_DEVICE_CONFIG* device, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, PDLIST_ENTRY waitingToSend)
 {
@@ -103,7 +109,8 @@ IoTHubTransport_Destroy = IoTHubTransportMqtt_WS_Destroy
 IoTHubTransport_Subscribe = IoTHubTransportMqtt_WS_Subscribe
 IoTHubTransport_Unsubscribe = IoTHubTransportMqtt_WS_Unsubscribe
 IoTHubTransport_DoWork = IoTHubTransportMqtt_WS_DoWork
-IoTHubTransport_SetOption = IoTHubTransportMqtt_WS_SetOption ] */
+IoTHubTransport_SetOption = IoTHubTransportMqtt_WS_SetOption
+IoTHubTransport_SetRetryPolicy = IoTHubTransportMqtt_WS_SetRetryPolicy ] */
 static TRANSPORT_PROVIDER thisTransportProvider_WebSocketsOverTls = {
     IoTHubTransportMqtt_WS_GetHostname,
     IoTHubTransportMqtt_WS_SetOption,
@@ -114,7 +121,8 @@ static TRANSPORT_PROVIDER thisTransportProvider_WebSocketsOverTls = {
     IoTHubTransportMqtt_WS_Subscribe,
     IoTHubTransportMqtt_WS_Unsubscribe,
     IoTHubTransportMqtt_WS_DoWork,
-    IoTHubTransportMqtt_WS_GetSendStatus
+    IoTHubTransportMqtt_WS_GetSendStatus,
+    IoTHubTransportMqtt_WS_SetRetryPolicy
 };
 
 const TRANSPORT_PROVIDER* MQTT_WebSocket_Protocol(void)
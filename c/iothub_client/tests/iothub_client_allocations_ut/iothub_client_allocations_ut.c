@@ -0,0 +1,319 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iothub_client_metrics.h"
+#include "iothub_client_allocations.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+
+/*the accounted blocks are real blocks and the counters are global, so every test compares two snapshots*/
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT before;
+static IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT after;
+
+static void takeSnapshot(IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT* snapshot)
+{
+    ASSERT_ARE_EQUAL(int, 0, iothub_client_metrics_get_allocations(snapshot));
+}
+
+static void assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG tag, uint64_t currentBytes, uint64_t liveBlocks, uint64_t allocations)
+{
+    ASSERT_ARE_EQUAL(uint64_t, currentBytes, after.currentBytes[tag] - before.currentBytes[tag]);
+    ASSERT_ARE_EQUAL(uint64_t, liveBlocks, after.liveBlocks[tag] - before.liveBlocks[tag]);
+    ASSERT_ARE_EQUAL(uint64_t, allocations, after.allocations[tag] - before.allocations[tag]);
+}
+
+static void assertNoChange(void)
+{
+    ASSERT_ARE_EQUAL(int, 0, memcmp(&before, &after, sizeof(IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT)));
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(iothub_client_allocations_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+    takeSnapshot(&before);
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_001: [ iothub_client_malloc_<tag> shall call malloc and, when it returns a block, add its size to the memory of the tag and count one allocation. ]*/
+TEST_FUNCTION(iothub_client_malloc_accounts_the_block_to_its_tag)
+{
+    ///act
+    void* block = iothub_client_malloc_client(100);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(block);
+    takeSnapshot(&after);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_CLIENT, 100, 1, 1);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_MESSAGE, 0, 0, 0);
+
+    ///cleanup
+    iothub_client_free_tagged(block);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_002: [ iothub_client_calloc_<tag> shall call calloc and, when it returns a block, add nmemb * size to the memory of the tag and count one allocation. ]*/
+TEST_FUNCTION(iothub_client_calloc_accounts_nmemb_times_size)
+{
+    ///act
+    unsigned char* block = (unsigned char*)iothub_client_calloc_message(3, 10);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(block);
+    ASSERT_ARE_EQUAL(int, 0, block[29]);
+    takeSnapshot(&after);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_MESSAGE, 30, 1, 1);
+
+    ///cleanup
+    iothub_client_free_tagged(block);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_003: [ iothub_client_realloc_<tag> shall call realloc, remove the previous block from the memory of its tag and, when realloc returns a block, add its size to the memory of the reallocating tag and count one allocation. ]*/
+TEST_FUNCTION(iothub_client_realloc_moves_the_block_to_the_reallocating_tag)
+{
+    ///arrange
+    void* block = iothub_client_malloc_queue(16);
+    ASSERT_IS_NOT_NULL(block);
+
+    ///act
+    block = iothub_client_realloc_transport(block, 64);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(block);
+    takeSnapshot(&after);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_QUEUE, 0, 0, 1);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_TRANSPORT, 64, 1, 1);
+
+    ///cleanup
+    iothub_client_free_tagged(block);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_003: [ iothub_client_realloc_<tag> shall call realloc, remove the previous block from the memory of its tag and, when realloc returns a block, add its size to the memory of the reallocating tag and count one allocation. ]*/
+TEST_FUNCTION(iothub_client_realloc_of_NULL_accounts_a_new_block)
+{
+    ///act
+    void* block = iothub_client_realloc_upload(NULL, 12);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(block);
+    takeSnapshot(&after);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_UPLOAD, 12, 1, 1);
+
+    ///cleanup
+    iothub_client_free_tagged(block);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_004: [ When realloc fails, the previous block shall stay accounted to its tag. ]*/
+TEST_FUNCTION(iothub_client_realloc_that_fails_keeps_the_previous_block)
+{
+    ///arrange
+    void* block = iothub_client_malloc_serializer(24);
+    ASSERT_IS_NOT_NULL(block);
+
+    ///act
+    void* result = iothub_client_realloc_client(block, SIZE_MAX);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    takeSnapshot(&after);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_SERIALIZER, 24, 1, 1);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_CLIENT, 0, 0, 0);
+
+    ///cleanup
+    iothub_client_free_tagged(block);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_005: [ iothub_client_free_tagged shall remove the block from the memory of its tag and then call free. ]*/
+TEST_FUNCTION(iothub_client_free_tagged_removes_the_block_and_keeps_the_peak)
+{
+    ///arrange
+    void* first = iothub_client_malloc_transport(1000);
+    void* second = iothub_client_malloc_transport(500);
+    ASSERT_IS_NOT_NULL(first);
+    ASSERT_IS_NOT_NULL(second);
+
+    ///act
+    iothub_client_free_tagged(first);
+    iothub_client_free_tagged(second);
+
+    ///assert
+    takeSnapshot(&after);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_TRANSPORT, 0, 0, 2);
+    ASSERT_IS_TRUE(after.peakBytes[IOTHUB_CLIENT_ALLOCATION_TAG_TRANSPORT] >= before.currentBytes[IOTHUB_CLIENT_ALLOCATION_TAG_TRANSPORT] + 1500);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_006: [ When ptr was not allocated by a tagged function, iothub_client_realloc_<tag> and iothub_client_free_tagged shall call realloc and free without accounting the block. ]*/
+TEST_FUNCTION(iothub_client_free_tagged_of_a_block_that_is_not_accounted_changes_nothing)
+{
+    ///arrange
+    void* block = malloc(32);
+    ASSERT_IS_NOT_NULL(block);
+
+    ///act
+    iothub_client_free_tagged(block);
+    iothub_client_free_tagged(NULL);
+
+    ///assert
+    takeSnapshot(&after);
+    assertNoChange();
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_005: [ iothub_client_free_tagged shall remove the block from the memory of its tag and then call free. ]*/
+TEST_FUNCTION(iothub_client_free_tagged_keeps_the_other_blocks_reachable)
+{
+    ///arrange
+    void* blocks[1000];
+    size_t i;
+    for (i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++)
+    {
+        blocks[i] = iothub_client_malloc_queue(8);
+        ASSERT_IS_NOT_NULL(blocks[i]);
+    }
+
+    ///act
+    for (i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i += 2)
+    {
+        iothub_client_free_tagged(blocks[i]);
+    }
+    for (i = 1; i < sizeof(blocks) / sizeof(blocks[0]); i += 2)
+    {
+        iothub_client_free_tagged(blocks[i]);
+    }
+
+    ///assert
+    takeSnapshot(&after);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_QUEUE, 0, 0, 1000);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_006: [ When ptr was not allocated by a tagged function, iothub_client_realloc_<tag> and iothub_client_free_tagged shall call realloc and free without accounting the block. ]*/
+TEST_FUNCTION(iothub_client_realloc_of_a_block_that_is_not_accounted_leaves_it_unaccounted)
+{
+    ///arrange
+    unsigned char* block = (unsigned char*)malloc(16);
+    ASSERT_IS_NOT_NULL(block);
+    (void)memset(block, 'a', 16);
+
+    ///act
+    block = (unsigned char*)iothub_client_realloc_message(block, 4096);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(block);
+    ASSERT_ARE_EQUAL(int, 'a', block[15]);
+    takeSnapshot(&after);
+    assertNoChange();
+
+    ///cleanup
+    free(block);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_012: [ iothub_client_malloc_caller_owned_<tag> shall call malloc and, when it returns a block, count one allocation of the tag without adding the block to the memory of the tag, so that the block can be freed with free and is not reported at exit. ]*/
+TEST_FUNCTION(iothub_client_malloc_caller_owned_counts_only_the_allocation)
+{
+    ///act
+    void* block = iothub_client_malloc_caller_owned_serializer(64);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(block);
+    takeSnapshot(&after);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_SERIALIZER, 0, 0, 1);
+
+    ///cleanup
+    free(block);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_012: [ iothub_client_malloc_caller_owned_<tag> shall call malloc and, when it returns a block, count one allocation of the tag without adding the block to the memory of the tag, so that the block can be freed with free and is not reported at exit. ]*/
+TEST_FUNCTION(iothub_client_free_tagged_of_a_caller_owned_block_changes_nothing)
+{
+    ///arrange
+    void* block = iothub_client_malloc_caller_owned_queue(20);
+    ASSERT_IS_NOT_NULL(block);
+    takeSnapshot(&before);
+
+    ///act
+    iothub_client_free_tagged(block);
+
+    ///assert
+    takeSnapshot(&after);
+    assertNoChange();
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_007: [ If snapshot is NULL, iothub_client_metrics_get_allocations shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(iothub_client_metrics_get_allocations_with_NULL_snapshot_fails)
+{
+    ///act
+    int result = iothub_client_metrics_get_allocations(NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_ALLOCATIONS_02_008: [ iothub_client_metrics_get_allocations shall read the current bytes, peak bytes, live blocks and allocations of every tag and return 0. ]*/
+TEST_FUNCTION(iothub_client_metrics_get_allocations_copies_every_tag)
+{
+    ///arrange
+    void* block = iothub_client_malloc_upload(7);
+    ASSERT_IS_NOT_NULL(block);
+
+    ///act
+    int result = iothub_client_metrics_get_allocations(&after);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    assertDelta(IOTHUB_CLIENT_ALLOCATION_TAG_UPLOAD, 7, 1, 1);
+    ASSERT_IS_TRUE(after.peakBytes[IOTHUB_CLIENT_ALLOCATION_TAG_UPLOAD] >= after.currentBytes[IOTHUB_CLIENT_ALLOCATION_TAG_UPLOAD]);
+
+    ///cleanup
+    iothub_client_free_tagged(block);
+}
+
+END_TEST_SUITE(iothub_client_allocations_ut)
@@ -0,0 +1,442 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "iothub_client_ingress_queue.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_callback_dispatcher.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_c.h"
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#define TEST_INGRESS_QUEUE_HANDLE ((INGRESS_QUEUE_HANDLE)0x4248)
+#define TEST_THREAD_HANDLE ((THREAD_HANDLE)0x4249)
+
+/*the ingress queue mock keeps the pushed entries in order*/
+#define TEST_MAX_ENTRIES 8
+static INGRESS_QUEUE_ENTRY* entries[TEST_MAX_ENTRIES];
+static size_t entryCount;
+static size_t emptyDrains; /*how many drains find nothing before the entries show up*/
+
+static THREAD_START_FUNC threadFunc;
+static void* threadFuncArg;
+static bool runThreadOnJoin; /*when true ThreadAPI_Join runs the thread function, as if the thread ran until then*/
+
+typedef struct TEST_ITEM_TAG
+{
+    CALLBACK_DISPATCHER_ITEM item;
+    int id;
+} TEST_ITEM;
+
+#define TEST_MAX_RUN 8
+static int runIds[TEST_MAX_RUN];
+static size_t runCount;
+
+static void onItem(CALLBACK_DISPATCHER_ITEM* item)
+{
+    TEST_ITEM* testItem = (TEST_ITEM*)((char*)item - offsetof(TEST_ITEM, item));
+    ASSERT_IS_TRUE(runCount < TEST_MAX_RUN);
+    runIds[runCount++] = testItem->id;
+}
+
+static int my_ingress_queue_push(INGRESS_QUEUE_HANDLE queue, INGRESS_QUEUE_ENTRY* entry)
+{
+    (void)queue;
+    ASSERT_IS_TRUE(entryCount < TEST_MAX_ENTRIES);
+    entries[entryCount++] = entry;
+    return 0;
+}
+
+static size_t my_ingress_queue_drain(INGRESS_QUEUE_HANDLE queue, INGRESS_QUEUE_ENTRY_CALLBACK callback, void* context)
+{
+    size_t result;
+    (void)queue;
+    if (emptyDrains > 0)
+    {
+        emptyDrains--;
+        result = 0;
+    }
+    else
+    {
+        size_t i;
+        result = entryCount;
+        entryCount = 0;
+        for (i = 0; i < result; i++)
+        {
+            callback(entries[i], context);
+        }
+    }
+    return result;
+}
+
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    *threadHandle = TEST_THREAD_HANDLE;
+    threadFunc = func;
+    threadFuncArg = arg;
+    return THREADAPI_OK;
+}
+
+static THREADAPI_RESULT my_ThreadAPI_Join(THREAD_HANDLE threadHandle, int* res)
+{
+    (void)threadHandle;
+    *res = runThreadOnJoin ? threadFunc(threadFuncArg) : 0;
+    return THREADAPI_OK;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(iothub_client_callback_dispatcher_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    int result;
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_c_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(INGRESS_QUEUE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(INGRESS_QUEUE_ENTRY_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(ingress_queue_create, TEST_INGRESS_QUEUE_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(ingress_queue_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(ingress_queue_push, my_ingress_queue_push);
+    REGISTER_GLOBAL_MOCK_HOOK(ingress_queue_drain, my_ingress_queue_drain);
+
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Join, my_ThreadAPI_Join);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+    entryCount = 0;
+    emptyDrains = 0;
+    threadFunc = NULL;
+    threadFuncArg = NULL;
+    runThreadOnJoin = false;
+    runCount = 0;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_001: [ callback_dispatcher_create shall allocate a dispatcher, create its queue by calling ingress_queue_create and start its thread by calling ThreadAPI_Create. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_003: [ Otherwise callback_dispatcher_create shall return a non-NULL handle. ]*/
+TEST_FUNCTION(callback_dispatcher_create_succeeds)
+{
+    ///arrange
+    CALLBACK_DISPATCHER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(ingress_queue_create());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    ///act
+    result = callback_dispatcher_create();
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_NOT_NULL(threadFunc);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    callback_dispatcher_destroy(result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_002: [ If any failure occurs, callback_dispatcher_create shall free what it allocated and return NULL. ]*/
+TEST_FUNCTION(callback_dispatcher_create_fails_when_malloc_fails)
+{
+    ///arrange
+    CALLBACK_DISPATCHER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    ///act
+    result = callback_dispatcher_create();
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_002: [ If any failure occurs, callback_dispatcher_create shall free what it allocated and return NULL. ]*/
+TEST_FUNCTION(callback_dispatcher_create_fails_when_ingress_queue_create_fails)
+{
+    ///arrange
+    CALLBACK_DISPATCHER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(ingress_queue_create())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    ///act
+    result = callback_dispatcher_create();
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_002: [ If any failure occurs, callback_dispatcher_create shall free what it allocated and return NULL. ]*/
+TEST_FUNCTION(callback_dispatcher_create_fails_when_ThreadAPI_Create_fails)
+{
+    ///arrange
+    CALLBACK_DISPATCHER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(ingress_queue_create());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(THREADAPI_ERROR);
+    STRICT_EXPECTED_CALL(ingress_queue_destroy(TEST_INGRESS_QUEUE_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    ///act
+    result = callback_dispatcher_create();
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_005: [ If dispatcher is NULL, callback_dispatcher_destroy shall do nothing. ]*/
+TEST_FUNCTION(callback_dispatcher_destroy_with_NULL_does_nothing)
+{
+    ///act
+    callback_dispatcher_destroy(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_006: [ callback_dispatcher_destroy shall post a stop request after the items already posted and join the thread by calling ThreadAPI_Join. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_008: [ callback_dispatcher_destroy shall destroy the queue and free the dispatcher. ]*/
+TEST_FUNCTION(callback_dispatcher_destroy_stops_the_thread_and_frees_the_dispatcher)
+{
+    ///arrange
+    CALLBACK_DISPATCHER_HANDLE dispatcher = callback_dispatcher_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ingress_queue_push(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ingress_queue_drain(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ingress_queue_destroy(TEST_INGRESS_QUEUE_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(dispatcher));
+
+    ///act
+    callback_dispatcher_destroy(dispatcher);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_007: [ callback_dispatcher_destroy shall call the function of every item still posted, on the calling thread, so that every item runs exactly once. ]*/
+TEST_FUNCTION(callback_dispatcher_destroy_runs_the_items_that_are_still_posted)
+{
+    ///arrange
+    TEST_ITEM testItems[2] = { { { { NULL }, NULL }, 1 }, { { { NULL }, NULL }, 2 } };
+    CALLBACK_DISPATCHER_HANDLE dispatcher = callback_dispatcher_create();
+    (void)callback_dispatcher_post(dispatcher, &testItems[0].item, onItem);
+    (void)callback_dispatcher_post(dispatcher, &testItems[1].item, onItem);
+
+    ///act
+    callback_dispatcher_destroy(dispatcher);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 2, runCount);
+    ASSERT_ARE_EQUAL(int, 1, runIds[0]);
+    ASSERT_ARE_EQUAL(int, 2, runIds[1]);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_004: [ The thread shall take all the posted items and call their function, in the order the items were posted, and sleep 1 ms when there was none, until it runs the stop request of callback_dispatcher_destroy. ]*/
+TEST_FUNCTION(the_thread_runs_the_items_in_order_and_stops_after_the_stop_request)
+{
+    ///arrange
+    TEST_ITEM testItems[2] = { { { { NULL }, NULL }, 1 }, { { { NULL }, NULL }, 2 } };
+    CALLBACK_DISPATCHER_HANDLE dispatcher = callback_dispatcher_create();
+    (void)callback_dispatcher_post(dispatcher, &testItems[0].item, onItem);
+    (void)callback_dispatcher_post(dispatcher, &testItems[1].item, onItem);
+    runThreadOnJoin = true;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ingress_queue_push(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ingress_queue_drain(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG)); /*the thread*/
+    STRICT_EXPECTED_CALL(ingress_queue_drain(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG)); /*callback_dispatcher_destroy*/
+    STRICT_EXPECTED_CALL(ingress_queue_destroy(TEST_INGRESS_QUEUE_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(dispatcher));
+
+    ///act
+    callback_dispatcher_destroy(dispatcher);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 2, runCount);
+    ASSERT_ARE_EQUAL(int, 1, runIds[0]);
+    ASSERT_ARE_EQUAL(int, 2, runIds[1]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_004: [ The thread shall take all the posted items and call their function, in the order the items were posted, and sleep 1 ms when there was none, until it runs the stop request of callback_dispatcher_destroy. ]*/
+TEST_FUNCTION(the_thread_sleeps_1_ms_when_there_is_nothing_to_run)
+{
+    ///arrange
+    CALLBACK_DISPATCHER_HANDLE dispatcher = callback_dispatcher_create();
+    runThreadOnJoin = true;
+    emptyDrains = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ingress_queue_push(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ingress_queue_drain(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1));
+    STRICT_EXPECTED_CALL(ingress_queue_drain(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ingress_queue_drain(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ingress_queue_destroy(TEST_INGRESS_QUEUE_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(dispatcher));
+
+    ///act
+    callback_dispatcher_destroy(dispatcher);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_009: [ If dispatcher, item or function is NULL, callback_dispatcher_post shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(callback_dispatcher_post_with_NULL_dispatcher_fails)
+{
+    ///arrange
+    TEST_ITEM testItem = { { { NULL }, NULL }, 1 };
+
+    ///act
+    int result = callback_dispatcher_post(NULL, &testItem.item, onItem);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_009: [ If dispatcher, item or function is NULL, callback_dispatcher_post shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(callback_dispatcher_post_with_NULL_item_fails)
+{
+    ///arrange
+    CALLBACK_DISPATCHER_HANDLE dispatcher = callback_dispatcher_create();
+    umock_c_reset_all_calls();
+
+    ///act
+    int result = callback_dispatcher_post(dispatcher, NULL, onItem);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    callback_dispatcher_destroy(dispatcher);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_009: [ If dispatcher, item or function is NULL, callback_dispatcher_post shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(callback_dispatcher_post_with_NULL_function_fails)
+{
+    ///arrange
+    TEST_ITEM testItem = { { { NULL }, NULL }, 1 };
+    CALLBACK_DISPATCHER_HANDLE dispatcher = callback_dispatcher_create();
+    umock_c_reset_all_calls();
+
+    ///act
+    int result = callback_dispatcher_post(dispatcher, &testItem.item, NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    callback_dispatcher_destroy(dispatcher);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_CALLBACK_DISPATCHER_02_010: [ callback_dispatcher_post shall remember function in item, push item to the queue by calling ingress_queue_push and return what ingress_queue_push returns. ]*/
+TEST_FUNCTION(callback_dispatcher_post_pushes_the_item)
+{
+    ///arrange
+    TEST_ITEM testItem = { { { NULL }, NULL }, 1 };
+    CALLBACK_DISPATCHER_HANDLE dispatcher = callback_dispatcher_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ingress_queue_push(TEST_INGRESS_QUEUE_HANDLE, &testItem.item.entry));
+
+    ///act
+    int result = callback_dispatcher_post(dispatcher, &testItem.item, onItem);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(testItem.item.function == onItem);
+    ASSERT_ARE_EQUAL(size_t, 0, runCount);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    callback_dispatcher_destroy(dispatcher);
+}
+
+END_TEST_SUITE(iothub_client_callback_dispatcher_ut)
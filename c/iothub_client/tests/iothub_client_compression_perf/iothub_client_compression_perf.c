@@ -0,0 +1,181 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "azure_c_shared_utility/tickcounter.h"
+
+#include "iothub_client_compression.h"
+
+/*
+ * Measures the compression stage on telemetry shaped payloads. Every payload is compressed and
+ * decompressed ITERATION_COUNT times, with and without a shared dictionary:
+ *  - a single small JSON message, the common case for a device, where only the dictionary helps
+ *  - a batch of messages as the HTTP transport sends them, which compresses well on its own
+ * The ratio is the compressed size over the original size, the rates are in original bytes.
+ */
+
+#define ITERATION_COUNT 20000
+#define BATCH_MESSAGE_COUNT 200
+#define MESSAGE_FORMAT "{\"deviceId\":\"thermostat-%04u\",\"temperature\":%u.%u,\"humidity\":%u,\"status\":\"%s\",\"firmware\":\"1.2.3\"}"
+
+/*typical messages concatenated, as an application would ship them next to its service*/
+static const char* dictionary =
+    "{\"deviceId\":\"thermostat-0000\",\"temperature\":20.0,\"humidity\":50,\"status\":\"normal\",\"firmware\":\"1.2.3\"}"
+    "{\"deviceId\":\"thermostat-0001\",\"temperature\":25.5,\"humidity\":45,\"status\":\"warning\",\"firmware\":\"1.2.3\"}";
+
+static size_t MakeMessage(char* destination, unsigned int index)
+{
+    return (size_t)sprintf(destination, MESSAGE_FORMAT, index % 10000, 18 + (index * 7) % 10, (index * 3) % 10, 30 + (index * 11) % 40, ((index % 13) == 0) ? "warning" : "normal");
+}
+
+static void PrintRate(const char* payload, const char* variant, const char* operation, size_t size, tickcounter_ms_t elapsedMs)
+{
+    char name[64];
+    double seconds = (double)elapsedMs / 1000.0;
+
+    (void)sprintf(name, "%s, %s, %s", operation, payload, variant);
+    if (seconds > 0)
+    {
+        (void)printf("%-48s %10.1f payloads/s %8.1f MB/s\n", name, ITERATION_COUNT / seconds, (ITERATION_COUNT * (double)size) / (seconds * 1024 * 1024));
+    }
+    else
+    {
+        (void)printf("%-48s too fast to measure\n", name);
+    }
+}
+
+static int Measure(TICK_COUNTER_HANDLE tickCounter, const char* payloadName, const unsigned char* payload, size_t size, int useDictionary)
+{
+    int result;
+    const char* variant = useDictionary ? "dictionary" : "no dictionary";
+    COMPRESSION_HANDLE compression = useDictionary ?
+        compression_create((const unsigned char*)dictionary, strlen(dictionary)) :
+        compression_create(NULL, 0);
+
+    if (compression == NULL)
+    {
+        (void)printf("compression_create failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t bound = compression_get_bound(size);
+        unsigned char* compressed = (unsigned char*)malloc(bound);
+        unsigned char* decompressed = (unsigned char*)malloc(size);
+        if ((compressed == NULL) || (decompressed == NULL))
+        {
+            (void)printf("malloc failed\n");
+            result = __LINE__;
+        }
+        else
+        {
+            tickcounter_ms_t start;
+            tickcounter_ms_t end;
+            size_t compressedSize = 0;
+            size_t i;
+
+            result = 0;
+
+            (void)tickcounter_get_current_ms(tickCounter, &start);
+            for (i = 0; (i < ITERATION_COUNT) && (result == 0); i++)
+            {
+                compressedSize = bound;
+                if (compression_compress(compression, payload, size, compressed, &compressedSize) != 0)
+                {
+                    (void)printf("compression_compress failed\n");
+                    result = __LINE__;
+                }
+            }
+            (void)tickcounter_get_current_ms(tickCounter, &end);
+
+            if (result == 0)
+            {
+                char name[64];
+                (void)sprintf(name, "ratio, %s, %s", payloadName, variant);
+                (void)printf("%-48s %10.3f %lu -> %lu bytes\n", name, (double)compressedSize / (double)size, (unsigned long)size, (unsigned long)compressedSize);
+                PrintRate(payloadName, variant, "compress", size, end - start);
+
+                (void)tickcounter_get_current_ms(tickCounter, &start);
+                for (i = 0; (i < ITERATION_COUNT) && (result == 0); i++)
+                {
+                    size_t decompressedSize = size;
+                    if ((compression_decompress(compression, compressed, compressedSize, decompressed, &decompressedSize) != 0) ||
+                        (decompressedSize != size))
+                    {
+                        (void)printf("compression_decompress failed\n");
+                        result = __LINE__;
+                    }
+                }
+                (void)tickcounter_get_current_ms(tickCounter, &end);
+
+                if (result == 0)
+                {
+                    if (memcmp(payload, decompressed, size) != 0)
+                    {
+                        (void)printf("the decompressed payload differs from the original\n");
+                        result = __LINE__;
+                    }
+                    else
+                    {
+                        PrintRate(payloadName, variant, "decompress", size, end - start);
+                    }
+                }
+            }
+        }
+        free(decompressed);
+        free(compressed);
+        compression_destroy(compression);
+    }
+    return result;
+}
+
+int main(void)
+{
+    int result;
+    TICK_COUNTER_HANDLE tickCounter;
+    char* batch;
+
+    if ((tickCounter = tickcounter_create()) == NULL)
+    {
+        (void)printf("tickcounter_create failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        if ((batch = (char*)malloc(BATCH_MESSAGE_COUNT * (sizeof(MESSAGE_FORMAT) + 32))) == NULL)
+        {
+            (void)printf("malloc failed\n");
+            result = __LINE__;
+        }
+        else
+        {
+            size_t batchSize = 0;
+            size_t messageSize;
+            unsigned int i;
+            int useDictionary;
+
+            for (i = 0; i < BATCH_MESSAGE_COUNT; i++)
+            {
+                batchSize += MakeMessage(batch + batchSize, i);
+            }
+            messageSize = MakeMessage(batch + batchSize, BATCH_MESSAGE_COUNT);
+
+            result = 0;
+            for (useDictionary = 0; (useDictionary < 2) && (result == 0); useDictionary++)
+            {
+                result = Measure(tickCounter, "single message", (const unsigned char*)batch + batchSize, messageSize, useDictionary);
+                if (result == 0)
+                {
+                    result = Measure(tickCounter, "batch", (const unsigned char*)batch, batchSize, useDictionary);
+                }
+            }
+            free(batch);
+        }
+        tickcounter_destroy(tickCounter);
+    }
+
+    return result;
+}
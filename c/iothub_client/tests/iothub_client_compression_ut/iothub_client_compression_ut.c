@@ -0,0 +1,922 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "iothub_message.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_compression.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_c.h"
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#define TEST_JSON "{\"deviceId\":\"thermostat-0042\",\"temperature\":21.5,\"humidity\":40,\"status\":\"normal\",\"firmware\":\"1.2.3\"}"
+#define TEST_DICTIONARY "{\"deviceId\":\"thermostat-0000\",\"temperature\":20.0,\"humidity\":50,\"status\":\"normal\",\"firmware\":\"1.2.3\"}"
+#define TEST_DICTIONARY_ID "telemetry-v1"
+
+/*a message is a plain struct, its properties map is the message itself*/
+#define TEST_MAX_PROPERTIES 4
+#define TEST_MAX_CONTENT 1024
+typedef struct TEST_MESSAGE_TAG
+{
+    IOTHUBMESSAGE_CONTENT_TYPE contentType;
+    unsigned char content[TEST_MAX_CONTENT];
+    size_t size;
+    const char* messageId;
+    const char* correlationId;
+    char messageIdStorage[32];
+    char correlationIdStorage[32];
+    IOTHUB_MESSAGE_PRIORITY priority;
+    size_t propertyCount;
+    const char* keys[TEST_MAX_PROPERTIES];
+    const char* values[TEST_MAX_PROPERTIES];
+    char keyStorage[TEST_MAX_PROPERTIES][32];
+    char valueStorage[TEST_MAX_PROPERTIES][32];
+} TEST_MESSAGE;
+
+static IOTHUB_MESSAGE_HANDLE my_IoTHubMessage_CreateFromByteArray(const unsigned char* byteArray, size_t size)
+{
+    TEST_MESSAGE* result = (TEST_MESSAGE*)my_gballoc_malloc(sizeof(TEST_MESSAGE));
+    (void)memset(result, 0, sizeof(TEST_MESSAGE));
+    ASSERT_IS_TRUE(size <= sizeof(result->content));
+    result->contentType = IOTHUBMESSAGE_BYTEARRAY;
+    if (size > 0)
+    {
+        (void)memcpy(result->content, byteArray, size);
+    }
+    result->size = size;
+    result->priority = IOTHUB_MESSAGE_PRIORITY_NORMAL;
+    return (IOTHUB_MESSAGE_HANDLE)result;
+}
+
+static IOTHUB_MESSAGE_HANDLE my_IoTHubMessage_CreateFromString(const char* source)
+{
+    TEST_MESSAGE* result = (TEST_MESSAGE*)my_IoTHubMessage_CreateFromByteArray((const unsigned char*)source, strlen(source) + 1);
+    result->contentType = IOTHUBMESSAGE_STRING;
+    return (IOTHUB_MESSAGE_HANDLE)result;
+}
+
+/*the clones are marked by the content type so that a test can tell them apart from compressed copies*/
+static IOTHUB_MESSAGE_HANDLE my_IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    TEST_MESSAGE* result = (TEST_MESSAGE*)my_gballoc_malloc(sizeof(TEST_MESSAGE));
+    (void)memcpy(result, iotHubMessageHandle, sizeof(TEST_MESSAGE));
+    return (IOTHUB_MESSAGE_HANDLE)result;
+}
+
+static void my_IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    my_gballoc_free(iotHubMessageHandle);
+}
+
+static IOTHUBMESSAGE_CONTENT_TYPE my_IoTHubMessage_GetContentType(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->contentType;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size)
+{
+    *buffer = ((TEST_MESSAGE*)iotHubMessageHandle)->content;
+    *size = ((TEST_MESSAGE*)iotHubMessageHandle)->size;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static const char* my_IoTHubMessage_GetString(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return (const char*)((TEST_MESSAGE*)iotHubMessageHandle)->content;
+}
+
+static MAP_HANDLE my_IoTHubMessage_Properties(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return (MAP_HANDLE)iotHubMessageHandle;
+}
+
+static const char* my_IoTHubMessage_GetMessageId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->messageId;
+}
+
+static const char* my_IoTHubMessage_GetCorrelationId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->correlationId;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_SetMessageId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const char* messageId)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)iotHubMessageHandle;
+    (void)strcpy(message->messageIdStorage, messageId);
+    message->messageId = message->messageIdStorage;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_SetCorrelationId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const char* correlationId)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)iotHubMessageHandle;
+    (void)strcpy(message->correlationIdStorage, correlationId);
+    message->correlationId = message->correlationIdStorage;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_SetPriority(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, IOTHUB_MESSAGE_PRIORITY priority)
+{
+    ((TEST_MESSAGE*)iotHubMessageHandle)->priority = priority;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static IOTHUB_MESSAGE_PRIORITY my_IoTHubMessage_GetPriority(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->priority;
+}
+
+static MAP_RESULT my_Map_GetInternals(MAP_HANDLE handle, const char*const** keys, const char*const** values, size_t* count)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)handle;
+    *keys = message->keys;
+    *values = message->values;
+    *count = message->propertyCount;
+    return MAP_OK;
+}
+
+static MAP_RESULT my_Map_AddOrUpdate(MAP_HANDLE handle, const char* key, const char* value)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)handle;
+    ASSERT_IS_TRUE(message->propertyCount < TEST_MAX_PROPERTIES);
+    (void)strcpy(message->keyStorage[message->propertyCount], key);
+    (void)strcpy(message->valueStorage[message->propertyCount], value);
+    message->keys[message->propertyCount] = message->keyStorage[message->propertyCount];
+    message->values[message->propertyCount] = message->valueStorage[message->propertyCount];
+    message->propertyCount++;
+    return MAP_OK;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static COMPRESSION_HANDLE createCompression(const char* dictionary)
+{
+    COMPRESSION_HANDLE result = (dictionary == NULL) ?
+        compression_create(NULL, 0) :
+        compression_create((const unsigned char*)dictionary, strlen(dictionary));
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+/*compresses and decompresses source, returns the compressed size*/
+static size_t assertRoundTrip(COMPRESSION_HANDLE compression, const unsigned char* source, size_t size)
+{
+    size_t compressedSize = compression_get_bound(size);
+    unsigned char* compressed = (unsigned char*)my_gballoc_malloc(compressedSize);
+    unsigned char* decompressed = (unsigned char*)my_gballoc_malloc(size + 1);
+    size_t decompressedSize = size + 1;
+
+    ASSERT_ARE_EQUAL(int, 0, compression_compress(compression, source, size, compressed, &compressedSize));
+    ASSERT_IS_TRUE(compressedSize <= compression_get_bound(size));
+    ASSERT_ARE_EQUAL(int, 0, compression_decompress(compression, compressed, compressedSize, decompressed, &decompressedSize));
+    ASSERT_ARE_EQUAL(size_t, size, decompressedSize);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(source, decompressed, size));
+
+    my_gballoc_free(decompressed);
+    my_gballoc_free(compressed);
+    return compressedSize;
+}
+
+/*LZ4 block of "abcabcabcabcabcabcabcabcabcabc" with its size, as written by the reference LZ4 library*/
+static const unsigned char REFERENCE_BLOCK[] =
+{
+    0x1e, 0x00, 0x00, 0x00, 0x3f, 0x61, 0x62, 0x63, 0x03, 0x00, 0x03, 0x50, 0x62, 0x63, 0x61, 0x62, 0x63
+};
+
+/*LZ4 block of "{\"temperature\":21.5,\"humidity\":40}" with the dictionary "{\"temperature\":20.0,\"humidity\":50}", as written by the reference LZ4 library*/
+static const unsigned char REFERENCE_DICTIONARY_BLOCK[] =
+{
+    0x22, 0x00, 0x00, 0x00, 0x0c, 0x22, 0x00, 0x36, 0x31, 0x2e, 0x35, 0x22, 0x00, 0x50, 0x22, 0x3a, 0x34, 0x30, 0x7d
+};
+
+BEGIN_TEST_SUITE(iothub_client_compression_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_c_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUBMESSAGE_CONTENT_TYPE, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_PRIORITY, int);
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_CreateFromByteArray, my_IoTHubMessage_CreateFromByteArray);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_CreateFromByteArray, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_Clone, my_IoTHubMessage_Clone);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_Destroy, my_IoTHubMessage_Destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetContentType, my_IoTHubMessage_GetContentType);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetByteArray, my_IoTHubMessage_GetByteArray);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetString, my_IoTHubMessage_GetString);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_Properties, my_IoTHubMessage_Properties);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetMessageId, my_IoTHubMessage_GetMessageId);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetCorrelationId, my_IoTHubMessage_GetCorrelationId);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetMessageId, my_IoTHubMessage_SetMessageId);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetCorrelationId, my_IoTHubMessage_SetCorrelationId);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetPriority, my_IoTHubMessage_SetPriority);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetPriority, my_IoTHubMessage_GetPriority);
+    REGISTER_GLOBAL_MOCK_HOOK(Map_GetInternals, my_Map_GetInternals);
+    REGISTER_GLOBAL_MOCK_HOOK(Map_AddOrUpdate, my_Map_AddOrUpdate);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_001: [ If dictionary is NULL and dictionarySize is not 0, compression_create shall fail and return NULL. ]*/
+TEST_FUNCTION(compression_create_with_NULL_dictionary_and_non_zero_size_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE result;
+
+    ///act
+    result = compression_create(NULL, 1);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_002: [ compression_create shall copy the last COMPRESSION_MAX_DICTIONARY_SIZE bytes of the dictionary and hash its positions once. ]*/
+TEST_FUNCTION(compression_create_without_dictionary_succeeds)
+{
+    ///arrange
+    COMPRESSION_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    ///act
+    result = compression_create(NULL, 0);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    compression_destroy(result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_002: [ compression_create shall copy the last COMPRESSION_MAX_DICTIONARY_SIZE bytes of the dictionary and hash its positions once. ]*/
+TEST_FUNCTION(compression_create_with_dictionary_copies_the_dictionary)
+{
+    ///arrange
+    COMPRESSION_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_DICTIONARY)));
+
+    ///act
+    result = compression_create((const unsigned char*)TEST_DICTIONARY, strlen(TEST_DICTIONARY));
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    compression_destroy(result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_002: [ compression_create shall copy the last COMPRESSION_MAX_DICTIONARY_SIZE bytes of the dictionary and hash its positions once. ]*/
+TEST_FUNCTION(compression_create_keeps_the_last_COMPRESSION_MAX_DICTIONARY_SIZE_bytes_of_the_dictionary)
+{
+    ///arrange
+    COMPRESSION_HANDLE result;
+    size_t dictionarySize = COMPRESSION_MAX_DICTIONARY_SIZE + 100;
+    unsigned char* dictionary = (unsigned char*)my_gballoc_malloc(dictionarySize);
+    (void)memset(dictionary, 'x', dictionarySize);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(COMPRESSION_MAX_DICTIONARY_SIZE));
+
+    ///act
+    result = compression_create(dictionary, dictionarySize);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    compression_destroy(result);
+    my_gballoc_free(dictionary);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_003: [ If any failure occurs, compression_create shall fail and return NULL. ]*/
+TEST_FUNCTION(compression_create_fails_when_malloc_of_the_dictionary_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_DICTIONARY)))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    ///act
+    result = compression_create((const unsigned char*)TEST_DICTIONARY, strlen(TEST_DICTIONARY));
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_003: [ If any failure occurs, compression_create shall fail and return NULL. ]*/
+TEST_FUNCTION(compression_create_fails_when_malloc_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    ///act
+    result = compression_create(NULL, 0);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_004: [ If compression is NULL, compression_destroy shall do nothing. ]*/
+TEST_FUNCTION(compression_destroy_with_NULL_handle_does_nothing)
+{
+    ///act
+    compression_destroy(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_005: [ compression_destroy shall free the dictionary and the instance. ]*/
+TEST_FUNCTION(compression_destroy_frees_the_dictionary_and_the_instance)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(TEST_DICTIONARY);
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(compression));
+
+    ///act
+    compression_destroy(compression);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_006: [ compression_get_bound shall return COMPRESSION_HEADER_SIZE + size + size / 255 + 16. ]*/
+TEST_FUNCTION(compression_get_bound_returns_the_worst_case_size)
+{
+    ///act
+    size_t result = compression_get_bound(1000);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, COMPRESSION_HEADER_SIZE + 1000 + 3 + 16, result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_007: [ If compression, destination or destinationSize is NULL, or source is NULL and size is not 0, compression_compress shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(compression_compress_with_NULL_arguments_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char destination[64];
+    size_t destinationSize = sizeof(destination);
+
+    ///act
+    int result1 = compression_compress(NULL, (const unsigned char*)"abc", 3, destination, &destinationSize);
+    int result2 = compression_compress(compression, NULL, 3, destination, &destinationSize);
+    int result3 = compression_compress(compression, (const unsigned char*)"abc", 3, NULL, &destinationSize);
+    int result4 = compression_compress(compression, (const unsigned char*)"abc", 3, destination, NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result4);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_008: [ compression_compress shall write the uncompressed size followed by the LZ4 block of the body, matches may reference the dictionary, and set *destinationSize to the size written. ]*/
+TEST_FUNCTION(compression_compress_of_an_empty_body_writes_the_size_and_an_empty_block)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char destination[64];
+    size_t destinationSize = sizeof(destination);
+
+    ///act
+    int result = compression_compress(compression, NULL, 0, destination, &destinationSize);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, COMPRESSION_HEADER_SIZE + 1, destinationSize);
+    ASSERT_ARE_EQUAL(int, 0, destination[0] | destination[1] | destination[2] | destination[3] | destination[4]);
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_008: [ compression_compress shall write the uncompressed size followed by the LZ4 block of the body, matches may reference the dictionary, and set *destinationSize to the size written. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_012: [ compression_decompress shall decode the LZ4 block, resolving the offsets that go back beyond the start of the body in the dictionary, and set *destinationSize to the uncompressed size. ]*/
+TEST_FUNCTION(compression_compress_shrinks_a_repetitive_body_and_decompress_restores_it)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char source[TEST_MAX_CONTENT];
+    size_t size = 0;
+    while (size + strlen(TEST_JSON) <= sizeof(source))
+    {
+        (void)memcpy(source + size, TEST_JSON, strlen(TEST_JSON));
+        size += strlen(TEST_JSON);
+    }
+
+    ///act
+    size_t compressedSize = assertRoundTrip(compression, source, size);
+
+    ///assert
+    ASSERT_IS_TRUE(compressedSize < size / 4);
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_008: [ compression_compress shall write the uncompressed size followed by the LZ4 block of the body, matches may reference the dictionary, and set *destinationSize to the size written. ]*/
+TEST_FUNCTION(compression_compress_of_incompressible_data_stays_under_the_bound)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char source[TEST_MAX_CONTENT];
+    uint32_t seed = 12345;
+    size_t i;
+    for (i = 0; i < sizeof(source); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        source[i] = (unsigned char)(seed >> 16);
+    }
+
+    ///act
+    size_t compressedSize = assertRoundTrip(compression, source, sizeof(source));
+
+    ///assert
+    ASSERT_IS_TRUE(compressedSize > sizeof(source));
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_008: [ compression_compress shall write the uncompressed size followed by the LZ4 block of the body, matches may reference the dictionary, and set *destinationSize to the size written. ]*/
+TEST_FUNCTION(compression_compress_with_a_dictionary_shrinks_a_small_message)
+{
+    ///arrange
+    COMPRESSION_HANDLE withoutDictionary = createCompression(NULL);
+    COMPRESSION_HANDLE withDictionary = createCompression(TEST_DICTIONARY);
+
+    ///act
+    size_t sizeWithoutDictionary = assertRoundTrip(withoutDictionary, (const unsigned char*)TEST_JSON, strlen(TEST_JSON));
+    size_t sizeWithDictionary = assertRoundTrip(withDictionary, (const unsigned char*)TEST_JSON, strlen(TEST_JSON));
+
+    ///assert
+    ASSERT_IS_TRUE(sizeWithoutDictionary >= strlen(TEST_JSON));
+    ASSERT_IS_TRUE(sizeWithDictionary < strlen(TEST_JSON) / 2);
+
+    ///cleanup
+    compression_destroy(withDictionary);
+    compression_destroy(withoutDictionary);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_009: [ If the compressed body does not fit in *destinationSize bytes, compression_compress shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(compression_compress_fails_when_the_body_does_not_fit)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char destination[16];
+    size_t destinationSize = sizeof(destination);
+
+    ///act
+    int result = compression_compress(compression, (const unsigned char*)TEST_JSON, strlen(TEST_JSON), destination, &destinationSize);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_010: [ If any other failure occurs, compression_compress shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(compression_compress_fails_when_growing_the_window_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char destination[256];
+    size_t destinationSize = sizeof(destination);
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, strlen(TEST_JSON)))
+        .SetReturn(NULL);
+
+    ///act
+    int result = compression_compress(compression, (const unsigned char*)TEST_JSON, strlen(TEST_JSON), destination, &destinationSize);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_011: [ If compression, source, destination or destinationSize is NULL, compression_decompress shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(compression_decompress_with_NULL_arguments_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char destination[64];
+    size_t destinationSize = sizeof(destination);
+
+    ///act
+    int result1 = compression_decompress(NULL, REFERENCE_BLOCK, sizeof(REFERENCE_BLOCK), destination, &destinationSize);
+    int result2 = compression_decompress(compression, NULL, sizeof(REFERENCE_BLOCK), destination, &destinationSize);
+    int result3 = compression_decompress(compression, REFERENCE_BLOCK, sizeof(REFERENCE_BLOCK), NULL, &destinationSize);
+    int result4 = compression_decompress(compression, REFERENCE_BLOCK, sizeof(REFERENCE_BLOCK), destination, NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result4);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_012: [ compression_decompress shall decode the LZ4 block, resolving the offsets that go back beyond the start of the body in the dictionary, and set *destinationSize to the uncompressed size. ]*/
+TEST_FUNCTION(compression_decompress_decodes_a_block_of_the_reference_library)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char destination[64];
+    size_t destinationSize = sizeof(destination);
+
+    ///act
+    int result = compression_decompress(compression, REFERENCE_BLOCK, sizeof(REFERENCE_BLOCK), destination, &destinationSize);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 30, destinationSize);
+    ASSERT_ARE_EQUAL(int, 0, memcmp("abcabcabcabcabcabcabcabcabcabc", destination, 30));
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_012: [ compression_decompress shall decode the LZ4 block, resolving the offsets that go back beyond the start of the body in the dictionary, and set *destinationSize to the uncompressed size. ]*/
+TEST_FUNCTION(compression_decompress_resolves_offsets_in_the_dictionary)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression("{\"temperature\":20.0,\"humidity\":50}");
+    unsigned char destination[64];
+    size_t destinationSize = sizeof(destination);
+
+    ///act
+    int result = compression_decompress(compression, REFERENCE_DICTIONARY_BLOCK, sizeof(REFERENCE_DICTIONARY_BLOCK), destination, &destinationSize);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 34, destinationSize);
+    ASSERT_ARE_EQUAL(int, 0, memcmp("{\"temperature\":21.5,\"humidity\":40}", destination, 34));
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_013: [ If the body is corrupt, compression_decompress shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(compression_decompress_of_a_truncated_block_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char destination[64];
+    size_t destinationSize = sizeof(destination);
+
+    ///act
+    int result = compression_decompress(compression, REFERENCE_BLOCK, sizeof(REFERENCE_BLOCK) - 1, destination, &destinationSize);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_013: [ If the body is corrupt, compression_decompress shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(compression_decompress_of_an_offset_beyond_the_dictionary_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char destination[64];
+    size_t destinationSize = sizeof(destination);
+
+    ///act
+    int result = compression_decompress(compression, REFERENCE_DICTIONARY_BLOCK, sizeof(REFERENCE_DICTIONARY_BLOCK), destination, &destinationSize);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_014: [ If the uncompressed body does not fit in *destinationSize bytes, compression_decompress shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(compression_decompress_fails_when_the_body_does_not_fit)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    unsigned char destination[29];
+    size_t destinationSize = sizeof(destination);
+
+    ///act
+    int result = compression_decompress(compression, REFERENCE_BLOCK, sizeof(REFERENCE_BLOCK), destination, &destinationSize);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    ///cleanup
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_015: [ If compression or message is NULL, compression_compress_message shall fail and return NULL. ]*/
+TEST_FUNCTION(compression_compress_message_with_NULL_arguments_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromString(TEST_JSON);
+
+    ///act
+    IOTHUB_MESSAGE_HANDLE result1 = compression_compress_message(NULL, message, NULL);
+    IOTHUB_MESSAGE_HANDLE result2 = compression_compress_message(compression, NULL, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result1);
+    ASSERT_IS_NULL(result2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(message);
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_016: [ compression_compress_message shall create a message from the compressed content, copy the properties, the message id, the correlation id and the priority of message, and add the COMPRESSION_CONTENT_ENCODING_PROPERTY property and, if dictionaryId is not NULL, the COMPRESSION_DICTIONARY_PROPERTY property. ]*/
+TEST_FUNCTION(compression_compress_message_copies_the_message_with_a_compressed_body)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(TEST_DICTIONARY);
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromByteArray((const unsigned char*)TEST_JSON, strlen(TEST_JSON));
+    TEST_MESSAGE* compressedMessage;
+    unsigned char decompressed[TEST_MAX_CONTENT];
+    size_t decompressedSize = sizeof(decompressed);
+    (void)my_IoTHubMessage_SetMessageId(message, "id1");
+    (void)my_IoTHubMessage_SetCorrelationId(message, "corr1");
+    (void)my_IoTHubMessage_SetPriority(message, IOTHUB_MESSAGE_PRIORITY_HIGH);
+    (void)my_Map_AddOrUpdate((MAP_HANDLE)message, "k1", "v1");
+
+    ///act
+    IOTHUB_MESSAGE_HANDLE result = compression_compress_message(compression, message, TEST_DICTIONARY_ID);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    compressedMessage = (TEST_MESSAGE*)result;
+    ASSERT_ARE_EQUAL(int, (int)IOTHUBMESSAGE_BYTEARRAY, (int)compressedMessage->contentType);
+    ASSERT_IS_TRUE(compressedMessage->size < strlen(TEST_JSON));
+    ASSERT_ARE_EQUAL(int, 0, compression_decompress(compression, compressedMessage->content, compressedMessage->size, decompressed, &decompressedSize));
+    ASSERT_ARE_EQUAL(size_t, strlen(TEST_JSON), decompressedSize);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(TEST_JSON, decompressed, decompressedSize));
+    ASSERT_ARE_EQUAL(char_ptr, "id1", compressedMessage->messageId);
+    ASSERT_ARE_EQUAL(char_ptr, "corr1", compressedMessage->correlationId);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_MESSAGE_PRIORITY_HIGH, (int)compressedMessage->priority);
+    ASSERT_ARE_EQUAL(size_t, 3, compressedMessage->propertyCount);
+    ASSERT_ARE_EQUAL(char_ptr, "k1", compressedMessage->keys[0]);
+    ASSERT_ARE_EQUAL(char_ptr, "v1", compressedMessage->values[0]);
+    ASSERT_ARE_EQUAL(char_ptr, COMPRESSION_CONTENT_ENCODING_PROPERTY, compressedMessage->keys[1]);
+    ASSERT_ARE_EQUAL(char_ptr, COMPRESSION_CONTENT_ENCODING, compressedMessage->values[1]);
+    ASSERT_ARE_EQUAL(char_ptr, COMPRESSION_DICTIONARY_PROPERTY, compressedMessage->keys[2]);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_DICTIONARY_ID, compressedMessage->values[2]);
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(result);
+    my_IoTHubMessage_Destroy(message);
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_016: [ compression_compress_message shall create a message from the compressed content, copy the properties, the message id, the correlation id and the priority of message, and add the COMPRESSION_CONTENT_ENCODING_PROPERTY property and, if dictionaryId is not NULL, the COMPRESSION_DICTIONARY_PROPERTY property. ]*/
+TEST_FUNCTION(compression_compress_message_of_a_string_message_compresses_it_without_the_terminator)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(TEST_DICTIONARY);
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromString(TEST_JSON);
+    TEST_MESSAGE* compressedMessage;
+    unsigned char decompressed[TEST_MAX_CONTENT];
+    size_t decompressedSize = sizeof(decompressed);
+
+    ///act
+    IOTHUB_MESSAGE_HANDLE result = compression_compress_message(compression, message, NULL);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    compressedMessage = (TEST_MESSAGE*)result;
+    ASSERT_ARE_EQUAL(int, (int)IOTHUBMESSAGE_BYTEARRAY, (int)compressedMessage->contentType);
+    ASSERT_ARE_EQUAL(int, 0, compression_decompress(compression, compressedMessage->content, compressedMessage->size, decompressed, &decompressedSize));
+    ASSERT_ARE_EQUAL(size_t, strlen(TEST_JSON), decompressedSize);
+    ASSERT_ARE_EQUAL(size_t, 1, compressedMessage->propertyCount);
+    ASSERT_ARE_EQUAL(char_ptr, COMPRESSION_CONTENT_ENCODING_PROPERTY, compressedMessage->keys[0]);
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(result);
+    my_IoTHubMessage_Destroy(message);
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_017: [ If the content of the message cannot be read or compressing does not make it smaller, compression_compress_message shall return a clone of the message made with IoTHubMessage_Clone. ]*/
+TEST_FUNCTION(compression_compress_message_clones_a_message_that_does_not_shrink)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromByteArray((const unsigned char*)"0123456789", 10);
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(message));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(message, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(compression_get_bound(10)));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 10));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(message));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    ///act
+    IOTHUB_MESSAGE_HANDLE result = compression_compress_message(compression, message, NULL);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 10, ((TEST_MESSAGE*)result)->size);
+    ASSERT_ARE_EQUAL(size_t, 0, ((TEST_MESSAGE*)result)->propertyCount);
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(result);
+    my_IoTHubMessage_Destroy(message);
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_017: [ If the content of the message cannot be read or compressing does not make it smaller, compression_compress_message shall return a clone of the message made with IoTHubMessage_Clone. ]*/
+TEST_FUNCTION(compression_compress_message_clones_a_message_of_unknown_content_type)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromByteArray((const unsigned char*)TEST_JSON, strlen(TEST_JSON));
+    ((TEST_MESSAGE*)message)->contentType = IOTHUBMESSAGE_UNKNOWN;
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(message));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(message));
+
+    ///act
+    IOTHUB_MESSAGE_HANDLE result = compression_compress_message(compression, message, NULL);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(result);
+    my_IoTHubMessage_Destroy(message);
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_018: [ If any other failure occurs, compression_compress_message shall fail and return NULL. ]*/
+TEST_FUNCTION(compression_compress_message_fails_when_creating_the_message_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(TEST_DICTIONARY);
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromByteArray((const unsigned char*)TEST_JSON, strlen(TEST_JSON));
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(message));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(message, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(compression_get_bound(strlen(TEST_JSON))));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, strlen(TEST_DICTIONARY) + strlen(TEST_JSON)));
+    STRICT_EXPECTED_CALL(IoTHubMessage_CreateFromByteArray(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    ///act
+    IOTHUB_MESSAGE_HANDLE result = compression_compress_message(compression, message, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(message);
+    compression_destroy(compression);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_COMPRESSION_02_018: [ If any other failure occurs, compression_compress_message shall fail and return NULL. ]*/
+TEST_FUNCTION(compression_compress_message_fails_when_malloc_fails)
+{
+    ///arrange
+    COMPRESSION_HANDLE compression = createCompression(NULL);
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromByteArray((const unsigned char*)TEST_JSON, strlen(TEST_JSON));
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(message));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(message, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(compression_get_bound(strlen(TEST_JSON))))
+        .SetReturn(NULL);
+
+    ///act
+    IOTHUB_MESSAGE_HANDLE result = compression_compress_message(compression, message, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(message);
+    compression_destroy(compression);
+}
+
+END_TEST_SUITE(iothub_client_compression_ut)
@@ -0,0 +1,230 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
+
+#include "iothub_client_ingress_queue.h"
+
+/*
+ * Measures how long a producer thread waits to hand an event to the worker thread while the worker
+ * is busy in a slow DoWork (a synchronous HTTP round trip is modeled by DO_WORK_MS of sleep):
+ *  - "lock": the producer takes the lock that the worker holds during DoWork, as IoTHubClient_SendEventAsync
+ *    does without OPTION_SEND_INGRESS_QUEUE
+ *  - "ingress queue": the producer pushes to the ingress queue, the worker drains it before DoWork
+ * The latencies are in milliseconds, as the tick counter reports them.
+ */
+
+#define PRODUCER_COUNT 4
+#define EVENTS_PER_PRODUCER 200
+#define DO_WORK_MS 20
+#define PRODUCER_PAUSE_MS 1
+
+typedef struct PERF_EVENT_TAG
+{
+    INGRESS_QUEUE_ENTRY entry;
+    unsigned int producer;
+} PERF_EVENT;
+
+typedef struct PERF_CONTEXT_TAG
+{
+    TICK_COUNTER_HANDLE tickCounter;
+    LOCK_HANDLE lock;
+    INGRESS_QUEUE_HANDLE ingressQueue; /*NULL in the "lock" run*/
+    volatile int stop;
+    size_t consumed; /*touched only by the worker*/
+    PERF_EVENT events[PRODUCER_COUNT * EVENTS_PER_PRODUCER];
+    tickcounter_ms_t latencies[PRODUCER_COUNT * EVENTS_PER_PRODUCER];
+} PERF_CONTEXT;
+
+typedef struct PRODUCER_TAG
+{
+    PERF_CONTEXT* context;
+    unsigned int index;
+} PRODUCER;
+
+static void OnEvent(INGRESS_QUEUE_ENTRY* entry, void* context)
+{
+    (void)entry;
+    ((PERF_CONTEXT*)context)->consumed++;
+}
+
+static int Worker(void* arg)
+{
+    PERF_CONTEXT* context = (PERF_CONTEXT*)arg;
+    while (!context->stop)
+    {
+        (void)Lock(context->lock);
+        if (context->ingressQueue != NULL)
+        {
+            (void)ingress_queue_drain(context->ingressQueue, OnEvent, context);
+        }
+        /*the slow DoWork*/
+        ThreadAPI_Sleep(DO_WORK_MS);
+        (void)Unlock(context->lock);
+        ThreadAPI_Sleep(1);
+    }
+    return 0;
+}
+
+static int Producer(void* arg)
+{
+    PRODUCER* producer = (PRODUCER*)arg;
+    PERF_CONTEXT* context = producer->context;
+    unsigned int i;
+
+    for (i = 0; i < EVENTS_PER_PRODUCER; i++)
+    {
+        size_t index = producer->index * EVENTS_PER_PRODUCER + i;
+        tickcounter_ms_t start;
+        tickcounter_ms_t end;
+
+        context->events[index].producer = producer->index;
+        (void)tickcounter_get_current_ms(context->tickCounter, &start);
+        if (context->ingressQueue != NULL)
+        {
+            (void)ingress_queue_push(context->ingressQueue, &context->events[index].entry);
+        }
+        else
+        {
+            (void)Lock(context->lock);
+            context->consumed++;
+            (void)Unlock(context->lock);
+        }
+        (void)tickcounter_get_current_ms(context->tickCounter, &end);
+        context->latencies[index] = end - start;
+        ThreadAPI_Sleep(PRODUCER_PAUSE_MS);
+    }
+    return 0;
+}
+
+static int CompareLatencies(const void* left, const void* right)
+{
+    tickcounter_ms_t l = *(const tickcounter_ms_t*)left;
+    tickcounter_ms_t r = *(const tickcounter_ms_t*)right;
+    return (l < r) ? -1 : ((l > r) ? 1 : 0);
+}
+
+static int Measure(PERF_CONTEXT* context, int useIngressQueue)
+{
+    int result;
+    const char* variant = useIngressQueue ? "ingress queue" : "lock";
+    THREAD_HANDLE worker;
+    THREAD_HANDLE producers[PRODUCER_COUNT];
+    PRODUCER producerArgs[PRODUCER_COUNT];
+    unsigned int i;
+    unsigned int started;
+
+    context->stop = 0;
+    context->consumed = 0;
+    context->ingressQueue = NULL;
+
+    if (useIngressQueue && ((context->ingressQueue = ingress_queue_create()) == NULL))
+    {
+        (void)printf("ingress_queue_create failed\n");
+        result = __LINE__;
+    }
+    else if (ThreadAPI_Create(&worker, Worker, context) != THREADAPI_OK)
+    {
+        (void)printf("ThreadAPI_Create failed\n");
+        ingress_queue_destroy(context->ingressQueue);
+        result = __LINE__;
+    }
+    else
+    {
+        int res;
+        result = 0;
+        for (started = 0; started < PRODUCER_COUNT; started++)
+        {
+            producerArgs[started].context = context;
+            producerArgs[started].index = started;
+            if (ThreadAPI_Create(&producers[started], Producer, &producerArgs[started]) != THREADAPI_OK)
+            {
+                (void)printf("ThreadAPI_Create failed\n");
+                result = __LINE__;
+                break;
+            }
+        }
+        for (i = 0; i < started; i++)
+        {
+            (void)ThreadAPI_Join(producers[i], &res);
+        }
+        context->stop = 1;
+        (void)ThreadAPI_Join(worker, &res);
+
+        if (context->ingressQueue != NULL)
+        {
+            (void)ingress_queue_drain(context->ingressQueue, OnEvent, context);
+            ingress_queue_destroy(context->ingressQueue);
+        }
+
+        if (result == 0)
+        {
+            size_t count = PRODUCER_COUNT * EVENTS_PER_PRODUCER;
+            char name[64];
+
+            if (context->consumed != count)
+            {
+                (void)printf("%s: %lu events consumed, %lu expected\n", variant, (unsigned long)context->consumed, (unsigned long)count);
+                result = __LINE__;
+            }
+            else
+            {
+                qsort(context->latencies, count, sizeof(tickcounter_ms_t), CompareLatencies);
+                (void)sprintf(name, "send latency, %s", variant);
+                (void)printf("%-48s p50 %4lu ms p99 %4lu ms max %4lu ms\n", name,
+                    (unsigned long)context->latencies[count / 2],
+                    (unsigned long)context->latencies[(count * 99) / 100],
+                    (unsigned long)context->latencies[count - 1]);
+            }
+        }
+    }
+    return result;
+}
+
+int main(void)
+{
+    int result;
+    PERF_CONTEXT* context;
+
+    if ((context = (PERF_CONTEXT*)malloc(sizeof(PERF_CONTEXT))) == NULL)
+    {
+        (void)printf("malloc failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        (void)memset(context, 0, sizeof(PERF_CONTEXT));
+        if ((context->tickCounter = tickcounter_create()) == NULL)
+        {
+            (void)printf("tickcounter_create failed\n");
+            result = __LINE__;
+        }
+        else
+        {
+            if ((context->lock = Lock_Init()) == NULL)
+            {
+                (void)printf("Lock_Init failed\n");
+                result = __LINE__;
+            }
+            else
+            {
+                int useIngressQueue;
+                result = 0;
+                for (useIngressQueue = 0; (useIngressQueue < 2) && (result == 0); useIngressQueue++)
+                {
+                    result = Measure(context, useIngressQueue);
+                }
+                Lock_Deinit(context->lock);
+            }
+            tickcounter_destroy(context->tickCounter);
+        }
+        free(context);
+    }
+
+    return result;
+}
@@ -0,0 +1,381 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_ingress_queue.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_c.h"
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+typedef struct TEST_EVENT_TAG
+{
+    INGRESS_QUEUE_ENTRY entry;
+    int id;
+} TEST_EVENT;
+
+#define TEST_MAX_DRAINED 8
+static int drainedIds[TEST_MAX_DRAINED];
+static size_t drainedCount;
+static void* drainedContext;
+static INGRESS_QUEUE_HANDLE pushWhileDraining; /*when not NULL, the callback pushes lateEvent to it*/
+static TEST_EVENT lateEvent;
+
+static void onEntry(INGRESS_QUEUE_ENTRY* entry, void* context)
+{
+    TEST_EVENT* testEvent = (TEST_EVENT*)((char*)entry - offsetof(TEST_EVENT, entry));
+    ASSERT_IS_TRUE(drainedCount < TEST_MAX_DRAINED);
+    drainedIds[drainedCount++] = testEvent->id;
+    drainedContext = context;
+    if (pushWhileDraining != NULL)
+    {
+        ASSERT_ARE_EQUAL(int, 0, ingress_queue_push(pushWhileDraining, &lateEvent.entry));
+        pushWhileDraining = NULL;
+    }
+}
+
+static void onEntryFree(INGRESS_QUEUE_ENTRY* entry, void* context)
+{
+    onEntry(entry, context);
+    my_gballoc_free(entry);
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(iothub_client_ingress_queue_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    int result;
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_c_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+    drainedCount = 0;
+    drainedContext = NULL;
+    pushWhileDraining = NULL;
+    lateEvent.id = 100;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_001: [ ingress_queue_create shall allocate an empty queue and return a non-NULL handle to it. ]*/
+TEST_FUNCTION(ingress_queue_create_succeeds)
+{
+    ///arrange
+    INGRESS_QUEUE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    ///act
+    result = ingress_queue_create();
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(ingress_queue_is_empty(result));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    ingress_queue_destroy(result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_002: [ If any failure occurs, ingress_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(ingress_queue_create_fails_when_malloc_fails)
+{
+    ///arrange
+    INGRESS_QUEUE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    ///act
+    result = ingress_queue_create();
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_003: [ If queue is NULL, ingress_queue_destroy shall do nothing. ]*/
+TEST_FUNCTION(ingress_queue_destroy_with_NULL_does_nothing)
+{
+    ///act
+    ingress_queue_destroy(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_004: [ ingress_queue_destroy shall free the queue and shall not touch the entries that are still in it. ]*/
+TEST_FUNCTION(ingress_queue_destroy_frees_the_queue_and_not_the_entries)
+{
+    ///arrange
+    TEST_EVENT testEvent = { { NULL }, 1 };
+    INGRESS_QUEUE_HANDLE queue = ingress_queue_create();
+    (void)ingress_queue_push(queue, &testEvent.entry);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(queue));
+
+    ///act
+    ingress_queue_destroy(queue);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 1, testEvent.id);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_005: [ If queue or entry is NULL, ingress_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ingress_queue_push_with_NULL_queue_fails)
+{
+    ///arrange
+    TEST_EVENT testEvent = { { NULL }, 1 };
+
+    ///act
+    int result = ingress_queue_push(NULL, &testEvent.entry);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_005: [ If queue or entry is NULL, ingress_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ingress_queue_push_with_NULL_entry_fails)
+{
+    ///arrange
+    INGRESS_QUEUE_HANDLE queue = ingress_queue_create();
+    umock_c_reset_all_calls();
+
+    ///act
+    int result = ingress_queue_push(queue, NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(ingress_queue_is_empty(queue));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    ingress_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_006: [ ingress_queue_push shall link entry in front of the current head and make it the head with a compare-and-swap, retrying with the new head when another producer got there first, and return 0. ]*/
+TEST_FUNCTION(ingress_queue_push_succeeds_without_allocating)
+{
+    ///arrange
+    TEST_EVENT testEvent = { { NULL }, 1 };
+    INGRESS_QUEUE_HANDLE queue = ingress_queue_create();
+    umock_c_reset_all_calls();
+
+    ///act
+    int result = ingress_queue_push(queue, &testEvent.entry);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(ingress_queue_is_empty(queue));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    (void)ingress_queue_drain(queue, onEntry, NULL);
+    ingress_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_007: [ If queue or callback is NULL, ingress_queue_drain shall return 0. ]*/
+TEST_FUNCTION(ingress_queue_drain_with_NULL_queue_returns_0)
+{
+    ///act
+    size_t result = ingress_queue_drain(NULL, onEntry, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, drainedCount);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_007: [ If queue or callback is NULL, ingress_queue_drain shall return 0. ]*/
+TEST_FUNCTION(ingress_queue_drain_with_NULL_callback_returns_0_and_keeps_the_entries)
+{
+    ///arrange
+    TEST_EVENT testEvent = { { NULL }, 1 };
+    INGRESS_QUEUE_HANDLE queue = ingress_queue_create();
+    (void)ingress_queue_push(queue, &testEvent.entry);
+
+    ///act
+    size_t result = ingress_queue_drain(queue, NULL, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_IS_FALSE(ingress_queue_is_empty(queue));
+
+    ///cleanup
+    (void)ingress_queue_drain(queue, onEntry, NULL);
+    ingress_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_008: [ ingress_queue_drain shall take all the entries from the queue with one exchange of the head with NULL. ]*/
+TEST_FUNCTION(ingress_queue_drain_of_an_empty_queue_returns_0)
+{
+    ///arrange
+    INGRESS_QUEUE_HANDLE queue = ingress_queue_create();
+
+    ///act
+    size_t result = ingress_queue_drain(queue, onEntry, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, drainedCount);
+
+    ///cleanup
+    ingress_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_008: [ ingress_queue_drain shall take all the entries from the queue with one exchange of the head with NULL. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_009: [ ingress_queue_drain shall call callback with every taken entry and context, in the order the entries were pushed, and return the number of entries. ]*/
+TEST_FUNCTION(ingress_queue_drain_gives_the_entries_in_push_order)
+{
+    ///arrange
+    TEST_EVENT testEvents[3] = { { { NULL }, 1 }, { { NULL }, 2 }, { { NULL }, 3 } };
+    INGRESS_QUEUE_HANDLE queue = ingress_queue_create();
+    (void)ingress_queue_push(queue, &testEvents[0].entry);
+    (void)ingress_queue_push(queue, &testEvents[1].entry);
+    (void)ingress_queue_push(queue, &testEvents[2].entry);
+    umock_c_reset_all_calls();
+
+    ///act
+    size_t result = ingress_queue_drain(queue, onEntry, (void*)0x42);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 3, result);
+    ASSERT_ARE_EQUAL(size_t, 3, drainedCount);
+    ASSERT_ARE_EQUAL(int, 1, drainedIds[0]);
+    ASSERT_ARE_EQUAL(int, 2, drainedIds[1]);
+    ASSERT_ARE_EQUAL(int, 3, drainedIds[2]);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, drainedContext);
+    ASSERT_IS_TRUE(ingress_queue_is_empty(queue));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    ingress_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_009: [ ingress_queue_drain shall call callback with every taken entry and context, in the order the entries were pushed, and return the number of entries. ]*/
+TEST_FUNCTION(ingress_queue_drain_lets_the_callback_free_the_entries)
+{
+    ///arrange
+    INGRESS_QUEUE_HANDLE queue = ingress_queue_create();
+    int i;
+    for (i = 1; i <= 2; i++)
+    {
+        TEST_EVENT* testEvent = (TEST_EVENT*)my_gballoc_malloc(sizeof(TEST_EVENT));
+        testEvent->id = i;
+        (void)ingress_queue_push(queue, &testEvent->entry);
+    }
+
+    ///act
+    size_t result = ingress_queue_drain(queue, onEntryFree, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 2, result);
+    ASSERT_ARE_EQUAL(int, 1, drainedIds[0]);
+    ASSERT_ARE_EQUAL(int, 2, drainedIds[1]);
+
+    ///cleanup
+    ingress_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_008: [ ingress_queue_drain shall take all the entries from the queue with one exchange of the head with NULL. ]*/
+TEST_FUNCTION(ingress_queue_drain_leaves_entries_pushed_by_the_callback_for_the_next_drain)
+{
+    ///arrange
+    TEST_EVENT testEvent = { { NULL }, 1 };
+    INGRESS_QUEUE_HANDLE queue = ingress_queue_create();
+    (void)ingress_queue_push(queue, &testEvent.entry);
+    pushWhileDraining = queue;
+
+    ///act
+    size_t first = ingress_queue_drain(queue, onEntry, NULL);
+    size_t second = ingress_queue_drain(queue, onEntry, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 1, first);
+    ASSERT_ARE_EQUAL(size_t, 1, second);
+    ASSERT_ARE_EQUAL(int, 1, drainedIds[0]);
+    ASSERT_ARE_EQUAL(int, 100, drainedIds[1]);
+
+    ///cleanup
+    ingress_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_INGRESS_QUEUE_02_010: [ ingress_queue_is_empty shall return true if queue is NULL or has no entry, false otherwise. ]*/
+TEST_FUNCTION(ingress_queue_is_empty_with_NULL_returns_true)
+{
+    ///act
+    bool result = ingress_queue_is_empty(NULL);
+
+    ///assert
+    ASSERT_IS_TRUE(result);
+}
+
+END_TEST_SUITE(iothub_client_ingress_queue_ut)
@@ -0,0 +1,208 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "azure_c_shared_utility/map.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
+#include "iothub_message.h"
+#include "iothub_client_private.h"
+#include "micro_benchmark.h"
+
+#include "iothub_client_message_perf.h"
+
+/*
+ * Measures the message hot paths of the client:
+ *  - IoTHubMessage_CreateFromByteArray (with its IoTHubMessage_Destroy) and IoTHubMessage_Clone of an event with a few properties
+ *  - the HTTP batch payload (makePayload) of BATCH_COUNT such events, when the HTTP transport is built
+ *  - the parsing of the properties of a cloud to device topic (extractMqttProperties), when the MQTT transport is built
+ * The results are compared against the baseline file given on the command line (iothub_client_message_perf_baseline.txt
+ * next to this file), see micro_benchmark.h.
+ */
+
+#define EVENT_SIZE 256
+#define BATCH_COUNT 8
+
+static const char* const PROPERTY_NAMES[] = { "temperatureAlert", "unit", "source" };
+static const char* const PROPERTY_VALUES[] = { "false", "celsius", "iothub_client_message_perf" };
+static const char C2D_TOPIC[] = "devices/perf/messages/devicebound/%24.to=%2Fdevices%2Fperf%2Fmessages%2FdeviceBound&%24.mid=42&temperatureAlert=false&unit=celsius&source=iothub_client_message_perf";
+
+typedef struct MESSAGE_PERF_TAG
+{
+    unsigned char body[EVENT_SIZE];
+    IOTHUB_MESSAGE_HANDLE event;
+    IOTHUB_MESSAGE_HANDLE c2dMessage;
+    IOTHUB_MESSAGE_LIST batch[BATCH_COUNT];
+    DLIST_ENTRY waitingToSend;
+} MESSAGE_PERF;
+
+static IOTHUB_MESSAGE_HANDLE CreateEvent(const unsigned char* body)
+{
+    IOTHUB_MESSAGE_HANDLE result = IoTHubMessage_CreateFromByteArray(body, EVENT_SIZE);
+    if (result != NULL)
+    {
+        MAP_HANDLE properties = IoTHubMessage_Properties(result);
+        size_t i;
+        for (i = 0; i < sizeof(PROPERTY_NAMES) / sizeof(PROPERTY_NAMES[0]); i++)
+        {
+            if ((properties == NULL) || (Map_AddOrUpdate(properties, PROPERTY_NAMES[i], PROPERTY_VALUES[i]) != MAP_OK))
+            {
+                IoTHubMessage_Destroy(result);
+                result = NULL;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+static int MeasureCreateFromByteArray(void* context)
+{
+    MESSAGE_PERF* perf = (MESSAGE_PERF*)context;
+    IOTHUB_MESSAGE_HANDLE message = IoTHubMessage_CreateFromByteArray(perf->body, EVENT_SIZE);
+    int result;
+    if (message == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        IoTHubMessage_Destroy(message);
+        result = 0;
+    }
+    return result;
+}
+
+static int MeasureClone(void* context)
+{
+    MESSAGE_PERF* perf = (MESSAGE_PERF*)context;
+    IOTHUB_MESSAGE_HANDLE message = IoTHubMessage_Clone(perf->event);
+    int result;
+    if (message == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        IoTHubMessage_Destroy(message);
+        result = 0;
+    }
+    return result;
+}
+
+#ifdef USE_HTTP
+static int MeasureMakePayload(void* context)
+{
+    MESSAGE_PERF* perf = (MESSAGE_PERF*)context;
+    return message_perf_make_http_payload(&perf->waitingToSend);
+}
+#endif
+
+#ifdef USE_MQTT
+static int MeasureExtractMqttProperties(void* context)
+{
+    /*the same properties are updated in place after the first run, as they would be on a reused map*/
+    MESSAGE_PERF* perf = (MESSAGE_PERF*)context;
+    return message_perf_extract_mqtt_properties(perf->c2dMessage, C2D_TOPIC);
+}
+#endif
+
+static void DestroyMessages(MESSAGE_PERF* perf)
+{
+    size_t i;
+    for (i = 0; i < BATCH_COUNT; i++)
+    {
+        if (perf->batch[i].messageHandle != NULL)
+        {
+            IoTHubMessage_Destroy(perf->batch[i].messageHandle);
+        }
+    }
+    if (perf->c2dMessage != NULL)
+    {
+        IoTHubMessage_Destroy(perf->c2dMessage);
+    }
+    if (perf->event != NULL)
+    {
+        IoTHubMessage_Destroy(perf->event);
+    }
+}
+
+static int CreateMessages(MESSAGE_PERF* perf)
+{
+    int result;
+    size_t i;
+
+    for (i = 0; i < EVENT_SIZE; i++)
+    {
+        perf->body[i] = (unsigned char)('a' + i % 26);
+    }
+    DList_InitializeListHead(&perf->waitingToSend);
+
+    if (((perf->event = CreateEvent(perf->body)) == NULL) ||
+        ((perf->c2dMessage = IoTHubMessage_CreateFromByteArray(perf->body, EVENT_SIZE)) == NULL))
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+        for (i = 0; i < BATCH_COUNT; i++)
+        {
+            if ((perf->batch[i].messageHandle = CreateEvent(perf->body)) == NULL)
+            {
+                result = __LINE__;
+                break;
+            }
+            perf->batch[i].priority = IOTHUB_MESSAGE_PRIORITY_NORMAL;
+            DList_InsertTailList(&perf->waitingToSend, &perf->batch[i].entry);
+        }
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    MICRO_BENCHMARK_HANDLE benchmark = micro_benchmark_create(argc, argv);
+    if (benchmark == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        MESSAGE_PERF* perf = (MESSAGE_PERF*)calloc(1, sizeof(MESSAGE_PERF));
+        if (perf == NULL)
+        {
+            (void)printf("unable to allocate the benchmark data\n");
+            result = __LINE__;
+        }
+        else
+        {
+            if (CreateMessages(perf) != 0)
+            {
+                (void)printf("unable to create the messages\n");
+                result = __LINE__;
+            }
+            else
+            {
+                /*a failed operation is counted by micro_benchmark_compare*/
+                (void)micro_benchmark_run(benchmark, "IoTHubMessage_CreateFromByteArray", MeasureCreateFromByteArray, perf);
+                (void)micro_benchmark_run(benchmark, "IoTHubMessage_Clone", MeasureClone, perf);
+#ifdef USE_HTTP
+                (void)micro_benchmark_run(benchmark, "makePayload", MeasureMakePayload, perf);
+#endif
+#ifdef USE_MQTT
+                (void)micro_benchmark_run(benchmark, "extractMqttProperties", MeasureExtractMqttProperties, perf);
+#endif
+                result = micro_benchmark_compare(benchmark);
+            }
+            DestroyMessages(perf);
+            free(perf);
+        }
+        micro_benchmark_destroy(benchmark);
+    }
+    return result;
+}
@@ -0,0 +1,22 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_MESSAGE_PERF_H
+#define IOTHUB_CLIENT_MESSAGE_PERF_H
+
+#include "azure_c_shared_utility/doublylinkedlist.h"
+#include "iothub_message.h"
+
+/*the transport functions being measured are static, these reach them from translation units that include the transport sources*/
+
+#ifdef USE_HTTP
+/*builds one batched HTTP payload out of waitingToSend (a list of IOTHUB_MESSAGE_LIST), then puts the messages back*/
+extern int message_perf_make_http_payload(PDLIST_ENTRY waitingToSend);
+#endif
+
+#ifdef USE_MQTT
+/*adds the application properties carried by the topic of a cloud to device message to message*/
+extern int message_perf_extract_mqtt_properties(IOTHUB_MESSAGE_HANDLE message, const char* topicName);
+#endif
+
+#endif /* IOTHUB_CLIENT_MESSAGE_PERF_H */
@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*makePayload is static, so the transport is compiled in here instead of being linked*/
+#include "../../src/iothubtransporthttp.c"
+
+#include "iothub_client_message_perf.h"
+
+int message_perf_make_http_payload(PDLIST_ENTRY waitingToSend)
+{
+    int result;
+    HTTPTRANSPORT_PERDEVICE_DATA deviceData;
+    STRING_HANDLE payload;
+
+    (void)memset(&deviceData, 0, sizeof(deviceData));
+    deviceData.waitingToSend = waitingToSend;
+    DList_InitializeListHead(&deviceData.eventConfirmations);
+
+    if (makePayload(&deviceData, &payload) != MAKE_PAYLOAD_OK)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        STRING_delete(payload);
+        result = 0;
+    }
+
+    /*the batched messages went to eventConfirmations, the next run needs them in waitingToSend again*/
+    reversePutListBackIn(&deviceData.eventConfirmations, waitingToSend);
+    return result;
+}
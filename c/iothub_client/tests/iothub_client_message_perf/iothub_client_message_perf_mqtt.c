@@ -0,0 +1,12 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*extractMqttProperties is static, so the transport is compiled in here instead of being linked*/
+#include "../../src/iothubtransport_mqtt_common.c"
+
+#include "iothub_client_message_perf.h"
+
+int message_perf_extract_mqtt_properties(IOTHUB_MESSAGE_HANDLE message, const char* topicName)
+{
+    return extractMqttProperties(message, topicName);
+}
@@ -0,0 +1,406 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_metrics.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_c.h"
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static IOTHUB_CLIENT_METRICS testMetrics;
+static IOTHUB_CLIENT_METRICS_SNAPSHOT testSnapshot;
+static IOTHUB_CLIENT_ALLOCATIONS_SNAPSHOT testAllocations;
+static char formatted[8192];
+
+static void assertSnapshotIsZero(const IOTHUB_CLIENT_METRICS_SNAPSHOT* snapshot)
+{
+    size_t i;
+    size_t j;
+    for (i = 0; i < IOTHUB_CLIENT_METRIC_COUNT; i++)
+    {
+        ASSERT_ARE_EQUAL(uint64_t, 0, snapshot->values[i]);
+    }
+    for (i = 0; i < IOTHUB_CLIENT_HISTOGRAM_COUNT; i++)
+    {
+        for (j = 0; j < IOTHUB_CLIENT_HISTOGRAM_BUCKET_COUNT; j++)
+        {
+            ASSERT_ARE_EQUAL(uint64_t, 0, snapshot->buckets[i][j]);
+        }
+        ASSERT_ARE_EQUAL(uint64_t, 0, snapshot->sums[i]);
+    }
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(iothub_client_metrics_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    int result;
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_c_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+    (void)memset((void*)&testMetrics, 0xAB, sizeof(testMetrics));
+    (void)memset(&testSnapshot, 0xCD, sizeof(testSnapshot));
+    (void)memset(&testAllocations, 0, sizeof(testAllocations));
+    (void)memset(formatted, 'x', sizeof(formatted));
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_001: [ If metrics is NULL, iothub_client_metrics_init shall do nothing. ]*/
+TEST_FUNCTION(iothub_client_metrics_init_with_NULL_does_nothing)
+{
+    ///act
+    iothub_client_metrics_init(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_002: [ iothub_client_metrics_init shall set all the values, buckets and sums to 0. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_010: [ iothub_client_metrics_get_snapshot shall copy every value, bucket and sum with an atomic read and return 0. ]*/
+TEST_FUNCTION(iothub_client_metrics_init_zeroes_everything)
+{
+    ///act
+    iothub_client_metrics_init(&testMetrics);
+    int result = iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    assertSnapshotIsZero(&testSnapshot);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_003: [ If metrics is NULL or metric is not a IOTHUB_CLIENT_METRIC, iothub_client_metrics_add shall do nothing. ]*/
+TEST_FUNCTION(iothub_client_metrics_add_with_NULL_metrics_does_nothing)
+{
+    ///act
+    iothub_client_metrics_add(NULL, IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_OK, 1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_003: [ If metrics is NULL or metric is not a IOTHUB_CLIENT_METRIC, iothub_client_metrics_add shall do nothing. ]*/
+TEST_FUNCTION(iothub_client_metrics_add_with_unknown_metric_does_nothing)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+
+    ///act
+    iothub_client_metrics_add(&testMetrics, (IOTHUB_CLIENT_METRIC)IOTHUB_CLIENT_METRIC_COUNT, 1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot));
+    assertSnapshotIsZero(&testSnapshot);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_004: [ iothub_client_metrics_add shall add value to the value of metric with one atomic operation. ]*/
+TEST_FUNCTION(iothub_client_metrics_add_adds_to_the_value)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+
+    ///act
+    iothub_client_metrics_add(&testMetrics, IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_SENT, 100);
+    iothub_client_metrics_add(&testMetrics, IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_SENT, 23);
+    iothub_client_metrics_add(&testMetrics, IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS, 1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 123, testSnapshot.values[IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_SENT]);
+    ASSERT_ARE_EQUAL(uint64_t, 1, testSnapshot.values[IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS]);
+    ASSERT_ARE_EQUAL(uint64_t, 0, testSnapshot.values[IOTHUB_CLIENT_METRIC_TRANSPORT_BYTES_RECEIVED]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_005: [ If metrics is NULL or metric is not a IOTHUB_CLIENT_METRIC, iothub_client_metrics_set shall do nothing. ]*/
+TEST_FUNCTION(iothub_client_metrics_set_with_NULL_metrics_does_nothing)
+{
+    ///act
+    iothub_client_metrics_set(NULL, IOTHUB_CLIENT_METRIC_EVENTS_QUEUED, 1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_006: [ iothub_client_metrics_set shall store value as the value of metric with one atomic operation. ]*/
+TEST_FUNCTION(iothub_client_metrics_set_replaces_the_value)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+    iothub_client_metrics_set(&testMetrics, IOTHUB_CLIENT_METRIC_EVENTS_QUEUED, 10);
+
+    ///act
+    iothub_client_metrics_set(&testMetrics, IOTHUB_CLIENT_METRIC_EVENTS_QUEUED, 4);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 4, testSnapshot.values[IOTHUB_CLIENT_METRIC_EVENTS_QUEUED]);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_007: [ If metrics is NULL or histogram is not a IOTHUB_CLIENT_HISTOGRAM, iothub_client_metrics_record shall do nothing. ]*/
+TEST_FUNCTION(iothub_client_metrics_record_with_NULL_metrics_does_nothing)
+{
+    ///act
+    iothub_client_metrics_record(NULL, IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, 1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_007: [ If metrics is NULL or histogram is not a IOTHUB_CLIENT_HISTOGRAM, iothub_client_metrics_record shall do nothing. ]*/
+TEST_FUNCTION(iothub_client_metrics_record_with_unknown_histogram_does_nothing)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+
+    ///act
+    iothub_client_metrics_record(&testMetrics, (IOTHUB_CLIENT_HISTOGRAM)IOTHUB_CLIENT_HISTOGRAM_COUNT, 1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot));
+    assertSnapshotIsZero(&testSnapshot);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_008: [ iothub_client_metrics_record shall add 1 to bucket 0 when value is 0, to bucket i when value is between 2^(i-1) and 2^i-1, or to the last bucket when value is bigger, and add value to the sum of histogram. ]*/
+TEST_FUNCTION(iothub_client_metrics_record_picks_the_bucket_and_adds_to_the_sum)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+
+    ///act
+    iothub_client_metrics_record(&testMetrics, IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, 0);
+    iothub_client_metrics_record(&testMetrics, IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, 1);
+    iothub_client_metrics_record(&testMetrics, IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, 2);
+    iothub_client_metrics_record(&testMetrics, IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, 3);
+    iothub_client_metrics_record(&testMetrics, IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, 4);
+    iothub_client_metrics_record(&testMetrics, IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, 1000000);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 1, testSnapshot.buckets[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS][0]);
+    ASSERT_ARE_EQUAL(uint64_t, 1, testSnapshot.buckets[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS][1]);
+    ASSERT_ARE_EQUAL(uint64_t, 2, testSnapshot.buckets[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS][2]);
+    ASSERT_ARE_EQUAL(uint64_t, 1, testSnapshot.buckets[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS][3]);
+    ASSERT_ARE_EQUAL(uint64_t, 1, testSnapshot.buckets[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS][IOTHUB_CLIENT_HISTOGRAM_BUCKET_COUNT - 1]);
+    ASSERT_ARE_EQUAL(uint64_t, 1000010, testSnapshot.sums[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS]);
+    ASSERT_ARE_EQUAL(uint64_t, 0, testSnapshot.sums[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_009: [ If metrics or snapshot is NULL, iothub_client_metrics_get_snapshot shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(iothub_client_metrics_get_snapshot_with_NULL_metrics_fails)
+{
+    ///act
+    int result = iothub_client_metrics_get_snapshot(NULL, &testSnapshot);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_009: [ If metrics or snapshot is NULL, iothub_client_metrics_get_snapshot shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(iothub_client_metrics_get_snapshot_with_NULL_snapshot_fails)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+
+    ///act
+    int result = iothub_client_metrics_get_snapshot(&testMetrics, NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_011: [ If snapshot is NULL, iothub_client_metrics_format shall return 0. ]*/
+TEST_FUNCTION(iothub_client_metrics_format_with_NULL_snapshot_returns_0)
+{
+    ///act
+    size_t result = iothub_client_metrics_format(NULL, formatted, sizeof(formatted));
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_012: [ iothub_client_metrics_format shall write every value as a Prometheus gauge or counter named after its IOTHUB_CLIENT_METRIC in lower case, with iothub_client_ in place of IOTHUB_CLIENT_METRIC_. ]*/
+TEST_FUNCTION(iothub_client_metrics_format_writes_gauges_and_counters)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+    iothub_client_metrics_set(&testMetrics, IOTHUB_CLIENT_METRIC_EVENTS_QUEUED, 7);
+    iothub_client_metrics_add(&testMetrics, IOTHUB_CLIENT_METRIC_TRANSPORT_AUTH_REFRESHES, 2);
+    (void)iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot);
+
+    ///act
+    size_t result = iothub_client_metrics_format(&testSnapshot, formatted, sizeof(formatted));
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, strlen(formatted), result);
+    ASSERT_IS_NOT_NULL(strstr(formatted, "# TYPE iothub_client_events_queued gauge\niothub_client_events_queued 7\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "# TYPE iothub_client_transport_auth_refreshes counter\niothub_client_transport_auth_refreshes 2\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_events_confirmed_ok 0\n"));
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_013: [ iothub_client_metrics_format shall write every histogram as a Prometheus histogram with cumulative buckets whose "le" label is 2^i-1 for bucket i and +Inf for the last one, followed by its _sum and _count. ]*/
+TEST_FUNCTION(iothub_client_metrics_format_writes_cumulative_histograms)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+    iothub_client_metrics_record(&testMetrics, IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE, 1);
+    iothub_client_metrics_record(&testMetrics, IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE, 3);
+    (void)iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot);
+
+    ///act
+    size_t result = iothub_client_metrics_format(&testSnapshot, formatted, sizeof(formatted));
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, strlen(formatted), result);
+    ASSERT_IS_NOT_NULL(strstr(formatted, "# TYPE iothub_client_confirmation_batch_size histogram\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_confirmation_batch_size_bucket{le=\"0\"} 0\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_confirmation_batch_size_bucket{le=\"1\"} 1\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_confirmation_batch_size_bucket{le=\"3\"} 2\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_confirmation_batch_size_bucket{le=\"+Inf\"} 2\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_confirmation_batch_size_sum 4\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_confirmation_batch_size_count 2\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_confirmation_latency_ms_count 0\n"));
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_012: [ iothub_client_metrics_format shall write every value as a Prometheus gauge or counter named after its IOTHUB_CLIENT_METRIC in lower case, with iothub_client_ in place of IOTHUB_CLIENT_METRIC_. ]*/
+TEST_FUNCTION(iothub_client_metrics_format_with_NULL_destination_returns_the_length)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+    (void)iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot);
+    size_t written = iothub_client_metrics_format(&testSnapshot, formatted, sizeof(formatted));
+
+    ///act
+    size_t result = iothub_client_metrics_format(&testSnapshot, NULL, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, written, result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_012: [ iothub_client_metrics_format shall write every value as a Prometheus gauge or counter named after its IOTHUB_CLIENT_METRIC in lower case, with iothub_client_ in place of IOTHUB_CLIENT_METRIC_. ]*/
+TEST_FUNCTION(iothub_client_metrics_format_truncates_like_snprintf)
+{
+    ///arrange
+    iothub_client_metrics_init(&testMetrics);
+    (void)iothub_client_metrics_get_snapshot(&testMetrics, &testSnapshot);
+    size_t fullLength = iothub_client_metrics_format(&testSnapshot, NULL, 0);
+
+    ///act
+    size_t result = iothub_client_metrics_format(&testSnapshot, formatted, 10);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, fullLength, result);
+    ASSERT_ARE_EQUAL(size_t, 9, strlen(formatted));
+    ASSERT_ARE_EQUAL(char, 'x', formatted[10]);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_014: [ If snapshot is NULL, iothub_client_metrics_format_allocations shall return 0. ]*/
+TEST_FUNCTION(iothub_client_metrics_format_allocations_with_NULL_snapshot_returns_0)
+{
+    ///act
+    size_t result = iothub_client_metrics_format_allocations(NULL, formatted, sizeof(formatted));
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_015: [ iothub_client_metrics_format_allocations shall write the currentBytes, peakBytes and liveBlocks of snapshot as the Prometheus gauges iothub_client_allocated_bytes, iothub_client_allocated_bytes_peak and iothub_client_allocated_blocks, and its allocations as the counter iothub_client_allocations. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_016: [ Every value shall have a tag label whose value is its IOTHUB_CLIENT_ALLOCATION_TAG in lower case without IOTHUB_CLIENT_ALLOCATION_TAG_. ]*/
+TEST_FUNCTION(iothub_client_metrics_format_allocations_writes_one_value_per_tag)
+{
+    ///arrange
+    testAllocations.currentBytes[IOTHUB_CLIENT_ALLOCATION_TAG_QUEUE] = 4096;
+    testAllocations.peakBytes[IOTHUB_CLIENT_ALLOCATION_TAG_QUEUE] = 8192;
+    testAllocations.liveBlocks[IOTHUB_CLIENT_ALLOCATION_TAG_MESSAGE] = 3;
+    testAllocations.allocations[IOTHUB_CLIENT_ALLOCATION_TAG_SERIALIZER] = 42;
+
+    ///act
+    size_t result = iothub_client_metrics_format_allocations(&testAllocations, formatted, sizeof(formatted));
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, strlen(formatted), result);
+    ASSERT_IS_NOT_NULL(strstr(formatted, "# TYPE iothub_client_allocated_bytes gauge\niothub_client_allocated_bytes{tag=\"client\"} 0\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_allocated_bytes{tag=\"queue\"} 4096\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "# TYPE iothub_client_allocated_bytes_peak gauge\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_allocated_bytes_peak{tag=\"queue\"} 8192\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_allocated_blocks{tag=\"message\"} 3\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "# TYPE iothub_client_allocations counter\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_allocations{tag=\"serializer\"} 42\n"));
+    ASSERT_IS_NOT_NULL(strstr(formatted, "iothub_client_allocations{tag=\"upload\"} 0\n"));
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_METRICS_02_015: [ iothub_client_metrics_format_allocations shall write the currentBytes, peakBytes and liveBlocks of snapshot as the Prometheus gauges iothub_client_allocated_bytes, iothub_client_allocated_bytes_peak and iothub_client_allocated_blocks, and its allocations as the counter iothub_client_allocations. ]*/
+TEST_FUNCTION(iothub_client_metrics_format_allocations_truncates_like_snprintf)
+{
+    ///arrange
+    size_t fullLength = iothub_client_metrics_format_allocations(&testAllocations, NULL, 0);
+
+    ///act
+    size_t result = iothub_client_metrics_format_allocations(&testAllocations, formatted, 10);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, fullLength, result);
+    ASSERT_ARE_EQUAL(size_t, 9, strlen(formatted));
+    ASSERT_ARE_EQUAL(char, 'x', formatted[10]);
+}
+
+END_TEST_SUITE(iothub_client_metrics_ut)
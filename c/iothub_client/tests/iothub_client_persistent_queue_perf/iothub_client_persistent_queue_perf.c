@@ -0,0 +1,216 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "azure_c_shared_utility/tickcounter.h"
+
+#include "iothub_client_persistent_queue.h"
+
+/*
+ * Measures the throughput of the persistent queue on the local disk. Every run appends RECORD_COUNT
+ * records to an empty queue, reads them all back in order and acknowledges them all:
+ *  - the record size is varied from a small telemetry message to a large one
+ *  - each record size is measured with small and with default sized segments, which changes how
+ *    often a segment file is created and reclaimed
+ * The queue lives in a scratch directory created in the current directory and left empty afterwards.
+ */
+
+#define RECORD_COUNT 10000
+#define QUEUE_DIRECTORY "iothub_client_persistent_queue_perf_dir"
+
+static const size_t recordSizes[] = { 64, 1024, 16 * 1024 };
+static const size_t segmentSizes[] = { 64 * 1024, PERSISTENT_QUEUE_DEFAULT_SEGMENT_SIZE };
+
+static void PrintRate(const char* operation, size_t recordSize, size_t segmentSize, tickcounter_ms_t elapsedMs)
+{
+    char name[64];
+    double seconds = (double)elapsedMs / 1000.0;
+
+    (void)sprintf(name, "%s, %lu B records, %lu KB segments", operation, (unsigned long)recordSize, (unsigned long)(segmentSize / 1024));
+    if (seconds > 0)
+    {
+        (void)printf("%-48s %10.1f records/s %8.1f MB/s\n", name, RECORD_COUNT / seconds, (RECORD_COUNT * (double)recordSize) / (seconds * 1024 * 1024));
+    }
+    else
+    {
+        (void)printf("%-48s too fast to measure\n", name);
+    }
+}
+
+static int Measure(TICK_COUNTER_HANDLE tickCounter, unsigned char* record, size_t recordSize, size_t segmentSize)
+{
+    int result;
+    PERSISTENT_QUEUE_CONFIG config;
+    PERSISTENT_QUEUE_HANDLE queue;
+
+    config.directory = QUEUE_DIRECTORY;
+    config.maxBytes = 0;
+    config.maxMessages = 0;
+    config.segmentSize = segmentSize;
+    config.overflowPolicy = PERSISTENT_QUEUE_OVERFLOW_REJECT;
+    config.blockTimeoutInMilliseconds = 0;
+    config.maxMessagesInMemory = 0;
+
+    if ((queue = persistent_queue_create(&config)) == NULL)
+    {
+        (void)printf("persistent_queue_create failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        uint64_t first;
+        uint64_t next;
+
+        if (persistent_queue_get_range(queue, &first, &next) != 0)
+        {
+            (void)printf("persistent_queue_get_range failed\n");
+            result = __LINE__;
+        }
+        else if (first != next)
+        {
+            (void)printf("the queue directory %s is not empty\n", QUEUE_DIRECTORY);
+            result = __LINE__;
+        }
+        else
+        {
+            tickcounter_ms_t start;
+            tickcounter_ms_t end;
+            uint64_t sequenceNumber;
+            size_t i;
+
+            result = 0;
+
+            (void)tickcounter_get_current_ms(tickCounter, &start);
+            for (i = 0; (i < RECORD_COUNT) && (result == 0); i++)
+            {
+                if (persistent_queue_append(queue, record, recordSize, &sequenceNumber) != PERSISTENT_QUEUE_OK)
+                {
+                    (void)printf("persistent_queue_append failed\n");
+                    result = __LINE__;
+                }
+            }
+            (void)tickcounter_get_current_ms(tickCounter, &end);
+            if (result == 0)
+            {
+                PrintRate("append", recordSize, segmentSize, end - start);
+
+                (void)tickcounter_get_current_ms(tickCounter, &start);
+                sequenceNumber = first;
+                for (i = 0; (i < RECORD_COUNT) && (result == 0); i++)
+                {
+                    unsigned char* readRecord;
+                    size_t readSize;
+                    if (persistent_queue_read(queue, sequenceNumber, &readRecord, &readSize, &sequenceNumber) != PERSISTENT_QUEUE_OK)
+                    {
+                        (void)printf("persistent_queue_read failed\n");
+                        result = __LINE__;
+                    }
+                    else
+                    {
+                        if (readSize != recordSize)
+                        {
+                            (void)printf("persistent_queue_read returned %lu bytes instead of %lu\n", (unsigned long)readSize, (unsigned long)recordSize);
+                            result = __LINE__;
+                        }
+                        free(readRecord);
+                        sequenceNumber++;
+                    }
+                }
+                (void)tickcounter_get_current_ms(tickCounter, &end);
+            }
+
+            if (result == 0)
+            {
+                PrintRate("read", recordSize, segmentSize, end - start);
+
+                (void)tickcounter_get_current_ms(tickCounter, &start);
+                for (sequenceNumber = first; (sequenceNumber < first + RECORD_COUNT) && (result == 0); sequenceNumber++)
+                {
+                    if (persistent_queue_ack(queue, sequenceNumber) != 0)
+                    {
+                        (void)printf("persistent_queue_ack failed\n");
+                        result = __LINE__;
+                    }
+                }
+                (void)tickcounter_get_current_ms(tickCounter, &end);
+                if (result == 0)
+                {
+                    PrintRate("ack", recordSize, segmentSize, end - start);
+                }
+            }
+        }
+        persistent_queue_destroy(queue);
+    }
+    return result;
+}
+
+/*the segment that was active at the end of a run is kept by the queue, the next run starts from an empty directory*/
+static void CleanDirectory(void)
+{
+    char fileName[64];
+    unsigned long i;
+    for (i = 0; i < RECORD_COUNT; i++)
+    {
+        (void)sprintf(fileName, "%s/seg%010lu.log", QUEUE_DIRECTORY, i);
+        (void)remove(fileName);
+    }
+    (void)remove(QUEUE_DIRECTORY "/queue.manifest");
+}
+
+int main(void)
+{
+    int result;
+    TICK_COUNTER_HANDLE tickCounter;
+    unsigned char* record;
+
+#ifdef _WIN32
+    (void)_mkdir(QUEUE_DIRECTORY);
+#else
+    (void)mkdir(QUEUE_DIRECTORY, 0777);
+#endif
+
+    if ((tickCounter = tickcounter_create()) == NULL)
+    {
+        (void)printf("tickcounter_create failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        if ((record = (unsigned char*)malloc(recordSizes[sizeof(recordSizes) / sizeof(recordSizes[0]) - 1])) == NULL)
+        {
+            (void)printf("malloc failed\n");
+            result = __LINE__;
+        }
+        else
+        {
+            size_t i;
+            size_t j;
+
+            (void)memset(record, 'x', recordSizes[sizeof(recordSizes) / sizeof(recordSizes[0]) - 1]);
+            result = 0;
+            for (i = 0; (i < sizeof(recordSizes) / sizeof(recordSizes[0])) && (result == 0); i++)
+            {
+                for (j = 0; (j < sizeof(segmentSizes) / sizeof(segmentSizes[0])) && (result == 0); j++)
+                {
+                    CleanDirectory();
+                    result = Measure(tickCounter, record, recordSizes[i], segmentSizes[j]);
+                }
+            }
+            free(record);
+        }
+        tickcounter_destroy(tickCounter);
+    }
+
+    CleanDirectory();
+    (void)remove(QUEUE_DIRECTORY);
+
+    return result;
+}
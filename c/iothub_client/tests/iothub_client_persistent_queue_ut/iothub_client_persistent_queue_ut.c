@@ -0,0 +1,1154 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "iothub_message.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_persistent_queue.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_c.h"
+
+/*the queue directory, relative to where the tests run*/
+#define TEST_DIRECTORY "persistent_queue_ut_dir"
+#define TEST_MAX_SEGMENT_FILES 20
+#define SEGMENT_HEADER_SIZE 16
+#define RECORD_HEADER_SIZE 12
+#define MANIFEST_SLOT_SIZE 32
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+/*a message is a plain struct, its properties map is the message itself*/
+#define TEST_MAX_PROPERTIES 4
+typedef struct TEST_MESSAGE_TAG
+{
+    IOTHUBMESSAGE_CONTENT_TYPE contentType;
+    unsigned char content[64];
+    size_t size;
+    const char* messageId;
+    const char* correlationId;
+    char messageIdStorage[32];
+    char correlationIdStorage[32];
+    size_t propertyCount;
+    const char* keys[TEST_MAX_PROPERTIES];
+    const char* values[TEST_MAX_PROPERTIES];
+    char keyStorage[TEST_MAX_PROPERTIES][16];
+    char valueStorage[TEST_MAX_PROPERTIES][16];
+} TEST_MESSAGE;
+
+static IOTHUB_MESSAGE_HANDLE my_IoTHubMessage_CreateFromByteArray(const unsigned char* byteArray, size_t size)
+{
+    TEST_MESSAGE* result = (TEST_MESSAGE*)my_gballoc_malloc(sizeof(TEST_MESSAGE));
+    (void)memset(result, 0, sizeof(TEST_MESSAGE));
+    ASSERT_IS_TRUE(size <= sizeof(result->content));
+    result->contentType = IOTHUBMESSAGE_BYTEARRAY;
+    (void)memcpy(result->content, byteArray, size);
+    result->size = size;
+    return (IOTHUB_MESSAGE_HANDLE)result;
+}
+
+static IOTHUB_MESSAGE_HANDLE my_IoTHubMessage_CreateFromString(const char* source)
+{
+    TEST_MESSAGE* result = (TEST_MESSAGE*)my_IoTHubMessage_CreateFromByteArray((const unsigned char*)source, strlen(source) + 1);
+    result->contentType = IOTHUBMESSAGE_STRING;
+    return (IOTHUB_MESSAGE_HANDLE)result;
+}
+
+static void my_IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    my_gballoc_free(iotHubMessageHandle);
+}
+
+static IOTHUBMESSAGE_CONTENT_TYPE my_IoTHubMessage_GetContentType(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->contentType;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size)
+{
+    *buffer = ((TEST_MESSAGE*)iotHubMessageHandle)->content;
+    *size = ((TEST_MESSAGE*)iotHubMessageHandle)->size;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static const char* my_IoTHubMessage_GetString(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return (const char*)((TEST_MESSAGE*)iotHubMessageHandle)->content;
+}
+
+static MAP_HANDLE my_IoTHubMessage_Properties(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return (MAP_HANDLE)iotHubMessageHandle;
+}
+
+static const char* my_IoTHubMessage_GetMessageId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->messageId;
+}
+
+static const char* my_IoTHubMessage_GetCorrelationId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->correlationId;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_SetMessageId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const char* messageId)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)iotHubMessageHandle;
+    (void)strcpy(message->messageIdStorage, messageId);
+    message->messageId = message->messageIdStorage;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_SetCorrelationId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const char* correlationId)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)iotHubMessageHandle;
+    (void)strcpy(message->correlationIdStorage, correlationId);
+    message->correlationId = message->correlationIdStorage;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static MAP_RESULT my_Map_GetInternals(MAP_HANDLE handle, const char*const** keys, const char*const** values, size_t* count)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)handle;
+    *keys = message->keys;
+    *values = message->values;
+    *count = message->propertyCount;
+    return MAP_OK;
+}
+
+static MAP_RESULT my_Map_AddOrUpdate(MAP_HANDLE handle, const char* key, const char* value)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)handle;
+    ASSERT_IS_TRUE(message->propertyCount < TEST_MAX_PROPERTIES);
+    (void)strcpy(message->keyStorage[message->propertyCount], key);
+    (void)strcpy(message->valueStorage[message->propertyCount], value);
+    message->keys[message->propertyCount] = message->keyStorage[message->propertyCount];
+    message->values[message->propertyCount] = message->valueStorage[message->propertyCount];
+    message->propertyCount++;
+    return MAP_OK;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static void makeSegmentFileName(char* fileName, size_t index)
+{
+    (void)sprintf(fileName, "%s/seg%010lu.log", TEST_DIRECTORY, (unsigned long)index);
+}
+
+static int segmentFileExists(size_t index)
+{
+    char fileName[64];
+    FILE* file;
+    makeSegmentFileName(fileName, index);
+    file = fopen(fileName, "rb");
+    if (file != NULL)
+    {
+        (void)fclose(file);
+    }
+    return file != NULL;
+}
+
+/*leaves an empty queue directory behind*/
+static void cleanDirectory(void)
+{
+    size_t i;
+    char fileName[64];
+    for (i = 0; i < TEST_MAX_SEGMENT_FILES; i++)
+    {
+        makeSegmentFileName(fileName, i);
+        (void)remove(fileName);
+    }
+    (void)remove(TEST_DIRECTORY "/queue.manifest");
+}
+
+static size_t readFile(const char* fileName, unsigned char* buffer, size_t bufferSize)
+{
+    size_t result;
+    FILE* file = fopen(fileName, "rb");
+    ASSERT_IS_NOT_NULL(file);
+    result = fread(buffer, 1, bufferSize, file);
+    (void)fclose(file);
+    return result;
+}
+
+static void writeFile(const char* fileName, const unsigned char* buffer, size_t size)
+{
+    FILE* file = fopen(fileName, "wb");
+    ASSERT_IS_NOT_NULL(file);
+    ASSERT_ARE_EQUAL(size_t, size, fwrite(buffer, 1, size, file));
+    (void)fclose(file);
+}
+
+/*what a crash in the middle of a write leaves behind*/
+static void truncateSegment(size_t index, size_t bytesToRemove)
+{
+    unsigned char buffer[4096];
+    char fileName[64];
+    size_t size;
+    makeSegmentFileName(fileName, index);
+    size = readFile(fileName, buffer, sizeof(buffer));
+    ASSERT_IS_TRUE(size >= bytesToRemove);
+    writeFile(fileName, buffer, size - bytesToRemove);
+}
+
+static void corruptFile(const char* fileName, size_t offset)
+{
+    unsigned char buffer[4096];
+    size_t size = readFile(fileName, buffer, sizeof(buffer));
+    ASSERT_IS_TRUE(offset < size);
+    buffer[offset] ^= 0xFF;
+    writeFile(fileName, buffer, size);
+}
+
+static PERSISTENT_QUEUE_CONFIG makeConfig(size_t maxBytes, size_t maxMessages, size_t segmentSize, PERSISTENT_QUEUE_OVERFLOW_POLICY overflowPolicy)
+{
+    PERSISTENT_QUEUE_CONFIG result;
+    result.directory = TEST_DIRECTORY;
+    result.maxBytes = maxBytes;
+    result.maxMessages = maxMessages;
+    result.segmentSize = segmentSize;
+    result.overflowPolicy = overflowPolicy;
+    result.blockTimeoutInMilliseconds = 0;
+    result.maxMessagesInMemory = 0;
+    return result;
+}
+
+static PERSISTENT_QUEUE_HANDLE createQueue(size_t maxBytes, size_t maxMessages, size_t segmentSize, PERSISTENT_QUEUE_OVERFLOW_POLICY overflowPolicy)
+{
+    PERSISTENT_QUEUE_CONFIG config = makeConfig(maxBytes, maxMessages, segmentSize, overflowPolicy);
+    PERSISTENT_QUEUE_HANDLE result = persistent_queue_create(&config);
+    ASSERT_IS_NOT_NULL(result);
+    return result;
+}
+
+static uint64_t appendText(PERSISTENT_QUEUE_HANDLE queue, const char* text)
+{
+    uint64_t result = 0;
+    PERSISTENT_QUEUE_RESULT appendResult = persistent_queue_append(queue, (const unsigned char*)text, strlen(text), &result);
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_OK, (int)appendResult);
+    return result;
+}
+
+static void assertRecord(PERSISTENT_QUEUE_HANDLE queue, uint64_t fromSequenceNumber, uint64_t expectedSequenceNumber, const char* expectedText)
+{
+    unsigned char* record = NULL;
+    size_t size = 0;
+    uint64_t sequenceNumber = 0;
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_read(queue, fromSequenceNumber, &record, &size, &sequenceNumber);
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_OK, (int)result);
+    ASSERT_ARE_EQUAL(uint64_t, expectedSequenceNumber, sequenceNumber);
+    ASSERT_ARE_EQUAL(size_t, strlen(expectedText), size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expectedText, record, size));
+    free(record);
+}
+
+static void assertNoRecord(PERSISTENT_QUEUE_HANDLE queue, uint64_t fromSequenceNumber)
+{
+    unsigned char* record = NULL;
+    size_t size = 0;
+    uint64_t sequenceNumber = 0;
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_read(queue, fromSequenceNumber, &record, &size, &sequenceNumber);
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_EMPTY, (int)result);
+}
+
+static void assertRange(PERSISTENT_QUEUE_HANDLE queue, uint64_t expectedFirst, uint64_t expectedNext)
+{
+    uint64_t first = 0;
+    uint64_t next = 0;
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_get_range(queue, &first, &next));
+    ASSERT_ARE_EQUAL(uint64_t, expectedFirst, first);
+    ASSERT_ARE_EQUAL(uint64_t, expectedNext, next);
+}
+
+BEGIN_TEST_SUITE(iothub_client_persistent_queue_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_c_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUBMESSAGE_CONTENT_TYPE, int);
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_CreateFromByteArray, my_IoTHubMessage_CreateFromByteArray);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_CreateFromString, my_IoTHubMessage_CreateFromString);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_Destroy, my_IoTHubMessage_Destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetContentType, my_IoTHubMessage_GetContentType);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetByteArray, my_IoTHubMessage_GetByteArray);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetString, my_IoTHubMessage_GetString);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_Properties, my_IoTHubMessage_Properties);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetMessageId, my_IoTHubMessage_GetMessageId);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetCorrelationId, my_IoTHubMessage_GetCorrelationId);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetMessageId, my_IoTHubMessage_SetMessageId);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetCorrelationId, my_IoTHubMessage_SetCorrelationId);
+    REGISTER_GLOBAL_MOCK_HOOK(Map_GetInternals, my_Map_GetInternals);
+    REGISTER_GLOBAL_MOCK_HOOK(Map_AddOrUpdate, my_Map_AddOrUpdate);
+
+#ifdef _WIN32
+    (void)_mkdir(TEST_DIRECTORY);
+#else
+    (void)mkdir(TEST_DIRECTORY, 0777);
+#endif
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    cleanDirectory();
+    (void)remove(TEST_DIRECTORY);
+
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    cleanDirectory();
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_001: [ If config or config->directory is NULL, or config->overflowPolicy is not a PERSISTENT_QUEUE_OVERFLOW_POLICY value, persistent_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(persistent_queue_create_with_NULL_config_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE result;
+
+    ///act
+    result = persistent_queue_create(NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_001: [ If config or config->directory is NULL, or config->overflowPolicy is not a PERSISTENT_QUEUE_OVERFLOW_POLICY value, persistent_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(persistent_queue_create_with_NULL_directory_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE result;
+    PERSISTENT_QUEUE_CONFIG config = makeConfig(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    config.directory = NULL;
+
+    ///act
+    result = persistent_queue_create(&config);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_001: [ If config or config->directory is NULL, or config->overflowPolicy is not a PERSISTENT_QUEUE_OVERFLOW_POLICY value, persistent_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(persistent_queue_create_with_unknown_policy_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE result;
+    PERSISTENT_QUEUE_CONFIG config = makeConfig(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    config.overflowPolicy = (PERSISTENT_QUEUE_OVERFLOW_POLICY)42;
+
+    ///act
+    result = persistent_queue_create(&config);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_003: [ If any failure occurs, persistent_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(persistent_queue_create_fails_when_malloc_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE result;
+    PERSISTENT_QUEUE_CONFIG config = makeConfig(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    ///act
+    result = persistent_queue_create(&config);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_002: [ persistent_queue_create shall copy the configuration, a segmentSize of 0 meaning PERSISTENT_QUEUE_DEFAULT_SEGMENT_SIZE. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_005: [ persistent_queue_create shall recover the segments starting at the head named by the manifest, up to the first missing segment file. ]*/
+TEST_FUNCTION(persistent_queue_create_on_an_empty_directory_succeeds)
+{
+    ///arrange
+    PERSISTENT_QUEUE_CONFIG config = makeConfig(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    PERSISTENT_QUEUE_HANDLE result;
+    size_t messageCount = 1;
+    size_t byteCount = 1;
+
+    ///act
+    result = persistent_queue_create(&config);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    assertRange(result, 1, 1);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_get_usage(result, &messageCount, &byteCount));
+    ASSERT_ARE_EQUAL(size_t, 0, messageCount);
+    ASSERT_ARE_EQUAL(size_t, 0, byteCount);
+    ASSERT_IS_FALSE(segmentFileExists(0));
+
+    ///cleanup
+    persistent_queue_destroy(result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_008: [ If handle is NULL, persistent_queue_destroy shall do nothing. ]*/
+TEST_FUNCTION(persistent_queue_destroy_with_NULL_handle_does_nothing)
+{
+    ///arrange
+
+    ///act
+    persistent_queue_destroy(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_010: [ If handle or sequenceNumber is NULL, or record is NULL and size is not 0, or size does not fit in 32 bits, persistent_queue_append shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+TEST_FUNCTION(persistent_queue_append_with_NULL_handle_fails)
+{
+    ///arrange
+    uint64_t sequenceNumber;
+
+    ///act
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_append(NULL, (const unsigned char*)"a", 1, &sequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_ERROR, (int)result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_010: [ If handle or sequenceNumber is NULL, or record is NULL and size is not 0, or size does not fit in 32 bits, persistent_queue_append shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+TEST_FUNCTION(persistent_queue_append_with_NULL_record_and_non_zero_size_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    uint64_t sequenceNumber;
+
+    ///act
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_append(queue, NULL, 1, &sequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_ERROR, (int)result);
+    assertRange(queue, 1, 1);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_014: [ If there is no active segment, persistent_queue_append shall create a new segment file starting with the next sequence number. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_015: [ persistent_queue_append shall write the record header and the record at the end of the active segment and flush them. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_017: [ persistent_queue_append shall give the record the next sequence number, starting at 1, and return PERSISTENT_QUEUE_OK. ]*/
+TEST_FUNCTION(persistent_queue_append_writes_the_records_in_a_segment_file)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    unsigned char buffer[256];
+    size_t messageCount;
+    size_t byteCount;
+
+    ///act
+    uint64_t first = appendText(queue, "first");
+    uint64_t second = appendText(queue, "second");
+
+    ///assert
+    ASSERT_ARE_EQUAL(uint64_t, 1, first);
+    ASSERT_ARE_EQUAL(uint64_t, 2, second);
+    assertRange(queue, 1, 3);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_get_usage(queue, &messageCount, &byteCount));
+    ASSERT_ARE_EQUAL(size_t, 2, messageCount);
+    ASSERT_ARE_EQUAL(size_t, 2 * RECORD_HEADER_SIZE + 5 + 6, byteCount);
+    /*the records are flushed, they are in the file while the queue is still open*/
+    ASSERT_ARE_EQUAL(size_t, SEGMENT_HEADER_SIZE + 2 * RECORD_HEADER_SIZE + 5 + 6, readFile(TEST_DIRECTORY "/seg0000000000.log", buffer, sizeof(buffer)));
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_021: [ persistent_queue_read shall return a copy of the first record whose sequence number is at least fromSequenceNumber, its size and its sequence number. ]*/
+TEST_FUNCTION(persistent_queue_read_returns_the_records_in_order)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    (void)appendText(queue, "third");
+
+    ///act + assert
+    assertRecord(queue, 1, 1, "first");
+    assertRecord(queue, 2, 2, "second");
+    assertRecord(queue, 3, 3, "third");
+    /*going back rescans from the right segment*/
+    assertRecord(queue, 2, 2, "second");
+    /*skipping forward*/
+    assertRecord(queue, 0, 1, "first");
+    assertRecord(queue, 3, 3, "third");
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_018: [ Once the active segment holds segmentSize bytes it shall be sealed. ]*/
+TEST_FUNCTION(persistent_queue_read_follows_the_records_across_segments)
+{
+    ///arrange
+    /*every record seals its segment*/
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    (void)appendText(queue, "third");
+
+    ///act + assert
+    ASSERT_IS_TRUE(segmentFileExists(0));
+    ASSERT_IS_TRUE(segmentFileExists(1));
+    ASSERT_IS_TRUE(segmentFileExists(2));
+    assertRecord(queue, 1, 1, "first");
+    assertRecord(queue, 2, 2, "second");
+    assertRecord(queue, 3, 3, "third");
+    assertNoRecord(queue, 4);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_019: [ If handle, record, size or sequenceNumber is NULL, persistent_queue_read shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+TEST_FUNCTION(persistent_queue_read_with_NULL_record_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    size_t size;
+    uint64_t sequenceNumber;
+
+    ///act
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_read(queue, 1, NULL, &size, &sequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_ERROR, (int)result);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_020: [ If there is no record with a sequence number of at least fromSequenceNumber, persistent_queue_read shall return PERSISTENT_QUEUE_EMPTY. ]*/
+TEST_FUNCTION(persistent_queue_read_past_the_last_record_returns_EMPTY)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///act + assert
+    assertNoRecord(queue, 1);
+    (void)appendText(queue, "first");
+    assertNoRecord(queue, 2);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_022: [ If the record cannot be read or its crc does not match, persistent_queue_read shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+TEST_FUNCTION(persistent_queue_read_of_a_record_corrupted_on_disk_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    unsigned char* record = NULL;
+    size_t size;
+    uint64_t sequenceNumber;
+    PERSISTENT_QUEUE_RESULT result;
+    (void)appendText(queue, "first");
+    corruptFile(TEST_DIRECTORY "/seg0000000000.log", SEGMENT_HEADER_SIZE + RECORD_HEADER_SIZE);
+
+    ///act
+    result = persistent_queue_read(queue, 1, &record, &size, &sequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_ERROR, (int)result);
+    ASSERT_IS_NULL(record);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_023: [ The leading sealed segments whose records are all acknowledged shall be removed. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_026: [ persistent_queue_ack shall count the record as acknowledged in its segment and reclaim the fully acknowledged leading segments. ]*/
+TEST_FUNCTION(persistent_queue_ack_removes_the_fully_acknowledged_leading_segments)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    size_t messageCount;
+    size_t byteCount;
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    (void)appendText(queue, "third");
+
+    ///act
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 2));
+    /*segment 0 still holds a record that is not acknowledged, segment 1 cannot go before it*/
+    ASSERT_IS_TRUE(segmentFileExists(0));
+    ASSERT_IS_TRUE(segmentFileExists(1));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 1));
+
+    ///assert
+    ASSERT_IS_FALSE(segmentFileExists(0));
+    ASSERT_IS_FALSE(segmentFileExists(1));
+    ASSERT_IS_TRUE(segmentFileExists(2));
+    assertRange(queue, 3, 4);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_get_usage(queue, &messageCount, &byteCount));
+    ASSERT_ARE_EQUAL(size_t, 1, messageCount);
+    assertRecord(queue, 1, 3, "third");
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_023: [ The leading sealed segments whose records are all acknowledged shall be removed. ]*/
+TEST_FUNCTION(persistent_queue_ack_keeps_the_active_segment)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+
+    ///act
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 1));
+
+    ///assert
+    ASSERT_IS_TRUE(segmentFileExists(0));
+    (void)appendText(queue, "second");
+    assertRecord(queue, 2, 2, "second");
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_025: [ If handle is NULL or sequenceNumber was never given to a record, persistent_queue_ack shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_ack_of_an_unknown_sequence_number_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+
+    ///act + assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, persistent_queue_ack(NULL, 1));
+    ASSERT_ARE_NOT_EQUAL(int, 0, persistent_queue_ack(queue, 0));
+    ASSERT_ARE_NOT_EQUAL(int, 0, persistent_queue_ack(queue, 2));
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_011: [ If the record alone is bigger than maxBytes, persistent_queue_append shall return PERSISTENT_QUEUE_FULL. ]*/
+TEST_FUNCTION(persistent_queue_append_of_a_record_bigger_than_maxBytes_returns_FULL)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(RECORD_HEADER_SIZE + 4, 0, 0, PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST);
+    uint64_t sequenceNumber;
+
+    ///act
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_append(queue, (const unsigned char*)"12345", 5, &sequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_FULL, (int)result);
+    assertRange(queue, 1, 1);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_012: [ If the record does not fit under maxMessages and maxBytes and the policy is PERSISTENT_QUEUE_OVERFLOW_REJECT or PERSISTENT_QUEUE_OVERFLOW_BLOCK, persistent_queue_append shall return PERSISTENT_QUEUE_FULL. ]*/
+TEST_FUNCTION(persistent_queue_append_over_maxMessages_with_REJECT_returns_FULL)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 2, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    uint64_t sequenceNumber;
+    PERSISTENT_QUEUE_RESULT result;
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+
+    ///act
+    result = persistent_queue_append(queue, (const unsigned char*)"third", 5, &sequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_FULL, (int)result);
+    assertRange(queue, 1, 3);
+    assertRecord(queue, 1, 1, "first");
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_012: [ If the record does not fit under maxMessages and maxBytes and the policy is PERSISTENT_QUEUE_OVERFLOW_REJECT or PERSISTENT_QUEUE_OVERFLOW_BLOCK, persistent_queue_append shall return PERSISTENT_QUEUE_FULL. ]*/
+TEST_FUNCTION(persistent_queue_append_over_maxBytes_with_BLOCK_returns_FULL_until_room_is_made)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(2 * (RECORD_HEADER_SIZE + 5), 0, 1, PERSISTENT_QUEUE_OVERFLOW_BLOCK);
+    uint64_t sequenceNumber;
+    (void)appendText(queue, "11111");
+    (void)appendText(queue, "22222");
+
+    ///act + assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_FULL, (int)persistent_queue_append(queue, (const unsigned char*)"33333", 5, &sequenceNumber));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 1));
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_OK, (int)persistent_queue_append(queue, (const unsigned char*)"33333", 5, &sequenceNumber));
+    ASSERT_ARE_EQUAL(uint64_t, 3, sequenceNumber);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_013: [ If the policy is PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST, persistent_queue_append shall drop the oldest segments, acknowledged or not, until the record fits. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_027: [ Acknowledging a record that was dropped shall succeed and do nothing. ]*/
+TEST_FUNCTION(persistent_queue_append_over_maxMessages_with_DROP_OLDEST_drops_the_oldest_segment)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 2, 1, PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+
+    ///act
+    (void)appendText(queue, "third");
+
+    ///assert
+    ASSERT_IS_FALSE(segmentFileExists(0));
+    assertRange(queue, 2, 4);
+    assertRecord(queue, 1, 2, "second");
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 1));
+    assertRange(queue, 2, 4);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_009: [ persistent_queue_destroy shall close the files and free the queue, leaving the segment files on disk. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_004: [ All the recovered segments are sealed, the first append shall open a new segment. ]*/
+TEST_FUNCTION(persistent_queue_create_recovers_the_records_of_a_previous_run)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    persistent_queue_destroy(queue);
+
+    ///act
+    queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///assert
+    assertRange(queue, 1, 3);
+    assertRecord(queue, 1, 1, "first");
+    assertRecord(queue, 2, 2, "second");
+    ASSERT_ARE_EQUAL(uint64_t, 3, appendText(queue, "third"));
+    ASSERT_IS_TRUE(segmentFileExists(1));
+    assertRecord(queue, 3, 3, "third");
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_006: [ A torn or corrupted record shall end its segment, the records before it are kept. ]*/
+TEST_FUNCTION(persistent_queue_create_drops_a_record_torn_by_a_crash)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    (void)appendText(queue, "third");
+    persistent_queue_destroy(queue);
+    /*the crash happened while "third" was written*/
+    truncateSegment(0, 2);
+
+    ///act
+    queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///assert
+    assertRange(queue, 1, 3);
+    assertRecord(queue, 1, 1, "first");
+    assertRecord(queue, 2, 2, "second");
+    assertNoRecord(queue, 3);
+    /*the torn tail is never followed by new records, the sequence numbers carry on in a new segment*/
+    ASSERT_ARE_EQUAL(uint64_t, 3, appendText(queue, "new third"));
+    persistent_queue_destroy(queue);
+
+    queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    assertRange(queue, 1, 4);
+    assertRecord(queue, 2, 2, "second");
+    assertRecord(queue, 3, 3, "new third");
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_006: [ A torn or corrupted record shall end its segment, the records before it are kept. ]*/
+TEST_FUNCTION(persistent_queue_create_drops_a_torn_record_header)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "2");
+    persistent_queue_destroy(queue);
+    /*only part of the header of "2" made it to disk*/
+    truncateSegment(0, 1 + RECORD_HEADER_SIZE / 2);
+
+    ///act
+    queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///assert
+    assertRange(queue, 1, 2);
+    assertRecord(queue, 1, 1, "first");
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_006: [ A torn or corrupted record shall end its segment, the records before it are kept. ]*/
+TEST_FUNCTION(persistent_queue_create_stops_a_segment_at_a_corrupted_record)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    (void)appendText(queue, "third");
+    persistent_queue_destroy(queue);
+    /*one byte of "second" flipped*/
+    corruptFile(TEST_DIRECTORY "/seg0000000000.log", SEGMENT_HEADER_SIZE + RECORD_HEADER_SIZE + 5 + RECORD_HEADER_SIZE + 1);
+
+    ///act
+    queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///assert
+    assertRange(queue, 1, 2);
+    assertRecord(queue, 1, 1, "first");
+    assertNoRecord(queue, 2);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_005: [ persistent_queue_create shall recover the segments starting at the head named by the manifest, up to the first missing segment file. ]*/
+TEST_FUNCTION(persistent_queue_create_starts_at_the_head_named_by_the_manifest)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    (void)appendText(queue, "third");
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 1));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 2));
+    persistent_queue_destroy(queue);
+
+    ///act
+    queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///assert
+    assertRange(queue, 3, 4);
+    assertRecord(queue, 1, 3, "third");
+    ASSERT_ARE_EQUAL(uint64_t, 4, appendText(queue, "fourth"));
+    ASSERT_IS_TRUE(segmentFileExists(3));
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_005: [ persistent_queue_create shall recover the segments starting at the head named by the manifest, up to the first missing segment file. ]*/
+TEST_FUNCTION(persistent_queue_create_after_everything_was_acknowledged_keeps_the_sequence_numbers)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 1));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 2));
+    persistent_queue_destroy(queue);
+
+    ///act
+    queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///assert
+    assertRange(queue, 3, 3);
+    ASSERT_ARE_EQUAL(uint64_t, 3, appendText(queue, "third"));
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_024: [ Before a segment file is removed the manifest shall be updated to point after it. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_007: [ Segment files before the head named by the manifest are leftovers of an interrupted reclaim and shall be removed. ]*/
+TEST_FUNCTION(persistent_queue_create_removes_a_segment_left_by_an_interrupted_reclaim)
+{
+    ///arrange
+    unsigned char segment0[256];
+    size_t segment0Size;
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    segment0Size = readFile(TEST_DIRECTORY "/seg0000000000.log", segment0, sizeof(segment0));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 1));
+    persistent_queue_destroy(queue);
+    /*the crash happened after the manifest was written, before the segment file was removed*/
+    writeFile(TEST_DIRECTORY "/seg0000000000.log", segment0, segment0Size);
+
+    ///act
+    queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///assert
+    ASSERT_IS_FALSE(segmentFileExists(0));
+    assertRange(queue, 2, 3);
+    assertRecord(queue, 1, 2, "second");
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_024: [ Before a segment file is removed the manifest shall be updated to point after it. ]*/
+TEST_FUNCTION(persistent_queue_create_with_a_torn_manifest_uses_the_previous_slot)
+{
+    ///arrange
+    unsigned char segment0[256];
+    size_t segment0Size;
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    (void)appendText(queue, "first");
+    (void)appendText(queue, "second");
+    segment0Size = readFile(TEST_DIRECTORY "/seg0000000000.log", segment0, sizeof(segment0));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, 1));
+    persistent_queue_destroy(queue);
+    /*the crash tore the first manifest write, so the segment file was never removed*/
+    corruptFile(TEST_DIRECTORY "/queue.manifest", MANIFEST_SLOT_SIZE + 20);
+    writeFile(TEST_DIRECTORY "/seg0000000000.log", segment0, segment0Size);
+
+    ///act
+    queue = createQueue(0, 0, 1, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///assert
+    /*the acknowledgment is lost, "first" is delivered again*/
+    assertRange(queue, 1, 3);
+    assertRecord(queue, 1, 1, "first");
+    assertRecord(queue, 2, 2, "second");
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_028: [ If handle, firstSequenceNumber or nextSequenceNumber is NULL, persistent_queue_get_range shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_get_range_with_NULL_handle_fails)
+{
+    ///arrange
+    uint64_t first;
+    uint64_t next;
+
+    ///act
+    int result = persistent_queue_get_range(NULL, &first, &next);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_030: [ If handle, messageCount or byteCount is NULL, persistent_queue_get_usage shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_get_usage_with_NULL_handle_fails)
+{
+    ///arrange
+    size_t messageCount;
+    size_t byteCount;
+
+    ///act
+    int result = persistent_queue_get_usage(NULL, &messageCount, &byteCount);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_032: [ If handle, message or sequenceNumber is NULL, persistent_queue_append_message shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+TEST_FUNCTION(persistent_queue_append_message_with_NULL_message_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    uint64_t sequenceNumber;
+
+    ///act
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_append_message(queue, NULL, &sequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_ERROR, (int)result);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_033: [ persistent_queue_append_message shall serialize the content, the content type, the message id, the correlation id and the properties of the message and append them as one record. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_036: [ persistent_queue_read_message shall read the record like persistent_queue_read and rebuild the message from it. ]*/
+TEST_FUNCTION(persistent_queue_read_message_rebuilds_a_bytearray_message_with_its_properties)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    const unsigned char content[] = { 0x00, 0x01, 0xFF };
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromByteArray(content, sizeof(content));
+    IOTHUB_MESSAGE_HANDLE readBack = NULL;
+    TEST_MESSAGE* readBackMessage;
+    uint64_t sequenceNumber;
+    uint64_t readSequenceNumber = 0;
+    (void)my_IoTHubMessage_SetMessageId(message, "id1");
+    (void)my_Map_AddOrUpdate((MAP_HANDLE)message, "k1", "v1");
+    (void)my_Map_AddOrUpdate((MAP_HANDLE)message, "k2", "");
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_OK, (int)persistent_queue_append_message(queue, message, &sequenceNumber));
+
+    ///act
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_read_message(queue, sequenceNumber, &readBack, &readSequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_OK, (int)result);
+    ASSERT_ARE_EQUAL(uint64_t, sequenceNumber, readSequenceNumber);
+    readBackMessage = (TEST_MESSAGE*)readBack;
+    ASSERT_ARE_EQUAL(int, (int)IOTHUBMESSAGE_BYTEARRAY, (int)readBackMessage->contentType);
+    ASSERT_ARE_EQUAL(size_t, sizeof(content), readBackMessage->size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(content, readBackMessage->content, sizeof(content)));
+    ASSERT_ARE_EQUAL(char_ptr, "id1", readBackMessage->messageId);
+    ASSERT_IS_NULL(readBackMessage->correlationId);
+    ASSERT_ARE_EQUAL(size_t, 2, readBackMessage->propertyCount);
+    ASSERT_ARE_EQUAL(char_ptr, "k1", readBackMessage->keys[0]);
+    ASSERT_ARE_EQUAL(char_ptr, "v1", readBackMessage->values[0]);
+    ASSERT_ARE_EQUAL(char_ptr, "k2", readBackMessage->keys[1]);
+    ASSERT_ARE_EQUAL(char_ptr, "", readBackMessage->values[1]);
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(readBack);
+    my_IoTHubMessage_Destroy(message);
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_036: [ persistent_queue_read_message shall read the record like persistent_queue_read and rebuild the message from it. ]*/
+TEST_FUNCTION(persistent_queue_read_message_rebuilds_a_string_message_after_a_restart)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromString("{\"temperature\":21}");
+    IOTHUB_MESSAGE_HANDLE readBack = NULL;
+    uint64_t sequenceNumber;
+    uint64_t readSequenceNumber = 0;
+    (void)my_IoTHubMessage_SetCorrelationId(message, "corr");
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_OK, (int)persistent_queue_append_message(queue, message, &sequenceNumber));
+    persistent_queue_destroy(queue);
+    queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+
+    ///act
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_read_message(queue, 1, &readBack, &readSequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_OK, (int)result);
+    ASSERT_ARE_EQUAL(uint64_t, 1, readSequenceNumber);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUBMESSAGE_STRING, (int)((TEST_MESSAGE*)readBack)->contentType);
+    ASSERT_ARE_EQUAL(char_ptr, "{\"temperature\":21}", (const char*)((TEST_MESSAGE*)readBack)->content);
+    ASSERT_ARE_EQUAL(char_ptr, "corr", ((TEST_MESSAGE*)readBack)->correlationId);
+    ASSERT_IS_NULL(((TEST_MESSAGE*)readBack)->messageId);
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(readBack);
+    my_IoTHubMessage_Destroy(message);
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_037: [ If the message cannot be rebuilt, persistent_queue_read_message shall fail and return PERSISTENT_QUEUE_ERROR. The sequence number of the record is still returned. ]*/
+TEST_FUNCTION(persistent_queue_read_message_of_a_raw_record_fails_and_returns_its_sequence_number)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    IOTHUB_MESSAGE_HANDLE readBack = NULL;
+    uint64_t readSequenceNumber = 0;
+    (void)appendText(queue, "not a message");
+
+    ///act
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_read_message(queue, 1, &readBack, &readSequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_ERROR, (int)result);
+    ASSERT_ARE_EQUAL(uint64_t, 1, readSequenceNumber);
+
+    ///cleanup
+    persistent_queue_destroy(queue);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_PERSISTENT_QUEUE_02_034: [ If serializing the message fails, persistent_queue_append_message shall fail and return PERSISTENT_QUEUE_ERROR. ]*/
+TEST_FUNCTION(persistent_queue_append_message_of_an_unknown_content_type_fails)
+{
+    ///arrange
+    PERSISTENT_QUEUE_HANDLE queue = createQueue(0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_REJECT);
+    IOTHUB_MESSAGE_HANDLE message = my_IoTHubMessage_CreateFromByteArray((const unsigned char*)"a", 1);
+    uint64_t sequenceNumber;
+    ((TEST_MESSAGE*)message)->contentType = IOTHUBMESSAGE_UNKNOWN;
+
+    ///act
+    PERSISTENT_QUEUE_RESULT result = persistent_queue_append_message(queue, message, &sequenceNumber);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)PERSISTENT_QUEUE_ERROR, (int)result);
+    assertRange(queue, 1, 1);
+
+    ///cleanup
+    my_IoTHubMessage_Destroy(message);
+    persistent_queue_destroy(queue);
+}
+
+END_TEST_SUITE(iothub_client_persistent_queue_ut)
@@ -0,0 +1,448 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/agenttime.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_retry_control.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umock_c_negative_tests.h"
+
+#define TEST_DEVICE_ID "thisIsDeviceID"
+#define TEST_TIME_T ((time_t)1234)
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+/*the tick counter of the retry control reads this*/
+static tickcounter_ms_t g_current_ms;
+
+static TICK_COUNTER_HANDLE my_tickcounter_create(void)
+{
+    return (TICK_COUNTER_HANDLE)my_gballoc_malloc(1);
+}
+
+static void my_tickcounter_destroy(TICK_COUNTER_HANDLE tick_counter)
+{
+    my_gballoc_free(tick_counter);
+}
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_current_ms;
+    return 0;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static RETRY_ACTION shouldRetryAt(RETRY_CONTROL_HANDLE handle, tickcounter_ms_t now)
+{
+    RETRY_ACTION result;
+    g_current_ms = now;
+    ASSERT_ARE_EQUAL(int, 0, retry_control_should_retry(handle, &result));
+    return result;
+}
+
+BEGIN_TEST_SUITE(iothub_client_retry_control_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_create, my_tickcounter_create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_destroy, my_tickcounter_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, __LINE__);
+
+    REGISTER_GLOBAL_MOCK_RETURN(get_time, TEST_TIME_T);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+    g_current_ms = 0;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_001: [ retry_control_create shall allocate memory for the retry control and create a tick counter. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_003: [ retry_control_create shall seed the jitter from the device id, the instance address, the current time and the tick counter. ]*/
+TEST_FUNCTION(retry_control_create_succeeds)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    ///act
+    result = retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, TEST_DEVICE_ID);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    retry_control_destroy(result);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_002: [ If any failure occurs, retry_control_create shall fail and return NULL. ]*/
+TEST_FUNCTION(retry_control_create_unhappy_paths)
+{
+    ///arrange
+    size_t i;
+
+    umock_c_negative_tests_init();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        RETRY_CONTROL_HANDLE result;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        ///act
+        result = retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, TEST_DEVICE_ID);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+    }
+
+    ///cleanup
+    umock_c_negative_tests_deinit();
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_004: [ If retryControlHandle is NULL, retry_control_destroy shall do nothing. ]*/
+TEST_FUNCTION(retry_control_destroy_with_NULL_handle_does_nothing)
+{
+    ///arrange
+
+    ///act
+    retry_control_destroy(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_005: [ retry_control_destroy shall destroy the tick counter and free the retry control. ]*/
+TEST_FUNCTION(retry_control_destroy_frees_everything)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_INTERVAL, 0, TEST_DEVICE_ID);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(handle));
+
+    ///act
+    retry_control_destroy(handle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_006: [ If retryControlHandle is NULL, retry_control_set_policy shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(retry_control_set_policy_with_NULL_handle_fails)
+{
+    ///arrange
+
+    ///act
+    int result = retry_control_set_policy(NULL, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_007: [ retry_control_set_policy shall store the policy and the timeout limit, reset the retry state and return 0. ]*/
+TEST_FUNCTION(retry_control_set_policy_succeeds_and_resets_the_retry_state)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_NONE, 0, TEST_DEVICE_ID);
+    int result;
+    (void)shouldRetryAt(handle, 0);
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_STOP_RETRYING, (int)shouldRetryAt(handle, 1));
+    umock_c_reset_all_calls();
+
+    ///act
+    result = retry_control_set_policy(handle, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 2));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_LATER, (int)shouldRetryAt(handle, 3));
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_008: [ If retryControlHandle or retryAction is NULL, retry_control_should_retry shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(retry_control_should_retry_with_NULL_arguments_fails)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_INTERVAL, 0, TEST_DEVICE_ID);
+    RETRY_ACTION retryAction;
+    int result1;
+    int result2;
+    umock_c_reset_all_calls();
+
+    ///act
+    result1 = retry_control_should_retry(NULL, &retryAction);
+    result2 = retry_control_should_retry(handle, NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_009: [ If tickcounter_get_current_ms fails, retry_control_should_retry shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(retry_control_should_retry_fails_when_tickcounter_get_current_ms_fails)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_INTERVAL, 0, TEST_DEVICE_ID);
+    RETRY_ACTION retryAction;
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    ///act
+    result = retry_control_should_retry(handle, &retryAction);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_010: [ The first call after retry_control_create or retry_control_reset shall set retryAction to RETRY_ACTION_RETRY_NOW. ]*/
+TEST_FUNCTION(retry_control_should_retry_first_call_is_RETRY_NOW)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_NONE, 0, TEST_DEVICE_ID);
+    RETRY_ACTION retryAction;
+    umock_c_reset_all_calls();
+
+    ///act
+    retryAction = shouldRetryAt(handle, 1000);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)retryAction);
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_011: [ If the policy is IOTHUB_CLIENT_RETRY_NONE, every following call shall set retryAction to RETRY_ACTION_STOP_RETRYING. ]*/
+TEST_FUNCTION(retry_control_should_retry_with_RETRY_NONE_stops_after_the_first_attempt)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_NONE, 0, TEST_DEVICE_ID);
+    (void)shouldRetryAt(handle, 0);
+    umock_c_reset_all_calls();
+
+    ///act
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_STOP_RETRYING, (int)shouldRetryAt(handle, 100000));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_STOP_RETRYING, (int)shouldRetryAt(handle, 200000));
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_012: [ If retryTimeoutLimitInSeconds is not 0 and at least that many seconds have passed since the first attempt, retryAction shall be set to RETRY_ACTION_STOP_RETRYING. ]*/
+TEST_FUNCTION(retry_control_should_retry_stops_when_the_timeout_limit_is_reached)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_IMMEDIATE, 10, TEST_DEVICE_ID);
+    (void)shouldRetryAt(handle, 0);
+    umock_c_reset_all_calls();
+
+    ///act
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 9999));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_STOP_RETRYING, (int)shouldRetryAt(handle, 10000));
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_012: [ If retryTimeoutLimitInSeconds is not 0 and at least that many seconds have passed since the first attempt, retryAction shall be set to RETRY_ACTION_STOP_RETRYING. ]*/
+TEST_FUNCTION(retry_control_should_retry_with_timeout_limit_0_never_stops)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_IMMEDIATE, 0, TEST_DEVICE_ID);
+    (void)shouldRetryAt(handle, 0);
+    umock_c_reset_all_calls();
+
+    ///act
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 24 * 3600 * 1000));
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_013: [ If the wait computed by the policy has passed since the last attempt, retryAction shall be set to RETRY_ACTION_RETRY_NOW and the wait before the next attempt shall be computed. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_014: [ Otherwise retryAction shall be set to RETRY_ACTION_RETRY_LATER. ]*/
+TEST_FUNCTION(retry_control_should_retry_with_RETRY_INTERVAL_waits_5_seconds)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_INTERVAL, 0, TEST_DEVICE_ID);
+    (void)shouldRetryAt(handle, 0);
+    umock_c_reset_all_calls();
+
+    ///act
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_LATER, (int)shouldRetryAt(handle, 4999));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 5000));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_LATER, (int)shouldRetryAt(handle, 9999));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 10000));
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_013: [ If the wait computed by the policy has passed since the last attempt, retryAction shall be set to RETRY_ACTION_RETRY_NOW and the wait before the next attempt shall be computed. ]*/
+TEST_FUNCTION(retry_control_should_retry_with_EXPONENTIAL_BACKOFF_doubles_the_wait)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF, 0, TEST_DEVICE_ID);
+    (void)shouldRetryAt(handle, 0);
+    umock_c_reset_all_calls();
+
+    ///act
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_LATER, (int)shouldRetryAt(handle, 999));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 1000));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_LATER, (int)shouldRetryAt(handle, 2999));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 3000));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_LATER, (int)shouldRetryAt(handle, 6999));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 7000));
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_013: [ If the wait computed by the policy has passed since the last attempt, retryAction shall be set to RETRY_ACTION_RETRY_NOW and the wait before the next attempt shall be computed. ]*/
+TEST_FUNCTION(retry_control_should_retry_with_EXPONENTIAL_BACKOFF_WITH_JITTER_waits_between_half_and_all_of_the_backoff)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, TEST_DEVICE_ID);
+    (void)shouldRetryAt(handle, 0);
+    umock_c_reset_all_calls();
+
+    ///act
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_LATER, (int)shouldRetryAt(handle, 499));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 1000));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_LATER, (int)shouldRetryAt(handle, 1999));
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 3000));
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_02_015: [ retry_control_reset shall clear the attempt count so that the next retry_control_should_retry answers RETRY_ACTION_RETRY_NOW. ]*/
+TEST_FUNCTION(retry_control_reset_allows_an_immediate_attempt)
+{
+    ///arrange
+    RETRY_CONTROL_HANDLE handle = retry_control_create(IOTHUB_CLIENT_RETRY_INTERVAL, 0, TEST_DEVICE_ID);
+    (void)shouldRetryAt(handle, 0);
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_LATER, (int)shouldRetryAt(handle, 1));
+    umock_c_reset_all_calls();
+
+    ///act
+    retry_control_reset(handle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)RETRY_ACTION_RETRY_NOW, (int)shouldRetryAt(handle, 2));
+
+    ///cleanup
+    retry_control_destroy(handle);
+}
+
+END_TEST_SUITE(iothub_client_retry_control_ut)
@@ -0,0 +1,860 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/urlencode.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_sastoken_cache.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_c.h"
+#include "umock_c_negative_tests.h"
+
+#define TEST_TIME_T ((time_t)1234)
+#define TEST_SCOPE "myhub.azure-devices.net/devices/dev1"
+#define TEST_KEY_NAME "owner"
+#define TEST_BASE64_SIGNATURE "theBase64Signature="
+#define TEST_URL_ENCODED_SIGNATURE "theBase64Signature%3D"
+#define TEST_LOCK_HANDLE ((LOCK_HANDLE)0x4250)
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+/*the strings are plain malloc'ed char* so that the tokens can be compared*/
+static STRING_HANDLE my_STRING_construct(const char* psz)
+{
+    char* result = (char*)my_gballoc_malloc(strlen(psz) + 1);
+    (void)strcpy(result, psz);
+    return (STRING_HANDLE)result;
+}
+
+static STRING_HANDLE my_STRING_clone(STRING_HANDLE handle)
+{
+    return my_STRING_construct((const char*)handle);
+}
+
+static const char* my_STRING_c_str(STRING_HANDLE handle)
+{
+    return (const char*)handle;
+}
+
+static size_t my_STRING_length(STRING_HANDLE handle)
+{
+    return strlen((const char*)handle);
+}
+
+static void my_STRING_delete(STRING_HANDLE handle)
+{
+    my_gballoc_free(handle);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    STRING_HANDLE STRING_construct_sprintf(const char* format, ...);
+
+    STRING_HANDLE STRING_construct_sprintf(const char* format, ...)
+    {
+        char* result;
+        int length;
+        va_list args;
+
+        va_start(args, format);
+        length = vsnprintf(NULL, 0, format, args);
+        va_end(args);
+
+        result = (char*)my_gballoc_malloc(length + 1);
+        va_start(args, format);
+        (void)vsnprintf(result, length + 1, format, args);
+        va_end(args);
+        return (STRING_HANDLE)result;
+    }
+#ifdef __cplusplus
+}
+#endif
+
+/*the decoded key handed to the cache, the "buffer" is a copy of it*/
+static unsigned char g_key[100];
+static size_t g_keyLength;
+
+static BUFFER_HANDLE my_Base64_Decoder(const char* source)
+{
+    unsigned char* result = (unsigned char*)my_gballoc_malloc(g_keyLength + 1);
+    (void)source;
+    (void)memcpy(result, g_key, g_keyLength);
+    return (BUFFER_HANDLE)result;
+}
+
+static unsigned char* my_BUFFER_u_char(BUFFER_HANDLE handle)
+{
+    return (unsigned char*)handle;
+}
+
+static size_t my_BUFFER_length(BUFFER_HANDLE handle)
+{
+    (void)handle;
+    return g_keyLength;
+}
+
+static void my_BUFFER_delete(BUFFER_HANDLE handle)
+{
+    my_gballoc_free(handle);
+}
+
+/*the last HMAC-SHA256 computed by the cache*/
+static unsigned char g_signature[32];
+
+static STRING_HANDLE my_Base64_Encode_Bytes(const unsigned char* source, size_t size)
+{
+    ASSERT_ARE_EQUAL(size_t, sizeof(g_signature), size);
+    (void)memcpy(g_signature, source, sizeof(g_signature));
+    return my_STRING_construct(TEST_BASE64_SIGNATURE);
+}
+
+static STRING_HANDLE my_URL_Encode(STRING_HANDLE input)
+{
+    (void)input;
+    return my_STRING_construct(TEST_URL_ENCODED_SIGNATURE);
+}
+
+/*seconds since the epoch as seen by the cache*/
+static double g_now;
+
+static double my_get_difftime(time_t stopTime, time_t startTime)
+{
+    (void)stopTime;
+    (void)startTime;
+    return g_now;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static void setKey(const unsigned char* key, size_t keyLength)
+{
+    (void)memcpy(g_key, key, keyLength);
+    g_keyLength = keyLength;
+}
+
+/*HMAC-SHA256 of TEST_SCOPE "\n3700" with the 32 bytes key "0123456789abcdef0123456789abcdef"*/
+static const unsigned char SHORT_KEY_SIGNATURE[32] =
+{
+    0x71, 0x89, 0x38, 0xbf, 0xa7, 0x5d, 0xb4, 0xb6, 0x3b, 0x15, 0xed, 0x87, 0xe5, 0xd1, 0x97, 0x7b,
+    0x03, 0x84, 0x2e, 0x56, 0x5b, 0x00, 0x31, 0x00, 0x85, 0x1e, 0x5b, 0xbd, 0x0c, 0xeb, 0xb6, 0x19
+};
+
+/*HMAC-SHA256 of TEST_SCOPE "\n3700" with the 100 bytes key 0x00, 0x01, ... 0x63*/
+static const unsigned char LONG_KEY_SIGNATURE[32] =
+{
+    0xbd, 0x34, 0x17, 0x9b, 0x5b, 0xad, 0x7a, 0xb3, 0x01, 0xf6, 0x4d, 0x31, 0xa9, 0xf4, 0xf5, 0x32,
+    0xd4, 0xe8, 0xd6, 0x6b, 0x5e, 0x63, 0x04, 0x3b, 0x15, 0x32, 0xd6, 0x50, 0x15, 0x99, 0x49, 0xfd
+};
+
+static void setShortKey(void)
+{
+    setKey((const unsigned char*)"0123456789abcdef0123456789abcdef", 32);
+}
+
+static SASTOKEN_CACHE_HANDLE createCache(STRING_HANDLE keyName)
+{
+    SASTOKEN_CACHE_HANDLE result;
+    STRING_HANDLE key = my_STRING_construct("a2V5");
+    STRING_HANDLE scope = my_STRING_construct(TEST_SCOPE);
+
+    result = sastoken_cache_create(key, scope, keyName);
+    ASSERT_IS_NOT_NULL(result);
+
+    my_STRING_delete(scope);
+    my_STRING_delete(key);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+BEGIN_TEST_SUITE(iothub_client_sastoken_cache_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_c_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(STRING_clone, my_STRING_clone);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(STRING_clone, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(STRING_c_str, my_STRING_c_str);
+    REGISTER_GLOBAL_MOCK_HOOK(STRING_length, my_STRING_length);
+    REGISTER_GLOBAL_MOCK_HOOK(STRING_delete, my_STRING_delete);
+
+    REGISTER_GLOBAL_MOCK_HOOK(Base64_Decoder, my_Base64_Decoder);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Base64_Decoder, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_u_char, my_BUFFER_u_char);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, my_BUFFER_length);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_delete, my_BUFFER_delete);
+
+    REGISTER_GLOBAL_MOCK_HOOK(Base64_Encode_Bytes, my_Base64_Encode_Bytes);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Base64_Encode_Bytes, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(URL_Encode, my_URL_Encode);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(URL_Encode, NULL);
+
+    REGISTER_GLOBAL_MOCK_RETURN(get_time, TEST_TIME_T);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(get_time, (time_t)-1);
+    REGISTER_GLOBAL_MOCK_HOOK(get_difftime, my_get_difftime);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+    setShortKey();
+    (void)memset(g_signature, 0, sizeof(g_signature));
+    g_now = 100;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_001: [ If key or scope is NULL, sastoken_cache_create shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_create_with_NULL_key_fails)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE result;
+    STRING_HANDLE scope = my_STRING_construct(TEST_SCOPE);
+
+    ///act
+    result = sastoken_cache_create(NULL, scope, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    my_STRING_delete(scope);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_001: [ If key or scope is NULL, sastoken_cache_create shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_create_with_NULL_scope_fails)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE result;
+    STRING_HANDLE key = my_STRING_construct("a2V5");
+
+    ///act
+    result = sastoken_cache_create(key, NULL, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    my_STRING_delete(key);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_002: [ sastoken_cache_create shall decode the key once and absorb the HMAC-SHA256 inner and outer pads into two SHA256 contexts. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_004: [ The tokens shall live SASTOKEN_CACHE_DEFAULT_LIFETIME_IN_SECONDS and be reused during SASTOKEN_CACHE_DEFAULT_REUSE_PERCENT of their lifetime. ]*/
+TEST_FUNCTION(sastoken_cache_create_succeeds)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE result;
+    STRING_HANDLE key = my_STRING_construct("a2V5");
+    STRING_HANDLE scope = my_STRING_construct(TEST_SCOPE);
+    STRING_HANDLE keyName = my_STRING_construct(TEST_KEY_NAME);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_clone(scope));
+    STRICT_EXPECTED_CALL(STRING_clone(keyName));
+    STRICT_EXPECTED_CALL(STRING_c_str(key));
+    STRICT_EXPECTED_CALL(Base64_Decoder("a2V5"));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    ///act
+    result = sastoken_cache_create(key, scope, keyName);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    sastoken_cache_destroy(result);
+    my_STRING_delete(keyName);
+    my_STRING_delete(scope);
+    my_STRING_delete(key);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_003: [ If any failure occurs, sastoken_cache_create shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_create_unhappy_paths)
+{
+    ///arrange
+    size_t i;
+    STRING_HANDLE key = my_STRING_construct("a2V5");
+    STRING_HANDLE scope = my_STRING_construct(TEST_SCOPE);
+    STRING_HANDLE keyName = my_STRING_construct(TEST_KEY_NAME);
+    size_t calls_that_cannot_fail[] =
+    {
+        3, /*STRING_c_str*/
+        5, /*BUFFER_u_char*/
+        6, /*BUFFER_length*/
+        7, /*BUFFER_u_char*/
+        8, /*BUFFER_delete*/
+    };
+
+    umock_c_negative_tests_init();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_clone(scope));
+    STRICT_EXPECTED_CALL(STRING_clone(keyName));
+    STRICT_EXPECTED_CALL(STRING_c_str(key));
+    STRICT_EXPECTED_CALL(Base64_Decoder("a2V5"));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        size_t j;
+        SASTOKEN_CACHE_HANDLE result;
+
+        for (j = 0; j < sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]); j++)
+        {
+            if (calls_that_cannot_fail[j] == i)
+            {
+                break;
+            }
+        }
+        if (j != sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]))
+        {
+            continue;
+        }
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        ///act
+        result = sastoken_cache_create(key, scope, keyName);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+    }
+
+    ///cleanup
+    umock_c_negative_tests_deinit();
+    my_STRING_delete(keyName);
+    my_STRING_delete(scope);
+    my_STRING_delete(key);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_005: [ If sasTokenCacheHandle is NULL, sastoken_cache_destroy shall do nothing. ]*/
+TEST_FUNCTION(sastoken_cache_destroy_with_NULL_handle_does_nothing)
+{
+    ///arrange
+
+    ///act
+    sastoken_cache_destroy(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_006: [ sastoken_cache_destroy shall free the cached token, the scope, the key name and the instance, and wipe the precomputed pads. ]*/
+TEST_FUNCTION(sastoken_cache_destroy_frees_everything)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    (void)sastoken_cache_get_token(handle, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*token*/
+    STRICT_EXPECTED_CALL(STRING_delete(NULL)); /*keyName*/
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*scope*/
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(handle));
+
+    ///act
+    sastoken_cache_destroy(handle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_007: [ If sasTokenCacheHandle is NULL, lifetimeInSeconds is 0 or reusePercent is greater than 100, sastoken_cache_set_lifetime shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sastoken_cache_set_lifetime_with_invalid_arguments_fails)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    int result1;
+    int result2;
+    int result3;
+
+    ///act
+    result1 = sastoken_cache_set_lifetime(NULL, 3600, 50);
+    result2 = sastoken_cache_set_lifetime(handle, 0, 50);
+    result3 = sastoken_cache_set_lifetime(handle, 3600, 101);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_008: [ sastoken_cache_set_lifetime shall store lifetimeInSeconds and reusePercent, drop the cached token and return 0. ]*/
+TEST_FUNCTION(sastoken_cache_set_lifetime_succeeds_and_drops_the_token)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    const char* token;
+    int result;
+    (void)sastoken_cache_get_token(handle, NULL);
+    umock_c_reset_all_calls();
+
+    ///act
+    result = sastoken_cache_set_lifetime(handle, 60, 10);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    token = sastoken_cache_get_token(handle, NULL);
+    ASSERT_ARE_EQUAL(char_ptr, "SharedAccessSignature sr=" TEST_SCOPE "&sig=" TEST_URL_ENCODED_SIGNATURE "&se=160", token);
+
+    /*6 seconds is 10% of 60 seconds*/
+    g_now = 105;
+    ASSERT_ARE_EQUAL(char_ptr, "SharedAccessSignature sr=" TEST_SCOPE "&sig=" TEST_URL_ENCODED_SIGNATURE "&se=160", sastoken_cache_get_token(handle, NULL));
+    g_now = 106;
+    ASSERT_ARE_EQUAL(char_ptr, "SharedAccessSignature sr=" TEST_SCOPE "&sig=" TEST_URL_ENCODED_SIGNATURE "&se=166", sastoken_cache_get_token(handle, NULL));
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_009: [ If sasTokenCacheHandle is NULL, sastoken_cache_get_token shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_get_token_with_NULL_handle_fails)
+{
+    ///arrange
+    size_t creationTime;
+
+    ///act
+    const char* result = sastoken_cache_get_token(NULL, &creationTime);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_010: [ If getting the current time fails, sastoken_cache_get_token shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_get_token_fails_when_get_time_fails)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    const char* result;
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL))
+        .SetReturn((time_t)-1);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    result = sastoken_cache_get_token(handle, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_012: [ The signature shall be computed by continuing copies of the precomputed inner and outer SHA256 contexts. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_013: [ The token shall have the format "SharedAccessSignature sr=<scope>&sig=<signature>&se=<expiry>", followed by "&skn=<keyName>" when keyName is not empty. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_014: [ Otherwise sastoken_cache_get_token shall sign a new token expiring lifetimeInSeconds from now, cache it and return it. ]*/
+TEST_FUNCTION(sastoken_cache_get_token_signs_with_HMAC_SHA256)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    size_t creationTime = 0;
+    const char* result;
+
+    ///act
+    result = sastoken_cache_get_token(handle, &creationTime);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, "SharedAccessSignature sr=" TEST_SCOPE "&sig=" TEST_URL_ENCODED_SIGNATURE "&se=3700", result);
+    ASSERT_ARE_EQUAL(size_t, 100, creationTime);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(SHORT_KEY_SIGNATURE, g_signature, sizeof(g_signature)));
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_002: [ sastoken_cache_create shall decode the key once and absorb the HMAC-SHA256 inner and outer pads into two SHA256 contexts. ]*/
+TEST_FUNCTION(sastoken_cache_get_token_hashes_keys_longer_than_a_block)
+{
+    ///arrange
+    unsigned char longKey[100];
+    SASTOKEN_CACHE_HANDLE handle;
+    size_t i;
+
+    for (i = 0; i < sizeof(longKey); i++)
+    {
+        longKey[i] = (unsigned char)i;
+    }
+    setKey(longKey, sizeof(longKey));
+    handle = createCache(NULL);
+
+    ///act
+    (void)sastoken_cache_get_token(handle, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, memcmp(LONG_KEY_SIGNATURE, g_signature, sizeof(g_signature)));
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_013: [ The token shall have the format "SharedAccessSignature sr=<scope>&sig=<signature>&se=<expiry>", followed by "&skn=<keyName>" when keyName is not empty. ]*/
+TEST_FUNCTION(sastoken_cache_get_token_appends_the_key_name)
+{
+    ///arrange
+    STRING_HANDLE keyName = my_STRING_construct(TEST_KEY_NAME);
+    SASTOKEN_CACHE_HANDLE handle = createCache(keyName);
+    const char* result;
+
+    ///act
+    result = sastoken_cache_get_token(handle, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, "SharedAccessSignature sr=" TEST_SCOPE "&sig=" TEST_URL_ENCODED_SIGNATURE "&se=3700&skn=" TEST_KEY_NAME, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(SHORT_KEY_SIGNATURE, g_signature, sizeof(g_signature)));
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+    my_STRING_delete(keyName);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_011: [ If there is a cached token younger than reusePercent of its lifetime, sastoken_cache_get_token shall return it without signing. ]*/
+TEST_FUNCTION(sastoken_cache_get_token_reuses_the_token_before_reuse_percent)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    size_t creationTime = 0;
+    const char* token1;
+    const char* token2;
+    token1 = sastoken_cache_get_token(handle, NULL);
+    umock_c_reset_all_calls();
+    g_now = 100 + 1799;
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_T, (time_t)0));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    token2 = sastoken_cache_get_token(handle, &creationTime);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, (void*)token1, (void*)token2);
+    ASSERT_ARE_EQUAL(size_t, 100, creationTime);
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_014: [ Otherwise sastoken_cache_get_token shall sign a new token expiring lifetimeInSeconds from now, cache it and return it. ]*/
+TEST_FUNCTION(sastoken_cache_get_token_signs_again_after_reuse_percent)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    size_t creationTime = 0;
+    const char* result;
+    (void)sastoken_cache_get_token(handle, NULL);
+    umock_c_reset_all_calls();
+    g_now = 100 + 1800;
+
+    ///act
+    result = sastoken_cache_get_token(handle, &creationTime);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, "SharedAccessSignature sr=" TEST_SCOPE "&sig=" TEST_URL_ENCODED_SIGNATURE "&se=5500", result);
+    ASSERT_ARE_EQUAL(size_t, 1900, creationTime);
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_015: [ If signing fails, sastoken_cache_get_token shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_get_token_fails_when_Base64_Encode_Bytes_fails)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    const char* result;
+
+    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 32))
+        .SetReturn(NULL);
+
+    ///act
+    result = sastoken_cache_get_token(handle, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_015: [ If signing fails, sastoken_cache_get_token shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_get_token_fails_when_URL_Encode_fails)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    const char* result;
+
+    STRICT_EXPECTED_CALL(URL_Encode(IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+
+    ///act
+    result = sastoken_cache_get_token(handle, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_018: [ If sasTokenCacheHandle is NULL, sastoken_cache_copy_token shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_copy_token_with_NULL_handle_fails)
+{
+    ///arrange
+    STRING_HANDLE result;
+
+    ///act
+    result = sastoken_cache_copy_token(NULL, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_019: [ sastoken_cache_copy_token shall get the token as sastoken_cache_get_token does and return a copy of it made under the lock of the cache, which the caller shall free with STRING_delete. ]*/
+TEST_FUNCTION(sastoken_cache_copy_token_returns_a_copy_of_the_cached_token)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    size_t creationTime = 0;
+    const char* token;
+    STRING_HANDLE result;
+    token = sastoken_cache_get_token(handle, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_T, (time_t)0));
+    STRICT_EXPECTED_CALL(STRING_clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    result = sastoken_cache_copy_token(handle, &creationTime);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, (void*)token, (void*)result);
+    ASSERT_ARE_EQUAL(char_ptr, token, my_STRING_c_str(result));
+    ASSERT_ARE_EQUAL(size_t, 100, creationTime);
+
+    ///cleanup
+    my_STRING_delete(result);
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_019: [ sastoken_cache_copy_token shall get the token as sastoken_cache_get_token does and return a copy of it made under the lock of the cache, which the caller shall free with STRING_delete. ]*/
+TEST_FUNCTION(sastoken_cache_copy_token_signs_when_there_is_no_token)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    STRING_HANDLE result;
+
+    ///act
+    result = sastoken_cache_copy_token(handle, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, "SharedAccessSignature sr=" TEST_SCOPE "&sig=" TEST_URL_ENCODED_SIGNATURE "&se=3700", my_STRING_c_str(result));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(SHORT_KEY_SIGNATURE, g_signature, sizeof(g_signature)));
+
+    ///cleanup
+    my_STRING_delete(result);
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_020: [ If any failure occurs, sastoken_cache_copy_token shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_copy_token_fails_when_Lock_fails)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    STRING_HANDLE result;
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    ///act
+    result = sastoken_cache_copy_token(handle, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_020: [ If any failure occurs, sastoken_cache_copy_token shall fail and return NULL. ]*/
+TEST_FUNCTION(sastoken_cache_copy_token_fails_when_STRING_clone_fails)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    STRING_HANDLE result;
+    (void)sastoken_cache_get_token(handle, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_T, (time_t)0));
+    STRICT_EXPECTED_CALL(STRING_clone(IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    result = sastoken_cache_copy_token(handle, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_016: [ If sasTokenCacheHandle is NULL, sastoken_cache_invalidate shall do nothing. ]*/
+TEST_FUNCTION(sastoken_cache_invalidate_with_NULL_handle_does_nothing)
+{
+    ///arrange
+
+    ///act
+    sastoken_cache_invalidate(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_SASTOKEN_CACHE_02_017: [ sastoken_cache_invalidate shall drop the cached token. ]*/
+TEST_FUNCTION(sastoken_cache_invalidate_makes_the_next_get_token_sign)
+{
+    ///arrange
+    SASTOKEN_CACHE_HANDLE handle = createCache(NULL);
+    (void)sastoken_cache_get_token(handle, NULL);
+    umock_c_reset_all_calls();
+    g_now = 101;
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    sastoken_cache_invalidate(handle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, "SharedAccessSignature sr=" TEST_SCOPE "&sig=" TEST_URL_ENCODED_SIGNATURE "&se=3701", sastoken_cache_get_token(handle, NULL));
+
+    ///cleanup
+    sastoken_cache_destroy(handle);
+}
+
+END_TEST_SUITE(iothub_client_sastoken_cache_ut)
@@ -0,0 +1,304 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*for getrusage(RUSAGE_THREAD)*/
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#include "iothub_client_ll.h"
+#include "iothub_message.h"
+#include "iothub_client_options.h"
+#ifdef USE_HTTP
+#include "iothubtransporthttp.h"
+#endif
+#ifdef USE_MQTT
+#include "iothubtransportmqtt.h"
+#endif
+#ifdef USE_AMQP
+#include "iothubtransportamqp.h"
+#endif
+
+#include "iothub_standin.h"
+
+/*
+ * Sends EVENT_COUNT events of EVENT_SIZE bytes through IoTHubClient_LL and every transport that is built,
+ * to a stand-in hub (testtools/iothub_standin) running in this process on 127.0.0.1, so it needs no
+ * network and no IoT Hub. At most WINDOW events are in flight. For every transport it prints:
+ *  - the throughput, from the first send to the last confirmation
+ *  - the latency from IoTHubClient_LL_SendEventAsync to the confirmation: p50, p90, p99 and max
+ *  - the CPU time of the thread of the client (IoTHubClient_LL_DoWork, TLS and the protocol stack) per
+ *    confirmed event; the stand-in runs in its own thread and is not counted
+ *  - the cloud to device messages received, one is pushed every C2D_INTERVAL_MS
+ * The stand-in can add faults: iothub_client_standin_perf [ackLatencyMs [dropPercent [throttlePercent]]].
+ * Dropped events end in a confirmation of MESSAGE_TIMEOUT after MESSAGE_TIMEOUT_MS, their latency is
+ * not counted. The run fails if a transport does not confirm all its events before RUN_TIMEOUT_MS.
+ */
+
+#define EVENT_COUNT 2000
+#define EVENT_SIZE 256
+#define WINDOW 100
+#define C2D_INTERVAL_MS 100
+#define MESSAGE_TIMEOUT_MS 10000
+#define RUN_TIMEOUT_MS 120000
+#define HTTP_PORT 8443
+
+static const char* DEVICE_ID = "standin-device";
+static const char* DEVICE_KEY = "c3RhbmRpbi1kZXZpY2Uta2V5";
+
+typedef struct PERF_CONTEXT_TAG PERF_CONTEXT;
+
+typedef struct PERF_EVENT_TAG
+{
+    PERF_CONTEXT* context;
+    uint64_t sentUs;
+} PERF_EVENT;
+
+struct PERF_CONTEXT_TAG
+{
+    size_t confirmedOk;
+    size_t confirmedOther;
+    size_t messagesReceived;
+    PERF_EVENT events[EVENT_COUNT];
+    uint64_t latenciesUs[EVENT_COUNT];
+};
+
+static uint64_t GetTimeUs(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+static uint64_t GetThreadCpuUs(void)
+{
+    struct rusage usage;
+    (void)getrusage(RUSAGE_THREAD, &usage);
+    return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + (uint64_t)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+static void OnConfirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    PERF_EVENT* event = (PERF_EVENT*)userContextCallback;
+    PERF_CONTEXT* context = event->context;
+    if (result == IOTHUB_CLIENT_CONFIRMATION_OK)
+    {
+        context->latenciesUs[context->confirmedOk++] = GetTimeUs() - event->sentUs;
+    }
+    else
+    {
+        context->confirmedOther++;
+    }
+}
+
+static IOTHUBMESSAGE_DISPOSITION_RESULT OnMessage(IOTHUB_MESSAGE_HANDLE message, void* userContextCallback)
+{
+    (void)message;
+    ((PERF_CONTEXT*)userContextCallback)->messagesReceived++;
+    return IOTHUBMESSAGE_ACCEPTED;
+}
+
+static int CompareLatencies(const void* left, const void* right)
+{
+    uint64_t l = *(const uint64_t*)left;
+    uint64_t r = *(const uint64_t*)right;
+    return (l < r) ? -1 : ((l > r) ? 1 : 0);
+}
+
+static int Measure(PERF_CONTEXT* context, IOTHUB_STANDIN_HANDLE standin, const char* name, IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol, const char* gatewayHostName, bool polls)
+{
+    int result;
+    IOTHUB_CLIENT_CONFIG config;
+    IOTHUB_CLIENT_LL_HANDLE client;
+    uint64_t messageTimeout = MESSAGE_TIMEOUT_MS;
+
+    (void)memset(context, 0, sizeof(PERF_CONTEXT));
+    config.protocol = protocol;
+    config.deviceId = DEVICE_ID;
+    config.deviceKey = DEVICE_KEY;
+    config.deviceSasToken = NULL;
+    config.iotHubName = "standin";
+    config.iotHubSuffix = "local";
+    config.protocolGatewayHostName = gatewayHostName;
+
+    if ((client = IoTHubClient_LL_Create(&config)) == NULL)
+    {
+        (void)printf("%s: IoTHubClient_LL_Create failed\n", name);
+        result = __LINE__;
+    }
+    else
+    {
+        if (IoTHubClient_LL_SetOption(client, "TrustedCerts", iothub_standin_get_certificate(standin)) != IOTHUB_CLIENT_OK ||
+            IoTHubClient_LL_SetOption(client, "messageTimeout", &messageTimeout) != IOTHUB_CLIENT_OK ||
+            IoTHubClient_LL_SetMessageCallback(client, OnMessage, context) != IOTHUB_CLIENT_OK)
+        {
+            (void)printf("%s: unable to set up the client\n", name);
+            result = __LINE__;
+        }
+        else
+        {
+            unsigned char payload[EVENT_SIZE];
+            IOTHUB_STANDIN_STATS before;
+            IOTHUB_STANDIN_STATS after;
+            size_t sent = 0;
+            uint64_t startUs;
+            uint64_t elapsedUs;
+            uint64_t cpuUs;
+
+            if (polls)
+            {
+                /*as often as HTTP allows, once a second*/
+                unsigned int minimumPollingTime = 1;
+                (void)IoTHubClient_LL_SetOption(client, OPTION_MIN_POLLING_TIME, &minimumPollingTime);
+            }
+            (void)memset(payload, 'p', sizeof(payload));
+            (void)iothub_standin_get_stats(standin, &before);
+
+            result = 0;
+            startUs = GetTimeUs();
+            cpuUs = GetThreadCpuUs();
+            while (context->confirmedOk + context->confirmedOther < EVENT_COUNT && result == 0)
+            {
+                while (sent < EVENT_COUNT && sent - (context->confirmedOk + context->confirmedOther) < WINDOW && result == 0)
+                {
+                    IOTHUB_MESSAGE_HANDLE message = IoTHubMessage_CreateFromByteArray(payload, sizeof(payload));
+                    if (message == NULL)
+                    {
+                        (void)printf("%s: IoTHubMessage_CreateFromByteArray failed\n", name);
+                        result = __LINE__;
+                    }
+                    else
+                    {
+                        context->events[sent].context = context;
+                        context->events[sent].sentUs = GetTimeUs();
+                        if (IoTHubClient_LL_SendEventAsync(client, message, OnConfirmation, &context->events[sent]) != IOTHUB_CLIENT_OK)
+                        {
+                            (void)printf("%s: IoTHubClient_LL_SendEventAsync failed\n", name);
+                            result = __LINE__;
+                        }
+                        sent++;
+                        IoTHubMessage_Destroy(message);
+                    }
+                }
+
+                IoTHubClient_LL_DoWork(client);
+                if (GetTimeUs() - startUs > (uint64_t)RUN_TIMEOUT_MS * 1000)
+                {
+                    (void)printf("%s: %lu events confirmed after %d ms\n", name, (unsigned long)(context->confirmedOk + context->confirmedOther), RUN_TIMEOUT_MS);
+                    result = __LINE__;
+                }
+                else
+                {
+                    ThreadAPI_Sleep(1);
+                }
+            }
+            elapsedUs = GetTimeUs() - startUs;
+            cpuUs = GetThreadCpuUs() - cpuUs;
+            (void)iothub_standin_get_stats(standin, &after);
+
+            if (result == 0)
+            {
+                size_t count = context->confirmedOk;
+                if (count == 0)
+                {
+                    (void)printf("%-6s no event confirmed OK, %lu confirmed otherwise\n", name, (unsigned long)context->confirmedOther);
+                }
+                else
+                {
+                    qsort(context->latenciesUs, count, sizeof(uint64_t), CompareLatencies);
+                    (void)printf("%-6s %8.0f events/s  latency p50 %6.2f ms p90 %6.2f ms p99 %6.2f ms max %7.2f ms  cpu %6.1f us/event\n",
+                        name,
+                        (double)count * 1000000.0 / (double)elapsedUs,
+                        (double)context->latenciesUs[count / 2] / 1000.0,
+                        (double)context->latenciesUs[(count * 90) / 100] / 1000.0,
+                        (double)context->latenciesUs[(count * 99) / 100] / 1000.0,
+                        (double)context->latenciesUs[count - 1] / 1000.0,
+                        (double)cpuUs / (double)count);
+                }
+                (void)printf("%-6s confirmed ok %lu, otherwise %lu; stand-in received %llu, dropped %llu, throttled %llu; c2d received %lu\n",
+                    name, (unsigned long)context->confirmedOk, (unsigned long)context->confirmedOther,
+                    (unsigned long long)(after.eventsReceived - before.eventsReceived),
+                    (unsigned long long)(after.eventsDropped - before.eventsDropped),
+                    (unsigned long long)(after.eventsThrottled - before.eventsThrottled),
+                    (unsigned long)context->messagesReceived);
+            }
+        }
+        IoTHubClient_LL_Destroy(client);
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    IOTHUB_STANDIN_CONFIG standinConfig;
+    IOTHUB_STANDIN_HANDLE standin;
+    PERF_CONTEXT* context;
+
+    iothub_standin_config_init(&standinConfig);
+    standinConfig.httpPort = HTTP_PORT;
+    standinConfig.c2dIntervalMs = C2D_INTERVAL_MS;
+    standinConfig.ackLatencyMs = (argc > 1) ? (unsigned int)atoi(argv[1]) : 0;
+    standinConfig.dropPercent = (argc > 2) ? (unsigned int)atoi(argv[2]) : 0;
+    standinConfig.throttlePercent = (argc > 3) ? (unsigned int)atoi(argv[3]) : 0;
+
+    if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        if ((context = (PERF_CONTEXT*)malloc(sizeof(PERF_CONTEXT))) == NULL)
+        {
+            (void)printf("malloc failed\n");
+            result = __LINE__;
+        }
+        else
+        {
+            if ((standin = iothub_standin_start(&standinConfig)) == NULL)
+            {
+                (void)printf("unable to start the stand-in, are ports %d, 8883 and 5671 free?\n", HTTP_PORT);
+                result = __LINE__;
+            }
+            else
+            {
+                (void)printf("%d events of %d bytes, %d in flight, ack latency %u ms, drop %u%%, throttle %u%%\n",
+                    EVENT_COUNT, EVENT_SIZE, WINDOW, standinConfig.ackLatencyMs, standinConfig.dropPercent, standinConfig.throttlePercent);
+                result = 0;
+#ifdef USE_HTTP
+                if (result == 0)
+                {
+                    char httpGateway[32];
+                    (void)sprintf(httpGateway, "127.0.0.1:%d", HTTP_PORT);
+                    result = Measure(context, standin, "HTTP", HTTP_Protocol, httpGateway, true);
+                }
+#endif
+#ifdef USE_MQTT
+                if (result == 0)
+                {
+                    result = Measure(context, standin, "MQTT", MQTT_Protocol, "127.0.0.1", false);
+                }
+#endif
+#ifdef USE_AMQP
+                if (result == 0)
+                {
+                    result = Measure(context, standin, "AMQP", AMQP_Protocol, "127.0.0.1", false);
+                }
+#endif
+                iothub_standin_stop(standin);
+            }
+            free(context);
+        }
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -0,0 +1,475 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_trace.h"
+#include "iothub_client_private.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_c.h"
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#define TEST_LOCK_HANDLE ((LOCK_HANDLE)0x4250)
+#define TEST_MESSAGE_1 ((IOTHUB_MESSAGE_HANDLE)0x10)
+#define TEST_MESSAGE_2 ((IOTHUB_MESSAGE_HANDLE)0x20)
+
+#define TEST_MAX_TRACED 8
+static IOTHUB_CLIENT_TRACE_STAGE tracedStages[TEST_MAX_TRACED];
+static IOTHUB_MESSAGE_HANDLE tracedMessages[TEST_MAX_TRACED];
+static uint64_t tracedTimestamps[TEST_MAX_TRACED];
+static void* tracedContext;
+static size_t tracedCount;
+static char formatted[4096];
+
+static void onTrace(IOTHUB_CLIENT_TRACE_STAGE stage, IOTHUB_MESSAGE_HANDLE message, uint64_t timestampUs, void* context)
+{
+    ASSERT_IS_TRUE(tracedCount < TEST_MAX_TRACED);
+    tracedStages[tracedCount] = stage;
+    tracedMessages[tracedCount] = message;
+    tracedTimestamps[tracedCount] = timestampUs;
+    tracedContext = context;
+    tracedCount++;
+}
+
+/*links the entry by hand, the doubly linked list of the shared utility is not part of the test*/
+static void addToList(PDLIST_ENTRY list, IOTHUB_MESSAGE_LIST* item, IOTHUB_MESSAGE_HANDLE message)
+{
+    (void)memset(item, 0, sizeof(IOTHUB_MESSAGE_LIST));
+    item->messageHandle = message;
+    item->entry.Flink = list;
+    item->entry.Blink = list->Blink;
+    list->Blink->Flink = &(item->entry);
+    list->Blink = &(item->entry);
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(iothub_client_trace_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    int result;
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_c_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+    iothub_client_trace_set_callback(NULL, NULL);
+    tracedCount = 0;
+    tracedContext = NULL;
+    (void)memset(formatted, 'x', sizeof(formatted));
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    iothub_client_trace_set_callback(NULL, NULL);
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_002: [ If no callback is set, iothub_client_trace_message shall return without reading the clock. ]*/
+TEST_FUNCTION(iothub_client_trace_message_without_callback_does_nothing)
+{
+    ///act
+    iothub_client_trace_message(IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE, TEST_MESSAGE_1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, tracedCount);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_001: [ iothub_client_trace_set_callback shall store callback and context, a NULL callback stops the tracing. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_003: [ Otherwise iothub_client_trace_message shall call the callback with stage, message, the time of iothub_client_trace_get_time_us and the context. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_006: [ iothub_client_trace_get_time_us shall return the time of a monotonic clock in microseconds. ]*/
+TEST_FUNCTION(iothub_client_trace_message_calls_the_callback)
+{
+    ///arrange
+    uint64_t before = iothub_client_trace_get_time_us();
+    uint64_t after;
+    iothub_client_trace_set_callback(onTrace, (void*)0x42);
+
+    ///act
+    iothub_client_trace_message(IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE, TEST_MESSAGE_1);
+    iothub_client_trace_message(IOTHUB_CLIENT_TRACE_STAGE_WRITE, TEST_MESSAGE_1);
+    after = iothub_client_trace_get_time_us();
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 2, tracedCount);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE, (int)tracedStages[0]);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_TRACE_STAGE_WRITE, (int)tracedStages[1]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_MESSAGE_1, tracedMessages[0]);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, tracedContext);
+    ASSERT_IS_TRUE(before <= tracedTimestamps[0]);
+    ASSERT_IS_TRUE(tracedTimestamps[0] <= tracedTimestamps[1]);
+    ASSERT_IS_TRUE(tracedTimestamps[1] <= after);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_001: [ iothub_client_trace_set_callback shall store callback and context, a NULL callback stops the tracing. ]*/
+TEST_FUNCTION(iothub_client_trace_set_callback_with_NULL_stops_the_tracing)
+{
+    ///arrange
+    iothub_client_trace_set_callback(onTrace, NULL);
+    iothub_client_trace_message(IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE, TEST_MESSAGE_1);
+
+    ///act
+    iothub_client_trace_set_callback(NULL, NULL);
+    iothub_client_trace_message(IOTHUB_CLIENT_TRACE_STAGE_DEQUEUE, TEST_MESSAGE_1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 1, tracedCount);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_004: [ If no callback is set or list is NULL, iothub_client_trace_message_list shall return without reading the clock. ]*/
+TEST_FUNCTION(iothub_client_trace_message_list_with_NULL_list_does_nothing)
+{
+    ///arrange
+    iothub_client_trace_set_callback(onTrace, NULL);
+
+    ///act
+    iothub_client_trace_message_list(IOTHUB_CLIENT_TRACE_STAGE_ACK, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, tracedCount);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_005: [ Otherwise iothub_client_trace_message_list shall read the clock once and call the callback with stage and that time for the message of every IOTHUB_MESSAGE_LIST in list, in order. ]*/
+TEST_FUNCTION(iothub_client_trace_message_list_traces_every_message_with_one_timestamp)
+{
+    ///arrange
+    DLIST_ENTRY list;
+    IOTHUB_MESSAGE_LIST item1;
+    IOTHUB_MESSAGE_LIST item2;
+    list.Flink = &list;
+    list.Blink = &list;
+    addToList(&list, &item1, TEST_MESSAGE_1);
+    addToList(&list, &item2, TEST_MESSAGE_2);
+    iothub_client_trace_set_callback(onTrace, NULL);
+
+    ///act
+    iothub_client_trace_message_list(IOTHUB_CLIENT_TRACE_STAGE_ACK, &list);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 2, tracedCount);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_MESSAGE_1, tracedMessages[0]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_MESSAGE_2, tracedMessages[1]);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_TRACE_STAGE_ACK, (int)tracedStages[1]);
+    ASSERT_ARE_EQUAL(uint64_t, tracedTimestamps[0], tracedTimestamps[1]);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_007: [ If capacity is 0, iothub_client_trace_recorder_create shall fail and return NULL. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_create_with_0_capacity_fails)
+{
+    ///act
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE result = iothub_client_trace_recorder_create(0);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_008: [ iothub_client_trace_recorder_create shall allocate the recorder and its capacity entries and create a lock. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_011: [ iothub_client_trace_recorder_destroy shall deinit the lock and free the entries and the recorder. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_create_and_destroy_succeed)
+{
+    ///arrange
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    ///act
+    result = iothub_client_trace_recorder_create(4);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///act
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    iothub_client_trace_recorder_destroy(result);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_009: [ If any of the above fails, iothub_client_trace_recorder_create shall fail and return NULL. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_create_fails_when_Lock_Init_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    ///act
+    result = iothub_client_trace_recorder_create(4);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_009: [ If any of the above fails, iothub_client_trace_recorder_create shall fail and return NULL. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_create_fails_when_the_entries_cannot_be_allocated)
+{
+    ///arrange
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    ///act
+    result = iothub_client_trace_recorder_create(4);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_010: [ If recorder is NULL, iothub_client_trace_recorder_destroy shall do nothing. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_destroy_with_NULL_does_nothing)
+{
+    ///act
+    iothub_client_trace_recorder_destroy(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_012: [ If context is NULL, iothub_client_trace_recorder_callback shall do nothing. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_callback_with_NULL_context_does_nothing)
+{
+    ///act
+    iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE, TEST_MESSAGE_1, 1, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_013: [ iothub_client_trace_recorder_callback shall store stage, message and timestampUs under the lock of the recorder, overwriting the oldest event when the recorder is full. ]*/
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_016: [ iothub_client_trace_recorder_format shall write the events oldest first as a Chrome trace {"traceEvents":[...]}, every event being an async instant event ("ph":"n") named after its stage in lower case, of category "iothub", whose id is the message handle and whose ts is its timestamp. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_callback_stores_the_event_under_the_lock)
+{
+    ///arrange
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE recorder = iothub_client_trace_recorder_create(4);
+    size_t length;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE_DEQUEUE, TEST_MESSAGE_1, 7, recorder);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    length = iothub_client_trace_recorder_format(recorder, formatted, sizeof(formatted));
+    ASSERT_ARE_EQUAL(char_ptr, "{\"traceEvents\":[{\"name\":\"dequeue\",\"cat\":\"iothub\",\"ph\":\"n\",\"id\":\"0x10\",\"ts\":7,\"pid\":1,\"tid\":1}]}", formatted);
+    ASSERT_ARE_EQUAL(size_t, strlen(formatted), length);
+
+    ///cleanup
+    iothub_client_trace_recorder_destroy(recorder);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_014: [ If the lock cannot be taken, iothub_client_trace_recorder_callback shall drop the event. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_callback_drops_the_event_when_Lock_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE recorder = iothub_client_trace_recorder_create(4);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    ///act
+    iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE_DEQUEUE, TEST_MESSAGE_1, 7, recorder);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)iothub_client_trace_recorder_format(recorder, formatted, sizeof(formatted));
+    ASSERT_ARE_EQUAL(char_ptr, "{\"traceEvents\":[]}", formatted);
+
+    ///cleanup
+    iothub_client_trace_recorder_destroy(recorder);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_013: [ iothub_client_trace_recorder_callback shall store stage, message and timestampUs under the lock of the recorder, overwriting the oldest event when the recorder is full. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_overwrites_the_oldest_event_when_full)
+{
+    ///arrange
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE recorder = iothub_client_trace_recorder_create(2);
+
+    ///act
+    iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE_DEQUEUE, TEST_MESSAGE_1, 1, recorder);
+    iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE_SERIALIZE, TEST_MESSAGE_1, 2, recorder);
+    iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE_WRITE, TEST_MESSAGE_1, 3, recorder);
+
+    ///assert
+    (void)iothub_client_trace_recorder_format(recorder, formatted, sizeof(formatted));
+    ASSERT_ARE_EQUAL(char_ptr,
+        "{\"traceEvents\":["
+        "{\"name\":\"serialize\",\"cat\":\"iothub\",\"ph\":\"n\",\"id\":\"0x10\",\"ts\":2,\"pid\":1,\"tid\":1},"
+        "{\"name\":\"write\",\"cat\":\"iothub\",\"ph\":\"n\",\"id\":\"0x10\",\"ts\":3,\"pid\":1,\"tid\":1}"
+        "]}", formatted);
+
+    ///cleanup
+    iothub_client_trace_recorder_destroy(recorder);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_017: [ An ENQUEUE event shall be preceded by the begin ("ph":"b") and a CALLBACK event followed by the end ("ph":"e") of an async event named "message" with the same id and ts. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_format_begins_and_ends_the_message_span)
+{
+    ///arrange
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE recorder = iothub_client_trace_recorder_create(4);
+    iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE, TEST_MESSAGE_2, 10, recorder);
+    iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE_CALLBACK, TEST_MESSAGE_2, 25, recorder);
+
+    ///act
+    (void)iothub_client_trace_recorder_format(recorder, formatted, sizeof(formatted));
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr,
+        "{\"traceEvents\":["
+        "{\"name\":\"message\",\"cat\":\"iothub\",\"ph\":\"b\",\"id\":\"0x20\",\"ts\":10,\"pid\":1,\"tid\":1},"
+        "{\"name\":\"enqueue\",\"cat\":\"iothub\",\"ph\":\"n\",\"id\":\"0x20\",\"ts\":10,\"pid\":1,\"tid\":1},"
+        "{\"name\":\"callback\",\"cat\":\"iothub\",\"ph\":\"n\",\"id\":\"0x20\",\"ts\":25,\"pid\":1,\"tid\":1},"
+        "{\"name\":\"message\",\"cat\":\"iothub\",\"ph\":\"e\",\"id\":\"0x20\",\"ts\":25,\"pid\":1,\"tid\":1}"
+        "]}", formatted);
+
+    ///cleanup
+    iothub_client_trace_recorder_destroy(recorder);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_016: [ iothub_client_trace_recorder_format shall write the events oldest first as a Chrome trace {"traceEvents":[...]}, every event being an async instant event ("ph":"n") named after its stage in lower case, of category "iothub", whose id is the message handle and whose ts is its timestamp. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_format_with_NULL_destination_returns_the_length)
+{
+    ///arrange
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE recorder = iothub_client_trace_recorder_create(4);
+    size_t needed;
+    size_t written;
+    iothub_client_trace_recorder_callback(IOTHUB_CLIENT_TRACE_STAGE_ENQUEUE, TEST_MESSAGE_1, 10, recorder);
+
+    ///act
+    needed = iothub_client_trace_recorder_format(recorder, NULL, 0);
+    written = iothub_client_trace_recorder_format(recorder, formatted, 20);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, needed, written);
+    ASSERT_ARE_EQUAL(size_t, 19, strlen(formatted));
+    ASSERT_IS_TRUE(0 == strncmp(formatted, "{\"traceEvents\":[{\"n", 19));
+
+    ///cleanup
+    iothub_client_trace_recorder_destroy(recorder);
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_015: [ If recorder is NULL, iothub_client_trace_recorder_format shall return 0. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_format_with_NULL_recorder_returns_0)
+{
+    ///act
+    size_t result = iothub_client_trace_recorder_format(NULL, formatted, sizeof(formatted));
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUB_CLIENT_TRACE_02_018: [ If the lock cannot be taken, iothub_client_trace_recorder_format shall return 0. ]*/
+TEST_FUNCTION(iothub_client_trace_recorder_format_returns_0_when_Lock_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_TRACE_RECORDER_HANDLE recorder = iothub_client_trace_recorder_create(4);
+    size_t result;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    ///act
+    result = iothub_client_trace_recorder_format(recorder, formatted, sizeof(formatted));
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    iothub_client_trace_recorder_destroy(recorder);
+}
+
+END_TEST_SUITE(iothub_client_trace_ut)
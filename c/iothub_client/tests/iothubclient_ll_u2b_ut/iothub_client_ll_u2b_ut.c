@@ -34,11 +34,11 @@ void my_gballoc_free(void* ptr)
 #define ENABLE_MOCKS
 
 #include "azure_c_shared_utility/httpapiex.h"
-#include "azure_c_shared_utility/httpapiexsas.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "blob.h"
 #include "parson.h"
+#include "iothub_client_sastoken_cache.h"
 
 MOCKABLE_FUNCTION(, JSON_Value*, json_parse_string, const char *, string);
 MOCKABLE_FUNCTION(, const char*, json_object_get_string, const JSON_Object *, object, const char *, name);
@@ -110,15 +110,21 @@ static void my_HTTPAPIEX_Destroy(HTTPAPIEX_HANDLE handle)
     free(handle);
 }
 
-static HTTPAPIEX_SAS_HANDLE my_HTTPAPIEX_SAS_Create(STRING_HANDLE key, STRING_HANDLE uriResource, STRING_HANDLE keyName)
+static SASTOKEN_CACHE_HANDLE my_sastoken_cache_create(STRING_HANDLE key, STRING_HANDLE scope, STRING_HANDLE keyName)
 {
-    (void)key, uriResource, keyName;
-    return (HTTPAPIEX_SAS_HANDLE)malloc(1);
+    (void)key, scope, keyName;
+    return (SASTOKEN_CACHE_HANDLE)malloc(1);
 }
 
-static void my_HTTPAPIEX_SAS_Destroy(HTTPAPIEX_SAS_HANDLE handle)
+static void my_sastoken_cache_destroy(SASTOKEN_CACHE_HANDLE sasTokenCacheHandle)
 {
-    free(handle);
+    free(sasTokenCacheHandle);
+}
+
+static STRING_HANDLE my_sastoken_cache_copy_token(SASTOKEN_CACHE_HANDLE sasTokenCacheHandle, size_t* creationTime)
+{
+    (void)sasTokenCacheHandle, creationTime;
+    return my_STRING_new();
 }
 
 static JSON_Value * my_json_parse_string(const char *string)
@@ -144,16 +150,6 @@ static HTTPAPIEX_RESULT my_HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTT
     return HTTPAPIEX_OK;
 }
 
-static HTTPAPIEX_RESULT my_HTTPAPIEX_SAS_ExecuteRequest(HTTPAPIEX_SAS_HANDLE sasHandle, HTTPAPIEX_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode, HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
-{
-    (void)sasHandle, handle, requestType, relativePath, requestHttpHeadersHandle, requestContent, responseHeadersHandle, responseContent;
-    if (statusCode != NULL)
-    {
-        *statusCode = 200;/*success*/
-    }
-    return HTTPAPIEX_OK;
-}
-
 static int my_mallocAndStrcpy_s(char** destination, const char* source)
 {
     size_t l = strlen(source);
@@ -201,6 +197,7 @@ static const TRANSPORT_PROVIDER* provideFAKE(void);
 #define TEST_DEVICE_KEY "theKeyoftheDevice"
 #define TEST_DEVICE_SAS "theSasOfTheDevice"
 #define TEST_DEVICE_SAS_FAIL "fail_theSasOfTheDevice"
+#define TEST_SASTOKEN_FROM_CACHE "theSasTokenFromTheCache"
 #define TEST_IOTHUBNAME "theNameoftheIotHub"
 #define TEST_IOTHUBSUFFIX "theSuffixoftheIotHubHostname"
 #define TEST_AUTHORIZATIONKEY "theAuthorizationKey"
@@ -277,7 +274,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_UMOCK_ALIAS_TYPE(HTTP_HEADERS_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(HTTP_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_HANDLE, void*);
-    REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_SAS_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SASTOKEN_CACHE_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(const unsigned char*, void*);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
@@ -303,10 +300,11 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(HTTPAPIEX_Create, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_Destroy, my_HTTPAPIEX_Destroy);
 
-    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_SAS_Create, my_HTTPAPIEX_SAS_Create);
-    REGISTER_GLOBAL_MOCK_FAIL_RETURN(HTTPAPIEX_SAS_ExecuteRequest, HTTPAPIEX_ERROR);
-    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_SAS_ExecuteRequest, my_HTTPAPIEX_SAS_ExecuteRequest)
-    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_SAS_Destroy, my_HTTPAPIEX_SAS_Destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(sastoken_cache_create, my_sastoken_cache_create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(sastoken_cache_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(sastoken_cache_destroy, my_sastoken_cache_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(sastoken_cache_copy_token, my_sastoken_cache_copy_token);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(sastoken_cache_copy_token, NULL);
 
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_new, my_BUFFER_new);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_new, NULL);
@@ -748,17 +746,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_happypath)
     }
 
     {/*step3*/
-        STRING_HANDLE uriResource;
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
-            .CaptureReturn(&uriResource);
-
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/devices/"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(uriResource, IGNORED_PTR_ARG)) /*50*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/files/notifications"))
-            .IgnoreArgument(1);
 
         STRING_HANDLE relativePathNotification;
         STRICT_EXPECTED_CALL(STRING_construct("/devices/"))
@@ -803,8 +790,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_happypath)
 
         STRICT_EXPECTED_CALL(STRING_delete(relativePathNotification)) /*60*/
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(uriResource))
-            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
@@ -1150,17 +1135,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_when_step2_httpStatusCode_i
     }
 
     {/*step3*/
-        STRING_HANDLE uriResource;
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
-            .CaptureReturn(&uriResource);
-
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/devices/"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(uriResource, IGNORED_PTR_ARG)) /*50*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/files/notifications"))
-            .IgnoreArgument(1);
 
         STRING_HANDLE relativePathNotification;
         STRICT_EXPECTED_CALL(STRING_construct("/devices/"))
@@ -1205,8 +1179,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_when_step2_httpStatusCode_i
 
         STRICT_EXPECTED_CALL(STRING_delete(relativePathNotification)) /*60*/
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(uriResource))
-            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
@@ -1443,17 +1415,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_when_step3_httpStatusCode_i
     }
 
     {/*step3*/
-        STRING_HANDLE uriResource;
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
-            .CaptureReturn(&uriResource);
-
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/devices/"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(uriResource, IGNORED_PTR_ARG)) /*50*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/files/notifications"))
-            .IgnoreArgument(1);
 
         STRING_HANDLE relativePathNotification;
         STRICT_EXPECTED_CALL(STRING_construct("/devices/"))
@@ -1498,8 +1459,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_when_step3_httpStatusCode_i
 
         STRICT_EXPECTED_CALL(STRING_delete(relativePathNotification)) /*60*/
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(uriResource))
-            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
@@ -1746,17 +1705,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_unhappypaths)
     }
 
     {/*step3*/
-        STRING_HANDLE uriResource;
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
-            .CaptureReturn(&uriResource);
-
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/devices/"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(uriResource, IGNORED_PTR_ARG)) /*50*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/files/notifications"))
-            .IgnoreArgument(1);
 
         STRING_HANDLE relativePathNotification;
         STRICT_EXPECTED_CALL(STRING_construct("/devices/"))
@@ -1801,8 +1749,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_unhappypaths)
 
         STRICT_EXPECTED_CALL(STRING_delete(relativePathNotification)) /*60*/
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(uriResource))
-            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
@@ -1827,7 +1773,7 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_unhappypaths)
 
     ///act
 
-    size_t calls_that_cannot_fail[] = { 
+    size_t calls_that_cannot_fail[] = {
         14, /*STRING_c_str*/
         16, /*STRING_c_str*/
         18, /*BUFFER_u_char*/
@@ -1840,18 +1786,16 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_unhappypaths)
         42, /*STRING_c_str*/
         44, /*BUFFER_u_char*/
         46, /*BUFFER_u_char*/
-        55, /*STRING_c_str*/
-        58, /*STRING_c_str*/
-        60, /*BUFFER_delete*/
-        60, /*STRING_delete*/
+        51, /*STRING_c_str*/
+        54, /*STRING_c_str*/
+        56, /*STRING_delete*/
+        57, /*BUFFER_delete*/
+        58, /*gballoc_free*/
+        59, /*BUFFER_delete*/
+        60, /*HTTPHeaders_Free*/
         61, /*STRING_delete*/
-        62, /*BUFFER_delete*/
-        63, /*gballoc_free*/
-        64, /*BUFFER_delete*/
-        65, /*HTTPHeaders_Free*/
-        66, /*STRING_delete*/
-        67, /*STRING_delete*/
-        68, /*HTTPAPIEX_Destroy*/
+        62, /*STRING_delete*/
+        63, /*HTTPAPIEX_Destroy*/
     };
 
     for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
@@ -1893,6 +1837,7 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SAS_token_unhappypaths)
 }
 
 
+/*Tests_SRS_IOTHUBCLIENT_LL_02_115: [ If the credentials are a device key then IoTHubClient_LL_UploadToBlob_Create shall create a SAS token cache passing the device key, hostname + "/devices/" + deviceId as scope and NULL as key name. ]*/
 TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_Create_DeviceKey_happypath)
 {
     ///arrange
@@ -1907,6 +1852,22 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_Create_DeviceKey_happypath)
 
     STRICT_EXPECTED_CALL(STRING_construct(TEST_DEVICE_KEY));
 
+    STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX)); /*this is building the path that the SAS token authenticates*/
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "/devices/"))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_s1()
+        .IgnoreArgument_s2();
+
+    STRICT_EXPECTED_CALL(sastoken_cache_create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL))
+        .IgnoreArgument_key()
+        .IgnoreArgument_scope();
+
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the path that the SAS token authenticates*/
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the device key, the cache keeps only the HMAC pads*/
+        .IgnoreArgument_handle();
+
     ///act
     IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_DEVICE_KEY);
 
@@ -1940,36 +1901,69 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_Create_DeviceKey_unhappypaths)
     STRICT_EXPECTED_CALL(STRING_construct(TEST_DEVICE_KEY))
         .SetFailReturn(NULL);
 
+    STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "/devices/"))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_s1()
+        .IgnoreArgument_s2();
+
+    STRICT_EXPECTED_CALL(sastoken_cache_create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL))
+        .IgnoreArgument_key()
+        .IgnoreArgument_scope();
+
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
     umock_c_negative_tests_snapshot();
 
+    size_t calls_that_cannot_fail[] = {
+        8, /*STRING_delete*/
+        9, /*STRING_delete*/
+    };
+
     ///act
     for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
     {
         /// arrange
         char temp_str[128];
+        size_t j;
         umock_c_negative_tests_reset();
         umock_c_negative_tests_fail_call(i);
 
-        /// act
-        IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_DEVICE_KEY);
+        for (j = 0;j<sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]);j++) /*not running the tests that have failed that cannot fail*/
+        {
+            if (calls_that_cannot_fail[j] == i)
+                break;
+        }
 
-        /// assert
-        sprintf(temp_str, "On failed call %zu", i + 1);
-        ASSERT_IS_NULL_WITH_MSG(h, temp_str);
+        if (j == sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]))
+        {
+            /// act
+            IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_DEVICE_KEY);
+
+            /// assert
+            sprintf(temp_str, "On failed call %zu", i + 1);
+            ASSERT_IS_NULL_WITH_MSG(h, temp_str);
+        }
     }
 
     umock_c_negative_tests_deinit();
 
 }
 
+/*Tests_SRS_IOTHUBCLIENT_LL_02_116: [ IoTHubClient_LL_UploadToBlob_Destroy shall destroy the SAS token cache. ]*/
 TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_Destroy_with_DeviceKey_happypath)
 {
     ///arrange
     IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_DEVICE_KEY);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(sastoken_cache_destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_sasTokenCacheHandle();
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreArgument_ptr();
     STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
@@ -1986,8 +1980,8 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_Destroy_with_DeviceKey_happypath)
     ///cleanup
 }
 
-/*Tests_SRS_IOTHUBCLIENT_LL_02_078: [ If the credentials used to create iotHubClientHandle have "deviceKey" then IoTHubClient_LL_UploadToBlob shall create an HTTPAPIEX_SAS_HANDLE passing as arguments: ]*/
-/*Tests_SRS_IOTHUBCLIENT_LL_02_090: [ IoTHubClient_LL_UploadToBlob shall call HTTPAPIEX_SAS_ExecuteRequest passing as arguments: ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_078: [ If the credentials used to create handle have "deviceKey" then IoTHubClient_LL_UploadToBlob shall replace the "Authorization" HTTP request header with a copy of the token returned by sastoken_cache_copy_token, and free the copy. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_090: [ IoTHubClient_LL_UploadToBlob shall call HTTPAPIEX_ExecuteRequest passing as arguments: ]*/
 TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_happypath)
 {
     ///arrange
@@ -2042,20 +2036,18 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_happypath)
             .IgnoreArgument(1);
 
        
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX)); /*this is starting to build the path that the SAS token authenticates*/
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "/devices/")) /*this is building the path that the SAS token authenticates*/
+        STRICT_EXPECTED_CALL(sastoken_cache_copy_token(IGNORED_PTR_ARG, NULL))
+            .IgnoreArgument_sasTokenCacheHandle();
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .SetReturn(TEST_SASTOKEN_FROM_CACHE);
+        STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(iotHubHttpRequestHeaders1, "Authorization", TEST_SASTOKEN_FROM_CACHE))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*this is building the path that the SAS token authenticates*/
-            .IgnoreArgument_s1()
-            .IgnoreArgument_s2();
-        STRICT_EXPECTED_CALL(STRING_new());/*this is needed for HTTPAPIEX_SAS_Create -it needs an empty STRING_HANDLE*/
-
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
         STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest( /*20*/
-            IGNORED_PTR_ARG,
+        STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(
             IGNORED_PTR_ARG,
             HTTPAPI_REQUEST_GET,
             IGNORED_PTR_ARG,
@@ -2065,22 +2057,12 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_happypath)
             NULL,
             IGNORED_PTR_ARG
         ))
-            .IgnoreArgument_sasHandle()
-            .IgnoreArgument_handle()
-            .IgnoreArgument_relativePath()
-            .IgnoreArgument_requestHttpHeadersHandle()
-            .IgnoreArgument_requestContent()
-            .IgnoreArgument_statusCode()
-            .IgnoreArgument_responseHeadersHandle()
-            .IgnoreArgument_responseContent()
-            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred))
-            ;
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the empty STRING_new*/
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the build the path that the SAS token authenticates*/
-            .IgnoreArgument_handle();
+            .IgnoreArgument(1)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4)
+            .IgnoreArgument(6)
+            .IgnoreArgument(8)
+            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred));
 
         unsigned char* iotHubHttpMessageBodyResponse1_unsigned_char = (unsigned char*)TEST_DEFAULT_STRING_VALUE;
         size_t iotHubHttpMessageBodyResponse1_size;
@@ -2202,17 +2184,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_happypath)
 
     {/*step3*/
 
-        STRING_HANDLE uriResource;
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
-            .CaptureReturn(&uriResource);
-
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/devices/"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(uriResource, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/files/notifications"))
-            .IgnoreArgument(1);
 
         STRING_HANDLE relativePathNotification;
         STRICT_EXPECTED_CALL(STRING_construct("/devices/"))
@@ -2234,41 +2205,36 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_happypath)
         STRICT_EXPECTED_CALL(STRING_concat(relativePathNotification, TEST_API_VERSION))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(STRING_new());
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(sastoken_cache_copy_token(IGNORED_PTR_ARG, NULL))
+            .IgnoreArgument_sasTokenCacheHandle();
         STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .SetReturn(TEST_SASTOKEN_FROM_CACHE);
+        STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(iotHubHttpRequestHeaders1, "Authorization", TEST_SASTOKEN_FROM_CACHE))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
-            IGNORED_PTR_ARG,
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(
             IGNORED_PTR_ARG,
             HTTPAPI_REQUEST_POST,
             IGNORED_PTR_ARG,
             IGNORED_PTR_ARG,
-            NULL,
+            IGNORED_PTR_ARG,
             IGNORED_PTR_ARG,
             NULL,
-            IGNORED_PTR_ARG
+            NULL
         ))
-            .IgnoreArgument_sasHandle()
-            .IgnoreArgument_handle()
-            .IgnoreArgument_relativePath()
-            .IgnoreArgument_requestHttpHeadersHandle()
-            .IgnoreArgument_requestContent()
-            .IgnoreArgument_statusCode()
-            .IgnoreArgument_responseHeadersHandle()
-            .IgnoreArgument_responseContent()
-            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred))
-            ;
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
+            .IgnoreArgument(1)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4)
+            .IgnoreArgument(5)
+            .IgnoreArgument(6)
+            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred));
             
         STRICT_EXPECTED_CALL(STRING_delete(relativePathNotification)) /*70*/
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(uriResource))
-            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
@@ -2355,20 +2321,18 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_when_step1_httpStatusCode_i
             .IgnoreArgument(1);
 
 
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX)); /*this is starting to build the path that the SAS token authenticates*/
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "/devices/")) /*this is building the path that the SAS token authenticates*/
+        STRICT_EXPECTED_CALL(sastoken_cache_copy_token(IGNORED_PTR_ARG, NULL))
+            .IgnoreArgument_sasTokenCacheHandle();
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .SetReturn(TEST_SASTOKEN_FROM_CACHE);
+        STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(iotHubHttpRequestHeaders1, "Authorization", TEST_SASTOKEN_FROM_CACHE))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*this is building the path that the SAS token authenticates*/
-            .IgnoreArgument_s1()
-            .IgnoreArgument_s2();
-        STRICT_EXPECTED_CALL(STRING_new());/*this is needed for HTTPAPIEX_SAS_Create -it needs an empty STRING_HANDLE*/
-
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
         STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
-            IGNORED_PTR_ARG,
+        STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(
             IGNORED_PTR_ARG,
             HTTPAPI_REQUEST_GET,
             IGNORED_PTR_ARG,
@@ -2378,22 +2342,12 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_when_step1_httpStatusCode_i
             NULL,
             IGNORED_PTR_ARG
         ))
-            .IgnoreArgument_sasHandle()
-            .IgnoreArgument_handle()
-            .IgnoreArgument_relativePath()
-            .IgnoreArgument_requestHttpHeadersHandle()
-            .IgnoreArgument_requestContent()
-            .IgnoreArgument_statusCode()
-            .IgnoreArgument_responseHeadersHandle()
-            .IgnoreArgument_responseContent()
-            .CopyOutArgumentBuffer_statusCode(&FourHundred, sizeof(FourHundred))
-            ;
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the empty STRING_new*/
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the build the path that the SAS token authenticates*/
-            .IgnoreArgument_handle();
+            .IgnoreArgument(1)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4)
+            .IgnoreArgument(6)
+            .IgnoreArgument(8)
+            .CopyOutArgumentBuffer_statusCode(&FourHundred, sizeof(FourHundred));
 
         STRICT_EXPECTED_CALL(BUFFER_delete(iotHubHttpMessageBodyResponse1))
             .IgnoreArgument(1);
@@ -2477,20 +2431,18 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_when_step3_httpStatusCode_i
             .IgnoreArgument(1);
 
 
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX)); /*this is starting to build the path that the SAS token authenticates*/
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "/devices/")) /*this is building the path that the SAS token authenticates*/
+        STRICT_EXPECTED_CALL(sastoken_cache_copy_token(IGNORED_PTR_ARG, NULL))
+            .IgnoreArgument_sasTokenCacheHandle();
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .SetReturn(TEST_SASTOKEN_FROM_CACHE);
+        STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(iotHubHttpRequestHeaders1, "Authorization", TEST_SASTOKEN_FROM_CACHE))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*this is building the path that the SAS token authenticates*/
-            .IgnoreArgument_s1()
-            .IgnoreArgument_s2();
-        STRICT_EXPECTED_CALL(STRING_new());/*this is needed for HTTPAPIEX_SAS_Create -it needs an empty STRING_HANDLE*/
-
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
         STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest( /*20*/
-            IGNORED_PTR_ARG,
+        STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(
             IGNORED_PTR_ARG,
             HTTPAPI_REQUEST_GET,
             IGNORED_PTR_ARG,
@@ -2500,22 +2452,12 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_when_step3_httpStatusCode_i
             NULL,
             IGNORED_PTR_ARG
         ))
-            .IgnoreArgument_sasHandle()
-            .IgnoreArgument_handle()
-            .IgnoreArgument_relativePath()
-            .IgnoreArgument_requestHttpHeadersHandle()
-            .IgnoreArgument_requestContent()
-            .IgnoreArgument_statusCode()
-            .IgnoreArgument_responseHeadersHandle()
-            .IgnoreArgument_responseContent()
-            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred))
-            ;
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the empty STRING_new*/
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the build the path that the SAS token authenticates*/
-            .IgnoreArgument_handle();
+            .IgnoreArgument(1)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4)
+            .IgnoreArgument(6)
+            .IgnoreArgument(8)
+            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred));
 
         unsigned char* iotHubHttpMessageBodyResponse1_unsigned_char = (unsigned char*)TEST_DEFAULT_STRING_VALUE;
         size_t iotHubHttpMessageBodyResponse1_size;
@@ -2637,17 +2579,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_when_step3_httpStatusCode_i
 
     {/*step3*/
 
-        STRING_HANDLE uriResource;
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
-            .CaptureReturn(&uriResource);
-
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/devices/"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(uriResource, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/files/notifications"))
-            .IgnoreArgument(1);
 
         STRING_HANDLE relativePathNotification;
         STRICT_EXPECTED_CALL(STRING_construct("/devices/"))
@@ -2669,41 +2600,36 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_when_step3_httpStatusCode_i
         STRICT_EXPECTED_CALL(STRING_concat(relativePathNotification, TEST_API_VERSION))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(STRING_new());
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(sastoken_cache_copy_token(IGNORED_PTR_ARG, NULL))
+            .IgnoreArgument_sasTokenCacheHandle();
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .SetReturn(TEST_SASTOKEN_FROM_CACHE);
+        STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(iotHubHttpRequestHeaders1, "Authorization", TEST_SASTOKEN_FROM_CACHE))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
         STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
-            IGNORED_PTR_ARG,
+        STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(
             IGNORED_PTR_ARG,
             HTTPAPI_REQUEST_POST,
             IGNORED_PTR_ARG,
             IGNORED_PTR_ARG,
-            NULL,
+            IGNORED_PTR_ARG,
             IGNORED_PTR_ARG,
             NULL,
-            IGNORED_PTR_ARG
+            NULL
         ))
-            .IgnoreArgument_sasHandle()
-            .IgnoreArgument_handle()
-            .IgnoreArgument_relativePath()
-            .IgnoreArgument_requestHttpHeadersHandle()
-            .IgnoreArgument_requestContent()
-            .IgnoreArgument_statusCode()
-            .IgnoreArgument_responseHeadersHandle()
-            .IgnoreArgument_responseContent()
-            .CopyOutArgumentBuffer_statusCode(&FourHundred, sizeof(FourHundred))
-            ;
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
+            .IgnoreArgument(1)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4)
+            .IgnoreArgument(5)
+            .IgnoreArgument(6)
+            .CopyOutArgumentBuffer_statusCode(&FourHundred, sizeof(FourHundred));
 
         STRICT_EXPECTED_CALL(STRING_delete(relativePathNotification)) /*70*/
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(uriResource))
-            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
@@ -2735,8 +2661,8 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_when_step3_httpStatusCode_i
     IoTHubClient_LL_UploadToBlob_Destroy(h);
 }
 
-/*Tests_SRS_IOTHUBCLIENT_LL_02_089: [ If creating the HTTPAPIEX_SAS_HANDLE fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-/*Tests_SRS_IOTHUBCLIENT_LL_02_079: [ If HTTPAPIEX_SAS_ExecuteRequest fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_089: [ If getting the SAS token or replacing the "Authorization" header fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_079: [ If HTTPAPIEX_ExecuteRequest fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
 TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_unhappypaths)
 {
     ///arrange
@@ -2795,20 +2721,18 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_unhappypaths)
             .IgnoreArgument(1);
 
 
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX)); /*this is starting to build the path that the SAS token authenticates*/
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "/devices/")) /*this is building the path that the SAS token authenticates*/
+        STRICT_EXPECTED_CALL(sastoken_cache_copy_token(IGNORED_PTR_ARG, NULL))
+            .IgnoreArgument_sasTokenCacheHandle();
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .SetReturn(TEST_SASTOKEN_FROM_CACHE);
+        STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(iotHubHttpRequestHeaders1, "Authorization", TEST_SASTOKEN_FROM_CACHE))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*this is building the path that the SAS token authenticates*/
-            .IgnoreArgument_s1()
-            .IgnoreArgument_s2();
-        STRICT_EXPECTED_CALL(STRING_new());/*this is needed for HTTPAPIEX_SAS_Create -it needs an empty STRING_HANDLE*/
-
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
         STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest( /*20*/
-            IGNORED_PTR_ARG,
+        STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(
             IGNORED_PTR_ARG,
             HTTPAPI_REQUEST_GET,
             IGNORED_PTR_ARG,
@@ -2818,22 +2742,12 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_unhappypaths)
             NULL,
             IGNORED_PTR_ARG
         ))
-            .IgnoreArgument_sasHandle()
-            .IgnoreArgument_handle()
-            .IgnoreArgument_relativePath()
-            .IgnoreArgument_requestHttpHeadersHandle()
-            .IgnoreArgument_requestContent()
-            .IgnoreArgument_statusCode()
-            .IgnoreArgument_responseHeadersHandle()
-            .IgnoreArgument_responseContent()
-            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred))
-            ;
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the empty STRING_new*/
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*the build the path that the SAS token authenticates*/
-            .IgnoreArgument_handle();
+            .IgnoreArgument(1)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4)
+            .IgnoreArgument(6)
+            .IgnoreArgument(8)
+            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred));
 
         unsigned char* iotHubHttpMessageBodyResponse1_unsigned_char = (unsigned char*)TEST_DEFAULT_STRING_VALUE;
         size_t iotHubHttpMessageBodyResponse1_size;
@@ -2955,17 +2869,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_unhappypaths)
 
     {/*step3*/
 
-        STRING_HANDLE uriResource;
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
-            .CaptureReturn(&uriResource);
-
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/devices/"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(uriResource, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/files/notifications"))
-            .IgnoreArgument(1);
 
         STRING_HANDLE relativePathNotification;
         STRICT_EXPECTED_CALL(STRING_construct("/devices/"))
@@ -2987,13 +2890,18 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_unhappypaths)
         STRICT_EXPECTED_CALL(STRING_concat(relativePathNotification, TEST_API_VERSION))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(STRING_new());
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(sastoken_cache_copy_token(IGNORED_PTR_ARG, NULL))
+            .IgnoreArgument_sasTokenCacheHandle();
         STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .SetReturn(TEST_SASTOKEN_FROM_CACHE);
+        STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(iotHubHttpRequestHeaders1, "Authorization", TEST_SASTOKEN_FROM_CACHE))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
             .IgnoreArgument_handle();
-        EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
-            IGNORED_PTR_ARG,
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(
             IGNORED_PTR_ARG,
             HTTPAPI_REQUEST_POST,
             IGNORED_PTR_ARG,
@@ -3003,22 +2911,15 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_unhappypaths)
             NULL,
             NULL
         ))
-            .IgnoreArgument_sasHandle()
-            .IgnoreArgument_handle()
-            .IgnoreArgument_relativePath()
-            .IgnoreArgument_requestHttpHeadersHandle()
-            .IgnoreArgument_requestContent()
-            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred))
-            ;
-        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
+            .IgnoreArgument(1)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4)
+            .IgnoreArgument(5)
+            .IgnoreArgument(6)
+            .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred));
 
         STRICT_EXPECTED_CALL(STRING_delete(relativePathNotification)) /*70*/
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(uriResource))
-            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
@@ -3042,34 +2943,31 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_deviceKey_unhappypaths)
     umock_c_negative_tests_snapshot();
 
     size_t calls_that_cannot_fail[] = {
-        19, /*STRING_c_str*/
-        21, /*HTTPAPIEX_SAS_Destroy*/
-        22, /*STRING_delete*/
-        23, /*STRING_delete*/
-        24, /*BUFFER_u_char*/
-        25, /*BUFFER_length*/
-        27, /*STRING_c_str*/
-        43, /*json_value_free*/
-        44, /*STRING_delete*/
-        45, /*BUFFER_delete*/
-        46, /*STRING_delete*/
-        48, /*STRING_c_str*/
-        50, /*BUFFER_u_char*/
-        52, /*BUFFER_u_char*/
-        61, /*STRING_c_str*/
-        66, /*STRING_c_str*/
-        68, /*HTTPAPIEX_SAS_Destroy*/
-        69, /*STRING_delete*/
-        70, /*STRING_delete*/
-        71, /*STRING_delete*/
-        72, /*BUFFER_delete*/
-        73, /*gballoc_free*/
-        74, /*BUFFER_delete*/
-        75, /*HTTPHeaders_Free*/
-        76, /*STRING_delete*/
-        77, /*STRING_delete*/
-        78, /*HTTPAPIEX_Destroy*/
-
+        15, /*STRING_c_str*/
+        17, /*STRING_delete*/
+        18, /*STRING_c_str*/
+        20, /*BUFFER_u_char*/
+        21, /*BUFFER_length*/
+        23, /*STRING_c_str*/
+        39, /*json_value_free*/
+        40, /*STRING_delete*/
+        41, /*BUFFER_delete*/
+        42, /*STRING_delete*/
+        44, /*STRING_c_str*/
+        46, /*BUFFER_u_char*/
+        48, /*BUFFER_u_char*/
+        53, /*STRING_c_str*/
+        57, /*STRING_c_str*/
+        59, /*STRING_delete*/
+        60, /*STRING_c_str*/
+        62, /*STRING_delete*/
+        63, /*BUFFER_delete*/
+        64, /*gballoc_free*/
+        65, /*BUFFER_delete*/
+        66, /*HTTPHeaders_Free*/
+        67, /*STRING_delete*/
+        68, /*STRING_delete*/
+        69, /*HTTPAPIEX_Destroy*/
     };
 
     for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
@@ -3308,17 +3206,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_passes_x509_information_to_HTTPAPIEX_
     }
 
     {/*step3*/
-        STRING_HANDLE uriResource;
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
-            .CaptureReturn(&uriResource);
-
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/devices/"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(uriResource, IGNORED_PTR_ARG)) /*50*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/files/notifications"))
-            .IgnoreArgument(1);
 
         STRING_HANDLE relativePathNotification;
         STRICT_EXPECTED_CALL(STRING_construct("/devices/"))
@@ -3363,8 +3250,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_passes_x509_information_to_HTTPAPIEX_
 
         STRICT_EXPECTED_CALL(STRING_delete(relativePathNotification)) /*60*/
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(uriResource))
-            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
@@ -3606,17 +3491,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_passes_x509_information_to_HTTPAPIEX_
     }
 
     {/*step3*/
-        STRING_HANDLE uriResource;
-        STRICT_EXPECTED_CALL(STRING_construct(TEST_IOTHUBNAME "." TEST_IOTHUBSUFFIX))
-            .CaptureReturn(&uriResource);
-
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/devices/"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(uriResource, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(uriResource, "/files/notifications"))/*50*/
-            .IgnoreArgument(1);
 
         STRING_HANDLE relativePathNotification;
         STRICT_EXPECTED_CALL(STRING_construct("/devices/"))
@@ -3661,8 +3535,6 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_passes_x509_information_to_HTTPAPIEX_
 
         STRICT_EXPECTED_CALL(STRING_delete(relativePathNotification)) 
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(uriResource)) /*60*/
-            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
@@ -3690,28 +3562,23 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_passes_x509_information_to_HTTPAPIEX_
         17, /*BUFFER_u_char*/
         18, /*BUFFER_length*/
         20, /*STRING_c_str*/
-
         36, /*json_value_free*/
         37, /*STRING_delete*/
         38, /*BUFFER_delete*/
         39, /*STRING_delete*/
-       
         41, /*STRING_c_str*/
         43, /*BUFFER_u_char*/
         45, /*BUFFER_u_char*/
-
-        54, /*STRING_c_str*/
-        57, /*STRING_c_str*/
-        59, /*STRING_delete*/
-        
+        50, /*STRING_c_str*/
+        53, /*STRING_c_str*/
+        55, /*STRING_delete*/
+        56, /*BUFFER_delete*/
+        57, /*gballoc_free*/
+        58, /*BUFFER_delete*/
+        59, /*HTTPHeaders_Free*/
         60, /*STRING_delete*/
-        61, /*BUFFER_delete*/
-        62, /*gballoc_free*/
-        63, /*BUFFER_delete*/
-        64, /*HTTPHeaders_Free*/
-        65, /*STRING_delete*/
-        66, /*STRING_delete*/
-        67, /*HTTPAPIEX_Destroy*/
+        61, /*STRING_delete*/
+        62, /*HTTPAPIEX_Destroy*/
     };
 
     for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
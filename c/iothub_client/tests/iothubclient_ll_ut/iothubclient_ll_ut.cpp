@@ -28,6 +28,9 @@
 #include "azure_c_shared_utility/strings.h"
 
 #include "azure_c_shared_utility/tickcounter.h"
+#include "iothub_client_persistent_queue.h"
+#include "iothub_client_compression.h"
+#include "iothub_client_options.h"
 
 extern "C" int gballoc_init(void);
 extern "C" void gballoc_deinit(void);
@@ -56,6 +59,24 @@ namespace BASEIMPLEMENTATION
 DEFINE_MICROMOCK_ENUM_TO_STRING(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
 DEFINE_MICROMOCK_ENUM_TO_STRING(IOTHUB_CLIENT_CONFIRMATION_RESULT, IOTHUB_CLIENT_CONFIRMATION_RESULT_VALUES);
 DEFINE_MICROMOCK_ENUM_TO_STRING(IOTHUBMESSAGE_DISPOSITION_RESULT, IOTHUBMESSAGE_DISPOSITION_RESULT_VALUES);
+DEFINE_MICROMOCK_ENUM_TO_STRING(PERSISTENT_QUEUE_RESULT, PERSISTENT_QUEUE_RESULT_VALUES);
+
+#define TEST_PERSISTENT_QUEUE_HANDLE (PERSISTENT_QUEUE_HANDLE)0x4343
+#define TEST_PERSISTED_MESSAGE_HANDLE(sequenceNumber) ((IOTHUB_MESSAGE_HANDLE)(uintptr_t)(0x1000 + (sequenceNumber)))
+#define TEST_COMPRESSION_HANDLE (COMPRESSION_HANDLE)0x4444
+#define TEST_COMPRESSED_MESSAGE_HANDLE (IOTHUB_MESSAGE_HANDLE)0x4545
+#define TEST_MESSAGE_SIZE 10
+static const unsigned char TEST_MESSAGE_CONTENT[TEST_MESSAGE_SIZE] = { 0 };
+
+/*number of records the fake persistent queue holds, their sequence numbers are 1..g_persistedCount*/
+static uint64_t g_persistedCount;
+
+/*what the last call of eventConfirmationBatchCallback was given*/
+#define TEST_MAX_BATCH 8
+static IOTHUB_CLIENT_EVENT_CONFIRMATION g_batch[TEST_MAX_BATCH];
+static size_t g_batchCount;
+/*waitingToSend list handed to the transport at Register time*/
+static PDLIST_ENTRY g_waitingToSend;
 
 
 static MICROMOCK_MUTEX_HANDLE g_testByTest;
@@ -64,6 +85,7 @@ static MICROMOCK_GLOBAL_SEMAPHORE_HANDLE g_dllByDll;
 //Check ProtocolGateway Configuration.
 static bool checkProtocolGatewayHostName;
 static bool checkProtocolGatewayIsNull;
+static IOTHUB_CLIENT_METRICS* g_transportMetrics; /*the metrics given to the transport in IOTHUBTRANSPORT_CONFIG*/
 
 #define TEST_DEVICE_ID "theidofTheDevice"
 #define TEST_DEVICE_KEY "theKeyoftheDevice"
@@ -83,6 +105,8 @@ static bool checkProtocolGatewayIsNull;
 
 #define TEST_DEVICEMESSAGE_HANDLE (IOTHUB_MESSAGE_HANDLE)0x52
 #define TEST_DEVICEMESSAGE_HANDLE_2 (IOTHUB_MESSAGE_HANDLE)0x53
+#define TEST_HIGH_PRIORITY_MESSAGE_HANDLE (IOTHUB_MESSAGE_HANDLE)0x54
+#define TEST_LOW_PRIORITY_MESSAGE_HANDLE (IOTHUB_MESSAGE_HANDLE)0x55
 #define TEST_IOTHUB_CLIENT_LL_HANDLE    (IOTHUB_CLIENT_LL_HANDLE)0x4242
 
 #define TEST_STRING_HANDLE (STRING_HANDLE)0x46
@@ -165,6 +189,10 @@ public:
         BASEIMPLEMENTATION::DList_InsertTailList(listHead, listEntry);
     MOCK_VOID_METHOD_END()
 
+    MOCK_STATIC_METHOD_2(, void, DList_InsertHeadList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, listEntry)
+        BASEIMPLEMENTATION::DList_InsertHeadList(listHead, listEntry);
+    MOCK_VOID_METHOD_END()
+
     MOCK_STATIC_METHOD_2(, void, DList_AppendTailList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, ListToAppend)
         BASEIMPLEMENTATION::DList_AppendTailList(listHead, ListToAppend);
     MOCK_VOID_METHOD_END()
@@ -206,6 +234,7 @@ public:
 
         MOCK_STATIC_METHOD_1(, TRANSPORT_LL_HANDLE, FAKE_IoTHubTransport_Create, const IOTHUBTRANSPORT_CONFIG*, config)
         TRANSPORT_LL_HANDLE result2;
+    g_transportMetrics = (config != NULL) ? config->metrics : NULL;
     if (checkProtocolGatewayHostName)
     {
         if (config != NULL && config->upperConfig != NULL && config->upperConfig->protocolGatewayHostName != NULL && strcmp(config->upperConfig->protocolGatewayHostName, TEST_CHAR) == 0)
@@ -244,6 +273,7 @@ public:
         MOCK_VOID_METHOD_END()
 
         MOCK_STATIC_METHOD_4(, IOTHUB_DEVICE_HANDLE, FAKE_IoTHubTransport_Register, TRANSPORT_LL_HANDLE, handle, const IOTHUB_DEVICE_CONFIG*, device, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, PDLIST_ENTRY, waitingToSend)
+        g_waitingToSend = waitingToSend;
         MOCK_METHOD_END(IOTHUB_DEVICE_HANDLE, (IOTHUB_DEVICE_HANDLE)handle)
 
         MOCK_STATIC_METHOD_1(, void, FAKE_IoTHubTransport_Unregister, IOTHUB_DEVICE_HANDLE, handle)
@@ -262,9 +292,17 @@ public:
         *iotHubClientStatus = currentIotHubClientStatus;
     MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK)
 
+        MOCK_STATIC_METHOD_3(, int, FAKE_IoTHubTransport_SetRetryPolicy, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds)
+    MOCK_METHOD_END(int, 0)
+
         MOCK_STATIC_METHOD_2(, void, eventConfirmationCallback, IOTHUB_CLIENT_CONFIRMATION_RESULT, result2, void*, userContextCallback)
         MOCK_VOID_METHOD_END()
 
+        MOCK_STATIC_METHOD_3(, void, eventConfirmationBatchCallback, const IOTHUB_CLIENT_EVENT_CONFIRMATION*, confirmations, size_t, confirmationCount, void*, userContextCallback)
+        g_batchCount = (confirmationCount < TEST_MAX_BATCH) ? confirmationCount : TEST_MAX_BATCH;
+        memcpy(g_batch, confirmations, g_batchCount * sizeof(IOTHUB_CLIENT_EVENT_CONFIRMATION));
+        MOCK_VOID_METHOD_END()
+
         MOCK_STATIC_METHOD_2(, IOTHUBMESSAGE_DISPOSITION_RESULT, messageCallback, IOTHUB_MESSAGE_HANDLE, message, void*, userContextCallback)
         MOCK_METHOD_END(IOTHUBMESSAGE_DISPOSITION_RESULT, IOTHUBMESSAGE_ACCEPTED);
 
@@ -338,11 +376,94 @@ public:
     MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK)
 #endif
 
+    /* Persistent queue mocks */
+    MOCK_STATIC_METHOD_1(, PERSISTENT_QUEUE_HANDLE, persistent_queue_create, const PERSISTENT_QUEUE_CONFIG*, config)
+    MOCK_METHOD_END(PERSISTENT_QUEUE_HANDLE, TEST_PERSISTENT_QUEUE_HANDLE)
+
+    MOCK_STATIC_METHOD_1(, void, persistent_queue_destroy, PERSISTENT_QUEUE_HANDLE, handle)
+    MOCK_VOID_METHOD_END()
+
+    MOCK_STATIC_METHOD_2(, int, persistent_queue_ack, PERSISTENT_QUEUE_HANDLE, handle, uint64_t, sequenceNumber)
+    MOCK_METHOD_END(int, 0)
+
+    MOCK_STATIC_METHOD_3(, int, persistent_queue_get_range, PERSISTENT_QUEUE_HANDLE, handle, uint64_t*, firstSequenceNumber, uint64_t*, nextSequenceNumber)
+        *firstSequenceNumber = 1;
+        *nextSequenceNumber = g_persistedCount + 1;
+    MOCK_METHOD_END(int, 0)
+
+    MOCK_STATIC_METHOD_3(, PERSISTENT_QUEUE_RESULT, persistent_queue_append_message, PERSISTENT_QUEUE_HANDLE, handle, IOTHUB_MESSAGE_HANDLE, message, uint64_t*, sequenceNumber)
+        *sequenceNumber = ++g_persistedCount;
+    MOCK_METHOD_END(PERSISTENT_QUEUE_RESULT, PERSISTENT_QUEUE_OK)
+
+    MOCK_STATIC_METHOD_4(, PERSISTENT_QUEUE_RESULT, persistent_queue_read_message, PERSISTENT_QUEUE_HANDLE, handle, uint64_t, fromSequenceNumber, IOTHUB_MESSAGE_HANDLE*, message, uint64_t*, sequenceNumber)
+        PERSISTENT_QUEUE_RESULT result2;
+        if (fromSequenceNumber <= g_persistedCount)
+        {
+            *message = TEST_PERSISTED_MESSAGE_HANDLE(fromSequenceNumber);
+            *sequenceNumber = fromSequenceNumber;
+            result2 = PERSISTENT_QUEUE_OK;
+        }
+        else
+        {
+            result2 = PERSISTENT_QUEUE_EMPTY;
+        }
+    MOCK_METHOD_END(PERSISTENT_QUEUE_RESULT, result2)
+
+    MOCK_STATIC_METHOD_3(, int, persistent_queue_get_usage, PERSISTENT_QUEUE_HANDLE, handle, size_t*, messageCount, size_t*, byteCount)
+        *messageCount = (size_t)g_persistedCount;
+        *byteCount = (size_t)g_persistedCount * TEST_MESSAGE_SIZE;
+    MOCK_METHOD_END(int, 0)
+
+    /* Compression mocks */
+    MOCK_STATIC_METHOD_2(, COMPRESSION_HANDLE, compression_create, const unsigned char*, dictionary, size_t, dictionarySize)
+    MOCK_METHOD_END(COMPRESSION_HANDLE, TEST_COMPRESSION_HANDLE)
+
+    MOCK_STATIC_METHOD_1(, void, compression_destroy, COMPRESSION_HANDLE, compression)
+    MOCK_VOID_METHOD_END()
+
+    MOCK_STATIC_METHOD_3(, IOTHUB_MESSAGE_HANDLE, compression_compress_message, COMPRESSION_HANDLE, compression, IOTHUB_MESSAGE_HANDLE, message, const char*, dictionaryId)
+    MOCK_METHOD_END(IOTHUB_MESSAGE_HANDLE, TEST_COMPRESSED_MESSAGE_HANDLE)
+
+    MOCK_STATIC_METHOD_2(, int, mallocAndStrcpy_s, char**, destination, const char*, source)
+        int result2;
+        size_t l = strlen(source);
+        if ((*destination = (char*)BASEIMPLEMENTATION::gballoc_malloc(l + 1)) == NULL)
+        {
+            result2 = __LINE__;
+        }
+        else
+        {
+            (void)memcpy(*destination, source, l + 1);
+            result2 = 0;
+        }
+    MOCK_METHOD_END(int, result2)
+
+    /* Message content mocks, every message is a byte array of TEST_MESSAGE_SIZE bytes */
+    MOCK_STATIC_METHOD_1(, IOTHUBMESSAGE_CONTENT_TYPE, IoTHubMessage_GetContentType, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle)
+    MOCK_METHOD_END(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_BYTEARRAY)
+
+    MOCK_STATIC_METHOD_3(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_GetByteArray, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, const unsigned char**, buffer, size_t*, size)
+        *buffer = TEST_MESSAGE_CONTENT;
+        *size = TEST_MESSAGE_SIZE;
+    MOCK_METHOD_END(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK)
+
+    MOCK_STATIC_METHOD_1(, const char*, IoTHubMessage_GetString, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle)
+    MOCK_METHOD_END(const char*, "0123456789")
+
+    /* the priority of a message is given by the handle it was cloned from, see IoTHubMessage_Clone */
+    MOCK_STATIC_METHOD_1(, IOTHUB_MESSAGE_PRIORITY, IoTHubMessage_GetPriority, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle)
+        IOTHUB_MESSAGE_PRIORITY result2 =
+            ((uintptr_t)iotHubMessageHandle == (uintptr_t)TEST_HIGH_PRIORITY_MESSAGE_HANDLE + 1000) ? IOTHUB_MESSAGE_PRIORITY_HIGH :
+            ((uintptr_t)iotHubMessageHandle == (uintptr_t)TEST_LOW_PRIORITY_MESSAGE_HANDLE + 1000) ? IOTHUB_MESSAGE_PRIORITY_LOW :
+            IOTHUB_MESSAGE_PRIORITY_NORMAL;
+    MOCK_METHOD_END(IOTHUB_MESSAGE_PRIORITY, result2)
+
 };
 
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , void, DList_InitializeListHead, PDLIST_ENTRY, listHead);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , int, DList_IsListEmpty, PDLIST_ENTRY, listHead);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , void, DList_InsertTailList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, listEntry);
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , void, DList_InsertHeadList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, listEntry);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , void, DList_AppendTailList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, ListToAppend);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , int, DList_RemoveEntryList, PDLIST_ENTRY, listEntry);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , PDLIST_ENTRY, DList_RemoveHeadList, PDLIST_ENTRY, listHead);
@@ -361,8 +482,10 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , int, FAKE_IoTHubTransport_S
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , void, FAKE_IoTHubTransport_Unsubscribe, TRANSPORT_LL_HANDLE, handle);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , void, FAKE_IoTHubTransport_DoWork, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , IOTHUB_CLIENT_RESULT, FAKE_IoTHubTransport_GetSendStatus, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_STATUS*, iotHubClientStatus);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientLLMocks, , int, FAKE_IoTHubTransport_SetRetryPolicy, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds);
 
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , void, eventConfirmationCallback, IOTHUB_CLIENT_CONFIRMATION_RESULT, result2, void*, userContextCallback);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientLLMocks, , void, eventConfirmationBatchCallback, const IOTHUB_CLIENT_EVENT_CONFIRMATION*, confirmations, size_t, confirmationCount, void*, userContextCallback);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , IOTHUBMESSAGE_DISPOSITION_RESULT, messageCallback, IOTHUB_MESSAGE_HANDLE, message, void*, userContextCallback);
 
 
@@ -395,6 +518,24 @@ DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientLLMocks, , IOTHUB_CLIENT_RESULT, IoTHu
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , void, IoTHubClient_LL_UploadToBlob_Destroy, IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE, handle);
 #endif
 
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , PERSISTENT_QUEUE_HANDLE, persistent_queue_create, const PERSISTENT_QUEUE_CONFIG*, config);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , void, persistent_queue_destroy, PERSISTENT_QUEUE_HANDLE, handle);
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , int, persistent_queue_ack, PERSISTENT_QUEUE_HANDLE, handle, uint64_t, sequenceNumber);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientLLMocks, , int, persistent_queue_get_range, PERSISTENT_QUEUE_HANDLE, handle, uint64_t*, firstSequenceNumber, uint64_t*, nextSequenceNumber);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientLLMocks, , PERSISTENT_QUEUE_RESULT, persistent_queue_append_message, PERSISTENT_QUEUE_HANDLE, handle, IOTHUB_MESSAGE_HANDLE, message, uint64_t*, sequenceNumber);
+DECLARE_GLOBAL_MOCK_METHOD_4(CIoTHubClientLLMocks, , PERSISTENT_QUEUE_RESULT, persistent_queue_read_message, PERSISTENT_QUEUE_HANDLE, handle, uint64_t, fromSequenceNumber, IOTHUB_MESSAGE_HANDLE*, message, uint64_t*, sequenceNumber);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientLLMocks, , int, persistent_queue_get_usage, PERSISTENT_QUEUE_HANDLE, handle, size_t*, messageCount, size_t*, byteCount);
+
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , COMPRESSION_HANDLE, compression_create, const unsigned char*, dictionary, size_t, dictionarySize);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , void, compression_destroy, COMPRESSION_HANDLE, compression);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientLLMocks, , IOTHUB_MESSAGE_HANDLE, compression_compress_message, COMPRESSION_HANDLE, compression, IOTHUB_MESSAGE_HANDLE, message, const char*, dictionaryId);
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientLLMocks, , int, mallocAndStrcpy_s, char**, destination, const char*, source);
+
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , IOTHUBMESSAGE_CONTENT_TYPE, IoTHubMessage_GetContentType, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientLLMocks, , IOTHUB_MESSAGE_RESULT, IoTHubMessage_GetByteArray, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, const unsigned char**, buffer, size_t*, size);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , const char*, IoTHubMessage_GetString, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientLLMocks, , IOTHUB_MESSAGE_PRIORITY, IoTHubMessage_GetPriority, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
+
 static TRANSPORT_PROVIDER FAKE_transport_provider =
 {
     FAKE_IoTHubTransport_GetHostname,   /*pfIoTHubTransport_GetHostname IoTHubTransport_GetHostname     */
@@ -406,7 +547,8 @@ static TRANSPORT_PROVIDER FAKE_transport_provider =
     FAKE_IoTHubTransport_Subscribe,     /*pfIoTHubTransport_Subscribe IoTHubTransport_Subscribe;        */
     FAKE_IoTHubTransport_Unsubscribe,   /*pfIoTHubTransport_Unsubscribe IoTHubTransport_Unsubscribe;    */
     FAKE_IoTHubTransport_DoWork,        /*pfIoTHubTransport_DoWork IoTHubTransport_DoWork;              */
-    FAKE_IoTHubTransport_GetSendStatus  /*pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus;*/
+    FAKE_IoTHubTransport_GetSendStatus, /*pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus;*/
+    FAKE_IoTHubTransport_SetRetryPolicy /*pfIoTHubTransport_SetRetryPolicy IoTHubTransport_SetRetryPolicy;*/
 };
 
 static const TRANSPORT_PROVIDER* provideFAKE(void)
@@ -440,6 +582,10 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
     whenShallmalloc_fail = 0;
     checkProtocolGatewayHostName = false;
     checkProtocolGatewayIsNull = false;
+    g_transportMetrics = NULL;
+    g_persistedCount = 0;
+    g_waitingToSend = NULL;
+    g_batchCount = 0;
 }
 
 TEST_FUNCTION_CLEANUP(TestMethodCleanup)
@@ -3001,6 +3147,9 @@ TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_succeeds)
     auto messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*stamps the event for the confirmation latency*/
+        .IgnoreAllArguments();
+
     STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreArgument(1);
 
@@ -3011,6 +3160,9 @@ TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_succeeds)
     STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Clone(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetPriority(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
     ///act
     auto result = IoTHubClient_LL_SendEventAsync(handle, messageHandle, eventConfirmationCallback, (void*)1);
 
@@ -3076,6 +3228,8 @@ TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_fails_when_IoTHubMessage_Clone_fail
     auto messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*stamps the event for the confirmation latency*/
+        .IgnoreAllArguments();
     STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*because _Clone fails below*/
@@ -3340,6 +3494,9 @@ TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_1_items_with_callback_succeeds)
     DList_InsertTailList(&temp, &(one->entry));
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*the confirmation latency*/
+        .IgnoreAllArguments();
+
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
@@ -3388,6 +3545,9 @@ TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_3_items_with_callback_succeeds)
 
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*the confirmation latency*/
+        .IgnoreAllArguments();
+
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
@@ -3449,6 +3609,9 @@ TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_3_items_one_without_callback_suc
 
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*the confirmation latency*/
+        .IgnoreAllArguments();
+
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
@@ -3509,6 +3672,9 @@ TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_3_items_with_callback__but_batch
 
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*the confirmation latency*/
+        .IgnoreAllArguments();
+
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, (void*)1));
@@ -3569,6 +3735,9 @@ TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_3_items_one_with_callback_but_ba
 
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*the confirmation latency*/
+        .IgnoreAllArguments();
+
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)1));
@@ -3855,6 +4024,200 @@ TEST_FUNCTION(IoTHubClient_GetSendStatus_HasEventToSend_Succeeds)
     currentIotHubClientStatus = IOTHUB_CLIENT_SEND_STATUS_IDLE;
 }
 
+/*** IoTHubClient_LL_SetRetryPolicy / IoTHubClient_LL_GetRetryPolicy ***/
+
+/* Tests_SRS_IOTHUBCLIENT_LL_25_116: [**IoTHubClient_LL_SetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL iotHubClientHandle**]*/
+TEST_FUNCTION(IoTHubClient_LL_SetRetryPolicy_with_NULL_handle_fails)
+{
+    // arrange
+    CIoTHubClientLLMocks mocks;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetRetryPolicy(NULL, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+}
+
+/* Tests_SRS_IOTHUBCLIENT_LL_02_173: [ For every policy, a retryTimeoutLimitinSeconds of 0 shall mean no time limit. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetRetryPolicy_with_0_timeout_sets_no_limit)
+{
+    // arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+    size_t retryTimeoutLimitInSeconds;
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_SetRetryPolicy(IGNORED_PTR_ARG, IOTHUB_CLIENT_RETRY_INTERVAL, 0))
+        .IgnoreArgument(1);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetRetryPolicy(handle, IOTHUB_CLIENT_RETRY_INTERVAL, 0);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetRetryPolicy(handle, &retryPolicy, &retryTimeoutLimitInSeconds));
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_RETRY_INTERVAL, (int)retryPolicy);
+    ASSERT_ARE_EQUAL(size_t, 0, retryTimeoutLimitInSeconds);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_LL_02_174: [ If iotHubClientHandle was created on a shared transport then IoTHubClient_LL_SetRetryPolicy shall fail and return IOTHUB_CLIENT_ERROR, because the policy of the transport is the policy of every device on it. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetRetryPolicy_on_a_shared_transport_fails)
+{
+    // arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_CreateWithTransport(&TEST_DEVICE_CONFIG);
+    IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+    size_t retryTimeoutLimitInSeconds;
+    mocks.ResetAllCalls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetRetryPolicy(handle, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetRetryPolicy(handle, &retryPolicy, &retryTimeoutLimitInSeconds));
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, (int)retryPolicy);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_LL_02_111: [ If retryPolicy is not one of the IOTHUB_CLIENT_RETRY_POLICY values then IoTHubClient_LL_SetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetRetryPolicy_with_unknown_policy_fails)
+{
+    // arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetRetryPolicy(handle, (IOTHUB_CLIENT_RETRY_POLICY)(IOTHUB_CLIENT_RETRY_RANDOM + 1), 10);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_LL_02_112: [ IoTHubClient_LL_SetRetryPolicy shall pass the policy and the timeout limit to the transport by calling _SetRetryPolicy. ]*/
+/* Tests_SRS_IOTHUBCLIENT_LL_25_118: [**IoTHubClient_LL_SetRetryPolicy shall save connection retry policies specified by the user to retryPolicy in struct IOTHUB_CLIENT_LL_HANDLE_DATA**]*/
+/* Tests_SRS_IOTHUBCLIENT_LL_25_119: [**IoTHubClient_LL_SetRetryPolicy shall save retryTimeoutLimitinSeconds in seconds to retryTimeout in struct IOTHUB_CLIENT_LL_HANDLE_DATA**]*/
+/* Tests_SRS_IOTHUBCLIENT_LL_25_121: [**IoTHubClient_LL_GetRetryPolicy shall retrieve connection retry policy from retryPolicy in struct IOTHUB_CLIENT_LL_HANDLE_DATA**]*/
+/* Tests_SRS_IOTHUBCLIENT_LL_25_122: [**IoTHubClient_LL_GetRetryPolicy shall retrieve retryTimeoutLimit in seconds from retryTimeoutinSeconds in struct IOTHUB_CLIENT_LL_HANDLE_DATA**]*/
+TEST_FUNCTION(IoTHubClient_LL_SetRetryPolicy_succeeds)
+{
+    // arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+    size_t retryTimeoutLimitInSeconds;
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_SetRetryPolicy(IGNORED_PTR_ARG, IOTHUB_CLIENT_RETRY_INTERVAL, 10))
+        .IgnoreArgument(1);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetRetryPolicy(handle, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetRetryPolicy(handle, &retryPolicy, &retryTimeoutLimitInSeconds));
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_RETRY_INTERVAL, (int)retryPolicy);
+    ASSERT_ARE_EQUAL(size_t, 10, retryTimeoutLimitInSeconds);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_LL_02_113: [ If _SetRetryPolicy fails then IoTHubClient_LL_SetRetryPolicy shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetRetryPolicy_fails_when_transport_SetRetryPolicy_fails)
+{
+    // arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+    size_t retryTimeoutLimitInSeconds;
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_SetRetryPolicy(IGNORED_PTR_ARG, IOTHUB_CLIENT_RETRY_INTERVAL, 10))
+        .IgnoreArgument(1)
+        .SetReturn(1);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetRetryPolicy(handle, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetRetryPolicy(handle, &retryPolicy, &retryTimeoutLimitInSeconds));
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, (int)retryPolicy);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_LL_25_120: [**IoTHubClient_LL_GetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL iotHubClientHandle or retryPolicy or retryTimeoutLimitinSeconds parameters**]*/
+TEST_FUNCTION(IoTHubClient_LL_GetRetryPolicy_with_NULL_arguments_fails)
+{
+    // arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+    size_t retryTimeoutLimitInSeconds;
+    mocks.ResetAllCalls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result1 = IoTHubClient_LL_GetRetryPolicy(NULL, &retryPolicy, &retryTimeoutLimitInSeconds);
+    IOTHUB_CLIENT_RESULT result2 = IoTHubClient_LL_GetRetryPolicy(handle, NULL, &retryTimeoutLimitInSeconds);
+    IOTHUB_CLIENT_RESULT result3 = IoTHubClient_LL_GetRetryPolicy(handle, &retryPolicy, NULL);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result1);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result2);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result3);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_LL_25_123: [**If user did not set the policy and timeout values by calling IoTHubClient_LL_SetRetryPolicy then IoTHubClient_LL_GetRetryPolicy shall return default values**]*/
+/* Tests_SRS_IOTHUBCLIENT_LL_02_114: [ By default the retry policy shall be IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER with no timeout limit (retryTimeoutinSeconds 0). ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetRetryPolicy_returns_the_defaults)
+{
+    // arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+    size_t retryTimeoutLimitInSeconds;
+    mocks.ResetAllCalls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetRetryPolicy(handle, &retryPolicy, &retryTimeoutLimitInSeconds);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, (int)retryPolicy);
+    ASSERT_ARE_EQUAL(size_t, 0, retryTimeoutLimitInSeconds);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
 /*Tests_SRS_IOTHUBCLIENT_LL_02_034: [If iotHubClientHandle is NULL then IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.]*/
 TEST_FUNCTION(IoTHubClient_LL_SetOption_with_NULL_handle_fails)
 {
@@ -4536,5 +4899,1637 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_with_NULL_source_and_size_greater_tha
 }
 #endif 
 
-END_TEST_SUITE(iothubclient_ll_ut)
+static PERSISTENT_QUEUE_CONFIG TEST_PERSISTENT_QUEUE_CONFIG =
+{
+    "queueDirectory",                       /*directory*/
+    0,                                      /*maxBytes*/
+    0,                                      /*maxMessages*/
+    0,                                      /*segmentSize*/
+    PERSISTENT_QUEUE_OVERFLOW_REJECT,       /*overflowPolicy*/
+    0,                                      /*blockTimeoutInMilliseconds*/
+    0                                       /*maxMessagesInMemory*/
+};
+
+static size_t countWaitingToSend(void)
+{
+    size_t result = 0;
+    PDLIST_ENTRY current = g_waitingToSend->Flink;
+    while (current != g_waitingToSend)
+    {
+        result++;
+        current = current->Flink;
+    }
+    return result;
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_118: [ OPTION_PERSISTENT_QUEUE - value is a pointer to a PERSISTENT_QUEUE_CONFIG. IoTHubClient_LL_SetOption shall create the persistent queue with persistent_queue_create, recovering the messages a previous run left in the directory. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_persistent_queue_succeeds)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_create(&TEST_PERSISTENT_QUEUE_CONFIG));
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_get_range(TEST_PERSISTENT_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(mocks, DList_InitializeListHead(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_119: [ If the persistent queue is already set or persistent_queue_create fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_persistent_queue_fails_when_persistent_queue_create_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_create(&TEST_PERSISTENT_QUEUE_CONFIG))
+        .SetReturn((PERSISTENT_QUEUE_HANDLE)NULL);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_119: [ If the persistent queue is already set or persistent_queue_create fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_persistent_queue_twice_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_121: [ If a persistent queue is set, IoTHubClient_LL_SendEventAsync shall append the message to it with persistent_queue_append_message instead of cloning it. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_persistent_queue_appends_the_message)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*stamps the event for the confirmation latency*/
+        .IgnoreAllArguments();
+
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_append_message(TEST_PERSISTENT_QUEUE_HANDLE, TEST_DEVICEMESSAGE_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_get_range(TEST_PERSISTENT_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_122: [ If persistent_queue_append_message returns PERSISTENT_QUEUE_FULL, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_QUEUE_FULL. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_persistent_queue_full_returns_IOTHUB_CLIENT_QUEUE_FULL)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*stamps the event for the confirmation latency*/
+        .IgnoreAllArguments();
+
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_append_message(TEST_PERSISTENT_QUEUE_HANDLE, TEST_DEVICEMESSAGE_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument(3)
+        .SetReturn(PERSISTENT_QUEUE_FULL);
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_QUEUE_FULL, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_123: [ If persistent_queue_append_message fails, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_persistent_queue_fails_when_append_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*stamps the event for the confirmation latency*/
+        .IgnoreAllArguments();
+
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_append_message(TEST_PERSISTENT_QUEUE_HANDLE, TEST_DEVICEMESSAGE_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument(3)
+        .SetReturn(PERSISTENT_QUEUE_ERROR);
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_120: [ IoTHubClient_LL_DoWork shall move persisted messages to waitingToSend, oldest first, keeping at most maxMessagesInMemory of them in memory. ]*/
+TEST_FUNCTION(IoTHubClient_LL_DoWork_moves_persisted_messages_to_waitingToSend)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_read_message(TEST_PERSISTENT_QUEUE_HANDLE, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(3)
+        .IgnoreArgument(4);
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_read_message(TEST_PERSISTENT_QUEUE_HANDLE, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(3)
+        .IgnoreArgument(4);
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_read_message(TEST_PERSISTENT_QUEUE_HANDLE, 3, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(3)
+        .IgnoreArgument(4);
+
+    ///act
+    IoTHubClient_LL_DoWork(handle);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 2, countWaitingToSend());
+    ASSERT_ARE_EQUAL(void_ptr, TEST_PERSISTED_MESSAGE_HANDLE(1), containingRecord(g_waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry)->messageHandle);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_PERSISTED_MESSAGE_HANDLE(2), containingRecord(g_waitingToSend->Blink, IOTHUB_MESSAGE_LIST, entry)->messageHandle);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_120: [ IoTHubClient_LL_DoWork shall move persisted messages to waitingToSend, oldest first, keeping at most maxMessagesInMemory of them in memory. ]*/
+TEST_FUNCTION(IoTHubClient_LL_DoWork_keeps_at_most_maxMessagesInMemory_persisted_messages_in_memory)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    PERSISTENT_QUEUE_CONFIG config = TEST_PERSISTENT_QUEUE_CONFIG;
+    config.maxMessagesInMemory = 1;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &config);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    mocks.ResetAllCalls();
+
+    ///act
+    IoTHubClient_LL_DoWork(handle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 1, countWaitingToSend());
+    ASSERT_ARE_EQUAL(void_ptr, TEST_PERSISTED_MESSAGE_HANDLE(1), containingRecord(g_waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry)->messageHandle);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_127: [ When a persisted message is completed with any result but IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY its record shall be acknowledged with persistent_queue_ack before the user callback is called. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_acks_the_persisted_message)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    DLIST_ENTRY completed;
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    IoTHubClient_LL_DoWork(handle);
+    BASEIMPLEMENTATION::DList_InitializeListHead(&completed);
+    BASEIMPLEMENTATION::DList_InsertTailList(&completed, BASEIMPLEMENTATION::DList_RemoveHeadList(g_waitingToSend));
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_ack(TEST_PERSISTENT_QUEUE_HANDLE, 1));
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Destroy(TEST_PERSISTED_MESSAGE_HANDLE(1)));
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &completed, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_127: [ When a persisted message is completed with any result but IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY its record shall be acknowledged with persistent_queue_ack before the user callback is called. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_acks_the_persisted_message_on_error)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    DLIST_ENTRY completed;
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    IoTHubClient_LL_DoWork(handle);
+    BASEIMPLEMENTATION::DList_InitializeListHead(&completed);
+    BASEIMPLEMENTATION::DList_InsertTailList(&completed, BASEIMPLEMENTATION::DList_RemoveHeadList(g_waitingToSend));
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_ack(TEST_PERSISTENT_QUEUE_HANDLE, 1));
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, (void*)1));
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &completed, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_128: [ IoTHubClient_LL_Destroy shall complete the persisted messages not yet handed to the transport with IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY and close the persistent queue, leaving the messages that were not acknowledged on disk. ]*/
+TEST_FUNCTION(IoTHubClient_LL_Destroy_completes_the_persisted_messages_without_acking_them)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, (void*)1));
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_destroy(TEST_PERSISTENT_QUEUE_HANDLE));
+    EXPECTED_CALL(mocks, persistent_queue_ack(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .NeverInvoked();
+
+    ///act
+    IoTHubClient_LL_Destroy(handle);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_129: [ If persisted messages are still waiting to be handed to the transport, IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetSendStatus_with_persisted_messages_not_loaded_is_BUSY)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_STATUS status = IOTHUB_CLIENT_SEND_STATUS_IDLE;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    mocks.ResetAllCalls();
+
+    EXPECTED_CALL(mocks, FAKE_IoTHubTransport_GetSendStatus(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .NeverInvoked();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendStatus(handle, &status);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_STATUS, IOTHUB_CLIENT_SEND_STATUS_BUSY, status);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+static IOTHUB_CLIENT_QUEUE_LIMITS TEST_QUEUE_LIMITS_REJECT =
+{
+    2,                                      /*maxMessages*/
+    0,                                      /*maxBytes*/
+    IOTHUB_CLIENT_QUEUE_OVERFLOW_REJECT,    /*overflowPolicy*/
+    0                                       /*blockTimeoutInMilliseconds*/
+};
+
+static IOTHUB_CLIENT_QUEUE_LIMITS TEST_QUEUE_LIMITS_DROP_OLDEST =
+{
+    0,                                      /*maxMessages*/
+    2 * TEST_MESSAGE_SIZE,                  /*maxBytes*/
+    IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST, /*overflowPolicy*/
+    0                                       /*blockTimeoutInMilliseconds*/
+};
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_130: [ OPTION_OUTBOUND_QUEUE_LIMITS - value is a pointer to an IOTHUB_CLIENT_QUEUE_LIMITS. IoTHubClient_LL_SetOption shall copy the limits, the events sent from then on are counted against them. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_queue_limits_succeeds)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    size_t messageCount = 1;
+    size_t byteCount = 1;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &TEST_QUEUE_LIMITS_REJECT);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetOutboundQueueSize(handle, &messageCount, &byteCount));
+    ASSERT_ARE_EQUAL(size_t, 0, messageCount);
+    ASSERT_ARE_EQUAL(size_t, 0, byteCount);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_131: [ If overflowPolicy is not an IOTHUB_CLIENT_QUEUE_OVERFLOW_POLICY value, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_queue_limits_with_invalid_policy_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_QUEUE_LIMITS limits = TEST_QUEUE_LIMITS_REJECT;
+    limits.overflowPolicy = (IOTHUB_CLIENT_QUEUE_OVERFLOW_POLICY)42;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &limits);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_133: [ If the outbound queue is bounded, IoTHubClient_LL_SendEventAsync shall count the event and the size of its content, and complete it through a callback that stops counting it before calling eventConfirmationCallback. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_outbound_queue_limits_counts_the_event)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    size_t messageCount = 0;
+    size_t byteCount = 0;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &TEST_QUEUE_LIMITS_REJECT);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*stamps the event for the confirmation latency*/
+        .IgnoreAllArguments();
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_DEVICEMESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_DEVICEMESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Clone(TEST_DEVICEMESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetPriority(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetOutboundQueueSize(handle, &messageCount, &byteCount));
+    ASSERT_ARE_EQUAL(size_t, 1, messageCount);
+    ASSERT_ARE_EQUAL(size_t, TEST_MESSAGE_SIZE, byteCount);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_135: [ If the event does not fit under maxMessages and maxBytes and the policy is IOTHUB_CLIENT_QUEUE_OVERFLOW_REJECT or IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_QUEUE_FULL. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_outbound_queue_limits_REJECT_returns_IOTHUB_CLIENT_QUEUE_FULL)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &TEST_QUEUE_LIMITS_REJECT);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    mocks.ResetAllCalls();
+
+    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .NeverInvoked();
+    EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, IGNORED_PTR_ARG))
+        .NeverInvoked();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)3);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_QUEUE_FULL, result);
+    ASSERT_ARE_EQUAL(size_t, 2, countWaitingToSend());
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_134: [ If the content of the event alone is bigger than maxBytes, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_QUEUE_FULL. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_event_bigger_than_maxBytes_returns_IOTHUB_CLIENT_QUEUE_FULL)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_QUEUE_LIMITS limits = TEST_QUEUE_LIMITS_DROP_OLDEST;
+    limits.maxBytes = TEST_MESSAGE_SIZE - 1;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &limits);
+    mocks.ResetAllCalls();
+
+    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .NeverInvoked();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_QUEUE_FULL, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_136: [ If the event does not fit and the policy is IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST, IoTHubClient_LL_SendEventAsync shall complete the counted events still in waitingToSend with IOTHUB_CLIENT_CONFIRMATION_ERROR until the event fits, the events of the lowest priority first and the oldest first within a priority. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_138: [ When an event counted in the outbound queue is completed, whichever way, it shall stop being counted before the user callback is called. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_outbound_queue_limits_DROP_OLDEST_completes_the_oldest_event)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    size_t messageCount = 0;
+    size_t byteCount = 0;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &TEST_QUEUE_LIMITS_DROP_OLDEST);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, (void*)1));
+    EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, (void*)2))
+        .NeverInvoked();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)3);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 2, countWaitingToSend());
+    mocks.AssertActualAndExpectedCalls();
+    (void)IoTHubClient_LL_GetOutboundQueueSize(handle, &messageCount, &byteCount);
+    ASSERT_ARE_EQUAL(size_t, 2, messageCount);
+    ASSERT_ARE_EQUAL(size_t, 2 * TEST_MESSAGE_SIZE, byteCount);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_137: [ If the event still does not fit because the transport holds the other events, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_QUEUE_FULL. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_outbound_queue_limits_DROP_OLDEST_does_not_drop_events_in_flight)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    DLIST_ENTRY inFlight;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &TEST_QUEUE_LIMITS_DROP_OLDEST);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    BASEIMPLEMENTATION::DList_InitializeListHead(&inFlight);
+    BASEIMPLEMENTATION::DList_InsertTailList(&inFlight, BASEIMPLEMENTATION::DList_RemoveHeadList(g_waitingToSend));
+    BASEIMPLEMENTATION::DList_InsertTailList(&inFlight, BASEIMPLEMENTATION::DList_RemoveHeadList(g_waitingToSend));
+    mocks.ResetAllCalls();
+
+    EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, IGNORED_PTR_ARG))
+        .NeverInvoked();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)3);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_QUEUE_FULL, result);
+    ASSERT_ARE_EQUAL(size_t, 0, countWaitingToSend());
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_SendComplete(handle, &inFlight, IOTHUB_CLIENT_CONFIRMATION_OK);
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_138: [ When an event counted in the outbound queue is completed, whichever way, it shall stop being counted before the user callback is called. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_stops_counting_the_event)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    size_t messageCount = 1;
+    size_t byteCount = 1;
+    DLIST_ENTRY completed;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &TEST_QUEUE_LIMITS_REJECT);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    BASEIMPLEMENTATION::DList_InitializeListHead(&completed);
+    BASEIMPLEMENTATION::DList_InsertTailList(&completed, BASEIMPLEMENTATION::DList_RemoveHeadList(g_waitingToSend));
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &completed, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetOutboundQueueSize(handle, &messageCount, &byteCount));
+    ASSERT_ARE_EQUAL(size_t, 0, messageCount);
+    ASSERT_ARE_EQUAL(size_t, 0, byteCount);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_139: [ If iotHubClientHandle, messageCount or byteCount is NULL, IoTHubClient_LL_GetOutboundQueueSize shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetOutboundQueueSize_with_NULL_arguments_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    size_t messageCount;
+    size_t byteCount;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &TEST_QUEUE_LIMITS_REJECT);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result1 = IoTHubClient_LL_GetOutboundQueueSize(NULL, &messageCount, &byteCount);
+    IOTHUB_CLIENT_RESULT result2 = IoTHubClient_LL_GetOutboundQueueSize(handle, NULL, &byteCount);
+    IOTHUB_CLIENT_RESULT result3 = IoTHubClient_LL_GetOutboundQueueSize(handle, &messageCount, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result1);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result2);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result3);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_140: [ If a persistent queue is set, IoTHubClient_LL_GetOutboundQueueSize shall return the number of records and of bytes the persistent queue keeps on disk, as returned by persistent_queue_get_usage. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetOutboundQueueSize_with_persistent_queue_returns_its_usage)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    size_t messageCount = 0;
+    size_t byteCount = 0;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_get_usage(TEST_PERSISTENT_QUEUE_HANDLE, &messageCount, &byteCount));
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetOutboundQueueSize(handle, &messageCount, &byteCount);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 1, messageCount);
+    ASSERT_ARE_EQUAL(size_t, TEST_MESSAGE_SIZE, byteCount);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_141: [ If persistent_queue_get_usage fails, IoTHubClient_LL_GetOutboundQueueSize shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetOutboundQueueSize_fails_when_persistent_queue_get_usage_fails)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    size_t messageCount;
+    size_t byteCount;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_get_usage(TEST_PERSISTENT_QUEUE_HANDLE, &messageCount, &byteCount))
+        .SetFailReturn(__LINE__);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetOutboundQueueSize(handle, &messageCount, &byteCount);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_132: [ By default, the outbound queue shall not be bounded. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_143: [ Otherwise IoTHubClient_LL_GetOutboundQueueSize shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetOutboundQueueSize_without_limits_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    size_t messageCount;
+    size_t byteCount;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetOutboundQueueSize(handle, &messageCount, &byteCount);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+static void* waitingToSendContext(size_t index)
+{
+    PDLIST_ENTRY current = g_waitingToSend->Flink;
+    while (index > 0)
+    {
+        current = current->Flink;
+        index--;
+    }
+    return containingRecord(current, IOTHUB_MESSAGE_LIST, entry)->context;
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_144: [ By default, the priority weights shall be 1 for IOTHUB_MESSAGE_PRIORITY_LOW, 4 for IOTHUB_MESSAGE_PRIORITY_NORMAL and 16 for IOTHUB_MESSAGE_PRIORITY_HIGH. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_145: [ IoTHubClient_LL_SendEventAsync shall insert the event in waitingToSend in weighted fair order: each priority advances its own tag by the inverse of its weight per event, starting no earlier than the tag of the first event in waitingToSend, and the event is inserted after all events with a tag not greater than its own. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_puts_a_HIGH_priority_event_after_the_first_NORMAL_event)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)3);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_HIGH_PRIORITY_MESSAGE_HANDLE, eventConfirmationCallback, (void*)4);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 4, countWaitingToSend());
+    ASSERT_ARE_EQUAL(void_ptr, (void*)1, waitingToSendContext(0));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)4, waitingToSendContext(1));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)2, waitingToSendContext(2));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)3, waitingToSendContext(3));
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_145: [ IoTHubClient_LL_SendEventAsync shall insert the event in waitingToSend in weighted fair order: each priority advances its own tag by the inverse of its weight per event, starting no earlier than the tag of the first event in waitingToSend, and the event is inserted after all events with a tag not greater than its own. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_puts_a_LOW_priority_event_after_the_NORMAL_events)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_LOW_PRIORITY_MESSAGE_HANDLE, eventConfirmationCallback, (void*)3);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)4);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)1, waitingToSendContext(0));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)2, waitingToSendContext(1));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)4, waitingToSendContext(2));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)3, waitingToSendContext(3));
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_147: [ OPTION_PRIORITY_WEIGHTS - value is a pointer to an IOTHUB_CLIENT_PRIORITY_WEIGHTS. IoTHubClient_LL_SetOption shall copy the weights, the events sent from then on are ordered by them. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_priority_weights_succeeds)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_PRIORITY_WEIGHTS weights = { 1, 1, 1 };
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_PRIORITY_WEIGHTS, &weights);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)3);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_HIGH_PRIORITY_MESSAGE_HANDLE, eventConfirmationCallback, (void*)4);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)1, waitingToSendContext(0));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)2, waitingToSendContext(1));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)4, waitingToSendContext(2));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)3, waitingToSendContext(3));
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_148: [ If any weight is 0 or greater than 1000, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_priority_weights_with_a_0_weight_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_PRIORITY_WEIGHTS weights = { 0, 4, 16 };
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_PRIORITY_WEIGHTS, &weights);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_148: [ If any weight is 0 or greater than 1000, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_priority_weights_with_a_weight_over_1000_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_PRIORITY_WEIGHTS weights = { 1, 4, 1001 };
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_PRIORITY_WEIGHTS, &weights);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_136: [ If the event does not fit and the policy is IOTHUB_CLIENT_QUEUE_OVERFLOW_DROP_OLDEST, IoTHubClient_LL_SendEventAsync shall complete the counted events still in waitingToSend with IOTHUB_CLIENT_CONFIRMATION_ERROR until the event fits, the events of the lowest priority first and the oldest first within a priority. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_outbound_queue_limits_DROP_OLDEST_completes_the_LOW_priority_event_first)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &TEST_QUEUE_LIMITS_DROP_OLDEST);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_LOW_PRIORITY_MESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, (void*)2));
+    EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, (void*)1))
+        .NeverInvoked();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)3);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 2, countWaitingToSend());
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_146: [ IoTHubClient_LL_DoWork shall not reorder waitingToSend: the tag of an event is fixed when it is inserted, a change of the weights does not move the events already waiting and the transports give events back at the head of waitingToSend. ]*/
+TEST_FUNCTION(IoTHubClient_LL_DoWork_does_not_reorder_waitingToSend_when_the_weights_change)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_PRIORITY_WEIGHTS weights = { 1000, 1, 1 };
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_HIGH_PRIORITY_MESSAGE_HANDLE, eventConfirmationCallback, (void*)3);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PRIORITY_WEIGHTS, &weights);
+    mocks.ResetAllCalls();
+
+    ///act
+    IoTHubClient_LL_DoWork(handle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 3, countWaitingToSend());
+    ASSERT_ARE_EQUAL(void_ptr, (void*)1, waitingToSendContext(0));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)3, waitingToSendContext(1));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)2, waitingToSendContext(2));
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+static const unsigned char TEST_COMPRESSION_DICTIONARY[] = { '{', '"', 'a', '"', ':', '1', '}' };
+static IOTHUB_CLIENT_COMPRESSION_CONFIG TEST_COMPRESSION_CONFIG =
+{
+    IOTHUB_CLIENT_COMPRESSION_LZ4,
+    TEST_COMPRESSION_DICTIONARY,
+    sizeof(TEST_COMPRESSION_DICTIONARY),
+    "dictionary-1",
+    0
+};
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_149: [ By default, the events shall not be compressed. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_by_default_does_not_compress)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Clone(TEST_DEVICEMESSAGE_HANDLE));
+    EXPECTED_CALL(mocks, compression_compress_message(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .NeverInvoked();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_150: [ OPTION_COMPRESSION - value is a pointer to an IOTHUB_CLIENT_COMPRESSION_CONFIG. IoTHubClient_LL_SetOption shall create a compressor with compression_create for IOTHUB_CLIENT_COMPRESSION_LZ4 and destroy the current compressor, if any, for IOTHUB_CLIENT_COMPRESSION_NONE. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_compression_LZ4_creates_the_compressor)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, mallocAndStrcpy_s(IGNORED_PTR_ARG, "dictionary-1"))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, compression_create(TEST_COMPRESSION_DICTIONARY, sizeof(TEST_COMPRESSION_DICTIONARY)));
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &TEST_COMPRESSION_CONFIG);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_150: [ OPTION_COMPRESSION - value is a pointer to an IOTHUB_CLIENT_COMPRESSION_CONFIG. IoTHubClient_LL_SetOption shall create a compressor with compression_create for IOTHUB_CLIENT_COMPRESSION_LZ4 and destroy the current compressor, if any, for IOTHUB_CLIENT_COMPRESSION_NONE. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_compression_NONE_destroys_the_compressor)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_COMPRESSION_CONFIG none = { IOTHUB_CLIENT_COMPRESSION_NONE, NULL, 0, NULL, 0 };
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &TEST_COMPRESSION_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, compression_destroy(TEST_COMPRESSION_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &none);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_151: [ If the algorithm is unknown or dictionary is NULL and dictionarySize is not 0, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_compression_with_an_unknown_algorithm_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_COMPRESSION_CONFIG config = TEST_COMPRESSION_CONFIG;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    config.algorithm = (IOTHUB_CLIENT_COMPRESSION_ALGORITHM)42;
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &config);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_151: [ If the algorithm is unknown or dictionary is NULL and dictionarySize is not 0, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_compression_with_NULL_dictionary_and_non_zero_size_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_COMPRESSION_CONFIG config = TEST_COMPRESSION_CONFIG;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    config.dictionary = NULL;
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &config);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_152: [ If creating the compressor fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current compressor. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_compression_fails_when_compression_create_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, mallocAndStrcpy_s(IGNORED_PTR_ARG, "dictionary-1"))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, compression_create(TEST_COMPRESSION_DICTIONARY, sizeof(TEST_COMPRESSION_DICTIONARY)))
+        .SetReturn((COMPRESSION_HANDLE)NULL);
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &TEST_COMPRESSION_CONFIG);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_153: [ If compression is set and the content of the event is at least minimumSize bytes, IoTHubClient_LL_SendEventAsync shall hand to the transport, or to the persistent queue, the copy made by compression_compress_message instead of a clone. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_compression_hands_the_compressed_copy_to_the_transport)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &TEST_COMPRESSION_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, compression_compress_message(TEST_COMPRESSION_HANDLE, TEST_DEVICEMESSAGE_HANDLE, "dictionary-1"));
+    EXPECTED_CALL(mocks, IoTHubMessage_Clone(IGNORED_PTR_ARG))
+        .NeverInvoked();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_COMPRESSED_MESSAGE_HANDLE, containingRecord(g_waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry)->messageHandle);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_153: [ If compression is set and the content of the event is at least minimumSize bytes, IoTHubClient_LL_SendEventAsync shall hand to the transport, or to the persistent queue, the copy made by compression_compress_message instead of a clone. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_compression_clones_an_event_under_minimumSize)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_COMPRESSION_CONFIG config = TEST_COMPRESSION_CONFIG;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    config.minimumSize = TEST_MESSAGE_SIZE + 1;
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &config);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Clone(TEST_DEVICEMESSAGE_HANDLE));
+    EXPECTED_CALL(mocks, compression_compress_message(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .NeverInvoked();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_153: [ If compression is set and the content of the event is at least minimumSize bytes, IoTHubClient_LL_SendEventAsync shall hand to the transport, or to the persistent queue, the copy made by compression_compress_message instead of a clone. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_compression_fails_when_compression_compress_message_fails)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &TEST_COMPRESSION_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, compression_compress_message(TEST_COMPRESSION_HANDLE, TEST_DEVICEMESSAGE_HANDLE, "dictionary-1"))
+        .SetReturn((IOTHUB_MESSAGE_HANDLE)NULL);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(size_t, 0, countWaitingToSend());
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_154: [ If compression is set, IoTHubClient_LL_SendEventAsync shall append to the persistent queue the compressed copy of the event and destroy the copy afterwards. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_compression_and_persistent_queue_appends_the_compressed_copy)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_PERSISTENT_QUEUE, &TEST_PERSISTENT_QUEUE_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &TEST_COMPRESSION_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, compression_compress_message(TEST_COMPRESSION_HANDLE, TEST_DEVICEMESSAGE_HANDLE, "dictionary-1"));
+    STRICT_EXPECTED_CALL(mocks, persistent_queue_append_message(TEST_PERSISTENT_QUEUE_HANDLE, TEST_COMPRESSED_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Destroy(TEST_COMPRESSED_MESSAGE_HANDLE));
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClient_LL_Destroy_destroys_the_compressor)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_COMPRESSION, &TEST_COMPRESSION_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, compression_destroy(TEST_COMPRESSION_HANDLE));
+
+    ///act
+    IoTHubClient_LL_Destroy(handle);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+}
+
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_156: [ If iotHubClientHandle is NULL, IoTHubClient_LL_SetEventConfirmationBatchCallback shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetEventConfirmationBatchCallback_with_NULL_handle_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetEventConfirmationBatchCallback(NULL, eventConfirmationBatchCallback, (void*)4);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_157: [ Otherwise IoTHubClient_LL_SetEventConfirmationBatchCallback shall remember batchCallback and userContextCallback, a NULL batchCallback turning the batching off, and return IOTHUB_CLIENT_OK. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_158: [ If a batch callback is set, IoTHubClient_LL_SendEventAsync shall accept a NULL eventConfirmationCallback with a non-NULL userContextCallback. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_NULL_eventConfirmationCallback_and_non_NULL_context_succeeds_with_a_batch_callback)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_RESULT setResult = IoTHubClient_LL_SetEventConfirmationBatchCallback(handle, eventConfirmationBatchCallback, (void*)4);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, NULL, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, setResult);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 1, countWaitingToSend());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_157: [ Otherwise IoTHubClient_LL_SetEventConfirmationBatchCallback shall remember batchCallback and userContextCallback, a NULL batchCallback turning the batching off, and return IOTHUB_CLIENT_OK. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetEventConfirmationBatchCallback_with_NULL_turns_the_batching_off)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetEventConfirmationBatchCallback(handle, eventConfirmationBatchCallback, (void*)4);
+    IOTHUB_CLIENT_RESULT setResult = IoTHubClient_LL_SetEventConfirmationBatchCallback(handle, NULL, NULL);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, NULL, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, setResult);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_159: [ When an event sent without eventConfirmationCallback and with a non-NULL userContextCallback is completed, whichever way, and a batch callback is set, its userContextCallback and result shall be added to the batch of the current call instead. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_160: [ At the end of IoTHubClient_LL_SendComplete, IoTHubClient_LL_DoWork, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_Destroy, the confirmations added to the batch (if any) shall be given to the batch callback in one call, oldest first. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_gives_the_batched_confirmations_in_one_call)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetEventConfirmationBatchCallback(handle, eventConfirmationBatchCallback, (void*)4);
+    DLIST_ENTRY temp;
+    DList_InitializeListHead(&temp);
+
+    IOTHUB_MESSAGE_LIST* one = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this is SendEvent wannabe*/
+    one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
+    one->callback = NULL;
+    one->context = (void*)1;
+    DList_InsertTailList(&temp, &(one->entry));
+
+    IOTHUB_MESSAGE_LIST* two = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this one keeps its own callback*/
+    two->messageHandle = (IOTHUB_MESSAGE_HANDLE)2;
+    two->callback = eventConfirmationCallback;
+    two->context = (void*)2;
+    DList_InsertTailList(&temp, &(two->entry));
+
+    IOTHUB_MESSAGE_LIST* three = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this is SendEvent wannabe*/
+    three->messageHandle = (IOTHUB_MESSAGE_HANDLE)3;
+    three->callback = NULL;
+    three->context = (void*)3;
+    DList_InsertTailList(&temp, &(three->entry));
+
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)2));
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationBatchCallback(IGNORED_PTR_ARG, 2, (void*)4))
+        .IgnoreArgument(1);
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &temp, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 2, g_batchCount);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)1, g_batch[0].userContextCallback);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_CONFIRMATION_OK, (int)g_batch[0].result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)3, g_batch[1].userContextCallback);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_CONFIRMATION_OK, (int)g_batch[1].result);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_160: [ At the end of IoTHubClient_LL_SendComplete, IoTHubClient_LL_DoWork, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_Destroy, the confirmations added to the batch (if any) shall be given to the batch callback in one call, oldest first. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_without_batched_events_does_not_call_the_batch_callback)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetEventConfirmationBatchCallback(handle, eventConfirmationBatchCallback, (void*)4);
+    DLIST_ENTRY temp;
+    DList_InitializeListHead(&temp);
+
+    IOTHUB_MESSAGE_LIST* one = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this is SendEvent wannabe*/
+    one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
+    one->callback = eventConfirmationCallback;
+    one->context = (void*)1;
+    DList_InsertTailList(&temp, &(one->entry));
+
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationBatchCallback(IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments()
+        .NeverInvoked();
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &temp, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_159: [ When an event sent without eventConfirmationCallback and with a non-NULL userContextCallback is completed, whichever way, and a batch callback is set, its userContextCallback and result shall be added to the batch of the current call instead. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_160: [ At the end of IoTHubClient_LL_SendComplete, IoTHubClient_LL_DoWork, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_Destroy, the confirmations added to the batch (if any) shall be given to the batch callback in one call, oldest first. ]*/
+TEST_FUNCTION(IoTHubClient_LL_Destroy_gives_the_waiting_events_to_the_batch_callback_in_one_call)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetEventConfirmationBatchCallback(handle, eventConfirmationBatchCallback, (void*)4);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, NULL, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, NULL, (void*)2);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, NULL, (void*)3);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationBatchCallback(IGNORED_PTR_ARG, 3, (void*)4))
+        .IgnoreArgument(1);
+
+    ///act
+    IoTHubClient_LL_Destroy(handle);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 3, g_batchCount);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)1, g_batch[0].userContextCallback);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)2, g_batch[1].userContextCallback);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)3, g_batch[2].userContextCallback);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, (int)g_batch[2].result);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_159: [ When an event sent without eventConfirmationCallback and with a non-NULL userContextCallback is completed, whichever way, and a batch callback is set, its userContextCallback and result shall be added to the batch of the current call instead. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_160: [ At the end of IoTHubClient_LL_SendComplete, IoTHubClient_LL_DoWork, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_Destroy, the confirmations added to the batch (if any) shall be given to the batch callback in one call, oldest first. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_gives_the_dropped_oldest_event_to_the_batch_callback)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &TEST_QUEUE_LIMITS_DROP_OLDEST);
+    (void)IoTHubClient_LL_SetEventConfirmationBatchCallback(handle, eventConfirmationBatchCallback, (void*)4);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, NULL, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, NULL, (void*)2);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, eventConfirmationBatchCallback(IGNORED_PTR_ARG, 1, (void*)4))
+        .IgnoreArgument(1);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, NULL, (void*)3);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 1, g_batchCount);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)1, g_batch[0].userContextCallback);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_CONFIRMATION_ERROR, (int)g_batch[0].result);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_170: [ If iotHubClientHandle or snapshot is NULL, IoTHubClient_LL_GetMetrics shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetMetrics_with_NULL_handle_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetMetrics(NULL, &snapshot);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_170: [ If iotHubClientHandle or snapshot is NULL, IoTHubClient_LL_GetMetrics shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetMetrics_with_NULL_snapshot_fails)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetMetrics(handle, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_162: [ IoTHubClient_LL_Create and IoTHubClient_LL_CreateWithTransport shall start all the metrics of the client at 0. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_171: [ Otherwise IoTHubClient_LL_GetMetrics shall copy the metrics of the client to snapshot by calling iothub_client_metrics_get_snapshot and return IOTHUB_CLIENT_OK. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetMetrics_after_Create_returns_zeroes)
+{
+    ///arrange
+    CIoTHubClientLLMocks mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)memset(&snapshot, 0xAB, sizeof(snapshot));
+    mocks.ResetAllCalls();
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetMetrics(handle, &snapshot);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    mocks.AssertActualAndExpectedCalls();
+    for (size_t i = 0; i < IOTHUB_CLIENT_METRIC_COUNT; i++)
+    {
+        ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.values[i]);
+    }
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.sums[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE]);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_163: [ IoTHubClient_LL_Create shall give the metrics of the client to the transport in the metrics field of IOTHUBTRANSPORT_CONFIG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_Create_gives_the_metrics_to_the_transport)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+
+    ///act
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    ASSERT_IS_NOT_NULL(g_transportMetrics);
+    iothub_client_metrics_add(g_transportMetrics, IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS, 1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetMetrics(handle, &snapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 1, snapshot.values[IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS]);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_164: [ Every event inserted in waitingToSend shall be counted in IOTHUB_CLIENT_METRIC_EVENTS_QUEUED right away. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_counts_the_queued_event)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    ///act
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetMetrics(handle, &snapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 2, snapshot.values[IOTHUB_CLIENT_METRIC_EVENTS_QUEUED]);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_165: [ Every event confirmed to the application, whichever way, shall be counted once in IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_OK, _BECAUSE_DESTROY, _MESSAGE_TIMEOUT or _ERROR, according to its result. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_168: [ IoTHubClient_LL_SendComplete shall record the number of events it completed in IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE, unless there was none. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_counts_the_confirmations_and_the_batch_size)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    DLIST_ENTRY temp;
+    DList_InitializeListHead(&temp);
+
+    IOTHUB_MESSAGE_LIST* one = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this is SendEvent wannabe*/
+    one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
+    one->callback = eventConfirmationCallback;
+    one->context = (void*)1;
+    one->ms_queuedAt = 0;
+    DList_InsertTailList(&temp, &(one->entry));
+
+    IOTHUB_MESSAGE_LIST* two = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this is SendEvent wannabe*/
+    two->messageHandle = (IOTHUB_MESSAGE_HANDLE)2;
+    two->callback = NULL;
+    two->context = NULL;
+    two->ms_queuedAt = 0;
+    DList_InsertTailList(&temp, &(two->entry));
+    mocks.ResetAllCalls();
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &temp, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetMetrics(handle, &snapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 2, snapshot.values[IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_ERROR]);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.values[IOTHUB_CLIENT_METRIC_EVENTS_CONFIRMED_OK]);
+    ASSERT_ARE_EQUAL(uint64_t, 1, snapshot.buckets[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE][2]);
+    ASSERT_ARE_EQUAL(uint64_t, 2, snapshot.sums[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE]);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_168: [ IoTHubClient_LL_SendComplete shall record the number of events it completed in IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE, unless there was none. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_empty_completed_does_not_record_a_batch)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    DLIST_ENTRY temp;
+    DList_InitializeListHead(&temp);
+    mocks.ResetAllCalls();
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &temp, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetMetrics(handle, &snapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.buckets[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE][0]);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.sums[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_BATCH_SIZE]);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_172: [ IoTHubClient_LL_SendComplete, through which every transport completes the events it took, shall remove every completed event from IOTHUB_CLIENT_METRIC_EVENTS_IN_FLIGHT right away. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_removes_the_completed_events_from_the_events_in_flight)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    DLIST_ENTRY taken;
+    DList_InitializeListHead(&taken);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)2);
+    while (!DList_IsListEmpty(g_waitingToSend)) /*this is the transport taking the events*/
+    {
+        PDLIST_ENTRY entry = DList_RemoveHeadList(g_waitingToSend);
+        DList_InsertTailList(&taken, entry);
+    }
+    IoTHubClient_LL_DoWork(handle);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetMetrics(handle, &snapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 2, snapshot.values[IOTHUB_CLIENT_METRIC_EVENTS_IN_FLIGHT]);
+    mocks.ResetAllCalls();
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &taken, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetMetrics(handle, &snapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.values[IOTHUB_CLIENT_METRIC_EVENTS_IN_FLIGHT]);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.values[IOTHUB_CLIENT_METRIC_EVENTS_QUEUED]);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_167: [ IoTHubClient_LL_SendComplete shall record in IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, for every event, the milliseconds between the tick read when the event was queued and the tick read when the event is completed. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_records_the_latency_between_the_queueing_and_the_completion)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    DLIST_ENTRY taken;
+    DList_InitializeListHead(&taken);
+    uint64_t queuedAt = 10;
+    uint64_t completedAt = 25;
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &queuedAt, sizeof(queuedAt));
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    DList_InsertTailList(&taken, DList_RemoveHeadList(g_waitingToSend)); /*this is the transport taking the event*/
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &completedAt, sizeof(completedAt));
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &taken, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetMetrics(handle, &snapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 15, snapshot.sums[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS]);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_167: [ IoTHubClient_LL_SendComplete shall record in IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS, for every event, the milliseconds between the tick read when the event was queued and the tick read when the event is completed. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_without_timeout_succeeds_when_the_tick_cannot_be_read_and_records_no_latency)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    DLIST_ENTRY taken;
+    DList_InitializeListHead(&taken);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments()
+        .SetFailReturn(__LINE__);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)1);
+    DList_InsertTailList(&taken, DList_RemoveHeadList(g_waitingToSend)); /*this is the transport taking the event*/
+    IoTHubClient_LL_SendComplete(handle, &taken, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetMetrics(handle, &snapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.buckets[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS][0]);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.sums[IOTHUB_CLIENT_HISTOGRAM_CONFIRMATION_LATENCY_MS]);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_169: [ IoTHubClient_LL_MessageCallback shall add 1 to IOTHUB_CLIENT_METRIC_MESSAGES_RECEIVED. ]*/
+TEST_FUNCTION(IoTHubClient_LL_MessageCallback_counts_the_received_message)
+{
+    ///arrange
+    CNiceCallComparer<CIoTHubClientLLMocks> mocks;
+    IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetMessageCallback(handle, messageCallback, (void*)11);
+    mocks.ResetAllCalls();
+
+    ///act
+    (void)IoTHubClient_LL_MessageCallback(handle, (IOTHUB_MESSAGE_HANDLE)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_LL_GetMetrics(handle, &snapshot));
+    ASSERT_ARE_EQUAL(uint64_t, 1, snapshot.values[IOTHUB_CLIENT_METRIC_MESSAGES_RECEIVED]);
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+END_TEST_SUITE(iothubclient_ll_ut)
@@ -19,6 +19,10 @@
 #include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "iothubtransport.h"
+#include "iothub_client_options.h"
+#include "iothub_client_persistent_queue.h"
+#include "iothub_client_ingress_queue.h"
+#include "iothub_client_callback_dispatcher.h"
 
 extern "C" int gballoc_init(void);
 extern "C" void gballoc_deinit(void);
@@ -60,6 +64,14 @@ static size_t howManyDoWorkCalls = 0;
 static size_t doWorkCallCount = 0;
 static THREAD_START_FUNC threadFunc;
 static void* threadFuncArg;
+
+static void TestBatchCallback(const IOTHUB_CLIENT_EVENT_CONFIRMATION* confirmations, size_t confirmationCount, void* userContextCallback)
+{
+    (void)confirmations;
+    (void)confirmationCount;
+    (void)userContextCallback;
+}
+
 static const TRANSPORT_PROVIDER* provideFAKE(void);
 extern "C" const size_t IoTHubClient_ThreadTerminationOffset;
 
@@ -81,6 +93,9 @@ static IOTHUB_CLIENT_HANDLE current_iothub_client;
 #define TEST_IOTHUBTRANSPORT_LOCK (TRANSPORT_HANDLE)0xDEAF
 #define TEST_IOTHUBTRANSPORT_LL (TRANSPORT_HANDLE)0xDEDE
 #define TEST_LIST_HANDLE				(SINGLYLINKEDLIST_HANDLE)0x4246
+#define TEST_INGRESS_QUEUE_HANDLE       (INGRESS_QUEUE_HANDLE)0x4248
+#define TEST_CLONED_MESSAGE_HANDLE      (IOTHUB_MESSAGE_HANDLE)0x53
+#define TEST_CALLBACK_DISPATCHER_HANDLE (CALLBACK_DISPATCHER_HANDLE)0x4249
 typedef struct TEST_LIST_ITEM_TAG
 {
     const void* item_value;
@@ -88,6 +103,20 @@ typedef struct TEST_LIST_ITEM_TAG
 
 static TEST_LIST_ITEM** list_items = NULL;
 static size_t list_item_count = 0;
+
+/*the ingress queue mock keeps the pushed entries in order*/
+#define TEST_MAX_INGRESS_ENTRIES 4
+static INGRESS_QUEUE_ENTRY* ingress_entries[TEST_MAX_INGRESS_ENTRIES];
+static size_t ingress_entry_count = 0;
+
+/*the callback dispatcher mock keeps the posted items, runDispatchedItems plays the dispatcher thread*/
+#define TEST_MAX_DISPATCHED_ITEMS 4
+static CALLBACK_DISPATCHER_ITEM* dispatched_items[TEST_MAX_DISPATCHED_ITEMS];
+static size_t dispatched_item_count = 0;
+
+/*what IoTHubClient gave to the LL layer*/
+static IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK ll_eventConfirmationCallback;
+static void* ll_eventConfirmationContext;
 TYPED_MOCK_CLASS(CIoTHubClientMocks, CGlobalMock)
 {
 public:
@@ -102,6 +131,8 @@ public:
     MOCK_STATIC_METHOD_1(, void, IoTHubClient_LL_Destroy, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle);
     MOCK_VOID_METHOD_END();
     MOCK_STATIC_METHOD_4(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SendEventAsync, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback)
+        ll_eventConfirmationCallback = eventConfirmationCallback;
+        ll_eventConfirmationContext = userContextCallback;
     MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
     MOCK_STATIC_METHOD_3(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SetMessageCallback, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC, messageCallback, void*, userContextCallback)
     MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
@@ -110,12 +141,23 @@ public:
     MOCK_VOID_METHOD_END();
     MOCK_STATIC_METHOD_2(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetSendStatus, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_STATUS*, iotHubClientStatus)
     MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
+    MOCK_STATIC_METHOD_3(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetOutboundQueueSize, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, size_t*, messageCount, size_t*, byteCount)
+    MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
+    MOCK_STATIC_METHOD_3(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SetEventConfirmationBatchCallback, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_BATCH_CALLBACK, batchCallback, void*, userContextCallback)
+    MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
+    MOCK_STATIC_METHOD_2(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetMetrics, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_METRICS_SNAPSHOT*, snapshot)
+    MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
     MOCK_STATIC_METHOD_2(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetLastMessageReceiveTime, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, time_t*, lastMessageReceiveTime)
     MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
 
     MOCK_STATIC_METHOD_3(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SetOption, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, const char*, optionName, const void*, value)
     MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
 
+    MOCK_STATIC_METHOD_3(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SetRetryPolicy, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitinSeconds)
+    MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
+    MOCK_STATIC_METHOD_3(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetRetryPolicy, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY*, retryPolicy, size_t*, retryTimeoutLimitinSeconds)
+    MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
+
     /* ThreadAPI mocks */
     MOCK_STATIC_METHOD_3(, THREADAPI_RESULT, ThreadAPI_Create, THREAD_HANDLE*, threadHandle, THREAD_START_FUNC, func, void*, arg);
         *threadHandle = TEST_THREAD_HANDLE;
@@ -216,6 +258,46 @@ public:
         }
     MOCK_METHOD_END(int, result2);
 
+    /* IoTHubMessage mocks */
+    MOCK_STATIC_METHOD_1(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_Clone, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle)
+    MOCK_METHOD_END(IOTHUB_MESSAGE_HANDLE, TEST_CLONED_MESSAGE_HANDLE);
+    MOCK_STATIC_METHOD_1(, void, IoTHubMessage_Destroy, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle)
+    MOCK_VOID_METHOD_END();
+
+    /* ingress queue mocks */
+    MOCK_STATIC_METHOD_0(, INGRESS_QUEUE_HANDLE, ingress_queue_create)
+        ingress_entry_count = 0;
+    MOCK_METHOD_END(INGRESS_QUEUE_HANDLE, TEST_INGRESS_QUEUE_HANDLE);
+    MOCK_STATIC_METHOD_1(, void, ingress_queue_destroy, INGRESS_QUEUE_HANDLE, queue)
+    MOCK_VOID_METHOD_END();
+    MOCK_STATIC_METHOD_2(, int, ingress_queue_push, INGRESS_QUEUE_HANDLE, queue, INGRESS_QUEUE_ENTRY*, entry)
+        ASSERT_IS_TRUE(ingress_entry_count < TEST_MAX_INGRESS_ENTRIES);
+        ingress_entries[ingress_entry_count++] = entry;
+    MOCK_METHOD_END(int, 0);
+    MOCK_STATIC_METHOD_3(, size_t, ingress_queue_drain, INGRESS_QUEUE_HANDLE, queue, INGRESS_QUEUE_ENTRY_CALLBACK, callback, void*, context)
+        size_t drained = ingress_entry_count;
+        size_t i;
+        ingress_entry_count = 0;
+        for (i = 0; i < drained; i++)
+        {
+            callback(ingress_entries[i], context);
+        }
+    MOCK_METHOD_END(size_t, drained);
+    MOCK_STATIC_METHOD_1(, bool, ingress_queue_is_empty, INGRESS_QUEUE_HANDLE, queue)
+    MOCK_METHOD_END(bool, ingress_entry_count == 0);
+
+    /* callback dispatcher mocks */
+    MOCK_STATIC_METHOD_0(, CALLBACK_DISPATCHER_HANDLE, callback_dispatcher_create)
+        dispatched_item_count = 0;
+    MOCK_METHOD_END(CALLBACK_DISPATCHER_HANDLE, TEST_CALLBACK_DISPATCHER_HANDLE);
+    MOCK_STATIC_METHOD_1(, void, callback_dispatcher_destroy, CALLBACK_DISPATCHER_HANDLE, dispatcher)
+    MOCK_VOID_METHOD_END();
+    MOCK_STATIC_METHOD_3(, int, callback_dispatcher_post, CALLBACK_DISPATCHER_HANDLE, dispatcher, CALLBACK_DISPATCHER_ITEM*, item, CALLBACK_DISPATCHER_FUNCTION, function)
+        ASSERT_IS_TRUE(dispatched_item_count < TEST_MAX_DISPATCHED_ITEMS);
+        item->function = function;
+        dispatched_items[dispatched_item_count++] = item;
+    MOCK_METHOD_END(int, 0);
+
 #ifndef DONT_USE_UPLOADTOBLOB
     MOCK_STATIC_METHOD_4(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_UploadToBlob, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, const char*, destinationFileName, const unsigned char*, source, size_t, size);
     MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK);
@@ -310,8 +392,13 @@ DECLARE_GLOBAL_MOCK_METHOD_4(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubC
 DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SetMessageCallback, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC, messageCallback, void*, userContextCallback)
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientMocks, , void, IoTHubClient_LL_DoWork, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle)
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetSendStatus, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_STATUS*, iotHubClientStatus)
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetOutboundQueueSize, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, size_t*, messageCount, size_t*, byteCount)
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SetEventConfirmationBatchCallback, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_BATCH_CALLBACK, batchCallback, void*, userContextCallback)
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetMetrics, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_METRICS_SNAPSHOT*, snapshot)
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetLastMessageReceiveTime, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, time_t*, lastMessageReceiveTime)
 DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SetOption, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, const char*, optionName, const void*, value)
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SetRetryPolicy, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitinSeconds)
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetRetryPolicy, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY*, retryPolicy, size_t*, retryTimeoutLimitinSeconds)
 
 DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientMocks, , THREADAPI_RESULT, ThreadAPI_Create, THREAD_HANDLE*, threadHandle, THREAD_START_FUNC, func, void*, arg);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientMocks, , THREADAPI_RESULT, ThreadAPI_Join, THREAD_HANDLE, threadHandle, int*, res);
@@ -338,6 +425,19 @@ DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientMocks, , void, IoTHubTransport_JoinWor
 
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientMocks, , int, mallocAndStrcpy_s, char**, destination, const char*, source);
 
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientMocks, , IOTHUB_MESSAGE_HANDLE, IoTHubMessage_Clone, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientMocks, , void, IoTHubMessage_Destroy, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
+
+DECLARE_GLOBAL_MOCK_METHOD_0(CIoTHubClientMocks, , INGRESS_QUEUE_HANDLE, ingress_queue_create);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientMocks, , void, ingress_queue_destroy, INGRESS_QUEUE_HANDLE, queue);
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientMocks, , int, ingress_queue_push, INGRESS_QUEUE_HANDLE, queue, INGRESS_QUEUE_ENTRY*, entry);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientMocks, , size_t, ingress_queue_drain, INGRESS_QUEUE_HANDLE, queue, INGRESS_QUEUE_ENTRY_CALLBACK, callback, void*, context);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientMocks, , bool, ingress_queue_is_empty, INGRESS_QUEUE_HANDLE, queue);
+
+DECLARE_GLOBAL_MOCK_METHOD_0(CIoTHubClientMocks, , CALLBACK_DISPATCHER_HANDLE, callback_dispatcher_create);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubClientMocks, , void, callback_dispatcher_destroy, CALLBACK_DISPATCHER_HANDLE, dispatcher);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubClientMocks, , int, callback_dispatcher_post, CALLBACK_DISPATCHER_HANDLE, dispatcher, CALLBACK_DISPATCHER_ITEM*, item, CALLBACK_DISPATCHER_FUNCTION, function);
+
 #ifndef DONT_USE_UPLOADTOBLOB
 DECLARE_GLOBAL_MOCK_METHOD_4(CIoTHubClientMocks, , IOTHUB_CLIENT_RESULT, IoTHubClient_LL_UploadToBlob, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, const char*, destinationFileName, const unsigned char*, source, size_t, size);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubClientMocks, , void, uploadToBlobAsyncCallback, IOTHUB_CLIENT_FILE_UPLOAD_RESULT, result, void*, userContextCallback);
@@ -357,6 +457,33 @@ static const TRANSPORT_PROVIDER* provideFAKE(void)
     return NULL;
 }
 
+static IOTHUB_CLIENT_HANDLE createClientWithIngressQueue(void)
+{
+    bool on = true;
+    IOTHUB_CLIENT_HANDLE result = IoTHubClient_Create(&TEST_CONFIG);
+    (void)IoTHubClient_SetOption(result, OPTION_SEND_INGRESS_QUEUE, &on);
+    return result;
+}
+
+static IOTHUB_CLIENT_HANDLE createClientWithCallbackDispatcher(void)
+{
+    bool on = true;
+    IOTHUB_CLIENT_HANDLE result = IoTHubClient_Create(&TEST_CONFIG);
+    (void)IoTHubClient_SetOption(result, OPTION_CALLBACK_DISPATCHER, &on);
+    return result;
+}
+
+static void runDispatchedItems(void)
+{
+    size_t count = dispatched_item_count;
+    size_t i;
+    dispatched_item_count = 0;
+    for (i = 0; i < count; i++)
+    {
+        dispatched_items[i]->function(dispatched_items[i]);
+    }
+}
+
 BEGIN_TEST_SUITE(iothubclient_ut)
 
     TEST_SUITE_INITIALIZE(TestClassInitialize)
@@ -384,6 +511,10 @@ BEGIN_TEST_SUITE(iothubclient_ut)
         doWorkCallCount = 0;
 		threadFunc = NULL;
 		threadFuncArg = NULL;
+        ingress_entry_count = 0;
+        dispatched_item_count = 0;
+        ll_eventConfirmationCallback = NULL;
+        ll_eventConfirmationContext = NULL;
     }
 
     TEST_FUNCTION_CLEANUP(TestMethodCleanup)
@@ -1305,6 +1436,97 @@ BEGIN_TEST_SUITE(iothubclient_ut)
         IoTHubClient_Destroy(iotHubClient);
     }
 
+    /* Tests_SRS_IOTHUBCLIENT_02_085: [ If optionName is OPTION_PERSISTENT_QUEUE and IoTHubClient_LL_SetOption succeeds, IoTHubClient_SetOption shall remember blockTimeoutInMilliseconds when the policy is PERSISTENT_QUEUE_OVERFLOW_BLOCK. ]*/
+    /* Tests_SRS_IOTHUBCLIENT_02_086: [ If IoTHubClient_LL_SendEventAsync returns IOTHUB_CLIENT_QUEUE_FULL and the persistent queue policy is PERSISTENT_QUEUE_OVERFLOW_BLOCK, IoTHubClient_SendEventAsync shall release the lock, let the worker thread make room and try again until blockTimeoutInMilliseconds have passed. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_a_full_blocking_persistent_queue_waits_for_room)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        PERSISTENT_QUEUE_CONFIG config = { "queueDirectory", 0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_BLOCK, 100, 0 };
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        (void)IoTHubClient_SetOption(iotHubClient, OPTION_PERSISTENT_QUEUE, &config);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42))
+            .SetReturn(IOTHUB_CLIENT_QUEUE_FULL);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ThreadAPI_Sleep(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_087: [ If optionName is OPTION_OUTBOUND_QUEUE_LIMITS and IoTHubClient_LL_SetOption succeeds, IoTHubClient_SetOption shall remember blockTimeoutInMilliseconds when the policy is IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK. ]*/
+    /* Tests_SRS_IOTHUBCLIENT_02_088: [ If IoTHubClient_LL_SendEventAsync returns IOTHUB_CLIENT_QUEUE_FULL and the outbound queue limits policy is IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK, IoTHubClient_SendEventAsync shall release the lock, let the worker thread make room and try again until blockTimeoutInMilliseconds have passed. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_full_blocking_outbound_queue_limits_waits_for_room)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_QUEUE_LIMITS limits = { 1, 0, IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK, 100 };
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        (void)IoTHubClient_SetOption(iotHubClient, OPTION_OUTBOUND_QUEUE_LIMITS, &limits);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42))
+            .SetReturn(IOTHUB_CLIENT_QUEUE_FULL);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ThreadAPI_Sleep(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_01_013: [When IoTHubClient_LL_SendEventAsync is called, IoTHubClient_SendEventAsync shall return the result of IoTHubClient_LL_SendEventAsync.] */
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_a_full_persistent_queue_returns_IOTHUB_CLIENT_QUEUE_FULL_without_waiting)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42))
+            .SetReturn(IOTHUB_CLIENT_QUEUE_FULL);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_QUEUE_FULL, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
     /* SRS_IOTHUBCLIENT_01_009: [IoTHubClient_SendEventAsync shall start the worker thread if it was not previously started.] */
     TEST_FUNCTION(When_The_Worker_Thread_Was_Started_Already_Due_To_SendEventAsync_Thread_Is_Not_Started_Again_On_A_New_SendEventAsync)
     {
@@ -1400,6 +1622,186 @@ BEGIN_TEST_SUITE(iothubclient_ut)
         IoTHubClient_Destroy(iotHubClient);
     }
 
+    /* Tests_SRS_IOTHUBCLIENT_01_009: [IoTHubClient_SendEventAsync shall start the worker thread if it was not previously started.] */
+    /* Tests_SRS_IOTHUBCLIENT_02_097: [ If the ingress queue is on, IoTHubClient_SendEventAsync shall take the lock only to start the worker thread, the first time. ]*/
+    /* Tests_SRS_IOTHUBCLIENT_02_098: [ If the ingress queue is on, IoTHubClient_SendEventAsync shall clone eventMessageHandle by calling IoTHubMessage_Clone, push the clone, eventConfirmationCallback and userContextCallback to the ingress queue and return IOTHUB_CLIENT_OK. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_ingress_queue_pushes_a_clone_without_calling_the_underlayer)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Clone(TEST_DEVICEMESSAGE_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_push(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        ASSERT_ARE_EQUAL(size_t, 1, ingress_entry_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_097: [ If the ingress queue is on, IoTHubClient_SendEventAsync shall take the lock only to start the worker thread, the first time. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_ingress_queue_does_not_lock_once_the_thread_runs)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Clone(TEST_DEVICEMESSAGE_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_push(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x43);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        ASSERT_ARE_EQUAL(size_t, 2, ingress_entry_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_096: [ If the ingress queue is on and eventMessageHandle is NULL, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_ingress_queue_and_NULL_message_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        mocks.ResetAllCalls();
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, NULL, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(size_t, 0, ingress_entry_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_01_010: [If starting the thread fails, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR.] */
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_ingress_queue_fails_when_starting_the_thread_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .SetReturn(THREADAPI_ERROR);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        ASSERT_ARE_EQUAL(size_t, 0, ingress_entry_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_099: [ If any failure occurs while queuing the event, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_ingress_queue_fails_when_IoTHubMessage_Clone_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Clone(TEST_DEVICEMESSAGE_HANDLE))
+            .SetReturn((IOTHUB_MESSAGE_HANDLE)NULL);
+        EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_099: [ If any failure occurs while queuing the event, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_ingress_queue_fails_when_push_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        ingress_entry_count = 0;
+        mocks.ResetAllCalls();
+
+        EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Clone(TEST_DEVICEMESSAGE_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_push(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(1);
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Destroy(TEST_CLONED_MESSAGE_HANDLE));
+        EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        ingress_entry_count = 0;
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_099: [ If any failure occurs while queuing the event, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_ingress_queue_fails_when_malloc_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        whenShallmalloc_fail = currentmalloc_call + 1;
+        EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        ASSERT_ARE_EQUAL(size_t, 1, ingress_entry_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
     /* IoTHubClient_SetMessageCallback */
 
     /* Tests_SRS_IOTHUBCLIENT_01_014: [IoTHubClient_SetMessageCallback shall start the worker thread if it was not previously started.] */
@@ -1684,16 +2086,150 @@ BEGIN_TEST_SUITE(iothubclient_ut)
         IoTHubClient_Destroy(iotHubClient);
     }
 
-    /* IoTHubClient_GetSendStatus */
+    /* IoTHubClient_SetRetryPolicy */
 
-    /* Tests_SRS_IOTHUBCLIENT_01_022: [IoTHubClient_GetSendStatus shall call IoTHubClient_LL_GetSendStatus, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameter iotHubClientStatus.] */
-    /* Tests_SRS_IOTHUBCLIENT_01_033: [IoTHubClient_GetSendStatus shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
-    TEST_FUNCTION(IoTHubClient_GetSendStatus_Calls_The_Underslayer_With_Lock_On)
+    /* Tests_SRS_IOTHUBCLIENT_02_075: [ If iotHubClientHandle is NULL, IoTHubClient_SetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_SetRetryPolicy_with_NULL_handle_fails)
     {
         // arrange
         CIoTHubClientMocks mocks;
-        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
-        mocks.ResetAllCalls();
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SetRetryPolicy(NULL, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_076: [ IoTHubClient_SetRetryPolicy shall call IoTHubClient_LL_SetRetryPolicy, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameters retryPolicy and retryTimeoutLimitinSeconds. ]*/
+    /* Tests_SRS_IOTHUBCLIENT_02_077: [ When IoTHubClient_LL_SetRetryPolicy is called, IoTHubClient_SetRetryPolicy shall return the result of IoTHubClient_LL_SetRetryPolicy. ]*/
+    /* Tests_SRS_IOTHUBCLIENT_02_081: [ IoTHubClient_SetRetryPolicy shall be made thread-safe by using the lock created in IoTHubClient_Create. ]*/
+    TEST_FUNCTION(IoTHubClient_SetRetryPolicy_Calls_the_Underlayer)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SetRetryPolicy(TEST_IOTHUB_CLIENT_LL_HANDLE, IOTHUB_CLIENT_RETRY_INTERVAL, 10))
+            .SetReturn(IOTHUB_CLIENT_ERROR);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SetRetryPolicy(iotHubClient, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_082: [ If acquiring the lock fails, IoTHubClient_SetRetryPolicy shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(When_Accquiring_The_Lock_Fails_Then_IoTHubClient_SetRetryPolicy_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE))
+            .SetReturn(LOCK_ERROR);
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SetRetryPolicy(iotHubClient, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* IoTHubClient_GetRetryPolicy */
+
+    /* Tests_SRS_IOTHUBCLIENT_02_078: [ If iotHubClientHandle is NULL, IoTHubClient_GetRetryPolicy shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_GetRetryPolicy_with_NULL_handle_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+        size_t retryTimeoutLimitinSeconds;
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_GetRetryPolicy(NULL, &retryPolicy, &retryTimeoutLimitinSeconds);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_079: [ IoTHubClient_GetRetryPolicy shall call IoTHubClient_LL_GetRetryPolicy, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameters retryPolicy and retryTimeoutLimitinSeconds. ]*/
+    /* Tests_SRS_IOTHUBCLIENT_02_080: [ When IoTHubClient_LL_GetRetryPolicy is called, IoTHubClient_GetRetryPolicy shall return the result of IoTHubClient_LL_GetRetryPolicy. ]*/
+    /* Tests_SRS_IOTHUBCLIENT_02_083: [ IoTHubClient_GetRetryPolicy shall be made thread-safe by using the lock created in IoTHubClient_Create. ]*/
+    TEST_FUNCTION(IoTHubClient_GetRetryPolicy_Calls_the_Underlayer)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+        size_t retryTimeoutLimitinSeconds;
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_GetRetryPolicy(TEST_IOTHUB_CLIENT_LL_HANDLE, &retryPolicy, &retryTimeoutLimitinSeconds))
+            .SetReturn(IOTHUB_CLIENT_INVALID_ARG);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_GetRetryPolicy(iotHubClient, &retryPolicy, &retryTimeoutLimitinSeconds);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_084: [ If acquiring the lock fails, IoTHubClient_GetRetryPolicy shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(When_Accquiring_The_Lock_Fails_Then_IoTHubClient_GetRetryPolicy_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        IOTHUB_CLIENT_RETRY_POLICY retryPolicy;
+        size_t retryTimeoutLimitinSeconds;
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE))
+            .SetReturn(LOCK_ERROR);
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_GetRetryPolicy(iotHubClient, &retryPolicy, &retryTimeoutLimitinSeconds);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* IoTHubClient_GetSendStatus */
+
+    /* Tests_SRS_IOTHUBCLIENT_01_022: [IoTHubClient_GetSendStatus shall call IoTHubClient_LL_GetSendStatus, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameter iotHubClientStatus.] */
+    /* Tests_SRS_IOTHUBCLIENT_01_033: [IoTHubClient_GetSendStatus shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
+    TEST_FUNCTION(IoTHubClient_GetSendStatus_Calls_The_Underslayer_With_Lock_On)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
 
         IOTHUB_CLIENT_STATUS injectedSendStatus = IOTHUB_CLIENT_SEND_STATUS_BUSY;
         STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
@@ -1804,6 +2340,176 @@ BEGIN_TEST_SUITE(iothubclient_ut)
         IoTHubClient_Destroy(iotHubClient);
     }
 
+    /* IoTHubClient_GetOutboundQueueSize */
+
+    /* Tests_SRS_IOTHUBCLIENT_02_090: [ IoTHubClient_GetOutboundQueueSize shall call IoTHubClient_LL_GetOutboundQueueSize under the lock created in IoTHubClient_Create, passing messageCount and byteCount, and return what IoTHubClient_LL_GetOutboundQueueSize returns. ]*/
+    TEST_FUNCTION(IoTHubClient_GetOutboundQueueSize_calls_the_underlayer_with_lock_on)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        size_t messageCount;
+        size_t byteCount;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_GetOutboundQueueSize(TEST_IOTHUB_CLIENT_LL_HANDLE, &messageCount, &byteCount))
+            .SetReturn(IOTHUB_CLIENT_INVALID_SIZE);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_GetOutboundQueueSize(iotHubClient, &messageCount, &byteCount);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_SIZE, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_089: [ If iotHubClientHandle is NULL, IoTHubClient_GetOutboundQueueSize shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_GetOutboundQueueSize_with_NULL_handle_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        size_t messageCount;
+        size_t byteCount;
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_GetOutboundQueueSize(NULL, &messageCount, &byteCount);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_091: [ If acquiring the lock fails, IoTHubClient_GetOutboundQueueSize shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(When_acquiring_the_lock_fails_then_IoTHubClient_GetOutboundQueueSize_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        size_t messageCount;
+        size_t byteCount;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE))
+            .SetReturn(LOCK_ERROR);
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_GetOutboundQueueSize(iotHubClient, &messageCount, &byteCount);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* IoTHubClient_SetEventConfirmationBatchCallback */
+
+    /* Tests_SRS_IOTHUBCLIENT_02_116: [ IoTHubClient_SetEventConfirmationBatchCallback shall call IoTHubClient_LL_SetEventConfirmationBatchCallback under the lock created in IoTHubClient_Create, passing batchCallback and userContextCallback, and return what IoTHubClient_LL_SetEventConfirmationBatchCallback returns. ]*/
+    TEST_FUNCTION(IoTHubClient_SetEventConfirmationBatchCallback_calls_the_underlayer_with_lock_on)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SetEventConfirmationBatchCallback(TEST_IOTHUB_CLIENT_LL_HANDLE, TestBatchCallback, (void*)1))
+            .SetReturn(IOTHUB_CLIENT_INVALID_ARG);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SetEventConfirmationBatchCallback(iotHubClient, TestBatchCallback, (void*)1);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_115: [ If iotHubClientHandle is NULL, IoTHubClient_SetEventConfirmationBatchCallback shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_SetEventConfirmationBatchCallback_with_NULL_handle_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SetEventConfirmationBatchCallback(NULL, TestBatchCallback, (void*)1);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_117: [ If acquiring the lock fails, IoTHubClient_SetEventConfirmationBatchCallback shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(When_acquiring_the_lock_fails_then_IoTHubClient_SetEventConfirmationBatchCallback_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE))
+            .SetReturn(LOCK_ERROR);
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SetEventConfirmationBatchCallback(iotHubClient, TestBatchCallback, (void*)1);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* IoTHubClient_GetMetrics */
+
+    /* Tests_SRS_IOTHUBCLIENT_02_119: [ IoTHubClient_GetMetrics shall call IoTHubClient_LL_GetMetrics without taking the lock created in IoTHubClient_Create, passing snapshot, and return what IoTHubClient_LL_GetMetrics returns. ]*/
+    TEST_FUNCTION(IoTHubClient_GetMetrics_calls_the_underlayer_without_the_lock)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+        IOTHUB_CLIENT_HANDLE iotHubClient = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_GetMetrics(TEST_IOTHUB_CLIENT_LL_HANDLE, &snapshot))
+            .SetReturn(IOTHUB_CLIENT_ERROR);
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_GetMetrics(iotHubClient, &snapshot);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /* Tests_SRS_IOTHUBCLIENT_02_118: [ If iotHubClientHandle is NULL, IoTHubClient_GetMetrics shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_GetMetrics_with_NULL_handle_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_GetMetrics(NULL, &snapshot);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
     /* Work scheduling */
 
     /* Tests_SRS_IOTHUBCLIENT_01_037: [The thread created by IoTHubClient_Create shall call IoTHubClient_LL_DoWork every 1 ms.] */
@@ -2057,6 +2763,698 @@ BEGIN_TEST_SUITE(iothubclient_ut)
         IoTHubClient_Destroy(handle);
     }
 
+    /*Tests_SRS_IOTHUBCLIENT_02_092: [ If optionName is OPTION_SEND_INGRESS_QUEUE and value points to true, IoTHubClient_SetOption shall create the ingress queue by calling ingress_queue_create (if it does not exist yet), shall not call IoTHubClient_LL_SetOption and shall return IOTHUB_CLIENT_OK. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_send_ingress_queue_true_creates_the_ingress_queue)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool on = true;
+        IOTHUB_CLIENT_HANDLE handle = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_create());
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_SEND_INGRESS_QUEUE, &on);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_092: [ If optionName is OPTION_SEND_INGRESS_QUEUE and value points to true, IoTHubClient_SetOption shall create the ingress queue by calling ingress_queue_create (if it does not exist yet), shall not call IoTHubClient_LL_SetOption and shall return IOTHUB_CLIENT_OK. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_send_ingress_queue_true_twice_keeps_the_ingress_queue)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool on = true;
+        IOTHUB_CLIENT_HANDLE handle = createClientWithIngressQueue();
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_SEND_INGRESS_QUEUE, &on);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_094: [ If ingress_queue_create fails, IoTHubClient_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_send_ingress_queue_fails_when_ingress_queue_create_fails)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool on = true;
+        IOTHUB_CLIENT_HANDLE handle = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_create())
+            .SetReturn((INGRESS_QUEUE_HANDLE)NULL);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_SEND_INGRESS_QUEUE, &on);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_093: [ If optionName is OPTION_SEND_INGRESS_QUEUE, value points to true and the transport is shared, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_send_ingress_queue_with_a_shared_transport_fails)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool on = true;
+        IOTHUB_CLIENT_HANDLE handle = IoTHubClient_CreateWithTransport(TEST_IOTHUBTRANSPORT_HANDLE, &TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Unlock(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_SEND_INGRESS_QUEUE, &on);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_095: [ If optionName is OPTION_SEND_INGRESS_QUEUE and value points to false, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG if the ingress queue is on and IOTHUB_CLIENT_OK otherwise. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_send_ingress_queue_false_fails_and_keeps_the_ingress_queue)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool off = false;
+        IOTHUB_CLIENT_HANDLE handle = createClientWithIngressQueue();
+        (void)IoTHubClient_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_SEND_INGRESS_QUEUE, &off);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(size_t, 1, ingress_entry_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_095: [ If optionName is OPTION_SEND_INGRESS_QUEUE and value points to false, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG if the ingress queue is on and IOTHUB_CLIENT_OK otherwise. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_send_ingress_queue_false_without_the_ingress_queue_succeeds)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool off = false;
+        IOTHUB_CLIENT_HANDLE handle = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_SEND_INGRESS_QUEUE, &off);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_122: [ If optionName is OPTION_SEND_INGRESS_QUEUE, value points to true and the policy of the persistent queue or of the outbound queue limits is REJECT or BLOCK, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_send_ingress_queue_with_rejecting_outbound_queue_limits_fails)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool on = true;
+        IOTHUB_CLIENT_QUEUE_LIMITS limits = { 1, 0, IOTHUB_CLIENT_QUEUE_OVERFLOW_REJECT, 0 };
+        IOTHUB_CLIENT_HANDLE handle = IoTHubClient_Create(&TEST_CONFIG);
+        (void)IoTHubClient_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &limits);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_SEND_INGRESS_QUEUE, &on);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_122: [ If optionName is OPTION_SEND_INGRESS_QUEUE, value points to true and the policy of the persistent queue or of the outbound queue limits is REJECT or BLOCK, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_send_ingress_queue_with_a_dropping_persistent_queue_creates_the_ingress_queue)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool on = true;
+        PERSISTENT_QUEUE_CONFIG blocking = { "queueDirectory", 0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_BLOCK, 100, 0 };
+        PERSISTENT_QUEUE_CONFIG dropping = { "queueDirectory", 0, 0, 0, PERSISTENT_QUEUE_OVERFLOW_DROP_OLDEST, 0, 0 };
+        IOTHUB_CLIENT_HANDLE handle = IoTHubClient_Create(&TEST_CONFIG);
+        (void)IoTHubClient_SetOption(handle, OPTION_PERSISTENT_QUEUE, &blocking);
+        (void)IoTHubClient_SetOption(handle, OPTION_PERSISTENT_QUEUE, &dropping);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_create());
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_SEND_INGRESS_QUEUE, &on);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_123: [ If the ingress queue is on and optionName is OPTION_PERSISTENT_QUEUE or OPTION_OUTBOUND_QUEUE_LIMITS with the REJECT or BLOCK policy, IoTHubClient_SetOption shall not call IoTHubClient_LL_SetOption and shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_blocking_outbound_queue_limits_with_the_ingress_queue_fails)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_QUEUE_LIMITS limits = { 1, 0, IOTHUB_CLIENT_QUEUE_OVERFLOW_BLOCK, 100 };
+        IOTHUB_CLIENT_HANDLE handle = createClientWithIngressQueue();
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_OUTBOUND_QUEUE_LIMITS, &limits);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_100: [ Before calling IoTHubClient_LL_DoWork, the thread shall drain the ingress queue (if any) and pass every event, oldest first, to IoTHubClient_LL_SendEventAsync, then destroy the clone of the event. ]*/
+    TEST_FUNCTION(Worker_Thread_moves_the_ingress_events_to_the_underlayer_before_DoWork)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x43);
+        mocks.ResetAllCalls();
+
+        howManyDoWorkCalls = 1;
+        current_iothub_client = iotHubClient;
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_drain(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CLONED_MESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CLONED_MESSAGE_HANDLE, eventConfirmationCallback, (void*)0x43));
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Destroy(TEST_CLONED_MESSAGE_HANDLE))
+            .ExpectedTimesExactly(2);
+        EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+            .ExpectedTimesExactly(2);
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_LL_HANDLE));
+#ifndef DONT_USE_UPLOADTOBLOB
+        STRICT_EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+#endif
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        STRICT_EXPECTED_CALL(mocks, ThreadAPI_Sleep(1));
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        threadFunc(threadFuncArg);
+
+        // assert
+        ASSERT_ARE_EQUAL(size_t, 0, ingress_entry_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_101: [ If IoTHubClient_LL_SendEventAsync fails for an event from the ingress queue, the event's eventConfirmationCallback (if any) shall be called with IOTHUB_CLIENT_CONFIRMATION_ERROR. ]*/
+    TEST_FUNCTION(Worker_Thread_calls_back_with_an_error_when_the_underlayer_refuses_an_ingress_event)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        howManyDoWorkCalls = 1;
+        current_iothub_client = iotHubClient;
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_drain(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CLONED_MESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42))
+            .SetReturn(IOTHUB_CLIENT_QUEUE_FULL);
+        STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, (void*)0x42));
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Destroy(TEST_CLONED_MESSAGE_HANDLE));
+        EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_LL_HANDLE));
+#ifndef DONT_USE_UPLOADTOBLOB
+        STRICT_EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+#endif
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        STRICT_EXPECTED_CALL(mocks, ThreadAPI_Sleep(1));
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        threadFunc(threadFuncArg);
+
+        // assert
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_102: [ IoTHubClient_Destroy shall drain the ingress queue (if any) into the IoTHubClient_LL instance before destroying it, so that the events get their callbacks, and destroy the ingress queue. ]*/
+    TEST_FUNCTION(IoTHubClient_Destroy_moves_the_ingress_events_to_the_underlayer_before_destroying_it)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+#ifndef DONT_USE_UPLOADTOBLOB
+        STRICT_EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+#endif
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_drain(TEST_INGRESS_QUEUE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CLONED_MESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42));
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Destroy(TEST_CLONED_MESSAGE_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_destroy(TEST_INGRESS_QUEUE_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_Destroy(TEST_IOTHUB_CLIENT_LL_HANDLE));
+#ifndef DONT_USE_UPLOADTOBLOB
+        STRICT_EXPECTED_CALL(mocks, singlylinkedlist_destroy(TEST_LIST_HANDLE));
+#endif
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(mocks, Lock_Deinit(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+            .ExpectedTimesExactly(2);
+
+        // act
+        IoTHubClient_Destroy(iotHubClient);
+
+        // assert
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_103: [ If IoTHubClient_LL_GetSendStatus succeeds and the ingress queue (if any) is not empty, IoTHubClient_GetSendStatus shall set iotHubClientStatus to IOTHUB_CLIENT_SEND_STATUS_BUSY. ]*/
+    TEST_FUNCTION(IoTHubClient_GetSendStatus_is_busy_while_the_ingress_queue_has_events)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithIngressQueue();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        IOTHUB_CLIENT_STATUS injectedSendStatus = IOTHUB_CLIENT_SEND_STATUS_IDLE;
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_GetSendStatus(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(2, &injectedSendStatus, sizeof(injectedSendStatus));
+        STRICT_EXPECTED_CALL(mocks, ingress_queue_is_empty(TEST_INGRESS_QUEUE_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_STATUS sendStatus;
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_GetSendStatus(iotHubClient, &sendStatus);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_STATUS, IOTHUB_CLIENT_SEND_STATUS_BUSY, sendStatus);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_104: [ If optionName is OPTION_CALLBACK_DISPATCHER and value points to true, IoTHubClient_SetOption shall create the callback dispatcher by calling callback_dispatcher_create (if it does not exist yet), shall not call IoTHubClient_LL_SetOption and shall return IOTHUB_CLIENT_OK. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_callback_dispatcher_true_creates_the_callback_dispatcher)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool on = true;
+        IOTHUB_CLIENT_HANDLE handle = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, callback_dispatcher_create());
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_CALLBACK_DISPATCHER, &on);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_104: [ If optionName is OPTION_CALLBACK_DISPATCHER and value points to true, IoTHubClient_SetOption shall create the callback dispatcher by calling callback_dispatcher_create (if it does not exist yet), shall not call IoTHubClient_LL_SetOption and shall return IOTHUB_CLIENT_OK. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_callback_dispatcher_true_twice_keeps_the_callback_dispatcher)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool on = true;
+        IOTHUB_CLIENT_HANDLE handle = createClientWithCallbackDispatcher();
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_CALLBACK_DISPATCHER, &on);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_105: [ If callback_dispatcher_create fails, IoTHubClient_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_callback_dispatcher_fails_when_callback_dispatcher_create_fails)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool on = true;
+        IOTHUB_CLIENT_HANDLE handle = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, callback_dispatcher_create())
+            .SetReturn((CALLBACK_DISPATCHER_HANDLE)NULL);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_CALLBACK_DISPATCHER, &on);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_106: [ If optionName is OPTION_CALLBACK_DISPATCHER and value points to false, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG if the callback dispatcher is on and IOTHUB_CLIENT_OK otherwise. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_callback_dispatcher_false_when_it_is_on_fails)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool off = false;
+        IOTHUB_CLIENT_HANDLE handle = createClientWithCallbackDispatcher();
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_CALLBACK_DISPATCHER, &off);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_106: [ If optionName is OPTION_CALLBACK_DISPATCHER and value points to false, IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG if the callback dispatcher is on and IOTHUB_CLIENT_OK otherwise. ]*/
+    TEST_FUNCTION(IoTHubClient_SetOption_callback_dispatcher_false_when_it_is_off_succeeds)
+    {
+        /// arrange
+        CIoTHubClientMocks mocks;
+        bool off = false;
+        IOTHUB_CLIENT_HANDLE handle = IoTHubClient_Create(&TEST_CONFIG);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        auto result = IoTHubClient_SetOption(handle, OPTION_CALLBACK_DISPATCHER, &off);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubClient_Destroy(handle);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_107: [ If the callback dispatcher is on and eventConfirmationCallback is not NULL, IoTHubClient_SendEventAsync shall allocate a structure that remembers eventConfirmationCallback and userContextCallback and send the event with a confirmation callback of its own and that structure, which is freed if sending fails. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_callback_dispatcher_sends_with_a_confirmation_callback_of_its_own)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithCallbackDispatcher();
+        mocks.ResetAllCalls();
+
+        EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_DEVICEMESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(3)
+            .IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        ASSERT_IS_NOT_NULL((void*)ll_eventConfirmationCallback);
+        ASSERT_IS_TRUE(ll_eventConfirmationCallback != eventConfirmationCallback);
+        ASSERT_IS_TRUE(ll_eventConfirmationContext != (void*)0x42);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        ll_eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, ll_eventConfirmationContext);
+        runDispatchedItems();
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_107: [ If the callback dispatcher is on and eventConfirmationCallback is not NULL, IoTHubClient_SendEventAsync shall allocate a structure that remembers eventConfirmationCallback and userContextCallback and send the event with a confirmation callback of its own and that structure, which is freed if sending fails. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_callback_dispatcher_frees_the_structure_when_the_underlayer_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithCallbackDispatcher();
+        mocks.ResetAllCalls();
+
+        EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendEventAsync(TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_DEVICEMESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(3)
+            .IgnoreArgument(4)
+            .SetReturn(IOTHUB_CLIENT_INVALID_SIZE);
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_SIZE, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_114: [ If allocating that structure fails, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR. ]*/
+    TEST_FUNCTION(IoTHubClient_SendEventAsync_with_the_callback_dispatcher_fails_when_malloc_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithCallbackDispatcher();
+        mocks.ResetAllCalls();
+
+        whenShallmalloc_fail = currentmalloc_call + 1;
+        EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_108: [ When the LL client confirms a dispatched event, the confirmation shall be posted to the callback dispatcher by calling callback_dispatcher_post, and the application's eventConfirmationCallback shall be called with the result from the callback dispatcher thread. ]*/
+    TEST_FUNCTION(the_confirmation_of_a_dispatched_event_is_posted_to_the_callback_dispatcher)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithCallbackDispatcher();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, callback_dispatcher_post(TEST_CALLBACK_DISPATCHER_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+
+        // act
+        ll_eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, ll_eventConfirmationContext);
+
+        // assert
+        ASSERT_ARE_EQUAL(size_t, 1, dispatched_item_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///arrange
+        mocks.ResetAllCalls();
+        STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, (void*)0x42));
+        EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        runDispatchedItems();
+
+        ///assert
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_109: [ If callback_dispatcher_post fails, the application's eventConfirmationCallback shall be called right away. ]*/
+    TEST_FUNCTION(the_confirmation_of_a_dispatched_event_is_called_right_away_when_callback_dispatcher_post_fails)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithCallbackDispatcher();
+        (void)IoTHubClient_SendEventAsync(iotHubClient, TEST_DEVICEMESSAGE_HANDLE, eventConfirmationCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, callback_dispatcher_post(TEST_CALLBACK_DISPATCHER_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3)
+            .SetReturn(__LINE__);
+        STRICT_EXPECTED_CALL(mocks, eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)0x42));
+        EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+
+        // act
+        ll_eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, ll_eventConfirmationContext);
+
+        // assert
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        dispatched_item_count = 0;
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_121: [ The message callback shall run on the thread that calls IoTHubClient_LL_DoWork, also when the callback dispatcher is on, so that its disposition reaches the service. ]*/
+    TEST_FUNCTION(IoTHubClient_SetMessageCallback_with_the_callback_dispatcher_registers_the_application_callback)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithCallbackDispatcher();
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SetMessageCallback(TEST_IOTHUB_CLIENT_LL_HANDLE, messageCallback, (void*)0x42));
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+        // act
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SetMessageCallback(iotHubClient, messageCallback, (void*)0x42);
+
+        // assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        IoTHubClient_Destroy(iotHubClient);
+    }
+
+    /*Tests_SRS_IOTHUBCLIENT_02_113: [ IoTHubClient_Destroy shall destroy the callback dispatcher (if any) by calling callback_dispatcher_destroy after IoTHubClient_LL_Destroy and after the worker thread was joined, so that every dispatched callback runs. ]*/
+    TEST_FUNCTION(IoTHubClient_Destroy_destroys_the_callback_dispatcher_after_joining_the_thread)
+    {
+        // arrange
+        CIoTHubClientMocks mocks;
+        IOTHUB_CLIENT_HANDLE iotHubClient = createClientWithCallbackDispatcher();
+        (void)IoTHubClient_SetMessageCallback(iotHubClient, messageCallback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+#ifndef DONT_USE_UPLOADTOBLOB
+        STRICT_EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+#endif
+        STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_Destroy(TEST_IOTHUB_CLIENT_LL_HANDLE));
+#ifndef DONT_USE_UPLOADTOBLOB
+        STRICT_EXPECTED_CALL(mocks, singlylinkedlist_destroy(TEST_LIST_HANDLE));
+#endif
+        STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(mocks, callback_dispatcher_destroy(TEST_CALLBACK_DISPATCHER_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Lock_Deinit(TEST_LOCK_HANDLE));
+        EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+
+        // act
+        IoTHubClient_Destroy(iotHubClient);
+
+        // assert
+        mocks.AssertActualAndExpectedCalls();
+    }
+
 #ifndef DONT_USE_UPLOADTOBLOB
     /*Tests_SRS_IOTHUBCLIENT_02_047: [ If iotHubClientHandle is NULL then IoTHubClient_UploadToBlobAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
     TEST_FUNCTION(IoTHubClient_UploadToBlobAsync_with_NULL_iotHubClientHandle_fails)
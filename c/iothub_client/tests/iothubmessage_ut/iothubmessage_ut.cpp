@@ -1527,4 +1527,113 @@ BEGIN_TEST_SUITE(iothubmessage_ut)
         IoTHubMessage_Destroy(h);
     }
 
+    /* Tests_SRS_IOTHUBMESSAGE_02_033: [ The priority of a new message shall be IOTHUB_MESSAGE_PRIORITY_NORMAL. ]*/
+    /* Tests_SRS_IOTHUBMESSAGE_02_034: [ IoTHubMessage_GetPriority shall return the priority of the message. ]*/
+    TEST_FUNCTION(IoTHubMessage_GetPriority_of_a_new_message_is_NORMAL)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        mocks.ResetAllCalls();
+
+        ///act
+        IOTHUB_MESSAGE_PRIORITY result = IoTHubMessage_GetPriority(h);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_PRIORITY, IOTHUB_MESSAGE_PRIORITY_NORMAL, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /* Tests_SRS_IOTHUBMESSAGE_02_038: [ If iotHubMessageHandle is NULL then IoTHubMessage_GetPriority shall return IOTHUB_MESSAGE_PRIORITY_NORMAL. ]*/
+    TEST_FUNCTION(IoTHubMessage_GetPriority_with_NULL_handle_returns_NORMAL)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
+        ///act
+        IOTHUB_MESSAGE_PRIORITY result = IoTHubMessage_GetPriority(NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_PRIORITY, IOTHUB_MESSAGE_PRIORITY_NORMAL, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_IOTHUBMESSAGE_02_037: [ Otherwise IoTHubMessage_SetPriority shall set the priority of the message and return IOTHUB_MESSAGE_OK. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetPriority_SUCCEED)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromString("c, 1");
+        mocks.ResetAllCalls();
+
+        ///act
+        IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetPriority(h, IOTHUB_MESSAGE_PRIORITY_HIGH);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_PRIORITY, IOTHUB_MESSAGE_PRIORITY_HIGH, IoTHubMessage_GetPriority(h));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /* Tests_SRS_IOTHUBMESSAGE_02_036: [ If iotHubMessageHandle is NULL or priority is not an IOTHUB_MESSAGE_PRIORITY value then IoTHubMessage_SetPriority shall return IOTHUB_MESSAGE_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetPriority_with_NULL_handle_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
+        ///act
+        IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetPriority(NULL, IOTHUB_MESSAGE_PRIORITY_HIGH);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_IOTHUBMESSAGE_02_036: [ If iotHubMessageHandle is NULL or priority is not an IOTHUB_MESSAGE_PRIORITY value then IoTHubMessage_SetPriority shall return IOTHUB_MESSAGE_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetPriority_with_invalid_priority_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromString("c, 1");
+        mocks.ResetAllCalls();
+
+        ///act
+        IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetPriority(h, (IOTHUB_MESSAGE_PRIORITY)42);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_PRIORITY, IOTHUB_MESSAGE_PRIORITY_NORMAL, IoTHubMessage_GetPriority(h));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /* Tests_SRS_IOTHUBMESSAGE_02_035: [ IoTHubMessage_Clone shall copy the priority. ]*/
+    TEST_FUNCTION(IoTHubMessage_Clone_copies_the_priority)
+    {
+        ///arrange
+        CNiceCallComparer<CIoTHubMessageMocks> mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        (void)IoTHubMessage_SetPriority(h, IOTHUB_MESSAGE_PRIORITY_LOW);
+        mocks.ResetAllCalls();
+
+        ///act
+        auto clone = IoTHubMessage_Clone(h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(clone);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_PRIORITY, IOTHUB_MESSAGE_PRIORITY_LOW, IoTHubMessage_GetPriority(clone));
+
+        ///cleanup
+        IoTHubMessage_Destroy(clone);
+        IoTHubMessage_Destroy(h);
+    }
+
 END_TEST_SUITE(iothubmessage_ut)
@@ -33,7 +33,6 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 
 #define ENABLE_MOCKS
 
-#include "azure_c_shared_utility/sastoken.h"
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/gballoc.h"
 
@@ -49,6 +48,8 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 #include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/string_tokenizer.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "iothub_client_retry_control.h"
+#include "iothub_client_sastoken_cache.h"
 #undef ENABLE_MOCKS
 
 #include "iothubtransport_mqtt_common.h"
@@ -136,6 +137,8 @@ static const IOTHUB_MESSAGE_HANDLE TEST_IOTHUB_MSG_BYTEARRAY = (const IOTHUB_MES
 static IOTHUB_MESSAGE_HANDLE TEST_IOTHUB_MSG_STRING = (IOTHUB_MESSAGE_HANDLE)0x01d2;
 
 static const TICK_COUNTER_HANDLE TEST_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x12;
+static const RETRY_CONTROL_HANDLE TEST_RETRY_CONTROL_HANDLE = (RETRY_CONTROL_HANDLE)0x1128;
+static const SASTOKEN_CACHE_HANDLE TEST_SASTOKEN_CACHE_HANDLE = (SASTOKEN_CACHE_HANDLE)0x1129;
 static const MAP_HANDLE TEST_MESSAGE_PROP_MAP = (MAP_HANDLE)0x1212;
 
 static char appMessageString[] = "App Message String";
@@ -336,13 +339,11 @@ static void my_STRING_TOKENIZER_destroy(STRING_TOKENIZER_HANDLE handle)
     my_gballoc_free(handle);
 }
 
-static STRING_HANDLE my_SASToken_Create(STRING_HANDLE key, STRING_HANDLE scope, STRING_HANDLE keyName, size_t expiry)
+static const char* my_sastoken_cache_get_token(SASTOKEN_CACHE_HANDLE sasTokenCacheHandle, size_t* creationTime)
 {
-    (void)key;
-    (void)scope;
-    (void)keyName;
-    (void)expiry;
-    return (STRING_HANDLE)my_gballoc_malloc(1);
+    (void)sasTokenCacheHandle;
+    *creationTime = (size_t)TEST_TIME_T;
+    return TEST_SAS_TOKEN;
 }
 
 static MAP_RESULT my_Map_GetInternals(MAP_HANDLE handle, const char*const** keys, const char*const** values, size_t* count)
@@ -384,6 +385,15 @@ static void my_tickcounter_destroy(TICK_COUNTER_HANDLE tick_counter)
     my_gballoc_free(tick_counter);
 }
 
+static RETRY_ACTION g_retryAction = RETRY_ACTION_RETRY_NOW;
+
+static int my_retry_control_should_retry(RETRY_CONTROL_HANDLE retryControlHandle, RETRY_ACTION* retryAction)
+{
+    (void)retryControlHandle;
+    *retryAction = g_retryAction;
+    return 0;
+}
+
 static MAP_HANDLE my_Map_Create(MAP_FILTER_CALLBACK mapFilterFunc)
 {
     (void)mapFilterFunc;
@@ -458,6 +468,9 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_CONFIRMATION_RESULT, int);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUBMESSAGE_DISPOSITION_RESULT, int);
     REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(RETRY_CONTROL_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SASTOKEN_CACHE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_RETRY_POLICY, int);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
@@ -555,8 +568,12 @@ TEST_SUITE_INITIALIZE(suite_init)
 
     REGISTER_GLOBAL_MOCK_HOOK(STRING_TOKENIZER_destroy, my_STRING_TOKENIZER_destroy);
     
-    REGISTER_GLOBAL_MOCK_HOOK(SASToken_Create, my_SASToken_Create);
-    REGISTER_GLOBAL_MOCK_FAIL_RETURN(SASToken_Create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(sastoken_cache_create, TEST_SASTOKEN_CACHE_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(sastoken_cache_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(sastoken_cache_get_token, my_sastoken_cache_get_token);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(sastoken_cache_get_token, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(sastoken_cache_set_lifetime, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(sastoken_cache_set_lifetime, __LINE__);
 
     REGISTER_GLOBAL_MOCK_RETURN(get_time, TEST_TIME_T);
 
@@ -578,6 +595,13 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, __LINE__);
 
+    REGISTER_GLOBAL_MOCK_RETURN(retry_control_create, TEST_RETRY_CONTROL_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(retry_control_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(retry_control_should_retry, my_retry_control_should_retry);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(retry_control_should_retry, __LINE__);
+    REGISTER_GLOBAL_MOCK_RETURN(retry_control_set_policy, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(retry_control_set_policy, __LINE__);
+
     REGISTER_GLOBAL_MOCK_HOOK(DList_InitializeListHead, real_DList_InitializeListHead);
     REGISTER_GLOBAL_MOCK_HOOK(DList_IsListEmpty, real_DList_IsListEmpty);
     REGISTER_GLOBAL_MOCK_HOOK(DList_InsertTailList, real_DList_InsertTailList);
@@ -603,6 +627,7 @@ TEST_FUNCTION_INITIALIZE(method_init)
     g_callbackCtx = NULL;
 
     g_current_ms = 0;
+    g_retryAction = RETRY_ACTION_RETRY_NOW;
     g_tokenizerIndex = 0;
     g_nullMapVariable = true;
 
@@ -665,6 +690,9 @@ static void setup_IoTHubTransport_MQTT_Common_Create_mocks(bool use_gateway)
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(STRING_construct(TEST_DEVICE_ID));
     STRICT_EXPECTED_CALL(STRING_construct(TEST_DEVICE_KEY));
+    STRICT_EXPECTED_CALL(sastoken_cache_create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL))
+        .IgnoreArgument_key()
+        .IgnoreArgument_scope();
 
     EXPECTED_CALL(mqtt_client_init(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
@@ -674,6 +702,7 @@ static void setup_IoTHubTransport_MQTT_Common_Create_mocks(bool use_gateway)
             .IgnoreArgument_psz();
     }
 
+    STRICT_EXPECTED_CALL(retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, TEST_DEVICE_ID));
     EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG));
 }
 
@@ -718,23 +747,19 @@ static void setup_message_recv_with_properties_mocks()
 
 static void setup_initialize_connection_mocks()
 {
-    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2);
-    STRICT_EXPECTED_CALL(STRING_new());
+    STRICT_EXPECTED_CALL(retry_control_should_retry(TEST_RETRY_CONTROL_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_retryAction();
+    STRICT_EXPECTED_CALL(sastoken_cache_get_token(TEST_SASTOKEN_CACHE_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_creationTime();
     STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
-    EXPECTED_CALL(SASToken_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_DEVICE_ID);
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_STRING_VALUE);
-    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_SAS_TOKEN);
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_HOST_NAME);
     EXPECTED_CALL(mqtt_client_connect(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(1)
         .IgnoreArgument(2);
-    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(1)
         .IgnoreArgument(2);
@@ -1106,7 +1131,7 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_Create_validConfig_fail)
 
     umock_c_negative_tests_snapshot();
 
-    size_t calls_cannot_fail[] = { 5, 6 };
+    size_t calls_cannot_fail[] = { 7 };
 
     // act
     size_t count = umock_c_negative_tests_call_count();
@@ -1162,6 +1187,7 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_Destroy_Unsubscribe_succeeds)
 
     EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
 
+    STRICT_EXPECTED_CALL(sastoken_cache_destroy(TEST_SASTOKEN_CACHE_HANDLE));
     EXPECTED_CALL(STRING_delete(NULL));
     EXPECTED_CALL(STRING_delete(NULL));
     EXPECTED_CALL(STRING_delete(NULL));
@@ -1177,6 +1203,7 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_Destroy_Unsubscribe_succeeds)
         .IgnoreArgument(3);
     EXPECTED_CALL(gballoc_free(NULL));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_XIO_HANDLE));
+    STRICT_EXPECTED_CALL(retry_control_destroy(TEST_RETRY_CONTROL_HANDLE));
     STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_COUNTER_HANDLE));
 
     // act
@@ -1222,6 +1249,7 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_Destroy_One_Message_Ack_succeeds)
         .IgnoreArgument(2);
     EXPECTED_CALL(gballoc_free(NULL));
     EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(sastoken_cache_destroy(TEST_SASTOKEN_CACHE_HANDLE));
     EXPECTED_CALL(STRING_delete(NULL));
     EXPECTED_CALL(STRING_delete(NULL));
     STRICT_EXPECTED_CALL(mqtt_client_deinit(TEST_MQTT_CLIENT_HANDLE)).IgnoreArgument(1);
@@ -1230,6 +1258,7 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_Destroy_One_Message_Ack_succeeds)
     EXPECTED_CALL(STRING_delete(NULL));
     EXPECTED_CALL(STRING_delete(NULL));
     EXPECTED_CALL(STRING_delete(NULL));
+    STRICT_EXPECTED_CALL(retry_control_destroy(TEST_RETRY_CONTROL_HANDLE));
     STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_COUNTER_HANDLE)).IgnoreArgument(1);
     EXPECTED_CALL(gballoc_free(NULL));
 
@@ -1252,6 +1281,7 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_Destroy_succeeds)
 
     EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
 
+    STRICT_EXPECTED_CALL(sastoken_cache_destroy(TEST_SASTOKEN_CACHE_HANDLE));
     EXPECTED_CALL(STRING_delete(NULL));
     EXPECTED_CALL(STRING_delete(NULL));
     EXPECTED_CALL(STRING_delete(NULL));
@@ -1264,6 +1294,7 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_Destroy_succeeds)
     STRICT_EXPECTED_CALL(mqtt_client_disconnect(TEST_MQTT_CLIENT_HANDLE));
     EXPECTED_CALL(xio_destroy(NULL));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(retry_control_destroy(TEST_RETRY_CONTROL_HANDLE));
     STRICT_EXPECTED_CALL(tickcounter_destroy(IGNORED_PTR_ARG)).IgnoreArgument(1);
 
     // act
@@ -1831,6 +1862,77 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_SetOption_keepAlive_same_value_succeed
     IoTHubTransport_MQTT_Common_Destroy(handle);
 }
 
+/* Tests_SRS_IOTHUB_MQTT_TRANSPORT_02_022: [ If the option parameter is set to "sas_token_reuse_percent" then the value shall be a size_t* giving the percent of the SAS token lifetime during which the token is reused on reconnect. ] */
+TEST_FUNCTION(IoTHubTransport_MQTT_Common_SetOption_sas_token_reuse_percent_succeed)
+{
+    // arrange
+    IOTHUBTRANSPORT_CONFIG config = { 0 };
+    SetupIothubTransportConfig(&config, TEST_DEVICE_ID, TEST_DEVICE_KEY, TEST_IOTHUB_NAME, TEST_IOTHUB_SUFFIX, TEST_PROTOCOL_GATEWAY_HOSTNAME);
+
+    TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
+    umock_c_reset_all_calls();
+
+    size_t reusePercent = 60;
+    STRICT_EXPECTED_CALL(sastoken_cache_set_lifetime(TEST_SASTOKEN_CACHE_HANDLE, IGNORED_NUM_ARG, 60))
+        .IgnoreArgument_lifetimeInSeconds();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransport_MQTT_Common_SetOption(handle, OPTION_SAS_TOKEN_REUSE_PERCENT, &reusePercent);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransport_MQTT_Common_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUB_MQTT_TRANSPORT_02_023: [ If the credentials are not a device key, or if the value is not below the reconnect threshold of 80 percent, IoTHubTransportMqtt_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ] */
+TEST_FUNCTION(IoTHubTransport_MQTT_Common_SetOption_sas_token_reuse_percent_above_reconnect_threshold_fails)
+{
+    // arrange
+    IOTHUBTRANSPORT_CONFIG config = { 0 };
+    SetupIothubTransportConfig(&config, TEST_DEVICE_ID, TEST_DEVICE_KEY, TEST_IOTHUB_NAME, TEST_IOTHUB_SUFFIX, TEST_PROTOCOL_GATEWAY_HOSTNAME);
+
+    TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
+    umock_c_reset_all_calls();
+
+    size_t reusePercent = 80;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransport_MQTT_Common_SetOption(handle, OPTION_SAS_TOKEN_REUSE_PERCENT, &reusePercent);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransport_MQTT_Common_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUB_MQTT_TRANSPORT_02_023: [ If the credentials are not a device key, or if the value is not below the reconnect threshold of 80 percent, IoTHubTransportMqtt_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ] */
+TEST_FUNCTION(IoTHubTransport_MQTT_Common_SetOption_sas_token_reuse_percent_without_device_key_fails)
+{
+    // arrange
+    IOTHUBTRANSPORT_CONFIG config = { 0 };
+    SetupIothubTransportConfigWithKeyAndSasToken(&config, TEST_DEVICE_ID, NULL, TEST_DEVICE_SAS, TEST_IOTHUB_NAME, TEST_IOTHUB_SUFFIX, TEST_PROTOCOL_GATEWAY_HOSTNAME);
+
+    TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
+    umock_c_reset_all_calls();
+
+    size_t reusePercent = 50;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransport_MQTT_Common_SetOption(handle, OPTION_SAS_TOKEN_REUSE_PERCENT, &reusePercent);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransport_MQTT_Common_Destroy(handle);
+}
+
 TEST_FUNCTION(IoTHubTransportMqtt_mqtt_operation_complete_msgInfo_NULL_succeed)
 {
     // arrange
@@ -1898,23 +2000,19 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_DoWork_mqtt_client_connect_fail)
     TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2);
-    STRICT_EXPECTED_CALL(STRING_new());
+    STRICT_EXPECTED_CALL(retry_control_should_retry(TEST_RETRY_CONTROL_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_retryAction();
+    STRICT_EXPECTED_CALL(sastoken_cache_get_token(TEST_SASTOKEN_CACHE_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_creationTime();
     STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
-    EXPECTED_CALL(SASToken_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_DEVICE_ID);
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_STRING_VALUE);
-    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_SAS_TOKEN);
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_HOST_NAME);
     EXPECTED_CALL(mqtt_client_connect(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(1)
         .IgnoreArgument(2);
-    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(1)
         .IgnoreArgument(2);
@@ -2021,11 +2119,9 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_DoWork_SAS_token_from_user_succeed)
     TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2);
-    STRICT_EXPECTED_CALL(STRING_new());
-    EXPECTED_CALL(STRING_clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(retry_control_should_retry(TEST_RETRY_CONTROL_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_retryAction();
+    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_SAS_TOKEN);
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_STRING_VALUE);
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_STRING_VALUE);
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_STRING_VALUE);
@@ -2033,8 +2129,6 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_DoWork_SAS_token_from_user_succeed)
     STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(1)
         .IgnoreArgument(2);
-    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(1)
         .IgnoreArgument(2);
@@ -2061,10 +2155,8 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_DoWork_x509_succeed)
     TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_COUNTER_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2);
-    STRICT_EXPECTED_CALL(STRING_new());
+    STRICT_EXPECTED_CALL(retry_control_should_retry(TEST_RETRY_CONTROL_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_retryAction();
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_STRING_VALUE);
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_STRING_VALUE);
     EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_STRING_VALUE);
@@ -2072,8 +2164,6 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_DoWork_x509_succeed)
     STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_COUNTER_HANDLE, IGNORED_PTR_ARG))
         .IgnoreArgument(1)
         .IgnoreArgument(2);
-    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
 
     STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_COUNTER_HANDLE, IGNORED_PTR_ARG))
         .IgnoreArgument(1)
@@ -2462,6 +2552,139 @@ TEST_FUNCTION(IoTHubTransport_MQTT_Common_DoWork_connectFailCount_exceed_succeed
     IoTHubTransport_MQTT_Common_Destroy(handle);
 }
 
+/* Tests_SRS_IOTHUB_MQTT_TRANSPORT_02_011: [ Before connecting IoTHubTransportMqtt_DoWork shall ask the retry control whether a connection attempt can be made now, and only connect when the answer is RETRY_ACTION_RETRY_NOW. ] */
+TEST_FUNCTION(IoTHubTransport_MQTT_Common_DoWork_retry_later_does_not_connect)
+{
+    // arrange
+    IOTHUBTRANSPORT_CONFIG config ={ 0 };
+    SetupIothubTransportConfig(&config, TEST_DEVICE_ID, TEST_DEVICE_KEY, TEST_IOTHUB_NAME, TEST_IOTHUB_SUFFIX, TEST_PROTOCOL_GATEWAY_HOSTNAME);
+
+    TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
+    umock_c_reset_all_calls();
+    g_retryAction = RETRY_ACTION_RETRY_LATER;
+
+    STRICT_EXPECTED_CALL(retry_control_should_retry(TEST_RETRY_CONTROL_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_retryAction();
+
+    // act
+    IoTHubTransport_MQTT_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransport_MQTT_Common_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUB_MQTT_TRANSPORT_02_011: [ Before connecting IoTHubTransportMqtt_DoWork shall ask the retry control whether a connection attempt can be made now, and only connect when the answer is RETRY_ACTION_RETRY_NOW. ] */
+TEST_FUNCTION(IoTHubTransport_MQTT_Common_DoWork_stop_retrying_does_not_connect)
+{
+    // arrange
+    IOTHUBTRANSPORT_CONFIG config ={ 0 };
+    SetupIothubTransportConfig(&config, TEST_DEVICE_ID, TEST_DEVICE_KEY, TEST_IOTHUB_NAME, TEST_IOTHUB_SUFFIX, TEST_PROTOCOL_GATEWAY_HOSTNAME);
+
+    TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
+    umock_c_reset_all_calls();
+    g_retryAction = RETRY_ACTION_STOP_RETRYING;
+
+    STRICT_EXPECTED_CALL(retry_control_should_retry(TEST_RETRY_CONTROL_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_retryAction();
+
+    // act
+    IoTHubTransport_MQTT_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransport_MQTT_Common_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUB_MQTT_TRANSPORT_02_012: [ When the CONNACK accepts the connection the retry control shall be reset. ] */
+TEST_FUNCTION(IoTHubTransport_MQTT_Common_connack_accepted_resets_retry_control)
+{
+    // arrange
+    IOTHUBTRANSPORT_CONFIG config ={ 0 };
+    SetupIothubTransportConfig(&config, TEST_DEVICE_ID, TEST_DEVICE_KEY, TEST_IOTHUB_NAME, TEST_IOTHUB_SUFFIX, TEST_PROTOCOL_GATEWAY_HOSTNAME);
+
+    TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
+    IoTHubTransport_MQTT_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(retry_control_reset(TEST_RETRY_CONTROL_HANDLE));
+
+    CONNECT_ACK connack ={ true, CONNECTION_ACCEPTED };
+
+    // act
+    g_fnMqttOperationCallback(TEST_MQTT_CLIENT_HANDLE, MQTT_CLIENT_ON_CONNACK, &connack, g_callbackCtx);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransport_MQTT_Common_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUB_MQTT_TRANSPORT_02_014: [ If handle is NULL then IoTHubTransportMqtt_SetRetryPolicy shall fail and return a non-zero value. ] */
+TEST_FUNCTION(IoTHubTransport_MQTT_Common_SetRetryPolicy_handle_NULL_fails)
+{
+    // arrange
+
+    // act
+    int result = IoTHubTransport_MQTT_Common_SetRetryPolicy(NULL, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_IOTHUB_MQTT_TRANSPORT_02_015: [ IoTHubTransportMqtt_SetRetryPolicy shall pass the policy and the timeout limit to the retry control and return what retry_control_set_policy returns. ] */
+TEST_FUNCTION(IoTHubTransport_MQTT_Common_SetRetryPolicy_succeeds)
+{
+    // arrange
+    IOTHUBTRANSPORT_CONFIG config ={ 0 };
+    SetupIothubTransportConfig(&config, TEST_DEVICE_ID, TEST_DEVICE_KEY, TEST_IOTHUB_NAME, TEST_IOTHUB_SUFFIX, TEST_PROTOCOL_GATEWAY_HOSTNAME);
+
+    TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(retry_control_set_policy(TEST_RETRY_CONTROL_HANDLE, IOTHUB_CLIENT_RETRY_INTERVAL, 10));
+
+    // act
+    int result = IoTHubTransport_MQTT_Common_SetRetryPolicy(handle, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransport_MQTT_Common_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUB_MQTT_TRANSPORT_02_015: [ IoTHubTransportMqtt_SetRetryPolicy shall pass the policy and the timeout limit to the retry control and return what retry_control_set_policy returns. ] */
+TEST_FUNCTION(IoTHubTransport_MQTT_Common_SetRetryPolicy_fails_when_retry_control_set_policy_fails)
+{
+    // arrange
+    IOTHUBTRANSPORT_CONFIG config ={ 0 };
+    SetupIothubTransportConfig(&config, TEST_DEVICE_ID, TEST_DEVICE_KEY, TEST_IOTHUB_NAME, TEST_IOTHUB_SUFFIX, TEST_PROTOCOL_GATEWAY_HOSTNAME);
+
+    TRANSPORT_LL_HANDLE handle = IoTHubTransport_MQTT_Common_Create(&config, get_IO_transport);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(retry_control_set_policy(TEST_RETRY_CONTROL_HANDLE, IOTHUB_CLIENT_RETRY_INTERVAL, 10))
+        .SetReturn(__LINE__);
+
+    // act
+    int result = IoTHubTransport_MQTT_Common_SetRetryPolicy(handle, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransport_MQTT_Common_Destroy(handle);
+}
+
 /* Test_SRS_IOTHUB_MQTT_TRANSPORT_07_023: [IoTHubTransport_MQTT_Common_GetSendStatus shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL parameter.] */
 TEST_FUNCTION(IoTHubTransport_MQTT_Common_GetSendStatus_InvalidHandleArgument_fail)
 {
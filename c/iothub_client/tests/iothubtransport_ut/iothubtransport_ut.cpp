@@ -57,6 +57,7 @@ static MICROMOCK_GLOBAL_SEMAPHORE_HANDLE g_dllByDll;
 //Check ProtocolGateway Configuration.
 static bool checkProtocolGatewayHostName;
 static bool checkProtocolGatewayIsNull;
+static IOTHUB_CLIENT_METRICS* g_transportMetrics; /*the metrics given to the lower layer in IOTHUBTRANSPORT_CONFIG*/
 static size_t howManyDoWorkCalls = 0;
 static size_t doWorkCallCount = 0;
 extern "C" const size_t IoTHubTransport_ThreadTerminationOffset;
@@ -185,6 +186,7 @@ public:
 
 		MOCK_STATIC_METHOD_1(, TRANSPORT_LL_HANDLE, FAKE_IoTHubTransport_Create, const IOTHUBTRANSPORT_CONFIG*, config)
 		TRANSPORT_LL_HANDLE result2;
+	g_transportMetrics = (config != NULL) ? config->metrics : NULL;
 	if (checkProtocolGatewayHostName)
 	{
 		if (config != NULL && config->upperConfig != NULL && config->upperConfig->protocolGatewayHostName != NULL && strcmp(config->upperConfig->protocolGatewayHostName, TEST_CHAR) == 0)
@@ -242,6 +244,9 @@ public:
 		*iotHubClientStatus = currentIotHubClientStatus;
 	MOCK_METHOD_END(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK)
 
+		MOCK_STATIC_METHOD_3(, int, FAKE_IoTHubTransport_SetRetryPolicy, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds)
+	MOCK_METHOD_END(int, 0)
+
 		MOCK_STATIC_METHOD_2(, void, eventConfirmationCallback, IOTHUB_CLIENT_CONFIRMATION_RESULT, result2, void*, userContextCallback)
 		MOCK_VOID_METHOD_END()
 
@@ -376,6 +381,7 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CIotHubTransportMocks, , int, FAKE_IoTHubTransport_
 DECLARE_GLOBAL_MOCK_METHOD_1(CIotHubTransportMocks, , void, FAKE_IoTHubTransport_Unsubscribe, TRANSPORT_LL_HANDLE, handle);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIotHubTransportMocks, , void, FAKE_IoTHubTransport_DoWork, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIotHubTransportMocks, , IOTHUB_CLIENT_RESULT, FAKE_IoTHubTransport_GetSendStatus, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_STATUS*, iotHubClientStatus);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIotHubTransportMocks, , int, FAKE_IoTHubTransport_SetRetryPolicy, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds);
 
 DECLARE_GLOBAL_MOCK_METHOD_2(CIotHubTransportMocks, , void, eventConfirmationCallback, IOTHUB_CLIENT_CONFIRMATION_RESULT, result2, void*, userContextCallback);
 
@@ -428,7 +434,8 @@ static TRANSPORT_PROVIDER FAKE_transport_provider =
 	FAKE_IoTHubTransport_Subscribe,     /*pfIoTHubTransport_Subscribe IoTHubTransport_Subscribe;        */
 	FAKE_IoTHubTransport_Unsubscribe,   /*pfIoTHubTransport_Unsubscribe IoTHubTransport_Unsubscribe;    */
 	FAKE_IoTHubTransport_DoWork,        /*pfIoTHubTransport_DoWork IoTHubTransport_DoWork;              */
-	FAKE_IoTHubTransport_GetSendStatus  /*pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus; */
+	FAKE_IoTHubTransport_GetSendStatus, /*pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus; */
+	FAKE_IoTHubTransport_SetRetryPolicy /*pfIoTHubTransport_SetRetryPolicy IoTHubTransport_SetRetryPolicy; */
 };
 
 static const TRANSPORT_PROVIDER* provideFAKE(void)
@@ -462,6 +469,7 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
 	whenShallmalloc_fail = 0;
 	checkProtocolGatewayHostName = false;
 	checkProtocolGatewayIsNull = false;
+	g_transportMetrics = NULL;
 	howManyDoWorkCalls = 0;
 	doWorkCallCount = 0;
 
@@ -1349,5 +1357,64 @@ TEST_FUNCTION(IoTHubTransport_worker_thread_runs_lock_fails)
 	IoTHubTransport_Destroy(transportHandle);
 }
 
+/*Tests_SRS_IOTHUBTRANSPORT_02_002: [ If transportHandle or snapshot is NULL, IoTHubTransport_GetMetrics shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubTransport_GetMetrics_with_NULL_handle_fails)
+{
+	CIotHubTransportMocks mocks;
+	///arrange
+	IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+
+	///act
+	IOTHUB_CLIENT_RESULT result = IoTHubTransport_GetMetrics(NULL, &snapshot);
+
+	///assert
+	ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+	mocks.AssertActualAndExpectedCalls();
+}
+
+/*Tests_SRS_IOTHUBTRANSPORT_02_002: [ If transportHandle or snapshot is NULL, IoTHubTransport_GetMetrics shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubTransport_GetMetrics_with_NULL_snapshot_fails)
+{
+	CIotHubTransportMocks mocks;
+	///arrange
+	auto transportHandle = IoTHubTransport_Create(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix);
+	mocks.ResetAllCalls();
+
+	///act
+	IOTHUB_CLIENT_RESULT result = IoTHubTransport_GetMetrics(transportHandle, NULL);
+
+	///assert
+	ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+	mocks.AssertActualAndExpectedCalls();
+
+	///cleanup
+	IoTHubTransport_Destroy(transportHandle);
+}
+
+/*Tests_SRS_IOTHUBTRANSPORT_02_001: [ IoTHubTransport_Create shall start the metrics of the transport at 0 and give them to the lower layer transport in the metrics field of IOTHUBTRANSPORT_CONFIG. ]*/
+/*Tests_SRS_IOTHUBTRANSPORT_02_003: [ Otherwise IoTHubTransport_GetMetrics shall copy the metrics of the transport to snapshot by calling iothub_client_metrics_get_snapshot, without taking the transport lock, and return IOTHUB_CLIENT_OK. ]*/
+TEST_FUNCTION(IoTHubTransport_GetMetrics_returns_what_the_lower_layer_counted)
+{
+	CIotHubTransportMocks mocks;
+	///arrange
+	IOTHUB_CLIENT_METRICS_SNAPSHOT snapshot;
+	auto transportHandle = IoTHubTransport_Create(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix);
+	ASSERT_IS_NOT_NULL(g_transportMetrics);
+	iothub_client_metrics_add(g_transportMetrics, IOTHUB_CLIENT_METRIC_TRANSPORT_EVENTS_SENT, 3);
+	mocks.ResetAllCalls();
+
+	///act
+	IOTHUB_CLIENT_RESULT result = IoTHubTransport_GetMetrics(transportHandle, &snapshot);
+
+	///assert
+	ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+	ASSERT_ARE_EQUAL(uint64_t, 3, snapshot.values[IOTHUB_CLIENT_METRIC_TRANSPORT_EVENTS_SENT]);
+	ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.values[IOTHUB_CLIENT_METRIC_TRANSPORT_CONNECTS]);
+	mocks.AssertActualAndExpectedCalls();
+
+	///cleanup
+	IoTHubTransport_Destroy(transportHandle);
+}
+
 END_TEST_SUITE(iothubtransport_ut)
 
@@ -22,7 +22,6 @@ static MICROMOCK_GLOBAL_SEMAPHORE_HANDLE g_dllByDll;
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/urlencode.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
-#include "azure_c_shared_utility/sastoken.h"
 #include "azure_c_shared_utility/tlsio_schannel.h"
 #include "azure_c_shared_utility/tlsio_openssl.h"
 #include "azure_c_shared_utility/platform.h"
@@ -36,6 +35,8 @@ static MICROMOCK_GLOBAL_SEMAPHORE_HANDLE g_dllByDll;
 #include "iothub_client_options.h"
 #include "iothub_client_private.h"
 #include "iothub_message.h"
+#include "iothub_client_retry_control.h"
+#include "iothub_client_sastoken_cache.h"
 
 #include "azure_uamqp_c/amqpvalue.h"
 #include "azure_uamqp_c/amqpvalue_to_string.h"
@@ -163,6 +164,8 @@ std::ostream& operator<<(std::ostream& left, const BINARY_DATA bindata)
 #define TEST_CONNECTION (CONNECTION_HANDLE)0x110
 #define TEST_SESSION (SESSION_HANDLE)0x120
 #define TEST_CBS (CBS_HANDLE)0x130
+#define TEST_RETRY_CONTROL (RETRY_CONTROL_HANDLE)0x132
+#define TEST_SASTOKEN_CACHE (SASTOKEN_CACHE_HANDLE)0x134
 #define TEST_SAS_TOKEN "SharedAccessSignature sr=" TEST_IOT_HUB_NAME "." TEST_IOT_HUB_SUFFIX "/devices/" TEST_DEVICE_ID "&sig=up5khAl%2fsAI2s4fJ7OnLQBRPrb4y4Z53K%2fJMn1Leu4Q%3d&se=1453961445&skn="
 #define TEST_MESSAGESENDER_SOURCE (AMQP_VALUE)0x140
 #define TEST_MESSAGESENDER_TARGET (AMQP_VALUE)0x142
@@ -219,7 +222,6 @@ static const char* const* two_property_values_ptr = two_property_values;
 static size_t two_properties_size = 2;
 
 static time_t test_current_time;
-static size_t test_latest_SASToken_expiry_time = 0;
 static ON_CBS_OPERATION_COMPLETE test_latest_cbs_put_token_callback;
 static void* test_latest_cbs_put_token_context;
 static int test_number_of_event_confirmation_callbacks_invoked;
@@ -242,6 +244,8 @@ void* saved_on_message_receiver_state_changed_context;
 
 static ON_MESSAGE_RECEIVED saved_on_message_received_callback;
 static const void* saved_on_message_received_context;
+static ON_MESSAGE_SEND_COMPLETE saved_on_message_send_complete_callback;
+static void* saved_on_message_send_complete_context;
 static BINARY_DATA* saved_message_get_body_amqp_data_binary_data;
 static PROPERTIES_HANDLE saved_message_get_properties_properties = TEST_UAMQP_PROPERTIES;
 static PROPERTIES_HANDLE saved_message_set_properties_properties;
@@ -253,6 +257,7 @@ static int test_amqpvalue_get_string_length = 10;
 static AMQP_VALUE test_message_get_application_properties_return = TEST_AMQP_MAP_VALUE;
 
 static int test_amqpvalue_get_map_pair_count = 1;
+static RETRY_ACTION test_retry_action = RETRY_ACTION_RETRY_NOW;
 
 // **  Mocks **
 TYPED_MOCK_CLASS(CIoTHubTransportAMQPMocks, CGlobalMock)
@@ -375,6 +380,10 @@ public:
         BASEIMPLEMENTATION::DList_InsertTailList(listHead, listEntry);
     MOCK_VOID_METHOD_END()
 
+    MOCK_STATIC_METHOD_2(, void, DList_InsertHeadList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, listEntry)
+        BASEIMPLEMENTATION::DList_InsertHeadList(listHead, listEntry);
+    MOCK_VOID_METHOD_END()
+
     MOCK_STATIC_METHOD_2(, void, DList_AppendTailList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, ListToAppend)
         BASEIMPLEMENTATION::DList_AppendTailList(listHead, ListToAppend);
     MOCK_VOID_METHOD_END()
@@ -480,7 +489,8 @@ public:
         PDLIST_ENTRY oldest;
         while ((oldest = BASEIMPLEMENTATION::DList_RemoveHeadList(completedMessages)) != completedMessages)
         {
-            ;
+            /*like the LL client, frees the completed events*/
+            BASEIMPLEMENTATION::gballoc_free(containingRecord(oldest, IOTHUB_MESSAGE_LIST, entry));
         }
     MOCK_VOID_METHOD_END();
 
@@ -496,10 +506,6 @@ public:
 	MOCK_STATIC_METHOD_2(, double, get_difftime, time_t, stop_time, time_t, start_time)
 		double get_difftime = BASEIMPLEMENTATION::get_difftime(stop_time, start_time);
 	MOCK_METHOD_END(double, get_difftime);
-    MOCK_STATIC_METHOD_4(, STRING_HANDLE, SASToken_Create, STRING_HANDLE, key, STRING_HANDLE, scope, STRING_HANDLE, keyName, size_t, expiry)
-        test_latest_SASToken_expiry_time = expiry;
-    MOCK_METHOD_END(STRING_HANDLE, BASEIMPLEMENTATION::STRING_construct(TEST_SAS_TOKEN));
-
     // xio.h
     MOCK_STATIC_METHOD_2(, XIO_HANDLE, xio_create, const IO_INTERFACE_DESCRIPTION*, io_interface_description, const void*, io_create_parameters)
     MOCK_METHOD_END(XIO_HANDLE, 0)
@@ -725,6 +731,8 @@ public:
     MOCK_METHOD_END(int, 0)
 
     MOCK_STATIC_METHOD_4(, int, messagesender_send, MESSAGE_SENDER_HANDLE, message_sender, MESSAGE_HANDLE, message, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context)
+        saved_on_message_send_complete_callback = on_message_send_complete;
+        saved_on_message_send_complete_context = callback_context;
     MOCK_METHOD_END(int, 0)
 
     // messaging.h
@@ -851,6 +859,44 @@ public:
 	MOCK_STATIC_METHOD_2(, int, IoTHubMessage_CreateFromUamqpMessage, MESSAGE_HANDLE, uamqp_message, IOTHUB_MESSAGE_HANDLE*, iothub_message)
 		*iothub_message = TEST_IOTHUB_MESSAGE_HANDLE;
 	MOCK_METHOD_END(int, 0)
+
+    // iothub_client_retry_control.h
+    MOCK_STATIC_METHOD_3(, RETRY_CONTROL_HANDLE, retry_control_create, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds, const char*, deviceId)
+    MOCK_METHOD_END(RETRY_CONTROL_HANDLE, TEST_RETRY_CONTROL)
+
+    MOCK_STATIC_METHOD_1(, void, retry_control_destroy, RETRY_CONTROL_HANDLE, retryControlHandle)
+    MOCK_VOID_METHOD_END()
+
+    MOCK_STATIC_METHOD_3(, int, retry_control_set_policy, RETRY_CONTROL_HANDLE, retryControlHandle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds)
+    MOCK_METHOD_END(int, 0)
+
+    MOCK_STATIC_METHOD_2(, int, retry_control_should_retry, RETRY_CONTROL_HANDLE, retryControlHandle, RETRY_ACTION*, retryAction)
+        *retryAction = test_retry_action;
+    MOCK_METHOD_END(int, 0)
+
+    MOCK_STATIC_METHOD_1(, void, retry_control_reset, RETRY_CONTROL_HANDLE, retryControlHandle)
+    MOCK_VOID_METHOD_END()
+
+    // iothub_client_sastoken_cache.h
+    MOCK_STATIC_METHOD_3(, SASTOKEN_CACHE_HANDLE, sastoken_cache_create, STRING_HANDLE, key, STRING_HANDLE, scope, STRING_HANDLE, keyName)
+    MOCK_METHOD_END(SASTOKEN_CACHE_HANDLE, TEST_SASTOKEN_CACHE)
+
+    MOCK_STATIC_METHOD_1(, void, sastoken_cache_destroy, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle)
+    MOCK_VOID_METHOD_END()
+
+    MOCK_STATIC_METHOD_3(, int, sastoken_cache_set_lifetime, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle, size_t, lifetimeInSeconds, size_t, reusePercent)
+    MOCK_METHOD_END(int, 0)
+
+    MOCK_STATIC_METHOD_2(, const char*, sastoken_cache_get_token, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle, size_t*, creationTime)
+        if (creationTime != NULL)
+        {
+            /*the cache signs a new token on every call in these tests*/
+            *creationTime = (size_t)difftime(time(NULL), 0);
+        }
+    MOCK_METHOD_END(const char*, TEST_SAS_TOKEN)
+
+    MOCK_STATIC_METHOD_1(, void, sastoken_cache_invalidate, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle)
+    MOCK_VOID_METHOD_END()
 };
 
 // ** End Mocks **
@@ -871,6 +917,7 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , const char*, IoTHubMes
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , void, DList_InitializeListHead, PDLIST_ENTRY, listHead);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , int, DList_IsListEmpty, PDLIST_ENTRY, listHead);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , void, DList_InsertTailList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, listEntry);
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , void, DList_InsertHeadList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, listEntry);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , void, DList_AppendTailList, PDLIST_ENTRY, listHead, PDLIST_ENTRY, ListToAppend);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , int, DList_RemoveEntryList, PDLIST_ENTRY, listEntry);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , PDLIST_ENTRY, DList_RemoveHeadList, PDLIST_ENTRY, listHead);
@@ -907,7 +954,6 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , time_t, get_time, time
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , struct tm*, get_gmtime, time_t*, t);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , time_t, get_mktime, struct tm*, t);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , double, get_difftime, time_t, stop_time, time_t, start_time);
-DECLARE_GLOBAL_MOCK_METHOD_4(CIoTHubTransportAMQPMocks, , STRING_HANDLE, SASToken_Create, STRING_HANDLE, key, STRING_HANDLE, scope, STRING_HANDLE, keyName, size_t, expiry);
 
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , int, mallocAndStrcpy_s, char**, destination, const char*, source);
 
@@ -1071,6 +1117,20 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , OPTIONHANDLER_HANDLE,
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , int, message_create_from_iothub_message, IOTHUB_MESSAGE_HANDLE, iothub_message, MESSAGE_HANDLE*, uamqp_message);
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , int, IoTHubMessage_CreateFromUamqpMessage, MESSAGE_HANDLE, uamqp_message, IOTHUB_MESSAGE_HANDLE*, iothub_message);
 
+// iothub_client_retry_control.h
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubTransportAMQPMocks, , RETRY_CONTROL_HANDLE, retry_control_create, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds, const char*, deviceId);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , void, retry_control_destroy, RETRY_CONTROL_HANDLE, retryControlHandle);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubTransportAMQPMocks, , int, retry_control_set_policy, RETRY_CONTROL_HANDLE, retryControlHandle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds);
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , int, retry_control_should_retry, RETRY_CONTROL_HANDLE, retryControlHandle, RETRY_ACTION*, retryAction);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , void, retry_control_reset, RETRY_CONTROL_HANDLE, retryControlHandle);
+
+// iothub_client_sastoken_cache.h
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubTransportAMQPMocks, , SASTOKEN_CACHE_HANDLE, sastoken_cache_create, STRING_HANDLE, key, STRING_HANDLE, scope, STRING_HANDLE, keyName);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , void, sastoken_cache_destroy, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubTransportAMQPMocks, , int, sastoken_cache_set_lifetime, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle, size_t, lifetimeInSeconds, size_t, reusePercent);
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , const char*, sastoken_cache_get_token, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle, size_t*, creationTime);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportAMQPMocks, , void, sastoken_cache_invalidate, SASTOKEN_CACHE_HANDLE, sasTokenCacheHandle);
+
 // Auxiliary Functions
 
 #define STEP_CREATE_LIST_INIT 0
@@ -1078,8 +1138,9 @@ DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportAMQPMocks, , int, IoTHubMessage_Cre
 #define STEP_CREATE_DEVICES_PATH 2
 #define STEP_CREATE_TARGET_ADDRESS 3
 #define STEP_CREATE_RECEIVE_ADDRESS 4
-#define STEP_CREATE_SASTOKEN_KEYNAME 5
-#define STEP_CREATE_DEVICEKEY 6
+#define STEP_CREATE_RETRY_CONTROL 5
+#define STEP_CREATE_SASTOKEN_KEYNAME 6
+#define STEP_CREATE_DEVICEKEY 7
 
 #define STEP_DOWORK_GET_TLS_IO 0
 #define STEP_DOWORK_CREATE_SASLMECHANISM 1
@@ -1182,6 +1243,10 @@ static void setExpectedCallsForTransportCreateUpTo(CIoTHubTransportAMQPMocks& mo
             EXPECTED_CALL(mocks, STRING_construct(0));
             EXPECTED_CALL(mocks, gballoc_free(0));
         }
+        else if (step == STEP_CREATE_RETRY_CONTROL)
+        {
+            STRICT_EXPECTED_CALL(mocks, retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, config->upperConfig->deviceId));
+        }
         else if (step == STEP_CREATE_SASTOKEN_KEYNAME)
         {
             STRICT_EXPECTED_CALL(mocks, STRING_new());
@@ -1189,6 +1254,8 @@ static void setExpectedCallsForTransportCreateUpTo(CIoTHubTransportAMQPMocks& mo
         else if (step == STEP_CREATE_DEVICEKEY)
         {
             STRICT_EXPECTED_CALL(mocks, STRING_construct(config->upperConfig->deviceKey)).IgnoreArgument(1);
+            STRICT_EXPECTED_CALL(mocks, sastoken_cache_create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+                .IgnoreAllArguments();
         }
     }
 }
@@ -1219,12 +1286,17 @@ static void setExpectedCleanupCallsForTransportCreateUpTo(CIoTHubTransportAMQPMo
         {
             EXPECTED_CALL(mocks, STRING_delete(0));
         }
+        else if (step == STEP_CREATE_RETRY_CONTROL)
+        {
+            EXPECTED_CALL(mocks, retry_control_destroy(0));
+        }
         else if (step == STEP_CREATE_SASTOKEN_KEYNAME)
         {
             EXPECTED_CALL(mocks, STRING_delete(0));
         }
         else if (step == STEP_CREATE_DEVICEKEY)
         {
+            EXPECTED_CALL(mocks, sastoken_cache_destroy(0));
             EXPECTED_CALL(mocks, STRING_delete(0));
         }
     }
@@ -1247,11 +1319,10 @@ static void setExpectedCallsForCbsAuthentication(CIoTHubTransportAMQPMocks& mock
 {
     (void)mocks;
 	setExpectedCallsForGetSecondsSinceEpoch(mocks, current_time);
-    EXPECTED_CALL(mocks, SASToken_Create(NULL, NULL, NULL, 0));
-    EXPECTED_CALL(mocks, STRING_c_str(NULL));
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_get_token(TEST_SASTOKEN_CACHE, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
     EXPECTED_CALL(mocks, STRING_c_str(NULL));
     EXPECTED_CALL(mocks, cbs_put_token(NULL, NULL, NULL, NULL, NULL, NULL));
-    EXPECTED_CALL(mocks, STRING_delete(NULL));
 }
 
 static void setExpectedCallsForCbsAuthTimeoutCheck(CIoTHubTransportAMQPMocks& mocks, time_t current_time)
@@ -1343,6 +1414,7 @@ static void setExpectedCallsForSendPendingEvents_SingleEvent(CIoTHubTransportAMQ
 
 	STRICT_EXPECTED_CALL(mocks, message_create_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG)).IgnoreArgument(2).SetReturn(0);
 
+    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
     EXPECTED_CALL(mocks, messagesender_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, message_destroy(TEST_MESSAGE_HANDLE));
 }
@@ -1393,12 +1465,14 @@ static void setExpectedCallsForTransportDestroy(CIoTHubTransportAMQPMocks& mocks
     EXPECTED_CALL(mocks, STRING_delete(0));
     EXPECTED_CALL(mocks, STRING_delete(0));
     EXPECTED_CALL(mocks, STRING_delete(0));
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_destroy(TEST_SASTOKEN_CACHE));
+    STRICT_EXPECTED_CALL(mocks, retry_control_destroy(TEST_RETRY_CONTROL));
 
     while (numberOfEventsInProgress-- > 0)
     {
         EXPECTED_CALL(mocks, DList_RemoveEntryList(0));
         EXPECTED_CALL(mocks, DList_InitializeListHead(0));
-        EXPECTED_CALL(mocks, DList_InsertTailList(0, 0));
+        EXPECTED_CALL(mocks, DList_InsertHeadList(0, 0));
     }
 
     EXPECTED_CALL(mocks, gballoc_free(NULL));
@@ -1408,6 +1482,8 @@ static void setExpectedCallsForTransportDoWorkUpTo(CIoTHubTransportAMQPMocks& mo
 {
     int step;
     (void)mocks;
+    STRICT_EXPECTED_CALL(mocks, retry_control_should_retry(TEST_RETRY_CONTROL, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
     for (step = 0; step <= maximumStepToSet; step++)
     {
         if (step == STEP_DOWORK_GET_TLS_IO)
@@ -1570,12 +1646,15 @@ static void resetTestSuiteState()
     fail_STRING_construct = false;
     saved_on_message_received_callback = NULL;
     saved_on_message_received_context = NULL;
+    saved_on_message_send_complete_callback = NULL;
+    saved_on_message_send_complete_context = NULL;
     saved_message_get_body_amqp_data_binary_data = NULL;
     test_amqpvalue_get_string_index = 0;
     saved_on_message_receiver_state_changed_callback = NULL;
     saved_on_message_receiver_state_changed_context = NULL;
     saved_on_message_sender_state_changed_callback = NULL;
     saved_on_message_sender_state_changed_context = NULL;
+    test_retry_action = RETRY_ACTION_RETRY_NOW;
 }
 
 static time_t addSecondsToTime(time_t reference_time, int seconds_to_add)
@@ -2091,6 +2170,63 @@ TEST_FUNCTION(AMQP_Create_receiveAddress_STRING_construct_fails)
     mocks.AssertActualAndExpectedCalls();
 }
 
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_013: [If creating the retry control fails IoTHubTransportAMQP_Create shall fail and return NULL]
+TEST_FUNCTION(AMQP_Create_retry_control_create_fails)
+{
+    // arrange
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+
+    mocks.ResetAllCalls();
+    setExpectedCallsForTransportCreateUpTo(mocks, &config, STEP_CREATE_RECEIVE_ADDRESS);
+    STRICT_EXPECTED_CALL(mocks, retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, TEST_DEVICE_ID))
+        .SetFailReturn((RETRY_CONTROL_HANDLE)NULL);
+    setExpectedCleanupCallsForTransportCreateUpTo(mocks, STEP_CREATE_RECEIVE_ADDRESS);
+
+    // act
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+
+    // assert
+    ASSERT_IS_NULL(transport);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_019: [If the credential is a device key, IoTHubTransportAMQP_Create shall create a SAS token cache for the device key, devicesPath and sasTokenKeyName.]
+TEST_FUNCTION(AMQP_Create_sastoken_cache_create_fails)
+{
+    // arrange
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+
+    mocks.ResetAllCalls();
+    setExpectedCallsForTransportCreateUpTo(mocks, &config, STEP_CREATE_SASTOKEN_KEYNAME);
+    STRICT_EXPECTED_CALL(mocks, STRING_construct(TEST_DEVICE_KEY));
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments()
+        .SetFailReturn((SASTOKEN_CACHE_HANDLE)NULL);
+    EXPECTED_CALL(mocks, STRING_delete(0));
+    setExpectedCleanupCallsForTransportCreateUpTo(mocks, STEP_CREATE_SASTOKEN_KEYNAME);
+
+    // act
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+
+    // assert
+    ASSERT_IS_NULL(transport);
+    mocks.AssertActualAndExpectedCalls();
+}
+
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_017: [If IoTHubTransportAMQP_Create fails to initialize handle->sasTokenKeyName with a zero-length STRING the function shall fail and return NULL.] 
 TEST_FUNCTION(AMQP_Create_sasTokenKeyName_allocation_fails)
 {
@@ -2106,9 +2242,9 @@ TEST_FUNCTION(AMQP_Create_sasTokenKeyName_allocation_fails)
     IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
 
     mocks.ResetAllCalls();
-    setExpectedCallsForTransportCreateUpTo(mocks, &config, STEP_CREATE_RECEIVE_ADDRESS);
+    setExpectedCallsForTransportCreateUpTo(mocks, &config, STEP_CREATE_RETRY_CONTROL);
     STRICT_EXPECTED_CALL(mocks, STRING_new()).SetFailReturn(TEST_NULL_STRING_HANDLE);
-    setExpectedCleanupCallsForTransportCreateUpTo(mocks, STEP_CREATE_RECEIVE_ADDRESS);
+    setExpectedCleanupCallsForTransportCreateUpTo(mocks, STEP_CREATE_RETRY_CONTROL);
 
     // act
     TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
@@ -2459,7 +2595,7 @@ TEST_FUNCTION(AMQP_DoWork_cbs_open_fails)
 
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_020: [IoTHubTransportAMQP_Create shall set parameter transport_state->sas_token_lifetime with the default value of 3600000 (milliseconds).] 
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_081: [IoTHubTransportAMQP_DoWork shall put a new SAS token if the one has not been out already, or if the previous one failed to be put due to timeout of cbs_put_token().] 
-// Tests_SRS_IOTHUBTRANSPORTAMQP_09_083: [SAS tokens expiration time shall be calculated using the number of seconds since Epoch UTC (Jan 1st 1970 00h00m00s000 GMT) to now (GMT), plus the 'sas_token_lifetime'.]
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_018: [The SAS token shall be obtained from sastoken_cache_get_token, which reuses the cached token on reconnect as long as it is younger than 'sas_token_refresh_time'.]
 TEST_FUNCTION(AMQP_DoWork_SASToken_create_fails)
 {
     // arrange
@@ -2473,12 +2609,13 @@ TEST_FUNCTION(AMQP_DoWork_SASToken_create_fails)
     IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
     TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
     time_t current_time = time(NULL);
-    size_t expected_expiry_time = (size_t)(difftime(current_time, 0) + TEST_SAS_TOKEN_LIFETIME_MS / 1000);
 
     mocks.ResetAllCalls();
     setExpectedCallsForTransportDoWorkUpTo(mocks, STEP_DOWORK_OPEN_CBS, DOWORK_MESSAGERECEIVER_NONE, current_time);
 	setExpectedCallsForGetSecondsSinceEpoch(mocks, current_time);
-    EXPECTED_CALL(mocks, SASToken_Create(NULL, NULL, NULL, 0)).SetReturn((STRING_HANDLE)NULL);
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_get_token(TEST_SASTOKEN_CACHE, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .SetReturn((const char*)NULL);
     setExpectedCallsForConnectionDestroyUpTo(mocks, STEP_DOWORK_CREATE_CBS);
 
     // act
@@ -2486,14 +2623,12 @@ TEST_FUNCTION(AMQP_DoWork_SASToken_create_fails)
 
     // assert
     mocks.AssertActualAndExpectedCalls();
-    ASSERT_ARE_EQUAL(size_t, expected_expiry_time, test_latest_SASToken_expiry_time);
 
     // cleanup
     transport_interface->IoTHubTransport_Destroy(transport);
 }
 
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_146: [If the SAS token fails to be sent to CBS (cbs_put_token), IoTHubTransportAMQP_DoWork shall fail and exit immediately]
-// Tests_SRS_IOTHUBTRANSPORTAMQP_09_145: [Each new SAS token created shall be deleted from memory immediately after sending it to CBS]
 TEST_FUNCTION(AMQP_DoWork_cbs_put_token_fails)
 {
     // arrange
@@ -2511,11 +2646,10 @@ TEST_FUNCTION(AMQP_DoWork_cbs_put_token_fails)
     mocks.ResetAllCalls();
     setExpectedCallsForTransportDoWorkUpTo(mocks, STEP_DOWORK_OPEN_CBS, DOWORK_MESSAGERECEIVER_NONE, current_time);
 	setExpectedCallsForGetSecondsSinceEpoch(mocks, current_time);
-    EXPECTED_CALL(mocks, SASToken_Create(NULL, NULL, NULL, 0));
-    EXPECTED_CALL(mocks, STRING_c_str(NULL));
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_get_token(TEST_SASTOKEN_CACHE, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
     EXPECTED_CALL(mocks, STRING_c_str(NULL));
     EXPECTED_CALL(mocks, cbs_put_token(NULL, NULL, NULL, NULL, NULL, NULL)).SetReturn(1);
-    EXPECTED_CALL(mocks, STRING_delete(NULL));
 
     setExpectedCallsForConnectionDestroyUpTo(mocks, STEP_DOWORK_CREATE_CBS);
 
@@ -3087,6 +3221,7 @@ TEST_FUNCTION(AMQP_DoWork_messagereceiver_open_fails)
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_055: [If the transport handle has a NULL connection, IoTHubTransportAMQP_DoWork shall instantiate and initialize the AMQP components and establish the connection] 
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_082: [IoTHubTransportAMQP_DoWork shall refresh the SAS token if the current token has been used for more than 'sas_token_refresh_time' milliseconds]
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_128: [IoTHubTransportAMQP_Create shall set parameter transport_state->sas_token_refresh_time with the default value of sas_token_lifetime/2 (milliseconds).] 
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_017: [When refreshing a SAS token that was already put, startAuthentication shall invalidate the SAS token cache so that a new token is signed.]
 TEST_FUNCTION(AMQP_DoWork_expired_SASToken_fails)
 {
     // arrange
@@ -3112,7 +3247,10 @@ TEST_FUNCTION(AMQP_DoWork_expired_SASToken_fails)
     setExpectedCallsForConnectionDoWork(mocks);
     setExpectedCallsForSASTokenExpiryCheck(mocks, expiration_time);
 	setExpectedCallsForGetSecondsSinceEpoch(mocks, current_time);
-    EXPECTED_CALL(mocks, SASToken_Create(NULL, NULL, NULL, 0)).SetReturn((STRING_HANDLE)NULL);
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_invalidate(TEST_SASTOKEN_CACHE));
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_get_token(TEST_SASTOKEN_CACHE, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .SetReturn((const char*)NULL);
     setExpectedCallsForConnectionDestroyUpTo(mocks, STEP_DOWORK_CREATE_CBS);
 
     // act
@@ -3200,12 +3338,13 @@ TEST_FUNCTION(AMQP_send_pending_events_parse_iothub_message_handle_fails)
 	EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 	STRICT_EXPECTED_CALL(mocks, message_create_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG)).IgnoreArgument(2).SetReturn(1);
 	STRICT_EXPECTED_CALL(mocks, message_destroy(TEST_MESSAGE_HANDLE)); // mocked function still assigns the MESSAGE_HANDLE, so need to expect a destroy.
-	STRICT_EXPECTED_CALL(mocks, test_iothubclient_send_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_ERROR, 0));
 	EXPECTED_CALL(mocks, DList_IsListEmpty(IGNORED_PTR_ARG)).SetReturn(0);
 	EXPECTED_CALL(mocks, DList_RemoveEntryList(IGNORED_PTR_ARG));
 	EXPECTED_CALL(mocks, DList_InitializeListHead(IGNORED_PTR_ARG));
-	STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Destroy(TEST_IOTHUB_MESSAGE_HANDLE));
-	EXPECTED_CALL(mocks, gballoc_free(NULL));
+	EXPECTED_CALL(mocks, DList_InitializeListHead(IGNORED_PTR_ARG));
+	EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_ERROR))
+		.IgnoreArgument(2);
 	EXPECTED_CALL(mocks, DList_IsListEmpty(IGNORED_PTR_ARG)).SetReturn(1);
 
 	setExpectedCallsForConnectionDoWork(mocks);
@@ -3223,6 +3362,193 @@ TEST_FUNCTION(AMQP_send_pending_events_parse_iothub_message_handle_fails)
 	cleanupList(config.waitingToSend);
 }
 
+static void setExpectedCallsForOnMessageSendComplete(CIoTHubTransportAMQPMocks& mocks, IOTHUB_CLIENT_CONFIRMATION_RESULT result)
+{
+    EXPECTED_CALL(mocks, DList_IsListEmpty(IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, DList_RemoveEntryList(IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, DList_InitializeListHead(IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, DList_InitializeListHead(IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, result))
+        .IgnoreArgument(2);
+    EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_09_100: [The callback 'on_message_send_complete' shall remove the target message from the in-progress list]
+// Tests_SRS_IOTHUBTRANSPORTAMQP_09_142: [The callback 'on_message_send_complete' shall pass to the upper layer callback an IOTHUB_CLIENT_CONFIRMATION_OK if the result received is MESSAGE_SEND_OK]
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_025: [The callback 'on_message_send_complete' shall complete the event by calling IoTHubClient_LL_SendComplete with a list that contains only the event, which calls the upper layer callback, destroys the message handle and frees the IOTHUB_MESSAGE_LIST instance]
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_026: [The callback 'on_message_send_complete' shall free the context that was given to messagesender_send]
+TEST_FUNCTION(AMQP_on_message_send_complete_OK_completes_the_event_through_IoTHubClient_LL_SendComplete)
+{
+    // arrange
+    resetTestSuiteState();
+
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    time_t current_time = time(NULL);
+
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+    addTestEvents(config.waitingToSend, 1, true);
+    setupSuccessfulDoWorkAndAuthenticate(transport, mocks, current_time);
+    ASSERT_IS_NOT_NULL((void*)saved_on_message_send_complete_callback);
+
+    setExpectedCallsForOnMessageSendComplete(mocks, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    // act
+    saved_on_message_send_complete_callback(saved_on_message_send_complete_context, MESSAGE_SEND_OK);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_IS_TRUE(BASEIMPLEMENTATION::DList_IsListEmpty(config.waitingToSend) != 0);
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+    cleanupList(config.waitingToSend);
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_09_143: [The callback 'on_message_send_complete' shall pass to the upper layer callback an IOTHUB_CLIENT_CONFIRMATION_ERROR if the result received is MESSAGE_SEND_ERROR]
+TEST_FUNCTION(AMQP_on_message_send_complete_ERROR_completes_the_event_through_IoTHubClient_LL_SendComplete)
+{
+    // arrange
+    resetTestSuiteState();
+
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    time_t current_time = time(NULL);
+
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+    addTestEvents(config.waitingToSend, 1, true);
+    setupSuccessfulDoWorkAndAuthenticate(transport, mocks, current_time);
+
+    setExpectedCallsForOnMessageSendComplete(mocks, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+
+    // act
+    saved_on_message_send_complete_callback(saved_on_message_send_complete_context, MESSAGE_SEND_ERROR);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+    cleanupList(config.waitingToSend);
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_025: [The callback 'on_message_send_complete' shall complete the event by calling IoTHubClient_LL_SendComplete with a list that contains only the event, which calls the upper layer callback, destroys the message handle and frees the IOTHUB_MESSAGE_LIST instance]
+TEST_FUNCTION(AMQP_on_message_send_complete_completes_an_event_without_callback_through_IoTHubClient_LL_SendComplete_for_the_batch_callback)
+{
+    // arrange
+    resetTestSuiteState();
+
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    time_t current_time = time(NULL);
+
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+    addTestEvents(config.waitingToSend, 1, false);
+    containingRecord(config.waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry)->callback = NULL;
+    containingRecord(config.waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry)->context = (void*)0x42;
+    setupSuccessfulDoWorkAndAuthenticate(transport, mocks, current_time);
+
+    /*the LL client gives the confirmation of an event sent without a callback to the batch callback*/
+    setExpectedCallsForOnMessageSendComplete(mocks, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    // act
+    saved_on_message_send_complete_callback(saved_on_message_send_complete_context, MESSAGE_SEND_OK);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+    cleanupList(config.waitingToSend);
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_028: [If allocating the context fails, IoTHubTransportAMQP_DoWork notify the failure, roll back the event to waitToSend list and return]
+TEST_FUNCTION(AMQP_DoWork_rolls_the_event_back_when_allocating_the_send_context_fails)
+{
+    // arrange
+    resetTestSuiteState();
+
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    time_t current_time = time(NULL);
+
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+    setupSuccessfulDoWorkAndAuthenticate(transport, mocks, current_time);
+    addTestEvents(config.waitingToSend, 1, true);
+    fail_malloc = true;
+
+    // act
+    transport_interface->IoTHubTransport_DoWork(transport, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    // assert
+    fail_malloc = false;
+    ASSERT_IS_NULL((void*)saved_on_message_send_complete_callback);
+    ASSERT_IS_TRUE(BASEIMPLEMENTATION::DList_IsListEmpty(config.waitingToSend) == 0);
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+    cleanupList(config.waitingToSend);
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_029: [An event rolled back to waitingToSend shall be put back at its head, the events rolled back together keeping the order in which they were taken, so waitingToSend stays in the order the upper layer built.]
+TEST_FUNCTION(AMQP_DoWork_rolls_the_event_back_at_the_head_of_waitingToSend)
+{
+    // arrange
+    resetTestSuiteState();
+
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    time_t current_time = time(NULL);
+
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+    setupSuccessfulDoWorkAndAuthenticate(transport, mocks, current_time);
+    addTestEvents(config.waitingToSend, 2, true);
+    fail_malloc = true;
+
+    // act
+    transport_interface->IoTHubTransport_DoWork(transport, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    // assert
+    fail_malloc = false;
+    ASSERT_ARE_EQUAL(void_ptr, (void*)1, containingRecord(config.waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry)->context);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0, containingRecord(config.waitingToSend->Blink, IOTHUB_MESSAGE_LIST, entry)->context);
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+    cleanupList(config.waitingToSend);
+}
+
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_191: [IoTHubTransportAMQP_DoWork shall create each AMQP message sender tracking its state changes with a callback function]
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_192: [If a message sender instance changes its state to MESSAGE_SENDER_STATE_ERROR (first transition only) the connection retry logic shall be triggered]
 TEST_FUNCTION(AMQP_messagesender_ERROR_state_change_triggers_reconnection)
@@ -3582,6 +3908,145 @@ TEST_FUNCTION(AMQP_on_message_received_callback_uamqp_message_parse_fails)
 	cleanupList(config.waitingToSend);
 }
 
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_014: [If the transport handle has a NULL connection, IoTHubTransportAMQP_DoWork shall ask the retry control whether the connection can be established now, and return without doing any work if it cannot]
+TEST_FUNCTION(AMQP_DoWork_retry_later_does_not_connect)
+{
+    // arrange
+    resetTestSuiteState();
+
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+    test_retry_action = RETRY_ACTION_RETRY_LATER;
+
+    mocks.ResetAllCalls();
+    STRICT_EXPECTED_CALL(mocks, retry_control_should_retry(TEST_RETRY_CONTROL, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
+
+    // act
+    transport_interface->IoTHubTransport_DoWork(transport, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+    test_retry_action = RETRY_ACTION_RETRY_NOW;
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_011: [When the message sender instance changes its state to MESSAGE_SENDER_STATE_OPEN the retry control shall be reset]
+TEST_FUNCTION(AMQP_event_sender_open_resets_retry_control)
+{
+    // arrange
+    resetTestSuiteState();
+
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    time_t current_time = time(NULL);
+
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+
+    setupSuccessfulDoWorkAndAuthenticate(transport, mocks, current_time);
+
+    mocks.ResetAllCalls();
+    STRICT_EXPECTED_CALL(mocks, retry_control_reset(TEST_RETRY_CONTROL));
+
+    // act
+    saved_on_message_sender_state_changed_callback(saved_on_message_sender_state_changed_context, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_015: [IoTHubTransportAMQP_SetRetryPolicy shall fail and return a non-zero value if the transport handle parameter is NULL]
+TEST_FUNCTION(AMQP_SetRetryPolicy_NULL_transport_fails)
+{
+    // arrange
+    CIoTHubTransportAMQPMocks mocks;
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+
+    mocks.ResetAllCalls();
+
+    // act
+    int result = transport_interface->IoTHubTransport_SetRetryPolicy(NULL, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_016: [IoTHubTransportAMQP_SetRetryPolicy shall pass the policy and the timeout limit to the retry control by calling retry_control_set_policy and return 0 on success, non-zero otherwise]
+TEST_FUNCTION(AMQP_SetRetryPolicy_succeeds)
+{
+    // arrange
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+
+    mocks.ResetAllCalls();
+    STRICT_EXPECTED_CALL(mocks, retry_control_set_policy(TEST_RETRY_CONTROL, IOTHUB_CLIENT_RETRY_INTERVAL, 10));
+
+    // act
+    int result = transport_interface->IoTHubTransport_SetRetryPolicy(transport, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_016: [IoTHubTransportAMQP_SetRetryPolicy shall pass the policy and the timeout limit to the retry control by calling retry_control_set_policy and return 0 on success, non-zero otherwise]
+TEST_FUNCTION(AMQP_SetRetryPolicy_fails_when_retry_control_set_policy_fails)
+{
+    // arrange
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+
+    mocks.ResetAllCalls();
+    STRICT_EXPECTED_CALL(mocks, retry_control_set_policy(TEST_RETRY_CONTROL, IOTHUB_CLIENT_RETRY_INTERVAL, 10))
+        .SetReturn(1);
+
+    // act
+    int result = transport_interface->IoTHubTransport_SetRetryPolicy(transport, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+}
+
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_044: [If handle parameter is NULL then IoTHubTransportAMQP_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.]
 TEST_FUNCTION(AMQP_SetOption_NULL_transport_fails)
 {
@@ -3664,6 +4129,97 @@ TEST_FUNCTION(AMQP_SetOption_NULL_value_fails)
     transport_interface->IoTHubTransport_Destroy(transport);
 }
 
+// Tests_SRS_IOTHUBTRANSPORTAMQP_09_048: [IotHubTransportAMQP_SetOption shall save and apply the value if the option name is "sas_token_lifetime", returning IOTHUB_CLIENT_OK] 
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_020: [When "sas_token_lifetime" or "sas_token_refresh_time" are set and the credential is a device key, IotHubTransportAMQP_SetOption shall call sastoken_cache_set_lifetime with the lifetime in seconds and the refresh time as a percent of the lifetime.]
+TEST_FUNCTION(AMQP_SetOption_sas_token_lifetime_updates_the_sastoken_cache)
+{
+    // arrange
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+    size_t lifetime = 7200000;
+
+    mocks.ResetAllCalls();
+    /*the default refresh time stays at 1800 seconds, that is 25% of the new lifetime*/
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_set_lifetime(TEST_SASTOKEN_CACHE, 7200, 25));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = transport_interface->IoTHubTransport_SetOption(transport, TEST_OPTION_SASTOKEN_LIFETIME, &lifetime);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_09_049: [IotHubTransportAMQP_SetOption shall save and apply the value if the option name is "sas_token_refresh_time", returning IOTHUB_CLIENT_OK] 
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_020: [When "sas_token_lifetime" or "sas_token_refresh_time" are set and the credential is a device key, IotHubTransportAMQP_SetOption shall call sastoken_cache_set_lifetime with the lifetime in seconds and the refresh time as a percent of the lifetime.]
+TEST_FUNCTION(AMQP_SetOption_sas_token_refresh_time_updates_the_sastoken_cache)
+{
+    // arrange
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+    size_t refresh_time = 2700000;
+
+    mocks.ResetAllCalls();
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_set_lifetime(TEST_SASTOKEN_CACHE, TEST_SAS_TOKEN_LIFETIME_MS / 1000, 75));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = transport_interface->IoTHubTransport_SetOption(transport, TEST_OPTION_SASTOKEN_REFRESH_TIME, &refresh_time);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+}
+
+// Tests_SRS_IOTHUBTRANSPORTAMQP_02_021: [If sastoken_cache_set_lifetime fails, IotHubTransportAMQP_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.]
+TEST_FUNCTION(AMQP_SetOption_sas_token_lifetime_fails_when_sastoken_cache_set_lifetime_fails)
+{
+    // arrange
+    CIoTHubTransportAMQPMocks mocks;
+
+    DLIST_ENTRY wts;
+    BASEIMPLEMENTATION::DList_InitializeListHead(&wts);
+    TRANSPORT_PROVIDER* transport_interface = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+    IOTHUB_CLIENT_CONFIG client_config = { (IOTHUB_CLIENT_TRANSPORT_PROVIDER)transport_interface,
+        TEST_DEVICE_ID, TEST_DEVICE_KEY, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL };
+    IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
+    TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
+    size_t lifetime = 500;
+
+    mocks.ResetAllCalls();
+    STRICT_EXPECTED_CALL(mocks, sastoken_cache_set_lifetime(TEST_SASTOKEN_CACHE, 0, 100))
+        .SetReturn(1);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = transport_interface->IoTHubTransport_SetOption(transport, TEST_OPTION_SASTOKEN_LIFETIME, &lifetime);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+    transport_interface->IoTHubTransport_Destroy(transport);
+}
+
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_047: [If the option name does not match one of the options handled by this module, then IoTHubTransportAMQP_SetOption shall get  the handle to the XIO and invoke the xio_setoption passing down the option name and value parameters.] 
 TEST_FUNCTION(AMQP_SetOption_invokes_xio_setoption_succeeds)
 {
@@ -4259,7 +4815,7 @@ TEST_FUNCTION(IoTHubTransportAMQP_Create_for_x509_succeeds)
         TEST_DEVICE_ID, NULL, NULL, TEST_IOT_HUB_NAME, TEST_IOT_HUB_SUFFIX, TEST_PROT_GW_HOSTNAME_NULL }; /*notice both deviceKey and deviceSasToken are NULL*/
     IOTHUBTRANSPORT_CONFIG config = { &client_config, &wts };
 
-    setExpectedCallsForTransportCreateUpTo(mocks, &config, STEP_CREATE_RECEIVE_ADDRESS);
+    setExpectedCallsForTransportCreateUpTo(mocks, &config, STEP_CREATE_RETRY_CONTROL);
 
     ///act
     TRANSPORT_LL_HANDLE transport = transport_interface->IoTHubTransport_Create(&config);
@@ -21,6 +21,7 @@
 #include "iothub_client_options.h"
 #include "iothub_client_version.h"
 #include "iothub_client_private.h"
+#include "iothub_client_retry_control.h"
 
 #include "azure_c_shared_utility/urlencode.h"
 #include "azure_c_shared_utility/doublylinkedlist.h"
@@ -114,6 +115,7 @@ static MICROMOCK_GLOBAL_SEMAPHORE_HANDLE g_dllByDll;
 #define TEST_PROPERTY_A_VALUE "value_of_a"
 
 #define TEST_HTTPAPIEX_HANDLE (HTTPAPIEX_HANDLE)0x343
+#define TEST_RETRY_CONTROL (RETRY_CONTROL_HANDLE)0x344
 
 static const bool thisIsTrue = true;
 static const bool thisIsFalse = false;
@@ -1242,6 +1244,23 @@ public:
         MOCK_STATIC_METHOD_1(, size_t, VECTOR_size, VECTOR_HANDLE, vector)
         size_t result2 = BASEIMPLEMENTATION::VECTOR_size(vector);
     MOCK_METHOD_END(size_t, result2)
+
+    /*iothub_client_retry_control.h*/
+    MOCK_STATIC_METHOD_3(, RETRY_CONTROL_HANDLE, retry_control_create, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds, const char*, deviceId)
+    MOCK_METHOD_END(RETRY_CONTROL_HANDLE, TEST_RETRY_CONTROL)
+
+    MOCK_STATIC_METHOD_1(, void, retry_control_destroy, RETRY_CONTROL_HANDLE, retryControlHandle)
+    MOCK_VOID_METHOD_END()
+
+    MOCK_STATIC_METHOD_3(, int, retry_control_set_policy, RETRY_CONTROL_HANDLE, retryControlHandle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds)
+    MOCK_METHOD_END(int, 0)
+
+    MOCK_STATIC_METHOD_2(, int, retry_control_should_retry, RETRY_CONTROL_HANDLE, retryControlHandle, RETRY_ACTION*, retryAction)
+        *retryAction = RETRY_ACTION_RETRY_LATER;
+    MOCK_METHOD_END(int, 0)
+
+    MOCK_STATIC_METHOD_1(, void, retry_control_reset, RETRY_CONTROL_HANDLE, retryControlHandle)
+    MOCK_VOID_METHOD_END()
 };
 
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportHttpMocks, , void, DList_InitializeListHead, PDLIST_ENTRY, listHead);
@@ -1337,6 +1356,12 @@ DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportHttpMocks, , void*, VECTOR_element,
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportHttpMocks, , void*, VECTOR_front, VECTOR_HANDLE, vector);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportHttpMocks, , void*, VECTOR_back, VECTOR_HANDLE, vector);
 DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubTransportHttpMocks, , void*, VECTOR_find_if, VECTOR_HANDLE, vector, PREDICATE_FUNCTION, pred, const void*, value);
+
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubTransportHttpMocks, , RETRY_CONTROL_HANDLE, retry_control_create, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds, const char*, deviceId);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportHttpMocks, , void, retry_control_destroy, RETRY_CONTROL_HANDLE, retryControlHandle);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubTransportHttpMocks, , int, retry_control_set_policy, RETRY_CONTROL_HANDLE, retryControlHandle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds);
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubTransportHttpMocks, , int, retry_control_should_retry, RETRY_CONTROL_HANDLE, retryControlHandle, RETRY_ACTION*, retryAction);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportHttpMocks, , void, retry_control_reset, RETRY_CONTROL_HANDLE, retryControlHandle);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubTransportHttpMocks, , size_t, VECTOR_size, VECTOR_HANDLE, vector);
 
 extern "C" HTTPAPIEX_RESULT HTTPAPIEX_SAS_ExecuteRequest(HTTPAPIEX_SAS_HANDLE sasHandle, HTTPAPIEX_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode, HTTP_HEADERS_HANDLE responseHttpHeadersHandle, BUFFER_HANDLE responseContent)
@@ -1416,12 +1441,25 @@ static void setupCreateHappyPathPerDeviceList(CIoTHubTransportHttpMocks &mocks,
     }
 }
 
+static void setupCreateHappyPathRetryControl(CIoTHubTransportHttpMocks &mocks, bool deallocateCreated)
+{
+    (void)mocks;
+
+    STRICT_EXPECTED_CALL(mocks, retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, TEST_DEVICE_ID))
+        .IgnoreArgument(3);
+    if (deallocateCreated == true)
+    {
+        STRICT_EXPECTED_CALL(mocks, retry_control_destroy(TEST_RETRY_CONTROL));
+    }
+}
+
 static void setupCreateHappyPath(CIoTHubTransportHttpMocks &mocks, bool deallocateCreated)
 {
     setupCreateHappyPathAlloc(mocks, deallocateCreated);
     setupCreateHappyPathHostname(mocks, deallocateCreated);
     setupCreateHappyPathApiExHandle(mocks, deallocateCreated);
     setupCreateHappyPathPerDeviceList(mocks, deallocateCreated);
+    setupCreateHappyPathRetryControl(mocks, deallocateCreated);
 }
 
 static void setupRegisterHappyPathNotFoundInList(CIoTHubTransportHttpMocks &mocks)
@@ -1797,6 +1835,7 @@ static pfIoTHubTransport_Subscribe      IoTHubTransportHttp_Subscribe;
 static pfIoTHubTransport_Unsubscribe    IoTHubTransportHttp_Unsubscribe;
 static pfIoTHubTransport_DoWork         IoTHubTransportHttp_DoWork;
 static pfIoTHubTransport_GetSendStatus  IoTHubTransportHttp_GetSendStatus;
+static pfIoTHubTransport_SetRetryPolicy IoTHubTransportHttp_SetRetryPolicy;
 
 BEGIN_TEST_SUITE(iothubtransporthttp)
 
@@ -1833,6 +1872,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     IoTHubTransportHttp_Unsubscribe = ((TRANSPORT_PROVIDER*)HTTP_Protocol())->IoTHubTransport_Unsubscribe;
     IoTHubTransportHttp_DoWork = ((TRANSPORT_PROVIDER*)HTTP_Protocol())->IoTHubTransport_DoWork;
     IoTHubTransportHttp_GetSendStatus = ((TRANSPORT_PROVIDER*)HTTP_Protocol())->IoTHubTransport_GetSendStatus;
+    IoTHubTransportHttp_SetRetryPolicy = ((TRANSPORT_PROVIDER*)HTTP_Protocol())->IoTHubTransport_SetRetryPolicy;
 
 }
 
@@ -2058,6 +2098,7 @@ TEST_FUNCTION(IoTHubTransportHttp_Create_happy_path_with_gwhostname)
     setupCreateHappyPathGWHostname(mocks, false);
     setupCreateHappyPathApiExHandle(mocks, false);
     setupCreateHappyPathPerDeviceList(mocks, false);
+    setupCreateHappyPathRetryControl(mocks, false);
 
     ///act
     auto result = IoTHubTransportHttp_Create(&TEST_GW_CONFIG);
@@ -2091,6 +2132,29 @@ TEST_FUNCTION(IoTHubTransportHttp_Create_fails_when_perDeviceList_fails)
     ///cleanup
 }
 
+//Tests_SRS_TRANSPORTMULTITHTTP_02_022: [ If creating the retry control fails, then IoTHubTransportHttp_Create shall fail and return NULL. ]
+TEST_FUNCTION(IoTHubTransportHttp_Create_fails_when_retry_control_create_fails)
+{
+    CIoTHubTransportHttpMocks mocks;
+
+    setupCreateHappyPathAlloc(mocks, true);
+    setupCreateHappyPathHostname(mocks, true);
+    setupCreateHappyPathApiExHandle(mocks, true);
+    setupCreateHappyPathPerDeviceList(mocks, true);
+    STRICT_EXPECTED_CALL(mocks, retry_control_create(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0, TEST_DEVICE_ID))
+        .IgnoreArgument(3)
+        .SetReturn((RETRY_CONTROL_HANDLE)NULL);
+
+    ///act
+    auto result = IoTHubTransportHttp_Create(&TEST_CONFIG);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+}
+
 //Tests_SRS_TRANSPORTMULTITHTTP_17_008: [ If creating the HTTPAPIEX_HANDLE fails then IoTHubTransportHttp_Create shall fail and return NULL. ]
 TEST_FUNCTION(IoTHubTransportHttp_Create_fails_when_ApiExCreate_fails)
 {
@@ -2235,6 +2299,7 @@ TEST_FUNCTION(IoTHubTransportHttp_Destroy_succeeds_NoRegistered_devices)
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, VECTOR_destroy(IGNORED_PTR_ARG))
         .IgnoreArgument(1);                                             //VECTOR_HANDLE perDeviceList;
+    STRICT_EXPECTED_CALL(mocks, retry_control_destroy(TEST_RETRY_CONTROL));          //RETRY_CONTROL_HANDLE retryControl;
 
     STRICT_EXPECTED_CALL(mocks, gballoc_free(handle));
 
@@ -2269,6 +2334,7 @@ TEST_FUNCTION(IoTHubTransportHttp_Destroy_succeeds_One_Registered_device)
 
     STRICT_EXPECTED_CALL(mocks, VECTOR_destroy(IGNORED_PTR_ARG))
         .IgnoreArgument(1);                                             //VECTOR_HANDLE perDeviceList;
+    STRICT_EXPECTED_CALL(mocks, retry_control_destroy(TEST_RETRY_CONTROL));          //RETRY_CONTROL_HANDLE retryControl;
 
     STRICT_EXPECTED_CALL(mocks, gballoc_free(handle));
 
@@ -4817,8 +4883,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_2devices_2nd_has_1_event_item_as_string
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message10.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message10.entry)))
         .IgnoreArgument(1);
 
@@ -8352,8 +8417,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_happy_path_succeeds)
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
@@ -8479,8 +8543,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_ht
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
@@ -8524,6 +8587,9 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_ht
     STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(IGNORED_PTR_ARG)).IgnoreAllArguments();
     STRICT_EXPECTED_CALL(mocks, DList_InitializeListHead(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
+    STRICT_EXPECTED_CALL(mocks, retry_control_should_retry(TEST_RETRY_CONTROL, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
+
     ENABLE_BATCHING();
 
     ///act
@@ -8605,8 +8671,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_HT
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
@@ -8651,6 +8716,9 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_HT
     STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(IGNORED_PTR_ARG)).IgnoreAllArguments();
     STRICT_EXPECTED_CALL(mocks, DList_InitializeListHead(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
+    STRICT_EXPECTED_CALL(mocks, retry_control_should_retry(TEST_RETRY_CONTROL, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
+
     ENABLE_BATCHING();
 
     ///act
@@ -8732,8 +8800,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_BU
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
@@ -8840,8 +8907,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_BU
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
@@ -9398,8 +9464,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_bigger_than_256K_path
     {
         /*adding the first payload to the "big" payload*/
         /*building the list of messages to be notified because this is 100% fail (>256K)*/
-        STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message4.entry)));
         STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message4.entry)))
             .IgnoreArgument(1);
     }
@@ -9490,8 +9555,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_almost255_happy_path_
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message5.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message5.entry)))
         .IgnoreArgument(1);
 
@@ -9658,12 +9722,10 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_makes_1_batch_succee
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message2.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message2.entry)))
         .IgnoreArgument(1);
 
@@ -9822,8 +9884,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_when_the_second_item
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
@@ -9989,8 +10050,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_when_the_second_item
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
@@ -10153,10 +10213,312 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_the_second_one_does_
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
+        .IgnoreArgument(1);
+    {
+        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
+        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
+        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+    }
+
+    /*executing HTTP goodies*/
+    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
+        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
+        IGNORED_PTR_ARG,
+        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
+        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
+        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
+        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
+        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
+        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
+        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
+        ))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2)
+        .IgnoreArgument(5)
+        .IgnoreArgument(6)
+        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
+
+    /*once the event has been succesfull...*/
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
+        .IgnoreArgument(2);
+
+    ENABLE_BATCHING();
+
+    ///act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+
+//Tests_SRS_TRANSPORTMULTITHTTP_02_028: [ A batch shall only contain events of the priority of the first event in waitingToSend, it is built from the events of that priority across the whole of waitingToSend and the events of other priorities stay in waitingToSend. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_of_different_priorities_makes_1_batch_of_the_first_item_succeeds)
+{
+    ///arrange
+    CIoTHubTransportHttpMocks mocks;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message2.entry));
+    message2.priority = IOTHUB_MESSAGE_PRIORITY_HIGH;
+    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+
+    mocks.ResetAllCalls();
+    setupDoWorkLoopOnceForOneDevice(mocks);
+
+    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
+
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
+        .IgnoreArgument(1);
+
+    /*starting to prepare the "big" payload*/
+    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
+    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG))
+        .ExpectedAtLeastTimes(2);
+
+    /*this is first batched payload*/
+    {
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
+        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
+        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+
+        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
+        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+
+        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
+            .IgnoreArgument(1);
+        /*end of the first batched payload*/
+    }
+
+    {
+        /*adding the first payload to the "big" payload*/
+        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+    }
+
+    {
+        /*closing the "big" payload*/
+        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+    }
+
+    /*building the list of messages to be notified if HTTP is fine*/
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
+        .IgnoreArgument(1);
+    {
+        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
+        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
+        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+    }
+
+    /*executing HTTP goodies*/
+    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
+        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
+        IGNORED_PTR_ARG,
+        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
+        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
+        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
+        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
+        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
+        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
+        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
+        ))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2)
+        .IgnoreArgument(5)
+        .IgnoreArgument(6)
+        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
+
+    /*once the event has been succesfull...*/
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
+        .IgnoreArgument(2);
+
+    ENABLE_BATCHING();
+
+    ///act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransportHttp_Destroy(handle);
+    message2.priority = message1.priority;
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_02_028: [ A batch shall only contain events of the priority of the first event in waitingToSend, it is built from the events of that priority across the whole of waitingToSend and the events of other priorities stay in waitingToSend. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_batches_the_events_of_the_first_priority_across_events_of_another_priority)
+{
+    ///arrange
+    CIoTHubTransportHttpMocks mocks;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message2.entry));
+    DList_InsertTailList(&(waitingToSend), &(message3.entry));
+    message2.priority = IOTHUB_MESSAGE_PRIORITY_HIGH;
+    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+
+    mocks.ResetAllCalls();
+
+    setupDoWorkLoopOnceForOneDevice(mocks);
+
+    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
+
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
+        .IgnoreArgument(1);
+
+    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG))
+        .ExpectedAtLeastTimes(2);
+
+    /*starting to prepare the "big" payload*/
+    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
+    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
+
+    /*this is first batched payload*/
+    {
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
+        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
+        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+
+        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
+        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+
+        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
+            .IgnoreArgument(1);
+        /*end of the first batched payload*/
+    }
+
+    {
+        /*adding the first payload to the "big" payload*/
+        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+    }
+
+    /*message2 is of another priority and is skipped, this is the second batched payload*/
+    {
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message3.messageHandle));
+        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
+        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message3.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+
+        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer3, buffer3_size));
+        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+
+        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message3.messageHandle));
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3)
+            .IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
+            .IgnoreArgument(1);
+        /*end of the first batched payload*/
+    }
+
+    {
+        /*adding the second payload to the "big" payload*/
+        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+    }
+
+    {
+        /*closing the "big" payload*/
+        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+    }
+
+    /*building the list of messages to be notified if HTTP is fine*/
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message1.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message3.entry)));
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message3.entry)))
+        .IgnoreArgument(1);
+
     {
         /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
         STRICT_EXPECTED_CALL(mocks, BUFFER_new());
@@ -10205,9 +10567,12 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_the_second_one_does_
 
     ///assert
     mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(void_ptr, (void*)&(message2.entry), (void*)waitingToSend.Flink);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)&waitingToSend, (void*)message2.entry.Flink);
 
     ///cleanup
     IoTHubTransportHttp_Destroy(handle);
+    message2.priority = message1.priority;
 }
 
 
@@ -10429,7 +10794,7 @@ void setupIrrelevantMocksForProperties(CIoTHubTransportHttpMocks *mocks, IOTHUB_
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL((*mocks), DList_RemoveHeadList(IGNORED_PTR_ARG))
+    STRICT_EXPECTED_CALL((*mocks), DList_RemoveEntryList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
     switch ((uintptr_t)messageHandle)
@@ -10751,12 +11116,10 @@ void setupIrrelevantMocksForProperties2(CIoTHubTransportHttpMocks *mocks, IOTHUB
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL((*mocks), DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL((*mocks), DList_RemoveEntryList(&(message6.entry)));
     STRICT_EXPECTED_CALL((*mocks), DList_InsertTailList(IGNORED_PTR_ARG, &(message6.entry)))
         .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL((*mocks), DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL((*mocks), DList_RemoveEntryList(&(message7.entry)));
     STRICT_EXPECTED_CALL((*mocks), DList_InsertTailList(IGNORED_PTR_ARG, &(message7.entry)))
         .IgnoreArgument(1);
 
@@ -11046,6 +11409,108 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_send_nothing)
     }
 }
 
+//Tests_SRS_TRANSPORTMULTITHTTP_02_023: [ When a request to send events fails or completes with a http status code >=300, the following calls to IoTHubTransportHttp_DoWork shall do nothing until the retry control allows a new attempt. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_after_http_status_404_does_nothing_until_the_retry_control_allows)
+{
+    ///arrange
+    CIoTHubTransportHttpMocks mocks;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    ENABLE_BATCHING();
+
+    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
+        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
+        IGNORED_PTR_ARG,
+        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
+        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
+        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
+        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
+        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
+        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
+        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
+        ))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2)
+        .IgnoreArgument(5)
+        .IgnoreArgument(6)
+        .CopyOutArgumentBuffer(7, &httpStatus404, sizeof(httpStatus404));
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, retry_control_should_retry(TEST_RETRY_CONTROL, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
+
+    ///act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_02_025: [ If handle is NULL then IoTHubTransportHttp_SetRetryPolicy shall fail and return a non-zero value. ]
+TEST_FUNCTION(IoTHubTransportHttp_SetRetryPolicy_with_NULL_handle_fails)
+{
+    ///arrange
+    CIoTHubTransportHttpMocks mocks;
+
+    ///act
+    int result = IoTHubTransportHttp_SetRetryPolicy(NULL, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_02_026: [ IoTHubTransportHttp_SetRetryPolicy shall pass the policy and the timeout limit to the retry control by calling retry_control_set_policy and return 0 when it succeeds. ]
+TEST_FUNCTION(IoTHubTransportHttp_SetRetryPolicy_succeeds)
+{
+    ///arrange
+    CIoTHubTransportHttpMocks mocks;
+    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, retry_control_set_policy(TEST_RETRY_CONTROL, IOTHUB_CLIENT_RETRY_INTERVAL, 10));
+
+    ///act
+    int result = IoTHubTransportHttp_SetRetryPolicy(handle, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_02_027: [ If retry_control_set_policy fails then IoTHubTransportHttp_SetRetryPolicy shall fail and return a non-zero value. ]
+TEST_FUNCTION(IoTHubTransportHttp_SetRetryPolicy_fails_when_retry_control_set_policy_fails)
+{
+    ///arrange
+    CIoTHubTransportHttpMocks mocks;
+    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, retry_control_set_policy(TEST_RETRY_CONTROL, IOTHUB_CLIENT_RETRY_INTERVAL, 10))
+        .SetReturn(1);
+
+    ///act
+    int result = IoTHubTransportHttp_SetRetryPolicy(handle, IOTHUB_CLIENT_RETRY_INTERVAL, 10);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
 //Tests_SRS_TRANSPORTMULTITHTTP_17_114: [ If handle parameter is NULL then IoTHubTransportHttp_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]
 TEST_FUNCTION(IoTHubTransportHttp_SetOption_with_NULL_handle_fails)
 {
@@ -12854,6 +13319,9 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
     EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
 
+    STRICT_EXPECTED_CALL(mocks, retry_control_should_retry(TEST_RETRY_CONTROL, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
+
     DISABLE_BATCHING();
 
     ///act
@@ -12945,6 +13413,9 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
     EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
 
+    STRICT_EXPECTED_CALL(mocks, retry_control_should_retry(TEST_RETRY_CONTROL, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
+
     DISABLE_BATCHING();
 
     ///act
@@ -13532,8 +14003,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_happy_path_
     }
 
     /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(&(message10.entry)));
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message10.entry)))
         .IgnoreArgument(1);
 
@@ -41,7 +41,8 @@ DEFINE_ENUM(IOTHUB_MESSAGE_SEND_STATE, IOTHUB_MESSAGE_SEND_STATE_VALUES);
     IOTHUB_MESSAGING_ERROR,                  \
     IOTHUB_MESSAGING_INVALID_JSON,           \
     IOTHUB_MESSAGING_DEVICE_EXIST,           \
-    IOTHUB_MESSAGING_CALLBACK_NOT_SET        \
+    IOTHUB_MESSAGING_CALLBACK_NOT_SET,       \
+    IOTHUB_MESSAGING_BUSY                    \
 
 DEFINE_ENUM(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_RESULT_VALUES);
 
@@ -65,9 +66,15 @@ typedef struct IOTHUB_SERVICE_FEEDBACK_BATCH_TAG
 
 typedef struct IOTHUB_MESSAGING_TAG* IOTHUB_MESSAGING_HANDLE;
 
+/*value is a const size_t*: maximum number of C2D messages awaiting settlement, 0 (default) means unlimited*/
+static const char* OPTION_MESSAGING_SEND_WINDOW = "send_window";
+/*value is a const size_t*: number of device addresses kept between sends, 0 (default) disables the cache*/
+static const char* OPTION_MESSAGING_DESTINATION_CACHE_SIZE = "destination_cache_size";
+
 typedef void(*IOTHUB_OPEN_COMPLETE_CALLBACK)(void* context);
 typedef void(*IOTHUB_SEND_COMPLETE_CALLBACK)(void* context, IOTHUB_MESSAGING_RESULT messagingResult);
 typedef void(*IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK)(void* context, IOTHUB_SERVICE_FEEDBACK_BATCH* feedbackBatch);
+typedef void(*IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK)(void* context, const IOTHUB_SERVICE_FEEDBACK_RECORD* feedbackRecords, size_t feedbackRecordCount);
 
 extern IOTHUB_MESSAGING_HANDLE IoTHubMessaging_LL_Create(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle);
 extern void IoTHubMessaging_LL_Destroy(IOTHUB_MESSAGING_HANDLE messagingHandle);
@@ -78,6 +85,9 @@ extern void IoTHubMessaging_LL_Close(IOTHUB_MESSAGING_HANDLE messagingHandle);
 extern IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_Send(IOTHUB_MESSAGING_HANDLE messagingHandle, const char* deviceId, IOTHUB_MESSAGE_HANDLE message, IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback, void* userContextCallback);
 
 extern IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetFeedbackMessageCallback(IOTHUB_MESSAGING_HANDLE messagingHandle, IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK feedbackMessageReceivedCallback, void* userContextCallback);
+extern IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetFeedbackRecordsCallback(IOTHUB_MESSAGING_HANDLE messagingHandle, IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK feedbackRecordsReceivedCallback, void* userContextCallback);
+
+extern IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetOption(IOTHUB_MESSAGING_HANDLE messagingHandle, const char* optionName, const void* value);
 
 extern void IoTHubMessaging_LL_DoWork(IOTHUB_MESSAGING_HANDLE messagingHandle);
 
@@ -14,6 +14,8 @@ extern "C"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/map.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/httpapiex.h"
 #include <time.h>
 #include "iothub_service_client_auth.h"
 
@@ -78,6 +80,28 @@ typedef struct IOTHUB_REGISTRY_DEVICE_UPDATE_TAG
     IOTHUB_DEVICE_STATUS status;
 } IOTHUB_REGISTRY_DEVICE_UPDATE;
 
+#define IOTHUB_REGISTRY_BULK_IMPORT_MODE_VALUES       \
+    IOTHUB_REGISTRY_BULK_IMPORT_MODE_CREATE,          \
+    IOTHUB_REGISTRY_BULK_IMPORT_MODE_UPDATE,          \
+    IOTHUB_REGISTRY_BULK_IMPORT_MODE_DELETE           \
+
+DEFINE_ENUM(IOTHUB_REGISTRY_BULK_IMPORT_MODE, IOTHUB_REGISTRY_BULK_IMPORT_MODE_VALUES);
+
+/* The IoT Hub accepts at most this many devices in one bulk request, longer arrays are sent in several requests */
+#define IOTHUB_REGISTRY_BULK_OPERATION_MAX_COUNT 100
+
+typedef struct IOTHUB_REGISTRY_BULK_OPERATION_TAG
+{
+    IOTHUB_REGISTRY_BULK_IMPORT_MODE importMode;
+    const char* deviceId;
+    const char* primaryKey;
+    const char* secondaryKey;
+    IOTHUB_DEVICE_STATUS status;
+
+    /* Set by IoTHubRegistryManager_BulkOperation to the outcome of this device */
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+} IOTHUB_REGISTRY_BULK_OPERATION;
+
 typedef struct IOTHUB_REGISTRY_STATISTIC_TAG
 {
     size_t totalDeviceCount;
@@ -94,6 +118,11 @@ typedef struct IOTHUB_REGISTRYMANAGER_TAG
     char* iothubSuffix;
     char* sharedAccessKey;
     char* keyName;
+
+    /* Kept between requests so consecutive calls reuse the same connection and SAS token */
+    HTTPAPIEX_HANDLE httpExApiHandle;
+    STRING_HANDLE sasToken;
+    time_t sasTokenRefreshTime;
 } IOTHUB_REGISTRYMANAGER;
 
 /** @brief Handle to hide struct and use it in consequent APIs
@@ -171,11 +200,43 @@ extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_DeleteDevice(IOTHUB_R
 * @param	registryManagerHandle   The handle created by a call to the create function.
 * @param	numberOfDevices     Number of devices requested.
 * @param    deviceList          Input parameter, if it is not NULL will contain the requested list of devices.
+*                               Release each IOTHUB_DEVICE of the list with IoTHubRegistryManager_FreeDevice
+*                               and then free.
 *
 * @return	IOTHUB_REGISTRYMANAGER_RESULT_OK upon success or an error code upon failure.
 */
 extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetDeviceList(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, size_t numberOfDevices, SINGLYLINKEDLIST_HANDLE deviceList);
 
+/**
+* @brief	Gets one page of the devices registered on the IoTHub. Call it again with the
+*           returned continuation token to get the next page, until the token comes back NULL.
+*           The pages come from the device query, so the devices do not carry their keys.
+*
+* @param	registryManagerHandle   The handle created by a call to the create function.
+* @param	pageSize                Maximum number of devices in the page.
+* @param	continuationToken       NULL for the first page, otherwise the token returned with the previous page.
+* @param    deviceList              The devices of the page are appended to this list. Release each of them with
+*                                   IoTHubRegistryManager_FreeDevice and then free.
+* @param    nextContinuationToken   Receives the token of the next page, or NULL after the last page.
+*                                   The caller shall free it.
+*
+* @return	IOTHUB_REGISTRYMANAGER_RESULT_OK upon success or an error code upon failure.
+*/
+extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetDeviceListPage(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, size_t pageSize, const char* continuationToken, SINGLYLINKEDLIST_HANDLE deviceList, char** nextContinuationToken);
+
+/**
+* @brief	Creates, updates or deletes many devices with as few requests as possible.
+*
+* @param	registryManagerHandle   The handle created by a call to the create function.
+* @param	operations              The device operations, sent in batches of IOTHUB_REGISTRY_BULK_OPERATION_MAX_COUNT.
+*                                   The result member of each operation receives the outcome of that device.
+* @param	operationCount          Number of elements in operations.
+*
+* @return	IOTHUB_REGISTRYMANAGER_RESULT_OK if every batch was processed by the IoTHub, even if some devices
+*           failed, or an error code if a batch could not be processed.
+*/
+extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_BulkOperation(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, IOTHUB_REGISTRY_BULK_OPERATION* operations, size_t operationCount);
+
 /**
 * @brief	Gets the registry statistic info.
 *
@@ -186,6 +247,15 @@ extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetDeviceList(IOTHUB_
 */
 extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetStatistics(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, IOTHUB_REGISTRY_STATISTICS* registryStatistics);
 
+/**
+* @brief	Frees the strings of a device info structure filled by IoTHubRegistryManager_CreateDevice,
+*           IoTHubRegistryManager_GetDevice, IoTHubRegistryManager_GetDeviceList or
+*           IoTHubRegistryManager_GetDeviceListPage. The structure itself is not freed.
+*
+* @param    deviceInfo      The device info structure, may be NULL.
+*/
+extern void IoTHubRegistryManager_FreeDevice(IOTHUB_DEVICE* deviceInfo);
+
 #ifdef __cplusplus
 }
 #endif
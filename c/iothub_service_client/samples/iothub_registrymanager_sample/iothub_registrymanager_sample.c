@@ -106,6 +106,7 @@ void iothub_registrymanager_sample_run(void)
         {
         case IOTHUB_REGISTRYMANAGER_OK:
             (void)printf("IoTHubRegistryManager_CreateDevice: Device has been created successfully: deviceId=%s\r\n", deviceInfo.deviceId);
+            IoTHubRegistryManager_FreeDevice(&deviceInfo);
             break;
         case IOTHUB_REGISTRYMANAGER_DEVICE_EXIST:
             (void)printf("IoTHubRegistryManager_CreateDevice: Device already exists\r\n");
@@ -161,6 +162,7 @@ void iothub_registrymanager_sample_run(void)
         case IOTHUB_REGISTRYMANAGER_OK:
             (void)printf("IoTHubRegistryManager_GetDevice: Successfully got device info: deviceId=%s\r\n", deviceInfo.deviceId);
             printDeviceInfo(&deviceInfo, -1);
+            IoTHubRegistryManager_FreeDevice(&deviceInfo);
             break;
         case IOTHUB_REGISTRYMANAGER_ERROR:
             (void)printf("IoTHubRegistryManager_GetDevice failed\r\n");
@@ -210,6 +212,19 @@ void iothub_registrymanager_sample_run(void)
             break;
         }
 
+        if (deviceList != NULL)
+        {
+            LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(deviceList);
+            while (list_item != NULL)
+            {
+                IOTHUB_DEVICE* device = (IOTHUB_DEVICE*)singlylinkedlist_item_get_value(list_item);
+                list_item = singlylinkedlist_get_next_item(list_item);
+                IoTHubRegistryManager_FreeDevice(device);
+                free(device);
+            }
+            singlylinkedlist_destroy(deviceList);
+        }
+
         // Get statistics
         result = IoTHubRegistryManager_GetStatistics(iotHubRegistryManagerHandle, &registryStatistics);
         switch (result)
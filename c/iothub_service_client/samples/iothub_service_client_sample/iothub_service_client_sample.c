@@ -97,6 +97,7 @@ void iothub_service_client_sample_run(void)
         if (result == IOTHUB_REGISTRYMANAGER_OK)
         {
             (void)printf("IoTHubRegistryManager_CreateDevice: Device has been created successfully: deviceId=%s\n", deviceInfo.deviceId);
+            IoTHubRegistryManager_FreeDevice(&deviceInfo);
         }
         else if (result == IOTHUB_REGISTRYMANAGER_DEVICE_EXIST)
         {
@@ -182,20 +183,17 @@ void iothub_service_client_sample_run(void)
             (void)printf("IoTHubRegistryManager_GetStatistics failed\n");
         }
 
+        LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(deviceList);
+        while (list_item != NULL)
+        {
+            IOTHUB_DEVICE* device = (IOTHUB_DEVICE*)singlylinkedlist_item_get_value(list_item);
+            list_item = singlylinkedlist_get_next_item(list_item);
+            IoTHubRegistryManager_FreeDevice(device);
+            free(device);
+        }
         singlylinkedlist_destroy(deviceList);
 
-        free((char*)deviceInfo.deviceId);
-        free((char*)deviceInfo.primaryKey);
-        free((char*)deviceInfo.secondaryKey);
-        free((char*)deviceInfo.generationId);
-        free((char*)deviceInfo.eTag);
-        free((char*)deviceInfo.connectionStateUpdatedTime);
-        free((char*)deviceInfo.statusReason);
-        free((char*)deviceInfo.statusUpdatedTime);
-        free((char*)deviceInfo.lastActivityTime);
-        free((char*)deviceInfo.configuration);
-        free((char*)deviceInfo.deviceProperties);
-        free((char*)deviceInfo.serviceProperties);
+        IoTHubRegistryManager_FreeDevice(&deviceInfo);
 
 
         (void)printf("Calling IoTHubRegistryManager_Destroy...\n");
@@ -30,13 +30,29 @@
 typedef struct CALLBACK_DATA_TAG
 {
     IOTHUB_OPEN_COMPLETE_CALLBACK openCompleteCompleteCallback;
-    IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback;
     IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK feedbackMessageCallback;
+    IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK feedbackRecordsCallback;
     void* openUserContext;
-    void* sendUserContext;
     void* feedbackUserContext;
+    void* feedbackRecordsUserContext;
 } CALLBACK_DATA;
 
+/*one per message handed to messagesender_send, so that completions of pipelined sends reach their own callback*/
+typedef struct SEND_CALLBACK_DATA_TAG
+{
+    struct IOTHUB_MESSAGING_TAG* messagingHandle;
+    IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback;
+    void* sendUserContext;
+    struct SEND_CALLBACK_DATA_TAG* nextFree;
+    struct SEND_CALLBACK_DATA_TAG* nextAllocated;
+} SEND_CALLBACK_DATA;
+
+typedef struct DESTINATION_CACHE_ENTRY_TAG
+{
+    char* deviceId;
+    AMQP_VALUE destination;
+} DESTINATION_CACHE_ENTRY;
+
 typedef struct IOTHUB_MESSAGING_TAG
 {
     int isOpened;
@@ -61,6 +77,14 @@ typedef struct IOTHUB_MESSAGING_TAG
     MESSAGE_RECEIVER_STATE message_receiver_state;
 
     CALLBACK_DATA* callback_data;
+
+    size_t sendWindow;
+    size_t messagesInFlight;
+    SEND_CALLBACK_DATA* freeSendCallbacks;
+    SEND_CALLBACK_DATA* allSendCallbacks;
+    PROPERTIES_HANDLE sendProperties;
+    DESTINATION_CACHE_ENTRY* destinationCache;
+    size_t destinationCacheSize;
 } IOTHUB_MESSAGING;
 
 static const char* FEEDBACK_RECORD_KEY_DEVICE_ID = "deviceId";
@@ -282,6 +306,137 @@ static char* createDeviceDestinationString(const char* deviceId)
     return result;
 }
 
+static AMQP_VALUE createDeviceDestination(const char* deviceId)
+{
+    AMQP_VALUE result;
+    char* deviceDestinationString;
+
+    if ((deviceDestinationString = createDeviceDestinationString(deviceId)) == NULL)
+    {
+        LogError("Could not create a message.");
+        result = NULL;
+    }
+    else
+    {
+        if ((result = amqpvalue_create_string(deviceDestinationString)) == NULL)
+        {
+            LogError("Could not create properties for message - amqpvalue_create_string");
+        }
+        free(deviceDestinationString);
+    }
+    return result;
+}
+
+static size_t hashDeviceId(const char* deviceId)
+{
+    /*djb2*/
+    size_t result = 5381;
+    while (*deviceId != '\0')
+    {
+        result = (result * 33) ^ (unsigned char)*deviceId;
+        deviceId++;
+    }
+    return result;
+}
+
+static void destroyDestinationCache(IOTHUB_MESSAGING* messagingHandle)
+{
+    if (messagingHandle->destinationCache != NULL)
+    {
+        size_t i;
+        for (i = 0; i < messagingHandle->destinationCacheSize; i++)
+        {
+            if (messagingHandle->destinationCache[i].deviceId != NULL)
+            {
+                free(messagingHandle->destinationCache[i].deviceId);
+                amqpvalue_destroy(messagingHandle->destinationCache[i].destination);
+            }
+        }
+        free(messagingHandle->destinationCache);
+        messagingHandle->destinationCache = NULL;
+    }
+}
+
+/*returns a destination owned by the cache; the cache is direct mapped, a colliding deviceId evicts the previous entry*/
+static AMQP_VALUE getCachedDeviceDestination(IOTHUB_MESSAGING* messagingHandle, const char* deviceId)
+{
+    AMQP_VALUE result;
+
+    if ((messagingHandle->destinationCache == NULL) &&
+        ((messagingHandle->destinationCache = (DESTINATION_CACHE_ENTRY*)malloc(messagingHandle->destinationCacheSize * sizeof(DESTINATION_CACHE_ENTRY))) != NULL))
+    {
+        (void)memset(messagingHandle->destinationCache, 0, messagingHandle->destinationCacheSize * sizeof(DESTINATION_CACHE_ENTRY));
+    }
+
+    if (messagingHandle->destinationCache == NULL)
+    {
+        LogError("Malloc failed for destination cache");
+        result = NULL;
+    }
+    else
+    {
+        DESTINATION_CACHE_ENTRY* entry = &messagingHandle->destinationCache[hashDeviceId(deviceId) % messagingHandle->destinationCacheSize];
+        if ((entry->deviceId != NULL) && (strcmp(entry->deviceId, deviceId) == 0))
+        {
+            result = entry->destination;
+        }
+        else
+        {
+            char* deviceIdCopy;
+
+            if ((result = createDeviceDestination(deviceId)) == NULL)
+            {
+                LogError("Could not create the device destination");
+            }
+            else if (mallocAndStrcpy_s(&deviceIdCopy, deviceId) != 0)
+            {
+                LogError("mallocAndStrcpy_s failed for deviceId");
+                amqpvalue_destroy(result);
+                result = NULL;
+            }
+            else
+            {
+                if (entry->deviceId != NULL)
+                {
+                    free(entry->deviceId);
+                    amqpvalue_destroy(entry->destination);
+                }
+                entry->deviceId = deviceIdCopy;
+                entry->destination = result;
+            }
+        }
+    }
+    return result;
+}
+
+static SEND_CALLBACK_DATA* acquireSendCallbackData(IOTHUB_MESSAGING* messagingHandle)
+{
+    SEND_CALLBACK_DATA* result;
+
+    if (messagingHandle->freeSendCallbacks != NULL)
+    {
+        result = messagingHandle->freeSendCallbacks;
+        messagingHandle->freeSendCallbacks = result->nextFree;
+    }
+    else if ((result = (SEND_CALLBACK_DATA*)malloc(sizeof(SEND_CALLBACK_DATA))) == NULL)
+    {
+        LogError("Malloc failed for send callback data");
+    }
+    else
+    {
+        result->messagingHandle = messagingHandle;
+        result->nextAllocated = messagingHandle->allSendCallbacks;
+        messagingHandle->allSendCallbacks = result;
+    }
+    return result;
+}
+
+static void releaseSendCallbackData(SEND_CALLBACK_DATA* sendCallbackData)
+{
+    sendCallbackData->nextFree = sendCallbackData->messagingHandle->freeSendCallbacks;
+    sendCallbackData->messagingHandle->freeSendCallbacks = sendCallbackData;
+}
+
 static void IoTHubMessaging_LL_SenderStateChanged(void* context, MESSAGE_SENDER_STATE new_state, MESSAGE_SENDER_STATE previous_state)
 {
     (void)previous_state;
@@ -334,18 +489,119 @@ static void IoTHubMessaging_LL_ReceiverStateChanged(const void* context, MESSAGE
     }
 }
 
-static void IoTHubMessaging_LL_SendMessageComplete(void* context, IOTHUB_MESSAGING_RESULT send_result)
+static void IoTHubMessaging_LL_SendMessageComplete(void* context, MESSAGE_SEND_RESULT send_result)
 {
     /*Codes_SRS_IOTHUBMESSAGING_12_056: [ If context is NULL IoTHubMessaging_LL_SendMessageComplete shall return ] */
     if (context != NULL)
     {
         /*Codes_SRS_IOTHUBMESSAGING_12_055: [ If context is not NULL and IoTHubMessaging_LL_SendMessageComplete shall call user callback with user context and messaging result ] */
-        IOTHUB_MESSAGING* messagingData = (IOTHUB_MESSAGING*)context;
-        if (messagingData->callback_data->sendCompleteCallback != NULL)
+        /*Codes_SRS_IOTHUBMESSAGING_02_012: [ IoTHubMessaging_LL_SendMessageComplete shall call the callback given to the IoTHubMessaging_LL_Send call that produced the message, with IOTHUB_MESSAGING_OK if send_result is MESSAGE_SEND_OK and IOTHUB_MESSAGING_ERROR otherwise ] */
+        SEND_CALLBACK_DATA* sendCallbackData = (SEND_CALLBACK_DATA*)context;
+        IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback = sendCallbackData->sendCompleteCallback;
+        void* sendUserContext = sendCallbackData->sendUserContext;
+
+        /*Codes_SRS_IOTHUBMESSAGING_02_013: [ IoTHubMessaging_LL_SendMessageComplete shall release the message's slot in the send window before calling the user callback ] */
+        sendCallbackData->messagingHandle->messagesInFlight--;
+        releaseSendCallbackData(sendCallbackData);
+
+        if (sendCompleteCallback != NULL)
+        {
+            sendCompleteCallback(sendUserContext, (send_result == MESSAGE_SEND_OK) ? IOTHUB_MESSAGING_OK : IOTHUB_MESSAGING_ERROR);
+        }
+    }
+}
+
+static IOTHUB_FEEDBACK_STATUS_CODE getFeedbackStatusCode(char* description)
+{
+    IOTHUB_FEEDBACK_STATUS_CODE result;
+
+    if (description == NULL)
+    {
+        result = IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN;
+    }
+    else
+    {
+        size_t j;
+        for (j = 0; description[j]; j++)
+        {
+            description[j] = (char)tolower(description[j]);
+        }
+
+        if (strcmp(description, "success") == 0)
+        {
+            result = IOTHUB_FEEDBACK_STATUS_CODE_SUCCESS;
+        }
+        else if (strcmp(description, "expired") == 0)
         {
-            (messagingData->callback_data->sendCompleteCallback)(messagingData->callback_data->sendUserContext, send_result);
+            result = IOTHUB_FEEDBACK_STATUS_CODE_EXPIRED;
+        }
+        else if (strcmp(description, "deliverycountexceeded") == 0)
+        {
+            result = IOTHUB_FEEDBACK_STATUS_CODE_DELIVER_COUNT_EXCEEDED;
+        }
+        else if (strcmp(description, "rejected") == 0)
+        {
+            result = IOTHUB_FEEDBACK_STATUS_CODE_REJECTED;
+        }
+        else
+        {
+            result = IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN;
         }
     }
+    return result;
+}
+
+static int readFeedbackRecords(JSON_Array* feedback_array, IOTHUB_SERVICE_FEEDBACK_RECORD* feedbackRecords, size_t feedbackRecordCount)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; i < feedbackRecordCount; i++)
+    {
+        JSON_Object* feedback_object;
+        if ((feedback_object = json_array_get_object(feedback_array, i)) == NULL)
+        {
+            LogError("json_array_get_object failed");
+            result = __LINE__;
+            break;
+        }
+        else
+        {
+            feedbackRecords[i].deviceId = json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_DEVICE_ID);
+            feedbackRecords[i].generationId = json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID);
+            feedbackRecords[i].description = (char*)json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_DESCRIPTION);
+            feedbackRecords[i].enqueuedTimeUtc = json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_ENQUED_TIME_UTC);
+            feedbackRecords[i].originalMessageId = json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID);
+            feedbackRecords[i].correlationId = "";
+            feedbackRecords[i].statusCode = getFeedbackStatusCode(feedbackRecords[i].description);
+        }
+    }
+    return result;
+}
+
+static SINGLYLINKEDLIST_HANDLE createFeedbackRecordList(IOTHUB_SERVICE_FEEDBACK_RECORD* feedbackRecords, size_t feedbackRecordCount)
+{
+    SINGLYLINKEDLIST_HANDLE result;
+
+    if ((result = singlylinkedlist_create()) == NULL)
+    {
+        LogError("singlylinkedlist_create failed");
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < feedbackRecordCount; i++)
+        {
+            if (singlylinkedlist_add(result, &feedbackRecords[i]) == NULL)
+            {
+                LogError("singlylinkedlist_add failed");
+                singlylinkedlist_destroy(result);
+                result = NULL;
+                break;
+            }
+        }
+    }
+    return result;
 }
 
 static AMQP_VALUE IoTHubMessaging_LL_FeedbackMessageReceived(const void* context, MESSAGE_HANDLE message)
@@ -362,9 +618,12 @@ static AMQP_VALUE IoTHubMessaging_LL_FeedbackMessageReceived(const void* context
         IOTHUB_MESSAGING* messagingData = (IOTHUB_MESSAGING*)context;
 
         BINARY_DATA binary_data;
+        char* feedback_json = NULL;
         JSON_Value* root_value = NULL;
-        JSON_Object* feedback_object = NULL;
         JSON_Array* feedback_array = NULL;
+        size_t array_count = 0;
+        IOTHUB_SERVICE_FEEDBACK_RECORD* feedbackRecords = NULL;
+        SINGLYLINKEDLIST_HANDLE feedbackRecordList = NULL;
 
         /*Codes_SRS_IOTHUBMESSAGING_12_058: [ If context is not NULL IoTHubMessaging_LL_FeedbackMessageReceived shall get the content string of the message by calling message_get_body_amqp_data ] */
         /*Codes_SRS_IOTHUBMESSAGING_12_059: [ IoTHubMessaging_LL_FeedbackMessageReceived shall parse the response JSON to IOTHUB_SERVICE_FEEDBACK_BATCH struct ] */
@@ -375,149 +634,82 @@ static AMQP_VALUE IoTHubMessaging_LL_FeedbackMessageReceived(const void* context
             LogError("Cannot get message data");
             result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed reading message body");
         }
-        else if ((root_value = json_parse_string((const char*)binary_data.bytes)) == NULL)
+        /*Codes_SRS_IOTHUBMESSAGING_02_014: [ IoTHubMessaging_LL_FeedbackMessageReceived shall copy the message body to a '\0' terminated buffer before parsing it ] */
+        else if ((feedback_json = (char*)malloc(binary_data.length + 1)) == NULL)
         {
-            /*Codes_SRS_IOTHUBMESSAGING_12_061: [ If any of the parson API fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return IOTHUB_MESSAGING_INVALID_JSON ] */
-            LogError("json_parse_string failed");
-            result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed parsing json root");
-        }
-        else if ((feedback_array = json_value_get_array(root_value)) == NULL)
-        {
-            /*Codes_SRS_IOTHUBMESSAGING_12_061: [ If any of the parson API fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return IOTHUB_MESSAGING_INVALID_JSON ] */
-            LogError("json_parse_string failed");
-            result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed parsing json array");
-        }
-        else if (json_array_get_count(feedback_array) == 0)
-        {
-            /*Codes_SRS_IOTHUBMESSAGING_12_061: [ If any of the parson API fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return IOTHUB_MESSAGING_INVALID_JSON ] */
-            LogError("json_array_get_count failed");
-            result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "json_array_get_count failed");
+            LogError("Malloc failed for feedback json");
+            result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed to allocate memory for feedback json");
         }
         else
         {
-            IOTHUB_SERVICE_FEEDBACK_BATCH* feedbackBatch;
+            (void)memcpy(feedback_json, binary_data.bytes, binary_data.length);
+            feedback_json[binary_data.length] = '\0';
 
-            if ((feedbackBatch = (IOTHUB_SERVICE_FEEDBACK_BATCH*)malloc(sizeof(IOTHUB_SERVICE_FEEDBACK_BATCH))) == NULL)
+            if ((root_value = json_parse_string(feedback_json)) == NULL)
             {
                 /*Codes_SRS_IOTHUBMESSAGING_12_061: [ If any of the parson API fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return IOTHUB_MESSAGING_INVALID_JSON ] */
                 LogError("json_parse_string failed");
-                result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed to allocate memory for feedback batch");
+                result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed parsing json root");
+            }
+            else if ((feedback_array = json_value_get_array(root_value)) == NULL)
+            {
+                /*Codes_SRS_IOTHUBMESSAGING_12_061: [ If any of the parson API fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return IOTHUB_MESSAGING_INVALID_JSON ] */
+                LogError("json_value_get_array failed");
+                result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed parsing json array");
+            }
+            else if ((array_count = json_array_get_count(feedback_array)) == 0)
+            {
+                /*Codes_SRS_IOTHUBMESSAGING_12_061: [ If any of the parson API fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return IOTHUB_MESSAGING_INVALID_JSON ] */
+                LogError("json_array_get_count failed");
+                result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "json_array_get_count failed");
+            }
+            /*Codes_SRS_IOTHUBMESSAGING_02_015: [ IoTHubMessaging_LL_FeedbackMessageReceived shall store all the records of the batch in one array allocation ] */
+            else if ((feedbackRecords = (IOTHUB_SERVICE_FEEDBACK_RECORD*)malloc(array_count * sizeof(IOTHUB_SERVICE_FEEDBACK_RECORD))) == NULL)
+            {
+                LogError("Malloc failed for feedback records");
+                result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed to allocate memory for feedback records");
+            }
+            else if (readFeedbackRecords(feedback_array, feedbackRecords, array_count) != 0)
+            {
+                LogError("Failed to read feedback records");
+                result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed to read feedback records");
+            }
+            else if ((messagingData->callback_data->feedbackMessageCallback != NULL) &&
+                ((feedbackRecordList = createFeedbackRecordList(feedbackRecords, array_count)) == NULL))
+            {
+                LogError("Failed to create feedback record list");
+                result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed to create feedback record list");
             }
             else
             {
-                size_t array_count = 0;
-                if ((array_count = json_array_get_count(feedback_array)) <= 0)
-                {
-                    /*Codes_SRS_IOTHUBMESSAGING_12_061: [ If any of the parson API fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return IOTHUB_MESSAGING_INVALID_JSON ] */
-                    LogError("json_array_get_count failed");
-                    free(feedbackBatch);
-                    result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "json_array_get_count failed");
-                }
-                else if ((feedbackBatch->feedbackRecordList = singlylinkedlist_create()) == NULL)
+                if (messagingData->callback_data->feedbackRecordsCallback != NULL)
                 {
-                    /*Codes_SRS_IOTHUBMESSAGING_12_061: [ If any of the parson API fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return IOTHUB_MESSAGING_INVALID_JSON ] */
-                    LogError("singlylinkedlist_create failed");
-                    free(feedbackBatch);
-                    result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "singlylinkedlist_create failed");
+                    /*Codes_SRS_IOTHUBMESSAGING_02_016: [ If a IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK has been set IoTHubMessaging_LL_FeedbackMessageReceived shall call it with the array of records and the record count ] */
+                    (messagingData->callback_data->feedbackRecordsCallback)(messagingData->callback_data->feedbackRecordsUserContext, feedbackRecords, array_count);
                 }
-                else
-                {
-                    bool isLoopFailed = false;
-                    for (size_t i = 0; i < array_count; i++)
-                    {
-                        if ((feedback_object = json_array_get_object(feedback_array, i)) == NULL)
-                        {
-                            isLoopFailed = true;
-                            break;
-                        }
-                        else
-                        {
-                            IOTHUB_SERVICE_FEEDBACK_RECORD* feedbackRecord;
-                            if ((feedbackRecord = (IOTHUB_SERVICE_FEEDBACK_RECORD*)malloc(sizeof(IOTHUB_SERVICE_FEEDBACK_RECORD))) == NULL)
-                            {
-                                isLoopFailed = true;
-                                break;
-                            }
-                            else
-                            {
-                                feedbackRecord->deviceId = (char*)json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_DEVICE_ID);
-                                feedbackRecord->generationId = (char*)json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID);
-                                feedbackRecord->description = (char*)json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_DESCRIPTION);
-                                feedbackRecord->enqueuedTimeUtc = (char*)json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_ENQUED_TIME_UTC);
-                                feedbackRecord->originalMessageId = (char*)json_object_get_string(feedback_object, FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID);
-                                feedbackRecord->correlationId = "";
-
-                                if (feedbackRecord->description == NULL)
-                                {
-                                    feedbackRecord->statusCode = IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN;
-                                }
-                                else
-                                {
-                                    size_t j;
-                                    for (j = 0; feedbackRecord->description[j]; j++)
-                                    {
-                                        feedbackRecord->description[j] = (char)tolower(feedbackRecord->description[j]);
-                                    }
-
-                                    if (strcmp(feedbackRecord->description, "success") == 0)
-                                    {
-                                        feedbackRecord->statusCode = IOTHUB_FEEDBACK_STATUS_CODE_SUCCESS;
-                                    }
-                                    else if (strcmp(feedbackRecord->description, "expired") == 0)
-                                    {
-                                        feedbackRecord->statusCode = IOTHUB_FEEDBACK_STATUS_CODE_EXPIRED;
-                                    }
-                                    else if (strcmp(feedbackRecord->description, "deliverycountexceeded") == 0)
-                                    {
-                                        feedbackRecord->statusCode = IOTHUB_FEEDBACK_STATUS_CODE_DELIVER_COUNT_EXCEEDED;
-                                    }
-                                    else if (strcmp(feedbackRecord->description, "rejected") == 0)
-                                    {
-                                        feedbackRecord->statusCode = IOTHUB_FEEDBACK_STATUS_CODE_REJECTED;
-                                    }
-                                    else
-                                    {
-                                        feedbackRecord->statusCode = IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN;
-                                    }
-                                }
-                                singlylinkedlist_add(feedbackBatch->feedbackRecordList, feedbackRecord);
-                            }
-                        }
-                    }
-                    feedbackBatch->lockToken = "";
-                    feedbackBatch->userId = "";
 
-                    if (isLoopFailed)
-                    {
-                        LogError("Failed to read feedback records");
-                        result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed to read feedback records");
-                    }
-                    else
-                    {
-                        if (messagingData->callback_data->feedbackMessageCallback != NULL)
-                        {
-                            /*Codes_SRS_IOTHUBMESSAGING_12_062: [ If context is not NULL IoTHubMessaging_LL_FeedbackMessageReceived shall call IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK with the received IOTHUB_SERVICE_FEEDBACK_BATCH ] */
-                            (messagingData->callback_data->feedbackMessageCallback)(messagingData->callback_data->feedbackUserContext, feedbackBatch);
-                        }
-                        result = messaging_delivery_accepted();
-                    }
+                if (feedbackRecordList != NULL)
+                {
+                    IOTHUB_SERVICE_FEEDBACK_BATCH feedbackBatch;
+                    feedbackBatch.lockToken = "";
+                    feedbackBatch.userId = "";
+                    feedbackBatch.feedbackRecordList = feedbackRecordList;
 
-                    /*Codes_SRS_IOTHUBMESSAGING_12_078: [** IoTHubMessaging_LL_FeedbackMessageReceived shall do clean up before exits ] */
-                    LIST_ITEM_HANDLE feedbackRecord = singlylinkedlist_get_head_item(feedbackBatch->feedbackRecordList);
-                    while (feedbackRecord != NULL)
-                    {
-                        IOTHUB_SERVICE_FEEDBACK_RECORD* feedback = (IOTHUB_SERVICE_FEEDBACK_RECORD*)singlylinkedlist_item_get_value(feedbackRecord);
-                        feedbackRecord = singlylinkedlist_get_next_item(feedbackRecord);
-                        free(feedback);
-                    }
-                    singlylinkedlist_destroy(feedbackBatch->feedbackRecordList);
-                    free(feedbackBatch);
+                    /*Codes_SRS_IOTHUBMESSAGING_12_062: [ If context is not NULL IoTHubMessaging_LL_FeedbackMessageReceived shall call IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK with the received IOTHUB_SERVICE_FEEDBACK_BATCH ] */
+                    (messagingData->callback_data->feedbackMessageCallback)(messagingData->callback_data->feedbackUserContext, &feedbackBatch);
                 }
+                result = messaging_delivery_accepted();
+            }
+
+            /*Codes_SRS_IOTHUBMESSAGING_12_078: [** IoTHubMessaging_LL_FeedbackMessageReceived shall do clean up before exits ] */
+            if (feedbackRecordList != NULL)
+            {
+                singlylinkedlist_destroy(feedbackRecordList);
             }
+            free(feedbackRecords);
+            json_value_free(root_value);
+            free(feedback_json);
         }
-        json_array_clear(feedback_array);
-        json_object_clear(feedback_object);
-        json_value_free(root_value);
     }
     return result;
 }
@@ -639,14 +831,23 @@ IOTHUB_MESSAGING_HANDLE IoTHubMessaging_LL_Create(IOTHUB_SERVICE_CLIENT_AUTH_HAN
             {
                 /*Codes_SRS_IOTHUBMESSAGING_12_076: [ If create successfull IoTHubMessaging_LL_Create shall save the callback data return the valid messaging handle ] */
                 callback_data->openCompleteCompleteCallback = NULL;
-                callback_data->sendCompleteCallback = NULL;
                 callback_data->feedbackMessageCallback = NULL;
+                callback_data->feedbackRecordsCallback = NULL;
                 callback_data->openUserContext = NULL;
-                callback_data->sendUserContext = NULL;
                 callback_data->feedbackUserContext = NULL;
+                callback_data->feedbackRecordsUserContext = NULL;
 
                 result->callback_data = callback_data;
                 result->isOpened = false;
+
+                /*Codes_SRS_IOTHUBMESSAGING_02_001: [ IoTHubMessaging_LL_Create shall set the send window to unlimited and disable the destination cache ] */
+                result->sendWindow = 0;
+                result->messagesInFlight = 0;
+                result->freeSendCallbacks = NULL;
+                result->allSendCallbacks = NULL;
+                result->sendProperties = NULL;
+                result->destinationCache = NULL;
+                result->destinationCacheSize = 0;
             }
         }
     }
@@ -661,6 +862,18 @@ void IoTHubMessaging_LL_Destroy(IOTHUB_MESSAGING_HANDLE messagingHandle)
         /*Codes_SRS_IOTHUBMESSAGING_12_006: [ If the messagingHandle input parameter is not NULL IoTHubMessaging_LL_Destroy shall free all resources (memory) allocated by IoTHubMessaging_LL_Create ] */
         IOTHUB_MESSAGING* messHandle = (IOTHUB_MESSAGING*)messagingHandle;
 
+        while (messHandle->allSendCallbacks != NULL)
+        {
+            SEND_CALLBACK_DATA* next = messHandle->allSendCallbacks->nextAllocated;
+            free(messHandle->allSendCallbacks);
+            messHandle->allSendCallbacks = next;
+        }
+        if (messHandle->sendProperties != NULL)
+        {
+            properties_destroy(messHandle->sendProperties);
+        }
+        destroyDestinationCache(messHandle);
+
         free(messHandle->callback_data);
         free(messHandle->hostname);
         free(messHandle->iothubName);
@@ -1038,10 +1251,9 @@ IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_Send(IOTHUB_MESSAGING_HANDLE messagin
     const unsigned char* data;
     size_t len;
 
-    char* deviceDestinationString = NULL;
     MESSAGE_HANDLE amqpMessage = NULL;
     AMQP_VALUE to_amqp_value = NULL;
-    PROPERTIES_HANDLE properties = NULL;
+    bool isDestinationCached = false;
 
     /*Codes_SRS_IOTHUBMESSAGING_12_034: [ IoTHubMessaging_LL_SendMessage shall verify the messagingHandle, deviceId, message input parameters and if any of them are NULL then return NULL ] */
     if (messagingHandle == NULL)
@@ -1067,96 +1279,126 @@ IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_Send(IOTHUB_MESSAGING_HANDLE messagin
         LogError("Messaging is not opened - call IoTHubMessaging_LL_Open to open");
         result = IOTHUB_MESSAGING_ERROR;
     }
-    /*Codes_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
-    else if ((deviceDestinationString = createDeviceDestinationString(deviceId)) == NULL)
-    {
-        /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
-        LogError("Could not create a message.");
-        result = IOTHUB_MESSAGING_ERROR;
-    }
-    /*Codes_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
-    else if ((to_amqp_value = amqpvalue_create_string(deviceDestinationString)) == NULL)
+    /*Codes_SRS_IOTHUBMESSAGING_02_002: [ If a send window has been set and that many messages are awaiting their send completion IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_BUSY ] */
+    else if ((messagingHandle->sendWindow != 0) && (messagingHandle->messagesInFlight >= messagingHandle->sendWindow))
     {
-        /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
-        LogError("Could not create properties for message - amqpvalue_create_string");
-        result = IOTHUB_MESSAGING_ERROR;
+        result = IOTHUB_MESSAGING_BUSY;
     }
-    /*Codes_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
-    else if ((properties = properties_create()) == NULL)
+    /*Codes_SRS_IOTHUBMESSAGING_02_003: [ If the destination cache is enabled IoTHubMessaging_LL_SendMessage shall reuse the destination of a previous send to the same deviceId ] */
+    else if (messagingHandle->destinationCacheSize != 0)
     {
-        /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
-        LogError("Could not create properties for message - properties_create failed");
-        result = IOTHUB_MESSAGING_ERROR;
+        if ((to_amqp_value = getCachedDeviceDestination(messagingHandle, deviceId)) == NULL)
+        {
+            /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
+            LogError("Could not get the device destination");
+            result = IOTHUB_MESSAGING_ERROR;
+        }
+        else
+        {
+            isDestinationCached = true;
+            result = IOTHUB_MESSAGING_OK;
+        }
     }
     /*Codes_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
-    else if ((properties_set_to(properties, to_amqp_value)) != 0)
+    else if ((to_amqp_value = createDeviceDestination(deviceId)) == NULL)
     {
         /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
-        LogError("Could not create properties for message - properties_set_to failed");
-        result = IOTHUB_MESSAGING_ERROR;
-    }
-    else if (IoTHubMessage_GetByteArray(message, &data, &len) != IOTHUB_MESSAGE_OK)
-    {
-        /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
-        LogError("Could not create a message - IoTHubMessage_GetByteArray failed");
+        LogError("Could not create the device destination");
         result = IOTHUB_MESSAGING_ERROR;
     }
     else
     {
-        BINARY_DATA binary_data;
+        result = IOTHUB_MESSAGING_OK;
+    }
 
-        binary_data.bytes = data;
-        binary_data.length = len;
+    if (to_amqp_value != NULL)
+    {
+        SEND_CALLBACK_DATA* sendCallbackData;
 
-        /*Codes_SRS_IOTHUBMESSAGING_12_036: [ IoTHubMessaging_LL_SendMessage shall create a uAMQP message by calling message_create ] */
-        if ((amqpMessage = message_create()) == NULL)
+        /*Codes_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
+        /*Codes_SRS_IOTHUBMESSAGING_02_004: [ IoTHubMessaging_LL_SendMessage shall create the uAMQP properties once and reuse them for every subsequent message ] */
+        if ((messagingHandle->sendProperties == NULL) && ((messagingHandle->sendProperties = properties_create()) == NULL))
         {
             /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
-            LogError("Could not create a message.");
+            LogError("Could not create properties for message - properties_create failed");
             result = IOTHUB_MESSAGING_ERROR;
         }
-        /*Codes_SRS_IOTHUBMESSAGING_12_037: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message body to the given message content by calling message_add_body_amqp_data ] */
-        else if (message_add_body_amqp_data(amqpMessage, binary_data) != 0)
+        /*Codes_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
+        else if ((properties_set_to(messagingHandle->sendProperties, to_amqp_value)) != 0)
         {
             /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
-            LogError("Could not add the binary data to the message - message_add_body_amqp_data failed");
-            message_destroy(amqpMessage);
+            LogError("Could not create properties for message - properties_set_to failed");
             result = IOTHUB_MESSAGING_ERROR;
         }
-        /*Codes_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
-        else if ((message_set_properties(amqpMessage, properties)) != 0)
+        else if (IoTHubMessage_GetByteArray(message, &data, &len) != IOTHUB_MESSAGE_OK)
         {
             /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
-            LogError("Could not set the properties on the message - message_set_properties failed");
-            message_destroy(amqpMessage);
+            LogError("Could not create a message - IoTHubMessage_GetByteArray failed");
+            result = IOTHUB_MESSAGING_ERROR;
+        }
+        /*Codes_SRS_IOTHUBMESSAGING_12_036: [ IoTHubMessaging_LL_SendMessage shall create a uAMQP message by calling message_create ] */
+        else if ((amqpMessage = message_create()) == NULL)
+        {
+            /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
+            LogError("Could not create a message.");
             result = IOTHUB_MESSAGING_ERROR;
         }
         else
         {
-            messagingHandle->callback_data->sendCompleteCallback = sendCompleteCallback;
-            messagingHandle->callback_data->sendUserContext = userContextCallback;
+            BINARY_DATA binary_data;
+
+            binary_data.bytes = data;
+            binary_data.length = len;
 
-            /*Codes_SRS_IOTHUBMESSAGING_12_039: [ IoTHubMessaging_LL_SendMessage shall call uAMQP messagesender_send with the created message with IoTHubMessaging_LL_SendMessageComplete callback by which IoTHubMessaging is notified of completition of send ] */
-            if (messagesender_send(messagingHandle->message_sender, amqpMessage, (ON_MESSAGE_SEND_COMPLETE)IoTHubMessaging_LL_SendMessageComplete, messagingHandle) != 0)
+            /*Codes_SRS_IOTHUBMESSAGING_12_037: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message body to the given message content by calling message_add_body_amqp_data ] */
+            if (message_add_body_amqp_data(amqpMessage, binary_data) != 0)
+            {
+                /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
+                LogError("Could not add the binary data to the message - message_add_body_amqp_data failed");
+                result = IOTHUB_MESSAGING_ERROR;
+            }
+            /*Codes_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
+            else if ((message_set_properties(amqpMessage, messagingHandle->sendProperties)) != 0)
             {
                 /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
-                LogError("Could not set outgoing window.");
-                message_destroy(amqpMessage);
+                LogError("Could not set the properties on the message - message_set_properties failed");
+                result = IOTHUB_MESSAGING_ERROR;
+            }
+            /*Codes_SRS_IOTHUBMESSAGING_02_005: [ IoTHubMessaging_LL_SendMessage shall keep sendCompleteCallback and userContextCallback per message, in a context recycled after the send completes ] */
+            else if ((sendCallbackData = acquireSendCallbackData(messagingHandle)) == NULL)
+            {
+                /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
+                LogError("Could not allocate the send callback data");
                 result = IOTHUB_MESSAGING_ERROR;
             }
             else
             {
-                /*Codes_SRS_IOTHUBMESSAGING_12_041: [ If all uAMQP call return 0 then IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_OK  ] */
-                result = IOTHUB_MESSAGING_OK;
+                sendCallbackData->sendCompleteCallback = sendCompleteCallback;
+                sendCallbackData->sendUserContext = userContextCallback;
+                messagingHandle->messagesInFlight++;
+
+                /*Codes_SRS_IOTHUBMESSAGING_12_039: [ IoTHubMessaging_LL_SendMessage shall call uAMQP messagesender_send with the created message with IoTHubMessaging_LL_SendMessageComplete callback by which IoTHubMessaging is notified of completition of send ] */
+                if (messagesender_send(messagingHandle->message_sender, amqpMessage, IoTHubMessaging_LL_SendMessageComplete, sendCallbackData) != 0)
+                {
+                    /*Codes_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
+                    LogError("messagesender_send failed");
+                    messagingHandle->messagesInFlight--;
+                    releaseSendCallbackData(sendCallbackData);
+                    result = IOTHUB_MESSAGING_ERROR;
+                }
+                else
+                {
+                    /*Codes_SRS_IOTHUBMESSAGING_12_041: [ If all uAMQP call return 0 then IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_OK  ] */
+                    result = IOTHUB_MESSAGING_OK;
+                }
             }
+            message_destroy(amqpMessage);
+        }
+
+        if (!isDestinationCached)
+        {
+            amqpvalue_destroy(to_amqp_value);
         }
-    }
-    message_destroy(amqpMessage);
-    properties_destroy(properties);
-    amqpvalue_destroy(to_amqp_value);
-    if (deviceDestinationString != NULL)
-    {
-        free(deviceDestinationString);
     }
     return result;
 }
@@ -1182,6 +1424,58 @@ IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetFeedbackMessageCallback(IOTHUB_MES
     return result;
 }
 
+IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetFeedbackRecordsCallback(IOTHUB_MESSAGING_HANDLE messagingHandle, IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK feedbackRecordsReceivedCallback, void* userContextCallback)
+{
+    IOTHUB_MESSAGING_RESULT result;
+
+    /*Codes_SRS_IOTHUBMESSAGING_02_006: [ If messagingHandle is NULL IoTHubMessaging_LL_SetFeedbackRecordsCallback shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+    if (messagingHandle == NULL)
+    {
+        LogError("Input parameter cannot be NULL");
+        result = IOTHUB_MESSAGING_INVALID_ARG;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBMESSAGING_02_007: [ IoTHubMessaging_LL_SetFeedbackRecordsCallback shall save feedbackRecordsReceivedCallback and userContextCallback and return IOTHUB_MESSAGING_OK ] */
+        messagingHandle->callback_data->feedbackRecordsCallback = feedbackRecordsReceivedCallback;
+        messagingHandle->callback_data->feedbackRecordsUserContext = userContextCallback;
+        result = IOTHUB_MESSAGING_OK;
+    }
+    return result;
+}
+
+IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetOption(IOTHUB_MESSAGING_HANDLE messagingHandle, const char* optionName, const void* value)
+{
+    IOTHUB_MESSAGING_RESULT result;
+
+    /*Codes_SRS_IOTHUBMESSAGING_02_008: [ If messagingHandle, optionName or value is NULL IoTHubMessaging_LL_SetOption shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+    if ((messagingHandle == NULL) || (optionName == NULL) || (value == NULL))
+    {
+        LogError("Invalid argument (NULL) messagingHandle=%p, optionName=%p, value=%p", messagingHandle, optionName, value);
+        result = IOTHUB_MESSAGING_INVALID_ARG;
+    }
+    /*Codes_SRS_IOTHUBMESSAGING_02_009: [ If optionName is OPTION_MESSAGING_SEND_WINDOW IoTHubMessaging_LL_SetOption shall set the send window to *(const size_t*)value and return IOTHUB_MESSAGING_OK ] */
+    else if (strcmp(optionName, OPTION_MESSAGING_SEND_WINDOW) == 0)
+    {
+        messagingHandle->sendWindow = *(const size_t*)value;
+        result = IOTHUB_MESSAGING_OK;
+    }
+    /*Codes_SRS_IOTHUBMESSAGING_02_010: [ If optionName is OPTION_MESSAGING_DESTINATION_CACHE_SIZE IoTHubMessaging_LL_SetOption shall drop the cached destinations, set the cache size to *(const size_t*)value and return IOTHUB_MESSAGING_OK ] */
+    else if (strcmp(optionName, OPTION_MESSAGING_DESTINATION_CACHE_SIZE) == 0)
+    {
+        destroyDestinationCache(messagingHandle);
+        messagingHandle->destinationCacheSize = *(const size_t*)value;
+        result = IOTHUB_MESSAGING_OK;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBMESSAGING_02_011: [ If optionName is not a known option IoTHubMessaging_LL_SetOption shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+        LogError("unknown option %s", optionName);
+        result = IOTHUB_MESSAGING_INVALID_ARG;
+    }
+    return result;
+}
+
 void IoTHubMessaging_LL_DoWork(IOTHUB_MESSAGING_HANDLE messagingHandle)
 {
     /*Codes_SRS_IOTHUBMESSAGING_12_045: [ IoTHubMessaging_LL_DoWork shall verify if uAMQP transport has been initialized and if it is not then return immediately ] */
@@ -7,6 +7,7 @@
 #endif
 
 #include <ctype.h>
+#include <time.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/string_tokenizer.h"
@@ -14,7 +15,7 @@
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/httpapiex.h"
-#include "azure_c_shared_utility/httpapiexsas.h"
+#include "azure_c_shared_utility/sastoken.h"
 
 #include "parson.h"
 #include "connection_string_parser.h"
@@ -26,7 +27,9 @@
     IOTHUB_REQUEST_UPDATE,            \
     IOTHUB_REQUEST_DELETE,            \
     IOTHUB_REQUEST_GET_DEVICE_LIST,   \
-    IOTHUB_REQUEST_GET_STATISTICS     \
+    IOTHUB_REQUEST_GET_STATISTICS,    \
+    IOTHUB_REQUEST_GET_DEVICE_LIST_PAGE, \
+    IOTHUB_REQUEST_BULK_OPERATION     \
 
 DEFINE_ENUM(IOTHUB_REQUEST_MODE, IOTHUB_REQUEST_MODE_VALUES);
 
@@ -42,6 +45,12 @@ DEFINE_ENUM(IOTHUB_REQUEST_MODE, IOTHUB_REQUEST_MODE_VALUES);
 #define  HTTP_HEADER_VAL_CONTENT_TYPE  "application/json; charset=utf-8"
 #define  HTTP_HEADER_KEY_IFMATCH  "If-Match"
 #define  HTTP_HEADER_VAL_IFMATCH  "*"
+#define  HTTP_HEADER_KEY_MAX_ITEM_COUNT  "x-ms-max-item-count"
+#define  HTTP_HEADER_KEY_CONTINUATION  "x-ms-continuation"
+
+#define  SAS_TOKEN_LIFETIME_SECONDS  3600
+#define  HTTP_STATUS_CODE_UNAUTHORIZED  401
+#define  HTTP_STATUS_CODE_BAD_REQUEST  400
 
 static size_t IOTHUB_DEVICES_MAX_REQUEST = 1000;
 
@@ -80,11 +89,30 @@ static const char* DEVICE_JSON_DEFAULT_VALUE_TIME = "0001-01-01T00:00:00";
 static const char* DEVICE_JSON_DEFAULT_VALUE_TRUE = "true";
 static const char* DEVICE_JSON_DEFAULT_VALUE_FALSE = "false";
 
+static const char* DEVICE_JSON_KEY_BULK_DEVICE_ID = "id";
+static const char* DEVICE_JSON_KEY_BULK_IMPORT_MODE = "importMode";
+static const char* DEVICE_JSON_KEY_BULK_IS_SUCCESSFUL = "isSuccessful";
+static const char* DEVICE_JSON_KEY_BULK_ERRORS = "errors";
+static const char* DEVICE_JSON_KEY_BULK_ERROR_DEVICE_ID = "deviceId";
+static const char* DEVICE_JSON_KEY_BULK_ERROR_CODE = "errorCode";
+
+static const char* DEVICE_JSON_VALUE_IMPORT_MODE_CREATE = "create";
+static const char* DEVICE_JSON_VALUE_IMPORT_MODE_UPDATE = "update";
+static const char* DEVICE_JSON_VALUE_IMPORT_MODE_DELETE = "delete";
+static const char* DEVICE_JSON_VALUE_ERROR_DEVICE_ALREADY_EXISTS = "DeviceAlreadyExists";
+static const char* DEVICE_JSON_VALUE_ERROR_DEVICE_NOT_FOUND = "DeviceNotFound";
+
+static const char* DEVICE_QUERY_JSON = "{\"query\":\"SELECT * FROM devices\"}";
+
 static const char* URL_API_VERSION = "api-version=2016-02-03";
+/* the device query, which pages with continuation tokens, is not available in the older api version */
+static const char* URL_API_VERSION_QUERY = "api-version=2016-11-14";
 
 static const char* RELATIVE_PATH_FMT_CRUD = "/devices/%s?%s";
 static const char* RELATIVE_PATH_FMT_LIST = "/devices/?top=%s&%s";
 static const char* RELATIVE_PATH_FMT_STAT = "/statistics/devices?%s";
+static const char* RELATIVE_PATH_FMT_QUERY = "/devices/query?%s";
+static const char* RELATIVE_PATH_FMT_BULK = "/devices?%s";
 
 static int strHasNoWhitespace(const char* s)
 {
@@ -451,362 +479,639 @@ static IOTHUB_REGISTRYMANAGER_RESULT parseDeviceJson(BUFFER_HANDLE jsonBuffer, I
     return result;
 }
 
-static IOTHUB_REGISTRYMANAGER_RESULT parseDeviceListJson(BUFFER_HANDLE jsonBuffer, SINGLYLINKEDLIST_HANDLE deviceList)
+typedef enum DEVICE_JSON_LEVEL_TAG
 {
-    IOTHUB_REGISTRYMANAGER_RESULT result;
+    DEVICE_JSON_LEVEL_DEVICE,
+    DEVICE_JSON_LEVEL_AUTHENTICATION,
+    DEVICE_JSON_LEVEL_SYMMETRIC_KEY
+} DEVICE_JSON_LEVEL;
 
-    const char* bufferStr = NULL;
-    JSON_Value* root_value = NULL;
-    JSON_Array* device_array = NULL;
-    JSON_Status jsonStatus = JSONFailure;
+typedef enum DEVICE_JSON_FIELD_TAG
+{
+    DEVICE_JSON_FIELD_DEVICE_ID,
+    DEVICE_JSON_FIELD_PRIMARY_KEY,
+    DEVICE_JSON_FIELD_SECONDARY_KEY,
+    DEVICE_JSON_FIELD_GENERATION_ID,
+    DEVICE_JSON_FIELD_ETAG,
+    DEVICE_JSON_FIELD_CONNECTION_STATE_UPDATED_TIME,
+    DEVICE_JSON_FIELD_STATUS_REASON,
+    DEVICE_JSON_FIELD_STATUS_UPDATED_TIME,
+    DEVICE_JSON_FIELD_LAST_ACTIVITY_TIME,
+    DEVICE_JSON_FIELD_CONFIGURATION,
+    DEVICE_JSON_FIELD_DEVICE_PROPERTIES,
+    DEVICE_JSON_FIELD_SERVICE_PROPERTIES,
+    DEVICE_JSON_FIELD_COUNT
+} DEVICE_JSON_FIELD;
+
+typedef struct DEVICE_JSON_STRING_FIELD_TAG
+{
+    DEVICE_JSON_LEVEL level;
+    const char* name;
+    DEVICE_JSON_FIELD field;
+} DEVICE_JSON_STRING_FIELD;
 
-    if (jsonBuffer == NULL)
+static const DEVICE_JSON_STRING_FIELD DEVICE_JSON_STRING_FIELDS[] =
+{
+    { DEVICE_JSON_LEVEL_DEVICE, "deviceId", DEVICE_JSON_FIELD_DEVICE_ID },
+    { DEVICE_JSON_LEVEL_SYMMETRIC_KEY, "primaryKey", DEVICE_JSON_FIELD_PRIMARY_KEY },
+    { DEVICE_JSON_LEVEL_SYMMETRIC_KEY, "secondaryKey", DEVICE_JSON_FIELD_SECONDARY_KEY },
+    { DEVICE_JSON_LEVEL_DEVICE, "generationId", DEVICE_JSON_FIELD_GENERATION_ID },
+    { DEVICE_JSON_LEVEL_DEVICE, "etag", DEVICE_JSON_FIELD_ETAG },
+    { DEVICE_JSON_LEVEL_DEVICE, "connectionStateUpdatedTime", DEVICE_JSON_FIELD_CONNECTION_STATE_UPDATED_TIME },
+    { DEVICE_JSON_LEVEL_DEVICE, "statusReason", DEVICE_JSON_FIELD_STATUS_REASON },
+    { DEVICE_JSON_LEVEL_DEVICE, "statusUpdatedTime", DEVICE_JSON_FIELD_STATUS_UPDATED_TIME },
+    { DEVICE_JSON_LEVEL_DEVICE, "lastActivityTime", DEVICE_JSON_FIELD_LAST_ACTIVITY_TIME },
+    { DEVICE_JSON_LEVEL_DEVICE, "configuration", DEVICE_JSON_FIELD_CONFIGURATION },
+    { DEVICE_JSON_LEVEL_DEVICE, "deviceProperties", DEVICE_JSON_FIELD_DEVICE_PROPERTIES },
+    { DEVICE_JSON_LEVEL_DEVICE, "serviceProperties", DEVICE_JSON_FIELD_SERVICE_PROPERTIES }
+};
+
+static const char* DEVICE_JSON_KEY_AUTHENTICATION = "authentication";
+static const char* DEVICE_JSON_KEY_SYMMETRIC_KEY = "symmetricKey";
+
+/* nesting allowed inside values the device list parser does not read, such as tags or properties */
+#define DEVICE_JSON_MAX_SKIP_DEPTH 64
+
+/* The device list parser reads the response in place. A string token is kept as the span between its
+   quotes and is only unescaped once, into the string of the device it belongs to. */
+typedef struct DEVICE_JSON_READER_TAG
+{
+    const char* current;
+    const char* end;
+} DEVICE_JSON_READER;
+
+typedef struct DEVICE_JSON_SPAN_TAG
+{
+    const char* start;
+    size_t length;
+} DEVICE_JSON_SPAN;
+
+typedef struct DEVICE_JSON_VALUES_TAG
+{
+    DEVICE_JSON_SPAN strings[DEVICE_JSON_FIELD_COUNT];
+    IOTHUB_DEVICE_CONNECTION_STATE connectionState;
+    IOTHUB_DEVICE_STATUS status;
+    size_t cloudToDeviceMessageCount;
+    bool isManaged;
+} DEVICE_JSON_VALUES;
+
+static void skipJsonWhitespace(DEVICE_JSON_READER* reader)
+{
+    while ((reader->current < reader->end) &&
+        ((*reader->current == ' ') || (*reader->current == '\t') || (*reader->current == '\r') || (*reader->current == '\n')))
     {
-        LogError("jsonBuffer cannot be NULL");
-        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+        reader->current++;
     }
-    else if (deviceList == NULL)
+}
+
+static int expectJsonChar(DEVICE_JSON_READER* reader, char expected)
+{
+    int result;
+
+    skipJsonWhitespace(reader);
+    if ((reader->current < reader->end) && (*reader->current == expected))
     {
-        LogError("deviceList cannot be NULL");
-        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+        reader->current++;
+        result = 0;
     }
     else
     {
-        if ((bufferStr = (const char*)BUFFER_u_char(jsonBuffer)) == NULL)
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+static int peekJsonChar(DEVICE_JSON_READER* reader, char expected)
+{
+    skipJsonWhitespace(reader);
+    return (reader->current < reader->end) && (*reader->current == expected);
+}
+
+static int readJsonString(DEVICE_JSON_READER* reader, DEVICE_JSON_SPAN* span)
+{
+    int result;
+
+    if (expectJsonChar(reader, '"') != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        const char* start = reader->current;
+        while ((reader->current < reader->end) && (*reader->current != '"'))
         {
-            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-            LogError("BUFFER_u_char failed");
-            result = IOTHUB_REGISTRYMANAGER_ERROR;
+            if ((*reader->current == '\\') && (reader->current + 1 < reader->end))
+            {
+                reader->current++;
+            }
+            reader->current++;
         }
-        else if ((root_value = json_parse_string(bufferStr)) == NULL)
+
+        if (reader->current >= reader->end)
         {
-            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [** If any of the parson API fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR **] */
-            LogError("json_parse_string failed");
-            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+            result = __LINE__;
         }
-        else if ((device_array = json_value_get_array(root_value)) == NULL)
+        else
         {
-            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [** If any of the parson API fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR **] */
-            LogError("json_value_get_object failed");
-            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+            span->start = start;
+            span->length = (size_t)(reader->current - start);
+            reader->current++;
+            result = 0;
         }
-        else
+    }
+
+    return result;
+}
+
+static int spanEquals(const DEVICE_JSON_SPAN* span, const char* text)
+{
+    size_t length = strlen(text);
+    return (span->length == length) && (memcmp(span->start, text, length) == 0);
+}
+
+static int skipJsonValue(DEVICE_JSON_READER* reader)
+{
+    int result;
+
+    skipJsonWhitespace(reader);
+    if (reader->current >= reader->end)
+    {
+        result = __LINE__;
+    }
+    else if (*reader->current == '"')
+    {
+        DEVICE_JSON_SPAN ignored;
+        result = readJsonString(reader, &ignored);
+    }
+    else if ((*reader->current == '{') || (*reader->current == '['))
+    {
+        size_t depth = 0;
+        result = 0;
+        do
         {
-            result = IOTHUB_REGISTRYMANAGER_OK;
+            if (*reader->current == '"')
+            {
+                DEVICE_JSON_SPAN ignored;
+                if (readJsonString(reader, &ignored) != 0)
+                {
+                    result = __LINE__;
+                }
+            }
+            else
+            {
+                if ((*reader->current == '{') || (*reader->current == '['))
+                {
+                    depth++;
+                }
+                else if ((*reader->current == '}') || (*reader->current == ']'))
+                {
+                    depth--;
+                }
+                reader->current++;
+            }
 
-            size_t array_count = json_array_get_count(device_array);
-            for (size_t i = 0; i < array_count; i++)
+            if (depth > DEVICE_JSON_MAX_SKIP_DEPTH)
             {
-                IOTHUB_DEVICE* iothubDevice = NULL;
-                JSON_Object* device_object = NULL;
+                result = __LINE__;
+            }
+            else if ((depth > 0) && (reader->current >= reader->end))
+            {
+                result = __LINE__;
+            }
+        } while ((result == 0) && (depth > 0));
+    }
+    else
+    {
+        /* number, true, false or null */
+        const char* start = reader->current;
+        while ((reader->current < reader->end) &&
+            (*reader->current != ',') && (*reader->current != '}') && (*reader->current != ']') &&
+            (*reader->current != ' ') && (*reader->current != '\t') && (*reader->current != '\r') && (*reader->current != '\n'))
+        {
+            reader->current++;
+        }
+        result = (reader->current == start) ? __LINE__ : 0;
+    }
+
+    return result;
+}
 
-                // Create temp device struct
-                if ((iothubDevice = (IOTHUB_DEVICE*)malloc(sizeof(IOTHUB_DEVICE))) == NULL)
+static int readJsonCount(DEVICE_JSON_READER* reader, size_t* value)
+{
+    int result;
+    const char* digit;
+
+    /* the hub sends cloudToDeviceMessageCount as a number, older versions sent it as a string */
+    skipJsonWhitespace(reader);
+    digit = reader->current;
+    if ((result = skipJsonValue(reader)) == 0)
+    {
+        if (*digit == '"')
+        {
+            digit++;
+        }
+
+        *value = 0;
+        while ((digit < reader->current) && (*digit >= '0') && (*digit <= '9'))
+        {
+            *value = (*value * 10) + (size_t)(*digit - '0');
+            digit++;
+        }
+    }
+
+    return result;
+}
+
+static int parseDeviceJsonMembers(DEVICE_JSON_READER* reader, DEVICE_JSON_LEVEL level, DEVICE_JSON_VALUES* values)
+{
+    int result;
+
+    if (expectJsonChar(reader, '{') != 0)
+    {
+        result = __LINE__;
+    }
+    else if (peekJsonChar(reader, '}'))
+    {
+        reader->current++;
+        result = 0;
+    }
+    else
+    {
+        result = 0;
+        do
+        {
+            DEVICE_JSON_SPAN key;
+            size_t i;
+
+            if ((readJsonString(reader, &key) != 0) || (expectJsonChar(reader, ':') != 0))
+            {
+                result = __LINE__;
+                break;
+            }
+
+            for (i = 0; i < sizeof(DEVICE_JSON_STRING_FIELDS) / sizeof(DEVICE_JSON_STRING_FIELDS[0]); i++)
+            {
+                if ((DEVICE_JSON_STRING_FIELDS[i].level == level) && spanEquals(&key, DEVICE_JSON_STRING_FIELDS[i].name))
                 {
-                    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                    LogError("Malloc failed for iothubDevice");
-                    result = IOTHUB_REGISTRYMANAGER_ERROR;
+                    break;
                 }
-                else if ((device_object = json_array_get_object(device_array, i)) == NULL)
+            }
+
+            if ((i < sizeof(DEVICE_JSON_STRING_FIELDS) / sizeof(DEVICE_JSON_STRING_FIELDS[0])) && peekJsonChar(reader, '"'))
+            {
+                result = readJsonString(reader, &values->strings[DEVICE_JSON_STRING_FIELDS[i].field]);
+            }
+            else if ((level == DEVICE_JSON_LEVEL_DEVICE) && spanEquals(&key, DEVICE_JSON_KEY_AUTHENTICATION) && peekJsonChar(reader, '{'))
+            {
+                result = parseDeviceJsonMembers(reader, DEVICE_JSON_LEVEL_AUTHENTICATION, values);
+            }
+            else if ((level == DEVICE_JSON_LEVEL_AUTHENTICATION) && spanEquals(&key, DEVICE_JSON_KEY_SYMMETRIC_KEY) && peekJsonChar(reader, '{'))
+            {
+                result = parseDeviceJsonMembers(reader, DEVICE_JSON_LEVEL_SYMMETRIC_KEY, values);
+            }
+            else if ((level == DEVICE_JSON_LEVEL_DEVICE) && spanEquals(&key, DEVICE_JSON_KEY_DEVICE_CONNECTIONSTATE) && peekJsonChar(reader, '"'))
+            {
+                DEVICE_JSON_SPAN value;
+                if ((result = readJsonString(reader, &value)) == 0)
                 {
-                    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [** If any of the parson API fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR **] */
-                    LogError("json_array_get_object failed");
-                    free(iothubDevice);
-                    result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+                    values->connectionState = spanEquals(&value, DEVICE_JSON_DEFAULT_VALUE_CONNECTED) ? IOTHUB_DEVICE_CONNECTION_STATE_CONNECTED : IOTHUB_DEVICE_CONNECTION_STATE_DISCONNECTED;
                 }
-                else
+            }
+            else if ((level == DEVICE_JSON_LEVEL_DEVICE) && spanEquals(&key, DEVICE_JSON_KEY_DEVICE_STATUS) && peekJsonChar(reader, '"'))
+            {
+                DEVICE_JSON_SPAN value;
+                if ((result = readJsonString(reader, &value)) == 0)
                 {
-                    iothubDevice->deviceId = NULL;
-                    iothubDevice->primaryKey = NULL;
-                    iothubDevice->secondaryKey = NULL;
-                    iothubDevice->generationId = NULL;
-                    iothubDevice->eTag = NULL;
-                    iothubDevice->connectionStateUpdatedTime = NULL;
-                    iothubDevice->connectionState = IOTHUB_DEVICE_CONNECTION_STATE_DISCONNECTED;
-                    iothubDevice->status = IOTHUB_DEVICE_STATUS_DISABLED;
-                    iothubDevice->statusReason = NULL;
-                    iothubDevice->statusUpdatedTime = NULL;
-                    iothubDevice->lastActivityTime = NULL;
-                    iothubDevice->cloudToDeviceMessageCount = 0;
-                    iothubDevice->isManaged = false;
-                    iothubDevice->configuration = NULL;
-                    iothubDevice->deviceProperties = NULL;
-                    iothubDevice->serviceProperties = NULL;
-                    const char* deviceId = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_NAME);
-                    const char* primaryKey = (char*)json_object_dotget_string(device_object, DEVICE_JSON_KEY_DEVICE_PRIMARY_KEY);
-                    const char* secondaryKey = (char*)json_object_dotget_string(device_object, DEVICE_JSON_KEY_DEVICE_SECONDARY_KEY);
-                    const char* generationId = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_GENERATION_ID);
-                    const char* eTag = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_ETAG);
-                    const char* connectionState = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_CONNECTIONSTATE);
-                    const char* connectionStateUpdatedTime = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_CONNECTIONSTATEUPDATEDTIME);
-                    const char* status = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_STATUS);
-                    const char* statusReason = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_STATUSREASON);
-                    const char* statusUpdatedTime = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_STATUSUPDATEDTIME);
-                    const char* lastActivityTime = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_LASTACTIVITYTIME);
-                    const char* cloudToDeviceMessageCount = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_CLOUDTODEVICEMESSAGECOUNT);
-                    const char* isManaged = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_ISMANAGED);
-                    const char* configuration = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_CONFIGURATION);
-                    const char* deviceProperties = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_DEVICEROPERTIES);
-                    const char* serviceProperties = (char*)json_object_get_string(device_object, DEVICE_JSON_KEY_DEVICE_SERVICEPROPERTIES);
-
-                    if ((deviceId != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->deviceId), deviceId) != 0))
-                    {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for deviceId");
-                        free(iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
-                    }
-                    else if ((primaryKey != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->primaryKey), primaryKey) != 0))
-                    {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for primaryKey");
-                        free((char*)iothubDevice->deviceId);
-                        free(iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
-                    }
-                    else if ((secondaryKey != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->secondaryKey), secondaryKey) != 0))
-                    {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for secondaryKey");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free(iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
-                    }
-                    else if ((generationId != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->generationId), generationId) != 0))
-                    {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for generationId");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free((char*)iothubDevice->secondaryKey);
-                        free(iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
-                    }
-                    else if ((eTag != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->eTag), eTag) != 0))
-                    {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for eTag");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free((char*)iothubDevice->secondaryKey);
-                        free((char*)iothubDevice->generationId);
-                        free(iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
-                    }
-                    else if ((connectionStateUpdatedTime != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->connectionStateUpdatedTime), connectionStateUpdatedTime) != 0))
+                    values->status = spanEquals(&value, DEVICE_JSON_DEFAULT_VALUE_ENABLED) ? IOTHUB_DEVICE_STATUS_ENABLED : IOTHUB_DEVICE_STATUS_DISABLED;
+                }
+            }
+            else if ((level == DEVICE_JSON_LEVEL_DEVICE) && spanEquals(&key, DEVICE_JSON_KEY_DEVICE_CLOUDTODEVICEMESSAGECOUNT))
+            {
+                result = readJsonCount(reader, &values->cloudToDeviceMessageCount);
+            }
+            else if ((level == DEVICE_JSON_LEVEL_DEVICE) && spanEquals(&key, DEVICE_JSON_KEY_DEVICE_ISMANAGED))
+            {
+                const char* start;
+                skipJsonWhitespace(reader);
+                start = reader->current;
+                if ((result = skipJsonValue(reader)) == 0)
+                {
+                    DEVICE_JSON_SPAN value;
+                    value.start = (*start == '"') ? start + 1 : start;
+                    value.length = (size_t)(reader->current - start) - ((*start == '"') ? 2 : 0);
+                    values->isManaged = spanEquals(&value, DEVICE_JSON_DEFAULT_VALUE_TRUE) ? true : false;
+                }
+            }
+            else
+            {
+                result = skipJsonValue(reader);
+            }
+
+            if (result != 0)
+            {
+                break;
+            }
+            else if (peekJsonChar(reader, ','))
+            {
+                reader->current++;
+            }
+            else if (expectJsonChar(reader, '}') == 0)
+            {
+                break;
+            }
+            else
+            {
+                result = __LINE__;
+            }
+        } while (result == 0);
+    }
+
+    return result;
+}
+
+static size_t unescapeJsonString(const DEVICE_JSON_SPAN* span, char* destination)
+{
+    size_t written = 0;
+    size_t i = 0;
+
+    while (i < span->length)
+    {
+        char c = span->start[i++];
+        if ((c != '\\') || (i >= span->length))
+        {
+            destination[written++] = c;
+        }
+        else
+        {
+            c = span->start[i++];
+            switch (c)
+            {
+            case 'b': destination[written++] = '\b'; break;
+            case 'f': destination[written++] = '\f'; break;
+            case 'n': destination[written++] = '\n'; break;
+            case 'r': destination[written++] = '\r'; break;
+            case 't': destination[written++] = '\t'; break;
+            case 'u':
+            {
+                unsigned long codePoint = 0;
+                size_t j;
+                for (j = 0; (j < 4) && (i < span->length); j++, i++)
+                {
+                    char h = span->start[i];
+                    codePoint = (codePoint << 4) |
+                        (unsigned long)(((h >= '0') && (h <= '9')) ? (h - '0') : ((h >= 'a') && (h <= 'f')) ? (h - 'a' + 10) : ((h >= 'A') && (h <= 'F')) ? (h - 'A' + 10) : 0);
+                }
+                if ((codePoint >= 0xD800) && (codePoint <= 0xDBFF) && (i + 6 <= span->length) && (span->start[i] == '\\') && (span->start[i + 1] == 'u'))
+                {
+                    unsigned long low = 0;
+                    for (j = 2; j < 6; j++)
                     {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for connectionStateUpdatedTime");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free((char*)iothubDevice->secondaryKey);
-                        free((char*)iothubDevice->generationId);
-                        free((char*)iothubDevice->eTag);
-                        free(iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
+                        char h = span->start[i + j];
+                        low = (low << 4) |
+                            (unsigned long)(((h >= '0') && (h <= '9')) ? (h - '0') : ((h >= 'a') && (h <= 'f')) ? (h - 'a' + 10) : ((h >= 'A') && (h <= 'F')) ? (h - 'A' + 10) : 0);
                     }
-                    else if ((statusReason != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->statusReason), statusReason) != 0))
+                    if ((low >= 0xDC00) && (low <= 0xDFFF))
                     {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for statusReason");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free((char*)iothubDevice->secondaryKey);
-                        free((char*)iothubDevice->generationId);
-                        free((char*)iothubDevice->eTag);
-                        free((char*)iothubDevice->connectionStateUpdatedTime);
-                        free(iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
                     }
-                    else if ((statusUpdatedTime != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->statusUpdatedTime), statusUpdatedTime) != 0))
+                }
+
+                if (codePoint < 0x80)
+                {
+                    destination[written++] = (char)codePoint;
+                }
+                else if (codePoint < 0x800)
+                {
+                    destination[written++] = (char)(0xC0 | (codePoint >> 6));
+                    destination[written++] = (char)(0x80 | (codePoint & 0x3F));
+                }
+                else if (codePoint < 0x10000)
+                {
+                    destination[written++] = (char)(0xE0 | (codePoint >> 12));
+                    destination[written++] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                    destination[written++] = (char)(0x80 | (codePoint & 0x3F));
+                }
+                else
+                {
+                    destination[written++] = (char)(0xF0 | (codePoint >> 18));
+                    destination[written++] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+                    destination[written++] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                    destination[written++] = (char)(0x80 | (codePoint & 0x3F));
+                }
+                break;
+            }
+            default:
+                /* \" \\ \/ */
+                destination[written++] = c;
+                break;
+            }
+        }
+    }
+
+    destination[written] = '\0';
+    return written + 1;
+}
+
+static void freeDeviceStrings(IOTHUB_DEVICE* deviceInfo)
+{
+    free((void*)deviceInfo->deviceId);
+    free((void*)deviceInfo->primaryKey);
+    free((void*)deviceInfo->secondaryKey);
+    free((void*)deviceInfo->generationId);
+    free((void*)deviceInfo->eTag);
+    free((void*)deviceInfo->connectionStateUpdatedTime);
+    free((void*)deviceInfo->statusReason);
+    free((void*)deviceInfo->statusUpdatedTime);
+    free((void*)deviceInfo->lastActivityTime);
+    free((void*)deviceInfo->configuration);
+    free((void*)deviceInfo->deviceProperties);
+    free((void*)deviceInfo->serviceProperties);
+
+    deviceInfo->deviceId = NULL;
+    deviceInfo->primaryKey = NULL;
+    deviceInfo->secondaryKey = NULL;
+    deviceInfo->generationId = NULL;
+    deviceInfo->eTag = NULL;
+    deviceInfo->connectionStateUpdatedTime = NULL;
+    deviceInfo->statusReason = NULL;
+    deviceInfo->statusUpdatedTime = NULL;
+    deviceInfo->lastActivityTime = NULL;
+    deviceInfo->configuration = NULL;
+    deviceInfo->deviceProperties = NULL;
+    deviceInfo->serviceProperties = NULL;
+}
+
+static IOTHUB_DEVICE* createDeviceFromJsonValues(const DEVICE_JSON_VALUES* values)
+{
+    IOTHUB_DEVICE* result;
+    char* strings[DEVICE_JSON_FIELD_COUNT];
+    size_t i;
+
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_029: [ Every device of the list shall be allocated like the one returned by IoTHubRegistryManager_GetDevice, the IOTHUB_DEVICE structure and each of its strings in an allocation of its own ] */
+    for (i = 0; i < DEVICE_JSON_FIELD_COUNT; i++)
+    {
+        if (values->strings[i].start == NULL)
+        {
+            strings[i] = NULL;
+        }
+        /* an unescaped string is never longer than its escaped form, so the span bounds the size of the string */
+        else if ((strings[i] = (char*)malloc(values->strings[i].length + 1)) == NULL)
+        {
+            LogError("Malloc failed for a string of the iothubDevice");
+            break;
+        }
+        else
+        {
+            (void)unescapeJsonString(&values->strings[i], strings[i]);
+        }
+    }
+
+    if (i < DEVICE_JSON_FIELD_COUNT)
+    {
+        size_t j;
+        for (j = 0; j < i; j++)
+        {
+            free(strings[j]);
+        }
+        result = NULL;
+    }
+    else if ((result = (IOTHUB_DEVICE*)malloc(sizeof(IOTHUB_DEVICE))) == NULL)
+    {
+        LogError("Malloc failed for iothubDevice");
+        for (i = 0; i < DEVICE_JSON_FIELD_COUNT; i++)
+        {
+            free(strings[i]);
+        }
+    }
+    else
+    {
+        result->deviceId = strings[DEVICE_JSON_FIELD_DEVICE_ID];
+        result->primaryKey = strings[DEVICE_JSON_FIELD_PRIMARY_KEY];
+        result->secondaryKey = strings[DEVICE_JSON_FIELD_SECONDARY_KEY];
+        result->generationId = strings[DEVICE_JSON_FIELD_GENERATION_ID];
+        result->eTag = strings[DEVICE_JSON_FIELD_ETAG];
+        result->connectionState = values->connectionState;
+        result->connectionStateUpdatedTime = strings[DEVICE_JSON_FIELD_CONNECTION_STATE_UPDATED_TIME];
+        result->status = values->status;
+        result->statusReason = strings[DEVICE_JSON_FIELD_STATUS_REASON];
+        result->statusUpdatedTime = strings[DEVICE_JSON_FIELD_STATUS_UPDATED_TIME];
+        result->lastActivityTime = strings[DEVICE_JSON_FIELD_LAST_ACTIVITY_TIME];
+        result->cloudToDeviceMessageCount = values->cloudToDeviceMessageCount;
+        result->isManaged = values->isManaged;
+        result->configuration = strings[DEVICE_JSON_FIELD_CONFIGURATION];
+        result->deviceProperties = strings[DEVICE_JSON_FIELD_DEVICE_PROPERTIES];
+        result->serviceProperties = strings[DEVICE_JSON_FIELD_SERVICE_PROPERTIES];
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT parseDeviceListJson(BUFFER_HANDLE jsonBuffer, SINGLYLINKEDLIST_HANDLE deviceList)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    if (jsonBuffer == NULL)
+    {
+        LogError("jsonBuffer cannot be NULL");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (deviceList == NULL)
+    {
+        LogError("deviceList cannot be NULL");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else
+    {
+        const char* bufferStr;
+
+        if ((bufferStr = (const char*)BUFFER_u_char(jsonBuffer)) == NULL)
+        {
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
+            LogError("BUFFER_u_char failed");
+            result = IOTHUB_REGISTRYMANAGER_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_028: [ IoTHubRegistryManager_GetDeviceList shall parse the response JSON in place, reading the devices of the array one after the other without building a document of the whole response ] */
+            DEVICE_JSON_READER reader;
+            reader.current = bufferStr;
+            reader.end = bufferStr + BUFFER_length(jsonBuffer);
+
+            if (expectJsonChar(&reader, '[') != 0)
+            {
+                /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [** If the JSON parsing fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR **] */
+                LogError("device list JSON is not an array");
+                result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+            }
+            else if (peekJsonChar(&reader, ']'))
+            {
+                result = IOTHUB_REGISTRYMANAGER_OK;
+            }
+            else
+            {
+                result = IOTHUB_REGISTRYMANAGER_OK;
+                do
+                {
+                    DEVICE_JSON_VALUES values;
+                    IOTHUB_DEVICE* iothubDevice;
+
+                    (void)memset(&values, 0, sizeof(values));
+                    values.connectionState = IOTHUB_DEVICE_CONNECTION_STATE_DISCONNECTED;
+                    values.status = IOTHUB_DEVICE_STATUS_DISABLED;
+
+                    if (parseDeviceJsonMembers(&reader, DEVICE_JSON_LEVEL_DEVICE, &values) != 0)
                     {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for statusUpdatedTime");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free((char*)iothubDevice->secondaryKey);
-                        free((char*)iothubDevice->generationId);
-                        free((char*)iothubDevice->eTag);
-                        free((char*)iothubDevice->connectionStateUpdatedTime);
-                        free((char*)iothubDevice->statusReason);
-                        free((char*)iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
+                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [** If the JSON parsing fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR **] */
+                        LogError("Failure parsing the device JSON");
+                        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
                     }
-                    else if ((lastActivityTime != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->lastActivityTime), lastActivityTime) != 0))
+                    else if ((iothubDevice = createDeviceFromJsonValues(&values)) == NULL)
                     {
                         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for lastActivityTime");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free((char*)iothubDevice->secondaryKey);
-                        free((char*)iothubDevice->generationId);
-                        free((char*)iothubDevice->eTag);
-                        free((char*)iothubDevice->connectionStateUpdatedTime);
-                        free((char*)iothubDevice->statusReason);
-                        free((char*)iothubDevice->statusUpdatedTime);
-                        free(iothubDevice);
                         result = IOTHUB_REGISTRYMANAGER_ERROR;
                     }
-                    else if ((configuration != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->configuration), configuration) != 0))
+                    else if ((singlylinkedlist_add(deviceList, iothubDevice)) == NULL)
                     {
                         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for configuration");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free((char*)iothubDevice->secondaryKey);
-                        free((char*)iothubDevice->generationId);
-                        free((char*)iothubDevice->eTag);
-                        free((char*)iothubDevice->connectionStateUpdatedTime);
-                        free((char*)iothubDevice->statusReason);
-                        free((char*)iothubDevice->statusUpdatedTime);
-                        free((char*)iothubDevice->lastActivityTime);
+                        LogError("singlylinkedlist_add failed");
+                        freeDeviceStrings(iothubDevice);
                         free(iothubDevice);
                         result = IOTHUB_REGISTRYMANAGER_ERROR;
                     }
-                    else if ((deviceProperties != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->deviceProperties), deviceProperties) != 0))
+                    else if (peekJsonChar(&reader, ','))
                     {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for deviceProperties");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free((char*)iothubDevice->secondaryKey);
-                        free((char*)iothubDevice->generationId);
-                        free((char*)iothubDevice->eTag);
-                        free((char*)iothubDevice->connectionStateUpdatedTime);
-                        free((char*)iothubDevice->statusReason);
-                        free((char*)iothubDevice->statusUpdatedTime);
-                        free((char*)iothubDevice->lastActivityTime);
-                        free((char*)iothubDevice->configuration);
-                        free(iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
+                        reader.current++;
                     }
-                    else if ((serviceProperties != NULL) && (mallocAndStrcpy_s((char**)&(iothubDevice->serviceProperties), serviceProperties) != 0))
+                    else if (expectJsonChar(&reader, ']') == 0)
                     {
-                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                        LogError("mallocAndStrcpy_s failed for serviceProperties");
-                        free((char*)iothubDevice->deviceId);
-                        free((char*)iothubDevice->primaryKey);
-                        free((char*)iothubDevice->secondaryKey);
-                        free((char*)iothubDevice->generationId);
-                        free((char*)iothubDevice->eTag);
-                        free((char*)iothubDevice->connectionStateUpdatedTime);
-                        free((char*)iothubDevice->statusReason);
-                        free((char*)iothubDevice->statusUpdatedTime);
-                        free((char*)iothubDevice->lastActivityTime);
-                        free((char*)iothubDevice->configuration);
-                        free((char*)iothubDevice->deviceProperties);
-                        free(iothubDevice);
-                        result = IOTHUB_REGISTRYMANAGER_ERROR;
+                        break;
                     }
                     else
                     {
-                        if ((connectionState != NULL) && (strcmp(connectionState, DEVICE_JSON_DEFAULT_VALUE_CONNECTED) == 0))
-                        {
-	                        iothubDevice->connectionState = IOTHUB_DEVICE_CONNECTION_STATE_CONNECTED;
-                        }
-                        if ((status != NULL) && (strcmp(status, DEVICE_JSON_DEFAULT_VALUE_ENABLED) == 0))
-                        {
-                            iothubDevice->status = IOTHUB_DEVICE_STATUS_ENABLED;
-                        }
-                        if (cloudToDeviceMessageCount != NULL)
-                        {
-                            iothubDevice->cloudToDeviceMessageCount = atoi(cloudToDeviceMessageCount);
-                        }
-                        if ((isManaged != NULL) && (strcmp(isManaged, DEVICE_JSON_DEFAULT_VALUE_TRUE) == 0))
-                        {
-                            iothubDevice->isManaged = true;
-                        }
-
-                        if ((singlylinkedlist_add(deviceList, iothubDevice)) == NULL)
-                        {
-                            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [** If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR **] */
-                            LogError("singlylinkedlist_add failed");
-                            free((char*)iothubDevice->deviceId);
-                            free((char*)iothubDevice->primaryKey);
-                            free((char*)iothubDevice->secondaryKey);
-                            free((char*)iothubDevice->generationId);
-                            free((char*)iothubDevice->eTag);
-                            free((char*)iothubDevice->connectionStateUpdatedTime);
-                            free((char*)iothubDevice->statusReason);
-                            free((char*)iothubDevice->statusUpdatedTime);
-                            free((char*)iothubDevice->lastActivityTime);
-                            free((char*)iothubDevice->configuration);
-                            free((char*)iothubDevice->deviceProperties);
-                            free((char*)iothubDevice->serviceProperties);
-                            free(iothubDevice);
-                            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
-                        }
+                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [** If the JSON parsing fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR **] */
+                        LogError("device list JSON array is not terminated");
+                        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
                     }
-                }
-
-                if ((device_object != NULL) && ((jsonStatus = json_object_clear(device_object)) != JSONSuccess))
-                {
-                    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [** If any of the parson API fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR **] */
-                    LogError("json_object_clear failed");
-                    result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
-                }
-                if (result != IOTHUB_REGISTRYMANAGER_OK)
-                {
-                    break;
-                }
+                } while (result == IOTHUB_REGISTRYMANAGER_OK);
             }
         }
     }
-    if (device_array != NULL)
-    {
-        if ((jsonStatus = json_array_clear(device_array)) != JSONSuccess)
-        {
-            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [** If any of the parson API fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR **] */
-            LogError("json_array_clear failed");
-            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
-        }
-    }
-
-    if (root_value != NULL)
-    {
-        json_value_free(root_value);
-    }
 
-    if (result != IOTHUB_REGISTRYMANAGER_OK)
+    if ((result != IOTHUB_REGISTRYMANAGER_OK) && (deviceList != NULL))
     {
-        if (deviceList != NULL)
+        LIST_ITEM_HANDLE itemHandle = singlylinkedlist_get_head_item(deviceList);
+        while (itemHandle != NULL)
         {
-            LIST_ITEM_HANDLE itemHandle = singlylinkedlist_get_head_item(deviceList);
-            while (itemHandle != NULL)
-            {
-                IOTHUB_DEVICE* deviceInfo = (IOTHUB_DEVICE*)singlylinkedlist_item_get_value(itemHandle);
-                LIST_ITEM_HANDLE lastHandle = itemHandle;
-                itemHandle = singlylinkedlist_get_next_item(itemHandle);
+            IOTHUB_DEVICE* deviceInfo = (IOTHUB_DEVICE*)singlylinkedlist_item_get_value(itemHandle);
+            LIST_ITEM_HANDLE lastHandle = itemHandle;
+            itemHandle = singlylinkedlist_get_next_item(itemHandle);
 
-                if (deviceInfo->deviceId != NULL)
-                    free((char*)deviceInfo->deviceId);
-                if (deviceInfo->primaryKey != NULL)
-                    free((char*)deviceInfo->primaryKey);
-                if (deviceInfo->secondaryKey != NULL)
-                    free((char*)deviceInfo->secondaryKey);
-                if (deviceInfo->generationId != NULL)
-                    free((char*)deviceInfo->generationId);
-                if (deviceInfo->eTag != NULL)
-                    free((char*)deviceInfo->eTag);
-                if (deviceInfo->connectionStateUpdatedTime != NULL)
-                    free((char*)deviceInfo->connectionStateUpdatedTime);
-                if (deviceInfo->statusReason != NULL)
-                    free((char*)deviceInfo->statusReason);
-                if (deviceInfo->statusUpdatedTime != NULL)
-                    free((char*)deviceInfo->statusUpdatedTime);
-                if (deviceInfo->lastActivityTime != NULL)
-                    free((char*)deviceInfo->lastActivityTime);
-                if (deviceInfo->configuration != NULL)
-                    free((char*)deviceInfo->configuration);
-                if (deviceInfo->deviceProperties != NULL)
-                    free((char*)deviceInfo->deviceProperties);
-                if (deviceInfo->serviceProperties != NULL)
-                    free((char*)deviceInfo->serviceProperties);
-                free(deviceInfo);
-
-                singlylinkedlist_remove(deviceList, lastHandle);
-            }
+            freeDeviceStrings(deviceInfo);
+            free(deviceInfo);
+
+            singlylinkedlist_remove(deviceList, lastHandle);
         }
     }
     return result;
@@ -850,28 +1155,269 @@ static IOTHUB_REGISTRYMANAGER_RESULT parseStatisticsJson(BUFFER_HANDLE jsonBuffe
         }
         else if ((root_object = json_value_get_object(root_value)) == NULL)
         {
-            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_082: [ If the parsing failed, IoTHubRegistryManager_GetStatistics shall return IOTHUB_REGISTRYMANAGER_ERROR ] */
-            LogError("json_value_get_object failed");
-            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_082: [ If the parsing failed, IoTHubRegistryManager_GetStatistics shall return IOTHUB_REGISTRYMANAGER_ERROR ] */
+            LogError("json_value_get_object failed");
+            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_083: [ IoTHubRegistryManager_GetStatistics shall save the registry statistics to the out value and return IOTHUB_REGISTRYMANAGER_OK ] */
+            registryStatistics->totalDeviceCount = (size_t)json_object_get_number(root_object, DEVICE_JSON_KEY_TOTAL_DEVICECOUNT);
+            registryStatistics->enabledDeviceCount = (size_t)json_object_get_number(root_object, DEVICE_JSON_KEY_ENABLED_DEVICECCOUNT);
+            registryStatistics->disabledDeviceCount = (size_t)json_object_get_number(root_object, DEVICE_JSON_KEY_DISABLED_DEVICECOUNT);
+
+            result = IOTHUB_REGISTRYMANAGER_OK;
+        }
+
+        if ((jsonStatus = json_object_clear(root_object)) != JSONSuccess)
+        {
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_082: [ If the parsing failed, IoTHubRegistryManager_GetStatistics shall return IOTHUB_REGISTRYMANAGER_ERROR ] */
+            LogError("json_object_clear failed");
+            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+        }
+        json_value_free(root_value);
+    }
+    return result;
+}
+
+static const char* bulkImportModeToString(IOTHUB_REGISTRY_BULK_IMPORT_MODE importMode)
+{
+    const char* result;
+
+    switch (importMode)
+    {
+    case IOTHUB_REGISTRY_BULK_IMPORT_MODE_CREATE:
+        result = DEVICE_JSON_VALUE_IMPORT_MODE_CREATE;
+        break;
+    case IOTHUB_REGISTRY_BULK_IMPORT_MODE_UPDATE:
+        result = DEVICE_JSON_VALUE_IMPORT_MODE_UPDATE;
+        break;
+    case IOTHUB_REGISTRY_BULK_IMPORT_MODE_DELETE:
+        result = DEVICE_JSON_VALUE_IMPORT_MODE_DELETE;
+        break;
+    default:
+        result = NULL;
+        break;
+    }
+
+    return result;
+}
+
+static int addBulkOperationJson(JSON_Array* root_array, const IOTHUB_REGISTRY_BULK_OPERATION* operation)
+{
+    int result;
+    JSON_Value* device_value;
+    JSON_Object* device_object;
+
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_021: [ Every operation shall be serialized as a JSON object with the id and importMode properties, and unless importMode is IOTHUB_REGISTRY_BULK_IMPORT_MODE_DELETE the status and the non NULL symmetric keys of the device. ] */
+    if ((device_value = json_value_init_object()) == NULL)
+    {
+        LogError("json_value_init_object failed");
+        result = __LINE__;
+    }
+    else if ((device_object = json_value_get_object(device_value)) == NULL)
+    {
+        LogError("json_value_get_object failed");
+        json_value_free(device_value);
+        result = __LINE__;
+    }
+    else if (json_object_set_string(device_object, DEVICE_JSON_KEY_BULK_DEVICE_ID, operation->deviceId) != JSONSuccess)
+    {
+        LogError("json_object_set_string failed for deviceId");
+        json_value_free(device_value);
+        result = __LINE__;
+    }
+    else if (json_object_set_string(device_object, DEVICE_JSON_KEY_BULK_IMPORT_MODE, bulkImportModeToString(operation->importMode)) != JSONSuccess)
+    {
+        LogError("json_object_set_string failed for importMode");
+        json_value_free(device_value);
+        result = __LINE__;
+    }
+    else if ((operation->importMode != IOTHUB_REGISTRY_BULK_IMPORT_MODE_DELETE) &&
+        (json_object_set_string(device_object, DEVICE_JSON_KEY_DEVICE_STATUS, (operation->status == IOTHUB_DEVICE_STATUS_DISABLED) ? DEVICE_JSON_DEFAULT_VALUE_DISABLED : DEVICE_JSON_DEFAULT_VALUE_ENABLED) != JSONSuccess))
+    {
+        LogError("json_object_set_string failed for status");
+        json_value_free(device_value);
+        result = __LINE__;
+    }
+    else if ((operation->importMode != IOTHUB_REGISTRY_BULK_IMPORT_MODE_DELETE) && (operation->primaryKey != NULL) &&
+        (json_object_dotset_string(device_object, DEVICE_JSON_KEY_DEVICE_PRIMARY_KEY, operation->primaryKey) != JSONSuccess))
+    {
+        LogError("json_object_dotset_string failed for primaryKey");
+        json_value_free(device_value);
+        result = __LINE__;
+    }
+    else if ((operation->importMode != IOTHUB_REGISTRY_BULK_IMPORT_MODE_DELETE) && (operation->secondaryKey != NULL) &&
+        (json_object_dotset_string(device_object, DEVICE_JSON_KEY_DEVICE_SECONDARY_KEY, operation->secondaryKey) != JSONSuccess))
+    {
+        LogError("json_object_dotset_string failed for secondaryKey");
+        json_value_free(device_value);
+        result = __LINE__;
+    }
+    else if (json_array_append_value(root_array, device_value) != JSONSuccess)
+    {
+        LogError("json_array_append_value failed");
+        json_value_free(device_value);
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static BUFFER_HANDLE constructBulkOperationJson(const IOTHUB_REGISTRY_BULK_OPERATION* operations, size_t operationCount)
+{
+    BUFFER_HANDLE result;
+    JSON_Value* root_value;
+    JSON_Array* root_array;
+
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_020: [ IoTHubRegistryManager_BulkOperation shall send the operations in batches of at most IOTHUB_REGISTRY_BULK_OPERATION_MAX_COUNT, each as an HTTP POST request to url/devices?api-version with a JSON array of the batch as body. ] */
+    if ((root_value = json_value_init_array()) == NULL)
+    {
+        LogError("json_value_init_array failed");
+        result = NULL;
+    }
+    else
+    {
+        if ((root_array = json_value_get_array(root_value)) == NULL)
+        {
+            LogError("json_value_get_array failed");
+            result = NULL;
+        }
+        else
+        {
+            size_t i;
+            for (i = 0; i < operationCount; i++)
+            {
+                if (addBulkOperationJson(root_array, &operations[i]) != 0)
+                {
+                    break;
+                }
+            }
+
+            if (i < operationCount)
+            {
+                LogError("Failure adding operation %lu to the bulk request", (unsigned long)i);
+                result = NULL;
+            }
+            else
+            {
+                char* serialized_string;
+                if ((serialized_string = json_serialize_to_string(root_value)) == NULL)
+                {
+                    LogError("json_serialize_to_string failed");
+                    result = NULL;
+                }
+                else
+                {
+                    if ((result = BUFFER_create((const unsigned char*)serialized_string, strlen(serialized_string))) == NULL)
+                    {
+                        LogError("Buffer_Create failed");
+                    }
+                    json_free_serialized_string(serialized_string);
+                }
+            }
+        }
+        json_value_free(root_value);
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT bulkErrorCodeToResult(const char* errorCode)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_024: [ The errorCode DeviceAlreadyExists shall be reported as IOTHUB_REGISTRYMANAGER_DEVICE_EXIST, DeviceNotFound as IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST and any other errorCode as IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR. ] */
+    if ((errorCode != NULL) && (strcmp(errorCode, DEVICE_JSON_VALUE_ERROR_DEVICE_ALREADY_EXISTS) == 0))
+    {
+        result = IOTHUB_REGISTRYMANAGER_DEVICE_EXIST;
+    }
+    else if ((errorCode != NULL) && (strcmp(errorCode, DEVICE_JSON_VALUE_ERROR_DEVICE_NOT_FOUND) == 0))
+    {
+        result = IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST;
+    }
+    else
+    {
+        result = IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR;
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT parseBulkOperationJson(BUFFER_HANDLE jsonBuffer, IOTHUB_REGISTRY_BULK_OPERATION* operations, size_t operationCount)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    const char* bufferStr;
+    JSON_Value* root_value = NULL;
+    JSON_Object* root_object;
+    JSON_Array* errors_array;
+
+    if ((bufferStr = (const char*)BUFFER_u_char(jsonBuffer)) == NULL)
+    {
+        LogError("BUFFER_u_char failed");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if ((root_value = json_parse_string(bufferStr)) == NULL)
+    {
+        LogError("json_parse_string failed");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if ((root_object = json_value_get_object(root_value)) == NULL)
+    {
+        LogError("json_value_get_object failed");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if ((errors_array = json_object_get_array(root_object, DEVICE_JSON_KEY_BULK_ERRORS)) == NULL)
+    {
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_025: [ If the response of a batch has no errors and its isSuccessful property is not true, the batch shall be treated as failed with IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR. ] */
+        if (json_object_get_boolean(root_object, DEVICE_JSON_KEY_BULK_IS_SUCCESSFUL) != 1)
+        {
+            LogError("Bulk request was not successful and reported no errors");
+            result = IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR;
         }
         else
         {
-            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_083: [ IoTHubRegistryManager_GetStatistics shall save the registry statistics to the out value and return IOTHUB_REGISTRYMANAGER_OK ] */
-            registryStatistics->totalDeviceCount = (size_t)json_object_get_number(root_object, DEVICE_JSON_KEY_TOTAL_DEVICECOUNT);
-            registryStatistics->enabledDeviceCount = (size_t)json_object_get_number(root_object, DEVICE_JSON_KEY_ENABLED_DEVICECCOUNT);
-            registryStatistics->disabledDeviceCount = (size_t)json_object_get_number(root_object, DEVICE_JSON_KEY_DISABLED_DEVICECOUNT);
-
             result = IOTHUB_REGISTRYMANAGER_OK;
         }
+    }
+    else
+    {
+        size_t errorCount = json_array_get_count(errors_array);
+        size_t i;
 
-        if ((jsonStatus = json_object_clear(root_object)) != JSONSuccess)
+        for (i = 0; i < errorCount; i++)
         {
-            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_082: [ If the parsing failed, IoTHubRegistryManager_GetStatistics shall return IOTHUB_REGISTRYMANAGER_ERROR ] */
-            LogError("json_object_clear failed");
-            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+            JSON_Object* error_object = json_array_get_object(errors_array, i);
+            if (error_object != NULL)
+            {
+                const char* deviceId = json_object_get_string(error_object, DEVICE_JSON_KEY_BULK_ERROR_DEVICE_ID);
+                if (deviceId != NULL)
+                {
+                    size_t j;
+                    for (j = 0; j < operationCount; j++)
+                    {
+                        if ((operations[j].result == IOTHUB_REGISTRYMANAGER_OK) && (strcmp(operations[j].deviceId, deviceId) == 0))
+                        {
+                            operations[j].result = bulkErrorCodeToResult(json_object_get_string(error_object, DEVICE_JSON_KEY_BULK_ERROR_CODE));
+                            break;
+                        }
+                    }
+                }
+            }
         }
+
+        result = IOTHUB_REGISTRYMANAGER_OK;
+    }
+
+    if (root_value != NULL)
+    {
         json_value_free(root_value);
     }
+
     return result;
 }
 
@@ -915,6 +1461,28 @@ static IOTHUB_REGISTRYMANAGER_RESULT createRelativePath(IOTHUB_REQUEST_MODE iotH
             result = IOTHUB_REGISTRYMANAGER_ERROR;
         }
     }
+    else if (iotHubRequestMode == IOTHUB_REQUEST_GET_DEVICE_LIST_PAGE)
+    {
+        if (snprintf(relativePath, 256, RELATIVE_PATH_FMT_QUERY, URL_API_VERSION_QUERY) > 0)
+        {
+            result = IOTHUB_REGISTRYMANAGER_OK;
+        }
+        else
+        {
+            result = IOTHUB_REGISTRYMANAGER_ERROR;
+        }
+    }
+    else if (iotHubRequestMode == IOTHUB_REQUEST_BULK_OPERATION)
+    {
+        if (snprintf(relativePath, 256, RELATIVE_PATH_FMT_BULK, URL_API_VERSION) > 0)
+        {
+            result = IOTHUB_REGISTRYMANAGER_OK;
+        }
+        else
+        {
+            result = IOTHUB_REGISTRYMANAGER_ERROR;
+        }
+    }
     else
     {
         if (snprintf(relativePath, 256, RELATIVE_PATH_FMT_CRUD, deviceName, URL_API_VERSION) > 0)
@@ -985,16 +1553,43 @@ static HTTP_HEADERS_HANDLE createHttpHeader(IOTHUB_REQUEST_MODE iotHubRequestMod
     return httpHeader;
 }
 
-static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, IOTHUB_REQUEST_MODE iotHubRequestMode, const char* deviceName, BUFFER_HANDLE deviceJsonBuffer, size_t numberOfDevices, BUFFER_HANDLE responseBuffer)
+static IOTHUB_REGISTRYMANAGER_RESULT addPageHttpHeaders(HTTP_HEADERS_HANDLE httpHeader, size_t pageSize, const char* continuationToken)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    char pageSizeStr[32];
+
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_013: [ IoTHubRegistryManager_GetDeviceListPage shall add the x-ms-max-item-count header with the value of pageSize to the request. ] */
+    if (snprintf(pageSizeStr, sizeof(pageSizeStr), "%lu", (unsigned long)pageSize) <= 0)
+    {
+        LogError("snprintf failed for page size");
+        result = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else if (HTTPHeaders_AddHeaderNameValuePair(httpHeader, HTTP_HEADER_KEY_MAX_ITEM_COUNT, pageSizeStr) != HTTP_HEADERS_OK)
+    {
+        LogError("HTTPHeaders_AddHeaderNameValuePair failed for x-ms-max-item-count header");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_014: [ If continuationToken is not NULL, IoTHubRegistryManager_GetDeviceListPage shall add it to the request in the x-ms-continuation header. ] */
+    else if ((continuationToken != NULL) && (HTTPHeaders_AddHeaderNameValuePair(httpHeader, HTTP_HEADER_KEY_CONTINUATION, continuationToken) != HTTP_HEADERS_OK))
+    {
+        LogError("HTTPHeaders_AddHeaderNameValuePair failed for x-ms-continuation header");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else
+    {
+        result = IOTHUB_REGISTRYMANAGER_OK;
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT refreshSasToken(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle)
 {
     IOTHUB_REGISTRYMANAGER_RESULT result;
 
     STRING_HANDLE uriResouce = NULL;
     STRING_HANDLE accessKey = NULL;
     STRING_HANDLE keyName = NULL;
-    HTTPAPIEX_SAS_HANDLE httpExApiSasHandle = NULL;
-    HTTPAPIEX_HANDLE httpExApiHandle = NULL;
-    HTTP_HEADERS_HANDLE httpHeader = NULL;
 
     if ((uriResouce = STRING_construct(registryManagerHandle->hostname)) == NULL)
     {
@@ -1017,6 +1612,65 @@ static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_
         LogError("STRING_construct failed for keyName");
         result = IOTHUB_REGISTRYMANAGER_ERROR;
     }
+    else
+    {
+        time_t currentTime = time(NULL);
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_003: [ The SAS token shall be created by calling SASToken_Create with an expiry of one hour from the current time. ] */
+        STRING_HANDLE sasToken = SASToken_Create(accessKey, uriResouce, keyName, (size_t)(currentTime + SAS_TOKEN_LIFETIME_SECONDS));
+        if (sasToken == NULL)
+        {
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_005: [ If creating the SAS token fails, the request shall fail and return IOTHUB_REGISTRYMANAGER_ERROR. ] */
+            LogError("SASToken_Create failed");
+            result = IOTHUB_REGISTRYMANAGER_ERROR;
+        }
+        else
+        {
+            if (registryManagerHandle->sasToken != NULL)
+            {
+                STRING_delete(registryManagerHandle->sasToken);
+            }
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_004: [ The SAS token shall be refreshed once half of its lifetime has passed. ] */
+            registryManagerHandle->sasToken = sasToken;
+            registryManagerHandle->sasTokenRefreshTime = currentTime + (SAS_TOKEN_LIFETIME_SECONDS / 2);
+            result = IOTHUB_REGISTRYMANAGER_OK;
+        }
+    }
+
+    STRING_delete(keyName);
+    STRING_delete(accessKey);
+    STRING_delete(uriResouce);
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, IOTHUB_REQUEST_MODE iotHubRequestMode, const char* deviceName, BUFFER_HANDLE deviceJsonBuffer, size_t numberOfDevices, const char* continuationToken, HTTP_HEADERS_HANDLE responseHeaders, BUFFER_HANDLE responseBuffer)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    HTTP_HEADERS_HANDLE httpHeader = NULL;
+
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_016: [ IoTHubRegistryManager_CreateDevice shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_028: [ IoTHubRegistryManager_GetDevice shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_045: [ IoTHubRegistryManager_UpdateDevice shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_055: [ IoTHubRegistryManager_DeleteDevice shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_002: [ The SAS token shall be kept on the registry manager and reused by the following requests until it is due for refresh. ] */
+    if (((registryManagerHandle->sasToken == NULL) || (time(NULL) >= registryManagerHandle->sasTokenRefreshTime)) &&
+        ((result = refreshSasToken(registryManagerHandle)) != IOTHUB_REGISTRYMANAGER_OK))
+    {
+        LogError("Failure getting the SAS token");
+    }
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_017: [ IoTHubRegistryManager_CreateDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_029: [ IoTHubRegistryManager_GetDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_046: [ IoTHubRegistryManager_UpdateDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_056: [ IoTHubRegistryManager_DeleteDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_001: [ The HTTPAPIEX_HANDLE shall be kept on the registry manager and reused by the following requests, so that the connection to the IoT Hub stays open between them. ] */
+    else if ((registryManagerHandle->httpExApiHandle == NULL) &&
+        ((registryManagerHandle->httpExApiHandle = HTTPAPIEX_Create(registryManagerHandle->hostname)) == NULL))
+    {
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_019: [ If any of the HTTPAPI call fails IoTHubRegistryManager_CreateDevice shall fail and return IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR ] */
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_104: [ If any of the HTTPAPI call fails IoTHubRegistryManager_UpdateDevice shall fail and return IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR ] */
+        LogError("HTTPAPIEX_Create failed");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
     /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_015: [ IoTHubRegistryManager_CreateDevice shall create an HTTP PUT request using the following HTTP headers: authorization=sasToken,Request-Id=1001,Accept=application/json,Content-Type=application/json,charset=utf-8 ] */
     /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_027: [ IoTHubRegistryManager_GetDevice shall add the following headers to the created HTTP GET request: authorization=sasToken,Request-Id=1001,Accept=application/json,Content-Type=application/json,charset=utf-8 ] */
     /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_043: [ IoTHubRegistryManager_UpdateDevice shall create an HTTP PUT request using the created JSON ] */
@@ -1029,27 +1683,17 @@ static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_
         LogError("HttpHeader creation failed");
         result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
     }
-    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_016: [ IoTHubRegistryManager_CreateDevice shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_028: [ IoTHubRegistryManager_GetDevice shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_045: [ IoTHubRegistryManager_UpdateDevice shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_055: [ IoTHubRegistryManager_DeleteDevice shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-    else if ((httpExApiSasHandle = HTTPAPIEX_SAS_Create(accessKey, uriResouce, keyName)) == NULL)
+    else if (HTTPHeaders_ReplaceHeaderNameValuePair(httpHeader, HTTP_HEADER_KEY_AUTHORIZATION, STRING_c_str(registryManagerHandle->sasToken)) != HTTP_HEADERS_OK)
     {
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_019: [ If any of the HTTPAPI call fails IoTHubRegistryManager_CreateDevice shall fail and return IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_104: [ If any of the HTTPAPI call fails IoTHubRegistryManager_UpdateDevice shall fail and return IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR ] */
-        LogError("HTTPAPIEX_SAS_Create failed");
+        LogError("HTTPHeaders_ReplaceHeaderNameValuePair failed for Authorization header");
         result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
     }
-    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_017: [ IoTHubRegistryManager_CreateDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
-    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_029: [ IoTHubRegistryManager_GetDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
-    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_046: [ IoTHubRegistryManager_UpdateDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
-    /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_056: [ IoTHubRegistryManager_DeleteDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
-    else if ((httpExApiHandle = HTTPAPIEX_Create(registryManagerHandle->hostname)) == NULL)
+    else if ((iotHubRequestMode == IOTHUB_REQUEST_GET_DEVICE_LIST_PAGE) &&
+        ((result = addPageHttpHeaders(httpHeader, numberOfDevices, continuationToken)) != IOTHUB_REGISTRYMANAGER_OK))
     {
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_019: [ If any of the HTTPAPI call fails IoTHubRegistryManager_CreateDevice shall fail and return IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR ] */
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_104: [ If any of the HTTPAPI call fails IoTHubRegistryManager_UpdateDevice shall fail and return IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR ] */
-        LogError("HTTPAPIEX_Create failed");
-        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+        LogError("Failure adding the paging headers");
     }
     else 
     {
@@ -1066,6 +1710,10 @@ static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_
         {
             httpApiRequestType = HTTPAPI_REQUEST_DELETE;
         }
+        else if ((iotHubRequestMode == IOTHUB_REQUEST_GET_DEVICE_LIST_PAGE) || (iotHubRequestMode == IOTHUB_REQUEST_BULK_OPERATION))
+        {
+            httpApiRequestType = HTTPAPI_REQUEST_POST;
+        }
         else if ((iotHubRequestMode == IOTHUB_REQUEST_GET) || (iotHubRequestMode == IOTHUB_REQUEST_GET_DEVICE_LIST) || (iotHubRequestMode == IOTHUB_REQUEST_GET_STATISTICS))
         {
             httpApiRequestType = HTTPAPI_REQUEST_GET;
@@ -1094,16 +1742,28 @@ static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_
             /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_030: [ IoTHubRegistryManager_GetDevice shall execute the HTTP GET request by calling HTTPAPIEX_ExecuteRequest ] */
             /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_047: [ IoTHubRegistryManager_UpdateDevice shall execute the HTTP PUT request by calling HTTPAPIEX_ExecuteRequest ] */
             /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_057: [ IoTHubRegistryManager_DeleteDevice shall execute the HTTP DELETE request by calling HTTPAPIEX_ExecuteRequest ] */
-            else if (HTTPAPIEX_SAS_ExecuteRequest(httpExApiSasHandle, httpExApiHandle, httpApiRequestType, relativePath, httpHeader, deviceJsonBuffer, &statusCode, NULL, responseBuffer) != HTTPAPIEX_OK)
+            else if (HTTPAPIEX_ExecuteRequest(registryManagerHandle->httpExApiHandle, httpApiRequestType, relativePath, httpHeader, deviceJsonBuffer, &statusCode, responseHeaders, responseBuffer) != HTTPAPIEX_OK)
             {
                 /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_019: [ If any of the HTTPAPI call fails IoTHubRegistryManager_CreateDevice shall fail and return IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR ] */
-                LogError("HTTPAPIEX_SAS_ExecuteRequest failed");
+                LogError("HTTPAPIEX_ExecuteRequest failed");
                 result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
             }
             else
             {
-                if (statusCode > 300)
+                if ((iotHubRequestMode == IOTHUB_REQUEST_BULK_OPERATION) && (statusCode == HTTP_STATUS_CODE_BAD_REQUEST))
+                {
+                    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_023: [ If the HTTP status code of a batch is 400, IoTHubRegistryManager_BulkOperation shall parse the per device errors from the response body. ] */
+                    result = IOTHUB_REGISTRYMANAGER_OK;
+                }
+                else if (statusCode > 300)
                 {
+                    if (statusCode == HTTP_STATUS_CODE_UNAUTHORIZED)
+                    {
+                        /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_006: [ If the HTTP status code is 401, the SAS token shall be discarded so that the next request creates a new one. ] */
+                        STRING_delete(registryManagerHandle->sasToken);
+                        registryManagerHandle->sasToken = NULL;
+                    }
+
                     if ((iotHubRequestMode == IOTHUB_REQUEST_CREATE) && (statusCode == 409))
                     {
                         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_020: [ IoTHubRegistryManager_CreateDevice shall verify the received HTTP status code and if it is 409 then return IOTHUB_REGISTRYMANAGER_DEVICE_EXIST ] */
@@ -1131,11 +1791,6 @@ static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_
     }
 
     HTTPHeaders_Free(httpHeader);
-    HTTPAPIEX_Destroy(httpExApiHandle);
-    HTTPAPIEX_SAS_Destroy(httpExApiSasHandle);
-    STRING_delete(keyName);
-    STRING_delete(accessKey);
-    STRING_delete(uriResouce);
     return result;
 }
 
@@ -1241,6 +1896,13 @@ IOTHUB_REGISTRYMANAGER_HANDLE IoTHubRegistryManager_Create(IOTHUB_SERVICE_CLIENT
                     free(result);
                     result = NULL;
                 }
+                else
+                {
+                    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_007: [ IoTHubRegistryManager_Create shall not open a connection nor create a SAS token, both are created by the first request. ] */
+                    result->httpExApiHandle = NULL;
+                    result->sasToken = NULL;
+                    result->sasTokenRefreshTime = 0;
+                }
             }
         }
     }
@@ -1255,6 +1917,16 @@ void IoTHubRegistryManager_Destroy(IOTHUB_REGISTRYMANAGER_HANDLE registryManager
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_006 : [ If the registryManagerHandle input parameter is not NULL IoTHubRegistryManager_Destroy shall free the memory of it and return ] */
         IOTHUB_REGISTRYMANAGER* regManHandle = (IOTHUB_REGISTRYMANAGER*)registryManagerHandle;
 
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_008: [ IoTHubRegistryManager_Destroy shall close the connection by calling HTTPAPIEX_Destroy and free the SAS token, if they exist. ] */
+        if (regManHandle->httpExApiHandle != NULL)
+        {
+            HTTPAPIEX_Destroy(regManHandle->httpExApiHandle);
+        }
+        if (regManHandle->sasToken != NULL)
+        {
+            STRING_delete(regManHandle->sasToken);
+        }
+
         free(regManHandle->hostname);
         free(regManHandle->iothubName);
         free(regManHandle->iothubSuffix);
@@ -1324,10 +1996,10 @@ IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_CreateDevice(IOTHUB_REGISTRY
                 }
                 /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_014: [ IoTHubRegistryManager_CreateDevice shall create an HTTP PUT request using the created JSON ] */
                 /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_015: [ IoTHubRegistryManager_CreateDevice shall create an HTTP PUT request using the following HTTP headers: authorization=sasToken,Request-Id=1001,Accept=application/json,Content-Type=application/json,charset=utf-8 ] */
-                /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_016: [ IoTHubRegistryManager_CreateDevice shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-                /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_017: [ IoTHubRegistryManager_CreateDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
+                /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_016: [ IoTHubRegistryManager_CreateDevice shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+                /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_017: [ IoTHubRegistryManager_CreateDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
                 /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_018: [ IoTHubRegistryManager_CreateDevice shall execute the HTTP PUT request by calling HTTPAPIEX_ExecuteRequest ] */
-                else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_CREATE, deviceCreateInfo->deviceId, deviceJsonBuffer, 0, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
+                else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_CREATE, deviceCreateInfo->deviceId, deviceJsonBuffer, 0, NULL, NULL, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
                 {
                     /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_019: [ If any of the HTTPAPI call fails IoTHubRegistryManager_CreateDevice shall fail and return IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR ] */
                     /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_099: [ If any of the call fails during the HTTP creation IoTHubRegistryManager_CreateDevice shall fail and return IOTHUB_REGISTRYMANAGER_ERROR ] */
@@ -1382,10 +2054,10 @@ IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetDevice(IOTHUB_REGISTRYMAN
         }
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_026: [ IoTHubRegistryManager_GetDevice shall create HTTP GET request URL using the given deviceId using the following format: url/devices/[deviceId]?api-version=2016-02-03  ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_027: [ IoTHubRegistryManager_GetDevice shall add the following headers to the created HTTP GET request: authorization=sasToken,Request-Id=1001,Accept=application/json,Content-Type=application/json,charset=utf-8 ] */
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_028: [ IoTHubRegistryManager_GetDevice shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_029: [ IoTHubRegistryManager_GetDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_028: [ IoTHubRegistryManager_GetDevice shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_029: [ IoTHubRegistryManager_GetDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_030: [ IoTHubRegistryManager_GetDevice shall execute the HTTP GET request by calling HTTPAPIEX_ExecuteRequest ] */
-        else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_GET, deviceId, NULL, 0, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
+        else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_GET, deviceId, NULL, 0, NULL, NULL, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
         {
             /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_031: [ If any of the HTTPAPI call fails IoTHubRegistryManager_GetDevice shall fail and return IOTHUB_REGISTRYMANAGER_ERROR ] */
             LogError("Failure sending HTTP request for create device");
@@ -1473,10 +2145,10 @@ IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_UpdateDevice(IOTHUB_REGISTRY
                 }
                 /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_043: [ IoTHubRegistryManager_UpdateDevice shall create an HTTP PUT request using the created JSON ] */
                 /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_044: [ IoTHubRegistryManager_UpdateDevice shall create an HTTP PUT request using the createdfollowing HTTP headers : authorization = sasToken, Request - Id = 1001, Accept = application / json, Content - Type = application / json, charset = utf - 8 ] */
-                /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_045: [ IoTHubRegistryManager_UpdateDevice shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-                /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_046: [ IoTHubRegistryManager_UpdateDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
+                /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_045: [ IoTHubRegistryManager_UpdateDevice shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+                /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_046: [ IoTHubRegistryManager_UpdateDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
                 /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_047: [ IoTHubRegistryManager_UpdateDevice shall execute the HTTP PUT request by calling HTTPAPIEX_ExecuteRequest ] */
-                else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_UPDATE, deviceUpdate->deviceId, deviceJsonBuffer, 0, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
+                else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_UPDATE, deviceUpdate->deviceId, deviceJsonBuffer, 0, NULL, NULL, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
                 {
                     /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_103: [ If any of the call fails during the HTTP creation IoTHubRegistryManager_UpdateDevice shall fail and return IOTHUB_REGISTRYMANAGER_ERROR ] */
                     /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_104: [ If any of the HTTPAPI call fails IoTHubRegistryManager_UpdateDevice shall fail and return IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR ] */
@@ -1513,12 +2185,12 @@ IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_DeleteDevice(IOTHUB_REGISTRY
     {
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_053: [ IoTHubRegistryManager_DeleteDevice shall create HTTP DELETE request URL using the given deviceId using the following format : url / devices / [deviceId] ? api - version  ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_054: [ IoTHubRegistryManager_DeleteDevice shall add the following headers to the created HTTP GET request : authorization = sasToken, Request - Id = 1001, Accept = application / json, Content - Type = application / json, charset = utf - 8 ] */
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_055: [ IoTHubRegistryManager_DeleteDevice shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_056: [ IoTHubRegistryManager_DeleteDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_055: [ IoTHubRegistryManager_DeleteDevice shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_056: [ IoTHubRegistryManager_DeleteDevice shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_057: [ IoTHubRegistryManager_DeleteDevice shall execute the HTTP DELETE request by calling HTTPAPIEX_ExecuteRequest ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_058: [ IoTHubRegistryManager_DeleteDevice shall verify the received HTTP status code and if it is greater than 300 then return IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_059: [ IoTHubRegistryManager_DeleteDevice shall verify the received HTTP status code and if it is less or equal than 300 then return IOTHUB_REGISTRYMANAGER_OK ] */
-        result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_DELETE, deviceId, NULL, 0, NULL);
+        result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_DELETE, deviceId, NULL, 0, NULL, NULL, NULL);
     }
     return result;
 }
@@ -1552,20 +2224,20 @@ IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetDeviceList(IOTHUB_REGISTR
         }
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_062: [ IoTHubRegistryManager_GetDeviceList shall create HTTP GET request for numberOfDevices using the follwoing format: url/devices/?top=[numberOfDevices]&api-version ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_063: [ IoTHubRegistryManager_GetDeviceList shall add the following headers to the created HTTP GET request: authorization=sasToken,Request-Id=1001,Accept=application/json,Content-Type=application/json,charset=utf-8 ] */
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_064: [ IoTHubRegistryManager_GetDeviceList shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_065: [ IoTHubRegistryManager_GetDeviceList shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_064: [ IoTHubRegistryManager_GetDeviceList shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_065: [ IoTHubRegistryManager_GetDeviceList shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_066: [ IoTHubRegistryManager_GetDeviceList shall execute the HTTP GET request by calling HTTPAPIEX_ExecuteRequest ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_067: [ IoTHubRegistryManager_GetDeviceList shall verify the received HTTP status code and if it is greater than 300 then return IOTHUB_REGISTRYMANAGER_ERROR ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_068: [ IoTHubRegistryManager_GetDeviceList shall verify the received HTTP status code and if it is less or equal than 300 then try to parse the response JSON to deviceList ] */
-        else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_GET_DEVICE_LIST, NULL, NULL, numberOfDevices, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
+        else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_GET_DEVICE_LIST, NULL, NULL, numberOfDevices, NULL, NULL, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
         {
             /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_115: [ If any of the HTTPAPI call fails IoTHubRegistryManager_GetDeviceList shall fail and return IOTHUB_REGISTRYMANAGER_ERROR ] */
             LogError("Failure sending HTTP request for get device list");
         }
         else if (result == IOTHUB_REGISTRYMANAGER_OK)
         {
-            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_069: [ IoTHubRegistryManager_GetDeviceList shall use the following parson APIs to parse the response JSON: json_parse_string, json_value_get_object, json_object_get_string, json_object_dotget_string  ] */
-            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [ If any of the parson API fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR ] */
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_069: [ IoTHubRegistryManager_GetDeviceList shall parse the response JSON array for the following properties of every device: deviceId, primaryKey, secondaryKey, generationId, eTag, connectionState, connectionStateUpdatedTime, status, statusReason, statusUpdatedTime, lastActivityTime, cloudToDeviceMessageCount, isManaged, configuration, deviceProperties, serviceProperties ] */
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_070: [ If the JSON parsing fails, IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_JSON_ERROR ] */
             /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_071: [ IoTHubRegistryManager_GetDeviceList shall populate the deviceList parameter with structures of type "IOTHUB_DEVICE" ] */
             /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_072: [ If populating the deviceList parameter fails IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_ERROR ] */
             /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_073: [ If populating the deviceList parameter successful IoTHubRegistryManager_GetDeviceList shall return IOTHUB_REGISTRYMANAGER_OK ] */
@@ -1581,6 +2253,208 @@ IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetDeviceList(IOTHUB_REGISTR
     return result;
 }
 
+IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetDeviceListPage(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, size_t pageSize, const char* continuationToken, SINGLYLINKEDLIST_HANDLE deviceList, char** nextContinuationToken)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_009: [ IoTHubRegistryManager_GetDeviceListPage shall verify the input parameters and if registryManagerHandle, deviceList or nextContinuationToken is NULL then return IOTHUB_REGISTRYMANAGER_INVALID_ARG ] */
+    if ((registryManagerHandle == NULL) || (deviceList == NULL) || (nextContinuationToken == NULL))
+    {
+        LogError("Input parameter cannot be NULL");
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_010: [ IoTHubRegistryManager_GetDeviceListPage shall verify if the pageSize input parameter is between 1 and 1000 and if it is not then return IOTHUB_REGISTRYMANAGER_INVALID_ARG ] */
+    else if ((pageSize == 0) || (pageSize > IOTHUB_DEVICES_MAX_REQUEST))
+    {
+        LogError("pageSize has to be between 1 and 1000");
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else
+    {
+        BUFFER_HANDLE queryBuffer = NULL;
+        BUFFER_HANDLE responseBuffer = NULL;
+        HTTP_HEADERS_HANDLE responseHeaders = NULL;
+        SINGLYLINKEDLIST_HANDLE pageList = NULL;
+
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_011: [ IoTHubRegistryManager_GetDeviceListPage shall set *nextContinuationToken to NULL before sending the request ] */
+        *nextContinuationToken = NULL;
+
+        if ((queryBuffer = BUFFER_create((const unsigned char*)DEVICE_QUERY_JSON, strlen(DEVICE_QUERY_JSON))) == NULL)
+        {
+            LogError("BUFFER_create failed for queryBuffer");
+            result = IOTHUB_REGISTRYMANAGER_ERROR;
+        }
+        else if ((responseBuffer = BUFFER_new()) == NULL)
+        {
+            LogError("BUFFER_new failed for responseBuffer");
+            result = IOTHUB_REGISTRYMANAGER_ERROR;
+        }
+        else if ((responseHeaders = HTTPHeaders_Alloc()) == NULL)
+        {
+            LogError("HTTPHeaders_Alloc failed for responseHeaders");
+            result = IOTHUB_REGISTRYMANAGER_ERROR;
+        }
+        else if ((pageList = singlylinkedlist_create()) == NULL)
+        {
+            LogError("singlylinkedlist_create failed for pageList");
+            result = IOTHUB_REGISTRYMANAGER_ERROR;
+        }
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_012: [ IoTHubRegistryManager_GetDeviceListPage shall send an HTTP POST request to url/devices/query?api-version=2016-11-14 with the body {"query":"SELECT * FROM devices"} over the connection and SAS token of the registry manager ] */
+        else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_GET_DEVICE_LIST_PAGE, NULL, queryBuffer, pageSize, continuationToken, responseHeaders, responseBuffer)) != IOTHUB_REGISTRYMANAGER_OK)
+        {
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_017: [ If any of the calls fails IoTHubRegistryManager_GetDeviceListPage shall return the error and leave deviceList unchanged ] */
+            LogError("Failure sending HTTP request for get device list page");
+        }
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_015: [ IoTHubRegistryManager_GetDeviceListPage shall parse the page into a list of its own and only then move the devices to the end of deviceList, so that the devices of earlier pages are kept if the page fails ] */
+        else if ((result = parseDeviceListJson(responseBuffer, pageList)) != IOTHUB_REGISTRYMANAGER_OK)
+        {
+            LogError("Failure parsing the device list page");
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_016: [ If the response carries an x-ms-continuation header IoTHubRegistryManager_GetDeviceListPage shall return a copy of it in *nextContinuationToken, which the caller shall free, otherwise *nextContinuationToken shall stay NULL as this was the last page ] */
+            const char* continuation = HTTPHeaders_FindHeaderValue(responseHeaders, HTTP_HEADER_KEY_CONTINUATION);
+            LIST_ITEM_HANDLE itemHandle = singlylinkedlist_get_head_item(pageList);
+
+            if ((continuation != NULL) && (mallocAndStrcpy_s(nextContinuationToken, continuation) != 0))
+            {
+                LogError("mallocAndStrcpy_s failed for the continuation token");
+                *nextContinuationToken = NULL;
+                result = IOTHUB_REGISTRYMANAGER_ERROR;
+            }
+
+            while (itemHandle != NULL)
+            {
+                IOTHUB_DEVICE* deviceInfo = (IOTHUB_DEVICE*)singlylinkedlist_item_get_value(itemHandle);
+                itemHandle = singlylinkedlist_get_next_item(itemHandle);
+
+                if ((result != IOTHUB_REGISTRYMANAGER_OK) || (singlylinkedlist_add(deviceList, deviceInfo) == NULL))
+                {
+                    if (result == IOTHUB_REGISTRYMANAGER_OK)
+                    {
+                        LogError("singlylinkedlist_add failed, the rest of the page is dropped");
+                        free(*nextContinuationToken);
+                        *nextContinuationToken = NULL;
+                        result = IOTHUB_REGISTRYMANAGER_ERROR;
+                    }
+                    freeDeviceStrings(deviceInfo);
+                    free(deviceInfo);
+                }
+            }
+        }
+
+        if (pageList != NULL)
+        {
+            singlylinkedlist_destroy(pageList);
+        }
+        if (responseHeaders != NULL)
+        {
+            HTTPHeaders_Free(responseHeaders);
+        }
+        if (responseBuffer != NULL)
+        {
+            BUFFER_delete(responseBuffer);
+        }
+        if (queryBuffer != NULL)
+        {
+            BUFFER_delete(queryBuffer);
+        }
+    }
+    return result;
+}
+
+IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_BulkOperation(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, IOTHUB_REGISTRY_BULK_OPERATION* operations, size_t operationCount)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    size_t i;
+
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_018: [ IoTHubRegistryManager_BulkOperation shall verify the input parameters and if registryManagerHandle or operations is NULL or operationCount is 0 then return IOTHUB_REGISTRYMANAGER_INVALID_ARG ] */
+    if ((registryManagerHandle == NULL) || (operations == NULL) || (operationCount == 0))
+    {
+        LogError("Input parameter cannot be NULL or empty");
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_019: [ If the deviceId of any operation is NULL or its importMode is not a valid IOTHUB_REGISTRY_BULK_IMPORT_MODE, IoTHubRegistryManager_BulkOperation shall return IOTHUB_REGISTRYMANAGER_INVALID_ARG without sending any request ] */
+        for (i = 0; i < operationCount; i++)
+        {
+            if ((operations[i].deviceId == NULL) || (bulkImportModeToString(operations[i].importMode) == NULL))
+            {
+                break;
+            }
+        }
+
+        if (i < operationCount)
+        {
+            LogError("Invalid operation at index %lu", (unsigned long)i);
+            result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+        }
+        else
+        {
+            size_t batchStart;
+
+            result = IOTHUB_REGISTRYMANAGER_OK;
+            for (batchStart = 0; (batchStart < operationCount) && (result == IOTHUB_REGISTRYMANAGER_OK); batchStart += IOTHUB_REGISTRY_BULK_OPERATION_MAX_COUNT)
+            {
+                size_t batchCount = operationCount - batchStart;
+                BUFFER_HANDLE bulkJsonBuffer;
+                BUFFER_HANDLE responseBuffer = NULL;
+
+                if (batchCount > IOTHUB_REGISTRY_BULK_OPERATION_MAX_COUNT)
+                {
+                    batchCount = IOTHUB_REGISTRY_BULK_OPERATION_MAX_COUNT;
+                }
+
+                /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_022: [ IoTHubRegistryManager_BulkOperation shall set the result of every operation of a processed batch to IOTHUB_REGISTRYMANAGER_OK unless the response reports an error for its device ] */
+                for (i = batchStart; i < batchStart + batchCount; i++)
+                {
+                    operations[i].result = IOTHUB_REGISTRYMANAGER_OK;
+                }
+
+                if ((bulkJsonBuffer = constructBulkOperationJson(&operations[batchStart], batchCount)) == NULL)
+                {
+                    LogError("Json creation failed for the bulk request");
+                    result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+                }
+                else if ((responseBuffer = BUFFER_new()) == NULL)
+                {
+                    LogError("BUFFER_new failed for responseBuffer");
+                    result = IOTHUB_REGISTRYMANAGER_ERROR;
+                }
+                else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_BULK_OPERATION, NULL, bulkJsonBuffer, 0, NULL, NULL, responseBuffer)) != IOTHUB_REGISTRYMANAGER_OK)
+                {
+                    LogError("Failure sending HTTP request for bulk operation");
+                }
+                else
+                {
+                    result = parseBulkOperationJson(responseBuffer, &operations[batchStart], batchCount);
+                }
+
+                if (result != IOTHUB_REGISTRYMANAGER_OK)
+                {
+                    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_026: [ If a batch fails, IoTHubRegistryManager_BulkOperation shall not send the remaining batches, set the result of the operations of the failed and remaining batches to the error and return it ] */
+                    for (i = batchStart; i < operationCount; i++)
+                    {
+                        operations[i].result = result;
+                    }
+                }
+
+                if (responseBuffer != NULL)
+                {
+                    BUFFER_delete(responseBuffer);
+                }
+                if (bulkJsonBuffer != NULL)
+                {
+                    BUFFER_delete(bulkJsonBuffer);
+                }
+            }
+            /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_027: [ If every batch was processed IoTHubRegistryManager_BulkOperation shall return IOTHUB_REGISTRYMANAGER_OK, the outcome of each device is in the result of its operation ] */
+        }
+    }
+    return result;
+}
+
 IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetStatistics(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, IOTHUB_REGISTRY_STATISTICS* registryStatistics)
 {
     IOTHUB_REGISTRYMANAGER_RESULT result;
@@ -1604,12 +2478,12 @@ IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetStatistics(IOTHUB_REGISTR
         }
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_075: [ IoTHubRegistryManager_GetStatistics shall create HTTP GET request for statistics using the following format: url/statistics/devices?api-version ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_076: [ IoTHubRegistryManager_GetStatistics shall add the following headers to the created HTTP GET request: authorization=sasToken,Request-Id=1001,Accept=application/json,Content-Type=application/json,charset=utf-8 ] */
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_077: [ IoTHubRegistryManager_GetStatistics shall create an HTTPAPIEX_SAS_HANDLE handle by calling HTTPAPIEX_SAS_Create ] */
-        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_078: [ IoTHubRegistryManager_GetStatistics shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create ] */
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_077: [ IoTHubRegistryManager_GetStatistics shall get the SAS token of the registry manager, creating it if it does not exist or is due for refresh ] */
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_078: [ IoTHubRegistryManager_GetStatistics shall create an HTTPAPIEX_HANDLE handle by calling HTTPAPIEX_Create if the registry manager does not have one yet ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_079: [ IoTHubRegistryManager_GetStatistics shall execute the HTTP GET request by calling HTTPAPIEX_ExecuteRequest ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_080: [ IoTHubRegistryManager_GetStatistics shall verify the received HTTP status code and if it is greater than 300 then return IOTHUB_REGISTRYMANAGER_ERROR ] */
         /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_081: [ IoTHubRegistryManager_GetStatistics shall verify the received HTTP status code and if it is less or equal than 300 then use the following parson APIs to parse the response JSON to registry statistics structure: json_parse_string, json_value_get_object, json_object_get_string, json_object_dotget_string ] */
-        else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_GET_STATISTICS, NULL, NULL, 0, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
+        else if ((result = sendHttpRequestCRUD(registryManagerHandle, IOTHUB_REQUEST_GET_STATISTICS, NULL, NULL, 0, NULL, NULL, responseBuffer)) == IOTHUB_REGISTRYMANAGER_ERROR)
         {
             /*Codes_SRS_IOTHUBREGISTRYMANAGER_12_116: [ If any of the HTTPAPI call fails IoTHubRegistryManager_GetStatistics shall fail and return IOTHUB_REGISTRYMANAGER_ERROR ] */
             LogError("Failure sending HTTP request for get registry statistics");
@@ -1629,3 +2503,13 @@ IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetStatistics(IOTHUB_REGISTR
     }
     return result;
 }
+
+void IoTHubRegistryManager_FreeDevice(IOTHUB_DEVICE* deviceInfo)
+{
+    /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_030: [ If deviceInfo is NULL, IoTHubRegistryManager_FreeDevice shall return ] */
+    if (deviceInfo != NULL)
+    {
+        /*Codes_SRS_IOTHUBREGISTRYMANAGER_02_031: [ IoTHubRegistryManager_FreeDevice shall free every string of deviceInfo and set it to NULL, but not deviceInfo itself ] */
+        freeDeviceStrings(deviceInfo);
+    }
+}
@@ -0,0 +1,240 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#include "iothub_message.h"
+#include "iothub_service_client_auth.h"
+#include "iothub_messaging_ll.h"
+
+/*
+ * Measures the cloud-to-device send throughput of IoTHubMessaging_LL against the hub named by the
+ * IOTHUB_CONNECTION_STRING environment variable, towards the device named by IOTHUB_PERF_DEVICE_ID
+ * (the device has to exist). Every run sends MESSAGE_COUNT messages over one open messaging handle
+ * and waits for all the send completions:
+ *  - the send window is varied from 1 (one message in flight, the pre-pipelining behavior) upwards
+ *  - each window is measured with and without the device destination cache
+ * When IOTHUB_CONNECTION_STRING is not set the benchmark prints a note and exits with 0.
+ */
+
+#define MESSAGE_COUNT 1000
+#define OPEN_TIMEOUT_MS 30000
+#define SEND_TIMEOUT_MS 120000
+#define DEFAULT_DEVICE_ID "iothub_msging_ll_perf"
+
+static const size_t sendWindows[] = { 1, 8, 32, 128 };
+
+typedef struct SEND_COUNTERS_TAG
+{
+    size_t completed;
+    size_t failed;
+} SEND_COUNTERS;
+
+static void OpenCompleteCallback(void* context)
+{
+    *(bool*)context = true;
+}
+
+static void SendCompleteCallback(void* context, IOTHUB_MESSAGING_RESULT messagingResult)
+{
+    SEND_COUNTERS* counters = (SEND_COUNTERS*)context;
+    counters->completed++;
+    if (messagingResult != IOTHUB_MESSAGING_OK)
+    {
+        counters->failed++;
+    }
+}
+
+static int Measure(IOTHUB_MESSAGING_HANDLE messagingHandle, TICK_COUNTER_HANDLE tickCounter, IOTHUB_MESSAGE_HANDLE message, const char* deviceId, size_t sendWindow, size_t cacheSize)
+{
+    int result;
+
+    if ((IoTHubMessaging_LL_SetOption(messagingHandle, OPTION_MESSAGING_SEND_WINDOW, &sendWindow) != IOTHUB_MESSAGING_OK) ||
+        (IoTHubMessaging_LL_SetOption(messagingHandle, OPTION_MESSAGING_DESTINATION_CACHE_SIZE, &cacheSize) != IOTHUB_MESSAGING_OK))
+    {
+        (void)printf("IoTHubMessaging_LL_SetOption failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        SEND_COUNTERS counters = { 0, 0 };
+        size_t sent = 0;
+        tickcounter_ms_t start;
+        tickcounter_ms_t now;
+        char name[64];
+
+        result = 0;
+        (void)tickcounter_get_current_ms(tickCounter, &start);
+        now = start;
+        while ((counters.completed < MESSAGE_COUNT) && (result == 0))
+        {
+            while (sent < MESSAGE_COUNT)
+            {
+                IOTHUB_MESSAGING_RESULT sendResult = IoTHubMessaging_LL_Send(messagingHandle, deviceId, message, SendCompleteCallback, &counters);
+                if (sendResult == IOTHUB_MESSAGING_BUSY)
+                {
+                    break;
+                }
+                else if (sendResult != IOTHUB_MESSAGING_OK)
+                {
+                    (void)printf("IoTHubMessaging_LL_Send failed\n");
+                    result = __LINE__;
+                    break;
+                }
+                sent++;
+            }
+
+            IoTHubMessaging_LL_DoWork(messagingHandle);
+            (void)tickcounter_get_current_ms(tickCounter, &now);
+            if ((now - start) > SEND_TIMEOUT_MS)
+            {
+                (void)printf("timed out after %lu of %d send completions\n", (unsigned long)counters.completed, MESSAGE_COUNT);
+                result = __LINE__;
+            }
+        }
+
+        (void)sprintf(name, "window %lu, %s", (unsigned long)sendWindow, (cacheSize == 0) ? "no destination cache" : "destination cache");
+        if (result != 0)
+        {
+            /*the failure has already been printed*/
+        }
+        else if (counters.failed != 0)
+        {
+            (void)printf("%-40s %lu of %d sends failed\n", name, (unsigned long)counters.failed, MESSAGE_COUNT);
+            result = __LINE__;
+        }
+        else
+        {
+            double elapsedMs = (double)(now - start);
+            (void)printf("%-40s %10.1f messages/s\n", name, (elapsedMs > 0) ? (MESSAGE_COUNT * 1000.0 / elapsedMs) : 0.0);
+        }
+    }
+    return result;
+}
+
+static int RunBenchmark(IOTHUB_MESSAGING_HANDLE messagingHandle, TICK_COUNTER_HANDLE tickCounter, const char* deviceId)
+{
+    int result;
+    bool isOpened = false;
+
+    if (IoTHubMessaging_LL_Open(messagingHandle, OpenCompleteCallback, &isOpened) != IOTHUB_MESSAGING_OK)
+    {
+        (void)printf("IoTHubMessaging_LL_Open failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        tickcounter_ms_t start;
+        tickcounter_ms_t now;
+
+        (void)tickcounter_get_current_ms(tickCounter, &start);
+        now = start;
+        while (!isOpened && ((now - start) < OPEN_TIMEOUT_MS))
+        {
+            IoTHubMessaging_LL_DoWork(messagingHandle);
+            ThreadAPI_Sleep(1);
+            (void)tickcounter_get_current_ms(tickCounter, &now);
+        }
+
+        if (!isOpened)
+        {
+            (void)printf("IoTHubMessaging_LL_Open did not complete\n");
+            result = __LINE__;
+        }
+        else
+        {
+            static const unsigned char payload[] = "iothub_msging_ll_perf";
+            IOTHUB_MESSAGE_HANDLE message;
+
+            if ((message = IoTHubMessage_CreateFromByteArray(payload, sizeof(payload) - 1)) == NULL)
+            {
+                (void)printf("IoTHubMessage_CreateFromByteArray failed\n");
+                result = __LINE__;
+            }
+            else
+            {
+                size_t i;
+
+                result = 0;
+                for (i = 0; (i < sizeof(sendWindows) / sizeof(sendWindows[0])) && (result == 0); i++)
+                {
+                    result = Measure(messagingHandle, tickCounter, message, deviceId, sendWindows[i], 0);
+                    if (result == 0)
+                    {
+                        result = Measure(messagingHandle, tickCounter, message, deviceId, sendWindows[i], 16);
+                    }
+                }
+                IoTHubMessage_Destroy(message);
+            }
+        }
+        IoTHubMessaging_LL_Close(messagingHandle);
+    }
+    return result;
+}
+
+int main(void)
+{
+    int result;
+    const char* connectionString = getenv("IOTHUB_CONNECTION_STRING");
+    const char* deviceId = getenv("IOTHUB_PERF_DEVICE_ID");
+
+    if (deviceId == NULL)
+    {
+        deviceId = DEFAULT_DEVICE_ID;
+    }
+
+    if (connectionString == NULL)
+    {
+        (void)printf("IOTHUB_CONNECTION_STRING is not set, skipping the messaging benchmark\n");
+        result = 0;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle;
+        IOTHUB_MESSAGING_HANDLE messagingHandle;
+        TICK_COUNTER_HANDLE tickCounter;
+
+        if ((tickCounter = tickcounter_create()) == NULL)
+        {
+            (void)printf("tickcounter_create failed\n");
+            result = __LINE__;
+        }
+        else
+        {
+            if ((serviceClientHandle = IoTHubServiceClientAuth_CreateFromConnectionString(connectionString)) == NULL)
+            {
+                (void)printf("IoTHubServiceClientAuth_CreateFromConnectionString failed\n");
+                result = __LINE__;
+            }
+            else
+            {
+                if ((messagingHandle = IoTHubMessaging_LL_Create(serviceClientHandle)) == NULL)
+                {
+                    (void)printf("IoTHubMessaging_LL_Create failed\n");
+                    result = __LINE__;
+                }
+                else
+                {
+                    result = RunBenchmark(messagingHandle, tickCounter, deviceId);
+                    IoTHubMessaging_LL_Destroy(messagingHandle);
+                }
+                IoTHubServiceClientAuth_Destroy(serviceClientHandle);
+            }
+            tickcounter_destroy(tickCounter);
+        }
+        platform_deinit();
+    }
+
+    return result;
+}
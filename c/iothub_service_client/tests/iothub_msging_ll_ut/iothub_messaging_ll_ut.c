@@ -46,12 +46,11 @@ MOCKABLE_FUNCTION(, const char*, json_object_get_string, const JSON_Object *, ob
 MOCKABLE_FUNCTION(, JSON_Object*, json_array_get_object, const JSON_Array*, array, size_t, index);
 MOCKABLE_FUNCTION(, JSON_Array*, json_value_get_array, const JSON_Value*, value);
 MOCKABLE_FUNCTION(, size_t, json_array_get_count, const JSON_Array*, array);
-MOCKABLE_FUNCTION(, JSON_Status, json_array_clear, JSON_Array*, array);
-MOCKABLE_FUNCTION(, JSON_Status, json_object_clear, JSON_Object*, object);
 MOCKABLE_FUNCTION(, void, json_value_free, JSON_Value *, value);
 MOCKABLE_FUNCTION(, void, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, void*, context);
 MOCKABLE_FUNCTION(, void, TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK, void*, context, IOTHUB_MESSAGING_RESULT, messagingResult);
 MOCKABLE_FUNCTION(, void, TEST_FUNC_IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK, void*, context, IOTHUB_SERVICE_FEEDBACK_BATCH*, feedbackBatch);
+MOCKABLE_FUNCTION(, void, TEST_FUNC_IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK, void*, context, const IOTHUB_SERVICE_FEEDBACK_RECORD*, feedbackRecords, size_t, feedbackRecordCount);
 #undef ENABLE_MOCKS
 
 static TEST_MUTEX_HANDLE g_testByTest;
@@ -85,9 +84,9 @@ static void my_gballoc_free(void* ptr)
 
 static int my_mallocAndStrcpy_s(char** destination, const char* source)
 {
-    char* p = (char*)malloc(2);
-    p[0] = source[0];
-    p[1] = '\0';
+    size_t length = strlen(source);
+    char* p = (char*)malloc(length + 1);
+    (void)memcpy(p, source, length + 1);
     *destination = p;
     return 0;
 }
@@ -226,11 +225,12 @@ static const void* my_list_item_get_value(LIST_ITEM_HANDLE item_handle)
     return result;
 }
 
+static const char* TEST_FEEDBACK_MESSAGE_BODY = "[{}]";
 static int my_message_get_body_amqp_data(MESSAGE_HANDLE message, size_t index, BINARY_DATA* binary_data)
 {
     (void)index, message;
-    binary_data->bytes = NULL;
-    binary_data->length = 1;
+    binary_data->bytes = (const unsigned char*)TEST_FEEDBACK_MESSAGE_BODY;
+    binary_data->length = strlen(TEST_FEEDBACK_MESSAGE_BODY);
     return 0;
 }
 
@@ -282,10 +282,12 @@ void my_messagereceiver_destroy(MESSAGE_RECEIVER_HANDLE message_receiver)
 }
 
 static ON_MESSAGE_SEND_COMPLETE onMessageSendCompleteCallback;
+static void* onMessageSendCompleteContext;
 static int my_messagesender_send(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context)
 {
-    (void)message, message_sender, callback_context;
+    (void)message, message_sender;
     onMessageSendCompleteCallback = on_message_send_complete;
+    onMessageSendCompleteContext = callback_context;
     return 0;
 }
 
@@ -358,13 +360,22 @@ typedef struct TEST_SASL_PLAIN_CONFIG_TAG
 typedef struct TEST_CALLBACK_TAG
 {
     IOTHUB_OPEN_COMPLETE_CALLBACK openCompleteCompleteCallback;
-    IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback;
     IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK feedbackMessageCallback;
+    IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK feedbackRecordsCallback;
     void* openUserContext;
-    void* sendUserContext;
     void* feedbackUserContext;
+    void* feedbackRecordsUserContext;
 } TEST_CALLBACK;
 
+typedef struct TEST_SEND_CALLBACK_DATA_TAG
+{
+    void* messagingHandle;
+    IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback;
+    void* sendUserContext;
+    struct TEST_SEND_CALLBACK_DATA_TAG* nextFree;
+    struct TEST_SEND_CALLBACK_DATA_TAG* nextAllocated;
+} TEST_SEND_CALLBACK_DATA;
+
 typedef struct TEST_IOTHUB_MESSAGING_TAG
 {
     int isOpened;
@@ -389,6 +400,14 @@ typedef struct TEST_IOTHUB_MESSAGING_TAG
     MESSAGE_RECEIVER_STATE message_receiver_state;
 
     TEST_CALLBACK* callback_data;
+
+    size_t sendWindow;
+    size_t messagesInFlight;
+    TEST_SEND_CALLBACK_DATA* freeSendCallbacks;
+    TEST_SEND_CALLBACK_DATA* allSendCallbacks;
+    PROPERTIES_HANDLE sendProperties;
+    void* destinationCache;
+    size_t destinationCacheSize;
 } TEST_IOTHUB_MESSAGING;
 
 static void* TEST_VOID_PTR = (void*)0x5454;
@@ -414,6 +433,7 @@ static PROPERTIES_HANDLE TEST_PROPERTIES_HANDLE = (PROPERTIES_HANDLE)0x5656;
 static MESSAGE_HANDLE TEST_MESSAGE_HANDLE = (MESSAGE_HANDLE)05757;
 static IOTHUB_OPEN_COMPLETE_CALLBACK TEST_IOTHUB_OPEN_COMPLETE_CALLBACK;
 static IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK TEST_IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK = (IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK)0x6060;
+static IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK TEST_IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK = (IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK)0x6262;
 static MESSAGE_SENDER_STATE TEST_MESSAGE_SENDER_STATE = (MESSAGE_SENDER_STATE)0x6161;
 static IOTHUB_MESSAGING_RESULT TEST_IOTHUB_MESSAGING_RESULT = (IOTHUB_MESSAGING_RESULT)0x6767;
 static JSON_Value* TEST_JSON_VALUE = (JSON_Value*)0x5050;
@@ -650,10 +670,18 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         TEST_IOTHUB_MESSAGING_DATA.keyName = TEST_SHAREDACCESSKEYNAME;
         TEST_IOTHUB_MESSAGING_DATA.sharedAccessKey = TEST_SHAREDACCESSKEY;
         TEST_IOTHUB_MESSAGING_DATA.isOpened = false;
+        TEST_IOTHUB_MESSAGING_DATA.sendWindow = 0;
+        TEST_IOTHUB_MESSAGING_DATA.messagesInFlight = 0;
+        TEST_IOTHUB_MESSAGING_DATA.freeSendCallbacks = NULL;
+        TEST_IOTHUB_MESSAGING_DATA.allSendCallbacks = NULL;
+        TEST_IOTHUB_MESSAGING_DATA.sendProperties = NULL;
+        TEST_IOTHUB_MESSAGING_DATA.destinationCache = NULL;
+        TEST_IOTHUB_MESSAGING_DATA.destinationCacheSize = 0;
 
         onMessageSenderStateChangedCallback = NULL;
         onMessageReceiverStateChangedCallback = NULL;
         onMessageSendCompleteCallback = NULL;
+        onMessageSendCompleteContext = NULL;
         onMessageReceivedCallback = NULL;
         messagereceiver_create_return = NULL;
         messagesender_create_return = NULL;
@@ -663,6 +691,14 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
 
     TEST_FUNCTION_CLEANUP(TestMethodCleanup)
     {
+        /*the Send tests run on TEST_IOTHUB_MESSAGING_DATA, which is never given to IoTHubMessaging_LL_Destroy*/
+        while (TEST_IOTHUB_MESSAGING_DATA.allSendCallbacks != NULL)
+        {
+            TEST_SEND_CALLBACK_DATA* next = TEST_IOTHUB_MESSAGING_DATA.allSendCallbacks->nextAllocated;
+            free(TEST_IOTHUB_MESSAGING_DATA.allSendCallbacks);
+            TEST_IOTHUB_MESSAGING_DATA.allSendCallbacks = next;
+        }
+
         TEST_MUTEX_RELEASE(g_testByTest);
     }
 
@@ -1448,9 +1484,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
     /*Tests_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_036: [ IoTHubMessaging_LL_SendMessage shall create a uAMQP message by calling message_create ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_037: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message body to the given message content by calling message_add_body_amqp_data ] */
-    /*Tests_SRS_IOTHUBMESSAGING_12_038: [ IoTHubMessaging_LL_SendMessage shall set the uAMQP message properties to the given message properties by calling message_set_properties ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_039: [ IoTHubMessaging_LL_SendMessage shall call uAMQP messagesender_send with the created message with IoTHubMessaging_LL_SendMessageComplete callback by which IoTHubMessaging is notified of completition of send ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_041: [ If all uAMQP call return 0 then IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_OK  ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_005: [ IoTHubMessaging_LL_SendMessage shall keep sendCompleteCallback and userContextCallback per message, in a context recycled after the send completes ] */
     TEST_FUNCTION(IoTHubMessaging_LL_Send_happy_path)
     {
         ///arrange
@@ -1458,9 +1494,10 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(amqpvalue_create_string(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(properties_create());
         STRICT_EXPECTED_CALL(properties_set_to(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
@@ -1470,28 +1507,149 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(message_create());
         STRICT_EXPECTED_CALL(message_add_body_amqp_data(IGNORED_PTR_ARG, TEST_BINARY_DATA_INST))
             .IgnoreAllArguments();
-
-
         STRICT_EXPECTED_CALL(message_set_properties(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(messagesender_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
-        STRICT_EXPECTED_CALL(properties_destroy(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
         STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_CONST_CHAR_PTR, TEST_IOTHUB_MESSAGE_HANDLE, TEST_IOTHUB_SEND_COMPLETE_CALLBACK, TEST_VOID_PTR);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 1, (int)TEST_IOTHUB_MESSAGING_DATA.messagesInFlight);
+        ASSERT_IS_TRUE(TEST_IOTHUB_SEND_COMPLETE_CALLBACK == ((TEST_SEND_CALLBACK_DATA*)onMessageSendCompleteContext)->sendCompleteCallback);
+        ASSERT_ARE_EQUAL(void_ptr, TEST_VOID_PTR, ((TEST_SEND_CALLBACK_DATA*)onMessageSendCompleteContext)->sendUserContext);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_004: [ IoTHubMessaging_LL_SendMessage shall create the uAMQP properties once and reuse them for every subsequent message ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_Send_reuses_properties)
+    {
+        ///arrange
+        TEST_IOTHUB_MESSAGING_DATA.isOpened = true;
+        (void)IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_CONST_CHAR_PTR, TEST_IOTHUB_MESSAGE_HANDLE, TEST_IOTHUB_SEND_COMPLETE_CALLBACK, TEST_VOID_PTR);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(amqpvalue_create_string(IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(properties_set_to(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+
+        STRICT_EXPECTED_CALL(message_create());
+        STRICT_EXPECTED_CALL(message_add_body_amqp_data(IGNORED_PTR_ARG, TEST_BINARY_DATA_INST))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(message_set_properties(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(messagesender_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+
+        STRICT_EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
 
         ///act
         IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_CONST_CHAR_PTR, TEST_IOTHUB_MESSAGE_HANDLE, TEST_IOTHUB_SEND_COMPLETE_CALLBACK, TEST_VOID_PTR);
-    
+
         ///assert
         ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 2, (int)TEST_IOTHUB_MESSAGING_DATA.messagesInFlight);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_003: [ If the destination cache is enabled IoTHubMessaging_LL_SendMessage shall reuse the destination of a previous send to the same deviceId ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_Send_reuses_cached_destination)
+    {
+        ///arrange
+        size_t cacheSize = 4;
+        size_t noCache = 0;
+        TEST_IOTHUB_MESSAGING_DATA.isOpened = true;
+        (void)IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, OPTION_MESSAGING_DESTINATION_CACHE_SIZE, &cacheSize);
+        (void)IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, TEST_IOTHUB_SEND_COMPLETE_CALLBACK, TEST_VOID_PTR);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(properties_set_to(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+
+        STRICT_EXPECTED_CALL(message_create());
+        STRICT_EXPECTED_CALL(message_add_body_amqp_data(IGNORED_PTR_ARG, TEST_BINARY_DATA_INST))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(message_set_properties(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(messagesender_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+
+        STRICT_EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, TEST_IOTHUB_SEND_COMPLETE_CALLBACK, TEST_VOID_PTR);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        (void)IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, OPTION_MESSAGING_DESTINATION_CACHE_SIZE, &noCache);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_002: [ If a send window has been set and that many messages are awaiting their send completion IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_BUSY ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_Send_returns_IOTHUB_MESSAGING_BUSY_when_the_send_window_is_full)
+    {
+        ///arrange
+        size_t sendWindow = 1;
+        TEST_IOTHUB_MESSAGING_DATA.isOpened = true;
+        (void)IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, OPTION_MESSAGING_SEND_WINDOW, &sendWindow);
+        (void)IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_CONST_CHAR_PTR, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL);
+        umock_c_reset_all_calls();
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_CONST_CHAR_PTR, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_BUSY, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_013: [ IoTHubMessaging_LL_SendMessageComplete shall release the message's slot in the send window before calling the user callback ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_Send_reuses_the_send_window_slot_after_completion)
+    {
+        ///arrange
+        size_t sendWindow = 1;
+        TEST_IOTHUB_MESSAGING_DATA.isOpened = true;
+        (void)IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, OPTION_MESSAGING_SEND_WINDOW, &sendWindow);
+        (void)IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_CONST_CHAR_PTR, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL);
+        void* firstSendContext = onMessageSendCompleteContext;
+        onMessageSendCompleteCallback(onMessageSendCompleteContext, MESSAGE_SEND_OK);
+        umock_c_reset_all_calls();
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_CONST_CHAR_PTR, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
+        ASSERT_ARE_EQUAL(void_ptr, firstSendContext, onMessageSendCompleteContext);
+        ASSERT_ARE_EQUAL(int, 1, (int)TEST_IOTHUB_MESSAGING_DATA.messagesInFlight);
     }
 
     /*Tests_SRS_IOTHUBMESSAGING_12_040: [ If any of the uAMQP call fails IoTHubMessaging_LL_SendMessage shall return IOTHUB_MESSAGING_ERROR ] */
@@ -1501,20 +1659,21 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         int umockc_result = umock_c_negative_tests_init();
         ASSERT_ARE_EQUAL(int, 0, umockc_result);
 
-        size_t doNotFailCalls[] = 
-        { 
-            9,   /*amqpvalue_destroy*/
-            10,  /*properties_destroy*/
-            11   /*gballoc_free*/
+        size_t doNotFailCalls[] =
+        {
+            2,   /*gballoc_free*/
+            11,  /*message_destroy*/
+            12   /*amqpvalue_destroy*/
         };
 
         TEST_IOTHUB_MESSAGING_DATA.isOpened = true;
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(amqpvalue_create_string(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(properties_create());
         STRICT_EXPECTED_CALL(properties_set_to(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
@@ -1524,19 +1683,17 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(message_create());
         STRICT_EXPECTED_CALL(message_add_body_amqp_data(IGNORED_PTR_ARG, TEST_BINARY_DATA_INST))
             .IgnoreAllArguments();
-
-
         STRICT_EXPECTED_CALL(message_set_properties(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(messagesender_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
-        STRICT_EXPECTED_CALL(properties_destroy(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
         STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
 
         umock_c_negative_tests_snapshot();
 
@@ -1557,16 +1714,115 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
             {
                 umock_c_negative_tests_fail_call(i);
 
+                /*every iteration has to go through properties_create and the send callback allocation again*/
+                TEST_IOTHUB_MESSAGING_DATA.sendProperties = NULL;
+                TEST_IOTHUB_MESSAGING_DATA.freeSendCallbacks = NULL;
+
                 IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_CONST_CHAR_PTR, TEST_IOTHUB_MESSAGE_HANDLE, TEST_IOTHUB_SEND_COMPLETE_CALLBACK, TEST_VOID_PTR);
 
                 ///assert
                 ASSERT_ARE_NOT_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_OK, result);
+                ASSERT_ARE_EQUAL(int, 0, (int)TEST_IOTHUB_MESSAGING_DATA.messagesInFlight);
             }
-            
+
         }
         umock_c_negative_tests_deinit();
     }
 
+    /*Tests_SRS_IOTHUBMESSAGING_02_008: [ If messagingHandle, optionName or value is NULL IoTHubMessaging_LL_SetOption shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetOption_with_NULL_messagingHandle_fails)
+    {
+        ///arrange
+        size_t sendWindow = 1;
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetOption(NULL, OPTION_MESSAGING_SEND_WINDOW, &sendWindow);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_INVALID_ARG, result);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_008: [ If messagingHandle, optionName or value is NULL IoTHubMessaging_LL_SetOption shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetOption_with_NULL_optionName_fails)
+    {
+        ///arrange
+        size_t sendWindow = 1;
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, NULL, &sendWindow);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_INVALID_ARG, result);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_008: [ If messagingHandle, optionName or value is NULL IoTHubMessaging_LL_SetOption shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetOption_with_NULL_value_fails)
+    {
+        ///arrange
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, OPTION_MESSAGING_SEND_WINDOW, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_INVALID_ARG, result);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_009: [ If optionName is OPTION_MESSAGING_SEND_WINDOW IoTHubMessaging_LL_SetOption shall set the send window to *(const size_t*)value and return IOTHUB_MESSAGING_OK ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetOption_send_window_succeeds)
+    {
+        ///arrange
+        size_t sendWindow = 16;
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, OPTION_MESSAGING_SEND_WINDOW, &sendWindow);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_OK, result);
+        ASSERT_ARE_EQUAL(int, 16, (int)TEST_IOTHUB_MESSAGING_DATA.sendWindow);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_010: [ If optionName is OPTION_MESSAGING_DESTINATION_CACHE_SIZE IoTHubMessaging_LL_SetOption shall drop the cached destinations, set the cache size to *(const size_t*)value and return IOTHUB_MESSAGING_OK ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetOption_destination_cache_size_drops_the_cached_destinations)
+    {
+        ///arrange
+        size_t cacheSize = 4;
+        size_t newCacheSize = 8;
+        TEST_IOTHUB_MESSAGING_DATA.isOpened = true;
+        (void)IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, OPTION_MESSAGING_DESTINATION_CACHE_SIZE, &cacheSize);
+        (void)IoTHubMessaging_LL_Send(TEST_IOTHUB_MESSAGING_HANDLE, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, OPTION_MESSAGING_DESTINATION_CACHE_SIZE, &newCacheSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_OK, result);
+        ASSERT_ARE_EQUAL(int, 8, (int)TEST_IOTHUB_MESSAGING_DATA.destinationCacheSize);
+        ASSERT_IS_NULL(TEST_IOTHUB_MESSAGING_DATA.destinationCache);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_011: [ If optionName is not a known option IoTHubMessaging_LL_SetOption shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetOption_with_unknown_option_fails)
+    {
+        ///arrange
+        size_t value = 1;
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetOption(TEST_IOTHUB_MESSAGING_HANDLE, "unknown_option", &value);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_INVALID_ARG, result);
+    }
+
     /*Tests_SRS_IOTHUBMESSAGING_12_042: [ IoTHubMessaging_LL_SetCallbacks shall verify the messagingHandle input parameter and if it is NULL then return NULL ] */
     TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackMessageCallback_return_IOTHUB_MESSAGING_INVALID_ARG_if_input_parameter_messagingHandle_is_NULL)
     {
@@ -1594,6 +1850,35 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_OK, result);
     }
 
+    /*Tests_SRS_IOTHUBMESSAGING_02_006: [ If messagingHandle is NULL IoTHubMessaging_LL_SetFeedbackRecordsCallback shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordsCallback_return_IOTHUB_MESSAGING_INVALID_ARG_if_input_parameter_messagingHandle_is_NULL)
+    {
+        ///arrange
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordsCallback(NULL, TEST_IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK, TEST_VOID_PTR);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_INVALID_ARG, result);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_007: [ IoTHubMessaging_LL_SetFeedbackRecordsCallback shall save feedbackRecordsReceivedCallback and userContextCallback and return IOTHUB_MESSAGING_OK ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordsCallback_happy_path)
+    {
+        ///arrange
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordsCallback(TEST_IOTHUB_MESSAGING_HANDLE, TEST_IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK, TEST_VOID_PTR);
+
+        ///assert
+        ASSERT_IS_TRUE(TEST_IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK == TEST_IOTHUB_MESSAGING_DATA.callback_data->feedbackRecordsCallback);
+        ASSERT_ARE_EQUAL(void_ptr, TEST_IOTHUB_MESSAGING_DATA.callback_data->feedbackRecordsUserContext, TEST_VOID_PTR);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_OK, result);
+
+        ///cleanup
+        (void)IoTHubMessaging_LL_SetFeedbackRecordsCallback(TEST_IOTHUB_MESSAGING_HANDLE, NULL, NULL);
+    }
+
     /*Tests_SRS_IOTHUBMESSAGING_12_045: [ IoTHubMessaging_LL_DoWork shall verify if uAMQP transport has been initialized and if it is not then return immediately ] */
     TEST_FUNCTION(IoTHubMessaging_LL_DoWork_return_if_input_parameter_messagingHandle_is_NULL)
     {
@@ -1800,14 +2085,14 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
     }
 
     /*Tests_SRS_IOTHUBMESSAGING_12_056: [ If context is NULL IoTHubMessaging_LL_SendMessageComplete shall return ] */
-    /*Tests_SRS_IOTHUBMESSAGING_12_055: [ If context is not NULL and IoTHubMessaging_LL_SendMessageComplete shall call user callback with user context and messaging result ] */
     TEST_FUNCTION(IoTHubMessaging_LL_SendMessageComplete_context_is_null)
     {
         ///arrange
         IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
         (void)IoTHubMessaging_LL_Open(iothub_messaging_handle, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, (void*)1);
+        ((TEST_IOTHUB_MESSAGING*)iothub_messaging_handle)->isOpened = true;
         (void)IoTHubMessaging_LL_Send(iothub_messaging_handle, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK, (void*)1);
-        
+
         umock_c_reset_all_calls();
 
         MESSAGE_SEND_RESULT send_result = MESSAGE_SEND_OK;
@@ -1823,52 +2108,103 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
     }
 
-    /*Tests_SRS_IOTHUBMESSAGING_12_056: [ If context is NULL IoTHubMessaging_LL_SendMessageComplete shall return ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_055: [ If context is not NULL and IoTHubMessaging_LL_SendMessageComplete shall call user callback with user context and messaging result ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_013: [ IoTHubMessaging_LL_SendMessageComplete shall release the message's slot in the send window before calling the user callback ] */
     TEST_FUNCTION(IoTHubMessaging_LL_SendMessageComplete_sendCompleteCallback_null)
     {
         ///arrange
         IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
         (void)IoTHubMessaging_LL_Open(iothub_messaging_handle, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, (void*)1);
-        (void)IoTHubMessaging_LL_Send(iothub_messaging_handle, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK, (void*)1);
+        ((TEST_IOTHUB_MESSAGING*)iothub_messaging_handle)->isOpened = true;
+        (void)IoTHubMessaging_LL_Send(iothub_messaging_handle, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL);
 
         umock_c_reset_all_calls();
 
         MESSAGE_SEND_RESULT send_result = MESSAGE_SEND_OK;
 
-        TEST_IOTHUB_MESSAGING* test_handle = (TEST_IOTHUB_MESSAGING*)iothub_messaging_handle;
-        test_handle->isOpened = true;
-        test_handle->callback_data->sendCompleteCallback = NULL;
-
         ///act
-        onMessageSendCompleteCallback((void*)test_handle, send_result);
+        onMessageSendCompleteCallback(onMessageSendCompleteContext, send_result);
 
         ///assert
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, (int)((TEST_IOTHUB_MESSAGING*)iothub_messaging_handle)->messagesInFlight);
 
         ///cleanup
         IoTHubMessaging_LL_Close(iothub_messaging_handle);
         IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
     }
 
-    /*Tests_SRS_IOTHUBMESSAGING_12_056: [ If context is NULL IoTHubMessaging_LL_SendMessageComplete shall return ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_055: [ If context is not NULL and IoTHubMessaging_LL_SendMessageComplete shall call user callback with user context and messaging result ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_012: [ IoTHubMessaging_LL_SendMessageComplete shall call the callback given to the IoTHubMessaging_LL_Send call that produced the message, with IOTHUB_MESSAGING_OK if send_result is MESSAGE_SEND_OK and IOTHUB_MESSAGING_ERROR otherwise ] */
     TEST_FUNCTION(IoTHubMessaging_LL_SendMessageComplete_call_to_user_callback)
     {
         ///arrange
         IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
         (void)IoTHubMessaging_LL_Open(iothub_messaging_handle, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, (void*)1);
+        ((TEST_IOTHUB_MESSAGING*)iothub_messaging_handle)->isOpened = true;
         (void)IoTHubMessaging_LL_Send(iothub_messaging_handle, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK, (void*)1);
 
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK(IGNORED_PTR_ARG, TEST_IOTHUB_MESSAGING_RESULT))
-            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK((void*)1, IOTHUB_MESSAGING_OK));
 
         MESSAGE_SEND_RESULT send_result = MESSAGE_SEND_OK;
 
         ///act
-        onMessageSendCompleteCallback((void*)iothub_messaging_handle, send_result);
+        onMessageSendCompleteCallback(onMessageSendCompleteContext, send_result);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubMessaging_LL_Close(iothub_messaging_handle);
+        IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_012: [ IoTHubMessaging_LL_SendMessageComplete shall call the callback given to the IoTHubMessaging_LL_Send call that produced the message, with IOTHUB_MESSAGING_OK if send_result is MESSAGE_SEND_OK and IOTHUB_MESSAGING_ERROR otherwise ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SendMessageComplete_send_error_calls_user_callback_with_IOTHUB_MESSAGING_ERROR)
+    {
+        ///arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+        (void)IoTHubMessaging_LL_Open(iothub_messaging_handle, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, (void*)1);
+        ((TEST_IOTHUB_MESSAGING*)iothub_messaging_handle)->isOpened = true;
+        (void)IoTHubMessaging_LL_Send(iothub_messaging_handle, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK, (void*)1);
+
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK((void*)1, IOTHUB_MESSAGING_ERROR));
+
+        ///act
+        onMessageSendCompleteCallback(onMessageSendCompleteContext, MESSAGE_SEND_ERROR);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubMessaging_LL_Close(iothub_messaging_handle);
+        IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_012: [ IoTHubMessaging_LL_SendMessageComplete shall call the callback given to the IoTHubMessaging_LL_Send call that produced the message, with IOTHUB_MESSAGING_OK if send_result is MESSAGE_SEND_OK and IOTHUB_MESSAGING_ERROR otherwise ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SendMessageComplete_pipelined_sends_call_their_own_user_callback)
+    {
+        ///arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+        (void)IoTHubMessaging_LL_Open(iothub_messaging_handle, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, (void*)1);
+        ((TEST_IOTHUB_MESSAGING*)iothub_messaging_handle)->isOpened = true;
+        (void)IoTHubMessaging_LL_Send(iothub_messaging_handle, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK, (void*)1);
+        void* firstSendContext = onMessageSendCompleteContext;
+        (void)IoTHubMessaging_LL_Send(iothub_messaging_handle, TEST_DEVCIEID, TEST_IOTHUB_MESSAGE_HANDLE, TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK, (void*)2);
+        void* secondSendContext = onMessageSendCompleteContext;
+
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK((void*)1, IOTHUB_MESSAGING_OK));
+        STRICT_EXPECTED_CALL(TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK((void*)2, IOTHUB_MESSAGING_OK));
+
+        ///act
+        onMessageSendCompleteCallback(firstSendContext, MESSAGE_SEND_OK);
+        onMessageSendCompleteCallback(secondSendContext, MESSAGE_SEND_OK);
 
         ///assert
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -1907,6 +2243,8 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
     /*Tests_SRS_IOTHUBMESSAGING_12_060: [ IoTHubMessaging_LL_FeedbackMessageReceived shall use the following parson APIs to parse the response string: json_parse_string, json_value_get_object, json_object_get_string, json_object_dotget_string  ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_062: [ If context is not NULL IoTHubMessaging_LL_FeedbackMessageReceived shall call IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK with the received IOTHUB_SERVICE_FEEDBACK_BATCH ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_078: [** IoTHubMessaging_LL_FeedbackMessageReceived shall do clean up before exits ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_014: [ IoTHubMessaging_LL_FeedbackMessageReceived shall copy the message body to a '\0' terminated buffer before parsing it ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_015: [ IoTHubMessaging_LL_FeedbackMessageReceived shall store all the records of the batch in one array allocation ] */
     TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_happy_path_feedback_success)
     {
         ///arrange
@@ -1921,6 +2259,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(message_get_body_amqp_data(IGNORED_PTR_ARG, IGNORED_NUM_ARG, &TEST_BINARY_DATA_INST))
             .IgnoreAllArguments();
 
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
         STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
@@ -1933,17 +2274,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_create());
-
         STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0))
             .SetReturn(TEST_JSON_OBJECT);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_ID))
             .SetReturn("deviceId");
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID))
@@ -1955,23 +2288,12 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID))
             .SetReturn("originalMessageId");
 
+        STRICT_EXPECTED_CALL(singlylinkedlist_create());
 
         STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
-        
-        STRICT_EXPECTED_CALL(messaging_delivery_accepted());
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
 
-        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-        
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-        
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(messaging_delivery_accepted());
 
         STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
@@ -1979,13 +2301,12 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(json_object_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(json_value_free(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
         TEST_IOTHUB_MESSAGING* test_handle = (TEST_IOTHUB_MESSAGING*)iothub_messaging_handle;
         test_handle->callback_data->feedbackMessageCallback = on_feedback_message_received;
 
@@ -2006,6 +2327,8 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
     /*Tests_SRS_IOTHUBMESSAGING_12_060: [ IoTHubMessaging_LL_FeedbackMessageReceived shall use the following parson APIs to parse the response string: json_parse_string, json_value_get_object, json_object_get_string, json_object_dotget_string  ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_062: [ If context is not NULL IoTHubMessaging_LL_FeedbackMessageReceived shall call IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK with the received IOTHUB_SERVICE_FEEDBACK_BATCH ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_078: [** IoTHubMessaging_LL_FeedbackMessageReceived shall do clean up before exits ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_014: [ IoTHubMessaging_LL_FeedbackMessageReceived shall copy the message body to a '\0' terminated buffer before parsing it ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_015: [ IoTHubMessaging_LL_FeedbackMessageReceived shall store all the records of the batch in one array allocation ] */
     TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_happy_path_feedback_expired)
     {
         ///arrange
@@ -2020,6 +2343,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(message_get_body_amqp_data(IGNORED_PTR_ARG, IGNORED_NUM_ARG, &TEST_BINARY_DATA_INST))
             .IgnoreAllArguments();
 
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
         STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
@@ -2032,17 +2358,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_create());
-
         STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0))
             .SetReturn(TEST_JSON_OBJECT);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_ID))
             .SetReturn("deviceId");
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID))
@@ -2054,37 +2372,25 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID))
             .SetReturn("originalMessageId");
 
+        STRICT_EXPECTED_CALL(singlylinkedlist_create());
 
         STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(messaging_delivery_accepted());
 
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(json_object_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(json_value_free(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
         TEST_IOTHUB_MESSAGING* test_handle = (TEST_IOTHUB_MESSAGING*)iothub_messaging_handle;
         test_handle->callback_data->feedbackMessageCallback = on_feedback_message_received;
 
@@ -2105,6 +2411,8 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
     /*Tests_SRS_IOTHUBMESSAGING_12_060: [ IoTHubMessaging_LL_FeedbackMessageReceived shall use the following parson APIs to parse the response string: json_parse_string, json_value_get_object, json_object_get_string, json_object_dotget_string  ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_062: [ If context is not NULL IoTHubMessaging_LL_FeedbackMessageReceived shall call IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK with the received IOTHUB_SERVICE_FEEDBACK_BATCH ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_078: [** IoTHubMessaging_LL_FeedbackMessageReceived shall do clean up before exits ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_014: [ IoTHubMessaging_LL_FeedbackMessageReceived shall copy the message body to a '\0' terminated buffer before parsing it ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_015: [ IoTHubMessaging_LL_FeedbackMessageReceived shall store all the records of the batch in one array allocation ] */
     TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_happy_path_feedback_deliverycountexceeded)
     {
         ///arrange
@@ -2119,6 +2427,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(message_get_body_amqp_data(IGNORED_PTR_ARG, IGNORED_NUM_ARG, &TEST_BINARY_DATA_INST))
             .IgnoreAllArguments();
 
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
         STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
@@ -2131,17 +2442,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_create());
-
         STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0))
             .SetReturn(TEST_JSON_OBJECT);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_ID))
             .SetReturn("deviceId");
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID))
@@ -2153,36 +2456,25 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID))
             .SetReturn("originalMessageId");
 
+        STRICT_EXPECTED_CALL(singlylinkedlist_create());
+
         STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(messaging_delivery_accepted());
 
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(json_object_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(json_value_free(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
         TEST_IOTHUB_MESSAGING* test_handle = (TEST_IOTHUB_MESSAGING*)iothub_messaging_handle;
         test_handle->callback_data->feedbackMessageCallback = on_feedback_message_received;
 
@@ -2203,6 +2495,8 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
     /*Tests_SRS_IOTHUBMESSAGING_12_060: [ IoTHubMessaging_LL_FeedbackMessageReceived shall use the following parson APIs to parse the response string: json_parse_string, json_value_get_object, json_object_get_string, json_object_dotget_string  ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_062: [ If context is not NULL IoTHubMessaging_LL_FeedbackMessageReceived shall call IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK with the received IOTHUB_SERVICE_FEEDBACK_BATCH ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_078: [** IoTHubMessaging_LL_FeedbackMessageReceived shall do clean up before exits ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_014: [ IoTHubMessaging_LL_FeedbackMessageReceived shall copy the message body to a '\0' terminated buffer before parsing it ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_015: [ IoTHubMessaging_LL_FeedbackMessageReceived shall store all the records of the batch in one array allocation ] */
     TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_happy_path_feedback_rejected)
     {
         ///arrange
@@ -2217,6 +2511,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(message_get_body_amqp_data(IGNORED_PTR_ARG, IGNORED_NUM_ARG, &TEST_BINARY_DATA_INST))
             .IgnoreAllArguments();
 
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
         STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
@@ -2229,17 +2526,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_create());
-
         STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0))
             .SetReturn(TEST_JSON_OBJECT);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_ID))
             .SetReturn("deviceId");
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID))
@@ -2251,37 +2540,25 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID))
             .SetReturn("originalMessageId");
 
+        STRICT_EXPECTED_CALL(singlylinkedlist_create());
 
         STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(messaging_delivery_accepted());
 
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(json_object_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(json_value_free(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
         TEST_IOTHUB_MESSAGING* test_handle = (TEST_IOTHUB_MESSAGING*)iothub_messaging_handle;
         test_handle->callback_data->feedbackMessageCallback = on_feedback_message_received;
 
@@ -2302,6 +2579,8 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
     /*Tests_SRS_IOTHUBMESSAGING_12_060: [ IoTHubMessaging_LL_FeedbackMessageReceived shall use the following parson APIs to parse the response string: json_parse_string, json_value_get_object, json_object_get_string, json_object_dotget_string  ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_062: [ If context is not NULL IoTHubMessaging_LL_FeedbackMessageReceived shall call IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK with the received IOTHUB_SERVICE_FEEDBACK_BATCH ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_078: [** IoTHubMessaging_LL_FeedbackMessageReceived shall do clean up before exits ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_014: [ IoTHubMessaging_LL_FeedbackMessageReceived shall copy the message body to a '\0' terminated buffer before parsing it ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_015: [ IoTHubMessaging_LL_FeedbackMessageReceived shall store all the records of the batch in one array allocation ] */
     TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_happy_path_feedback_unknown)
     {
         ///arrange
@@ -2316,6 +2595,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(message_get_body_amqp_data(IGNORED_PTR_ARG, IGNORED_NUM_ARG, &TEST_BINARY_DATA_INST))
             .IgnoreAllArguments();
 
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
         STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
@@ -2328,17 +2610,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_create());
-
         STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0))
             .SetReturn(TEST_JSON_OBJECT);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_ID))
             .SetReturn("deviceId");
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID))
@@ -2350,37 +2624,25 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID))
             .SetReturn("originalMessageId");
 
+        STRICT_EXPECTED_CALL(singlylinkedlist_create());
 
         STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(messaging_delivery_accepted());
 
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(json_object_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(json_value_free(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
         TEST_IOTHUB_MESSAGING* test_handle = (TEST_IOTHUB_MESSAGING*)iothub_messaging_handle;
         test_handle->callback_data->feedbackMessageCallback = on_feedback_message_received;
 
@@ -2401,6 +2663,8 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
     /*Tests_SRS_IOTHUBMESSAGING_12_060: [ IoTHubMessaging_LL_FeedbackMessageReceived shall use the following parson APIs to parse the response string: json_parse_string, json_value_get_object, json_object_get_string, json_object_dotget_string  ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_062: [ If context is not NULL IoTHubMessaging_LL_FeedbackMessageReceived shall call IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK with the received IOTHUB_SERVICE_FEEDBACK_BATCH ] */
     /*Tests_SRS_IOTHUBMESSAGING_12_078: [** IoTHubMessaging_LL_FeedbackMessageReceived shall do clean up before exits ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_014: [ IoTHubMessaging_LL_FeedbackMessageReceived shall copy the message body to a '\0' terminated buffer before parsing it ] */
+    /*Tests_SRS_IOTHUBMESSAGING_02_015: [ IoTHubMessaging_LL_FeedbackMessageReceived shall store all the records of the batch in one array allocation ] */
     TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_happy_path_feedback_null)
     {
         ///arrange
@@ -2415,6 +2679,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(message_get_body_amqp_data(IGNORED_PTR_ARG, IGNORED_NUM_ARG, &TEST_BINARY_DATA_INST))
             .IgnoreAllArguments();
 
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
         STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
@@ -2427,17 +2694,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_create());
-
         STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0))
             .SetReturn(TEST_JSON_OBJECT);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_ID))
             .SetReturn("deviceId");
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID))
@@ -2449,37 +2708,25 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID))
             .SetReturn("originalMessageId");
 
+        STRICT_EXPECTED_CALL(singlylinkedlist_create());
 
         STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(messaging_delivery_accepted());
 
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(json_object_clear(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(json_value_free(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
         TEST_IOTHUB_MESSAGING* test_handle = (TEST_IOTHUB_MESSAGING*)iothub_messaging_handle;
         test_handle->callback_data->feedbackMessageCallback = on_feedback_message_received;
 
@@ -2512,6 +2759,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(message_get_body_amqp_data(IGNORED_PTR_ARG, IGNORED_NUM_ARG, &TEST_BINARY_DATA_INST))
             .IgnoreAllArguments();
 
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
         STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
@@ -2524,32 +2774,20 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_create());
-
         STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0))
             .SetReturn(TEST_JSON_OBJECT);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_ID))
             .SetReturn("deviceId");
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID))
             .SetReturn("generationId");
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DESCRIPTION))
-            .SetReturn("success");
+            .SetReturn(NULL);
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ENQUED_TIME_UTC))
             .SetReturn("time");
         STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID))
             .SetReturn("originalMessageId");
 
-
-        STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments();
-
         STRICT_EXPECTED_CALL(messaging_delivery_accepted());
 
         umock_c_negative_tests_snapshot();
@@ -2563,19 +2801,13 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
             TEST_IOTHUB_MESSAGING* test_handle = (TEST_IOTHUB_MESSAGING*)iothub_messaging_handle;
             test_handle->callback_data->feedbackMessageCallback = NULL;
 
-            if (i <= 9)
-            {
-                ///act
-                AMQP_VALUE amqp_result = onMessageReceivedCallback((void*)iothub_messaging_handle, TEST_MESSAGE_HANDLE);
+            ///act
+            AMQP_VALUE amqp_result = onMessageReceivedCallback((void*)iothub_messaging_handle, TEST_MESSAGE_HANDLE);
 
-                ///assert
-                if (i < 7)
-                {
-                    if (amqp_result != NULL)
-                    {
-                        ASSERT_ARE_EQUAL(int, 0, 1);
-                    }
-                }
+            ///assert
+            if (i < 7)
+            {
+                ASSERT_IS_NULL(amqp_result);
             }
         }
         umock_c_negative_tests_deinit();
@@ -2584,4 +2816,73 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         IoTHubMessaging_LL_Close(iothub_messaging_handle);
         IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
     }
+
+    /*Tests_SRS_IOTHUBMESSAGING_02_016: [ If a IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK has been set IoTHubMessaging_LL_FeedbackMessageReceived shall call it with the array of records and the record count ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_calls_the_feedback_records_callback)
+    {
+        ///arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+        (void)IoTHubMessaging_LL_Open(iothub_messaging_handle, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, (void*)1);
+        (void)IoTHubMessaging_LL_SetFeedbackRecordsCallback(iothub_messaging_handle, TEST_FUNC_IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK, (void*)1);
+
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(message_get_body_amqp_data(IGNORED_PTR_ARG, IGNORED_NUM_ARG, &TEST_BINARY_DATA_INST))
+            .IgnoreAllArguments();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(json_value_get_array(TEST_JSON_VALUE))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
+            .SetReturn(1);
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0))
+            .SetReturn(TEST_JSON_OBJECT);
+
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_ID))
+            .SetReturn("deviceId");
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID))
+            .SetReturn("generationId");
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_DESCRIPTION))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ENQUED_TIME_UTC))
+            .SetReturn("time");
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, TEST_FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID))
+            .SetReturn("originalMessageId");
+
+        STRICT_EXPECTED_CALL(TEST_FUNC_IOTHUB_FEEDBACK_RECORDS_RECEIVED_CALLBACK((void*)1, IGNORED_PTR_ARG, 1))
+            .IgnoreArgument(2);
+
+        STRICT_EXPECTED_CALL(messaging_delivery_accepted());
+
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(json_value_free(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        AMQP_VALUE amqp_result = onMessageReceivedCallback((void*)iothub_messaging_handle, TEST_MESSAGE_HANDLE);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(amqp_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubMessaging_LL_Close(iothub_messaging_handle);
+        IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
+    }
+
     END_TEST_SUITE(iothub_messaging_ll_ut)
@@ -0,0 +1,180 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#include "iothub_service_client_auth.h"
+#include "iothub_registrymanager.h"
+
+/*
+ * Measures the IoTHubRegistryManager_GetDevice throughput against the hub named by the
+ * IOTHUB_CONNECTION_STRING environment variable. Point it at a local HTTPS stand-in to take
+ * the service out of the measurement. Two runs are compared:
+ *  - "new registry manager per call": every request opens its own connection and computes its own SAS token
+ *  - "shared registry manager": all the requests go through one handle, reusing the connection and the SAS token
+ * When IOTHUB_CONNECTION_STRING is not set the benchmark prints a note and exits with 0.
+ */
+
+#define REQUEST_COUNT 200
+#define DEFAULT_DEVICE_ID "iothub_rm_perf"
+
+typedef IOTHUB_REGISTRYMANAGER_RESULT(*GET_DEVICE_FUNCTION)(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle, IOTHUB_REGISTRYMANAGER_HANDLE sharedHandle, const char* deviceId);
+
+static IOTHUB_REGISTRYMANAGER_RESULT GetDevice(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, const char* deviceId)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    IOTHUB_DEVICE device = { 0 };
+
+    result = IoTHubRegistryManager_GetDevice(registryManagerHandle, deviceId, &device);
+    IoTHubRegistryManager_FreeDevice(&device);
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT GetDeviceWithNewRegistryManager(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle, IOTHUB_REGISTRYMANAGER_HANDLE sharedHandle, const char* deviceId)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle;
+
+    (void)sharedHandle;
+    if ((registryManagerHandle = IoTHubRegistryManager_Create(serviceClientHandle)) == NULL)
+    {
+        result = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else
+    {
+        result = GetDevice(registryManagerHandle, deviceId);
+        IoTHubRegistryManager_Destroy(registryManagerHandle);
+    }
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT GetDeviceWithSharedRegistryManager(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle, IOTHUB_REGISTRYMANAGER_HANDLE sharedHandle, const char* deviceId)
+{
+    (void)serviceClientHandle;
+    return GetDevice(sharedHandle, deviceId);
+}
+
+static int Measure(const char* name, GET_DEVICE_FUNCTION getDevice, IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle, IOTHUB_REGISTRYMANAGER_HANDLE sharedHandle, const char* deviceId)
+{
+    int result;
+    TICK_COUNTER_HANDLE tickCounter;
+    tickcounter_ms_t start;
+    tickcounter_ms_t end;
+
+    if ((tickCounter = tickcounter_create()) == NULL)
+    {
+        (void)printf("tickcounter_create failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t i;
+        size_t failures = 0;
+
+        (void)tickcounter_get_current_ms(tickCounter, &start);
+        for (i = 0; i < REQUEST_COUNT; i++)
+        {
+            if (getDevice(serviceClientHandle, sharedHandle, deviceId) != IOTHUB_REGISTRYMANAGER_OK)
+            {
+                failures++;
+            }
+        }
+        (void)tickcounter_get_current_ms(tickCounter, &end);
+
+        if (failures != 0)
+        {
+            (void)printf("%-32s %lu of %d requests failed\n", name, (unsigned long)failures, REQUEST_COUNT);
+            result = __LINE__;
+        }
+        else
+        {
+            double elapsedMs = (double)(end - start);
+            (void)printf("%-32s %10.1f requests/s %8.2f ms/request\n", name, (elapsedMs > 0) ? (REQUEST_COUNT * 1000.0 / elapsedMs) : 0.0, elapsedMs / REQUEST_COUNT);
+            result = 0;
+        }
+        tickcounter_destroy(tickCounter);
+    }
+    return result;
+}
+
+int main(void)
+{
+    int result;
+    const char* connectionString = getenv("IOTHUB_CONNECTION_STRING");
+    const char* deviceId = getenv("IOTHUB_PERF_DEVICE_ID");
+
+    if (deviceId == NULL)
+    {
+        deviceId = DEFAULT_DEVICE_ID;
+    }
+
+    if (connectionString == NULL)
+    {
+        (void)printf("IOTHUB_CONNECTION_STRING is not set, skipping the registry manager benchmark\n");
+        result = 0;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\n");
+        result = __LINE__;
+    }
+    else
+    {
+        IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle;
+        IOTHUB_REGISTRYMANAGER_HANDLE sharedHandle;
+
+        if ((serviceClientHandle = IoTHubServiceClientAuth_CreateFromConnectionString(connectionString)) == NULL)
+        {
+            (void)printf("IoTHubServiceClientAuth_CreateFromConnectionString failed\n");
+            result = __LINE__;
+        }
+        else
+        {
+            if ((sharedHandle = IoTHubRegistryManager_Create(serviceClientHandle)) == NULL)
+            {
+                (void)printf("IoTHubRegistryManager_Create failed\n");
+                result = __LINE__;
+            }
+            else
+            {
+                IOTHUB_REGISTRY_DEVICE_CREATE deviceCreate;
+                IOTHUB_DEVICE device = { 0 };
+                IOTHUB_REGISTRYMANAGER_RESULT createResult;
+
+                deviceCreate.deviceId = deviceId;
+                deviceCreate.primaryKey = "";
+                deviceCreate.secondaryKey = "";
+                createResult = IoTHubRegistryManager_CreateDevice(sharedHandle, &deviceCreate, &device);
+                IoTHubRegistryManager_FreeDevice(&device);
+
+                if ((createResult != IOTHUB_REGISTRYMANAGER_OK) && (createResult != IOTHUB_REGISTRYMANAGER_DEVICE_EXIST))
+                {
+                    (void)printf("IoTHubRegistryManager_CreateDevice failed for %s\n", deviceId);
+                    result = __LINE__;
+                }
+                else
+                {
+                    result = Measure("new registry manager per call", GetDeviceWithNewRegistryManager, serviceClientHandle, sharedHandle, deviceId);
+                    if (result == 0)
+                    {
+                        result = Measure("shared registry manager", GetDeviceWithSharedRegistryManager, serviceClientHandle, sharedHandle, deviceId);
+                    }
+
+                    if (createResult == IOTHUB_REGISTRYMANAGER_OK)
+                    {
+                        (void)IoTHubRegistryManager_DeleteDevice(sharedHandle, deviceId);
+                    }
+                }
+                IoTHubRegistryManager_Destroy(sharedHandle);
+            }
+            IoTHubServiceClientAuth_Destroy(serviceClientHandle);
+        }
+        platform_deinit();
+    }
+
+    return result;
+}
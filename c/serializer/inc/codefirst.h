@@ -133,6 +133,13 @@ extern CODEFIRST_RESULT CodeFirst_SendAsync(unsigned char** destination, size_t*
 
 extern AGENT_DATA_TYPE_TYPE CodeFirst_GetPrimitiveType(const char* typeName);
 
+typedef void* CODEFIRST_BATCH_HANDLE;
+
+extern CODEFIRST_BATCH_HANDLE CodeFirst_CreateBatch(size_t maxSamples, bool deltaEncoding, size_t numProperties, ...);
+extern CODEFIRST_RESULT CodeFirst_AppendBatchSample(CODEFIRST_BATCH_HANDLE batchHandle);
+extern CODEFIRST_RESULT CodeFirst_SendBatchAsync(unsigned char** destination, size_t* destinationSize, CODEFIRST_BATCH_HANDLE batchHandle);
+extern void CodeFirst_DestroyBatch(CODEFIRST_BATCH_HANDLE batchHandle);
+
 #ifdef __cplusplus
 }
 #endif
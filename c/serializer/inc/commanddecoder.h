@@ -23,6 +23,10 @@ EXECUTE_COMMAND_ERROR /*when a transient error either in the final recipient or
 
 DEFINE_ENUM(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_RESULT_VALUES)
 
+/*longest "childModel1/.../childModelN/actionName" accepted in the "Name" member of a command*/
+#define COMMAND_DECODER_MAX_ACTION_PATH_LENGTH 255
+/*how many struct values can be nested inside an action argument*/
+#define COMMAND_DECODER_MAX_STRUCT_NESTING 8
 
 #ifdef __cplusplus
 extern "C" {
@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef DATABATCH_H
+#define DATABATCH_H
+
+#include <stdbool.h>
+#include "agenttypesystem.h"
+#include "azure_c_shared_utility/macro_utils.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+/*Codes_SRS_DATA_BATCH_02_001: [DataBatch shall have the following interface]*/
+#define DATA_BATCH_RESULT_VALUES            \
+DATA_BATCH_OK,                              \
+DATA_BATCH_INVALID_ARG,                     \
+DATA_BATCH_EMPTY,                           \
+DATA_BATCH_AGENT_DATA_TYPES_ERROR,          \
+DATA_BATCH_ERROR
+
+DEFINE_ENUM(DATA_BATCH_RESULT, DATA_BATCH_RESULT_VALUES);
+
+typedef void* DATA_BATCH_HANDLE;
+
+extern DATA_BATCH_HANDLE DataBatch_Create(size_t columnCount, const char* const* columnNames, size_t maxSamples, bool deltaEncoding);
+extern void DataBatch_Destroy(DATA_BATCH_HANDLE dataBatchHandle);
+extern DATA_BATCH_RESULT DataBatch_AppendSample(DATA_BATCH_HANDLE dataBatchHandle, AGENT_DATA_TYPE* values);
+extern size_t DataBatch_GetSampleCount(DATA_BATCH_HANDLE dataBatchHandle);
+extern DATA_BATCH_RESULT DataBatch_Encode(DATA_BATCH_HANDLE dataBatchHandle, unsigned char** destination, size_t* destinationSize);
+extern void DataBatch_Clear(DATA_BATCH_HANDLE dataBatchHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DATABATCH_H */
@@ -33,6 +33,7 @@ extern void DataPublisher_Destroy(DATA_PUBLISHER_HANDLE dataPublisherHandle);
 
 extern TRANSACTION_HANDLE DataPublisher_StartTransaction(DATA_PUBLISHER_HANDLE dataPublisherHandle);
 extern DATA_PUBLISHER_RESULT DataPublisher_PublishTransacted(TRANSACTION_HANDLE transactionHandle, const char* propertyPath, const AGENT_DATA_TYPE* data);
+extern DATA_PUBLISHER_RESULT DataPublisher_PublishTransactedMove(TRANSACTION_HANDLE transactionHandle, const char* propertyPath, AGENT_DATA_TYPE* data);
 extern DATA_PUBLISHER_RESULT DataPublisher_EndTransaction(TRANSACTION_HANDLE transactionHandle, unsigned char** destination, size_t* destinationSize);
 extern DATA_PUBLISHER_RESULT DataPublisher_CancelTransaction(TRANSACTION_HANDLE transactionHandle);
 extern void DataPublisher_SetMaxBufferSize(size_t value);
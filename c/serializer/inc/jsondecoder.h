@@ -22,7 +22,20 @@ typedef enum JSON_DECODER_RESULT_TAG
     JSON_DECODER_ERROR
 } JSON_DECODER_RESULT;
 
+/* Begin positions point to the opening '{' or '[', end positions point just past the closing '}' or ']'.
+   Member names are passed without their quotation marks, values are passed as they appear in the JSON. */
+typedef struct JSON_DECODER_CALLBACKS_TAG
+{
+    JSON_DECODER_RESULT(*OnObjectBegin)(void* context, const char* position);
+    JSON_DECODER_RESULT(*OnObjectEnd)(void* context, const char* position);
+    JSON_DECODER_RESULT(*OnArrayBegin)(void* context, const char* position);
+    JSON_DECODER_RESULT(*OnArrayEnd)(void* context, const char* position);
+    JSON_DECODER_RESULT(*OnMemberName)(void* context, const char* name, size_t nameLength);
+    JSON_DECODER_RESULT(*OnValue)(void* context, const char* value, size_t valueLength);
+} JSON_DECODER_CALLBACKS;
+
 extern JSON_DECODER_RESULT JSONDecoder_JSON_To_MultiTree(char* json, MULTITREE_HANDLE* multiTreeHandle);
+extern JSON_DECODER_RESULT JSONDecoder_Parse(const char* json, size_t jsonLength, const JSON_DECODER_CALLBACKS* callbacks, void* callbackContext);
 
 #ifdef __cplusplus
 }
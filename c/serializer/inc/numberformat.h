@@ -0,0 +1,31 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef NUMBERFORMAT_H
+#define NUMBERFORMAT_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+/*Codes_SRS_NUMBER_FORMAT_02_001: [NumberFormat shall have the following interface]*/
+/*enough for "-", 17 significant digits, ".", "e-308" or the longest fixed notation and the '\0'*/
+#define NUMBER_FORMAT_DOUBLE_BUFFER_SIZE 32
+/*enough for "-9223372036854775808" and the '\0'*/
+#define NUMBER_FORMAT_INT64_BUFFER_SIZE 21
+
+extern size_t NumberFormat_Double(char* destination, double value);
+extern size_t NumberFormat_Single(char* destination, float value);
+extern size_t NumberFormat_Int64(char* destination, int64_t value);
+extern size_t NumberFormat_UInt64(char* destination, uint64_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NUMBERFORMAT_H */
@@ -93,6 +93,11 @@ extern SCHEMA_PROPERTY_HANDLE Schema_GetStructTypePropertyByIndex(SCHEMA_STRUCT_
 extern const char* Schema_GetPropertyName(SCHEMA_PROPERTY_HANDLE propertyHandle);
 extern const char* Schema_GetPropertyType(SCHEMA_PROPERTY_HANDLE propertyHandle);
 
+extern SCHEMA_RESULT Schema_Freeze(SCHEMA_HANDLE schemaHandle);
+extern SCHEMA_RESULT Schema_GetModelPropertyIdCount(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, size_t* propertyIdCount);
+extern SCHEMA_RESULT Schema_GetModelPropertyIdByPath(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* propertyPath, size_t* propertyId);
+extern const char* Schema_GetModelPropertyPathById(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, size_t propertyId);
+
 extern void Schema_Destroy(SCHEMA_HANDLE schemaHandle);
 extern SCHEMA_RESULT Schema_DestroyIfUnused(SCHEMA_MODEL_TYPE_HANDLE modelHandle);
 
@@ -259,6 +259,40 @@ DEFINE_ENUM(IOT_AGENT_RESULT, IOT_AGENT_RESULT_ENUM_VALUES);
 /*Codes_SRS_SERIALIZER_99_114:[ If CodeFirst_SendAsync fails, SEND shall return IOT_AGENT_SERIALIZE_FAILED.] */
 #define SERIALIZE(destination, destinationSize,...) ((CodeFirst_SendAsync(destination, destinationSize, COUNT_ARG(__VA_ARGS__) FOR_EACH_1(ADDRESS_MACRO, __VA_ARGS__)) == CODEFIRST_OK) ? IOT_AGENT_OK : IOT_AGENT_SERIALIZE_FAILED)
 
+/**
+ * @def      CREATE_BATCH(maxSamples, deltaEncoding, ...)
+ * This macro creates a batch that buffers samples of a set of properties so
+ * that they can be serialized together in a columnar layout by ::SERIALIZE_BATCH.
+ *
+ * @param   maxSamples                   Maximum number of buffered samples.
+ *                                       When the batch is full the oldest
+ *                                       sample is dropped.
+ * @param   deltaEncoding                When @c true, integer and timestamp
+ *                                       columns are written as deltas.
+ * @param    property1, property2...     A list of properties of the same model
+ *                                       instance, or the model instance itself
+ *                                       to batch all its properties.
+ *
+ * The batch shall be destroyed with ::DESTROY_BATCH before the model instance
+ * is destroyed.
+ */
+/*Codes_SRS_SERIALIZER_02_019: [CREATE_BATCH shall call CodeFirst_CreateBatch passing maxSamples, deltaEncoding, the number of properties and pointers to the values for each property.]*/
+#define CREATE_BATCH(maxSamples, deltaEncoding, ...) CodeFirst_CreateBatch(maxSamples, deltaEncoding, COUNT_ARG(__VA_ARGS__) FOR_EACH_1(ADDRESS_MACRO, __VA_ARGS__))
+
+/*Codes_SRS_SERIALIZER_02_020: [APPEND_BATCH shall call CodeFirst_AppendBatchSample. If CodeFirst_AppendBatchSample succeeds, APPEND_BATCH shall return IOT_AGENT_OK, otherwise IOT_AGENT_SERIALIZE_FAILED.]*/
+#define APPEND_BATCH(batch) ((CodeFirst_AppendBatchSample(batch) == CODEFIRST_OK) ? IOT_AGENT_OK : IOT_AGENT_SERIALIZE_FAILED)
+
+/**
+ * @def      SERIALIZE_BATCH(destination, destinationSize, batch)
+ * This macro produces the columnar JSON representation of all the samples
+ * buffered in the batch, one array per property, and empties the batch.
+ */
+/*Codes_SRS_SERIALIZER_02_021: [SERIALIZE_BATCH shall call CodeFirst_SendBatchAsync. If CodeFirst_SendBatchAsync succeeds, SERIALIZE_BATCH shall return IOT_AGENT_OK, otherwise IOT_AGENT_SERIALIZE_FAILED.]*/
+#define SERIALIZE_BATCH(destination, destinationSize, batch) ((CodeFirst_SendBatchAsync(destination, destinationSize, batch) == CODEFIRST_OK) ? IOT_AGENT_OK : IOT_AGENT_SERIALIZE_FAILED)
+
+/*Codes_SRS_SERIALIZER_02_022: [DESTROY_BATCH shall call CodeFirst_DestroyBatch.]*/
+#define DESTROY_BATCH(batch) CodeFirst_DestroyBatch(batch)
+
 /**
  * @def   EXECUTE_COMMAND(device, command)
  * Any action that is declared in a model must also have an implementation as
@@ -29,6 +29,7 @@
 #include "azure_c_shared_utility/crt_abstractions.h"
 
 #include "jsonencoder.h"
+#include "numberformat.h"
 #include "multitree.h"
 
 #include "azure_c_shared_utility/xlogging.h"
@@ -1673,35 +1674,9 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             case (EDM_INT16_TYPE) :
             {
                 /*-32768 to +32767*/
-                char buffertemp2[7]; /*because 5 digits and sign and '\0'*/
-                uint16_t positiveValue;
-                size_t pos = 0;
-                uint16_t rank = (uint16_t)10000;
-                bool foundFirstDigit = false;
+                char buffertemp2[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+                (void)NumberFormat_Int64(buffertemp2, value->value.edmInt16.value);
 
-                if (value->value.edmInt16.value < 0)
-                {
-                    buffertemp2[pos++] = '-';
-                    positiveValue = -value->value.edmInt16.value;
-                }
-                else
-                {
-                    positiveValue = value->value.edmInt16.value;
-                }
-
-                while (rank >= 10)
-                {
-                    if ((foundFirstDigit == true) || (positiveValue / rank) > 0)
-                    {
-                        buffertemp2[pos++] = '0' + (char)(positiveValue / rank);
-                        foundFirstDigit = true;
-                    }
-                    positiveValue %= rank;
-                    rank /= 10;
-                }
-                buffertemp2[pos++] = '0' + (char)(positiveValue);
-                buffertemp2[pos++] = '\0';
-                
                 if (STRING_concat(destination, buffertemp2) != 0)
                 {
                     result = AGENT_DATA_TYPES_ERROR;
@@ -1716,35 +1691,9 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             case (EDM_INT32_TYPE) :
             {
                 /*-2147483648 to +2147483647*/
-                char buffertemp2[12]; /*because 10 digits and sign and '\0'*/
-                uint32_t positiveValue;
-                size_t pos = 0;
-                uint32_t rank = 1000000000UL;
-                bool foundFirstDigit = false;
-
-                if (value->value.edmInt32.value < 0)
-                {
-                    buffertemp2[pos++] = '-';
-                    positiveValue = - value->value.edmInt32.value;
-                }
-                else
-                {
-                    positiveValue = value->value.edmInt32.value;
-                }
+                char buffertemp2[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+                (void)NumberFormat_Int64(buffertemp2, value->value.edmInt32.value);
 
-                while (rank >= 10)
-                {
-                    if ((foundFirstDigit == true) || (positiveValue / rank) > 0)
-                    {
-                        buffertemp2[pos++] = '0' + (char)(positiveValue / rank);
-                        foundFirstDigit = true;
-                    }
-                    positiveValue %= rank;
-                    rank /= 10;
-                }
-                buffertemp2[pos++] = '0' + (char)(positiveValue);
-                buffertemp2[pos++] = '\0';
-                
                 if (STRING_concat(destination, buffertemp2) != 0)
                 {
                     result = AGENT_DATA_TYPES_ERROR;
@@ -1758,34 +1707,8 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             }
             case (EDM_INT64_TYPE):
             {
-                char buffertemp2[21]; /*because 19 digits and sign and '\0'*/
-                uint64_t positiveValue;
-                size_t pos = 0;
-                uint64_t rank = 10000000000000000000ULL;
-                bool foundFirstDigit = false;
-
-                if (value->value.edmInt64.value < 0)
-                {
-                    buffertemp2[pos++] = '-';
-                    positiveValue = -value->value.edmInt64.value;
-                }
-                else
-                {
-                    positiveValue = value->value.edmInt64.value;
-                }
-
-                while (rank >= 10)
-                {
-                    if ((foundFirstDigit == true) || (positiveValue / rank) > 0)
-                    {
-                        buffertemp2[pos++] = '0' + (char)(positiveValue / rank);
-                        foundFirstDigit = true;
-                    }
-                    positiveValue %= rank;
-                    rank /= 10;
-                }
-                buffertemp2[pos++] = '0' + (char)(positiveValue);
-                buffertemp2[pos++] = '\0';
+                char buffertemp2[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+                (void)NumberFormat_Int64(buffertemp2, value->value.edmInt64.value);
 
                 if (STRING_concat(destination, buffertemp2) != 0)
                 {
@@ -1958,8 +1881,6 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                 /*C89 standard says: When a float is promoted to double or long double, or a double is promoted to long double, its value is unchanged*/
                 /*I read that as : when a float is NaN or Inf, it will stay NaN or INF in double representation*/
 
-                /*The sprintf function returns the number of characters written in the array, not counting the terminating null character.*/
-
                 if(ISNAN(value->value.edmSingle.value))
                 {
                     if (STRING_concat(destination, NaN_STRING) != 0)
@@ -1998,43 +1919,27 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                 }
                 else
                 {
-                    size_t tempBufferSize = MAX_FLOATING_POINT_STRING_LENGTH;
-                    char* tempBuffer = (char*)malloc(tempBufferSize);
-                    if (tempBuffer == NULL)
+                    char tempBuffer[NUMBER_FORMAT_DOUBLE_BUFFER_SIZE];
+                    (void)NumberFormat_Single(tempBuffer, value->value.edmSingle.value);
+                    if (STRING_concat(destination, tempBuffer) != 0)
                     {
                         result = AGENT_DATA_TYPES_ERROR;
                         LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
                     }
                     else
                     {
-                        if (sprintf_s(tempBuffer, tempBufferSize, "%.*f", FLT_DIG, (double)(value->value.edmSingle.value)) < 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else if (STRING_concat(destination, tempBuffer) != 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            result = AGENT_DATA_TYPES_OK;
-                        }
-
-                        free(tempBuffer);
+                        result = AGENT_DATA_TYPES_OK;
                     }
                 }
                 break;
             }
             case(EDM_DOUBLE_TYPE):
             {
-                /*The sprintf function returns the number of characters written in the array, not counting the terminating null character.*/
                 /*OData-ABNF says these can be used: nanInfinity = 'NaN' / '-INF' / 'INF'*/
                 /*C90 doesn't declare a NaN or Inf in the standard, however, values might be NaN or Inf...*/
                 /*C99 ... does*/
                 /*C11 is same as C99*/
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
                 if(ISNAN(value->value.edmDouble.value))
                 {
                     if (STRING_concat(destination, NaN_STRING) != 0)
@@ -2047,7 +1952,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                         result = AGENT_DATA_TYPES_OK;
                     }
                 }
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
                 else if (ISNEGATIVEINFINITY(value->value.edmDouble.value))
                 {
                     if (STRING_concat(destination, MINUSINF_STRING) != 0)
@@ -2060,7 +1965,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                         result = AGENT_DATA_TYPES_OK;
                     }
                 }
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
                 else if (ISPOSITIVEINFINITY(value->value.edmDouble.value))
                 {
                     if (STRING_concat(destination, PLUSINF_STRING) != 0)
@@ -2073,34 +1978,19 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                         result = AGENT_DATA_TYPES_OK;
                     }
                 }
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
                 else
                 {
-                    size_t tempBufferSize = DECIMAL_DIG * 2;
-                    char* tempBuffer = (char*)malloc(tempBufferSize);
-                    if (tempBuffer == NULL)
+                    char tempBuffer[NUMBER_FORMAT_DOUBLE_BUFFER_SIZE];
+                    (void)NumberFormat_Double(tempBuffer, value->value.edmDouble.value);
+                    if (STRING_concat(destination, tempBuffer) != 0)
                     {
                         result = AGENT_DATA_TYPES_ERROR;
                         LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
                     }
                     else
                     {
-                        if (sprintf_s(tempBuffer, tempBufferSize, "%.*f", DBL_DIG, value->value.edmDouble.value) < 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else if (STRING_concat(destination, tempBuffer) != 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            result = AGENT_DATA_TYPES_OK;
-                        }
-
-                        free(tempBuffer);
+                        result = AGENT_DATA_TYPES_OK;
                     }
                 }
                 break;
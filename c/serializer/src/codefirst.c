@@ -14,6 +14,7 @@
 #include <stddef.h>
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "iotdevice.h"
+#include "databatch.h"
 
 DEFINE_ENUM_STRINGS(CODEFIRST_RESULT, CODEFIRST_ENUM_VALUES)
 DEFINE_ENUM_STRINGS(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_RESULT_VALUES)
@@ -423,8 +424,10 @@ SCHEMA_HANDLE CodeFirst_RegisterSchema(const char* schemaNamespace, const REFLEC
         }
         else
         {
+            /* Codes_SRS_CODEFIRST_02_038: [ After all the struct types and model types have been built, CodeFirst_RegisterSchema shall call Schema_Freeze so that later lookups in the schema are hash based. ]*/
             if ((buildStructTypes(result, metadata) != CODEFIRST_OK) ||
-                (buildModelTypes(result, metadata) != CODEFIRST_OK))
+                (buildModelTypes(result, metadata) != CODEFIRST_OK) ||
+                (Schema_Freeze(result) != SCHEMA_OK))
             {
                 Schema_Destroy(result);
                 result = NULL;
@@ -900,6 +903,335 @@ CODEFIRST_RESULT CodeFirst_SendAsync(unsigned char** destination, size_t* destin
     return result;
 }
 
+typedef struct CODEFIRST_BATCH_TAG
+{
+    DEVICE_HEADER_DATA* DeviceHeader;
+    size_t ColumnCount;
+    const REFLECTED_SOMETHING** Columns;
+    size_t* ColumnOffsets; /*offset of each property in the device block*/
+    AGENT_DATA_TYPE* Row; /*scratch row, its content is moved into the DataBatch at every sample*/
+    DATA_BATCH_HANDLE DataBatch;
+} CODEFIRST_BATCH;
+
+static void DestroyBatchColumnNames(STRING_HANDLE* columnNames, size_t columnCount)
+{
+    size_t i;
+    for (i = 0; i < columnCount; i++)
+    {
+        STRING_delete(columnNames[i]);
+    }
+    free(columnNames);
+}
+
+static CODEFIRST_RESULT AddBatchColumn(CODEFIRST_BATCH* batch, STRING_HANDLE** columnNames, const REFLECTED_SOMETHING* property, size_t offset, STRING_HANDLE columnName)
+{
+    CODEFIRST_RESULT result;
+    const REFLECTED_SOMETHING** newColumns;
+    size_t* newColumnOffsets;
+    STRING_HANDLE* newColumnNames;
+
+    if ((newColumns = (const REFLECTED_SOMETHING**)realloc((void*)batch->Columns, sizeof(const REFLECTED_SOMETHING*) * (batch->ColumnCount + 1))) == NULL)
+    {
+        result = CODEFIRST_ERROR;
+        LOG_CODEFIRST_ERROR;
+    }
+    else
+    {
+        batch->Columns = newColumns;
+        if ((newColumnOffsets = (size_t*)realloc(batch->ColumnOffsets, sizeof(size_t) * (batch->ColumnCount + 1))) == NULL)
+        {
+            result = CODEFIRST_ERROR;
+            LOG_CODEFIRST_ERROR;
+        }
+        else
+        {
+            batch->ColumnOffsets = newColumnOffsets;
+            if ((newColumnNames = (STRING_HANDLE*)realloc(*columnNames, sizeof(STRING_HANDLE) * (batch->ColumnCount + 1))) == NULL)
+            {
+                result = CODEFIRST_ERROR;
+                LOG_CODEFIRST_ERROR;
+            }
+            else
+            {
+                *columnNames = newColumnNames;
+                batch->Columns[batch->ColumnCount] = property;
+                batch->ColumnOffsets[batch->ColumnCount] = offset;
+                (*columnNames)[batch->ColumnCount] = columnName;
+                batch->ColumnCount++;
+                result = CODEFIRST_OK;
+            }
+        }
+    }
+
+    return result;
+}
+
+static CODEFIRST_RESULT AddAllDevicePropertiesToBatch(CODEFIRST_BATCH* batch, STRING_HANDLE** columnNames)
+{
+    const char* modelName = Schema_GetModelName(batch->DeviceHeader->ModelHandle);
+    const REFLECTED_SOMETHING* something;
+    CODEFIRST_RESULT result = CODEFIRST_OK;
+
+    for (something = batch->DeviceHeader->ReflectedData->reflectedData; something != NULL; something = something->next)
+    {
+        if ((something->type == REFLECTION_PROPERTY_TYPE) &&
+            (strcmp(something->what.property.modelName, modelName) == 0))
+        {
+            STRING_HANDLE columnName;
+            if ((columnName = STRING_construct(something->what.property.name)) == NULL)
+            {
+                result = CODEFIRST_ERROR;
+                LOG_CODEFIRST_ERROR;
+                break;
+            }
+            else if ((result = AddBatchColumn(batch, columnNames, something, something->what.property.offset, columnName)) != CODEFIRST_OK)
+            {
+                STRING_delete(columnName);
+                LOG_CODEFIRST_ERROR;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Codes_SRS_CODEFIRST_02_018: [CodeFirst_CreateBatch shall create a batch that buffers up to maxSamples samples of the properties passed as pointers in the variable argument list.] */
+CODEFIRST_BATCH_HANDLE CodeFirst_CreateBatch(size_t maxSamples, bool deltaEncoding, size_t numProperties, ...)
+{
+    CODEFIRST_BATCH* result;
+
+    /* Codes_SRS_CODEFIRST_02_019: [If maxSamples or numProperties is 0 then CodeFirst_CreateBatch shall fail and return NULL.] */
+    if ((maxSamples == 0) ||
+        (numProperties == 0))
+    {
+        result = NULL;
+        LogError("invalid arg size_t maxSamples=%u, size_t numProperties=%u", (unsigned int)maxSamples, (unsigned int)numProperties);
+    }
+    else if ((result = (CODEFIRST_BATCH*)malloc(sizeof(CODEFIRST_BATCH))) == NULL)
+    {
+        /* Codes_SRS_CODEFIRST_02_022: [If any other error occurs then CodeFirst_CreateBatch shall fail and return NULL.] */
+        LogError("failure in malloc");
+    }
+    else
+    {
+        CODEFIRST_RESULT codeFirstResult = CODEFIRST_OK;
+        STRING_HANDLE* columnNames = NULL;
+        size_t i;
+        va_list ap;
+
+        result->DeviceHeader = NULL;
+        result->ColumnCount = 0;
+        result->Columns = NULL;
+        result->ColumnOffsets = NULL;
+        result->Row = NULL;
+        result->DataBatch = NULL;
+
+        va_start(ap, numProperties);
+        for (i = 0; i < numProperties; i++)
+        {
+            void* value = (void*)va_arg(ap, void*);
+            DEVICE_HEADER_DATA* currentValueDeviceHeader = FindDevice(value);
+            if ((currentValueDeviceHeader == NULL) ||
+                /* Codes_SRS_CODEFIRST_02_020: [If any property cannot be associated with a device, or if the properties belong to different devices, then CodeFirst_CreateBatch shall fail and return NULL.] */
+                ((result->DeviceHeader != NULL) && (currentValueDeviceHeader != result->DeviceHeader)))
+            {
+                codeFirstResult = CODEFIRST_INVALID_ARG;
+                LogError("property cannot be associated with the device of the batch");
+                break;
+            }
+            else
+            {
+                result->DeviceHeader = currentValueDeviceHeader;
+
+                if (value == ((unsigned char*)currentValueDeviceHeader->data))
+                {
+                    /* Codes_SRS_CODEFIRST_02_021: [If a pointer to the beginning of a device block is passed then all the properties of that device shall become columns of the batch.] */
+                    if ((codeFirstResult = AddAllDevicePropertiesToBatch(result, &columnNames)) != CODEFIRST_OK)
+                    {
+                        break;
+                    }
+                }
+                else
+                {
+                    const REFLECTED_SOMETHING* propertyReflectedData;
+                    const char* modelName;
+                    STRING_HANDLE valuePath;
+
+                    if ((valuePath = STRING_new()) == NULL)
+                    {
+                        codeFirstResult = CODEFIRST_ERROR;
+                        LogError("failure in STRING_new");
+                        break;
+                    }
+                    else if (((modelName = Schema_GetModelName(currentValueDeviceHeader->ModelHandle)) == NULL) ||
+                        ((propertyReflectedData = FindValue(currentValueDeviceHeader, value, modelName, 0, valuePath)) == NULL))
+                    {
+                        STRING_delete(valuePath);
+                        codeFirstResult = CODEFIRST_INVALID_ARG;
+                        LogError("property cannot be found in the model");
+                        break;
+                    }
+                    /* Codes_SRS_CODEFIRST_02_023: [Each column shall be named by the full path of its property, as CodeFirst_SendAsync does.] */
+                    else if ((codeFirstResult = AddBatchColumn(result, &columnNames, propertyReflectedData, (size_t)((unsigned char*)value - currentValueDeviceHeader->data), valuePath)) != CODEFIRST_OK)
+                    {
+                        STRING_delete(valuePath);
+                        break;
+                    }
+                }
+            }
+        }
+        va_end(ap);
+
+        if (codeFirstResult == CODEFIRST_OK)
+        {
+            const char** columnNamesAsString;
+
+            if ((result->Row = (AGENT_DATA_TYPE*)malloc(sizeof(AGENT_DATA_TYPE) * result->ColumnCount)) == NULL)
+            {
+                codeFirstResult = CODEFIRST_ERROR;
+                LogError("failure in malloc");
+            }
+            else if ((columnNamesAsString = (const char**)malloc(sizeof(const char*) * result->ColumnCount)) == NULL)
+            {
+                codeFirstResult = CODEFIRST_ERROR;
+                LogError("failure in malloc");
+            }
+            else
+            {
+                for (i = 0; i < result->ColumnCount; i++)
+                {
+                    columnNamesAsString[i] = STRING_c_str(columnNames[i]);
+                }
+
+                /* Codes_SRS_CODEFIRST_02_024: [CodeFirst_CreateBatch shall call DataBatch_Create passing the column count, the column names, maxSamples and deltaEncoding.] */
+                if ((result->DataBatch = DataBatch_Create(result->ColumnCount, columnNamesAsString, maxSamples, deltaEncoding)) == NULL)
+                {
+                    codeFirstResult = CODEFIRST_ERROR;
+                    LogError("failure in DataBatch_Create");
+                }
+
+                free((void*)columnNamesAsString);
+            }
+        }
+
+        DestroyBatchColumnNames(columnNames, result->ColumnCount);
+
+        if (codeFirstResult != CODEFIRST_OK)
+        {
+            free(result->Row);
+            free(result->ColumnOffsets);
+            free((void*)result->Columns);
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+/* Codes_SRS_CODEFIRST_02_025: [CodeFirst_AppendBatchSample shall snapshot the current values of all the columns of the batch and append them as one sample.] */
+CODEFIRST_RESULT CodeFirst_AppendBatchSample(CODEFIRST_BATCH_HANDLE batchHandle)
+{
+    CODEFIRST_RESULT result;
+
+    if (batchHandle == NULL)
+    {
+        /* Codes_SRS_CODEFIRST_02_026: [If batchHandle is NULL then CodeFirst_AppendBatchSample shall return CODEFIRST_INVALID_ARG.] */
+        result = CODEFIRST_INVALID_ARG;
+        LOG_CODEFIRST_ERROR;
+    }
+    else
+    {
+        CODEFIRST_BATCH* batch = (CODEFIRST_BATCH*)batchHandle;
+        size_t i;
+
+        for (i = 0; i < batch->ColumnCount; i++)
+        {
+            /* Codes_SRS_CODEFIRST_02_027: [The marshalling shall be done by calling the Create_AGENT_DATA_TYPE_from_Ptr function associated with each property.] */
+            if (batch->Columns[i]->what.property.Create_AGENT_DATA_TYPE_from_Ptr(batch->DeviceHeader->data + batch->ColumnOffsets[i], &batch->Row[i]) != AGENT_DATA_TYPES_OK)
+            {
+                break;
+            }
+        }
+
+        if (i < batch->ColumnCount)
+        {
+            size_t j;
+            for (j = 0; j < i; j++)
+            {
+                Destroy_AGENT_DATA_TYPE(&batch->Row[j]);
+            }
+
+            /* Codes_SRS_CODEFIRST_02_028: [If Create_AGENT_DATA_TYPE_from_Ptr fails, CodeFirst_AppendBatchSample shall return CODEFIRST_AGENT_DATA_TYPE_ERROR.] */
+            result = CODEFIRST_AGENT_DATA_TYPE_ERROR;
+            LOG_CODEFIRST_ERROR;
+        }
+        /* Codes_SRS_CODEFIRST_02_029: [CodeFirst_AppendBatchSample shall pass the values to DataBatch_AppendSample, which takes ownership of them.] */
+        else if (DataBatch_AppendSample(batch->DataBatch, batch->Row) != DATA_BATCH_OK)
+        {
+            for (i = 0; i < batch->ColumnCount; i++)
+            {
+                Destroy_AGENT_DATA_TYPE(&batch->Row[i]);
+            }
+
+            /* Codes_SRS_CODEFIRST_02_030: [If DataBatch_AppendSample fails, CodeFirst_AppendBatchSample shall return CODEFIRST_ERROR.] */
+            result = CODEFIRST_ERROR;
+            LOG_CODEFIRST_ERROR;
+        }
+        else
+        {
+            /* Codes_SRS_CODEFIRST_02_031: [Otherwise CodeFirst_AppendBatchSample shall return CODEFIRST_OK.] */
+            result = CODEFIRST_OK;
+        }
+    }
+
+    return result;
+}
+
+CODEFIRST_RESULT CodeFirst_SendBatchAsync(unsigned char** destination, size_t* destinationSize, CODEFIRST_BATCH_HANDLE batchHandle)
+{
+    CODEFIRST_RESULT result;
+
+    /* Codes_SRS_CODEFIRST_02_032: [If destination, destinationSize or batchHandle is NULL then CodeFirst_SendBatchAsync shall return CODEFIRST_INVALID_ARG.] */
+    if ((destination == NULL) ||
+        (destinationSize == NULL) ||
+        (batchHandle == NULL))
+    {
+        result = CODEFIRST_INVALID_ARG;
+        LOG_CODEFIRST_ERROR;
+    }
+    /* Codes_SRS_CODEFIRST_02_033: [CodeFirst_SendBatchAsync shall call DataBatch_Encode to produce the columnar payload of all the buffered samples.] */
+    else if (DataBatch_Encode(((CODEFIRST_BATCH*)batchHandle)->DataBatch, destination, destinationSize) != DATA_BATCH_OK)
+    {
+        /* Codes_SRS_CODEFIRST_02_034: [If DataBatch_Encode fails, CodeFirst_SendBatchAsync shall return CODEFIRST_ERROR.] */
+        result = CODEFIRST_ERROR;
+        LOG_CODEFIRST_ERROR;
+    }
+    else
+    {
+        /* Codes_SRS_CODEFIRST_02_035: [Otherwise CodeFirst_SendBatchAsync shall return CODEFIRST_OK.] */
+        result = CODEFIRST_OK;
+    }
+
+    return result;
+}
+
+void CodeFirst_DestroyBatch(CODEFIRST_BATCH_HANDLE batchHandle)
+{
+    /* Codes_SRS_CODEFIRST_02_036: [If batchHandle is NULL then CodeFirst_DestroyBatch shall do nothing.] */
+    if (batchHandle != NULL)
+    {
+        /* Codes_SRS_CODEFIRST_02_037: [CodeFirst_DestroyBatch shall call DataBatch_Destroy and free all the resources used by the batch.] */
+        CODEFIRST_BATCH* batch = (CODEFIRST_BATCH*)batchHandle;
+        DataBatch_Destroy(batch->DataBatch);
+        free(batch->Row);
+        free(batch->ColumnOffsets);
+        free((void*)batch->Columns);
+        free(batch);
+    }
+}
+
 EXECUTE_COMMAND_RESULT CodeFirst_ExecuteCommand(void* device, const char* command)
 {
     EXECUTE_COMMAND_RESULT result;
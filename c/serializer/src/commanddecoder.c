@@ -8,9 +8,10 @@
 #include "azure_c_shared_utility/gballoc.h"
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
 
 #include "commanddecoder.h"
-#include "multitree.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "schema.h"
@@ -19,6 +20,9 @@
 
 DEFINE_ENUM_STRINGS(COMMANDDECODER_RESULT, COMMANDDECODER_RESULT_VALUES);
 
+/*values up to this length are decoded from a stack buffer*/
+#define VALUE_BUFFER_SIZE 64
+
 typedef struct COMMAND_DECODER_INSTANCE_TAG
 {
     SCHEMA_MODEL_TYPE_HANDLE ModelHandle;
@@ -26,395 +30,743 @@ typedef struct COMMAND_DECODER_INSTANCE_TAG
     void* ActionCallbackContext;
 } COMMAND_DECODER_INSTANCE;
 
-static int DecodeValueFromNode(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* agentDataType, MULTITREE_HANDLE node, const char* edmTypeName)
+/*an expected value: an action argument or a member of a struct argument*/
+typedef struct VALUE_SLOT_TAG
+{
+    size_t NameLength;
+    const char* TypeName;
+    AGENT_DATA_TYPE_TYPE PrimitiveType; /*EDM_NO_TYPE for struct types*/
+    bool IsDecoded;
+} VALUE_SLOT;
+
+/*the values of one JSON object being decoded: "Parameters" or a struct nested in it*/
+typedef struct DECODE_LEVEL_TAG
+{
+    const char* TypeName; /*NULL for "Parameters"*/
+    size_t Count;
+    size_t PendingIndex; /*slot that receives the next value, Count when that value is skipped*/
+    AGENT_DATA_TYPE* Values;
+    const char** Names;
+    VALUE_SLOT* Slots;
+} DECODE_LEVEL;
+
+typedef enum COMMAND_MEMBER_TAG
 {
-    /* because "pottentially uninitialized variable on MS compiler" */
-    int result = 0;
-    const char* argStringValue;
-    AGENT_DATA_TYPE_TYPE primitiveType;
+    COMMAND_MEMBER_NONE,
+    COMMAND_MEMBER_NAME,
+    COMMAND_MEMBER_PARAMETERS,
+    COMMAND_MEMBER_OTHER
+} COMMAND_MEMBER;
 
-    /* Codes_SRS_COMMAND_DECODER_99_029:[ If the argument type is complex then a complex type value shall be built from the child nodes.] */
-    if ((primitiveType = CodeFirst_GetPrimitiveType(edmTypeName)) == EDM_NO_TYPE)
+typedef struct COMMAND_PARSE_CONTEXT_TAG
+{
+    COMMAND_DECODER_INSTANCE* commandDecoderInstance;
+    SCHEMA_HANDLE schemaHandle;
+    bool isInCommand;
+    COMMAND_MEMBER pendingMember;
+    bool hasName;
+    bool hasParameters;
+    size_t skipDepth;
+    bool isRecordingParameters;
+    const char* parametersBegin;
+    const char* parametersEnd;
+    SCHEMA_ACTION_HANDLE actionHandle; /*non-NULL once levels[0] holds the action arguments*/
+    const char* relativeActionPath;
+    const char* actionName;
+    size_t openLevels; /*levels[0] is "Parameters", levels[1..] are nested structs*/
+    DECODE_LEVEL levels[COMMAND_DECODER_MAX_STRUCT_NESTING + 1];
+    char actionPath[COMMAND_DECODER_MAX_ACTION_PATH_LENGTH + 1];
+} COMMAND_PARSE_CONTEXT;
+
+static int AllocateLevel(DECODE_LEVEL* level, const char* typeName, size_t count)
+{
+    int result;
+
+    level->TypeName = typeName;
+    level->Count = count;
+    level->PendingIndex = count;
+
+    if (count == 0)
+    {
+        level->Values = NULL;
+        level->Names = NULL;
+        level->Slots = NULL;
+        result = 0;
+    }
+    /*Codes_SRS_COMMAND_DECODER_02_002: [ The values shall be decoded into an array pre-sized from the Schema APIs, allocated in a single block together with their names and types. ]*/
+    else if ((level->Values = (AGENT_DATA_TYPE*)malloc(count * (sizeof(AGENT_DATA_TYPE) + sizeof(const char*) + sizeof(VALUE_SLOT)))) == NULL)
     {
-        SCHEMA_STRUCT_TYPE_HANDLE structTypeHandle;
-        size_t propertyCount;
+        /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
+        LogError("Failed allocating %u values", (unsigned int)count);
+        result = __LINE__;
+    }
+    else
+    {
+        size_t i;
 
-        /* Codes_SRS_COMMAND_DECODER_99_033:[ In order to determine which are the members of a complex types, Schema APIs for structure types shall be used.] */
-        if (((structTypeHandle = Schema_GetStructTypeByName(schemaHandle, edmTypeName)) == NULL) ||
-            (Schema_GetStructTypePropertyCount(structTypeHandle, &propertyCount) != SCHEMA_OK))
+        level->Names = (const char**)(level->Values + count);
+        level->Slots = (VALUE_SLOT*)(level->Names + count);
+        for (i = 0; i < count; i++)
         {
-            /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-            result = __LINE__;
-            LogError("Getting Struct information failed.");
+            level->Slots[i].IsDecoded = false;
         }
-        else
-        {
-            if (propertyCount == 0)
-            {
-                /* Codes_SRS_COMMAND_DECODER_99_034:[ If Schema APIs indicate that a complex type has 0 members then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-                result = __LINE__;
-                LogError("Struct type with 0 members is not allowed");
-            }
-            else
-            {
-                AGENT_DATA_TYPE* memberValues = (AGENT_DATA_TYPE*)malloc(sizeof(AGENT_DATA_TYPE)* propertyCount);
-                if (memberValues == NULL)
-                {
-                    /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
-                    result = __LINE__;
-                    LogError("Failed allocating member values for command argument");
-                }
-                else
-                {
-                    const char** memberNames = (const char**)malloc(sizeof(const char*)* propertyCount);
-                    if (memberNames == NULL)
-                    {
-                        /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
-                        result = __LINE__;
-                        LogError("Failed allocating member names for command argument.");
-                    }
-                    else
-                    {
-                        size_t j;
-                        size_t k;
-
-                        for (j = 0; j < propertyCount; j++)
-                        {
-                            SCHEMA_PROPERTY_HANDLE propertyHandle;
-                            MULTITREE_HANDLE memberNode;
-                            const char* propertyName;
-                            const char* propertyType;
-
-                            if ((propertyHandle = Schema_GetStructTypePropertyByIndex(structTypeHandle, j)) == NULL)
-                            {
-                                /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-                                result = __LINE__;
-                                LogError("Getting struct member failed.");
-                                break;
-                            }
-                            else if (((propertyName = Schema_GetPropertyName(propertyHandle)) == NULL) ||
-                                     ((propertyType = Schema_GetPropertyType(propertyHandle)) == NULL))
-                            {
-                                /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-                                result = __LINE__;
-                                LogError("Getting the struct member information failed.");
-                                break;
-                            }
-                            else
-                            {
-                                memberNames[j] = propertyName;
-                                
-                                /* Codes_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
-                                if (MultiTree_GetChildByName(node, memberNames[j], &memberNode) != MULTITREE_OK)
-                                {
-                                    /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-                                    result = __LINE__;
-                                    LogError("Getting child %s failed", propertyName);
-                                    break;
-                                }
-                                /* Codes_SRS_COMMAND_DECODER_99_032:[ Nesting shall be supported for complex type.] */
-                                else if ((result = DecodeValueFromNode(schemaHandle, &memberValues[j], memberNode, propertyType)) != 0)
-                                {
-                                    break;
-                                }
-                            }
-                        }
-
-                        if (j == propertyCount)
-                        {
-                            /* Codes_SRS_COMMAND_DECODER_99_031:[ The complex type value that aggregates the children shall be built by using the Create_AGENT_DATA_TYPE_from_Members.] */
-                            if (Create_AGENT_DATA_TYPE_from_Members(agentDataType, edmTypeName, propertyCount, (const char* const*)memberNames, memberValues) != AGENT_DATA_TYPES_OK)
-                            {
-                                /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-                                result = __LINE__;
-                                LogError("Creating the agent data type from members failed.");
-                            }
-                            else
-                            {
-                                result = 0;
-                            }
-                        }
-
-                        for (k = 0; k < j; k++)
-                        {
-                            Destroy_AGENT_DATA_TYPE(&memberValues[k]);
-                        }
-
-                        free((void*)memberNames);
-                    }
+        result = 0;
+    }
 
-                    free(memberValues);
-                }
-            }
+    return result;
+}
+
+static void FreeLevel(DECODE_LEVEL* level)
+{
+    size_t i;
+
+    for (i = 0; i < level->Count; i++)
+    {
+        if (level->Slots[i].IsDecoded)
+        {
+            Destroy_AGENT_DATA_TYPE(&level->Values[i]);
         }
     }
-    else
+
+    if (level->Values != NULL)
+    {
+        free(level->Values);
+    }
+}
+
+static void SetSlot(DECODE_LEVEL* level, size_t index, const char* name, const char* typeName)
+{
+    level->Names[index] = name;
+    level->Slots[index].NameLength = strlen(name);
+    level->Slots[index].TypeName = typeName;
+    /* Codes_SRS_COMMAND_DECODER_99_029:[ If the argument type is complex then a complex type value shall be built from the child nodes.] */
+    level->Slots[index].PrimitiveType = CodeFirst_GetPrimitiveType(typeName);
+}
+
+static bool AreAllValuesDecoded(const DECODE_LEVEL* level)
+{
+    size_t i;
+
+    for (i = 0; i < level->Count; i++)
     {
-        /* Codes_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
-        if (MultiTree_GetValue(node, (const void **)&argStringValue) != MULTITREE_OK)
+        if (!level->Slots[i].IsDecoded)
         {
             /* Codes_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-            result = __LINE__;
-            LogError("Getting the string from the multitree failed.");
-        }
-        /* Codes_SRS_COMMAND_DECODER_99_027:[ The value for an argument of primitive type shall be decoded by using the CreateAgentDataType_From_String API.] */
-        else if (CreateAgentDataType_From_String(argStringValue, primitiveType, agentDataType) != AGENT_DATA_TYPES_OK)
-        {
-            /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-            result = __LINE__;
-            LogError("Failed parsing node %s.", argStringValue);
+            LogError("Missing argument %s", level->Names[i]);
+            break;
         }
     }
 
-    return result;
+    return (i == level->Count);
 }
 
-static EXECUTE_COMMAND_RESULT DecodeAndExecuteModelAction(COMMAND_DECODER_INSTANCE* commandDecoderInstance, SCHEMA_HANDLE schemaHandle, SCHEMA_MODEL_TYPE_HANDLE modelHandle, const char* relativeActionPath, const char* actionName, MULTITREE_HANDLE commandNode)
+static JSON_DECODER_RESULT ResolveAction(COMMAND_PARSE_CONTEXT* context, const char* value, size_t valueLength)
 {
-    EXECUTE_COMMAND_RESULT result;
-    char tempStr[128];
-    size_t strLength = strlen(actionName);
+    JSON_DECODER_RESULT result;
 
-    if (strLength <= 1)
+    if ((valueLength < 3) ||
+        (value[0] != '"'))
     {
-        /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
-        LogError("Invalid action name");
-        result = EXECUTE_COMMAND_ERROR;
+        /* Codes_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+        LogError("Invalid action name.");
+        result = JSON_DECODER_ERROR;
+    }
+    else if (valueLength - 2 > COMMAND_DECODER_MAX_ACTION_PATH_LENGTH)
+    {
+        /* Codes_SRS_COMMAND_DECODER_02_007: [ If the action path is longer than COMMAND_DECODER_MAX_ACTION_PATH_LENGTH characters then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+        LogError("Action path is longer than %u characters", (unsigned int)COMMAND_DECODER_MAX_ACTION_PATH_LENGTH);
+        result = JSON_DECODER_ERROR;
     }
     else
     {
         /* Codes_SRS_COMMAND_DECODER_99_006:[ The action name shall be decoded from the element "Name" of the command JSON.] */
-        SCHEMA_ACTION_HANDLE modelActionHandle;
-        size_t argCount;
-        MULTITREE_HANDLE parametersTreeNode;
+        SCHEMA_MODEL_TYPE_HANDLE modelHandle = context->commandDecoderInstance->ModelHandle;
+        char* actionName = context->actionPath;
+        char* lastSlash = NULL;
+        char* slashPos;
 
-#ifdef _MSC_VER
-#pragma warning(suppress: 6324) /* We intentionally use here strncpy */ 
-#endif
-        if (strncpy(tempStr, actionName, strLength - 1) == NULL)
+        (void)memcpy(context->actionPath, value + 1, valueLength - 2);
+        context->actionPath[valueLength - 2] = '\0';
+
+        /* Codes_SRS_COMMAND_DECODER_99_035:[ CommandDecoder_ExecuteCommand shall support paths to actions that are in child models (i.e. ChildModel/SomeAction.] */
+        while ((slashPos = strchr(actionName, '/')) != NULL)
         {
-            /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
-            LogError("Invalid action name.");
-            result = EXECUTE_COMMAND_ERROR;
+            *slashPos = '\0';
+            modelHandle = Schema_GetModelModelByName(modelHandle, actionName);
+            if (modelHandle == NULL)
+            {
+                /* Codes_SRS_COMMAND_DECODER_99_036:[ If a child model cannot be found by using Schema APIs then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+                LogError("Getting the model %s failed", actionName);
+                break;
+            }
+            *slashPos = '/';
+            lastSlash = slashPos;
+            actionName = slashPos + 1;
         }
-        /* Codes_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
-        else if (MultiTree_GetChildByName(commandNode, "Parameters", &parametersTreeNode) != MULTITREE_OK)
+
+        if (modelHandle == NULL)
         {
-            /* Codes_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-            LogError("Error getting Parameters node.");
-            result = EXECUTE_COMMAND_ERROR;
+            result = JSON_DECODER_ERROR;
         }
         else
         {
-            tempStr[strLength - 1] = 0;
+            SCHEMA_ACTION_HANDLE actionHandle;
+            size_t argCount;
+
+            /* Codes_SRS_COMMAND_DECODER_99_037:[ The relative path passed to the actionCallback shall be in the format "childModel1/childModel2/.../childModelN".] */
+            if (lastSlash == NULL)
+            {
+                context->relativeActionPath = "";
+            }
+            else
+            {
+                *lastSlash = '\0';
+                context->relativeActionPath = context->actionPath;
+            }
+            context->actionName = actionName;
 
             /* Codes_SRS_COMMAND_DECODER_99_009:[ CommandDecoder shall call Schema_GetModelActionByName to obtain the information about a specific action.] */
-            if (((modelActionHandle = Schema_GetModelActionByName(modelHandle, tempStr)) == NULL) ||
-                (Schema_GetModelActionArgumentCount(modelActionHandle, &argCount) != SCHEMA_OK))
+            if (((actionHandle = Schema_GetModelActionByName(modelHandle, actionName)) == NULL) ||
+                (Schema_GetModelActionArgumentCount(actionHandle, &argCount) != SCHEMA_OK))
             {
                 /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-                LogError("Failed reading action %s from the schema", tempStr);
-                result = EXECUTE_COMMAND_ERROR;
+                LogError("Failed reading action %s from the schema", actionName);
+                result = JSON_DECODER_ERROR;
+            }
+            else if (AllocateLevel(&context->levels[0], NULL, argCount) != 0)
+            {
+                result = JSON_DECODER_ERROR;
             }
             else
             {
-                AGENT_DATA_TYPE* arguments = NULL;
+                size_t i;
 
-                if (argCount > 0)
+                for (i = 0; i < argCount; i++)
                 {
-                    arguments = (AGENT_DATA_TYPE*)malloc(sizeof(AGENT_DATA_TYPE)* argCount);
+                    SCHEMA_ACTION_ARGUMENT_HANDLE actionArgumentHandle;
+                    const char* argName;
+                    const char* argType;
+
+                    if (((actionArgumentHandle = Schema_GetModelActionArgumentByIndex(actionHandle, i)) == NULL) ||
+                        ((argName = Schema_GetActionArgumentName(actionArgumentHandle)) == NULL) ||
+                        ((argType = Schema_GetActionArgumentType(actionArgumentHandle)) == NULL))
+                    {
+                        /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+                        LogError("Failed getting the argument information from the schema");
+                        break;
+                    }
+                    else
+                    {
+                        SetSlot(&context->levels[0], i, argName, argType);
+                    }
                 }
 
-                if ((argCount > 0) &&
-                    (arguments == NULL))
+                if (i < argCount)
                 {
-                    /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
-                    LogError("Failed allocating arguments array");
-                    result = EXECUTE_COMMAND_ERROR;
+                    FreeLevel(&context->levels[0]);
+                    result = JSON_DECODER_ERROR;
                 }
                 else
                 {
-                    size_t i;
-                    size_t j;
-                    result = EXECUTE_COMMAND_ERROR;
+                    context->actionHandle = actionHandle;
+                    result = JSON_DECODER_OK;
+                }
+            }
+        }
+    }
 
-                    /* Codes_SRS_COMMAND_DECODER_99_011:[ CommandDecoder shall attempt to extract from the command text the value for each action argument.] */
-                    for (i = 0; i < argCount; i++)
-                    {
-                        SCHEMA_ACTION_ARGUMENT_HANDLE actionArgumentHandle;
-                        MULTITREE_HANDLE argumentNode;
-                        const char* argName;
-                        const char* argType;
-
-                        if (((actionArgumentHandle = Schema_GetModelActionArgumentByIndex(modelActionHandle, i)) == NULL) ||
-                            ((argName = Schema_GetActionArgumentName(actionArgumentHandle)) == NULL) ||
-                            ((argType = Schema_GetActionArgumentType(actionArgumentHandle)) == NULL))
-                        {
-                            LogError("Failed getting the argument information from the schema");
-                            result = EXECUTE_COMMAND_ERROR;
-                            break;
-                        }
-                        /* Codes_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
-                        /* Codes_SRS_COMMAND_DECODER_01_008: [Each argument shall be looked up as a field, member of the "Parameters" node.]  */
-                        else if (MultiTree_GetChildByName(parametersTreeNode, argName, &argumentNode) != MULTITREE_OK)
-                        {
-                            /* Codes_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-                            LogError("Missing argument %s", argName);
-                            result = EXECUTE_COMMAND_ERROR;
-                            break;
-                        }
-                        else if (DecodeValueFromNode(schemaHandle, &arguments[i], argumentNode, argType) != 0)
-                        {
-                            result = EXECUTE_COMMAND_ERROR;
-                            break;
-                        }
-                    }
+    return result;
+}
 
-                    if (i == argCount)
-                    {
-                        /* Codes_SRS_COMMAND_DECODER_99_005:[ If an Invoke Action is decoded successfully then the callback actionCallback shall be called, passing to it the callback action context, decoded name and arguments.] */
-                        result = commandDecoderInstance->ActionCallback(commandDecoderInstance->ActionCallbackContext, relativeActionPath, tempStr, argCount, arguments);
-                    }
+static JSON_DECODER_RESULT PushStructLevel(COMMAND_PARSE_CONTEXT* context, const char* typeName)
+{
+    JSON_DECODER_RESULT result;
+    SCHEMA_STRUCT_TYPE_HANDLE structTypeHandle;
+    size_t propertyCount;
 
-                    for (j = 0; j < i; j++)
-                    {
-                        Destroy_AGENT_DATA_TYPE(&arguments[j]);
-                    }
+    if (context->openLevels > COMMAND_DECODER_MAX_STRUCT_NESTING)
+    {
+        /* Codes_SRS_COMMAND_DECODER_02_008: [ If struct values are nested deeper than COMMAND_DECODER_MAX_STRUCT_NESTING levels then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+        LogError("Struct values nested deeper than %u levels", (unsigned int)COMMAND_DECODER_MAX_STRUCT_NESTING);
+        result = JSON_DECODER_ERROR;
+    }
+    /* Codes_SRS_COMMAND_DECODER_99_033:[ In order to determine which are the members of a complex types, Schema APIs for structure types shall be used.] */
+    else if (((structTypeHandle = Schema_GetStructTypeByName(context->schemaHandle, typeName)) == NULL) ||
+        (Schema_GetStructTypePropertyCount(structTypeHandle, &propertyCount) != SCHEMA_OK))
+    {
+        /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+        LogError("Getting Struct information failed.");
+        result = JSON_DECODER_ERROR;
+    }
+    else if (propertyCount == 0)
+    {
+        /* Codes_SRS_COMMAND_DECODER_99_034:[ If Schema APIs indicate that a complex type has 0 members then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+        LogError("Struct type with 0 members is not allowed");
+        result = JSON_DECODER_ERROR;
+    }
+    else
+    {
+        DECODE_LEVEL* level = &context->levels[context->openLevels];
 
-                    if (arguments != NULL)
-                    {
-                        free(arguments);
-                    }
+        if (AllocateLevel(level, typeName, propertyCount) != 0)
+        {
+            result = JSON_DECODER_ERROR;
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < propertyCount; i++)
+            {
+                SCHEMA_PROPERTY_HANDLE propertyHandle;
+                const char* propertyName;
+                const char* propertyType;
+
+                if (((propertyHandle = Schema_GetStructTypePropertyByIndex(structTypeHandle, i)) == NULL) ||
+                    ((propertyName = Schema_GetPropertyName(propertyHandle)) == NULL) ||
+                    ((propertyType = Schema_GetPropertyType(propertyHandle)) == NULL))
+                {
+                    /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+                    LogError("Getting the struct member information failed.");
+                    break;
+                }
+                else
+                {
+                    SetSlot(level, i, propertyName, propertyType);
                 }
             }
+
+            if (i < propertyCount)
+            {
+                FreeLevel(level);
+                result = JSON_DECODER_ERROR;
+            }
+            else
+            {
+                /* Codes_SRS_COMMAND_DECODER_99_032:[ Nesting shall be supported for complex type.] */
+                context->openLevels++;
+                result = JSON_DECODER_OK;
+            }
         }
     }
+
     return result;
 }
 
-static EXECUTE_COMMAND_RESULT ScanActionPathAndExecuteAction(COMMAND_DECODER_INSTANCE* commandDecoderInstance, SCHEMA_HANDLE schemaHandle, const char* actionPath, MULTITREE_HANDLE commandNode)
+static JSON_DECODER_RESULT PopLevel(COMMAND_PARSE_CONTEXT* context)
 {
-    EXECUTE_COMMAND_RESULT result;
-    char* relativeActionPath;
-    const char* actionName = actionPath;
-    SCHEMA_MODEL_TYPE_HANDLE modelHandle = commandDecoderInstance->ModelHandle;
+    JSON_DECODER_RESULT result;
+    DECODE_LEVEL* level = &context->levels[context->openLevels - 1];
 
-    /* Codes_SRS_COMMAND_DECODER_99_035:[ CommandDecoder_ExecuteCommand shall support paths to actions that are in child models (i.e. ChildModel/SomeAction.] */
-    do
+    if (!AreAllValuesDecoded(level))
+    {
+        /* Codes_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+        result = JSON_DECODER_ERROR;
+    }
+    else if (context->openLevels == 1)
     {
-        /* find the slash */
-        const char* slashPos = strchr(actionName, '/');
-        if (slashPos == NULL)
+        /*"Parameters" is complete, the arguments are kept for the dispatch*/
+        context->openLevels = 0;
+        result = JSON_DECODER_OK;
+    }
+    else
+    {
+        DECODE_LEVEL* parent = &context->levels[context->openLevels - 2];
+
+        /* Codes_SRS_COMMAND_DECODER_99_031:[ The complex type value that aggregates the children shall be built by using the Create_AGENT_DATA_TYPE_from_Members.] */
+        if (Create_AGENT_DATA_TYPE_from_Members(&parent->Values[parent->PendingIndex], level->TypeName, level->Count, (const char* const*)level->Names, level->Values) != AGENT_DATA_TYPES_OK)
+        {
+            /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+            LogError("Creating the agent data type from members failed.");
+            result = JSON_DECODER_ERROR;
+        }
+        else
         {
-            size_t relativeActionPathLength;
+            parent->Slots[parent->PendingIndex].IsDecoded = true;
+            parent->PendingIndex = parent->Count;
+            FreeLevel(level);
+            context->openLevels--;
+            result = JSON_DECODER_OK;
+        }
+    }
 
-            /* Codes_SRS_COMMAND_DECODER_99_037:[ The relative path passed to the actionCallback shall be in the format "childModel1/childModel2/.../childModelN".] */
-            if (actionName == actionPath)
+    return result;
+}
+
+static JSON_DECODER_RESULT DecodeValue(DECODE_LEVEL* level, const char* value, size_t valueLength)
+{
+    JSON_DECODER_RESULT result;
+    VALUE_SLOT* slot = &level->Slots[level->PendingIndex];
+
+    if (slot->PrimitiveType == EDM_NO_TYPE)
+    {
+        /* Codes_SRS_COMMAND_DECODER_02_009: [ If an argument of complex type does not have a JSON object value, or an argument of primitive type has a JSON object or array value, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+        LogError("Expected an object value for %s", level->Names[level->PendingIndex]);
+        result = JSON_DECODER_ERROR;
+    }
+    else
+    {
+        char valueBuffer[VALUE_BUFFER_SIZE];
+        char* valueString = (valueLength < VALUE_BUFFER_SIZE) ? valueBuffer : (char*)malloc(valueLength + 1);
+
+        if (valueString == NULL)
+        {
+            /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
+            LogError("Failed allocating a value of %u characters", (unsigned int)valueLength);
+            result = JSON_DECODER_ERROR;
+        }
+        else
+        {
+            (void)memcpy(valueString, value, valueLength);
+            valueString[valueLength] = '\0';
+
+            /* Codes_SRS_COMMAND_DECODER_99_027:[ The value for an argument of primitive type shall be decoded by using the CreateAgentDataType_From_String API.] */
+            if (CreateAgentDataType_From_String(valueString, slot->PrimitiveType, &level->Values[level->PendingIndex]) != AGENT_DATA_TYPES_OK)
             {
-                relativeActionPathLength = 0;
+                /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+                LogError("Failed parsing node %s.", valueString);
+                result = JSON_DECODER_ERROR;
             }
             else
             {
-                relativeActionPathLength = actionName - actionPath - 1;
+                slot->IsDecoded = true;
+                level->PendingIndex = level->Count;
+                result = JSON_DECODER_OK;
             }
 
-            relativeActionPath = (char*)malloc(relativeActionPathLength + 1);
-            if (relativeActionPath == NULL)
+            if (valueString != valueBuffer)
             {
-                /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
-                LogError("Failed allocating relative action path");
-                result = EXECUTE_COMMAND_ERROR;
+                free(valueString);
             }
-            else
-            {
-                strncpy(relativeActionPath, actionPath, relativeActionPathLength);
-                relativeActionPath[relativeActionPathLength] = 0;
+        }
+    }
 
-                /* no slash found, this must be an action */
-                result = DecodeAndExecuteModelAction(commandDecoderInstance, schemaHandle, modelHandle, relativeActionPath, actionName, commandNode);
+    return result;
+}
+
+static JSON_DECODER_RESULT OnObjectBegin(void* callbackContext, const char* position)
+{
+    JSON_DECODER_RESULT result = JSON_DECODER_OK;
+    COMMAND_PARSE_CONTEXT* context = (COMMAND_PARSE_CONTEXT*)callbackContext;
 
-                free(relativeActionPath);
-                actionName = NULL;
+    if (context->skipDepth > 0)
+    {
+        context->skipDepth++;
+    }
+    else if (!context->isInCommand)
+    {
+        context->isInCommand = true;
+    }
+    else if (context->openLevels == 0)
+    {
+        switch (context->pendingMember)
+        {
+        case COMMAND_MEMBER_NAME:
+            /* Codes_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+            LogError("Invalid action name.");
+            result = JSON_DECODER_ERROR;
+            break;
+        case COMMAND_MEMBER_PARAMETERS:
+            if (context->actionHandle != NULL)
+            {
+                /* Codes_SRS_COMMAND_DECODER_99_011:[ CommandDecoder shall attempt to extract the command arguments from the command JSON by looking them up under the node "Parameters".] */
+                context->openLevels = 1;
+            }
+            else
+            {
+                /* Codes_SRS_COMMAND_DECODER_02_003: [ If "Parameters" precedes "Name", CommandDecoder shall record where "Parameters" begins and ends and decode it with a second JSONDecoder_Parse once the action is known. ]*/
+                context->parametersBegin = position;
+                context->isRecordingParameters = true;
+                context->skipDepth = 1;
             }
             break;
+        default:
+            /* Codes_SRS_COMMAND_DECODER_02_006: [ Members that are not "Name", "Parameters", an action argument or a struct member shall be skipped. ]*/
+            context->skipDepth = 1;
+            break;
+        }
+        context->pendingMember = COMMAND_MEMBER_NONE;
+    }
+    else
+    {
+        DECODE_LEVEL* level = &context->levels[context->openLevels - 1];
+
+        if (level->PendingIndex == level->Count)
+        {
+            /* Codes_SRS_COMMAND_DECODER_02_006: [ Members that are not "Name", "Parameters", an action argument or a struct member shall be skipped. ]*/
+            context->skipDepth = 1;
+        }
+        else if (level->Slots[level->PendingIndex].PrimitiveType != EDM_NO_TYPE)
+        {
+            /* Codes_SRS_COMMAND_DECODER_02_009: [ If an argument of complex type does not have a JSON object value, or an argument of primitive type has a JSON object or array value, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+            LogError("Unexpected object value for %s", level->Names[level->PendingIndex]);
+            result = JSON_DECODER_ERROR;
         }
         else
         {
-            /* found a slash, get the child model name */
-            size_t modelLength = slashPos - actionName;
-            char* childModelName = (char*)malloc(modelLength + 1);
-            if (childModelName == NULL)
+            result = PushStructLevel(context, level->Slots[level->PendingIndex].TypeName);
+        }
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT OnObjectEnd(void* callbackContext, const char* position)
+{
+    JSON_DECODER_RESULT result = JSON_DECODER_OK;
+    COMMAND_PARSE_CONTEXT* context = (COMMAND_PARSE_CONTEXT*)callbackContext;
+
+    if (context->skipDepth > 0)
+    {
+        context->skipDepth--;
+        if ((context->skipDepth == 0) &&
+            context->isRecordingParameters)
+        {
+            context->parametersEnd = position;
+            context->isRecordingParameters = false;
+        }
+    }
+    else if (context->openLevels > 0)
+    {
+        result = PopLevel(context);
+    }
+    else
+    {
+        context->isInCommand = false;
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT OnArrayBegin(void* callbackContext, const char* position)
+{
+    JSON_DECODER_RESULT result = JSON_DECODER_OK;
+    COMMAND_PARSE_CONTEXT* context = (COMMAND_PARSE_CONTEXT*)callbackContext;
+    (void)position;
+
+    if (context->skipDepth > 0)
+    {
+        context->skipDepth++;
+    }
+    else if (!context->isInCommand)
+    {
+        /* Codes_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+        LogError("The command is not a JSON object");
+        result = JSON_DECODER_ERROR;
+    }
+    else if (context->openLevels == 0)
+    {
+        if (context->pendingMember == COMMAND_MEMBER_NAME)
+        {
+            /* Codes_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+            LogError("Invalid action name.");
+            result = JSON_DECODER_ERROR;
+        }
+        else
+        {
+            /*an array "Parameters" carries no arguments*/
+            context->skipDepth = 1;
+        }
+        context->pendingMember = COMMAND_MEMBER_NONE;
+    }
+    else
+    {
+        DECODE_LEVEL* level = &context->levels[context->openLevels - 1];
+
+        if (level->PendingIndex == level->Count)
+        {
+            /* Codes_SRS_COMMAND_DECODER_02_006: [ Members that are not "Name", "Parameters", an action argument or a struct member shall be skipped. ]*/
+            context->skipDepth = 1;
+        }
+        else
+        {
+            /* Codes_SRS_COMMAND_DECODER_02_009: [ If an argument of complex type does not have a JSON object value, or an argument of primitive type has a JSON object or array value, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+            LogError("Unexpected array value for %s", level->Names[level->PendingIndex]);
+            result = JSON_DECODER_ERROR;
+        }
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT OnArrayEnd(void* callbackContext, const char* position)
+{
+    COMMAND_PARSE_CONTEXT* context = (COMMAND_PARSE_CONTEXT*)callbackContext;
+    (void)position;
+
+    /*every array that is accepted is skipped*/
+    context->skipDepth--;
+
+    return JSON_DECODER_OK;
+}
+
+static JSON_DECODER_RESULT OnMemberName(void* callbackContext, const char* name, size_t nameLength)
+{
+    JSON_DECODER_RESULT result = JSON_DECODER_OK;
+    COMMAND_PARSE_CONTEXT* context = (COMMAND_PARSE_CONTEXT*)callbackContext;
+
+    if (context->skipDepth > 0)
+    {
+        /* nothing to do */
+    }
+    else if (context->openLevels == 0)
+    {
+        if ((nameLength == sizeof("Name") - 1) &&
+            (memcmp(name, "Name", nameLength) == 0))
+        {
+            context->pendingMember = COMMAND_MEMBER_NAME;
+            if (context->hasName)
             {
-                /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
-                LogError("Failed allocating child model name");
-                result = EXECUTE_COMMAND_ERROR;
-                break;
+                /* Codes_SRS_COMMAND_DECODER_02_005: [ If "Name", "Parameters", an action argument or a struct member appears more than once in the same object then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+                LogError("Duplicate Name member");
+                result = JSON_DECODER_ERROR;
             }
-            else
+            context->hasName = true;
+        }
+        else if ((nameLength == sizeof("Parameters") - 1) &&
+            (memcmp(name, "Parameters", nameLength) == 0))
+        {
+            context->pendingMember = COMMAND_MEMBER_PARAMETERS;
+            if (context->hasParameters)
             {
-                strncpy(childModelName, actionName, modelLength);
-                childModelName[modelLength] = 0;
+                /* Codes_SRS_COMMAND_DECODER_02_005: [ If "Name", "Parameters", an action argument or a struct member appears more than once in the same object then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+                LogError("Duplicate Parameters member");
+                result = JSON_DECODER_ERROR;
+            }
+            context->hasParameters = true;
+        }
+        else
+        {
+            context->pendingMember = COMMAND_MEMBER_OTHER;
+        }
+    }
+    else
+    {
+        DECODE_LEVEL* level = &context->levels[context->openLevels - 1];
+        size_t i;
 
-                /* find the model */
-                modelHandle = Schema_GetModelModelByName(modelHandle, childModelName);
-                if (modelHandle == NULL)
-                {
-                    /* Codes_SRS_COMMAND_DECODER_99_036:[ If a child model cannot be found by using Schema APIs then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-                    LogError("Getting the model %s failed", childModelName);
-                    free(childModelName);
-                    result = EXECUTE_COMMAND_ERROR;
-                    break;
-                }
-                else
-                {
-                    free(childModelName);
-                    actionName = slashPos + 1;
-                    result = EXECUTE_COMMAND_ERROR; /*this only exists to quench a compiler warning about returning an uninitialized variable, which is not possible by design*/
-                }
+        /* Codes_SRS_COMMAND_DECODER_01_008: [Each argument shall be looked up as a field, member of the "Parameters" node.] */
+        for (i = 0; i < level->Count; i++)
+        {
+            if ((level->Slots[i].NameLength == nameLength) &&
+                (memcmp(level->Names[i], name, nameLength) == 0))
+            {
+                break;
             }
         }
-    } while (actionName != NULL);
+
+        if ((i < level->Count) &&
+            level->Slots[i].IsDecoded)
+        {
+            /* Codes_SRS_COMMAND_DECODER_02_005: [ If "Name", "Parameters", an action argument or a struct member appears more than once in the same object then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+            LogError("Duplicate member %s", level->Names[i]);
+            result = JSON_DECODER_ERROR;
+        }
+        else
+        {
+            level->PendingIndex = i;
+        }
+    }
+
     return result;
 }
 
-static EXECUTE_COMMAND_RESULT DecodeCommand(COMMAND_DECODER_INSTANCE* commandDecoderInstance, MULTITREE_HANDLE commandNode)
+static JSON_DECODER_RESULT OnValue(void* callbackContext, const char* value, size_t valueLength)
 {
-    EXECUTE_COMMAND_RESULT result;
-    SCHEMA_HANDLE schemaHandle;
+    JSON_DECODER_RESULT result = JSON_DECODER_OK;
+    COMMAND_PARSE_CONTEXT* context = (COMMAND_PARSE_CONTEXT*)callbackContext;
 
-    /* Codes_SRS_COMMAND_DECODER_99_022:[ CommandDecoder shall use the Schema APIs to obtain the information about the entity set name and namespace] */
-    if ((schemaHandle = Schema_GetSchemaForModelType(commandDecoderInstance->ModelHandle)) == NULL)
+    if (context->skipDepth > 0)
     {
-        /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-        LogError("Getting schema information failed");
-        result = EXECUTE_COMMAND_ERROR;
+        /* nothing to do */
+    }
+    else if (context->openLevels == 0)
+    {
+        if (context->pendingMember == COMMAND_MEMBER_NAME)
+        {
+            result = ResolveAction(context, value, valueLength);
+        }
+        context->pendingMember = COMMAND_MEMBER_NONE;
     }
     else
     {
-        const char* actionName;
-        MULTITREE_HANDLE nameTreeNode;
+        DECODE_LEVEL* level = &context->levels[context->openLevels - 1];
 
-        /* Codes_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
-        /* Codes_SRS_COMMAND_DECODER_99_006:[ The action name shall be decoded from the element "name" of the command JSON.] */
-        if ((MultiTree_GetChildByName(commandNode, "Name", &nameTreeNode) != MULTITREE_OK) ||
-            (MultiTree_GetValue(nameTreeNode, (const void **)&actionName) != MULTITREE_OK))
+        if (level->PendingIndex < level->Count)
         {
-            /* Codes_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-            LogError("Getting action name failed.");
-            result = EXECUTE_COMMAND_ERROR;
+            result = DecodeValue(level, value, valueLength);
         }
-        else if (strlen(actionName) < 2)
+    }
+
+    return result;
+}
+
+static const JSON_DECODER_CALLBACKS commandCallbacks =
+{
+    OnObjectBegin,
+    OnObjectEnd,
+    OnArrayBegin,
+    OnArrayEnd,
+    OnMemberName,
+    OnValue
+};
+
+static EXECUTE_COMMAND_RESULT DecodeAndExecuteCommand(COMMAND_PARSE_CONTEXT* context, const char* command, size_t size)
+{
+    EXECUTE_COMMAND_RESULT result;
+
+    /* Codes_SRS_COMMAND_DECODER_02_001: [ CommandDecoder shall decode the command JSON with JSONDecoder_Parse directly from the command string, without copying it and without building a MultiTree. ]*/
+    if (JSONDecoder_Parse(command, size, &commandCallbacks, context) != JSON_DECODER_OK)
+    {
+        /* Codes_SRS_COMMAND_DECODER_01_013: [If parsing the JSON fails, the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+        LogError("Decoding the command JSON failed");
+        result = EXECUTE_COMMAND_ERROR;
+    }
+    else if (!context->hasName ||
+        !context->hasParameters)
+    {
+        /* Codes_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+        LogError("The command does not have both a Name and Parameters");
+        result = EXECUTE_COMMAND_ERROR;
+    }
+    else
+    {
+        if (context->parametersEnd != NULL)
         {
-            /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
-            LogError("Invalid action name.");
-            result = EXECUTE_COMMAND_ERROR;
+            /* Codes_SRS_COMMAND_DECODER_02_003: [ If "Parameters" precedes "Name", CommandDecoder shall record where "Parameters" begins and ends and decode it with a second JSONDecoder_Parse once the action is known. ]*/
+            context->isInCommand = true;
+            context->pendingMember = COMMAND_MEMBER_PARAMETERS;
+            if (JSONDecoder_Parse(context->parametersBegin, context->parametersEnd - context->parametersBegin, &commandCallbacks, context) != JSON_DECODER_OK)
+            {
+                LogError("Decoding the command Parameters failed");
+                result = EXECUTE_COMMAND_ERROR;
+            }
+            else
+            {
+                result = EXECUTE_COMMAND_SUCCESS;
+            }
         }
         else
         {
-            actionName++;
-            result = ScanActionPathAndExecuteAction(commandDecoderInstance, schemaHandle, actionName, commandNode);
+            result = EXECUTE_COMMAND_SUCCESS;
+        }
+
+        if (result == EXECUTE_COMMAND_SUCCESS)
+        {
+            if (!AreAllValuesDecoded(&context->levels[0]))
+            {
+                /* Codes_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+                result = EXECUTE_COMMAND_ERROR;
+            }
+            else
+            {
+                /* Codes_SRS_COMMAND_DECODER_02_010: [ The actionCallback shall be called only after the whole command has been decoded successfully. ]*/
+                /* Codes_SRS_COMMAND_DECODER_99_005:[ If an Invoke Action is decoded successfully then the callback actionCallback shall be called, passing to it the callback action context, decoded name and arguments.] */
+                result = context->commandDecoderInstance->ActionCallback(context->commandDecoderInstance->ActionCallbackContext, context->relativeActionPath, context->actionName, context->levels[0].Count, context->levels[0].Values);
+            }
         }
     }
+
     return result;
 }
 
@@ -435,7 +787,7 @@ EXECUTE_COMMAND_RESULT CommandDecoder_ExecuteCommand(COMMAND_DECODER_HANDLE hand
     else
     {
         size_t size = strlen(command);
-        char* commandJSON;
+        SCHEMA_HANDLE schemaHandle;
 
         /* Codes_SRS_COMMAND_DECODER_01_011: [If the size of the command is 0 then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
         if (
@@ -445,35 +797,44 @@ EXECUTE_COMMAND_RESULT CommandDecoder_ExecuteCommand(COMMAND_DECODER_HANDLE hand
             LogError("Failed because command size is zero");
             result = EXECUTE_COMMAND_ERROR;
         }
-        /*Codes_SRS_COMMAND_DECODER_01_013: [If parsing the JSON to a multi tree fails, the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-        else if ((commandJSON = (char*)malloc(size + 1)) == NULL)
+        /* Codes_SRS_COMMAND_DECODER_99_022:[ CommandDecoder shall use the Schema APIs to obtain the information about the entity set name and namespace] */
+        else if ((schemaHandle = Schema_GetSchemaForModelType(commandDecoderInstance->ModelHandle)) == NULL)
         {
-            LogError("Failed to allocate temporary storage for the commands JSON");
+            /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+            LogError("Getting schema information failed");
             result = EXECUTE_COMMAND_ERROR;
         }
         else
         {
-            MULTITREE_HANDLE commandsTree;
-
-            (void)memcpy(commandJSON, command, size);
-            commandJSON[size] = '\0';
-
-            /* Codes_SRS_COMMAND_DECODER_01_012: [CommandDecoder shall decode the command JSON contained in buffer to a multi-tree by using JSONDecoder_JSON_To_MultiTree.] */
-            if (JSONDecoder_JSON_To_MultiTree(commandJSON, &commandsTree) != JSON_DECODER_OK)
+            COMMAND_PARSE_CONTEXT context;
+            size_t i;
+
+            context.commandDecoderInstance = commandDecoderInstance;
+            context.schemaHandle = schemaHandle;
+            context.isInCommand = false;
+            context.pendingMember = COMMAND_MEMBER_NONE;
+            context.hasName = false;
+            context.hasParameters = false;
+            context.skipDepth = 0;
+            context.isRecordingParameters = false;
+            context.parametersBegin = NULL;
+            context.parametersEnd = NULL;
+            context.actionHandle = NULL;
+            context.relativeActionPath = NULL;
+            context.actionName = NULL;
+            context.openLevels = 0;
+
+            result = DecodeAndExecuteCommand(&context, command, size);
+
+            /* Codes_SRS_COMMAND_DECODER_02_011: [ All the decoded values shall be freed before CommandDecoder_ExecuteCommand returns. ]*/
+            for (i = context.openLevels; i > 1; i--)
             {
-                /* Codes_SRS_COMMAND_DECODER_01_013: [If parsing the JSON to a multi tree fails, the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-                LogError("Decoding JSON to a multi tree failed");
-                result = EXECUTE_COMMAND_ERROR;
+                FreeLevel(&context.levels[i - 1]);
             }
-            else
+            if (context.actionHandle != NULL)
             {
-                result = DecodeCommand(commandDecoderInstance, commandsTree);
-
-                /* Codes_SRS_COMMAND_DECODER_01_016: [CommandDecoder shall ensure that the multi-tree resulting from JSONDecoder_JSON_To_MultiTree is freed after the commands are executed.] */
-                MultiTree_Destroy(commandsTree);
+                FreeLevel(&context.levels[0]);
             }
-
-            free(commandJSON);
         }
     }
     return result;
@@ -0,0 +1,512 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "databatch.h"
+#include "agenttypesystem.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*the payload is freed by the application, with use_allocation_tags it is not accounted as memory of the serializer*/
+#ifdef IOTHUB_CLIENT_MALLOC_CALLER_OWNED
+#include "iothub_client_allocations.h"
+#else
+#define IOTHUB_CLIENT_MALLOC_CALLER_OWNED malloc
+#endif
+
+DEFINE_ENUM_STRINGS(DATA_BATCH_RESULT, DATA_BATCH_RESULT_VALUES);
+
+#define LOG_DATA_BATCH_ERROR \
+    LogError("(result = %s)", ENUM_TO_STRING(DATA_BATCH_RESULT, result));
+
+typedef struct DATA_BATCH_INSTANCE_TAG
+{
+    size_t ColumnCount;
+    char** ColumnNames;
+    size_t MaxSamples;
+    size_t SampleCount;
+    size_t FirstSample; /*index of the oldest row in the ring*/
+    bool DeltaEncoding;
+    AGENT_DATA_TYPE* Samples; /*MaxSamples rows of ColumnCount values each*/
+} DATA_BATCH_INSTANCE;
+
+/*returns the first value of the index-th oldest row*/
+static AGENT_DATA_TYPE* GetRow(DATA_BATCH_INSTANCE* dataBatchInstance, size_t index)
+{
+    return &dataBatchInstance->Samples[((dataBatchInstance->FirstSample + index) % dataBatchInstance->MaxSamples) * dataBatchInstance->ColumnCount];
+}
+
+static void DestroyRow(DATA_BATCH_INSTANCE* dataBatchInstance, AGENT_DATA_TYPE* row)
+{
+    size_t i;
+    for (i = 0; i < dataBatchInstance->ColumnCount; i++)
+    {
+        Destroy_AGENT_DATA_TYPE(&row[i]);
+    }
+}
+
+static void DestroyColumnNames(char** columnNames, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        free(columnNames[i]);
+    }
+    free(columnNames);
+}
+
+static bool GetIntegerValue(const AGENT_DATA_TYPE* value, int64_t* integerValue)
+{
+    bool result = true;
+    switch (value->type)
+    {
+        case EDM_BYTE_TYPE:
+            *integerValue = value->value.edmByte.value;
+            break;
+        case EDM_SBYTE_TYPE:
+            *integerValue = value->value.edmSbyte.value;
+            break;
+        case EDM_INT16_TYPE:
+            *integerValue = value->value.edmInt16.value;
+            break;
+        case EDM_INT32_TYPE:
+            *integerValue = value->value.edmInt32.value;
+            break;
+        case EDM_INT64_TYPE:
+            *integerValue = value->value.edmInt64.value;
+            break;
+        default:
+            result = false;
+            break;
+    }
+    return result;
+}
+
+/*days since 1970-01-01 of a proleptic Gregorian date, month is 1..12*/
+static int64_t DaysFromCivil(int64_t year, int64_t month, int64_t day)
+{
+    int64_t era;
+    int64_t yearOfEra;
+    int64_t dayOfYear;
+    int64_t dayOfEra;
+
+    year -= (month <= 2) ? 1 : 0;
+    era = ((year >= 0) ? year : year - 399) / 400;
+    yearOfEra = year - era * 400;
+    dayOfYear = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+    dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/*seconds since the UTC epoch, only used to compute differences between two timestamps*/
+static bool GetTimestampSeconds(const AGENT_DATA_TYPE* value, int64_t* seconds)
+{
+    bool result;
+    if ((value->type != EDM_DATE_TIME_OFFSET_TYPE) ||
+        (value->value.edmDateTimeOffset.hasFractionalSecond != 0))
+    {
+        /*fractional seconds would be lost by a delta expressed in seconds*/
+        result = false;
+    }
+    else
+    {
+        const EDM_DATE_TIME_OFFSET* dateTimeOffset = &value->value.edmDateTimeOffset;
+        int64_t days = DaysFromCivil((int64_t)dateTimeOffset->dateTime.tm_year + 1900, (int64_t)dateTimeOffset->dateTime.tm_mon + 1, dateTimeOffset->dateTime.tm_mday);
+        *seconds = days * 86400 + dateTimeOffset->dateTime.tm_hour * 3600 + dateTimeOffset->dateTime.tm_min * 60 + dateTimeOffset->dateTime.tm_sec;
+        if (dateTimeOffset->hasTimeZone != 0)
+        {
+            int64_t offsetMinutes = (int64_t)dateTimeOffset->timeZoneHour * 60 + ((dateTimeOffset->timeZoneHour < 0) ? -(int64_t)dateTimeOffset->timeZoneMinute : (int64_t)dateTimeOffset->timeZoneMinute);
+            *seconds -= offsetMinutes * 60;
+        }
+        result = true;
+    }
+    return result;
+}
+
+typedef bool(*GET_DELTA_VALUE)(const AGENT_DATA_TYPE* value, int64_t* deltaValue);
+
+/*a column is delta encoded only when all its samples can be turned into the same kind of integer*/
+static GET_DELTA_VALUE GetColumnDeltaFunction(DATA_BATCH_INSTANCE* dataBatchInstance, size_t column)
+{
+    GET_DELTA_VALUE result;
+    int64_t unused;
+
+    if (GetIntegerValue(&GetRow(dataBatchInstance, 0)[column], &unused))
+    {
+        result = GetIntegerValue;
+    }
+    else if (GetTimestampSeconds(&GetRow(dataBatchInstance, 0)[column], &unused))
+    {
+        result = GetTimestampSeconds;
+    }
+    else
+    {
+        result = NULL;
+    }
+
+    if (result != NULL)
+    {
+        size_t i;
+        for (i = 1; i < dataBatchInstance->SampleCount; i++)
+        {
+            if (!result(&GetRow(dataBatchInstance, i)[column], &unused))
+            {
+                result = NULL;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int ConcatInt64(STRING_HANDLE destination, int64_t value)
+{
+    int result;
+    AGENT_DATA_TYPE agentData;
+    if (Create_AGENT_DATA_TYPE_from_SINT64(&agentData, value) != AGENT_DATA_TYPES_OK)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = (AgentDataTypes_ToString(destination, &agentData) == AGENT_DATA_TYPES_OK) ? 0 : __LINE__;
+        Destroy_AGENT_DATA_TYPE(&agentData);
+    }
+    return result;
+}
+
+static DATA_BATCH_RESULT EncodeDeltaColumn(DATA_BATCH_INSTANCE* dataBatchInstance, size_t column, GET_DELTA_VALUE getDeltaValue, STRING_HANDLE payload)
+{
+    DATA_BATCH_RESULT result = DATA_BATCH_OK;
+    size_t i;
+    int64_t previous = 0;
+
+    if (STRING_concat(payload, "{") != 0)
+    {
+        result = DATA_BATCH_ERROR;
+    }
+    /*Codes_SRS_DATA_BATCH_02_020: [Timestamp columns shall be written as {"base":firstTimestamp,"delta":[...]} where the deltas are expressed in seconds and the first delta is 0.]*/
+    else if ((getDeltaValue == GetTimestampSeconds) &&
+        (
+            (STRING_concat(payload, "\"base\":") != 0) ||
+            (AgentDataTypes_ToString(payload, &GetRow(dataBatchInstance, 0)[column]) != AGENT_DATA_TYPES_OK) ||
+            (STRING_concat(payload, ", ") != 0) ||
+            (getDeltaValue(&GetRow(dataBatchInstance, 0)[column], &previous) != true)
+        ))
+    {
+        result = DATA_BATCH_AGENT_DATA_TYPES_ERROR;
+    }
+    else if (STRING_concat(payload, "\"delta\":[") != 0)
+    {
+        result = DATA_BATCH_ERROR;
+    }
+    else
+    {
+        /*Codes_SRS_DATA_BATCH_02_019: [Integer columns shall be written as {"delta":[...]} where each entry is the difference to the previous sample and the first entry is the difference to 0.]*/
+        for (i = 0; i < dataBatchInstance->SampleCount; i++)
+        {
+            int64_t current;
+            if (!getDeltaValue(&GetRow(dataBatchInstance, i)[column], &current))
+            {
+                result = DATA_BATCH_AGENT_DATA_TYPES_ERROR;
+                break;
+            }
+            /*differences are computed modulo 2^64 so that decoding with the same arithmetic is exact*/
+            else if (((i > 0) && (STRING_concat(payload, ",") != 0)) ||
+                (ConcatInt64(payload, (int64_t)((uint64_t)current - (uint64_t)previous)) != 0))
+            {
+                result = DATA_BATCH_ERROR;
+                break;
+            }
+            else
+            {
+                previous = current;
+            }
+        }
+
+        if ((i == dataBatchInstance->SampleCount) &&
+            (STRING_concat(payload, "]}") != 0))
+        {
+            result = DATA_BATCH_ERROR;
+        }
+    }
+
+    return result;
+}
+
+static DATA_BATCH_RESULT EncodeColumn(DATA_BATCH_INSTANCE* dataBatchInstance, size_t column, STRING_HANDLE payload)
+{
+    DATA_BATCH_RESULT result;
+    GET_DELTA_VALUE getDeltaValue = (dataBatchInstance->DeltaEncoding) ? GetColumnDeltaFunction(dataBatchInstance, column) : NULL;
+
+    if (getDeltaValue != NULL)
+    {
+        result = EncodeDeltaColumn(dataBatchInstance, column, getDeltaValue, payload);
+    }
+    /*Codes_SRS_DATA_BATCH_02_018: [Columns that are not delta encoded shall be written as a JSON array of the values, oldest sample first, each value being produced by AgentDataTypes_ToString.]*/
+    else if (STRING_concat(payload, "[") != 0)
+    {
+        result = DATA_BATCH_ERROR;
+    }
+    else
+    {
+        size_t i;
+        result = DATA_BATCH_OK;
+        for (i = 0; i < dataBatchInstance->SampleCount; i++)
+        {
+            if ((i > 0) && (STRING_concat(payload, ",") != 0))
+            {
+                result = DATA_BATCH_ERROR;
+                break;
+            }
+            else if (AgentDataTypes_ToString(payload, &GetRow(dataBatchInstance, i)[column]) != AGENT_DATA_TYPES_OK)
+            {
+                result = DATA_BATCH_AGENT_DATA_TYPES_ERROR;
+                break;
+            }
+        }
+
+        if ((i == dataBatchInstance->SampleCount) &&
+            (STRING_concat(payload, "]") != 0))
+        {
+            result = DATA_BATCH_ERROR;
+        }
+    }
+
+    return result;
+}
+
+DATA_BATCH_HANDLE DataBatch_Create(size_t columnCount, const char* const* columnNames, size_t maxSamples, bool deltaEncoding)
+{
+    DATA_BATCH_INSTANCE* result;
+
+    /*Codes_SRS_DATA_BATCH_02_002: [If columnCount or maxSamples is 0 or columnNames is NULL then DataBatch_Create shall fail and return NULL.]*/
+    if ((columnCount == 0) ||
+        (columnNames == NULL) ||
+        (maxSamples == 0) ||
+        /*Codes_SRS_DATA_BATCH_02_003: [If columnCount * maxSamples values cannot be represented in a size_t then DataBatch_Create shall fail and return NULL.]*/
+        ((SIZE_MAX / sizeof(AGENT_DATA_TYPE)) / columnCount < maxSamples))
+    {
+        result = NULL;
+        LogError("invalid arg size_t columnCount=%u, const char* const* columnNames=%p, size_t maxSamples=%u", (unsigned int)columnCount, columnNames, (unsigned int)maxSamples);
+    }
+    else if ((result = (DATA_BATCH_INSTANCE*)malloc(sizeof(DATA_BATCH_INSTANCE))) == NULL)
+    {
+        /*Codes_SRS_DATA_BATCH_02_006: [If any allocation fails then DataBatch_Create shall fail and return NULL.]*/
+        LogError("failure in malloc");
+    }
+    else if ((result->ColumnNames = (char**)malloc(sizeof(char*) * columnCount)) == NULL)
+    {
+        free(result);
+        result = NULL;
+        LogError("failure in malloc");
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < columnCount; i++)
+        {
+            /*Codes_SRS_DATA_BATCH_02_004: [DataBatch_Create shall make a copy of every column name.]*/
+            if ((columnNames[i] == NULL) ||
+                (mallocAndStrcpy_s(&result->ColumnNames[i], columnNames[i]) != 0))
+            {
+                break;
+            }
+        }
+
+        if (i < columnCount)
+        {
+            DestroyColumnNames(result->ColumnNames, i);
+            free(result);
+            result = NULL;
+            LogError("failure copying column name %u", (unsigned int)i);
+        }
+        /*Codes_SRS_DATA_BATCH_02_005: [DataBatch_Create shall allocate in one block the storage for maxSamples rows of columnCount values.]*/
+        else if ((result->Samples = (AGENT_DATA_TYPE*)malloc(sizeof(AGENT_DATA_TYPE) * columnCount * maxSamples)) == NULL)
+        {
+            DestroyColumnNames(result->ColumnNames, columnCount);
+            free(result);
+            result = NULL;
+            LogError("failure in malloc");
+        }
+        else
+        {
+            /*Codes_SRS_DATA_BATCH_02_007: [Otherwise DataBatch_Create shall succeed and return a non-NULL handle.]*/
+            result->ColumnCount = columnCount;
+            result->MaxSamples = maxSamples;
+            result->SampleCount = 0;
+            result->FirstSample = 0;
+            result->DeltaEncoding = deltaEncoding;
+        }
+    }
+
+    return result;
+}
+
+void DataBatch_Clear(DATA_BATCH_HANDLE dataBatchHandle)
+{
+    /*Codes_SRS_DATA_BATCH_02_022: [If dataBatchHandle is NULL then DataBatch_Clear shall do nothing.]*/
+    if (dataBatchHandle != NULL)
+    {
+        /*Codes_SRS_DATA_BATCH_02_023: [DataBatch_Clear shall destroy all the buffered samples.]*/
+        DATA_BATCH_INSTANCE* dataBatchInstance = (DATA_BATCH_INSTANCE*)dataBatchHandle;
+        size_t i;
+        for (i = 0; i < dataBatchInstance->SampleCount; i++)
+        {
+            DestroyRow(dataBatchInstance, GetRow(dataBatchInstance, i));
+        }
+        dataBatchInstance->SampleCount = 0;
+        dataBatchInstance->FirstSample = 0;
+    }
+}
+
+void DataBatch_Destroy(DATA_BATCH_HANDLE dataBatchHandle)
+{
+    /*Codes_SRS_DATA_BATCH_02_008: [If dataBatchHandle is NULL then DataBatch_Destroy shall do nothing.]*/
+    if (dataBatchHandle != NULL)
+    {
+        /*Codes_SRS_DATA_BATCH_02_009: [DataBatch_Destroy shall free all the buffered samples and all the resources used by the batch.]*/
+        DATA_BATCH_INSTANCE* dataBatchInstance = (DATA_BATCH_INSTANCE*)dataBatchHandle;
+        DataBatch_Clear(dataBatchInstance);
+        DestroyColumnNames(dataBatchInstance->ColumnNames, dataBatchInstance->ColumnCount);
+        free(dataBatchInstance->Samples);
+        free(dataBatchInstance);
+    }
+}
+
+DATA_BATCH_RESULT DataBatch_AppendSample(DATA_BATCH_HANDLE dataBatchHandle, AGENT_DATA_TYPE* values)
+{
+    DATA_BATCH_RESULT result;
+
+    /*Codes_SRS_DATA_BATCH_02_010: [If dataBatchHandle or values is NULL then DataBatch_AppendSample shall fail and return DATA_BATCH_INVALID_ARG.]*/
+    if ((dataBatchHandle == NULL) ||
+        (values == NULL))
+    {
+        result = DATA_BATCH_INVALID_ARG;
+        LOG_DATA_BATCH_ERROR;
+    }
+    else
+    {
+        DATA_BATCH_INSTANCE* dataBatchInstance = (DATA_BATCH_INSTANCE*)dataBatchHandle;
+
+        /*Codes_SRS_DATA_BATCH_02_011: [If the batch already holds maxSamples samples, the oldest sample shall be destroyed and its slot reused.]*/
+        if (dataBatchInstance->SampleCount == dataBatchInstance->MaxSamples)
+        {
+            DestroyRow(dataBatchInstance, GetRow(dataBatchInstance, 0));
+            dataBatchInstance->FirstSample = (dataBatchInstance->FirstSample + 1) % dataBatchInstance->MaxSamples;
+            dataBatchInstance->SampleCount--;
+        }
+
+        /*Codes_SRS_DATA_BATCH_02_012: [DataBatch_AppendSample shall move the columnCount values into the ring without copying their content; the values become owned by the batch.]*/
+        (void)memcpy(GetRow(dataBatchInstance, dataBatchInstance->SampleCount), values, sizeof(AGENT_DATA_TYPE) * dataBatchInstance->ColumnCount);
+        dataBatchInstance->SampleCount++;
+
+        /*Codes_SRS_DATA_BATCH_02_013: [On success DataBatch_AppendSample shall return DATA_BATCH_OK.]*/
+        result = DATA_BATCH_OK;
+    }
+
+    return result;
+}
+
+size_t DataBatch_GetSampleCount(DATA_BATCH_HANDLE dataBatchHandle)
+{
+    /*Codes_SRS_DATA_BATCH_02_014: [DataBatch_GetSampleCount shall return the number of buffered samples, or 0 if dataBatchHandle is NULL.]*/
+    return (dataBatchHandle == NULL) ? 0 : ((DATA_BATCH_INSTANCE*)dataBatchHandle)->SampleCount;
+}
+
+DATA_BATCH_RESULT DataBatch_Encode(DATA_BATCH_HANDLE dataBatchHandle, unsigned char** destination, size_t* destinationSize)
+{
+    DATA_BATCH_RESULT result;
+
+    /*Codes_SRS_DATA_BATCH_02_015: [If dataBatchHandle, destination or destinationSize is NULL then DataBatch_Encode shall fail and return DATA_BATCH_INVALID_ARG.]*/
+    if ((dataBatchHandle == NULL) ||
+        (destination == NULL) ||
+        (destinationSize == NULL))
+    {
+        result = DATA_BATCH_INVALID_ARG;
+        LOG_DATA_BATCH_ERROR;
+    }
+    else
+    {
+        DATA_BATCH_INSTANCE* dataBatchInstance = (DATA_BATCH_INSTANCE*)dataBatchHandle;
+        STRING_HANDLE payload;
+
+        if (dataBatchInstance->SampleCount == 0)
+        {
+            /*Codes_SRS_DATA_BATCH_02_016: [If there are no buffered samples then DataBatch_Encode shall return DATA_BATCH_EMPTY.]*/
+            result = DATA_BATCH_EMPTY;
+            LOG_DATA_BATCH_ERROR;
+        }
+        else if ((payload = STRING_construct("{")) == NULL)
+        {
+            result = DATA_BATCH_ERROR;
+            LOG_DATA_BATCH_ERROR;
+        }
+        else
+        {
+            size_t i;
+            result = DATA_BATCH_OK;
+
+            /*Codes_SRS_DATA_BATCH_02_017: [DataBatch_Encode shall produce a JSON object with one member per column, named after the column, in the order the columns were given to DataBatch_Create.]*/
+            for (i = 0; i < dataBatchInstance->ColumnCount; i++)
+            {
+                if (((i > 0) && (STRING_concat(payload, ", ") != 0)) ||
+                    (STRING_concat(payload, "\"") != 0) ||
+                    (STRING_concat(payload, dataBatchInstance->ColumnNames[i]) != 0) ||
+                    (STRING_concat(payload, "\":") != 0))
+                {
+                    result = DATA_BATCH_ERROR;
+                    LOG_DATA_BATCH_ERROR;
+                    break;
+                }
+                else if ((result = EncodeColumn(dataBatchInstance, i, payload)) != DATA_BATCH_OK)
+                {
+                    /*Codes_SRS_DATA_BATCH_02_024: [If encoding fails then DataBatch_Encode shall fail, keep the buffered samples and return DATA_BATCH_AGENT_DATA_TYPES_ERROR or DATA_BATCH_ERROR.]*/
+                    LOG_DATA_BATCH_ERROR;
+                    break;
+                }
+            }
+
+            if (result == DATA_BATCH_OK)
+            {
+                if (STRING_concat(payload, "}") != 0)
+                {
+                    result = DATA_BATCH_ERROR;
+                    LOG_DATA_BATCH_ERROR;
+                }
+                else
+                {
+                    size_t resultSize = STRING_length(payload);
+                    unsigned char* temp = (unsigned char*)IOTHUB_CLIENT_MALLOC_CALLER_OWNED(resultSize);
+                    if (temp == NULL)
+                    {
+                        result = DATA_BATCH_ERROR;
+                        LOG_DATA_BATCH_ERROR;
+                    }
+                    else
+                    {
+                        /*Codes_SRS_DATA_BATCH_02_021: [On success DataBatch_Encode shall copy the payload in *destination, its size in *destinationSize, clear all the buffered samples and return DATA_BATCH_OK.]*/
+                        (void)memcpy(temp, STRING_c_str(payload), resultSize);
+                        *destination = temp;
+                        *destinationSize = resultSize;
+                        DataBatch_Clear(dataBatchInstance);
+                    }
+                }
+            }
+
+            STRING_delete(payload);
+        }
+    }
+
+    return result;
+}
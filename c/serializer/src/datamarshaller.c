@@ -15,6 +15,13 @@
 #include "agenttypesystem.h"
 #include "azure_c_shared_utility/xlogging.h"
 
+/*the payload is freed by the application, with use_allocation_tags it is not accounted as memory of the serializer*/
+#ifdef IOTHUB_CLIENT_MALLOC_CALLER_OWNED
+#include "iothub_client_allocations.h"
+#else
+#define IOTHUB_CLIENT_MALLOC_CALLER_OWNED malloc
+#endif
+
 DEFINE_ENUM_STRINGS(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_RESULT_VALUES);
 
 #define LOG_DATA_MARSHALLER_ERROR \
@@ -196,7 +203,7 @@ DATA_MARSHALLER_RESULT DataMarshaller_SendData(DATA_MARSHALLER_HANDLE dataMarsha
                         {
                             /*Codes_SRS_DATAMARSHALLER_02_007: [DataMarshaller_SendData shall copy in the output parameters *destination, *destinationSize the content and the content length of the encoded JSON tree.] */
                             size_t resultSize = STRING_length(payload);
-                            unsigned char* temp = malloc(resultSize);
+                            unsigned char* temp = (unsigned char*)IOTHUB_CLIENT_MALLOC_CALLER_OWNED(resultSize);
                             if (temp == NULL)
                             {
                                 /*Codes_SRS_DATA_MARSHALLER_99_015:[ DATA_MARSHALLER_ERROR shall be returned in all the other error cases not explicitly defined here.]*/
@@ -30,19 +30,30 @@ typedef struct DATA_PUBLISHER_INSTANCE_TAG
 {
     DATA_MARSHALLER_HANDLE DataMarshallerHandle;
     SCHEMA_MODEL_TYPE_HANDLE ModelHandle;
+    size_t PropertyIdCount;
 } DATA_PUBLISHER_INSTANCE;
 
+/*one slot for every property id of the model*/
+typedef struct TRANSACTION_SLOT_TAG
+{
+    AGENT_DATA_TYPE Value;
+    size_t ValueIndex; /*position + 1 in Values, 0 when no value has been published for this property id*/
+} TRANSACTION_SLOT;
+
+/*a transaction is allocated as a single block: the header, PropertyIdCount slots and PropertyIdCount values*/
 typedef struct TRANSACTION_TAG
 {
     DATA_PUBLISHER_INSTANCE* DataPublisherInstance;
     size_t ValueCount;
     DATA_MARSHALLER_VALUE* Values;
+    TRANSACTION_SLOT Slots[1];
 } TRANSACTION;
 
 DATA_PUBLISHER_HANDLE DataPublisher_Create(SCHEMA_MODEL_TYPE_HANDLE modelHandle, bool includePropertyPath)
 {
     DATA_PUBLISHER_HANDLE result;
     DATA_PUBLISHER_INSTANCE* dataPublisherInstance;
+    SCHEMA_HANDLE schemaHandle;
 
     /* Codes_SRS_DATA_PUBLISHER_99_042:[ If a NULL argument is passed to it, DataPublisher_Create shall return NULL.] */
     if (
@@ -58,6 +69,18 @@ DATA_PUBLISHER_HANDLE DataPublisher_Create(SCHEMA_MODEL_TYPE_HANDLE modelHandle,
         result = NULL;
         LogError("(result = %s)", ENUM_TO_STRING(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_ERROR));
     }
+    /* Codes_SRS_DATA_PUBLISHER_02_008: [DataPublisher_Create shall freeze the schema of the model by calling Schema_GetSchemaForModelType and Schema_Freeze.] */
+    /* Codes_SRS_DATA_PUBLISHER_02_009: [DataPublisher_Create shall get the number of property ids of the model by calling Schema_GetModelPropertyIdCount.] */
+    else if (((schemaHandle = Schema_GetSchemaForModelType(modelHandle)) == NULL) ||
+        (Schema_Freeze(schemaHandle) != SCHEMA_OK) ||
+        (Schema_GetModelPropertyIdCount(modelHandle, &dataPublisherInstance->PropertyIdCount) != SCHEMA_OK))
+    {
+        free(dataPublisherInstance);
+
+        /* Codes_SRS_DATA_PUBLISHER_02_010: [If any of the Schema calls fails, DataPublisher_Create shall return NULL.] */
+        result = NULL;
+        LogError("(result = %s)", ENUM_TO_STRING(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_SCHEMA_FAILED));
+    }
     else
     {
         /* Codes_SRS_DATA_PUBLISHER_99_043:[ DataPublisher_Create shall initialize and hold a handle to a DataMarshaller instance.] */
@@ -105,17 +128,28 @@ TRANSACTION_HANDLE DataPublisher_StartTransaction(DATA_PUBLISHER_HANDLE dataPubl
     }
     else
     {
+        DATA_PUBLISHER_INSTANCE* dataPublisherInstance = (DATA_PUBLISHER_INSTANCE*)dataPublisherHandle;
+        size_t slotCount = (dataPublisherInstance->PropertyIdCount == 0) ? 1 : dataPublisherInstance->PropertyIdCount;
+
         /* Codes_SRS_DATA_PUBLISHER_99_007:[ A call to DataPublisher_StartTransaction shall start a new transaction.] */
-        transaction = (TRANSACTION*)malloc(sizeof(TRANSACTION));
+        /* Codes_SRS_DATA_PUBLISHER_02_011: [DataPublisher_StartTransaction shall allocate the transaction in one block that has room for one value for every property id of the model.] */
+        transaction = (TRANSACTION*)malloc(sizeof(TRANSACTION) + (slotCount - 1) * sizeof(TRANSACTION_SLOT) + slotCount * sizeof(DATA_MARSHALLER_VALUE));
         if (transaction == NULL)
         {
             LogError("Allocating transaction failed (Error code: %s)", ENUM_TO_STRING(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_ERROR));
         }
         else
         {
+            size_t i;
+
+            for (i = 0; i < slotCount; i++)
+            {
+                transaction->Slots[i].ValueIndex = 0;
+            }
+
             transaction->ValueCount = 0;
-            transaction->Values = NULL;
-            transaction->DataPublisherInstance = (DATA_PUBLISHER_INSTANCE*)dataPublisherHandle;
+            transaction->Values = (DATA_MARSHALLER_VALUE*)(transaction->Slots + slotCount);
+            transaction->DataPublisherInstance = dataPublisherInstance;
         }
     }
 
@@ -124,20 +158,19 @@ TRANSACTION_HANDLE DataPublisher_StartTransaction(DATA_PUBLISHER_HANDLE dataPubl
     return transaction;
 }
 
-DATA_PUBLISHER_RESULT DataPublisher_PublishTransacted(TRANSACTION_HANDLE transactionHandle, const char* propertyPath, const AGENT_DATA_TYPE* data)
+static DATA_PUBLISHER_RESULT GetTransactionSlot(TRANSACTION* transaction, const char* propertyPath, TRANSACTION_SLOT** slot)
 {
     DATA_PUBLISHER_RESULT result;
-    char* propertyPathCopy;
+    size_t propertyId;
 
-    /* Codes_SRS_DATA_PUBLISHER_99_017:[ When one or more NULL parameter(s) are specified, DataPublisher_PublishTransacted is called with a NULL transactionHandle, it shall return DATA_PUBLISHER_INVALID_ARG.] */
-    if ((transactionHandle == NULL) ||
-        (propertyPath == NULL) ||
-        (data == NULL))
+    /* Codes_SRS_DATA_PUBLISHER_02_012: [DataPublisher_PublishTransacted shall get the property id of propertyPath by calling Schema_GetModelPropertyIdByPath.] */
+    if (Schema_GetModelPropertyIdByPath(transaction->DataPublisherInstance->ModelHandle, propertyPath, &propertyId) != SCHEMA_OK)
     {
-        result = DATA_PUBLISHER_INVALID_ARG;
+        /* Codes_SRS_DATA_PUBLISHER_99_040:[ When propertyPath does not exist in the supplied model, DataPublisher_Publish shall return DATA_PUBLISHER_SCHEMA_FAILED without dispatching data.] */
+        result = DATA_PUBLISHER_SCHEMA_FAILED;
         LOG_DATA_PUBLISHER_ERROR;
     }
-    else if (mallocAndStrcpy_s(&propertyPathCopy, propertyPath) != 0)
+    else if (propertyId >= transaction->DataPublisherInstance->PropertyIdCount)
     {
         /* Codes_SRS_DATA_PUBLISHER_99_020:[ For any errors not explicitly mentioned here the DataPublisher APIs shall return DATA_PUBLISHER_ERROR.] */
         result = DATA_PUBLISHER_ERROR;
@@ -145,89 +178,86 @@ DATA_PUBLISHER_RESULT DataPublisher_PublishTransacted(TRANSACTION_HANDLE transac
     }
     else
     {
-        TRANSACTION* transaction = (TRANSACTION*)transactionHandle;
-        AGENT_DATA_TYPE* propertyValue;
+        *slot = &transaction->Slots[propertyId];
 
-        if (!Schema_ModelPropertyByPathExists(transaction->DataPublisherInstance->ModelHandle, propertyPath))
+        if ((*slot)->ValueIndex != 0)
         {
-            free(propertyPathCopy);
-
-            /* Codes_SRS_DATA_PUBLISHER_99_040:[ When propertyPath does not exist in the supplied model, DataPublisher_Publish shall return DATA_PUBLISHER_SCHEMA_FAILED without dispatching data.] */
-            result = DATA_PUBLISHER_SCHEMA_FAILED;
-            LOG_DATA_PUBLISHER_ERROR;
-        }
-        else if ((propertyValue = (AGENT_DATA_TYPE*)malloc(sizeof(AGENT_DATA_TYPE))) == NULL)
-        {
-            free(propertyPathCopy);
-
-            /* Codes_SRS_DATA_PUBLISHER_99_020:[ For any errors not explicitly mentioned here the DataPublisher APIs shall return DATA_PUBLISHER_ERROR.] */
-            result = DATA_PUBLISHER_ERROR;
-            LOG_DATA_PUBLISHER_ERROR;
-        }
-        else if (Create_AGENT_DATA_TYPE_from_AGENT_DATA_TYPE(propertyValue, data) != AGENT_DATA_TYPES_OK)
-        {
-            free(propertyPathCopy);
-            free(propertyValue);
-
-            /* Codes_SRS_DATA_PUBLISHER_99_028:[ If creating the copy fails then DATA_PUBLISHER_AGENT_DATA_TYPES_ERROR shall be returned.] */
-            result = DATA_PUBLISHER_AGENT_DATA_TYPES_ERROR;
-            LOG_DATA_PUBLISHER_ERROR;
+            result = DATA_PUBLISHER_OK;
         }
         else
         {
-            size_t i;
-            DATA_MARSHALLER_VALUE* propertySlot = NULL;
-
-            /* Codes_SRS_DATA_PUBLISHER_99_019:[ If the same property is associated twice with a transaction, then the last value shall be kept associated with the transaction.] */
-            for (i = 0; i < transaction->ValueCount; i++)
+            /* Codes_SRS_DATA_PUBLISHER_02_013: [The property path associated with the value shall be the one returned by Schema_GetModelPropertyPathById, no copy of propertyPath shall be made.] */
+            const char* schemaPropertyPath = Schema_GetModelPropertyPathById(transaction->DataPublisherInstance->ModelHandle, propertyId);
+            if (schemaPropertyPath == NULL)
             {
-                if (strcmp(transaction->Values[i].PropertyPath, propertyPath) == 0)
-                {
-                    propertySlot = &transaction->Values[i];
-                    break;
-                }
+                /* Codes_SRS_DATA_PUBLISHER_99_020:[ For any errors not explicitly mentioned here the DataPublisher APIs shall return DATA_PUBLISHER_ERROR.] */
+                result = DATA_PUBLISHER_ERROR;
+                LOG_DATA_PUBLISHER_ERROR;
             }
-
-            if (propertySlot == NULL)
+            else
             {
-                DATA_MARSHALLER_VALUE* newValues = (DATA_MARSHALLER_VALUE*)realloc(transaction->Values, sizeof(DATA_MARSHALLER_VALUE)* (transaction->ValueCount + 1));
-                if (newValues != NULL)
-                {
-                    transaction->Values = newValues;
-                    propertySlot = &transaction->Values[transaction->ValueCount];
-                    propertySlot->Value = NULL;
-                    propertySlot->PropertyPath = NULL;
-                    transaction->ValueCount++;
-                }
+                transaction->Values[transaction->ValueCount].PropertyPath = schemaPropertyPath;
+                transaction->Values[transaction->ValueCount].Value = &(*slot)->Value;
+                result = DATA_PUBLISHER_OK;
             }
+        }
+    }
 
-            if (propertySlot == NULL)
-            {
-                Destroy_AGENT_DATA_TYPE((AGENT_DATA_TYPE*)propertyValue);
-                free(propertyValue);
-                free(propertyPathCopy);
+    return result;
+}
 
-                /* Codes_SRS_DATA_PUBLISHER_99_020:[ For any errors not explicitly mentioned here the DataPublisher APIs shall return DATA_PUBLISHER_ERROR.] */
-                result = DATA_PUBLISHER_ERROR;
+static void StoreTransactionValue(TRANSACTION* transaction, TRANSACTION_SLOT* slot, const AGENT_DATA_TYPE* value)
+{
+    if (slot->ValueIndex == 0)
+    {
+        transaction->ValueCount++;
+        slot->ValueIndex = transaction->ValueCount;
+    }
+    else
+    {
+        /* Codes_SRS_DATA_PUBLISHER_99_019:[ If the same property is associated twice with a transaction, then the last value shall be kept associated with the transaction.] */
+        Destroy_AGENT_DATA_TYPE(&slot->Value);
+    }
+
+    slot->Value = *value;
+}
+
+DATA_PUBLISHER_RESULT DataPublisher_PublishTransacted(TRANSACTION_HANDLE transactionHandle, const char* propertyPath, const AGENT_DATA_TYPE* data)
+{
+    DATA_PUBLISHER_RESULT result;
+
+    /* Codes_SRS_DATA_PUBLISHER_99_017:[ When one or more NULL parameter(s) are specified, DataPublisher_PublishTransacted is called with a NULL transactionHandle, it shall return DATA_PUBLISHER_INVALID_ARG.] */
+    if ((transactionHandle == NULL) ||
+        (propertyPath == NULL) ||
+        (data == NULL))
+    {
+        result = DATA_PUBLISHER_INVALID_ARG;
+        LOG_DATA_PUBLISHER_ERROR;
+    }
+    else
+    {
+        TRANSACTION* transaction = (TRANSACTION*)transactionHandle;
+        TRANSACTION_SLOT* slot;
+
+        if ((result = GetTransactionSlot(transaction, propertyPath, &slot)) != DATA_PUBLISHER_OK)
+        {
+            /*error already logged*/
+        }
+        else
+        {
+            AGENT_DATA_TYPE propertyValue;
+
+            /* Codes_SRS_DATA_PUBLISHER_99_027:[ DataPublisher shall make a copy of the data when associating it with the transaction by using AgentTypeSystem APIs.] */
+            if (Create_AGENT_DATA_TYPE_from_AGENT_DATA_TYPE(&propertyValue, data) != AGENT_DATA_TYPES_OK)
+            {
+                /* Codes_SRS_DATA_PUBLISHER_99_028:[ If creating the copy fails then DATA_PUBLISHER_AGENT_DATA_TYPES_ERROR shall be returned.] */
+                result = DATA_PUBLISHER_AGENT_DATA_TYPES_ERROR;
                 LOG_DATA_PUBLISHER_ERROR;
             }
             else
             {
-                if (propertySlot->Value != NULL)
-                {
-                    Destroy_AGENT_DATA_TYPE((AGENT_DATA_TYPE*)propertySlot->Value);
-                    free((AGENT_DATA_TYPE*)propertySlot->Value);
-                }
-                if (propertySlot->PropertyPath != NULL)
-                {
-                    char* existingValue = (char*)propertySlot->PropertyPath;
-                    free(existingValue);
-                }
-
                 /* Codes_SRS_DATA_PUBLISHER_99_016:[ When DataPublisher_PublishTransacted is invoked, DataPublisher shall associate the data with the transaction identified by the transactionHandle argument and return DATA_PUBLISHER_OK. No data shall be dispatched at the time of the call.] */
-                propertySlot->PropertyPath = propertyPathCopy;
-                propertySlot->Value = propertyValue;
-
+                StoreTransactionValue(transaction, slot, &propertyValue);
                 result = DATA_PUBLISHER_OK;
             }
         }
@@ -236,6 +266,42 @@ DATA_PUBLISHER_RESULT DataPublisher_PublishTransacted(TRANSACTION_HANDLE transac
     return result;
 }
 
+DATA_PUBLISHER_RESULT DataPublisher_PublishTransactedMove(TRANSACTION_HANDLE transactionHandle, const char* propertyPath, AGENT_DATA_TYPE* data)
+{
+    DATA_PUBLISHER_RESULT result;
+
+    /* Codes_SRS_DATA_PUBLISHER_02_014: [If any of the arguments is NULL, DataPublisher_PublishTransactedMove shall return DATA_PUBLISHER_INVALID_ARG.] */
+    if ((transactionHandle == NULL) ||
+        (propertyPath == NULL) ||
+        (data == NULL))
+    {
+        result = DATA_PUBLISHER_INVALID_ARG;
+        LOG_DATA_PUBLISHER_ERROR;
+    }
+    else
+    {
+        TRANSACTION* transaction = (TRANSACTION*)transactionHandle;
+        TRANSACTION_SLOT* slot;
+
+        /* Codes_SRS_DATA_PUBLISHER_02_015: [DataPublisher_PublishTransactedMove shall find the slot of propertyPath the same way DataPublisher_PublishTransacted does and fail the same way when it cannot.] */
+        if ((result = GetTransactionSlot(transaction, propertyPath, &slot)) != DATA_PUBLISHER_OK)
+        {
+            /*error already logged*/
+        }
+        else
+        {
+            /* Codes_SRS_DATA_PUBLISHER_02_016: [DataPublisher_PublishTransactedMove shall take ownership of the content of data without copying it and shall set the type of data to EDM_NO_TYPE.] */
+            StoreTransactionValue(transaction, slot, data);
+            data->type = EDM_NO_TYPE;
+
+            /* Codes_SRS_DATA_PUBLISHER_02_017: [On success DataPublisher_PublishTransactedMove shall return DATA_PUBLISHER_OK.] */
+            result = DATA_PUBLISHER_OK;
+        }
+    }
+
+    return result;
+}
+
 DATA_PUBLISHER_RESULT DataPublisher_EndTransaction(TRANSACTION_HANDLE transactionHandle, unsigned char** destination, size_t* destinationSize)
 {
     DATA_PUBLISHER_RESULT result;
@@ -302,12 +368,9 @@ DATA_PUBLISHER_RESULT DataPublisher_CancelTransaction(TRANSACTION_HANDLE transac
         for (i = 0; i < transaction->ValueCount; i++)
         {
             Destroy_AGENT_DATA_TYPE((AGENT_DATA_TYPE*)transaction->Values[i].Value);
-            free((char*)transaction->Values[i].PropertyPath);
-            free((AGENT_DATA_TYPE*)transaction->Values[i].Value);
         }
 
         /* Codes_SRS_DATA_PUBLISHER_99_015:[ DataPublisher_CancelTransaction shall dispose of any resources associated with the transaction.] */
-        free(transaction->Values);
         free(transaction);
 
         /* Codes_SRS_DATA_PUBLISHER_99_013:[ A call to DataPublisher_CancelTransaction shall dispose of the transaction without dispatching 
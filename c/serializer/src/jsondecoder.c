@@ -14,10 +14,13 @@
 #include <stddef.h>
 
 #define IsWhiteSpace(A) (((A) == 0x20) || ((A) == 0x09) || ((A) == 0x0A) || ((A) == 0x0D))
+/* reading past the end of the input yields '\0', so the scanners below stop exactly as they would on a zero terminated string */
+#define CurrentChar(parserState) (((parserState)->json < (parserState)->end) ? *((parserState)->json) : '\0')
 
 typedef struct PARSER_STATE_TAG
 {
     char* json;
+    const char* end;
 } PARSER_STATE;
 
 static JSON_DECODER_RESULT ParseArray(PARSER_STATE* parserState, MULTITREE_HANDLE currentNode);
@@ -37,7 +40,7 @@ static int NOPCloneFunction(void** destination, const void* source)
 
 void SkipWhiteSpaces(PARSER_STATE* parserState)
 {
-    while ((*(parserState->json) != '\0') && IsWhiteSpace(*(parserState->json)))
+    while ((CurrentChar(parserState) != '\0') && IsWhiteSpace(CurrentChar(parserState)))
     {
         parserState->json++;
     }
@@ -49,7 +52,7 @@ static JSON_DECODER_RESULT ParseString(PARSER_STATE* parserState, char** stringB
     *stringBegin = parserState->json;
 
     /* Codes_SRS_JSON_DECODER_99_028:[ A string begins and ends with quotation marks.] */
-    if (*(parserState->json) != '"')
+    if (CurrentChar(parserState) != '"')
     {
         /* Codes_SRS_JSON_DECODER_99_007:[ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_PARSE_ERROR.] */
         result = JSON_DECODER_PARSE_ERROR;
@@ -57,30 +60,30 @@ static JSON_DECODER_RESULT ParseString(PARSER_STATE* parserState, char** stringB
     else
     {
         parserState->json++;
-        while ((*(parserState->json) != '"') && (*(parserState->json) != '\0'))
+        while ((CurrentChar(parserState) != '"') && (CurrentChar(parserState) != '\0'))
         {
             /* Codes_SRS_JSON_DECODER_99_030:[ Any character may be escaped.]  */
             /* Codes_SRS_JSON_DECODER_99_033:[ Alternatively, there are two-character sequence escape  representations of some popular characters.  So, for example, a string containing only a single reverse solidus character may be represented more compactly as "\\".] */
-            if (*(parserState->json) == '\\')
+            if (CurrentChar(parserState) == '\\')
             {
                 parserState->json++;
                 if (
                     /* Codes_SRS_JSON_DECODER_99_051:[ %x5C /          ; \    reverse solidus U+005C] */
-                    (*parserState->json == '\\') ||
+                    (CurrentChar(parserState) == '\\') ||
                     /* Codes_SRS_JSON_DECODER_99_050:[ %x22 /          ; "    quotation mark  U+0022] */
-                    (*parserState->json == '"') ||
+                    (CurrentChar(parserState) == '"') ||
                     /* Codes_SRS_JSON_DECODER_99_052:[ %x2F /          ; /    solidus         U+002F] */
-                    (*parserState->json == '/') ||
+                    (CurrentChar(parserState) == '/') ||
                     /* Codes_SRS_JSON_DECODER_99_053:[ %x62 /          ; b    backspace       U+0008] */
-                    (*parserState->json == 'b') ||
+                    (CurrentChar(parserState) == 'b') ||
                     /* Codes_SRS_JSON_DECODER_99_054:[ %x66 /          ; f    form feed       U+000C] */
-                    (*parserState->json == 'f') ||
+                    (CurrentChar(parserState) == 'f') ||
                     /* Codes_SRS_JSON_DECODER_99_055:[ %x6E /          ; n    line feed       U+000A] */
-                    (*parserState->json == 'n') ||
+                    (CurrentChar(parserState) == 'n') ||
                     /* Codes_SRS_JSON_DECODER_99_056:[ %x72 /          ; r    carriage return U+000D] */
-                    (*parserState->json == 'r') ||
+                    (CurrentChar(parserState) == 'r') ||
                     /* Codes_SRS_JSON_DECODER_99_057:[ %x74 /          ; t    tab             U+0009] */
-                    (*parserState->json == 't'))
+                    (CurrentChar(parserState) == 't'))
                 {
                     parserState->json++;
                 }
@@ -97,7 +100,7 @@ static JSON_DECODER_RESULT ParseString(PARSER_STATE* parserState, char** stringB
             }
         }
 
-        if (*(parserState->json) != '"')
+        if (CurrentChar(parserState) != '"')
         {
             /* Codes_SRS_JSON_DECODER_99_007:[ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_PARSE_ERROR.] */
             result = JSON_DECODER_PARSE_ERROR;
@@ -117,16 +120,16 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
     JSON_DECODER_RESULT result = JSON_DECODER_OK;
     size_t digitCount = 0;
 
-    if (*(parserState->json) == '-')
+    if (CurrentChar(parserState) == '-')
     {
         parserState->json++;
     }
 
     /* Codes_SRS_JSON_DECODER_99_043:[ A number contains an integer component that may be prefixed with an optional minus sign, which may be followed by a fraction part and/or an exponent part.] */
-    while (*(parserState->json) != '\0')
+    while (CurrentChar(parserState) != '\0')
     {
         /* Codes_SRS_JSON_DECODER_99_044:[ Octal and hex forms are not allowed.] */
-        if (isdigit(*(parserState->json)))
+        if (isdigit(CurrentChar(parserState)))
         {
             digitCount++;
             /* simply continue */
@@ -149,16 +152,16 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
     else
     {
         /* Codes_SRS_JSON_DECODER_99_046:[ A fraction part is a decimal point followed by one or more digits.] */
-        if (*(parserState->json) == '.')
+        if (CurrentChar(parserState) == '.')
         {
             /* optional fractional part */
             parserState->json++;
             digitCount = 0;
 
-            while (*(parserState->json) != '\0')
+            while (CurrentChar(parserState) != '\0')
             {
                 /* Codes_SRS_JSON_DECODER_99_044:[ Octal and hex forms are not allowed.] */
-                if (isdigit(*(parserState->json)))
+                if (isdigit(CurrentChar(parserState)))
                 {
                     digitCount++;
                     /* simply continue */
@@ -179,12 +182,12 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
         }
 
         /* Codes_SRS_JSON_DECODER_99_047:[ An exponent part begins with the letter E in upper or lowercase, which may be followed by a plus or minus sign.] */
-        if ((*(parserState->json) == 'e') || (*(parserState->json) == 'E'))
+        if ((CurrentChar(parserState) == 'e') || (CurrentChar(parserState) == 'E'))
         {
             parserState->json++;
 
             /* optional sign */
-            if ((*(parserState->json) == '-') || (*(parserState->json) == '+'))
+            if ((CurrentChar(parserState) == '-') || (CurrentChar(parserState) == '+'))
             {
                 parserState->json++;
             }
@@ -192,10 +195,10 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
             digitCount = 0;
 
             /* Codes_SRS_JSON_DECODER_99_048:[ The E and optional sign are followed by one or more digits.] */
-            while (*(parserState->json) != '\0')
+            while (CurrentChar(parserState) != '\0')
             {
                 /* Codes_SRS_JSON_DECODER_99_044:[ Octal and hex forms are not allowed.] */
-                if (isdigit(*(parserState->json)))
+                if (isdigit(CurrentChar(parserState)))
                 {
                     digitCount++;
                     /* simply continue */
@@ -219,53 +222,47 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
     return result;
 }
 
-static JSON_DECODER_RESULT ParseValue(PARSER_STATE* parserState, MULTITREE_HANDLE currentNode, char** stringBegin)
+static int IsLiteral(PARSER_STATE* parserState, const char* literal, size_t literalLength)
 {
-    JSON_DECODER_RESULT result;
+    return (((size_t)(parserState->end - parserState->json) >= literalLength) &&
+        (memcmp(parserState->json, literal, literalLength) == 0));
+}
 
-    SkipWhiteSpaces(parserState);
+/* parses a string, number or literal name; the scanned token is [*stringBegin, parserState->json) */
+static JSON_DECODER_RESULT ParseScalarValue(PARSER_STATE* parserState, char** stringBegin)
+{
+    JSON_DECODER_RESULT result;
 
-    if (*(parserState->json) == '"')
+    if (CurrentChar(parserState) == '"')
     {
         result = ParseString(parserState, stringBegin);
     }
     /* Codes_SRS_JSON_DECODER_99_018:[ A JSON value MUST be an object, array, number, or string, or one of the following three literal names: false null true] */
     /* Codes_SRS_JSON_DECODER_99_019:[ The literal names MUST be lowercase.] */
     /* Codes_SRS_JSON_DECODER_99_020:[ No other literal names are allowed.] */
-    else if (strncmp(parserState->json, "false", 5) == 0)
+    else if (IsLiteral(parserState, "false", 5))
     {
         *stringBegin = parserState->json;
         parserState->json += 5;
         result = JSON_DECODER_OK;
     }
-    else if (strncmp(parserState->json, "true", 4) == 0)
+    else if (IsLiteral(parserState, "true", 4))
     {
         *stringBegin = parserState->json;
         parserState->json += 4;
         result = JSON_DECODER_OK;
     }
-    else if (strncmp(parserState->json, "null", 4) == 0)
+    else if (IsLiteral(parserState, "null", 4))
     {
         *stringBegin = parserState->json;
         parserState->json += 4;
         result = JSON_DECODER_OK;
     }
-    /* Tests_SRS_JSON_DECODER_99_018:[ A JSON value MUST be an object, array, number, or string, or one of the following three literal names: false null true] */
-    else if (*(parserState->json) == '[')
-    {
-        result = ParseArray(parserState, currentNode);
-        *stringBegin = NULL;
-    }
-    else if (*(parserState->json) == '{')
-    {
-        result = ParseObject(parserState, currentNode);
-        *stringBegin = NULL;
-    }
     else if (
         (
-            isdigit(*(parserState->json))
+            isdigit(CurrentChar(parserState))
         )
-        || (*(parserState->json) == '-'))
+        || (CurrentChar(parserState) == '-'))
     {
         *stringBegin = parserState->json;
         result = ParseNumber(parserState);
@@ -279,13 +276,38 @@ static JSON_DECODER_RESULT ParseValue(PARSER_STATE* parserState, MULTITREE_HANDL
     return result;
 }
 
+static JSON_DECODER_RESULT ParseValue(PARSER_STATE* parserState, MULTITREE_HANDLE currentNode, char** stringBegin)
+{
+    JSON_DECODER_RESULT result;
+
+    SkipWhiteSpaces(parserState);
+
+    /* Tests_SRS_JSON_DECODER_99_018:[ A JSON value MUST be an object, array, number, or string, or one of the following three literal names: false null true] */
+    if (CurrentChar(parserState) == '[')
+    {
+        result = ParseArray(parserState, currentNode);
+        *stringBegin = NULL;
+    }
+    else if (CurrentChar(parserState) == '{')
+    {
+        result = ParseObject(parserState, currentNode);
+        *stringBegin = NULL;
+    }
+    else
+    {
+        result = ParseScalarValue(parserState, stringBegin);
+    }
+
+    return result;
+}
+
 static JSON_DECODER_RESULT ParseColon(PARSER_STATE* parserState)
 {
     JSON_DECODER_RESULT result;
 
     SkipWhiteSpaces(parserState);
     /* Codes_SRS_JSON_DECODER_99_023:[  A single colon comes after each name, separating the name from the value.] */
-    if (*(parserState->json) != ':')
+    if (CurrentChar(parserState) != ':')
     {
         /* Codes_SRS_JSON_DECODER_99_007:[ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_PARSE_ERROR.] */
         result = JSON_DECODER_PARSE_ERROR;
@@ -306,7 +328,7 @@ static JSON_DECODER_RESULT ParseOpenCurly(PARSER_STATE* parserState)
     SkipWhiteSpaces(parserState);
 
     /* Codes_SRS_JSON_DECODER_99_021:[    An object structure is represented as a pair of curly brackets surrounding zero or more name/value pairs (or members).] */
-    if (*(parserState->json) != '{')
+    if (CurrentChar(parserState) != '{')
     {
         /* Codes_SRS_JSON_DECODER_99_007:[ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_PARSE_ERROR.] */
         result = JSON_DECODER_PARSE_ERROR;
@@ -376,7 +398,7 @@ static JSON_DECODER_RESULT ParseObject(PARSER_STATE* parserState, MULTITREE_HAND
 
         SkipWhiteSpaces(parserState);
 
-        jsonChar = *(parserState->json);
+        jsonChar = CurrentChar(parserState);
         while ((jsonChar != '}') && (jsonChar != '\0'))
         {
             char* valueEnd;
@@ -391,7 +413,7 @@ static JSON_DECODER_RESULT ParseObject(PARSER_STATE* parserState, MULTITREE_HAND
             valueEnd = parserState->json;
 
             SkipWhiteSpaces(parserState);
-            jsonChar = *(parserState->json);
+            jsonChar = CurrentChar(parserState);
             *valueEnd = 0;
 
             /* Codes_SRS_JSON_DECODER_99_024:[ A single comma separates a value from a following name.] */
@@ -430,7 +452,7 @@ static JSON_DECODER_RESULT ParseArray(PARSER_STATE* parserState, MULTITREE_HANDL
     SkipWhiteSpaces(parserState);
 
     /* Codes_SRS_JSON_DECODER_99_026:[ An array structure is represented as square brackets surrounding zero or more values (or elements).] */
-    if (*(parserState->json) != '[')
+    if (CurrentChar(parserState) != '[')
     {
         /* Codes_SRS_JSON_DECODER_99_007:[ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_PARSE_ERROR.] */
         result = JSON_DECODER_PARSE_ERROR;
@@ -446,7 +468,7 @@ static JSON_DECODER_RESULT ParseArray(PARSER_STATE* parserState, MULTITREE_HANDL
 
         SkipWhiteSpaces(parserState);
 
-        jsonChar = *parserState->json;
+        jsonChar = CurrentChar(parserState);
         while ((jsonChar != ']') && (jsonChar != '\0'))
         {
             char arrayIndexStr[22];
@@ -489,7 +511,7 @@ static JSON_DECODER_RESULT ParseArray(PARSER_STATE* parserState, MULTITREE_HANDL
                 valueEnd = parserState->json;
 
                 SkipWhiteSpaces(parserState);
-                jsonChar = *(parserState->json);
+                jsonChar = CurrentChar(parserState);
                 *valueEnd = 0;
 
                 /* Codes_SRS_JSON_DECODER_99_027:[ Elements are separated by commas.] */
@@ -540,12 +562,12 @@ static JSON_DECODER_RESULT ParseObjectOrArray(PARSER_STATE* parserState, MULTITR
 
     SkipWhiteSpaces(parserState);
 
-    if (*(parserState->json) == '{')
+    if (CurrentChar(parserState) == '{')
     {
         result = ParseObject(parserState, currentNode);
         SkipWhiteSpaces(parserState);
     }
-    else if (*(parserState->json) == '[')
+    else if (CurrentChar(parserState) == '[')
     {
         result = ParseArray(parserState, currentNode);
         SkipWhiteSpaces(parserState);
@@ -557,7 +579,7 @@ static JSON_DECODER_RESULT ParseObjectOrArray(PARSER_STATE* parserState, MULTITR
     }
 
     if ((result == JSON_DECODER_OK) &&
-        (*(parserState->json) != '\0'))
+        (CurrentChar(parserState) != '\0'))
     {
         /* Codes_SRS_JSON_DECODER_99_007:[ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_PARSE_ERROR.] */
         result = JSON_DECODER_PARSE_ERROR;
@@ -571,6 +593,7 @@ static JSON_DECODER_RESULT ParseJSON(char* json, MULTITREE_HANDLE currentNode)
     /* Codes_SRS_JSON_DECODER_99_009:[ On success, JSONDecoder_JSON_To_MultiTree shall return a handle to the multi tree it created in the multiTreeHandle argument and it shall return JSON_DECODER_OK.] */
     PARSER_STATE parseState;
     parseState.json = json;
+    parseState.end = json + strlen(json);
     return ParseObjectOrArray(&parseState, currentNode);
 }
 
@@ -612,3 +635,206 @@ JSON_DECODER_RESULT JSONDecoder_JSON_To_MultiTree(char* json, MULTITREE_HANDLE*
 
     return result;
 }
+
+static JSON_DECODER_RESULT SaxParseValue(PARSER_STATE* parserState, const JSON_DECODER_CALLBACKS* callbacks, void* callbackContext);
+
+static JSON_DECODER_RESULT SaxParseObject(PARSER_STATE* parserState, const JSON_DECODER_CALLBACKS* callbacks, void* callbackContext)
+{
+    JSON_DECODER_RESULT result;
+    char jsonChar;
+
+    /* Codes_SRS_JSON_DECODER_02_005: [ OnObjectBegin and OnArrayBegin shall be called with a pointer to the '{' or '[' that opens the object or array. ]*/
+    result = (callbacks->OnObjectBegin == NULL) ? JSON_DECODER_OK : callbacks->OnObjectBegin(callbackContext, parserState->json);
+    parserState->json++;
+
+    SkipWhiteSpaces(parserState);
+    jsonChar = CurrentChar(parserState);
+
+    if ((result == JSON_DECODER_OK) &&
+        (jsonChar != '}'))
+    {
+        for (;;)
+        {
+            char* memberNameBegin;
+
+            SkipWhiteSpaces(parserState);
+
+            /* Codes_SRS_JSON_DECODER_99_022:[ A name is a string.] */
+            if ((result = ParseString(parserState, &memberNameBegin)) != JSON_DECODER_OK)
+            {
+                break;
+            }
+
+            /* Codes_SRS_JSON_DECODER_02_007: [ OnMemberName shall be called with a pointer to the first character of the member name and its length, the quotation marks excluded. ]*/
+            if ((callbacks->OnMemberName != NULL) &&
+                ((result = callbacks->OnMemberName(callbackContext, memberNameBegin + 1, parserState->json - memberNameBegin - 2)) != JSON_DECODER_OK))
+            {
+                break;
+            }
+
+            if (((result = ParseColon(parserState)) != JSON_DECODER_OK) ||
+                ((result = SaxParseValue(parserState, callbacks, callbackContext)) != JSON_DECODER_OK))
+            {
+                break;
+            }
+
+            SkipWhiteSpaces(parserState);
+            jsonChar = CurrentChar(parserState);
+
+            /* Codes_SRS_JSON_DECODER_99_024:[ A single comma separates a value from a following name.] */
+            if (jsonChar != ',')
+            {
+                break;
+            }
+            parserState->json++;
+        }
+    }
+
+    if (result == JSON_DECODER_OK)
+    {
+        if (jsonChar != '}')
+        {
+            /* Codes_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+            result = JSON_DECODER_PARSE_ERROR;
+        }
+        else
+        {
+            parserState->json++;
+
+            /* Codes_SRS_JSON_DECODER_02_006: [ OnObjectEnd and OnArrayEnd shall be called with a pointer to the character following the '}' or ']' that closes the object or array. ]*/
+            if (callbacks->OnObjectEnd != NULL)
+            {
+                result = callbacks->OnObjectEnd(callbackContext, parserState->json);
+            }
+        }
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT SaxParseArray(PARSER_STATE* parserState, const JSON_DECODER_CALLBACKS* callbacks, void* callbackContext)
+{
+    JSON_DECODER_RESULT result;
+    char jsonChar;
+
+    /* Codes_SRS_JSON_DECODER_02_005: [ OnObjectBegin and OnArrayBegin shall be called with a pointer to the '{' or '[' that opens the object or array. ]*/
+    result = (callbacks->OnArrayBegin == NULL) ? JSON_DECODER_OK : callbacks->OnArrayBegin(callbackContext, parserState->json);
+    parserState->json++;
+
+    SkipWhiteSpaces(parserState);
+    jsonChar = CurrentChar(parserState);
+
+    if ((result == JSON_DECODER_OK) &&
+        (jsonChar != ']'))
+    {
+        for (;;)
+        {
+            if ((result = SaxParseValue(parserState, callbacks, callbackContext)) != JSON_DECODER_OK)
+            {
+                break;
+            }
+
+            SkipWhiteSpaces(parserState);
+            jsonChar = CurrentChar(parserState);
+
+            /* Codes_SRS_JSON_DECODER_99_027:[ Elements are separated by commas.] */
+            if (jsonChar != ',')
+            {
+                break;
+            }
+            parserState->json++;
+        }
+    }
+
+    if (result == JSON_DECODER_OK)
+    {
+        if (jsonChar != ']')
+        {
+            /* Codes_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+            result = JSON_DECODER_PARSE_ERROR;
+        }
+        else
+        {
+            parserState->json++;
+
+            /* Codes_SRS_JSON_DECODER_02_006: [ OnObjectEnd and OnArrayEnd shall be called with a pointer to the character following the '}' or ']' that closes the object or array. ]*/
+            if (callbacks->OnArrayEnd != NULL)
+            {
+                result = callbacks->OnArrayEnd(callbackContext, parserState->json);
+            }
+        }
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT SaxParseValue(PARSER_STATE* parserState, const JSON_DECODER_CALLBACKS* callbacks, void* callbackContext)
+{
+    JSON_DECODER_RESULT result;
+
+    SkipWhiteSpaces(parserState);
+
+    if (CurrentChar(parserState) == '{')
+    {
+        result = SaxParseObject(parserState, callbacks, callbackContext);
+    }
+    else if (CurrentChar(parserState) == '[')
+    {
+        result = SaxParseArray(parserState, callbacks, callbackContext);
+    }
+    else
+    {
+        char* valueBegin;
+
+        if (((result = ParseScalarValue(parserState, &valueBegin)) == JSON_DECODER_OK) &&
+            (callbacks->OnValue != NULL))
+        {
+            /* Codes_SRS_JSON_DECODER_02_008: [ OnValue shall be called for every string, number and literal name with a pointer to the first character of the value and its length, quotation marks included for strings. ]*/
+            result = callbacks->OnValue(callbackContext, valueBegin, parserState->json - valueBegin);
+        }
+    }
+
+    return result;
+}
+
+JSON_DECODER_RESULT JSONDecoder_Parse(const char* json, size_t jsonLength, const JSON_DECODER_CALLBACKS* callbacks, void* callbackContext)
+{
+    JSON_DECODER_RESULT result;
+
+    if ((json == NULL) ||
+        (callbacks == NULL))
+    {
+        /* Codes_SRS_JSON_DECODER_02_001: [ If json or callbacks is NULL then JSONDecoder_Parse shall return JSON_DECODER_INVALID_ARG. ]*/
+        result = JSON_DECODER_INVALID_ARG;
+    }
+    else
+    {
+        /* Codes_SRS_JSON_DECODER_02_002: [ JSONDecoder_Parse shall parse the jsonLength characters at json without modifying them and without allocating memory. ]*/
+        PARSER_STATE parserState;
+        parserState.json = (char*)json; /* only read from in this path */
+        parserState.end = json + jsonLength;
+
+        SkipWhiteSpaces(&parserState);
+
+        /* Codes_SRS_JSON_DECODER_99_012:[ A JSON text is a serialized object or array.] */
+        if ((CurrentChar(&parserState) != '{') &&
+            (CurrentChar(&parserState) != '['))
+        {
+            /* Codes_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+            result = JSON_DECODER_PARSE_ERROR;
+        }
+        /* Codes_SRS_JSON_DECODER_02_003: [ JSONDecoder_Parse shall report the JSON structure by calling the callbacks in document order. Callbacks that are NULL shall be skipped. ]*/
+        /* Codes_SRS_JSON_DECODER_02_009: [ If a callback returns anything else than JSON_DECODER_OK then JSONDecoder_Parse shall stop parsing and return that value. ]*/
+        else if ((result = SaxParseValue(&parserState, callbacks, callbackContext)) == JSON_DECODER_OK)
+        {
+            SkipWhiteSpaces(&parserState);
+            if (parserState.json != parserState.end)
+            {
+                /* Codes_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+                result = JSON_DECODER_PARSE_ERROR;
+            }
+        }
+    }
+
+    return result;
+}
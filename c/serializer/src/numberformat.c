@@ -0,0 +1,449 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+
+#include <string.h>
+#include "numberformat.h"
+
+/*
+ * Shortest round-trip formatting of binary floating point numbers with the Grisu2 algorithm
+ * (Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010).
+ * The digits produced always parse back to the same value and are the shortest such digits for
+ * the vast majority of inputs. Only integer arithmetic is used, so the output does not depend on
+ * the current locale or on the printf implementation of the platform.
+ */
+
+typedef struct DIY_FP_TAG
+{
+    uint64_t f;
+    int e;
+} DIY_FP;
+
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint64_t POW10[] =
+{
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/*10^-348, 10^-340, ..., 10^340 normalized to a 64 bit significand*/
+static const uint64_t CACHED_POWERS_F[] =
+{
+    0xFA8FD5A0081C0288ULL, 0xBAAEE17FA23EBF76ULL, 0x8B16FB203055AC76ULL, 0xCF42894A5DCE35EAULL,
+    0x9A6BB0AA55653B2DULL, 0xE61ACF033D1A45DFULL, 0xAB70FE17C79AC6CAULL, 0xFF77B1FCBEBCDC4FULL,
+    0xBE5691EF416BD60CULL, 0x8DD01FAD907FFC3CULL, 0xD3515C2831559A83ULL, 0x9D71AC8FADA6C9B5ULL,
+    0xEA9C227723EE8BCBULL, 0xAECC49914078536DULL, 0x823C12795DB6CE57ULL, 0xC21094364DFB5637ULL,
+    0x9096EA6F3848984FULL, 0xD77485CB25823AC7ULL, 0xA086CFCD97BF97F4ULL, 0xEF340A98172AACE5ULL,
+    0xB23867FB2A35B28EULL, 0x84C8D4DFD2C63F3BULL, 0xC5DD44271AD3CDBAULL, 0x936B9FCEBB25C996ULL,
+    0xDBAC6C247D62A584ULL, 0xA3AB66580D5FDAF6ULL, 0xF3E2F893DEC3F126ULL, 0xB5B5ADA8AAFF80B8ULL,
+    0x87625F056C7C4A8BULL, 0xC9BCFF6034C13053ULL, 0x964E858C91BA2655ULL, 0xDFF9772470297EBDULL,
+    0xA6DFBD9FB8E5B88FULL, 0xF8A95FCF88747D94ULL, 0xB94470938FA89BCFULL, 0x8A08F0F8BF0F156BULL,
+    0xCDB02555653131B6ULL, 0x993FE2C6D07B7FACULL, 0xE45C10C42A2B3B06ULL, 0xAA242499697392D3ULL,
+    0xFD87B5F28300CA0EULL, 0xBCE5086492111AEBULL, 0x8CBCCC096F5088CCULL, 0xD1B71758E219652CULL,
+    0x9C40000000000000ULL, 0xE8D4A51000000000ULL, 0xAD78EBC5AC620000ULL, 0x813F3978F8940984ULL,
+    0xC097CE7BC90715B3ULL, 0x8F7E32CE7BEA5C70ULL, 0xD5D238A4ABE98068ULL, 0x9F4F2726179A2245ULL,
+    0xED63A231D4C4FB27ULL, 0xB0DE65388CC8ADA8ULL, 0x83C7088E1AAB65DBULL, 0xC45D1DF942711D9AULL,
+    0x924D692CA61BE758ULL, 0xDA01EE641A708DEAULL, 0xA26DA3999AEF774AULL, 0xF209787BB47D6B85ULL,
+    0xB454E4A179DD1877ULL, 0x865B86925B9BC5C2ULL, 0xC83553C5C8965D3DULL, 0x952AB45CFA97A0B3ULL,
+    0xDE469FBD99A05FE3ULL, 0xA59BC234DB398C25ULL, 0xF6C69A72A3989F5CULL, 0xB7DCBF5354E9BECEULL,
+    0x88FCF317F22241E2ULL, 0xCC20CE9BD35C78A5ULL, 0x98165AF37B2153DFULL, 0xE2A0B5DC971F303AULL,
+    0xA8D9D1535CE3B396ULL, 0xFB9B7CD9A4A7443CULL, 0xBB764C4CA7A44410ULL, 0x8BAB8EEFB6409C1AULL,
+    0xD01FEF10A657842CULL, 0x9B10A4E5E9913129ULL, 0xE7109BFBA19C0C9DULL, 0xAC2820D9623BF429ULL,
+    0x80444B5E7AA7CF85ULL, 0xBF21E44003ACDD2DULL, 0x8E679C2F5E44FF8FULL, 0xD433179D9C8CB841ULL,
+    0x9E19DB92B4E31BA9ULL, 0xEB96BF6EBADF77D9ULL, 0xAF87023B9BF0EE6BULL
+};
+
+static const int16_t CACHED_POWERS_E[] =
+{
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+};
+
+#define DIY_SIGNIFICAND_SIZE 64
+
+static DIY_FP DiyFp_Multiply(DIY_FP x, DIY_FP y)
+{
+    DIY_FP result;
+    const uint64_t M32 = 0xFFFFFFFFULL;
+    uint64_t a = x.f >> 32;
+    uint64_t b = x.f & M32;
+    uint64_t c = y.f >> 32;
+    uint64_t d = y.f & M32;
+    uint64_t ac = a * c;
+    uint64_t bc = b * c;
+    uint64_t ad = a * d;
+    uint64_t bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+    tmp += 1ULL << 31; /*round*/
+    result.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+    result.e = x.e + y.e + DIY_SIGNIFICAND_SIZE;
+    return result;
+}
+
+static DIY_FP DiyFp_Normalize(DIY_FP x)
+{
+    while ((x.f & (1ULL << 63)) == 0)
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+static DIY_FP GetCachedPower(int e, int* K)
+{
+    DIY_FP result;
+    /*the cached power c is chosen so that the exponent of w*c falls in [-60, -32]*/
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    size_t index;
+    if (dk - k > 0.0)
+    {
+        k++;
+    }
+    index = (size_t)((k >> 3) + 1);
+    *K = -(-348 + (int)(index << 3));
+    result.f = CACHED_POWERS_F[index];
+    result.e = CACHED_POWERS_E[index];
+    return result;
+}
+
+static void GrisuRound(char* buffer, size_t length, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t wpw)
+{
+    /*move the last digit closer to the exact value as long as the result stays in the rounding interval*/
+    while ((rest < wpw) &&
+        (delta - rest >= tenKappa) &&
+        ((rest + tenKappa < wpw) || (wpw - rest > rest + tenKappa - wpw)))
+    {
+        buffer[length - 1]--;
+        rest += tenKappa;
+    }
+}
+
+static unsigned int CountDecimalDigits32(uint32_t n)
+{
+    unsigned int result = 1;
+    while ((result < 10) && (n >= POW10[result]))
+    {
+        result++;
+    }
+    return result;
+}
+
+static size_t DigitGen(DIY_FP W, DIY_FP Mp, uint64_t delta, char* buffer, int* K)
+{
+    DIY_FP one;
+    uint64_t wpw = Mp.f - W.f;
+    uint32_t p1;
+    uint64_t p2;
+    int kappa;
+    size_t length = 0;
+
+    one.f = 1ULL << -Mp.e;
+    one.e = Mp.e;
+    p1 = (uint32_t)(Mp.f >> -one.e);
+    p2 = Mp.f & (one.f - 1);
+    kappa = (int)CountDecimalDigits32(p1);
+
+    /*integral part*/
+    while (kappa > 0)
+    {
+        uint32_t d = p1 / (uint32_t)POW10[kappa - 1];
+        p1 %= (uint32_t)POW10[kappa - 1];
+        if ((d != 0) || (length != 0))
+        {
+            buffer[length++] = (char)('0' + d);
+        }
+        kappa--;
+        {
+            uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+            if (rest <= delta)
+            {
+                *K += kappa;
+                GrisuRound(buffer, length, delta, rest, POW10[kappa] << -one.e, wpw);
+                return length;
+            }
+        }
+    }
+
+    /*fractional part*/
+    for (;;)
+    {
+        int index;
+        char d;
+        p2 *= 10;
+        delta *= 10;
+        d = (char)(p2 >> -one.e);
+        if ((d != 0) || (length != 0))
+        {
+            buffer[length++] = (char)('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta)
+        {
+            *K += kappa;
+            index = -kappa;
+            GrisuRound(buffer, length, delta, p2, one.f, (index < 20) ? wpw * POW10[index] : 0);
+            return length;
+        }
+    }
+}
+
+/*significand and exponent such that value == f * 2^e, for a binary format with significandBits explicit bits*/
+static size_t Grisu2(uint64_t f, int e, uint64_t hiddenBit, char* buffer, int* K)
+{
+    DIY_FP v;
+    DIY_FP plus;
+    DIY_FP minus;
+    DIY_FP cachedPower;
+    DIY_FP W;
+    DIY_FP Wp;
+    DIY_FP Wm;
+
+    v.f = f;
+    v.e = e;
+
+    /*boundaries m+ and m- are halfway to the next and previous representable values*/
+    plus.f = (v.f << 1) + 1;
+    plus.e = v.e - 1;
+    plus = DiyFp_Normalize(plus);
+    if (v.f == hiddenBit)
+    {
+        /*the previous representable value is closer when the significand is a power of 2*/
+        minus.f = (v.f << 2) - 1;
+        minus.e = v.e - 2;
+    }
+    else
+    {
+        minus.f = (v.f << 1) - 1;
+        minus.e = v.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    cachedPower = GetCachedPower(plus.e, K);
+    W = DiyFp_Multiply(DiyFp_Normalize(v), cachedPower);
+    Wp = DiyFp_Multiply(plus, cachedPower);
+    Wm = DiyFp_Multiply(minus, cachedPower);
+    /*be conservative: the multiplications are exact only to 1 ulp*/
+    Wm.f++;
+    Wp.f--;
+    return DigitGen(W, Wp, Wp.f - Wm.f, buffer, K);
+}
+
+static size_t WriteExponent(char* destination, int k)
+{
+    size_t length = 0;
+    destination[length++] = 'e';
+    if (k < 0)
+    {
+        destination[length++] = '-';
+        k = -k;
+    }
+    if (k >= 100)
+    {
+        destination[length++] = (char)('0' + k / 100);
+        k %= 100;
+        destination[length++] = DIGIT_PAIRS[k * 2];
+        destination[length++] = DIGIT_PAIRS[k * 2 + 1];
+    }
+    else if (k >= 10)
+    {
+        destination[length++] = DIGIT_PAIRS[k * 2];
+        destination[length++] = DIGIT_PAIRS[k * 2 + 1];
+    }
+    else
+    {
+        destination[length++] = (char)('0' + k);
+    }
+    return length;
+}
+
+/*turns the digits in buffer (value = digits * 10^k) into a JSON number, returns its length*/
+static size_t Prettify(char* buffer, size_t length, int k)
+{
+    int kk = (int)length + k; /*10^(kk-1) <= value < 10^kk*/
+    size_t result;
+
+    /*Codes_SRS_NUMBER_FORMAT_02_004: [If the decimal exponent of value is between -6 and 21 then the number shall be written in fixed notation with at least one digit after the decimal point for integral values (e.g. "100.0", "0.000125", "3.14").]*/
+    if ((k >= 0) && (kk <= 21))
+    {
+        /*1234e7 -> 12340000000.0*/
+        memset(buffer + length, '0', (size_t)k);
+        buffer[kk] = '.';
+        buffer[kk + 1] = '0';
+        result = (size_t)kk + 2;
+    }
+    else if ((0 < kk) && (kk <= 21))
+    {
+        /*1234e-2 -> 12.34*/
+        memmove(buffer + kk + 1, buffer + kk, length - (size_t)kk);
+        buffer[kk] = '.';
+        result = length + 1;
+    }
+    else if ((-6 < kk) && (kk <= 0))
+    {
+        /*1234e-6 -> 0.001234*/
+        size_t offset = (size_t)(2 - kk);
+        memmove(buffer + offset, buffer, length);
+        buffer[0] = '0';
+        buffer[1] = '.';
+        memset(buffer + 2, '0', offset - 2);
+        result = length + offset;
+    }
+    /*Codes_SRS_NUMBER_FORMAT_02_005: [Otherwise the number shall be written in exponential notation, with the exponent written without a '+' sign and without leading zeroes (e.g. "1e21", "1.5e-7", "2.2250738585072014e-308").]*/
+    else if (length == 1)
+    {
+        /*1e30*/
+        result = 1 + WriteExponent(buffer + 1, kk - 1);
+    }
+    else
+    {
+        /*1234e30 -> 1.234e33*/
+        memmove(buffer + 2, buffer + 1, length - 1);
+        buffer[1] = '.';
+        result = length + 1 + WriteExponent(buffer + length + 1, kk - 1);
+    }
+
+    buffer[result] = '\0';
+    return result;
+}
+
+static size_t FormatBinaryFloatingPoint(char* destination, int isNegative, uint64_t f, int e, uint64_t hiddenBit)
+{
+    size_t result;
+    char* digits = destination;
+
+    if (isNegative)
+    {
+        *digits++ = '-';
+    }
+
+    if (f == 0)
+    {
+        /*Codes_SRS_NUMBER_FORMAT_02_003: [If value is 0, NumberFormat_Double shall write "0.0" (or "-0.0" for negative zero).]*/
+        digits[0] = '0';
+        digits[1] = '.';
+        digits[2] = '0';
+        digits[3] = '\0';
+        result = 3;
+    }
+    else
+    {
+        int K;
+        size_t length = Grisu2(f, e, hiddenBit, digits, &K);
+        result = Prettify(digits, length, K);
+    }
+
+    return result + (isNegative ? 1 : 0);
+}
+
+size_t NumberFormat_Double(char* destination, double value)
+{
+    uint64_t bits;
+    uint64_t significand;
+    int biasedExponent;
+    const uint64_t hiddenBit = 1ULL << 52;
+
+    (void)memcpy(&bits, &value, sizeof(bits));
+    significand = bits & (hiddenBit - 1);
+    biasedExponent = (int)((bits >> 52) & 0x7FF);
+
+    /*NaN and infinities have no numeric representation, the caller shall handle them*/
+    /*Codes_SRS_NUMBER_FORMAT_02_002: [NumberFormat_Double shall write to destination a '\0' terminated decimal representation of value that strtod converts back to value and shall return the number of characters written, not counting the '\0'.]*/
+    return (biasedExponent == 0) ?
+        FormatBinaryFloatingPoint(destination, (bits >> 63) != 0, significand, 1 - 1075, hiddenBit) :
+        FormatBinaryFloatingPoint(destination, (bits >> 63) != 0, significand | hiddenBit, biasedExponent - 1075, hiddenBit);
+}
+
+size_t NumberFormat_Single(char* destination, float value)
+{
+    uint32_t bits;
+    uint64_t significand;
+    int biasedExponent;
+    const uint64_t hiddenBit = 1ULL << 23;
+
+    (void)memcpy(&bits, &value, sizeof(bits));
+    significand = bits & (uint32_t)(hiddenBit - 1);
+    biasedExponent = (int)((bits >> 23) & 0xFF);
+
+    /*Codes_SRS_NUMBER_FORMAT_02_006: [NumberFormat_Single shall write value following the same rules as NumberFormat_Double, except that the digits shall be those that strtof converts back to value.]*/
+    /*the boundaries are those of a float, so the digits are the shortest that read back as the same float*/
+    return (biasedExponent == 0) ?
+        FormatBinaryFloatingPoint(destination, (bits >> 31) != 0, significand, 1 - 150, hiddenBit) :
+        FormatBinaryFloatingPoint(destination, (bits >> 31) != 0, significand | hiddenBit, biasedExponent - 150, hiddenBit);
+}
+
+/*Codes_SRS_NUMBER_FORMAT_02_007: [NumberFormat_Int64 and NumberFormat_UInt64 shall write to destination the '\0' terminated decimal representation of value, with a leading '-' for negative values and no leading zeroes, and shall return the number of characters written, not counting the '\0'.]*/
+size_t NumberFormat_UInt64(char* destination, uint64_t value)
+{
+    char temp[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+    char* p = temp + sizeof(temp);
+    size_t result;
+
+    /*two digits at a time, from the least significant*/
+    while (value >= 100)
+    {
+        unsigned int pair = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        *--p = DIGIT_PAIRS[pair + 1];
+        *--p = DIGIT_PAIRS[pair];
+    }
+    if (value >= 10)
+    {
+        unsigned int pair = (unsigned int)value * 2;
+        *--p = DIGIT_PAIRS[pair + 1];
+        *--p = DIGIT_PAIRS[pair];
+    }
+    else
+    {
+        *--p = (char)('0' + value);
+    }
+
+    result = (size_t)(temp + sizeof(temp) - p);
+    (void)memcpy(destination, p, result);
+    destination[result] = '\0';
+    return result;
+}
+
+size_t NumberFormat_Int64(char* destination, int64_t value)
+{
+    size_t result;
+    if (value < 0)
+    {
+        destination[0] = '-';
+        /*Codes_SRS_NUMBER_FORMAT_02_008: [NumberFormat_Int64 shall write INT64_MIN as "-9223372036854775808".]*/
+        /*computed in unsigned arithmetic so that INT64_MIN does not overflow*/
+        result = 1 + NumberFormat_UInt64(destination + 1, (uint64_t)0 - (uint64_t)value);
+    }
+    else
+    {
+        result = NumberFormat_UInt64(destination, (uint64_t)value);
+    }
+    return result;
+}
@@ -15,6 +15,24 @@
 
 DEFINE_ENUM_STRINGS(SCHEMA_RESULT, SCHEMA_RESULT_VALUES);
 
+/*deepest chain of models in models that Schema_Freeze will resolve property paths for*/
+#define SCHEMA_MAX_MODEL_NESTING 32
+
+typedef struct NAME_INDEX_SLOT_TAG
+{
+    const char* name; /*NULL marks an empty slot*/
+    size_t nameLength;
+    size_t hash;
+    size_t position;
+} NAME_INDEX_SLOT;
+
+/*open addressing hash table from a name to the position of the element carrying that name, built by Schema_Freeze*/
+typedef struct NAME_INDEX_TAG
+{
+    NAME_INDEX_SLOT* slots;
+    size_t slotCount; /*0 or a power of 2, always at least twice the number of names*/
+} NAME_INDEX;
+
 typedef struct PROPERTY_TAG
 {
     const char* PropertyName;
@@ -50,6 +68,12 @@ typedef struct MODEL_TYPE_TAG
     size_t ActionCount;
     VECTOR_HANDLE models;
     size_t DeviceCount;
+    NAME_INDEX PropertyIndex;
+    NAME_INDEX ActionIndex;
+    NAME_INDEX ModelIndex;
+    NAME_INDEX PathIndex;
+    char** PropertyPaths; /*indexed by property id*/
+    size_t PropertyPathCount;
 } MODEL_TYPE;
 
 typedef struct STRUCT_TYPE_TAG
@@ -66,10 +90,154 @@ typedef struct SCHEMA_TAG
     size_t ModelTypeCount;
     SCHEMA_STRUCT_TYPE_HANDLE* StructTypes;
     size_t StructTypeCount;
+    NAME_INDEX ModelTypeIndex;
+    NAME_INDEX StructTypeIndex;
+    bool IsFrozen;
 } SCHEMA;
 
 static VECTOR_HANDLE g_schemas = NULL;
 
+/*FNV-1a, good enough for the short identifiers the schema holds*/
+static size_t HashName(const char* name, size_t nameLength)
+{
+    size_t result = (size_t)2166136261u;
+    size_t i;
+    for (i = 0; i < nameLength; i++)
+    {
+        result ^= (unsigned char)name[i];
+        result *= (size_t)16777619u;
+    }
+    return result;
+}
+
+static void InitializeNameIndex(NAME_INDEX* index)
+{
+    index->slots = NULL;
+    index->slotCount = 0;
+}
+
+static int CreateNameIndex(NAME_INDEX* index, size_t nameCount)
+{
+    int result;
+    if (nameCount == 0)
+    {
+        InitializeNameIndex(index);
+        result = 0;
+    }
+    else
+    {
+        size_t slotCount = 2;
+        while (slotCount < 2 * nameCount)
+        {
+            slotCount *= 2;
+        }
+
+        if ((index->slots = (NAME_INDEX_SLOT*)malloc(sizeof(NAME_INDEX_SLOT) * slotCount)) == NULL)
+        {
+            index->slotCount = 0;
+            result = __LINE__;
+            LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ERROR));
+        }
+        else
+        {
+            size_t i;
+            for (i = 0; i < slotCount; i++)
+            {
+                index->slots[i].name = NULL;
+            }
+            index->slotCount = slotCount;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/*the index has been created for at least as many names as are added, so there always is a free slot*/
+static void AddToNameIndex(NAME_INDEX* index, const char* name, size_t position)
+{
+    size_t nameLength = strlen(name);
+    size_t hash = HashName(name, nameLength);
+    size_t i = hash & (index->slotCount - 1);
+
+    while (index->slots[i].name != NULL)
+    {
+        i = (i + 1) & (index->slotCount - 1);
+    }
+
+    index->slots[i].name = name;
+    index->slots[i].nameLength = nameLength;
+    index->slots[i].hash = hash;
+    index->slots[i].position = position;
+}
+
+/*name does not need to be '\0' terminated, only the first nameLength characters are looked up*/
+static bool FindInNameIndex(const NAME_INDEX* index, const char* name, size_t nameLength, size_t* position)
+{
+    bool result = false;
+    if (index->slotCount > 0)
+    {
+        size_t hash = HashName(name, nameLength);
+        size_t i = hash & (index->slotCount - 1);
+
+        while (index->slots[i].name != NULL)
+        {
+            if ((index->slots[i].hash == hash) &&
+                (index->slots[i].nameLength == nameLength) &&
+                (memcmp(index->slots[i].name, name, nameLength) == 0))
+            {
+                *position = index->slots[i].position;
+                result = true;
+                break;
+            }
+            i = (i + 1) & (index->slotCount - 1);
+        }
+    }
+    return result;
+}
+
+static void DestroyNameIndex(NAME_INDEX* index)
+{
+    free(index->slots);
+    InitializeNameIndex(index);
+}
+
+static void DestroyModelIndexes(MODEL_TYPE* modelType)
+{
+    size_t i;
+
+    DestroyNameIndex(&modelType->PropertyIndex);
+    DestroyNameIndex(&modelType->ActionIndex);
+    DestroyNameIndex(&modelType->ModelIndex);
+    DestroyNameIndex(&modelType->PathIndex);
+
+    for (i = 0; i < modelType->PropertyPathCount; i++)
+    {
+        free(modelType->PropertyPaths[i]);
+    }
+    free(modelType->PropertyPaths);
+    modelType->PropertyPaths = NULL;
+    modelType->PropertyPathCount = 0;
+}
+
+static void DestroySchemaIndexes(SCHEMA* schema)
+{
+    size_t i;
+
+    for (i = 0; i < schema->ModelTypeCount; i++)
+    {
+        DestroyModelIndexes((MODEL_TYPE*)schema->ModelTypes[i]);
+    }
+
+    DestroyNameIndex(&schema->ModelTypeIndex);
+    DestroyNameIndex(&schema->StructTypeIndex);
+    schema->IsFrozen = false;
+}
+
+static bool IsModelFrozen(const MODEL_TYPE* modelType)
+{
+    return ((SCHEMA*)modelType->SchemaHandle)->IsFrozen;
+}
+
 static void DestroyProperty(SCHEMA_PROPERTY_HANDLE propertyHandle)
 {
     PROPERTY* propertyType = (PROPERTY*)propertyHandle;
@@ -130,6 +298,8 @@ static void DestroyModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle)
     MODEL_TYPE* modelType = (MODEL_TYPE*)modelTypeHandle;
     size_t i;
 
+    DestroyModelIndexes(modelType);
+
     free((void*)modelType->Name);
     modelType->Name = NULL;
 
@@ -170,6 +340,12 @@ static SCHEMA_RESULT AddModelProperty(MODEL_TYPE* modelType, const char* name, c
         result = SCHEMA_INVALID_ARG;
         LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
     }
+    /* Codes_SRS_SCHEMA_02_001: [ If the model type belongs to a frozen schema, Schema_AddModelProperty shall fail and return SCHEMA_ERROR. ]*/
+    else if (IsModelFrozen(modelType))
+    {
+        result = SCHEMA_ERROR;
+        LogError("cannot add property %s to a frozen schema", name);
+    }
     else
     {
         size_t i;
@@ -314,6 +490,9 @@ SCHEMA_HANDLE Schema_Create(const char* schemaNamespace)
             result->ModelTypeCount = 0;
             result->StructTypes = NULL;
             result->StructTypeCount = 0;
+            InitializeNameIndex(&result->ModelTypeIndex);
+            InitializeNameIndex(&result->StructTypeIndex);
+            result->IsFrozen = false;
         }
     }
 
@@ -388,6 +567,8 @@ void Schema_Destroy(SCHEMA_HANDLE schemaHandle)
         }
 
         free(schema->StructTypes);
+        DestroyNameIndex(&schema->ModelTypeIndex);
+        DestroyNameIndex(&schema->StructTypeIndex);
         free((void*)schema->Namespace);
         free(schema);
 
@@ -507,6 +688,12 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_CreateModelType(SCHEMA_HANDLE schemaHandle, cons
         result = NULL;
         LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_INVALID_ARG));
     }
+    /* Codes_SRS_SCHEMA_02_002: [ If the schema is frozen, Schema_CreateModelType shall fail and return NULL. ]*/
+    else if (((SCHEMA*)schemaHandle)->IsFrozen)
+    {
+        result = NULL;
+        LogError("cannot add model %s to a frozen schema", modelName);
+    }
     else
     {
         SCHEMA* schema = (SCHEMA*)schemaHandle;
@@ -566,6 +753,12 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_CreateModelType(SCHEMA_HANDLE schemaHandle, cons
                     modelType->SchemaHandle = schemaHandle;
                     modelType->DeviceCount = 0;
                     modelType->models = VECTOR_create(sizeof(MODEL_IN_MODEL) );
+                    InitializeNameIndex(&modelType->PropertyIndex);
+                    InitializeNameIndex(&modelType->ActionIndex);
+                    InitializeNameIndex(&modelType->ModelIndex);
+                    InitializeNameIndex(&modelType->PathIndex);
+                    modelType->PropertyPaths = NULL;
+                    modelType->PropertyPathCount = 0;
                     schema->ModelTypes[schema->ModelTypeCount] = modelType;
                     schema->ModelTypeCount++;
 
@@ -629,6 +822,12 @@ SCHEMA_ACTION_HANDLE Schema_CreateModelAction(SCHEMA_MODEL_TYPE_HANDLE modelType
         result = NULL;
         LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_INVALID_ARG));
     }
+    /* Codes_SRS_SCHEMA_02_003: [ If the model type belongs to a frozen schema, Schema_CreateModelAction shall fail and return NULL. ]*/
+    else if (IsModelFrozen((MODEL_TYPE*)modelTypeHandle))
+    {
+        result = NULL;
+        LogError("cannot add action %s to a frozen schema", actionName);
+    }
     else
     {
         MODEL_TYPE* modelType = (MODEL_TYPE*)modelTypeHandle;
@@ -827,12 +1026,23 @@ SCHEMA_PROPERTY_HANDLE Schema_GetModelPropertyByName(SCHEMA_MODEL_TYPE_HANDLE mo
         MODEL_TYPE* modelType = (MODEL_TYPE*)modelTypeHandle;
 
         /* Codes_SRS_SCHEMA_99_036:[Schema_GetModelPropertyByName shall return a non-NULL SCHEMA_PROPERTY_HANDLE corresponding to the model type identified by modelTypeHandle and matching the propertyName argument value.] */
-        for (i = 0; i < modelType->PropertyCount; i++)
+        if (IsModelFrozen(modelType))
         {
-            PROPERTY* modelProperty = (PROPERTY*)modelType->Properties[i];
-            if (strcmp(modelProperty->PropertyName, propertyName) == 0)
+            /* Codes_SRS_SCHEMA_02_013: [ Once the schema is frozen, Schema_GetModelPropertyByName, Schema_GetModelActionByName, Schema_GetModelModelByName, Schema_GetModelByName and Schema_GetStructTypeByName shall find the element through the hash indexes built by Schema_Freeze instead of comparing the name with every element. ]*/
+            if (!FindInNameIndex(&modelType->PropertyIndex, propertyName, strlen(propertyName), &i))
             {
-                break;
+                i = modelType->PropertyCount;
+            }
+        }
+        else
+        {
+            for (i = 0; i < modelType->PropertyCount; i++)
+            {
+                PROPERTY* modelProperty = (PROPERTY*)modelType->Properties[i];
+                if (strcmp(modelProperty->PropertyName, propertyName) == 0)
+                {
+                    break;
+                }
             }
         }
 
@@ -915,12 +1125,23 @@ SCHEMA_ACTION_HANDLE Schema_GetModelActionByName(SCHEMA_MODEL_TYPE_HANDLE modelT
         MODEL_TYPE* modelType = (MODEL_TYPE*)modelTypeHandle;
 
         /* Codes_SRS_SCHEMA_99_040:[Schema_GetModelActionByName shall return a non-NULL SCHEMA_ACTION_HANDLE corresponding to the model type identified by modelTypeHandle and matching the actionName argument value.] */
-        for (i = 0; i < modelType->ActionCount; i++)
+        if (IsModelFrozen(modelType))
         {
-            ACTION* modelAction = (ACTION*)modelType->Actions[i];
-            if (strcmp(modelAction->ActionName, actionName) == 0)
+            /* Codes_SRS_SCHEMA_02_013: [ Once the schema is frozen, Schema_GetModelPropertyByName, Schema_GetModelActionByName, Schema_GetModelModelByName, Schema_GetModelByName and Schema_GetStructTypeByName shall find the element through the hash indexes built by Schema_Freeze instead of comparing the name with every element. ]*/
+            if (!FindInNameIndex(&modelType->ActionIndex, actionName, strlen(actionName), &i))
             {
-                break;
+                i = modelType->ActionCount;
+            }
+        }
+        else
+        {
+            for (i = 0; i < modelType->ActionCount; i++)
+            {
+                ACTION* modelAction = (ACTION*)modelType->Actions[i];
+                if (strcmp(modelAction->ActionName, actionName) == 0)
+                {
+                    break;
+                }
             }
         }
 
@@ -1144,6 +1365,12 @@ SCHEMA_STRUCT_TYPE_HANDLE Schema_CreateStructType(SCHEMA_HANDLE schemaHandle, co
         result = NULL;
         LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_INVALID_ARG));
     }
+    /* Codes_SRS_SCHEMA_02_004: [ If the schema is frozen, Schema_CreateStructType shall fail and return NULL. ]*/
+    else if (schema->IsFrozen)
+    {
+        result = NULL;
+        LogError("cannot add struct type %s to a frozen schema", typeName);
+    }
     else
     {
         STRUCT_TYPE* structType;
@@ -1282,12 +1509,23 @@ SCHEMA_STRUCT_TYPE_HANDLE Schema_GetStructTypeByName(SCHEMA_HANDLE schemaHandle,
         size_t i;
 
         /* Codes_SRS_SCHEMA_99_068:[Schema_GetStructTypeByName shall return a non-NULL handle corresponding to the struct type identified by the structTypeName in the schemaHandle schema.] */
-        for (i = 0; i < schema->StructTypeCount; i++)
+        if (schema->IsFrozen)
         {
-            STRUCT_TYPE* structType = (STRUCT_TYPE*)schema->StructTypes[i];
-            if (strcmp(structType->Name, name) == 0)
+            /* Codes_SRS_SCHEMA_02_013: [ Once the schema is frozen, Schema_GetModelPropertyByName, Schema_GetModelActionByName, Schema_GetModelModelByName, Schema_GetModelByName and Schema_GetStructTypeByName shall find the element through the hash indexes built by Schema_Freeze instead of comparing the name with every element. ]*/
+            if (!FindInNameIndex(&schema->StructTypeIndex, name, strlen(name), &i))
             {
-                break;
+                i = schema->StructTypeCount;
+            }
+        }
+        else
+        {
+            for (i = 0; i < schema->StructTypeCount; i++)
+            {
+                STRUCT_TYPE* structType = (STRUCT_TYPE*)schema->StructTypes[i];
+                if (strcmp(structType->Name, name) == 0)
+                {
+                    break;
+                }
             }
         }
 
@@ -1595,12 +1833,23 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelByName(SCHEMA_HANDLE schemaHandle, const
         /* Codes_SRS_SCHEMA_99_124: [Schema_GetModelByName shall return a non-NULL SCHEMA_MODEL_TYPE_HANDLE corresponding to the model identified by schemaHandle and matching the modelName argument value.] */
         SCHEMA* schema = (SCHEMA*)schemaHandle;
         size_t i;
-        for (i = 0; i < schema->ModelTypeCount; i++)
+        if (schema->IsFrozen)
         {
-            MODEL_TYPE* modelType = (MODEL_TYPE*)schema->ModelTypes[i];
-            if (strcmp(modelName, modelType->Name)==0)
+            /* Codes_SRS_SCHEMA_02_013: [ Once the schema is frozen, Schema_GetModelPropertyByName, Schema_GetModelActionByName, Schema_GetModelModelByName, Schema_GetModelByName and Schema_GetStructTypeByName shall find the element through the hash indexes built by Schema_Freeze instead of comparing the name with every element. ]*/
+            if (!FindInNameIndex(&schema->ModelTypeIndex, modelName, strlen(modelName), &i))
             {
-                break;
+                i = schema->ModelTypeCount;
+            }
+        }
+        else
+        {
+            for (i = 0; i < schema->ModelTypeCount; i++)
+            {
+                MODEL_TYPE* modelType = (MODEL_TYPE*)schema->ModelTypes[i];
+                if (strcmp(modelName, modelType->Name)==0)
+                {
+                    break;
+                }
             }
         }
         if (i == schema->ModelTypeCount)
@@ -1669,6 +1918,12 @@ SCHEMA_RESULT Schema_AddModelModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, con
         result = SCHEMA_INVALID_ARG;
         LogError("(Error code: %s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_INVALID_ARG));
     }
+    /* Codes_SRS_SCHEMA_02_005: [ If the model type identified by modelTypeHandle belongs to a frozen schema, Schema_AddModelModel shall fail and return SCHEMA_ERROR. ]*/
+    else if (IsModelFrozen((MODEL_TYPE*)modelTypeHandle))
+    {
+        result = SCHEMA_ERROR;
+        LogError("cannot add model %s to a frozen schema", propertyName);
+    }
     else
     {
         MODEL_TYPE* parentModel = (MODEL_TYPE*)modelTypeHandle;
@@ -1743,7 +1998,17 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelModelByName(SCHEMA_MODEL_TYPE_HANDLE mod
         MODEL_TYPE* model = (MODEL_TYPE*)modelTypeHandle;
         /*Codes_SRS_SCHEMA_99_170: [Schema_GetModelModelByName shall return a handle to the model identified by the property with the name propertyName in the model identified by the handle modelTypeHandle.]*/
         /*Codes_SRS_SCHEMA_99_171: [If Schema_GetModelModelByName is unable to provide the handle it shall return NULL.]*/
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        void* temp;
+        size_t i;
+        if (IsModelFrozen(model))
+        {
+            /* Codes_SRS_SCHEMA_02_013: [ Once the schema is frozen, Schema_GetModelPropertyByName, Schema_GetModelActionByName, Schema_GetModelModelByName, Schema_GetModelByName and Schema_GetStructTypeByName shall find the element through the hash indexes built by Schema_Freeze instead of comparing the name with every element. ]*/
+            temp = FindInNameIndex(&model->ModelIndex, propertyName, strlen(propertyName), &i) ? VECTOR_element(model->models, i) : NULL;
+        }
+        else
+        {
+            temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        }
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -1827,6 +2092,19 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
         LogError("error SCHEMA_INVALID_ARG");
         result = false;
     }
+    else if (IsModelFrozen((MODEL_TYPE*)modelTypeHandle))
+    {
+        size_t propertyId;
+
+        /* Codes_SRS_SCHEMA_99_182: [A single slash ('/') at the beginning of the path shall be ignored and the path shall still be valid.] */
+        if (*propertyPath == '/')
+        {
+            propertyPath++;
+        }
+
+        /* Codes_SRS_SCHEMA_02_014: [ Once the schema is frozen, Schema_ModelPropertyByPathExists shall look the whole path up in the property id index of the model instead of walking the path one segment at a time. ]*/
+        result = FindInNameIndex(&((MODEL_TYPE*)modelTypeHandle)->PathIndex, propertyPath, strlen(propertyPath), &propertyId);
+    }
     else
     {
         const char* slashPos;
@@ -1906,3 +2184,306 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
 
     return result;
 }
+
+static int CountModelPropertyPaths(const MODEL_TYPE* modelType, size_t nesting, size_t* pathCount)
+{
+    int result;
+    if (nesting > SCHEMA_MAX_MODEL_NESTING)
+    {
+        result = __LINE__;
+        LogError("models are nested deeper than %u levels in %s", (unsigned int)SCHEMA_MAX_MODEL_NESTING, modelType->Name);
+    }
+    else
+    {
+        size_t i;
+        size_t modelCount = VECTOR_size(modelType->models);
+
+        *pathCount += modelType->PropertyCount + modelCount;
+        result = 0;
+        for (i = 0; (result == 0) && (i < modelCount); i++)
+        {
+            MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
+            result = CountModelPropertyPaths((MODEL_TYPE*)childModel->modelHandle, nesting + 1, pathCount);
+        }
+    }
+    return result;
+}
+
+static char* CreatePropertyPath(const char* prefix, size_t prefixLength, const char* name)
+{
+    size_t nameLength = strlen(name);
+    char* result = (char*)malloc(prefixLength + nameLength + 1);
+    if (result == NULL)
+    {
+        LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ERROR));
+    }
+    else
+    {
+        (void)memcpy(result, prefix, prefixLength);
+        (void)memcpy(result + prefixLength, name, nameLength + 1);
+    }
+    return result;
+}
+
+/*appends the paths of modelType to the property paths of rootModel. The paths of the properties of a model come first, then each model in model followed by its own paths*/
+static int AddModelPropertyPaths(MODEL_TYPE* rootModel, const MODEL_TYPE* modelType, const char* prefix, size_t prefixLength)
+{
+    int result = 0;
+    size_t i;
+    size_t modelCount = VECTOR_size(modelType->models);
+
+    for (i = 0; (result == 0) && (i < modelType->PropertyCount); i++)
+    {
+        PROPERTY* property = (PROPERTY*)modelType->Properties[i];
+        char* path = CreatePropertyPath(prefix, prefixLength, property->PropertyName);
+        if (path == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            rootModel->PropertyPaths[rootModel->PropertyPathCount++] = path;
+        }
+    }
+
+    for (i = 0; (result == 0) && (i < modelCount); i++)
+    {
+        MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
+        char* path = CreatePropertyPath(prefix, prefixLength, childModel->propertyName);
+        if (path == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            size_t pathLength = strlen(path);
+            char* childPrefix;
+
+            rootModel->PropertyPaths[rootModel->PropertyPathCount++] = path;
+            if ((childPrefix = CreatePropertyPath(path, pathLength, "/")) == NULL)
+            {
+                result = __LINE__;
+            }
+            else
+            {
+                result = AddModelPropertyPaths(rootModel, (MODEL_TYPE*)childModel->modelHandle, childPrefix, pathLength + 1);
+                free(childPrefix);
+            }
+        }
+    }
+
+    return result;
+}
+
+static int BuildModelIndexes(MODEL_TYPE* modelType)
+{
+    int result;
+    size_t modelCount = VECTOR_size(modelType->models);
+    size_t pathCount = 0;
+
+    if ((CreateNameIndex(&modelType->PropertyIndex, modelType->PropertyCount) != 0) ||
+        (CreateNameIndex(&modelType->ActionIndex, modelType->ActionCount) != 0) ||
+        (CreateNameIndex(&modelType->ModelIndex, modelCount) != 0) ||
+        (CountModelPropertyPaths(modelType, 0, &pathCount) != 0) ||
+        (CreateNameIndex(&modelType->PathIndex, pathCount) != 0))
+    {
+        result = __LINE__;
+    }
+    else if ((pathCount > 0) &&
+        ((modelType->PropertyPaths = (char**)malloc(sizeof(char*) * pathCount)) == NULL))
+    {
+        result = __LINE__;
+        LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ERROR));
+    }
+    else if (AddModelPropertyPaths(modelType, modelType, "", 0) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < modelType->PropertyCount; i++)
+        {
+            AddToNameIndex(&modelType->PropertyIndex, ((PROPERTY*)modelType->Properties[i])->PropertyName, i);
+        }
+
+        for (i = 0; i < modelType->ActionCount; i++)
+        {
+            AddToNameIndex(&modelType->ActionIndex, ((ACTION*)modelType->Actions[i])->ActionName, i);
+        }
+
+        for (i = 0; i < modelCount; i++)
+        {
+            AddToNameIndex(&modelType->ModelIndex, ((MODEL_IN_MODEL*)VECTOR_element(modelType->models, i))->propertyName, i);
+        }
+
+        for (i = 0; i < modelType->PropertyPathCount; i++)
+        {
+            AddToNameIndex(&modelType->PathIndex, modelType->PropertyPaths[i], i);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+SCHEMA_RESULT Schema_Freeze(SCHEMA_HANDLE schemaHandle)
+{
+    SCHEMA_RESULT result;
+
+    /* Codes_SRS_SCHEMA_02_006: [ If schemaHandle is NULL, Schema_Freeze shall return SCHEMA_INVALID_ARG. ]*/
+    if (schemaHandle == NULL)
+    {
+        result = SCHEMA_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
+    }
+    else
+    {
+        SCHEMA* schema = (SCHEMA*)schemaHandle;
+
+        /* Codes_SRS_SCHEMA_02_007: [ If the schema is already frozen, Schema_Freeze shall return SCHEMA_OK without doing anything. ]*/
+        if (schema->IsFrozen)
+        {
+            result = SCHEMA_OK;
+        }
+        /* Codes_SRS_SCHEMA_02_008: [ Schema_Freeze shall build a hash index of the model types and one of the struct types of the schema. ]*/
+        else if ((CreateNameIndex(&schema->ModelTypeIndex, schema->ModelTypeCount) != 0) ||
+            (CreateNameIndex(&schema->StructTypeIndex, schema->StructTypeCount) != 0))
+        {
+            /* Codes_SRS_SCHEMA_02_011: [ If any error occurs, Schema_Freeze shall release everything it built, leave the schema unfrozen and return SCHEMA_ERROR. ]*/
+            DestroySchemaIndexes(schema);
+            result = SCHEMA_ERROR;
+            LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < schema->ModelTypeCount; i++)
+            {
+                MODEL_TYPE* modelType = (MODEL_TYPE*)schema->ModelTypes[i];
+
+                /* Codes_SRS_SCHEMA_02_009: [ For every model type, Schema_Freeze shall build a hash index of its properties, one of its actions and one of its models. ]*/
+                /* Codes_SRS_SCHEMA_02_010: [ For every model type, Schema_Freeze shall assign a property id to every path accepted by Schema_ModelPropertyByPathExists: the model's properties in the order they were added, then every model in model, each followed by the paths inside that model. ]*/
+                if (BuildModelIndexes(modelType) != 0)
+                {
+                    break;
+                }
+                AddToNameIndex(&schema->ModelTypeIndex, modelType->Name, i);
+            }
+
+            if (i < schema->ModelTypeCount)
+            {
+                /* Codes_SRS_SCHEMA_02_011: [ If any error occurs, Schema_Freeze shall release everything it built, leave the schema unfrozen and return SCHEMA_ERROR. ]*/
+                DestroySchemaIndexes(schema);
+                result = SCHEMA_ERROR;
+                LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
+            }
+            else
+            {
+                for (i = 0; i < schema->StructTypeCount; i++)
+                {
+                    AddToNameIndex(&schema->StructTypeIndex, ((STRUCT_TYPE*)schema->StructTypes[i])->Name, i);
+                }
+
+                /* Codes_SRS_SCHEMA_02_012: [ Otherwise Schema_Freeze shall mark the schema as frozen and return SCHEMA_OK. ]*/
+                schema->IsFrozen = true;
+                result = SCHEMA_OK;
+            }
+        }
+    }
+
+    return result;
+}
+
+SCHEMA_RESULT Schema_GetModelPropertyIdCount(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, size_t* propertyIdCount)
+{
+    SCHEMA_RESULT result;
+
+    /* Codes_SRS_SCHEMA_02_015: [ If any of the arguments is NULL, Schema_GetModelPropertyIdCount shall return SCHEMA_INVALID_ARG. ]*/
+    if ((modelTypeHandle == NULL) ||
+        (propertyIdCount == NULL))
+    {
+        result = SCHEMA_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
+    }
+    /* Codes_SRS_SCHEMA_02_016: [ If the model type does not belong to a frozen schema, Schema_GetModelPropertyIdCount shall return SCHEMA_ERROR. ]*/
+    else if (!IsModelFrozen((MODEL_TYPE*)modelTypeHandle))
+    {
+        result = SCHEMA_ERROR;
+        LogError("schema is not frozen");
+    }
+    else
+    {
+        /* Codes_SRS_SCHEMA_02_017: [ Schema_GetModelPropertyIdCount shall provide in propertyIdCount the number of property ids of the model type and return SCHEMA_OK. Property ids are 0 to propertyIdCount - 1. ]*/
+        *propertyIdCount = ((MODEL_TYPE*)modelTypeHandle)->PropertyPathCount;
+        result = SCHEMA_OK;
+    }
+
+    return result;
+}
+
+SCHEMA_RESULT Schema_GetModelPropertyIdByPath(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* propertyPath, size_t* propertyId)
+{
+    SCHEMA_RESULT result;
+
+    /* Codes_SRS_SCHEMA_02_018: [ If any of the arguments is NULL, Schema_GetModelPropertyIdByPath shall return SCHEMA_INVALID_ARG. ]*/
+    if ((modelTypeHandle == NULL) ||
+        (propertyPath == NULL) ||
+        (propertyId == NULL))
+    {
+        result = SCHEMA_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
+    }
+    /* Codes_SRS_SCHEMA_02_019: [ If the model type does not belong to a frozen schema, Schema_GetModelPropertyIdByPath shall return SCHEMA_ERROR. ]*/
+    else if (!IsModelFrozen((MODEL_TYPE*)modelTypeHandle))
+    {
+        result = SCHEMA_ERROR;
+        LogError("schema is not frozen");
+    }
+    else
+    {
+        /* Codes_SRS_SCHEMA_02_020: [ A single slash ('/') at the beginning of propertyPath shall be ignored. ]*/
+        if (*propertyPath == '/')
+        {
+            propertyPath++;
+        }
+
+        /* Codes_SRS_SCHEMA_02_021: [ Schema_GetModelPropertyIdByPath shall provide in propertyId the property id of propertyPath and return SCHEMA_OK. ]*/
+        if (FindInNameIndex(&((MODEL_TYPE*)modelTypeHandle)->PathIndex, propertyPath, strlen(propertyPath), propertyId))
+        {
+            result = SCHEMA_OK;
+        }
+        else
+        {
+            /* Codes_SRS_SCHEMA_02_022: [ If propertyPath does not exist in the model type, Schema_GetModelPropertyIdByPath shall return SCHEMA_ELEMENT_NOT_FOUND. ]*/
+            result = SCHEMA_ELEMENT_NOT_FOUND;
+            LogError("property path not found (%s)", propertyPath);
+        }
+    }
+
+    return result;
+}
+
+const char* Schema_GetModelPropertyPathById(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, size_t propertyId)
+{
+    const char* result;
+
+    /* Codes_SRS_SCHEMA_02_023: [ If modelTypeHandle is NULL, the model type does not belong to a frozen schema or propertyId is not a property id of the model type, Schema_GetModelPropertyPathById shall return NULL. ]*/
+    if ((modelTypeHandle == NULL) ||
+        (!IsModelFrozen((MODEL_TYPE*)modelTypeHandle)) ||
+        (propertyId >= ((MODEL_TYPE*)modelTypeHandle)->PropertyPathCount))
+    {
+        result = NULL;
+        LogError("(Error code: %s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_INVALID_ARG));
+    }
+    else
+    {
+        /* Codes_SRS_SCHEMA_02_024: [ Otherwise Schema_GetModelPropertyPathById shall return the path, without a leading slash, that has the property id propertyId. The path stays valid until the schema is destroyed. ]*/
+        result = ((MODEL_TYPE*)modelTypeHandle)->PropertyPaths[propertyId];
+    }
+
+    return result;
+}
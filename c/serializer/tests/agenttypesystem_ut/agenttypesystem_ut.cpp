@@ -4273,7 +4273,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             Destroy_AGENT_DATA_TYPE(&ag);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_SignallingNan_succeeds)
         {
             ///arrange
@@ -4286,7 +4286,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "NaN", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_SignallingNan_insuficient_buffer_fails)
         {
             ///arrange
@@ -4299,7 +4299,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_QuietNan_succeeds)
         {
             ///arrange
@@ -4312,7 +4312,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "NaN", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_QuietNan_insuficient_buffer_fails)
         {
             ///arrange
@@ -4325,7 +4325,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_minusInf_succeeds)
         {
             ///arrange
@@ -4338,7 +4338,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "-INF", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_minusInf_insuficient_buffer_fails)
         {
             ///arrange
@@ -4352,7 +4352,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_plusInf_succeeds)
         {
             ///arrange
@@ -4365,7 +4365,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "INF", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_plusInf_insuficient_buffer_fails)
         {
             ///arrange
@@ -4378,7 +4378,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_succeeds_1)
         {
             ///arrange
@@ -4391,7 +4391,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(double, TEST_DOUBLE_1, atof(STRING_c_str(global_bufferTemp)));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_succeeds_2)
         {
             ///arrange
@@ -4404,6 +4404,42 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(double, TEST_DOUBLE_2, atof(STRING_c_str(global_bufferTemp)));
         }
 
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
+        TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_produces_shortest_representation)
+        {
+            ///arrange
+            AGENT_DATA_TYPE ag;
+            (void)Create_AGENT_DATA_TYPE_from_DOUBLE(&ag, 0.1);
+
+            ///act
+            auto res = AgentDataTypes_ToString(global_bufferTemp, &ag);
+
+            ///assert
+            ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_OK, res);
+            ASSERT_ARE_EQUAL(char_ptr, "0.1", STRING_c_str(global_bufferTemp));
+
+            ///cleanup
+            Destroy_AGENT_DATA_TYPE(&ag);
+        }
+
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary64 value.*/
+        TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_small_value_uses_exponent)
+        {
+            ///arrange
+            AGENT_DATA_TYPE ag;
+            (void)Create_AGENT_DATA_TYPE_from_DOUBLE(&ag, 1.5e-10);
+
+            ///act
+            auto res = AgentDataTypes_ToString(global_bufferTemp, &ag);
+
+            ///assert
+            ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_OK, res);
+            ASSERT_ARE_EQUAL(char_ptr, "1.5e-10", STRING_c_str(global_bufferTemp));
+
+            ///cleanup
+            Destroy_AGENT_DATA_TYPE(&ag);
+        }
+
         /*Tests_SRS_AGENT_TYPE_SYSTEM_99_047:[ Creates an AGENT_DATA_TYPE containing an EDM_SINGLE from float]*/
         TEST_FUNCTION(Create_AGENT_DATA_TYPE_from_FLOAT_succeeds_1)
         {
@@ -4500,7 +4536,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             Destroy_AGENT_DATA_TYPE(&ag);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_SignallingNan_succeeds)
         {
             ///arrange
@@ -4513,7 +4549,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "NaN", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_SignallingNan_insuficient_buffer_fails)
         {
             ///arrange
@@ -4527,7 +4563,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_QuietNan_succeeds)
         {
             ///arrange
@@ -4540,7 +4576,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "NaN", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_QuietNan_insuficient_buffer_fails)
         {
             ///arrange
@@ -4555,7 +4591,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
 
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_minusInf_succeeds)
         {
             ///arrange
@@ -4568,7 +4604,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "-INF", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_minusInf_insuficient_buffer_fails)
         {
             ///arrange
@@ -4584,7 +4620,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
 
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_plusInf_succeeds)
         {
             ///arrange
@@ -4597,7 +4633,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "INF", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_plusInf_insuficient_buffer_fails)
         {
             ///arrange
@@ -4611,7 +4647,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_succeeds_1)
         {
             ///arrange
@@ -4625,7 +4661,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
 
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_succeeds_2)
         {
             ///arrange
@@ -4638,6 +4674,24 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(float, TEST_FLOAT_2, (float)atof(STRING_c_str(global_bufferTemp)));
 
         }
+
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest decimal string that reads back as the same binary32 value.]*/
+        TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_produces_shortest_representation)
+        {
+            ///arrange
+            AGENT_DATA_TYPE ag;
+            (void)Create_AGENT_DATA_TYPE_from_FLOAT(&ag, 0.1f);
+
+            ///act
+            auto res = AgentDataTypes_ToString(global_bufferTemp, &ag);
+
+            ///assert
+            ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_OK, res);
+            ASSERT_ARE_EQUAL(char_ptr, "0.1", STRING_c_str(global_bufferTemp));
+
+            ///cleanup
+            Destroy_AGENT_DATA_TYPE(&ag);
+        }
 #endif
 
         /*Tests_SRS_AGENT_TYPE_SYSTEM_99_043:[ Creates an AGENT_DATA_TYPE containing an EDM_INT16 from int16_t]*/
@@ -17,6 +17,7 @@
 #include <string>
 #include "azure_c_shared_utility/strings.h"
 #include "serializer.h"
+#include "databatch.h"
 
 
 DEFINE_MICROMOCK_ENUM_TO_STRING(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_RESULT_VALUES);
@@ -147,6 +148,7 @@ static const SCHEMA_HANDLE TEST_SCHEMA_HANDLE = (SCHEMA_MODEL_TYPE_HANDLE)0x4242
 static const SCHEMA_MODEL_TYPE_HANDLE TEST_MODEL_HANDLE = (SCHEMA_MODEL_TYPE_HANDLE)0x4243;
 static const SCHEMA_MODEL_TYPE_HANDLE TEST_TRUCKTYPE_MODEL_HANDLE = (SCHEMA_MODEL_TYPE_HANDLE)0x4244;
 static const DEVICE_HANDLE TEST_DEVICE_HANDLE = (DEVICE_HANDLE)0x4848;
+static const DATA_BATCH_HANDLE TEST_DATA_BATCH_HANDLE = (DATA_BATCH_HANDLE)0x4849;
 
 static const SCHEMA_ACTION_HANDLE TEST1_ACTION_HANDLE = (SCHEMA_ACTION_HANDLE)0x5201;
 static const SCHEMA_ACTION_HANDLE SETSPEED_ACTION_HANDLE = (SCHEMA_ACTION_HANDLE)0x5202;
@@ -634,6 +636,18 @@ public:
     MOCK_METHOD_END(SCHEMA_HANDLE, (SCHEMA_HANDLE)NULL);
     MOCK_STATIC_METHOD_1(, SCHEMA_RESULT, Schema_DestroyIfUnused, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle);
     MOCK_METHOD_END(SCHEMA_RESULT, SCHEMA_OK);
+    MOCK_STATIC_METHOD_1(, SCHEMA_RESULT, Schema_Freeze, SCHEMA_HANDLE, schemaHandle);
+    MOCK_METHOD_END(SCHEMA_RESULT, SCHEMA_OK);
+
+    /* DataBatch mocks */
+    MOCK_STATIC_METHOD_4(, DATA_BATCH_HANDLE, DataBatch_Create, size_t, columnCount, const char* const*, columnNames, size_t, maxSamples, bool, deltaEncoding)
+    MOCK_METHOD_END(DATA_BATCH_HANDLE, TEST_DATA_BATCH_HANDLE);
+    MOCK_STATIC_METHOD_1(, void, DataBatch_Destroy, DATA_BATCH_HANDLE, dataBatchHandle)
+    MOCK_VOID_METHOD_END();
+    MOCK_STATIC_METHOD_2(, DATA_BATCH_RESULT, DataBatch_AppendSample, DATA_BATCH_HANDLE, dataBatchHandle, AGENT_DATA_TYPE*, values)
+    MOCK_METHOD_END(DATA_BATCH_RESULT, DATA_BATCH_OK);
+    MOCK_STATIC_METHOD_3(, DATA_BATCH_RESULT, DataBatch_Encode, DATA_BATCH_HANDLE, dataBatchHandle, unsigned char**, destination, size_t*, destinationSize)
+    MOCK_METHOD_END(DATA_BATCH_RESULT, DATA_BATCH_OK);
 };
 
 DECLARE_GLOBAL_MOCK_METHOD_2(CMocksForCodeFirst, , AGENT_DATA_TYPES_RESULT, Create_EDM_BOOLEAN_from_int, AGENT_DATA_TYPE*, agentData, int, v);
@@ -678,6 +692,12 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CMocksForCodeFirst, , SCHEMA_RESULT, Schema_AddDevi
 DECLARE_GLOBAL_MOCK_METHOD_1(CMocksForCodeFirst, , SCHEMA_RESULT, Schema_ReleaseDeviceRef, SCHEMA_MODEL_TYPE_HANDLE, modelHandle);
 DECLARE_GLOBAL_MOCK_METHOD_1(CMocksForCodeFirst, , SCHEMA_HANDLE, Schema_GetSchemaForModelType, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle);
 DECLARE_GLOBAL_MOCK_METHOD_1(CMocksForCodeFirst, , SCHEMA_RESULT, Schema_DestroyIfUnused, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle);
+DECLARE_GLOBAL_MOCK_METHOD_1(CMocksForCodeFirst, , SCHEMA_RESULT, Schema_Freeze, SCHEMA_HANDLE, schemaHandle);
+
+DECLARE_GLOBAL_MOCK_METHOD_4(CMocksForCodeFirst, , DATA_BATCH_HANDLE, DataBatch_Create, size_t, columnCount, const char* const*, columnNames, size_t, maxSamples, bool, deltaEncoding);
+DECLARE_GLOBAL_MOCK_METHOD_1(CMocksForCodeFirst, , void, DataBatch_Destroy, DATA_BATCH_HANDLE, dataBatchHandle);
+DECLARE_GLOBAL_MOCK_METHOD_2(CMocksForCodeFirst, , DATA_BATCH_RESULT, DataBatch_AppendSample, DATA_BATCH_HANDLE, dataBatchHandle, AGENT_DATA_TYPE*, values);
+DECLARE_GLOBAL_MOCK_METHOD_3(CMocksForCodeFirst, , DATA_BATCH_RESULT, DataBatch_Encode, DATA_BATCH_HANDLE, dataBatchHandle, unsigned char**, destination, size_t*, destinationSize);
 
 
 typedef struct SimpleDevice_TAG
@@ -2681,6 +2701,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         STRICT_EXPECTED_CALL(mocks, Schema_AddModelActionArgument(SETSPEED_ACTION_HANDLE, "theSpeed", "double"));
         STRICT_EXPECTED_CALL(mocks, Schema_CreateModelAction(TEST_TRUCKTYPE_MODEL_HANDLE, "reset"))
             .SetReturn(RESET_ACTION_HANDLE);
+        STRICT_EXPECTED_CALL(mocks, Schema_Freeze(TEST_SCHEMA_HANDLE));
 
         ///act
         SCHEMA_HANDLE result = CodeFirst_RegisterSchema("TestSchema", &testReflectedData);
@@ -2715,6 +2736,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         STRICT_EXPECTED_CALL(mocks, Schema_AddModelModel(TEST_OUTERTYPE_MODEL_HANDLE, "Inner", TEST_INNERTYPE_MODEL_HANDLE));
         STRICT_EXPECTED_CALL(mocks, Schema_CreateModelAction(TEST_OUTERTYPE_MODEL_HANDLE, "reset"));
         STRICT_EXPECTED_CALL(mocks, Schema_CreateModelAction(TEST_INNERTYPE_MODEL_HANDLE, "reset"));
+        STRICT_EXPECTED_CALL(mocks, Schema_Freeze(TEST_SCHEMA_HANDLE));
 
         ///act
         SCHEMA_HANDLE result = CodeFirst_RegisterSchema("TestSchema", &testModelInModelReflectedData);
@@ -2868,6 +2890,24 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         ASSERT_IS_NULL(result);
     }
 
+    /* Tests_SRS_CODEFIRST_02_038: [ After all the struct types and model types have been built, CodeFirst_RegisterSchema shall call Schema_Freeze so that later lookups in the schema are hash based. ]*/
+    /* Tests_SRS_CODEFIRST_99_076:[If any Schema APIs fail, CodeFirst_RegisterSchema shall return NULL.] */
+    TEST_FUNCTION(When_Schema_Freeze_Fails_Then_CodeFirst_RegisterSchema_Fails)
+    {
+        CNiceCallComparer<CMocksForCodeFirst> mocks;
+
+        ///arrange
+        STRICT_EXPECTED_CALL(mocks, Schema_Freeze(TEST_SCHEMA_HANDLE))
+            .SetReturn(SCHEMA_ERROR);
+        STRICT_EXPECTED_CALL(mocks, Schema_Destroy(TEST_SCHEMA_HANDLE));
+
+        ///act
+        SCHEMA_HANDLE result = CodeFirst_RegisterSchema("TestSchema", &testReflectedData);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+    }
+
     /* Tests_SRS_CODEFIRST_99_121:[If the schema has already been registered, CodeFirst_RegisterSchema shall return its handle.] */
     TEST_FUNCTION(When_Schema_Was_Already_Registered_CodeFirst_Returns_Its_Handle)
     {
@@ -3003,4 +3043,323 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         CodeFirst_DestroyDevice(device);
     }
 
+    /* CodeFirst_CreateBatch */
+
+    /* Tests_SRS_CODEFIRST_02_019: [If maxSamples or numProperties is 0 then CodeFirst_CreateBatch shall fail and return NULL.] */
+    TEST_FUNCTION(CodeFirst_CreateBatch_with_0_maxSamples_fails)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        mocks.ResetAllCalls();
+
+        ///act
+        CODEFIRST_BATCH_HANDLE result = CodeFirst_CreateBatch(0, false, 1, &device->this_is_double);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+    }
+
+    /* Tests_SRS_CODEFIRST_02_020: [If any property cannot be associated with a device, or if the properties belong to different devices, then CodeFirst_CreateBatch shall fail and return NULL.] */
+    TEST_FUNCTION(CodeFirst_CreateBatch_with_a_property_not_in_a_device_fails)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        double notAProperty = 0.0;
+
+        ///act
+        CODEFIRST_BATCH_HANDLE result = CodeFirst_CreateBatch(10, false, 1, &notAProperty);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_CODEFIRST_02_018: [CodeFirst_CreateBatch shall create a batch that buffers up to maxSamples samples of the properties passed as pointers in the variable argument list.] */
+    /* Tests_SRS_CODEFIRST_02_023: [Each column shall be named by the full path of its property, as CodeFirst_SendAsync does.] */
+    /* Tests_SRS_CODEFIRST_02_024: [CodeFirst_CreateBatch shall call DataBatch_Create passing the column count, the column names, maxSamples and deltaEncoding.] */
+    TEST_FUNCTION(CodeFirst_CreateBatch_with_2_properties_succeeds)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelName(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelName(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, DataBatch_Create(2, IGNORED_PTR_ARG, 10, true))
+            .IgnoreArgument(2);
+
+        ///act
+        CODEFIRST_BATCH_HANDLE result = CodeFirst_CreateBatch(10, true, 2, &device->this_is_double, &device->this_is_int);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyBatch(result);
+        CodeFirst_DestroyDevice(device);
+    }
+
+    /* Tests_SRS_CODEFIRST_02_021: [If a pointer to the beginning of a device block is passed then all the properties of that device shall become columns of the batch.] */
+    TEST_FUNCTION(CodeFirst_CreateBatch_with_the_entire_device_succeeds)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelName(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, DataBatch_Create(2, IGNORED_PTR_ARG, 10, false))
+            .IgnoreArgument(2);
+
+        ///act
+        CODEFIRST_BATCH_HANDLE result = CodeFirst_CreateBatch(10, false, 1, device);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyBatch(result);
+        CodeFirst_DestroyDevice(device);
+    }
+
+    /* Tests_SRS_CODEFIRST_02_022: [If any other error occurs then CodeFirst_CreateBatch shall fail and return NULL.] */
+    TEST_FUNCTION(CodeFirst_CreateBatch_when_DataBatch_Create_fails_fails)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelName(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, DataBatch_Create(1, IGNORED_PTR_ARG, 10, false))
+            .IgnoreArgument(2)
+            .SetReturn((DATA_BATCH_HANDLE)NULL);
+
+        ///act
+        CODEFIRST_BATCH_HANDLE result = CodeFirst_CreateBatch(10, false, 1, &device->this_is_double);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+    }
+
+    /* CodeFirst_AppendBatchSample */
+
+    /* Tests_SRS_CODEFIRST_02_026: [If batchHandle is NULL then CodeFirst_AppendBatchSample shall return CODEFIRST_INVALID_ARG.] */
+    TEST_FUNCTION(CodeFirst_AppendBatchSample_with_NULL_batchHandle_fails)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_AppendBatchSample(NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_CODEFIRST_02_025: [CodeFirst_AppendBatchSample shall snapshot the current values of all the columns of the batch and append them as one sample.] */
+    /* Tests_SRS_CODEFIRST_02_027: [The marshalling shall be done by calling the Create_AGENT_DATA_TYPE_from_Ptr function associated with each property.] */
+    /* Tests_SRS_CODEFIRST_02_029: [CodeFirst_AppendBatchSample shall pass the values to DataBatch_AppendSample, which takes ownership of them.] */
+    /* Tests_SRS_CODEFIRST_02_031: [Otherwise CodeFirst_AppendBatchSample shall return CODEFIRST_OK.] */
+    TEST_FUNCTION(CodeFirst_AppendBatchSample_succeeds)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        CODEFIRST_BATCH_HANDLE batch = CodeFirst_CreateBatch(10, false, 2, &device->this_is_double, &device->this_is_int);
+        device->this_is_double = 42.0;
+        device->this_is_int = 1;
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_DOUBLE(IGNORED_PTR_ARG, 42.0))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_SINT32(IGNORED_PTR_ARG, 1))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, DataBatch_AppendSample(TEST_DATA_BATCH_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_AppendBatchSample(batch);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyBatch(batch);
+        CodeFirst_DestroyDevice(device);
+    }
+
+    /* Tests_SRS_CODEFIRST_02_028: [If Create_AGENT_DATA_TYPE_from_Ptr fails, CodeFirst_AppendBatchSample shall return CODEFIRST_AGENT_DATA_TYPE_ERROR.] */
+    TEST_FUNCTION(CodeFirst_AppendBatchSample_when_Create_AGENT_DATA_TYPE_fails_destroys_the_values_already_created)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        CODEFIRST_BATCH_HANDLE batch = CodeFirst_CreateBatch(10, false, 2, &device->this_is_double, &device->this_is_int);
+        mocks.ResetAllCalls();
+
+        EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_DOUBLE(IGNORED_PTR_ARG, 0.0));
+        EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_SINT32(IGNORED_PTR_ARG, 0))
+            .SetReturn(AGENT_DATA_TYPES_ERROR);
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_AppendBatchSample(batch);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_AGENT_DATA_TYPE_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyBatch(batch);
+        CodeFirst_DestroyDevice(device);
+    }
+
+    /* Tests_SRS_CODEFIRST_02_030: [If DataBatch_AppendSample fails, CodeFirst_AppendBatchSample shall return CODEFIRST_ERROR.] */
+    TEST_FUNCTION(CodeFirst_AppendBatchSample_when_DataBatch_AppendSample_fails_fails)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        CODEFIRST_BATCH_HANDLE batch = CodeFirst_CreateBatch(10, false, 1, &device->this_is_double);
+        mocks.ResetAllCalls();
+
+        EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_DOUBLE(IGNORED_PTR_ARG, 0.0));
+        STRICT_EXPECTED_CALL(mocks, DataBatch_AppendSample(TEST_DATA_BATCH_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(DATA_BATCH_ERROR);
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_AppendBatchSample(batch);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyBatch(batch);
+        CodeFirst_DestroyDevice(device);
+    }
+
+    /* CodeFirst_SendBatchAsync */
+
+    /* Tests_SRS_CODEFIRST_02_032: [If destination, destinationSize or batchHandle is NULL then CodeFirst_SendBatchAsync shall return CODEFIRST_INVALID_ARG.] */
+    TEST_FUNCTION(CodeFirst_SendBatchAsync_with_NULL_batchHandle_fails)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        unsigned char* destination;
+        size_t destinationSize;
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_SendBatchAsync(&destination, &destinationSize, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_INVALID_ARG, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_CODEFIRST_02_033: [CodeFirst_SendBatchAsync shall call DataBatch_Encode to produce the columnar payload of all the buffered samples.] */
+    /* Tests_SRS_CODEFIRST_02_035: [Otherwise CodeFirst_SendBatchAsync shall return CODEFIRST_OK.] */
+    TEST_FUNCTION(CodeFirst_SendBatchAsync_succeeds)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        CODEFIRST_BATCH_HANDLE batch = CodeFirst_CreateBatch(10, false, 1, device);
+        unsigned char* destination;
+        size_t destinationSize;
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, DataBatch_Encode(TEST_DATA_BATCH_HANDLE, &destination, &destinationSize));
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_SendBatchAsync(&destination, &destinationSize, batch);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyBatch(batch);
+        CodeFirst_DestroyDevice(device);
+    }
+
+    /* Tests_SRS_CODEFIRST_02_034: [If DataBatch_Encode fails, CodeFirst_SendBatchAsync shall return CODEFIRST_ERROR.] */
+    TEST_FUNCTION(CodeFirst_SendBatchAsync_when_DataBatch_Encode_fails_fails)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        CODEFIRST_BATCH_HANDLE batch = CodeFirst_CreateBatch(10, false, 1, device);
+        unsigned char* destination;
+        size_t destinationSize;
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, DataBatch_Encode(TEST_DATA_BATCH_HANDLE, &destination, &destinationSize))
+            .SetReturn(DATA_BATCH_EMPTY);
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_SendBatchAsync(&destination, &destinationSize, batch);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyBatch(batch);
+        CodeFirst_DestroyDevice(device);
+    }
+
+    /* CodeFirst_DestroyBatch */
+
+    /* Tests_SRS_CODEFIRST_02_036: [If batchHandle is NULL then CodeFirst_DestroyBatch shall do nothing.] */
+    TEST_FUNCTION(CodeFirst_DestroyBatch_with_NULL_does_nothing)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+
+        ///act
+        CodeFirst_DestroyBatch(NULL);
+
+        ///assert
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /* Tests_SRS_CODEFIRST_02_037: [CodeFirst_DestroyBatch shall call DataBatch_Destroy and free all the resources used by the batch.] */
+    TEST_FUNCTION(CodeFirst_DestroyBatch_calls_DataBatch_Destroy)
+    {
+        ///arrange
+        CMocksForCodeFirst mocks;
+        SimpleDevice* device = (SimpleDevice*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &testReflectedData, sizeof(SimpleDevice), false);
+        CODEFIRST_BATCH_HANDLE batch = CodeFirst_CreateBatch(10, false, 1, device);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, DataBatch_Destroy(TEST_DATA_BATCH_HANDLE));
+
+        ///act
+        CodeFirst_DestroyBatch(batch);
+
+        ///assert
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+    }
+
 END_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider);
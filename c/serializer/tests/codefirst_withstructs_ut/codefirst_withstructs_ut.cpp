@@ -14,6 +14,7 @@
 #include "schema.h"
 #include "iotdevice.h"
 #include "serializer.h"
+#include "databatch.h"
 #include "iotdevice.h"
 
 
@@ -169,6 +170,7 @@ static const SCHEMA_MODEL_TYPE_HANDLE TEST_MODEL_HANDLE = (SCHEMA_MODEL_TYPE_HAN
 static const SCHEMA_STRUCT_TYPE_HANDLE TEST_STRUCT_TYPE = (SCHEMA_STRUCT_TYPE_HANDLE)0x4244;
 static const SCHEMA_ACTION_HANDLE TEST_ACTION_HANDLE = (SCHEMA_ACTION_HANDLE)0x4245;
 static const DEVICE_HANDLE TEST_DEVICE_HANDLE = (DEVICE_HANDLE)0x4848;
+static const DATA_BATCH_HANDLE TEST_DATA_BATCH_HANDLE = (DATA_BATCH_HANDLE)0x4849;
 static void* g_InvokeActionCallbackArgument;
 
 std::ostream& operator<<(std::ostream& left, const EDM_GUID edmGuid)
@@ -526,6 +528,18 @@ public:
     MOCK_METHOD_END(SCHEMA_HANDLE, (SCHEMA_HANDLE)NULL);
     MOCK_STATIC_METHOD_1(, SCHEMA_RESULT, Schema_DestroyIfUnused, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle);
     MOCK_METHOD_END(SCHEMA_RESULT, SCHEMA_OK);
+    MOCK_STATIC_METHOD_1(, SCHEMA_RESULT, Schema_Freeze, SCHEMA_HANDLE, schemaHandle);
+    MOCK_METHOD_END(SCHEMA_RESULT, SCHEMA_OK);
+
+    /* DataBatch mocks */
+    MOCK_STATIC_METHOD_4(, DATA_BATCH_HANDLE, DataBatch_Create, size_t, columnCount, const char* const*, columnNames, size_t, maxSamples, bool, deltaEncoding)
+    MOCK_METHOD_END(DATA_BATCH_HANDLE, TEST_DATA_BATCH_HANDLE);
+    MOCK_STATIC_METHOD_1(, void, DataBatch_Destroy, DATA_BATCH_HANDLE, dataBatchHandle)
+    MOCK_VOID_METHOD_END();
+    MOCK_STATIC_METHOD_2(, DATA_BATCH_RESULT, DataBatch_AppendSample, DATA_BATCH_HANDLE, dataBatchHandle, AGENT_DATA_TYPE*, values)
+    MOCK_METHOD_END(DATA_BATCH_RESULT, DATA_BATCH_OK);
+    MOCK_STATIC_METHOD_3(, DATA_BATCH_RESULT, DataBatch_Encode, DATA_BATCH_HANDLE, dataBatchHandle, unsigned char**, destination, size_t*, destinationSize)
+    MOCK_METHOD_END(DATA_BATCH_RESULT, DATA_BATCH_OK);
 };
 
 DECLARE_GLOBAL_MOCK_METHOD_2(CCodeFirstMocks, , AGENT_DATA_TYPES_RESULT, Create_EDM_BOOLEAN_from_int, AGENT_DATA_TYPE*, agentData, int, v);
@@ -569,6 +583,12 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CCodeFirstMocks, , SCHEMA_RESULT, Schema_AddDeviceR
 DECLARE_GLOBAL_MOCK_METHOD_1(CCodeFirstMocks, , SCHEMA_RESULT, Schema_ReleaseDeviceRef, SCHEMA_MODEL_TYPE_HANDLE, modelHandle);
 DECLARE_GLOBAL_MOCK_METHOD_1(CCodeFirstMocks, , SCHEMA_HANDLE, Schema_GetSchemaForModelType, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle);
 DECLARE_GLOBAL_MOCK_METHOD_1(CCodeFirstMocks, , SCHEMA_RESULT, Schema_DestroyIfUnused, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle);
+DECLARE_GLOBAL_MOCK_METHOD_1(CCodeFirstMocks, , SCHEMA_RESULT, Schema_Freeze, SCHEMA_HANDLE, schemaHandle);
+
+DECLARE_GLOBAL_MOCK_METHOD_4(CCodeFirstMocks, , DATA_BATCH_HANDLE, DataBatch_Create, size_t, columnCount, const char* const*, columnNames, size_t, maxSamples, bool, deltaEncoding);
+DECLARE_GLOBAL_MOCK_METHOD_1(CCodeFirstMocks, , void, DataBatch_Destroy, DATA_BATCH_HANDLE, dataBatchHandle);
+DECLARE_GLOBAL_MOCK_METHOD_2(CCodeFirstMocks, , DATA_BATCH_RESULT, DataBatch_AppendSample, DATA_BATCH_HANDLE, dataBatchHandle, AGENT_DATA_TYPE*, values);
+DECLARE_GLOBAL_MOCK_METHOD_3(CCodeFirstMocks, , DATA_BATCH_RESULT, DataBatch_Encode, DATA_BATCH_HANDLE, dataBatchHandle, unsigned char**, destination, size_t*, destinationSize);
 
 
 extern "C" DEVICE_HANDLE serializer_getdevicehandle(void) { return TEST_DEVICE_HANDLE; }
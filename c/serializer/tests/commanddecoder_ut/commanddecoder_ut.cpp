@@ -6,6 +6,8 @@
 #include <crtdbg.h>
 #endif
 
+#include <string>
+
 #include "azure_c_shared_utility/lock.h"
 #include "testrunnerswitcher.h"
 #include "micromock.h"
@@ -49,12 +51,6 @@ static MICROMOCK_MUTEX_HANDLE g_testByTest;
 
 static const SCHEMA_ACTION_HANDLE SetACStateActionHandle = (SCHEMA_ACTION_HANDLE)0x4242;
 
-static const MULTITREE_HANDLE TEST_COMMAND_ROOT_NODE = (MULTITREE_HANDLE)0x4201;
-static const MULTITREE_HANDLE TEST_COMMAND_NAME_NODE = (MULTITREE_HANDLE)0x4202;
-static const MULTITREE_HANDLE TEST_COMMAND_ARGS_NODE = (MULTITREE_HANDLE)0x4202;
-static const MULTITREE_HANDLE TEST_ARG1_NODE = (MULTITREE_HANDLE)0x4281;
-static const MULTITREE_HANDLE TEST_ARG2_NODE = (MULTITREE_HANDLE)0x4282;
-static const MULTITREE_HANDLE TEST_NESTED_STRUCT_NODE = (MULTITREE_HANDLE)0x4283;
 static const SCHEMA_MODEL_TYPE_HANDLE TEST_MODEL_HANDLE = (SCHEMA_MODEL_TYPE_HANDLE)0x4301;
 static const SCHEMA_MODEL_TYPE_HANDLE TEST_CHILD_MODEL_HANDLE = (SCHEMA_MODEL_TYPE_HANDLE)0x4302;
 static const SCHEMA_HANDLE TEST_SCHEMA_HANDLE = (SCHEMA_HANDLE)0x4401;
@@ -74,9 +70,7 @@ static AGENT_DATA_TYPE LatAgentDataType;
 static AGENT_DATA_TYPE LongAgentDataType;
 static AGENT_DATA_TYPE OtherArgAgentDataType;
 
-static const char* quotedSetLocationName = "\"SetLocation\"";
 static const char* setLocationName = "SetLocation";
-static const char* quotedSetACStateName = "\"SetACState\"";
 static const char* setACStateName = "SetACState";
 
 #define DEFAULT_SCHEMA_NAME_SPACE "TruckDemo"
@@ -85,7 +79,7 @@ static const char OtherArgValue[] = "SomeString";
 static const SCHEMA_STRUCT_TYPE_HANDLE TEST_STRUCT_1_HANDLE = (SCHEMA_STRUCT_TYPE_HANDLE)0x4301;
 static const SCHEMA_STRUCT_TYPE_HANDLE TEST_STRUCT_2_HANDLE = (SCHEMA_STRUCT_TYPE_HANDLE)0x4302;
 
-static const SCHEMA_ACTION_HANDLE SetLocationActionHandle = (SCHEMA_ACTION_HANDLE)0x4242;
+static const SCHEMA_ACTION_HANDLE SetLocationActionHandle = (SCHEMA_ACTION_HANDLE)0x4243;
 
 // { "Location", "GeoLocation" }
 static const char LocationActionArgument_Name[] = "Location";
@@ -100,9 +94,6 @@ static const SCHEMA_PROPERTY_HANDLE memberProperty2 = (SCHEMA_PROPERTY_HANDLE)0x
 //  = { "NestedLocation", "NestedGeoLocation" }
 static const SCHEMA_PROPERTY_HANDLE memberNestedComplexTypeProperty = (SCHEMA_PROPERTY_HANDLE)0x4403;
 
-static const MULTITREE_HANDLE TEST_MEMBER1_NODE = (MULTITREE_HANDLE)0x4401;
-static const MULTITREE_HANDLE TEST_MEMBER2_NODE = (MULTITREE_HANDLE)0x4402;
-
 static char lastMemberNames[100][100][100];
 static size_t nCall = 0;
 
@@ -111,19 +102,28 @@ static size_t nCall = 0;
     "\"Name\" : \"hagauaga\"," \
     "\"Parameters\":" \
     "{ "  \
-    "  \"param1\" : \"42\"," \
+    "  \"param1\" : \"42\"" \
     "} "  \
     " }"
 
-static char TestCommand[] = TEST_COMMAND;
+#define SET_AC_STATE_COMMAND \
+    "{\"Name\":\"SetACState\",\"Parameters\":{\"State\":true}}"
+
+#define SET_AC_STATE_2_ARGS_COMMAND \
+    "{\"Name\":\"SetACState\",\"Parameters\":{\"State\":true,\"OtherArg\":\"SomeString\"}}"
+
+#define SET_LOCATION_COMMAND \
+    "{\"Name\":\"SetLocation\",\"Parameters\":{\"Location\":{\"Lat\":42.42,\"Long\":1.2}}}"
+
+#define SET_NESTED_LOCATION_COMMAND \
+    "{\"Name\":\"SetLocation\",\"Parameters\":{\"Location\":{\"NestedLocation\":{\"Lat\":42.42,\"Long\":1.2}}}}"
+
+#define CHILD_MODEL_COMMAND \
+    "{\"Name\":\"ChildModel/SetACState\",\"Parameters\":{}}"
 
 static const ACTION_CALLBACK_FUNC TEST_CALLBACK_PTR = (ACTION_CALLBACK_FUNC)0x4343;
-static const char* TEST_IOTHUB_MESSAGE_HANDLE2 = TEST_COMMAND;
-static const MULTITREE_HANDLE TEST_COMMANDS_ROOT_NODE = (MULTITREE_HANDLE)0x4201;
 static const COMMAND_DECODER_HANDLE TEST_COMMAND_DECODER_HANDLE = (COMMAND_DECODER_HANDLE)0x4246;
 
-static bool isIoTHubMessage_GetData_writing_to_outputs = true;
-
 static size_t currentmalloc_call;
 static size_t whenShallmalloc_fail;
 
@@ -134,15 +134,13 @@ static size_t whenShallrealloc_fail;
 TYPED_MOCK_CLASS(CCommandDecoderMocks, CGlobalMock)
 {
 public:
-    /* MultiTree mocks */
-    MOCK_STATIC_METHOD_3(, MULTITREE_RESULT, MultiTree_GetChildByName, MULTITREE_HANDLE, treeHandle, const char*, childName, MULTITREE_HANDLE*, childHandle)
-    MOCK_METHOD_END(MULTITREE_RESULT, MULTITREE_OK)
-    MOCK_STATIC_METHOD_2(, MULTITREE_RESULT, MultiTree_GetValue, MULTITREE_HANDLE, treeHandle, const void**, destination)
-    MOCK_METHOD_END(MULTITREE_RESULT, MULTITREE_OK)
-    MOCK_STATIC_METHOD_2(, MULTITREE_RESULT, MultiTree_GetChildCount, MULTITREE_HANDLE, treeHandle, size_t*, count)
-    MOCK_METHOD_END(MULTITREE_RESULT, MULTITREE_OK)
-    MOCK_STATIC_METHOD_3(, MULTITREE_RESULT, MultiTree_GetChild, MULTITREE_HANDLE, treeHandle, size_t, index, MULTITREE_HANDLE*, childHandle)
-    MOCK_METHOD_END(MULTITREE_RESULT, MULTITREE_OK)
+    /* MultiTree mocks, only needed to link JSONDecoder_JSON_To_MultiTree */
+    MOCK_STATIC_METHOD_2(, MULTITREE_HANDLE, MultiTree_Create, MULTITREE_CLONE_FUNCTION, cloneFunction, MULTITREE_FREE_FUNCTION, freeFunction)
+    MOCK_METHOD_END(MULTITREE_HANDLE, (MULTITREE_HANDLE)NULL)
+    MOCK_STATIC_METHOD_3(, MULTITREE_RESULT, MultiTree_AddChild, MULTITREE_HANDLE, treeHandle, const char*, childName, MULTITREE_HANDLE*, childHandle)
+    MOCK_METHOD_END(MULTITREE_RESULT, MULTITREE_ERROR)
+    MOCK_STATIC_METHOD_2(, MULTITREE_RESULT, MultiTree_SetValue, MULTITREE_HANDLE, treeHandle, void*, value)
+    MOCK_METHOD_END(MULTITREE_RESULT, MULTITREE_ERROR)
     MOCK_STATIC_METHOD_1(, void, MultiTree_Destroy, MULTITREE_HANDLE, treeHandle)
     MOCK_VOID_METHOD_END()
 
@@ -190,29 +188,12 @@ public:
         nCall++;
     }
     MOCK_METHOD_END(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_OK)
-        MOCK_STATIC_METHOD_1(, void, Destroy_AGENT_DATA_TYPE, AGENT_DATA_TYPE*, agentData)
-        MOCK_VOID_METHOD_END()
-        MOCK_STATIC_METHOD_1(, AGENT_DATA_TYPE_TYPE, CodeFirst_GetPrimitiveType, const char*, typeName)
-        MOCK_METHOD_END(AGENT_DATA_TYPE_TYPE, EDM_NO_TYPE)
-
-        ///* IoT Hub mocks */
-    /*MOCK_STATIC_METHOD_3(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_GetData, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, const unsigned char**, buffer, size_t*, size)
-        
-    if (isIoTHubMessage_GetData_writing_to_outputs)
-    {
-        *buffer = (const unsigned char*)TEST_COMMAND;
-        *size = strlen(TEST_COMMAND);
-    }
-        
-    MOCK_METHOD_END(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK)*/
-
-    /* JSON Decoder mocks */
-    MOCK_STATIC_METHOD_2(, JSON_DECODER_RESULT, JSONDecoder_JSON_To_MultiTree, char*, json, MULTITREE_HANDLE*, multiTreeHandle);
-        *multiTreeHandle = TEST_COMMANDS_ROOT_NODE;
-    MOCK_METHOD_END(JSON_DECODER_RESULT, JSON_DECODER_OK)
-
+    MOCK_STATIC_METHOD_1(, void, Destroy_AGENT_DATA_TYPE, AGENT_DATA_TYPE*, agentData)
+    MOCK_VOID_METHOD_END()
+    MOCK_STATIC_METHOD_1(, AGENT_DATA_TYPE_TYPE, CodeFirst_GetPrimitiveType, const char*, typeName)
+    MOCK_METHOD_END(AGENT_DATA_TYPE_TYPE, EDM_NO_TYPE)
 
-        MOCK_STATIC_METHOD_1(, void*, gballoc_malloc, size_t, size)
+    MOCK_STATIC_METHOD_1(, void*, gballoc_malloc, size_t, size)
         void* result2;
     currentmalloc_call++;
     if (whenShallmalloc_fail>0)
@@ -258,10 +239,9 @@ public:
 
 };
 
-DECLARE_GLOBAL_MOCK_METHOD_3(CCommandDecoderMocks, , MULTITREE_RESULT, MultiTree_GetChildByName, MULTITREE_HANDLE, treeHandle, const char*, childName, MULTITREE_HANDLE*, childHandle);
-DECLARE_GLOBAL_MOCK_METHOD_2(CCommandDecoderMocks, , MULTITREE_RESULT, MultiTree_GetValue, MULTITREE_HANDLE, treeHandle, const void**, destination);
-DECLARE_GLOBAL_MOCK_METHOD_2(CCommandDecoderMocks, , MULTITREE_RESULT, MultiTree_GetChildCount, MULTITREE_HANDLE, treeHandle, size_t*, count);
-DECLARE_GLOBAL_MOCK_METHOD_3(CCommandDecoderMocks, , MULTITREE_RESULT, MultiTree_GetChild, MULTITREE_HANDLE, treeHandle, size_t, index, MULTITREE_HANDLE*, childHandle);
+DECLARE_GLOBAL_MOCK_METHOD_2(CCommandDecoderMocks, , MULTITREE_HANDLE, MultiTree_Create, MULTITREE_CLONE_FUNCTION, cloneFunction, MULTITREE_FREE_FUNCTION, freeFunction);
+DECLARE_GLOBAL_MOCK_METHOD_3(CCommandDecoderMocks, , MULTITREE_RESULT, MultiTree_AddChild, MULTITREE_HANDLE, treeHandle, const char*, childName, MULTITREE_HANDLE*, childHandle);
+DECLARE_GLOBAL_MOCK_METHOD_2(CCommandDecoderMocks, , MULTITREE_RESULT, MultiTree_SetValue, MULTITREE_HANDLE, treeHandle, void*, value);
 DECLARE_GLOBAL_MOCK_METHOD_1(CCommandDecoderMocks, , void, MultiTree_Destroy, MULTITREE_HANDLE, treeHandle);
 
 DECLARE_GLOBAL_MOCK_METHOD_5(CCommandDecoderMocks, , EXECUTE_COMMAND_RESULT, ActionCallbackMock, void*, actionCallbackContext, const char*, relativeActionPath, const char*, actionName, size_t, parameterCount, const AGENT_DATA_TYPE*, parameterValues);
@@ -285,10 +265,6 @@ DECLARE_GLOBAL_MOCK_METHOD_5(CCommandDecoderMocks, , AGENT_DATA_TYPES_RESULT, Cr
 DECLARE_GLOBAL_MOCK_METHOD_1(CCommandDecoderMocks, , void, Destroy_AGENT_DATA_TYPE, AGENT_DATA_TYPE*, agentData);
 DECLARE_GLOBAL_MOCK_METHOD_1(CCommandDecoderMocks, , AGENT_DATA_TYPE_TYPE, CodeFirst_GetPrimitiveType, const char*, typeName);
 
-//
-DECLARE_GLOBAL_MOCK_METHOD_2(CCommandDecoderMocks, , JSON_DECODER_RESULT, JSONDecoder_JSON_To_MultiTree, char*, json, MULTITREE_HANDLE*, multiTreeHandle);
-
-
 DECLARE_GLOBAL_MOCK_METHOD_1(CCommandDecoderMocks, , void*, gballoc_malloc, size_t, size);
 DECLARE_GLOBAL_MOCK_METHOD_2(CCommandDecoderMocks, , void*, gballoc_realloc, void*, ptr, size_t, size);
 DECLARE_GLOBAL_MOCK_METHOD_1(CCommandDecoderMocks, , void, gballoc_free, void*, ptr);
@@ -296,26 +272,26 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CCommandDecoderMocks, , void, gballoc_free, void*,
 /* Requirements tested by the virtue of invoking the public API */
 /* Tests_SRS_COMMAND_DECODER_99_001:[ The CommandDecoder module shall expose the following API ... ] */
 
-void SetupCommand(CCommandDecoderMocks* mocks, const char* quotedActionName, const char* actionName)
+/*the calls made when the "Name" value is decoded; the values block is allocated only when the action has arguments*/
+void SetupCommand(CCommandDecoderMocks* mocks, SCHEMA_MODEL_TYPE_HANDLE modelHandle, const char* actionName, SCHEMA_ACTION_HANDLE actionHandle, size_t* argCount)
+{
+    (void)mocks;
+    STRICT_EXPECTED_CALL((*mocks), Schema_GetModelActionByName(modelHandle, actionName))
+        .SetReturn(actionHandle);
+    STRICT_EXPECTED_CALL((*mocks), Schema_GetModelActionArgumentCount(actionHandle, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, argCount, sizeof(*argCount));
+}
+
+void SetupValuesBlock(CCommandDecoderMocks* mocks)
 {
     (void)mocks;
-    STRICT_EXPECTED_CALL((*mocks), JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
-    STRICT_EXPECTED_CALL((*mocks), MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-        .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-    STRICT_EXPECTED_CALL((*mocks), MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-        .CopyOutArgumentBuffer(2, &quotedActionName, sizeof(quotedActionName));
-    STRICT_EXPECTED_CALL((*mocks), gballoc_malloc(IGNORED_NUM_ARG)) /*quotedActionName*/
+    STRICT_EXPECTED_CALL((*mocks), gballoc_malloc(IGNORED_NUM_ARG)) /*values, names and types in one block*/
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL((*mocks), gballoc_free(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL((*mocks), Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-    STRICT_EXPECTED_CALL((*mocks), MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Parameters", IGNORED_PTR_ARG))
-        .CopyOutArgumentBuffer(3, &TEST_COMMAND_ARGS_NODE, sizeof(TEST_COMMAND_ARGS_NODE));
-    STRICT_EXPECTED_CALL((*mocks), Schema_GetModelActionByName(TEST_MODEL_HANDLE, actionName))
-        .SetReturn(SetACStateActionHandle);
 }
 
-void SetupArgumentCalls(CCommandDecoderMocks* mocks, SCHEMA_ACTION_HANDLE actionHandle, size_t index, SCHEMA_ACTION_ARGUMENT_HANDLE argHandle, const char* argName, const char* argType)
+void SetupArgumentCalls(CCommandDecoderMocks* mocks, SCHEMA_ACTION_HANDLE actionHandle, size_t index, SCHEMA_ACTION_ARGUMENT_HANDLE argHandle, const char* argName, const char* argType, AGENT_DATA_TYPE_TYPE primitiveType)
 {
     (void)mocks;
     STRICT_EXPECTED_CALL((*mocks), Schema_GetModelActionArgumentByIndex(actionHandle, index))
@@ -324,6 +300,30 @@ void SetupArgumentCalls(CCommandDecoderMocks* mocks, SCHEMA_ACTION_HANDLE action
         .SetReturn(argName);
     STRICT_EXPECTED_CALL((*mocks), Schema_GetActionArgumentType(argHandle))
         .SetReturn(argType);
+    STRICT_EXPECTED_CALL((*mocks), CodeFirst_GetPrimitiveType(argType))
+        .SetReturn(primitiveType);
+}
+
+void SetupStructCalls(CCommandDecoderMocks* mocks, const char* typeName, SCHEMA_STRUCT_TYPE_HANDLE structTypeHandle, size_t* memberCount)
+{
+    (void)mocks;
+    STRICT_EXPECTED_CALL((*mocks), Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, typeName))
+        .SetReturn(structTypeHandle);
+    STRICT_EXPECTED_CALL((*mocks), Schema_GetStructTypePropertyCount(structTypeHandle, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, memberCount, sizeof(*memberCount));
+}
+
+void SetupMemberCalls(CCommandDecoderMocks* mocks, SCHEMA_STRUCT_TYPE_HANDLE structTypeHandle, size_t index, SCHEMA_PROPERTY_HANDLE propertyHandle, const char* memberName, const char* memberType, AGENT_DATA_TYPE_TYPE primitiveType)
+{
+    (void)mocks;
+    STRICT_EXPECTED_CALL((*mocks), Schema_GetStructTypePropertyByIndex(structTypeHandle, index))
+        .SetReturn(propertyHandle);
+    STRICT_EXPECTED_CALL((*mocks), Schema_GetPropertyName(propertyHandle))
+        .SetReturn(memberName);
+    STRICT_EXPECTED_CALL((*mocks), Schema_GetPropertyType(propertyHandle))
+        .SetReturn(memberType);
+    STRICT_EXPECTED_CALL((*mocks), CodeFirst_GetPrimitiveType(memberType))
+        .SetReturn(primitiveType);
 }
 
 static MICROMOCK_GLOBAL_SEMAPHORE_HANDLE g_dllByDll;
@@ -361,8 +361,6 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         StateAgentDataType.value.edmString.length = COUNT_OF(OtherArgValue);
         StateAgentDataType.value.edmString.chars = (char*)OtherArgValue;
 
-        isIoTHubMessage_GetData_writing_to_outputs = true;
-
         currentmalloc_call = 0;
         whenShallmalloc_fail = 0;
 
@@ -568,19 +566,19 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /*Tests_SRS_COMMAND_DECODER_01_013: [If parsing the JSON to a multi tree fails, the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-    TEST_FUNCTION(When_copying_the_command_content_fails_returns_EXECUTE_COMMAND_ERROR)
+
+    /* Tests_SRS_COMMAND_DECODER_01_013: [If parsing the JSON fails, the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+    TEST_FUNCTION(When_Parsing_The_JSON_Fails_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        whenShallmalloc_fail = currentmalloc_call + 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\" \"SetACState\",\"Parameters\":{}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -590,23 +588,20 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_01_013: [If parsing the JSON to a multi tree fails, the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-    TEST_FUNCTION(When_Parsing_The_JSON_To_MultiTree_Fails_Then_No_Command_Is_Dispatched)
+    /* Tests_SRS_COMMAND_DECODER_01_013: [If parsing the JSON fails, the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+    TEST_FUNCTION(When_The_Command_JSON_Is_Truncated_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2)
-            .SetReturn(JSON_DECODER_INVALID_ARG);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        size_t argCount = 0;
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"SetACState\",\"Parameters\":{}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -616,9 +611,7 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-
-
-    /* Tests_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+    /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
     TEST_FUNCTION(When_Getting_The_Schema_For_The_Model_Fails_Then_No_Command_Is_Dispatched)
     {
         // arrange
@@ -626,16 +619,11 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE))
             .SetReturn((SCHEMA_HANDLE)NULL);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -645,26 +633,18 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(When_Getting_The_ActionName_Node_Fails_Then_No_Command_Is_Dispatched)
+    /* Tests_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(When_The_Command_Is_An_Array_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE))
-            .SetReturn(MULTITREE_INVALID_ARG);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "[" SET_AC_STATE_COMMAND "]");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -674,28 +654,18 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(When_Getting_The_ActionName_Fails_Then_No_Command_Is_Dispatched)
+    /* Tests_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(When_The_Name_Is_Missing_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedSetACStateName, sizeof(quotedSetACStateName))
-            .SetReturn(MULTITREE_INVALID_ARG);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Parameters\":{\"State\":true}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -705,34 +675,22 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(When_Getting_The_Parameters_Node_Fails_Then_No_Command_Is_Dispatched)
+    /* Tests_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(When_The_Parameters_Are_Missing_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedSetACStateName, sizeof(quotedSetACStateName));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Parameters", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_ARGS_NODE, sizeof(TEST_COMMAND_ARGS_NODE))
-            .SetReturn(MULTITREE_INVALID_ARG);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        size_t argCount = 1;
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"SetACState\"}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -742,31 +700,18 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(When_Copying_The_relativepath_fails_EXECUTE_COMMAND_ERROR_is_returned)
+    /* Tests_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(When_The_Name_Is_Not_A_String_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedSetACStateName, sizeof(quotedSetACStateName));
-        whenShallmalloc_fail = currentmalloc_call + 2;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":42,\"Parameters\":{}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -776,36 +721,18 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-    TEST_FUNCTION(When_GetModelActionByName_Fails_Then_No_Command_Is_Dispatched)
+    /* Tests_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(When_The_Name_Is_An_Object_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedSetACStateName, sizeof(quotedSetACStateName));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Parameters", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_ARGS_NODE, sizeof(TEST_COMMAND_ARGS_NODE));
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionByName(TEST_MODEL_HANDLE, setACStateName))
-            .SetReturn((SCHEMA_ACTION_HANDLE)NULL);
-
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":{},\"Parameters\":{}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -815,44 +742,41 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-    TEST_FUNCTION(When_Getting_The_ArgCount_Fails_Then_No_Command_Is_Dispatched)
+    /* Tests_SRS_COMMAND_DECODER_02_004: [ If the command is not a JSON object, "Name" is not a string, or "Name" or "Parameters" is missing, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(When_The_actionname_Contains_Only_2_Quotes_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        const char* quotedActionName = "\"SetACState\"";
-        const char* actionName = "SetACState";
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+
+        // act
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"\",\"Parameters\":{}}");
+
+        // assert
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /* Tests_SRS_COMMAND_DECODER_02_005: [ If "Name", "Parameters", an action argument or a struct member appears more than once in the same object then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(When_The_Name_Appears_Twice_Then_No_Command_Is_Dispatched)
+    {
+        // arrange
+        CCommandDecoderMocks mocks;
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedActionName, sizeof(quotedActionName));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1); 
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Parameters", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_ARGS_NODE, sizeof(TEST_COMMAND_ARGS_NODE));
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionByName(TEST_MODEL_HANDLE, actionName))
-            .SetReturn(SetACStateActionHandle);
         size_t argCount = 0;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount))
-            .SetReturn(SCHEMA_ERROR);
-
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
 
         // act
-
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"SetACState\",\"Name\":\"SetACState\",\"Parameters\":{}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -862,29 +786,20 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    TEST_FUNCTION(When_The_actionname_Contains_Only_One_Quote_No_Command_Is_Dispatched)
+    /* Tests_SRS_COMMAND_DECODER_02_007: [ If the action path is longer than COMMAND_DECODER_MAX_ACTION_PATH_LENGTH characters then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(When_The_Action_Path_Is_Too_Long_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        const char* quotedActionName = "\"";
+        std::string command = "{\"Name\":\"" + std::string(COMMAND_DECODER_MAX_ACTION_PATH_LENGTH + 1, 'a') + "\",\"Parameters\":{}}";
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedActionName, sizeof(quotedActionName));
-
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, command.c_str());
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -894,33 +809,47 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    TEST_FUNCTION(When_The_actionname_Contains_Only_2_Quotes_No_Command_Is_Dispatched)
+    /* Tests_SRS_COMMAND_DECODER_99_009:[ CommandDecoder shall call Schema_GetModelActionByName to obtain the information about a specific action.] */
+    /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+    TEST_FUNCTION(When_GetModelActionByName_Fails_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        const char* quotedActionName = "\"\"";
-
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedActionName, sizeof(quotedActionName));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionByName(TEST_MODEL_HANDLE, setACStateName))
+            .SetReturn((SCHEMA_ACTION_HANDLE)NULL);
+
+        // act
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_COMMAND);
+
+        // assert
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+    TEST_FUNCTION(When_Getting_The_ArgCount_Fails_Then_No_Command_Is_Dispatched)
+    {
+        // arrange
+        CCommandDecoderMocks mocks;
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionByName(TEST_MODEL_HANDLE, setACStateName))
+            .SetReturn(SetACStateActionHandle);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(SCHEMA_ERROR);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -930,28 +859,23 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /*Tests_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.]*/
-    TEST_FUNCTION(CommandDecoder_ExecuteCommand_fails_when_array_of_args_fails)
+    /* Tests_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
+    TEST_FUNCTION(When_Allocating_The_Arguments_Fails_Then_No_Command_Is_Dispatched)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        whenShallmalloc_fail = currentmalloc_call + 3;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        whenShallmalloc_fail = currentmalloc_call + 1;
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -961,11 +885,14 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
+    /* Tests_SRS_COMMAND_DECODER_02_001: [ CommandDecoder shall decode the command JSON with JSONDecoder_Parse directly from the command string, without copying it and without building a MultiTree. ]*/
+    /* Tests_SRS_COMMAND_DECODER_02_002: [ The values shall be decoded into an array pre-sized from the Schema APIs, allocated in a single block together with their names and types. ]*/
+    /* Tests_SRS_COMMAND_DECODER_99_006:[ The action name shall be decoded from the element "Name" of the command JSON.] */
     /* Tests_SRS_COMMAND_DECODER_99_011:[ CommandDecoder shall attempt to extract the command arguments from the command JSON by looking them up under the node "Parameters".] */
+    /* Tests_SRS_COMMAND_DECODER_01_008: [Each argument shall be looked up as a field, member of the "Parameters" node.] */
     /* Tests_SRS_COMMAND_DECODER_99_027:[ The value for an argument of primitive type shall be decoded by using the CreateAgentDataType_From_String API.] */
-    /* Tests_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
-    /* Tests_SRS_COMMAND_DECODER_99_005:[ If an action is decoded successfully then the callback actionCallback shall be called, passing to it the callback action context, decoded name and arguments.] */
-    /* Tests_SRS_COMMAND_DECODER_01_008: [Each argument shall be looked up as a field, member of the "Parameters" node.]  */
+    /* Tests_SRS_COMMAND_DECODER_99_005:[ If an Invoke Action is decoded successfully then the callback actionCallback shall be called, passing to it the callback action context, decoded name and arguments.] */
+    /* Tests_SRS_COMMAND_DECODER_02_011: [ All the decoded values shall be freed before CommandDecoder_ExecuteCommand returns. ]*/
     TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_Valid_Command_With_1_Arg_Decodes_The_Argument_And_Calls_The_ActionCallback)
     {
         // arrange
@@ -973,36 +900,49 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(stateValue, EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("true", EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
             .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
-
-        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", "SetACState", 1, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", setACStateName, 1, IGNORED_PTR_ARG))
             .IgnoreArgument(5);
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+        // act
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_COMMAND);
+
+        // assert
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /* Tests_SRS_COMMAND_DECODER_02_003: [ If "Parameters" precedes "Name", CommandDecoder shall record where "Parameters" begins and ends and decode it with a second JSONDecoder_Parse once the action is known. ]*/
+    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_Parameters_Before_Name_Decodes_The_Argument_And_Calls_The_ActionCallback)
+    {
+        // arrange
+        CCommandDecoderMocks mocks;
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        mocks.ResetAllCalls();
 
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        size_t argCount = 1;
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("true", EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", setACStateName, 1, IGNORED_PTR_ARG))
+            .IgnoreArgument(5);
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Parameters\":{\"State\":true},\"Name\":\"SetACState\"}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
@@ -1012,34 +952,30 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-    TEST_FUNCTION(CommandDecoder_When_GetModelActionArgumentByIndex_Fails_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_02_006: [ Members that are not "Name", "Parameters", an action argument or a struct member shall be skipped. ]*/
+    TEST_FUNCTION(CommandDecoder_ExecuteCommand_Skips_Unknown_Members)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentByIndex(SetACStateActionHandle, 0))
-            .SetReturn((SCHEMA_ACTION_ARGUMENT_HANDLE)NULL);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("true", EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", setACStateName, 1, IGNORED_PTR_ARG))
+            .IgnoreArgument(5);
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Id\":\"1\",\"Name\":\"SetACState\",\"Parameters\":{\"Other\":[1,{\"State\":2}],\"State\":true,\"More\":{\"State\":3}},\"Trace\":{\"a\":[]}}");
 
         // assert
-        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
         mocks.AssertActualAndExpectedCalls();
 
         // cleanup
@@ -1047,32 +983,22 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
     }
 
     /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-    TEST_FUNCTION(CommandDecoder_When_GetActionArgumentName_Fails_ExecuteCommand_Fails)
+    TEST_FUNCTION(CommandDecoder_When_GetModelActionArgumentByIndex_Fails_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
+
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
         STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentByIndex(SetACStateActionHandle, 0))
-            .SetReturn(StateActionArgument);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetActionArgumentName(StateActionArgument))
-            .SetReturn((const char*)NULL);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+            .SetReturn((SCHEMA_ACTION_ARGUMENT_HANDLE)NULL);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1083,34 +1009,24 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
     }
 
     /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-    TEST_FUNCTION(CommandDecoder_When_GetActionArgumentType_Fails_ExecuteCommand_Fails)
+    TEST_FUNCTION(CommandDecoder_When_GetActionArgumentName_Fails_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
+
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
         STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentByIndex(SetACStateActionHandle, 0))
             .SetReturn(StateActionArgument);
         STRICT_EXPECTED_CALL(mocks, Schema_GetActionArgumentName(StateActionArgument))
-            .SetReturn(StateActionArgument_Name);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetActionArgumentType(StateActionArgument))
             .SetReturn((const char*)NULL);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1120,33 +1036,27 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(CommandDecoder_When_Getting_The_Argument_Node_Fails_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+    TEST_FUNCTION(CommandDecoder_When_GetActionArgumentType_Fails_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
+
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE))
-            .SetReturn(MULTITREE_INVALID_ARG);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentByIndex(SetACStateActionHandle, 0))
+            .SetReturn(StateActionArgument);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetActionArgumentName(StateActionArgument))
+            .SetReturn(StateActionArgument_Name);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetActionArgumentType(StateActionArgument))
+            .SetReturn((const char*)NULL);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1156,38 +1066,22 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(CommandDecoder_When_Getting_The_Argument_Node_Value_Fails_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+    TEST_FUNCTION(CommandDecoder_When_An_Argument_Is_Missing_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
+
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue))
-            .SetReturn(MULTITREE_INVALID_ARG);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"SetACState\",\"Parameters\":{\"state\":true}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1197,40 +1091,25 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+    /* Tests_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
     TEST_FUNCTION(CommandDecoder_When_Decoding_The_Argument_Value_Fails_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
+
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(stateValue, EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType))
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("true", EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
+            .IgnoreArgument(3)
             .SetReturn(AGENT_DATA_TYPES_INVALID_ARG);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1240,10 +1119,8 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_011:[ CommandDecoder shall attempt to extract from the command text the value for each action argument.] */
-    /* Tests_SRS_COMMAND_DECODER_99_027:[ The value for an argument of primitive type shall be decoded by using the CreateAgentDataType_From_String API.] */
-    /* Tests_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
-    /* Tests_SRS_COMMAND_DECODER_99_005:[ If an action is decoded successfully then the callback actionCallback shall be called, passing to it the callback action context, decoded name and arguments.] */
+    /* Tests_SRS_COMMAND_DECODER_01_008: [Each argument shall be looked up as a field, member of the "Parameters" node.] */
+    /* Tests_SRS_COMMAND_DECODER_99_005:[ If an Invoke Action is decoded successfully then the callback actionCallback shall be called, passing to it the callback action context, decoded name and arguments.] */
     TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_Valid_Command_With_2_Args_Decodes_The_Arguments_And_Calls_The_ActionCallback)
     {
         // arrange
@@ -1251,53 +1128,23 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        /* arg 1 */
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(stateValue, EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 1, OtherArgActionArgument, OtherArgActionArgument_Name, OtherArgActionArgument_Type, EDM_STRING_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("true", EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
             .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
-
-        /* arg 2 */
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 1, OtherArgActionArgument, OtherArgActionArgument_Name, OtherArgActionArgument_Type);
-        const char* otherArgValue = OtherArgValue;
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "OtherArg", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG2_NODE, sizeof(TEST_ARG2_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("ascii_char_ptr"))
-            .SetReturn(EDM_STRING_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG2_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &otherArgValue, sizeof(otherArgValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(otherArgValue, EDM_STRING_TYPE, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("\"SomeString\"", EDM_STRING_TYPE, IGNORED_PTR_ARG))
             .CopyOutArgumentBuffer(3, &OtherArgAgentDataType, sizeof(OtherArgAgentDataType));
-
-        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", "SetACState", 2, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", setACStateName, 2, IGNORED_PTR_ARG))
             .IgnoreArgument(5);
-
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_2_ARGS_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
@@ -1314,41 +1161,17 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        /* arg 1 */
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
 
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(stateValue, EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
-
-        /* arg 2 */
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
         STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentByIndex(SetACStateActionHandle, 1))
             .SetReturn((SCHEMA_ACTION_ARGUMENT_HANDLE)NULL);
 
-        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
-
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_2_ARGS_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1358,50 +1181,30 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-    TEST_FUNCTION(CommandDecoder_When_GetArgument_Name_For_The_2nd_Argument_Fails_Then_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+    /* Tests_SRS_COMMAND_DECODER_02_011: [ All the decoded values shall be freed before CommandDecoder_ExecuteCommand returns. ]*/
+    TEST_FUNCTION(CommandDecoder_When_Creating_The_Agent_Data_Type_For_The_2nd_Argument_Fails_Then_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        /* arg 1 */
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(stateValue, EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 1, OtherArgActionArgument, OtherArgActionArgument_Name, OtherArgActionArgument_Type, EDM_STRING_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("true", EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
             .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
-
-        /* arg 2 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentByIndex(SetACStateActionHandle, 1))
-            .SetReturn(OtherArgActionArgument);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetActionArgumentName(OtherArgActionArgument))
-            .SetReturn((const char*)NULL);
-
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("\"SomeString\"", EDM_STRING_TYPE, IGNORED_PTR_ARG))
+            .IgnoreArgument(3)
+            .SetReturn(AGENT_DATA_TYPES_INVALID_ARG);
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_AC_STATE_2_ARGS_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1411,52 +1214,26 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-    TEST_FUNCTION(CommandDecoder_When_GetArgument_Type_For_The_2nd_Argument_Fails_Then_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_02_005: [ If "Name", "Parameters", an action argument or a struct member appears more than once in the same object then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    /* Tests_SRS_COMMAND_DECODER_02_010: [ The actionCallback shall be called only after the whole command has been decoded successfully. ]*/
+    TEST_FUNCTION(CommandDecoder_When_An_Argument_Appears_Twice_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        /* arg 1 */
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        size_t argCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(stateValue, EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        size_t argCount = 1;
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("true", EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
             .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
-
-        /* arg 2 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentByIndex(SetACStateActionHandle, 1))
-            .SetReturn(OtherArgActionArgument);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetActionArgumentName(OtherArgActionArgument))
-            .SetReturn(OtherArgActionArgument_Name);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetActionArgumentType(OtherArgActionArgument))
-            .SetReturn((const char*)NULL);
-
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"SetACState\",\"Parameters\":{\"State\":true,\"State\":false}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1466,50 +1243,22 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(CommandDecoder_When_GetChildName_For_The_2nd_Argument_Fails_Then_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_02_009: [ If an argument of complex type does not have a JSON object value, or an argument of primitive type has a JSON object or array value, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(CommandDecoder_When_A_Primitive_Argument_Has_An_Object_Value_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-    
-        /* arg 1 */
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        size_t argCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(stateValue, EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
-
-        /* arg 2 */
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 1, OtherArgActionArgument, OtherArgActionArgument_Name, OtherArgActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "OtherArg", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG2_NODE, sizeof(TEST_ARG2_NODE))
-            .SetReturn(MULTITREE_INVALID_ARG);
-
-        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        size_t argCount = 1;
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"SetACState\",\"Parameters\":{\"State\":{\"value\":true}}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1519,55 +1268,22 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(CommandDecoder_When_GetValue_For_The_2nd_Argument_Fails_Then_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_02_009: [ If an argument of complex type does not have a JSON object value, or an argument of primitive type has a JSON object or array value, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(CommandDecoder_When_A_Primitive_Argument_Has_An_Array_Value_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        /* arg 1 */
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        size_t argCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(stateValue, EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
-
-        /* arg 2 */
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 1, OtherArgActionArgument, OtherArgActionArgument_Name, OtherArgActionArgument_Type);
-        const char* otherArgValue = OtherArgValue;
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "OtherArg", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG2_NODE, sizeof(TEST_ARG2_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("ascii_char_ptr"))
-            .SetReturn(EDM_STRING_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG2_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &otherArgValue, sizeof(otherArgValue))
-            .SetReturn(MULTITREE_INVALID_ARG);
-
-        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        size_t argCount = 1;
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type, EDM_BOOLEAN_TYPE);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"SetACState\",\"Parameters\":{\"State\":[true]}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1577,216 +1293,109 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(CommandDecoder_When_Creating_The_Agent_Data_Type_For_The_2nd_Argument_Fails_Then_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_99_027:[ The value for an argument of primitive type shall be decoded by using the CreateAgentDataType_From_String API.] */
+    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Long_Argument_Value_Decodes_It_From_A_Heap_Copy)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        /* arg 1 */
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        size_t argCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
+        std::string longValue = "\"" + std::string(100, 'x') + "\"";
+        std::string command = "{\"Name\":\"SetACState\",\"Parameters\":{\"OtherArg\":" + longValue + "}}";
+
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        size_t argCount = 1;
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, OtherArgActionArgument, OtherArgActionArgument_Name, OtherArgActionArgument_Type, EDM_STRING_TYPE);
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(longValue.length() + 1));
         STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, StateActionArgument, StateActionArgument_Name, StateActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "State", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        const char* stateValue = "true";
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("bool"))
-            .SetReturn(EDM_BOOLEAN_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &stateValue, sizeof(stateValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(stateValue, EDM_BOOLEAN_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &StateAgentDataType, sizeof(StateAgentDataType));
-
-        /* arg 2 */
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 1, OtherArgActionArgument, OtherArgActionArgument_Name, OtherArgActionArgument_Type);
-        const char* otherArgValue = OtherArgValue;
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "OtherArg", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG2_NODE, sizeof(TEST_ARG2_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("ascii_char_ptr"))
-            .SetReturn(EDM_STRING_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_ARG2_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &otherArgValue, sizeof(otherArgValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(otherArgValue, EDM_STRING_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &OtherArgAgentDataType, sizeof(OtherArgAgentDataType))
-            .SetReturn(AGENT_DATA_TYPES_INVALID_ARG);
-
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(longValue.c_str(), EDM_STRING_TYPE, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(3, &OtherArgAgentDataType, sizeof(OtherArgAgentDataType));
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", setACStateName, 1, IGNORED_PTR_ARG))
+            .IgnoreArgument(5);
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, command.c_str());
 
         // assert
-        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
         mocks.AssertActualAndExpectedCalls();
 
         // cleanup
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_029:[ If the argument type is complex then a complex type value shall be built from the child nodes.] */
-    /* Tests_SRS_COMMAND_DECODER_99_030:[ For each child node a value shall be built by using AgentTypeSystem APIs.] */
-    /* Tests_SRS_COMMAND_DECODER_99_031:[ The complex type value that aggregates the children shall be built by using the Create_AGENT_DATA_TYPE_from_Members.] */
-    /* Tests_SRS_COMMAND_DECODER_99_033:[ In order to determine which are the members of a complex types, Schema APIs for structure types shall be used.] */
-    /* Tests_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
-    /* Tests_SRS_COMMAND_DECODER_99_005:[ If an action is decoded successfully then the callback actionCallback shall be called, passing to it the callback action context, decoded name and arguments.] */
-    TEST_FUNCTION(CommandDecoder_When_The_Argument_Is_Complex_The_Nodes_Are_Scanned_To_Get_The_Members)
+    /* Tests_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
+    TEST_FUNCTION(CommandDecoder_When_Copying_A_Long_Argument_Value_Fails_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
+        std::string longValue = "\"" + std::string(100, 'x') + "\"";
+        std::string command = "{\"Name\":\"SetACState\",\"Parameters\":{\"OtherArg\":" + longValue + "}}";
 
-        SetupCommand(&mocks, quotedSetLocationName, setLocationName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
-            .SetReturn(memberProperty1);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty1))
-            .SetReturn("Lat");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty1))
-            .SetReturn("double");
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_ARG1_NODE, "Lat", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_MEMBER1_NODE, sizeof(TEST_MEMBER1_NODE));
-        const char* latValue = "42.42";
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("double"))
-            .SetReturn(EDM_DOUBLE_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_MEMBER1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &latValue, sizeof(latValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(latValue, EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &LatAgentDataType, sizeof(LatAgentDataType));
-
-        /* member 2 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 1))
-            .SetReturn(memberProperty2);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty2))
-            .SetReturn("Long");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty2))
-            .SetReturn("double");
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_ARG1_NODE, "Long", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_MEMBER2_NODE, sizeof(TEST_MEMBER2_NODE));
-        const char * longValue = "1.2";
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("double"))
-            .SetReturn(EDM_DOUBLE_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_MEMBER2_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &longValue, sizeof(longValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(longValue, EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &LongAgentDataType, sizeof(LongAgentDataType));
-
-        EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_Members(IGNORED_PTR_ARG, "GeoLocation", 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .ValidateArgument(2).ValidateArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", "SetLocation", 1, IGNORED_PTR_ARG))
-            .IgnoreArgument(5);
-
-        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, OtherArgActionArgument, OtherArgActionArgument_Name, OtherArgActionArgument_Type, EDM_STRING_TYPE);
+        whenShallmalloc_fail = currentmalloc_call + 2;
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(longValue.length() + 1));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, command.c_str());
 
         // assert
-        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
         mocks.AssertActualAndExpectedCalls();
-        ASSERT_ARE_EQUAL(char_ptr, "Lat", lastMemberNames[0][0]);
-        ASSERT_ARE_EQUAL(char_ptr, "Long", lastMemberNames[0][1]);
 
         // cleanup
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /*Tests_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.]*/
-    TEST_FUNCTION(CommandDecoder_When_The_Argument_Is_Complex_The_Nodes_Are_Scanned_To_Get_The_Members_and_fail_when_gbaloc_fails_1)
+    /* Tests_SRS_COMMAND_DECODER_99_029:[ If the argument type is complex then a complex type value shall be built from the child nodes.] */
+    /* Tests_SRS_COMMAND_DECODER_99_033:[ In order to determine which are the members of a complex types, Schema APIs for structure types shall be used.] */
+    /* Tests_SRS_COMMAND_DECODER_99_031:[ The complex type value that aggregates the children shall be built by using the Create_AGENT_DATA_TYPE_from_Members.] */
+    TEST_FUNCTION(CommandDecoder_When_The_Argument_Is_Complex_The_Members_Are_Decoded)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-
-        SetupCommand(&mocks, quotedSetLocationName, setLocationName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
         size_t memberCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        whenShallmalloc_fail = currentmalloc_call + 5;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        SetupValuesBlock(&mocks);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 0, memberProperty1, "Lat", "double", EDM_DOUBLE_TYPE);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 1, memberProperty2, "Long", "double", EDM_DOUBLE_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("42.42", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(3, &LatAgentDataType, sizeof(LatAgentDataType));
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("1.2", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(3, &LongAgentDataType, sizeof(LongAgentDataType));
+        EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_Members(IGNORED_PTR_ARG, "GeoLocation", 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .ValidateArgument(2).ValidateArgument(3);
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", setLocationName, 1, IGNORED_PTR_ARG))
+            .IgnoreArgument(5);
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
-        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
         mocks.AssertActualAndExpectedCalls();
         ASSERT_ARE_EQUAL(char_ptr, "Lat", lastMemberNames[0][0]);
         ASSERT_ARE_EQUAL(char_ptr, "Long", lastMemberNames[0][1]);
@@ -1795,57 +1404,36 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /*Tests_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.]*/
-    TEST_FUNCTION(CommandDecoder_When_The_Argument_Is_Complex_The_Nodes_Are_Scanned_To_Get_The_Members_and_fail_when_gbaloc_fails_2)
+    /* Tests_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
+    TEST_FUNCTION(CommandDecoder_When_Allocating_The_Members_Of_A_Complex_Argument_Fails_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-
-        SetupCommand(&mocks, quotedSetLocationName, setLocationName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
         size_t memberCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        whenShallmalloc_fail = currentmalloc_call + 4;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        whenShallmalloc_fail = currentmalloc_call + 2;
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
-
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
         mocks.AssertActualAndExpectedCalls();
-        ASSERT_ARE_EQUAL(char_ptr, "Lat", lastMemberNames[0][0]);
-        ASSERT_ARE_EQUAL(char_ptr, "Long", lastMemberNames[0][1]);
 
         // cleanup
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_029:[ If the argument type is complex then a complex type value shall be built from the child nodes.] */
     /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
     TEST_FUNCTION(CommandDecoder_When_Getting_The_Structure_Type_For_A_Complex_Type_Fails_Then_ExecuteCommand_Fails)
     {
@@ -1853,31 +1441,17 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
         STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
             .SetReturn((SCHEMA_STRUCT_TYPE_HANDLE)NULL);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1887,7 +1461,6 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_029:[ If the argument type is complex then a complex type value shall be built from the child nodes.] */
     /* Tests_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
     TEST_FUNCTION(CommandDecoder_When_Getting_The_Structure_PropertyCount_For_A_Complex_Type_Fails_Then_ExecuteCommand_Fails)
     {
@@ -1895,35 +1468,20 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
         STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
             .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 1;
         STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount))
+            .IgnoreArgument(2)
             .SetReturn(SCHEMA_ERROR);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1940,34 +1498,17 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
         size_t memberCount = 0;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -1984,46 +1525,21 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
+        size_t memberCount = 2;
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        SetupValuesBlock(&mocks);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 0, memberProperty1, "Lat", "double", EDM_DOUBLE_TYPE);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 1))
             .SetReturn((SCHEMA_PROPERTY_HANDLE)NULL);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -2040,48 +1556,22 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1 */
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
+        size_t memberCount = 2;
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        SetupValuesBlock(&mocks);
         STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
             .SetReturn(memberProperty1);
         STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty1))
             .SetReturn((const char*)NULL);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -2098,51 +1588,24 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        
-        size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
 
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1 */
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        size_t argCount = 1;
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
+        size_t memberCount = 2;
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        SetupValuesBlock(&mocks);
         STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
             .SetReturn(memberProperty1);
         STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty1))
             .SetReturn("Lat");
         STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty1))
             .SetReturn((const char*)NULL);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -2152,60 +1615,31 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(CommandDecoder_When_Getting_The_Child_Node_For_A_Member_Property_For_A_Complex_Type_Fails_Then_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_99_012:[ If any argument is missing in the command text then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+    /* Tests_SRS_COMMAND_DECODER_02_011: [ All the decoded values shall be freed before CommandDecoder_ExecuteCommand returns. ]*/
+    TEST_FUNCTION(CommandDecoder_When_A_Member_Of_A_Complex_Argument_Is_Missing_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
-            .SetReturn(memberProperty1);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty1))
-            .SetReturn("Lat");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty1))
-            .SetReturn("double");
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_ARG1_NODE, "Lat", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_MEMBER1_NODE, sizeof(TEST_MEMBER1_NODE))
-            .SetReturn(MULTITREE_INVALID_ARG);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
+        size_t memberCount = 2;
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        SetupValuesBlock(&mocks);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 0, memberProperty1, "Lat", "double", EDM_DOUBLE_TYPE);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 1, memberProperty2, "Long", "double", EDM_DOUBLE_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("42.42", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(3, &LatAgentDataType, sizeof(LatAgentDataType));
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"SetLocation\",\"Parameters\":{\"Location\":{\"Lat\":42.42}}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -2215,65 +1649,30 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_01_015: [If any MultiTree API call fails then the processing shall stop and the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(CommandDecoder_When_Getting_The_Child_Value_For_A_Member_Property_For_A_Complex_Type_Fails_Then_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+    TEST_FUNCTION(CommandDecoder_When_Creating_The_Agent_Data_Type_Value_For_A_Member_Property_For_A_Complex_Type_Fails_Then_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
-            .SetReturn(memberProperty1);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty1))
-            .SetReturn("Lat");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty1))
-            .SetReturn("double");
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("double"))
-            .SetReturn(EDM_DOUBLE_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_ARG1_NODE, "Lat", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_MEMBER1_NODE, sizeof(TEST_MEMBER1_NODE));
-        const char* latValue = "42.42";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_MEMBER1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &latValue, sizeof(latValue))
-            .SetReturn(MULTITREE_INVALID_ARG);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
+        size_t memberCount = 2;
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        SetupValuesBlock(&mocks);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 0, memberProperty1, "Lat", "double", EDM_DOUBLE_TYPE);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 1, memberProperty2, "Long", "double", EDM_DOUBLE_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("42.42", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+            .IgnoreArgument(3)
+            .SetReturn(AGENT_DATA_TYPES_INVALID_ARG);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -2284,66 +1683,33 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
     }
 
     /* Tests_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(CommandDecoder_When_Creating_The_Agent_Data_Type_Value_For_A_Member_Property_For_A_Complex_Type_Fails_Then_ExecuteCommand_Fails)
+    /* Tests_SRS_COMMAND_DECODER_02_011: [ All the decoded values shall be freed before CommandDecoder_ExecuteCommand returns. ]*/
+    TEST_FUNCTION(CommandDecoder_When_Decoding_The_2nd_Member_Of_A_Complex_Property_Fails_Execute_Command_Frees_The_Previously_Allocated_Member)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
-            .SetReturn(memberProperty1);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty1))
-            .SetReturn("Lat");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty1))
-            .SetReturn("double");
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("double"))
-            .SetReturn(EDM_DOUBLE_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_ARG1_NODE, "Lat", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_MEMBER1_NODE, sizeof(TEST_MEMBER1_NODE));
-        const char* latValue = "42.42";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_MEMBER1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &latValue, sizeof(latValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(latValue, EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &LatAgentDataType, sizeof(LatAgentDataType))
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
+        size_t memberCount = 2;
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        SetupValuesBlock(&mocks);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 0, memberProperty1, "Lat", "double", EDM_DOUBLE_TYPE);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 1, memberProperty2, "Long", "double", EDM_DOUBLE_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("42.42", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(3, &LatAgentDataType, sizeof(LatAgentDataType));
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("1.2", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+            .IgnoreArgument(3)
             .SetReturn(AGENT_DATA_TYPES_INVALID_ARG);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -2360,65 +1726,29 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
-            .SetReturn(memberProperty1);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty1))
-            .SetReturn("Lat");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty1))
-            .SetReturn("double");
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("double"))
-            .SetReturn(EDM_DOUBLE_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_ARG1_NODE, "Lat", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_MEMBER1_NODE, sizeof(TEST_MEMBER1_NODE));
-        const char* latValue = "42.42";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_MEMBER1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &latValue, sizeof(latValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(latValue, EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
+        size_t memberCount = 2;
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        SetupValuesBlock(&mocks);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 0, memberProperty1, "Lat", "double", EDM_DOUBLE_TYPE);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 1, memberProperty2, "Long", "double", EDM_DOUBLE_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("42.42", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
             .CopyOutArgumentBuffer(3, &LatAgentDataType, sizeof(LatAgentDataType));
-
-        EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_Members(IGNORED_PTR_ARG, "GeoLocation", 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("1.2", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(3, &LongAgentDataType, sizeof(LongAgentDataType));
+        EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_Members(IGNORED_PTR_ARG, "GeoLocation", 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .ValidateArgument(2).ValidateArgument(3)
-            .SetReturn(AGENT_DATA_TYPES_INVALID_ARG);
-
+            .SetReturn(AGENT_DATA_TYPES_ERROR);
+        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -2428,72 +1758,22 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    TEST_FUNCTION(CommandDecoder_When_Decoding_The_2nd_Member_Of_A_Complex_Property_Fails_Execute_Command_Frees_The_Previously_Allocated_Member)
+    /* Tests_SRS_COMMAND_DECODER_02_009: [ If an argument of complex type does not have a JSON object value, or an argument of primitive type has a JSON object or array value, the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(CommandDecoder_When_A_Complex_Argument_Has_A_Scalar_Value_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetACStateName, setACStateName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
-        size_t memberCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
-            .SetReturn(memberProperty1);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty1))
-            .SetReturn("Lat");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty1))
-            .SetReturn("double");
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("double"))
-            .SetReturn(EDM_DOUBLE_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_ARG1_NODE, "Lat", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_MEMBER1_NODE, sizeof(TEST_MEMBER1_NODE));
-        const char* latValue = "42.42";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_MEMBER1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &latValue, sizeof(latValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(latValue, EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &LatAgentDataType, sizeof(LatAgentDataType));
-
-        /* member 2 */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 1))
-            .SetReturn((SCHEMA_PROPERTY_HANDLE)NULL);
-
-        EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"SetLocation\",\"Parameters\":{\"Location\":42}}");
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -2510,115 +1790,43 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
-        
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
 
-        SetupCommand(&mocks, quotedSetLocationName, setLocationName);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         size_t argCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetLocationActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating memory for the argument array*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type, EDM_NO_TYPE);
 
-        SetupArgumentCalls(&mocks, SetACStateActionHandle, 0, LocationActionArgument, LocationActionArgument_Name, LocationActionArgument_Type);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ARGS_NODE, "Location", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_ARG1_NODE, sizeof(TEST_ARG1_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("GeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "GeoLocation"))
-            .SetReturn(TEST_STRUCT_1_HANDLE);
         size_t memberCount = 1;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_1_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1, nested complex type */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_1_HANDLE, 0))
-            .SetReturn(memberNestedComplexTypeProperty);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberNestedComplexTypeProperty))
-            .SetReturn("NestedLocation");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberNestedComplexTypeProperty))
-            .SetReturn("NestedGeoLocation");
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_ARG1_NODE, "NestedLocation", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_NESTED_STRUCT_NODE, sizeof(TEST_NESTED_STRUCT_NODE));
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("NestedGeoLocation"))
-            .SetReturn(EDM_NO_TYPE);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypeByName(TEST_SCHEMA_HANDLE, "NestedGeoLocation"))
-            .SetReturn(TEST_STRUCT_2_HANDLE);
-        memberCount = 2;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyCount(TEST_STRUCT_2_HANDLE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &memberCount, sizeof(memberCount));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member values of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is allocating the member names of the struct*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        /* member 1, nested */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_2_HANDLE, 0))
-            .SetReturn(memberProperty1);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty1))
-            .SetReturn("Lat");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty1))
-            .SetReturn("double");
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("double"))
-            .SetReturn(EDM_DOUBLE_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_NESTED_STRUCT_NODE, "Lat", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_MEMBER1_NODE, sizeof(TEST_MEMBER1_NODE));
-        const char* latValue = "42.42";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_MEMBER1_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &latValue, sizeof(latValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(latValue, EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+        SetupStructCalls(&mocks, "GeoLocation", TEST_STRUCT_1_HANDLE, &memberCount);
+        SetupValuesBlock(&mocks);
+        SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 0, memberNestedComplexTypeProperty, "NestedLocation", "NestedGeoLocation", EDM_NO_TYPE);
+
+        size_t nestedMemberCount = 2;
+        SetupStructCalls(&mocks, "NestedGeoLocation", TEST_STRUCT_2_HANDLE, &nestedMemberCount);
+        SetupValuesBlock(&mocks);
+        SetupMemberCalls(&mocks, TEST_STRUCT_2_HANDLE, 0, memberProperty1, "Lat", "double", EDM_DOUBLE_TYPE);
+        SetupMemberCalls(&mocks, TEST_STRUCT_2_HANDLE, 1, memberProperty2, "Long", "double", EDM_DOUBLE_TYPE);
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("42.42", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
             .CopyOutArgumentBuffer(3, &LatAgentDataType, sizeof(LatAgentDataType));
-
-        /* member 2, nested */
-        STRICT_EXPECTED_CALL(mocks, Schema_GetStructTypePropertyByIndex(TEST_STRUCT_2_HANDLE, 1))
-            .SetReturn(memberProperty2);
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyName(memberProperty2))
-            .SetReturn("Long");
-        STRICT_EXPECTED_CALL(mocks, Schema_GetPropertyType(memberProperty2))
-            .SetReturn("double");
-        STRICT_EXPECTED_CALL(mocks, CodeFirst_GetPrimitiveType("double"))
-            .SetReturn(EDM_DOUBLE_TYPE);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_NESTED_STRUCT_NODE, "Long", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_MEMBER2_NODE, sizeof(TEST_MEMBER2_NODE));
-        const char* longValue = "1.2";
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_MEMBER2_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &longValue, sizeof(longValue));
-        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String(longValue, EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(mocks, CreateAgentDataType_From_String("1.2", EDM_DOUBLE_TYPE, IGNORED_PTR_ARG))
             .CopyOutArgumentBuffer(3, &LongAgentDataType, sizeof(LongAgentDataType));
 
         EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_Members(IGNORED_PTR_ARG, "NestedGeoLocation", 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .ValidateArgument(2).ValidateArgument(3);
-
         EXPECTED_CALL(mocks, Create_AGENT_DATA_TYPE_from_Members(IGNORED_PTR_ARG, "GeoLocation", 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .ValidateArgument(2).ValidateArgument(3);
 
-        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", "SetLocation", 1, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", setLocationName, 1, IGNORED_PTR_ARG))
             .IgnoreArgument(5);
 
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
         EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, SET_NESTED_LOCATION_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
@@ -2631,48 +1839,68 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_035:[ CommandDecoder_ExecuteCommand shall support paths to actions that are in child models (i.e. ChildModel/SomeAction.] */
-    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Command_In_A_Child_Model_Calls_The_ActionCallback)
+    /* Tests_SRS_COMMAND_DECODER_02_008: [ If struct values are nested deeper than COMMAND_DECODER_MAX_STRUCT_NESTING levels then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(CommandDecoder_When_Complex_Types_Are_Nested_Too_Deep_ExecuteCommand_Fails)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        const char* quotedActionName = "\"ChildModel/SetACState\"";
+        /*"Node" is a struct whose only member "Next" is a "Node"*/
+        std::string command = "{\"Name\":\"SetLocation\",\"Parameters\":{\"Node\":";
+        for (size_t i = 0; i < COMMAND_DECODER_MAX_STRUCT_NESTING; i++)
+        {
+            command += "{\"Next\":";
+        }
+        command += "{}";
+        for (size_t i = 0; i < COMMAND_DECODER_MAX_STRUCT_NESTING; i++)
+        {
+            command += "}";
+        }
+        command += "}}";
 
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        size_t argCount = 1;
+        SetupCommand(&mocks, TEST_MODEL_HANDLE, setLocationName, SetLocationActionHandle, &argCount);
+        SetupValuesBlock(&mocks);
+        SetupArgumentCalls(&mocks, SetLocationActionHandle, 0, LocationActionArgument, "Node", "Node", EDM_NO_TYPE);
+        size_t memberCount = 1;
+        for (size_t i = 0; i < COMMAND_DECODER_MAX_STRUCT_NESTING; i++)
+        {
+            SetupStructCalls(&mocks, "Node", TEST_STRUCT_1_HANDLE, &memberCount);
+            SetupValuesBlock(&mocks);
+            SetupMemberCalls(&mocks, TEST_STRUCT_1_HANDLE, 0, memberProperty1, "Next", "Node", EDM_NO_TYPE);
+        }
 
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedActionName, sizeof(quotedActionName));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/ /*well - first part of it ="ChildModel"*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/ /*well - last part of it ="SetACState"*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        // act
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, command.c_str());
+
+        // assert
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        mocks.AssertActualAndExpectedCalls();
+
+        // cleanup
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /* Tests_SRS_COMMAND_DECODER_99_035:[ CommandDecoder_ExecuteCommand shall support paths to actions that are in child models (i.e. ChildModel/SomeAction.] */
+    /* Tests_SRS_COMMAND_DECODER_99_037:[ The relative path passed to the actionCallback shall be in the format "childModel1/childModel2/.../childModelN".] */
+    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Command_In_A_Child_Model_Calls_The_ActionCallback)
+    {
+        // arrange
+        CCommandDecoderMocks mocks;
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        mocks.ResetAllCalls();
 
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Parameters", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_ARGS_NODE, sizeof(TEST_COMMAND_ARGS_NODE));
         STRICT_EXPECTED_CALL(mocks, Schema_GetModelModelByName(TEST_MODEL_HANDLE, "ChildModel"));
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionByName(TEST_CHILD_MODEL_HANDLE, "SetACState"))
-            .SetReturn(SetACStateActionHandle);
         size_t argCount = 0;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "ChildModel", "SetACState", 0, NULL));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_CHILD_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "ChildModel", setACStateName, 0, NULL));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, CHILD_MODEL_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
@@ -2682,52 +1910,26 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /* Tests_SRS_COMMAND_DECODER_99_035:[ CommandDecoder_ExecuteCommand shall support paths to actions that are in child models (i.e. ChildModel/SomeAction.] */
-    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Command_In_A_Child_Model_Calls_The_ActionCallback_and_returns_REJECTED)
+    /* Tests_SRS_COMMAND_DECODER_99_037:[ The relative path passed to the actionCallback shall be in the format "childModel1/childModel2/.../childModelN".] */
+    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Command_In_A_Grandchild_Model_Passes_The_Whole_Relative_Path)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        const char* quotedActionName = "\"ChildModel/SetACState\"";
-
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedActionName, sizeof(quotedActionName));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/ /*well - first part of it ="ChildModel"*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/ /*well - last part of it ="SetACState"*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Parameters", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_ARGS_NODE, sizeof(TEST_COMMAND_ARGS_NODE));
         STRICT_EXPECTED_CALL(mocks, Schema_GetModelModelByName(TEST_MODEL_HANDLE, "ChildModel"));
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionByName(TEST_CHILD_MODEL_HANDLE, "SetACState"))
-            .SetReturn(SetACStateActionHandle);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelModelByName(TEST_CHILD_MODEL_HANDLE, "GrandchildModel"));
         size_t argCount = 0;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "ChildModel", "SetACState", 0, NULL))
-            .SetReturn(EXECUTE_COMMAND_FAILED);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_CHILD_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "ChildModel/GrandchildModel", setACStateName, 0, NULL));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, "{\"Name\":\"ChildModel/GrandchildModel/SetACState\",\"Parameters\":{}}");
 
         // assert
-        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_FAILED, result);
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
         mocks.AssertActualAndExpectedCalls();
 
         // cleanup
@@ -2735,87 +1937,48 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
     }
 
     /* Tests_SRS_COMMAND_DECODER_99_035:[ CommandDecoder_ExecuteCommand shall support paths to actions that are in child models (i.e. ChildModel/SomeAction.] */
-    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Command_In_A_Child_Model_Calls_The_ActionCallback_and_returns_ABANDONED)
+    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Command_In_A_Child_Model_Calls_The_ActionCallback_and_returns_REJECTED)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        const char* quotedActionName = "\"ChildModel/SetACState\"";
-
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedActionName, sizeof(quotedActionName));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/ /*well - first part of it ="ChildModel"*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/ /*well - last part of it ="SetACState"*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Parameters", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_ARGS_NODE, sizeof(TEST_COMMAND_ARGS_NODE));
         STRICT_EXPECTED_CALL(mocks, Schema_GetModelModelByName(TEST_MODEL_HANDLE, "ChildModel"));
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionByName(TEST_CHILD_MODEL_HANDLE, "SetACState"))
-            .SetReturn(SetACStateActionHandle);
         size_t argCount = 0;
-        STRICT_EXPECTED_CALL(mocks, Schema_GetModelActionArgumentCount(SetACStateActionHandle, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &argCount, sizeof(argCount));
-        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "ChildModel", "SetACState", 0, NULL))
-            .SetReturn(EXECUTE_COMMAND_ERROR);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+        SetupCommand(&mocks, TEST_CHILD_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "ChildModel", setACStateName, 0, NULL))
+            .SetReturn(EXECUTE_COMMAND_FAILED);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, CHILD_MODEL_COMMAND);
 
         // assert
-        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_FAILED, result);
         mocks.AssertActualAndExpectedCalls();
 
         // cleanup
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    /*Tests_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.]*/
-    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Command_In_A_Child_Model_when_gballoc_fails_it_fails)
+    /* Tests_SRS_COMMAND_DECODER_99_035:[ CommandDecoder_ExecuteCommand shall support paths to actions that are in child models (i.e. ChildModel/SomeAction.] */
+    TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Command_In_A_Child_Model_Calls_The_ActionCallback_and_returns_ABANDONED)
     {
         // arrange
         CCommandDecoderMocks mocks;
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        const char* quotedActionName = "\"ChildModel/SetACState\"";
-
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedActionName, sizeof(quotedActionName));
-        whenShallmalloc_fail = currentmalloc_call + 2;
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/ /*well - first part of it ="ChildModel"*/
-            .IgnoreArgument(1);
-
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
-
-        ASSERT_IS_NOT_NULL(CommandDecoder_ExecuteCommand);
+        STRICT_EXPECTED_CALL(mocks, Schema_GetModelModelByName(TEST_MODEL_HANDLE, "ChildModel"));
+        size_t argCount = 0;
+        SetupCommand(&mocks, TEST_CHILD_MODEL_HANDLE, setACStateName, SetACStateActionHandle, &argCount);
+        STRICT_EXPECTED_CALL(mocks, ActionCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "ChildModel", setACStateName, 0, NULL))
+            .SetReturn(EXECUTE_COMMAND_ERROR);
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, CHILD_MODEL_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -2826,7 +1989,6 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
     }
 
     /* Tests_SRS_COMMAND_DECODER_99_036:[ If a child model cannot be found by using Schema APIs then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-    /* Tests_SRS_COMMAND_DECODER_99_037:[ The relative path passed to the actionCallback shall be in the format "childModel1/childModel2/.../childModelN".] */
     TEST_FUNCTION(CommandDecoder_ExecuteCommand_With_A_Command_In_A_Child_Model_And_The_Child_Model_Does_Not_Exist_Fails)
     {
         // arrange
@@ -2834,29 +1996,12 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         mocks.ResetAllCalls();
 
-        const char* quotedActionName = "\"ChildModel/SetLocation\"";
-
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(strlen(TEST_COMMAND) + 1)); /*this creates a copy of the command that is given to JSON decoder*/
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)) /*free-ing the copy of the buffer*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, JSONDecoder_JSON_To_MultiTree(TestCommand, IGNORED_PTR_ARG)).IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetChildByName(TEST_COMMAND_ROOT_NODE, "Name", IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_COMMAND_NAME_NODE, sizeof(TEST_COMMAND_NAME_NODE));
-        STRICT_EXPECTED_CALL(mocks, MultiTree_GetValue(TEST_COMMAND_NAME_NODE, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(2, &quotedActionName, sizeof(quotedActionName));
-        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG)) /*this is relativeActionPath*/ /*well - first part of it ="ChildModel"*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-                                                                    /*this is relativeActionPath*/ /*well - notice there's no last part of it not found*/
-
         STRICT_EXPECTED_CALL(mocks, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         STRICT_EXPECTED_CALL(mocks, Schema_GetModelModelByName(TEST_MODEL_HANDLE, "ChildModel"))
             .SetReturn((SCHEMA_MODEL_TYPE_HANDLE)NULL);
-        STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
 
         // act
-        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, TEST_COMMAND);
+        auto result = CommandDecoder_ExecuteCommand(commandDecoderHandle, CHILD_MODEL_COMMAND);
 
         // assert
         ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
@@ -0,0 +1,504 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <cstdlib>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <cstdio>
+#include <string>
+#include "testrunnerswitcher.h"
+#include "databatch.h"
+#include "micromock.h"
+#include "micromockcharstararenullterminatedstrings.h"
+#include "azure_c_shared_utility/strings.h"
+
+static MICROMOCK_MUTEX_HANDLE g_testByTest;
+static MICROMOCK_GLOBAL_SEMAPHORE_HANDLE g_dllByDll;
+
+DEFINE_MICROMOCK_ENUM_TO_STRING(DATA_BATCH_RESULT, DATA_BATCH_RESULT_VALUES);
+
+static const char* const TWO_COLUMNS[] = { "Temperature", "Counter" };
+static const char* const ONE_COLUMN[] = { "Time" };
+
+static size_t nDestroyCalls;
+
+/*writes integers as %lld, doubles as %g and timestamps as "hh:mm:ss" - enough to check the layout*/
+static AGENT_DATA_TYPES_RESULT TestToString(STRING_HANDLE destination, const AGENT_DATA_TYPE* value)
+{
+    char temp[64];
+    switch (value->type)
+    {
+        case EDM_INT32_TYPE:
+            (void)sprintf(temp, "%d", (int)value->value.edmInt32.value);
+            break;
+        case EDM_INT64_TYPE:
+            (void)sprintf(temp, "%lld", (long long)value->value.edmInt64.value);
+            break;
+        case EDM_DOUBLE_TYPE:
+            (void)sprintf(temp, "%g", value->value.edmDouble.value);
+            break;
+        case EDM_DATE_TIME_OFFSET_TYPE:
+            (void)sprintf(temp, "\"%02d:%02d:%02d\"", value->value.edmDateTimeOffset.dateTime.tm_hour, value->value.edmDateTimeOffset.dateTime.tm_min, value->value.edmDateTimeOffset.dateTime.tm_sec);
+            break;
+        default:
+            (void)sprintf(temp, "?");
+            break;
+    }
+    return (STRING_concat(destination, temp) == 0) ? AGENT_DATA_TYPES_OK : AGENT_DATA_TYPES_ERROR;
+}
+
+TYPED_MOCK_CLASS(CDataBatchMocks, CGlobalMock)
+{
+public:
+    MOCK_STATIC_METHOD_2(, AGENT_DATA_TYPES_RESULT, AgentDataTypes_ToString, STRING_HANDLE, destination, const AGENT_DATA_TYPE*, value)
+    MOCK_METHOD_END(AGENT_DATA_TYPES_RESULT, TestToString(destination, value))
+
+    MOCK_STATIC_METHOD_2(, AGENT_DATA_TYPES_RESULT, Create_AGENT_DATA_TYPE_from_SINT64, AGENT_DATA_TYPE*, agentData, int64_t, v)
+        agentData->type = EDM_INT64_TYPE;
+        agentData->value.edmInt64.value = v;
+    MOCK_METHOD_END(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_OK)
+
+    MOCK_STATIC_METHOD_1(, void, Destroy_AGENT_DATA_TYPE, AGENT_DATA_TYPE*, agentData)
+        nDestroyCalls++;
+    MOCK_VOID_METHOD_END()
+};
+
+DECLARE_GLOBAL_MOCK_METHOD_2(CDataBatchMocks, , AGENT_DATA_TYPES_RESULT, AgentDataTypes_ToString, STRING_HANDLE, destination, const AGENT_DATA_TYPE*, value);
+DECLARE_GLOBAL_MOCK_METHOD_2(CDataBatchMocks, , AGENT_DATA_TYPES_RESULT, Create_AGENT_DATA_TYPE_from_SINT64, AGENT_DATA_TYPE*, agentData, int64_t, v);
+DECLARE_GLOBAL_MOCK_METHOD_1(CDataBatchMocks, , void, Destroy_AGENT_DATA_TYPE, AGENT_DATA_TYPE*, agentData);
+
+static void makeSample(AGENT_DATA_TYPE* values, double temperature, int32_t counter)
+{
+    values[0].type = EDM_DOUBLE_TYPE;
+    values[0].value.edmDouble.value = temperature;
+    values[1].type = EDM_INT32_TYPE;
+    values[1].value.edmInt32.value = counter;
+}
+
+static void makeTimestamp(AGENT_DATA_TYPE* value, int hour, int minute, int second)
+{
+    memset(value, 0, sizeof(*value));
+    value->type = EDM_DATE_TIME_OFFSET_TYPE;
+    value->value.edmDateTimeOffset.dateTime.tm_year = 116;
+    value->value.edmDateTimeOffset.dateTime.tm_mon = 2;
+    value->value.edmDateTimeOffset.dateTime.tm_mday = 1;
+    value->value.edmDateTimeOffset.dateTime.tm_hour = hour;
+    value->value.edmDateTimeOffset.dateTime.tm_min = minute;
+    value->value.edmDateTimeOffset.dateTime.tm_sec = second;
+}
+
+static std::string encode(DATA_BATCH_HANDLE handle, DATA_BATCH_RESULT expectedResult)
+{
+    unsigned char* destination = NULL;
+    size_t destinationSize = 0;
+    std::string payload;
+    DATA_BATCH_RESULT result = DataBatch_Encode(handle, &destination, &destinationSize);
+    ASSERT_ARE_EQUAL(DATA_BATCH_RESULT, expectedResult, result);
+    if (destination != NULL)
+    {
+        payload.assign((const char*)destination, destinationSize);
+        free(destination);
+    }
+    return payload;
+}
+
+BEGIN_TEST_SUITE(DataBatch_ut)
+
+    TEST_SUITE_INITIALIZE(TestClassInitialize)
+    {
+        TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+        g_testByTest = MicroMockCreateMutex();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+    }
+
+    TEST_SUITE_CLEANUP(TestClassCleanup)
+    {
+        MicroMockDestroyMutex(g_testByTest);
+        TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    }
+
+    TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+    {
+        if (!MicroMockAcquireMutex(g_testByTest))
+        {
+            ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+        }
+        nDestroyCalls = 0;
+    }
+
+    TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+    {
+        if (!MicroMockReleaseMutex(g_testByTest))
+        {
+            ASSERT_FAIL("failure in test framework at ReleaseMutex");
+        }
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_002: [If columnCount or maxSamples is 0 or columnNames is NULL then DataBatch_Create shall fail and return NULL.]*/
+    TEST_FUNCTION(DataBatch_Create_with_0_columnCount_fails)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+
+        ///act
+        DATA_BATCH_HANDLE result = DataBatch_Create(0, TWO_COLUMNS, 10, false);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_002: [If columnCount or maxSamples is 0 or columnNames is NULL then DataBatch_Create shall fail and return NULL.]*/
+    TEST_FUNCTION(DataBatch_Create_with_NULL_columnNames_fails)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+
+        ///act
+        DATA_BATCH_HANDLE result = DataBatch_Create(2, NULL, 10, false);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_002: [If columnCount or maxSamples is 0 or columnNames is NULL then DataBatch_Create shall fail and return NULL.]*/
+    TEST_FUNCTION(DataBatch_Create_with_0_maxSamples_fails)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+
+        ///act
+        DATA_BATCH_HANDLE result = DataBatch_Create(2, TWO_COLUMNS, 0, false);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_003: [If columnCount * maxSamples values cannot be represented in a size_t then DataBatch_Create shall fail and return NULL.]*/
+    TEST_FUNCTION(DataBatch_Create_with_overflowing_size_fails)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+
+        ///act
+        DATA_BATCH_HANDLE result = DataBatch_Create(2, TWO_COLUMNS, ((size_t)-1) / 2, false);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_004: [DataBatch_Create shall make a copy of every column name.]*/
+    /*Tests_SRS_DATA_BATCH_02_007: [Otherwise DataBatch_Create shall succeed and return a non-NULL handle.]*/
+    TEST_FUNCTION(DataBatch_Create_succeeds)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+
+        ///act
+        DATA_BATCH_HANDLE result = DataBatch_Create(2, TWO_COLUMNS, 10, false);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_EQUAL(size_t, 0, DataBatch_GetSampleCount(result));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        DataBatch_Destroy(result);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_008: [If dataBatchHandle is NULL then DataBatch_Destroy shall do nothing.]*/
+    TEST_FUNCTION(DataBatch_Destroy_with_NULL_does_nothing)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+
+        ///act
+        DataBatch_Destroy(NULL);
+
+        ///assert
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_009: [DataBatch_Destroy shall free all the buffered samples and all the resources used by the batch.]*/
+    TEST_FUNCTION(DataBatch_Destroy_destroys_the_buffered_samples)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(2, TWO_COLUMNS, 10, false);
+        AGENT_DATA_TYPE values[2];
+        makeSample(values, 21.5, 100);
+        (void)DataBatch_AppendSample(handle, values);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        DataBatch_Destroy(handle);
+
+        ///assert
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_010: [If dataBatchHandle or values is NULL then DataBatch_AppendSample shall fail and return DATA_BATCH_INVALID_ARG.]*/
+    TEST_FUNCTION(DataBatch_AppendSample_with_NULL_values_fails)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(2, TWO_COLUMNS, 10, false);
+
+        ///act
+        DATA_BATCH_RESULT result = DataBatch_AppendSample(handle, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DATA_BATCH_RESULT, DATA_BATCH_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(size_t, 0, DataBatch_GetSampleCount(handle));
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_012: [DataBatch_AppendSample shall move the columnCount values into the ring without copying their content; the values become owned by the batch.]*/
+    /*Tests_SRS_DATA_BATCH_02_013: [On success DataBatch_AppendSample shall return DATA_BATCH_OK.]*/
+    /*Tests_SRS_DATA_BATCH_02_014: [DataBatch_GetSampleCount shall return the number of buffered samples, or 0 if dataBatchHandle is NULL.]*/
+    TEST_FUNCTION(DataBatch_AppendSample_succeeds)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(2, TWO_COLUMNS, 10, false);
+        AGENT_DATA_TYPE values[2];
+        makeSample(values, 21.5, 100);
+        mocks.ResetAllCalls();
+
+        ///act
+        DATA_BATCH_RESULT result = DataBatch_AppendSample(handle, values);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DATA_BATCH_RESULT, DATA_BATCH_OK, result);
+        ASSERT_ARE_EQUAL(size_t, 1, DataBatch_GetSampleCount(handle));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_011: [If the batch already holds maxSamples samples, the oldest sample shall be destroyed and its slot reused.]*/
+    TEST_FUNCTION(DataBatch_AppendSample_when_full_drops_the_oldest_sample)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(2, TWO_COLUMNS, 2, false);
+        AGENT_DATA_TYPE values[2];
+        makeSample(values, 1, 1);
+        (void)DataBatch_AppendSample(handle, values);
+        makeSample(values, 2, 2);
+        (void)DataBatch_AppendSample(handle, values);
+        makeSample(values, 3, 3);
+        nDestroyCalls = 0;
+
+        ///act
+        DATA_BATCH_RESULT result = DataBatch_AppendSample(handle, values);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DATA_BATCH_RESULT, DATA_BATCH_OK, result);
+        ASSERT_ARE_EQUAL(size_t, 2, nDestroyCalls);
+        ASSERT_ARE_EQUAL(size_t, 2, DataBatch_GetSampleCount(handle));
+        ASSERT_ARE_EQUAL(char_ptr, "{\"Temperature\":[2,3], \"Counter\":[2,3]}", encode(handle, DATA_BATCH_OK).c_str());
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_015: [If dataBatchHandle, destination or destinationSize is NULL then DataBatch_Encode shall fail and return DATA_BATCH_INVALID_ARG.]*/
+    TEST_FUNCTION(DataBatch_Encode_with_NULL_handle_fails)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+
+        ///act
+        std::string payload = encode(NULL, DATA_BATCH_INVALID_ARG);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, payload.size());
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_016: [If there are no buffered samples then DataBatch_Encode shall return DATA_BATCH_EMPTY.]*/
+    TEST_FUNCTION(DataBatch_Encode_with_no_samples_returns_DATA_BATCH_EMPTY)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(2, TWO_COLUMNS, 10, false);
+
+        ///act
+        std::string payload = encode(handle, DATA_BATCH_EMPTY);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, payload.size());
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_017: [DataBatch_Encode shall produce a JSON object with one member per column, named after the column, in the order the columns were given to DataBatch_Create.]*/
+    /*Tests_SRS_DATA_BATCH_02_018: [Columns that are not delta encoded shall be written as a JSON array of the values, oldest sample first, each value being produced by AgentDataTypes_ToString.]*/
+    /*Tests_SRS_DATA_BATCH_02_021: [On success DataBatch_Encode shall copy the payload in *destination, its size in *destinationSize, clear all the buffered samples and return DATA_BATCH_OK.]*/
+    TEST_FUNCTION(DataBatch_Encode_writes_one_array_per_column)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(2, TWO_COLUMNS, 10, false);
+        AGENT_DATA_TYPE values[2];
+        makeSample(values, 21.5, 100);
+        (void)DataBatch_AppendSample(handle, values);
+        makeSample(values, 22, 101);
+        (void)DataBatch_AppendSample(handle, values);
+
+        ///act
+        std::string payload = encode(handle, DATA_BATCH_OK);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, "{\"Temperature\":[21.5,22], \"Counter\":[100,101]}", payload.c_str());
+        ASSERT_ARE_EQUAL(size_t, 0, DataBatch_GetSampleCount(handle));
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_019: [Integer columns shall be written as {"delta":[...]} where each entry is the difference to the previous sample and the first entry is the difference to 0.]*/
+    TEST_FUNCTION(DataBatch_Encode_with_deltaEncoding_writes_integer_columns_as_deltas)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(2, TWO_COLUMNS, 10, true);
+        AGENT_DATA_TYPE values[2];
+        makeSample(values, 21.5, 100);
+        (void)DataBatch_AppendSample(handle, values);
+        makeSample(values, 22, 101);
+        (void)DataBatch_AppendSample(handle, values);
+        makeSample(values, 22.5, 99);
+        (void)DataBatch_AppendSample(handle, values);
+
+        ///act
+        std::string payload = encode(handle, DATA_BATCH_OK);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, "{\"Temperature\":[21.5,22,22.5], \"Counter\":{\"delta\":[100,1,-2]}}", payload.c_str());
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_020: [Timestamp columns shall be written as {"base":firstTimestamp,"delta":[...]} where the deltas are expressed in seconds and the first delta is 0.]*/
+    TEST_FUNCTION(DataBatch_Encode_with_deltaEncoding_writes_timestamps_as_base_and_deltas)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(1, ONE_COLUMN, 10, true);
+        AGENT_DATA_TYPE value;
+        makeTimestamp(&value, 10, 0, 0);
+        (void)DataBatch_AppendSample(handle, &value);
+        makeTimestamp(&value, 10, 0, 5);
+        (void)DataBatch_AppendSample(handle, &value);
+        makeTimestamp(&value, 10, 1, 5);
+        (void)DataBatch_AppendSample(handle, &value);
+
+        ///act
+        std::string payload = encode(handle, DATA_BATCH_OK);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, "{\"Time\":{\"base\":\"10:00:00\", \"delta\":[0,5,60]}}", payload.c_str());
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_018: [Columns that are not delta encoded shall be written as a JSON array of the values, oldest sample first, each value being produced by AgentDataTypes_ToString.]*/
+    TEST_FUNCTION(DataBatch_Encode_with_deltaEncoding_and_fractional_seconds_writes_timestamps_as_values)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(1, ONE_COLUMN, 10, true);
+        AGENT_DATA_TYPE value;
+        makeTimestamp(&value, 10, 0, 0);
+        (void)DataBatch_AppendSample(handle, &value);
+        makeTimestamp(&value, 10, 0, 5);
+        value.value.edmDateTimeOffset.hasFractionalSecond = 1;
+        value.value.edmDateTimeOffset.fractionalSecond = 5;
+        (void)DataBatch_AppendSample(handle, &value);
+
+        ///act
+        std::string payload = encode(handle, DATA_BATCH_OK);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, "{\"Time\":[\"10:00:00\",\"10:00:05\"]}", payload.c_str());
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_024: [If encoding fails then DataBatch_Encode shall fail, keep the buffered samples and return DATA_BATCH_AGENT_DATA_TYPES_ERROR or DATA_BATCH_ERROR.]*/
+    TEST_FUNCTION(DataBatch_Encode_when_AgentDataTypes_ToString_fails_keeps_the_samples)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(2, TWO_COLUMNS, 10, false);
+        AGENT_DATA_TYPE values[2];
+        makeSample(values, 21.5, 100);
+        (void)DataBatch_AppendSample(handle, values);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, AgentDataTypes_ToString(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments()
+            .SetReturn(AGENT_DATA_TYPES_ERROR);
+
+        ///act
+        std::string payload = encode(handle, DATA_BATCH_AGENT_DATA_TYPES_ERROR);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, payload.size());
+        ASSERT_ARE_EQUAL(size_t, 1, DataBatch_GetSampleCount(handle));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_022: [If dataBatchHandle is NULL then DataBatch_Clear shall do nothing.]*/
+    TEST_FUNCTION(DataBatch_Clear_with_NULL_does_nothing)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+
+        ///act
+        DataBatch_Clear(NULL);
+
+        ///assert
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /*Tests_SRS_DATA_BATCH_02_023: [DataBatch_Clear shall destroy all the buffered samples.]*/
+    TEST_FUNCTION(DataBatch_Clear_destroys_the_buffered_samples)
+    {
+        ///arrange
+        CDataBatchMocks mocks;
+        DATA_BATCH_HANDLE handle = DataBatch_Create(2, TWO_COLUMNS, 10, false);
+        AGENT_DATA_TYPE values[2];
+        makeSample(values, 21.5, 100);
+        (void)DataBatch_AppendSample(handle, values);
+        nDestroyCalls = 0;
+
+        ///act
+        DataBatch_Clear(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 2, nDestroyCalls);
+        ASSERT_ARE_EQUAL(size_t, 0, DataBatch_GetSampleCount(handle));
+
+        ///cleanup
+        DataBatch_Destroy(handle);
+    }
+
+END_TEST_SUITE(DataBatch_ut)
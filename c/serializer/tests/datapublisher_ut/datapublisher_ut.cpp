@@ -29,6 +29,11 @@ static const DATA_MARSHALLER_VALUE* g_ExpectedDataSentValues;
 
 
 static const SCHEMA_MODEL_TYPE_HANDLE TEST_MODEL_HANDLE = (SCHEMA_PROPERTY_HANDLE)0x4242;
+static const SCHEMA_HANDLE TEST_SCHEMA_HANDLE = (SCHEMA_HANDLE)0x4245;
+static const size_t TEST_PROPERTY_ID_COUNT = 2;
+
+static const char* PropertyPath = "TestPropertyPath";
+static const char* PropertyPath_2 = "Test42PropertyPath";
 
 static DATA_PUBLISHER_HANDLE g_handle = NULL;
 static TRANSACTION_HANDLE g_myTransaction = NULL;
@@ -54,8 +59,24 @@ TYPED_MOCK_CLASS(CDataPublisherMock, CGlobalMock)
 {
 public:
     /* Tests_SRS_DATA_PUBLISHER_99_002:[ The DataPublisher module shall make use of the Schema module APIs to query schema information.] */
-    MOCK_STATIC_METHOD_2(, bool, Schema_ModelPropertyByPathExists, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle, const char*, propertyPath);
-    MOCK_METHOD_END(bool, true)
+    MOCK_STATIC_METHOD_1(, SCHEMA_HANDLE, Schema_GetSchemaForModelType, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle);
+    MOCK_METHOD_END(SCHEMA_HANDLE, TEST_SCHEMA_HANDLE)
+    MOCK_STATIC_METHOD_1(, SCHEMA_RESULT, Schema_Freeze, SCHEMA_HANDLE, schemaHandle);
+    MOCK_METHOD_END(SCHEMA_RESULT, SCHEMA_OK)
+    MOCK_STATIC_METHOD_2(, SCHEMA_RESULT, Schema_GetModelPropertyIdCount, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle, size_t*, propertyIdCount);
+        if (propertyIdCount != NULL)
+        {
+            *propertyIdCount = TEST_PROPERTY_ID_COUNT;
+        }
+    MOCK_METHOD_END(SCHEMA_RESULT, SCHEMA_OK)
+    MOCK_STATIC_METHOD_3(, SCHEMA_RESULT, Schema_GetModelPropertyIdByPath, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle, const char*, propertyPath, size_t*, propertyId);
+        if (propertyId != NULL)
+        {
+            *propertyId = (strcmp(propertyPath, PropertyPath_2) == 0) ? 1 : 0;
+        }
+    MOCK_METHOD_END(SCHEMA_RESULT, SCHEMA_OK)
+    MOCK_STATIC_METHOD_2(, const char*, Schema_GetModelPropertyPathById, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle, size_t, propertyId);
+    MOCK_METHOD_END(const char*, (propertyId == 1) ? PropertyPath_2 : PropertyPath)
 
     /* Tests_SRS_DATA_PUBLISHER_99_039:[ The DataPublisher module shall make use of the DataPublisher module APIs to dispatch data to be published.] */
     MOCK_STATIC_METHOD_2(, DATA_MARSHALLER_HANDLE, DataMarshaller_Create, SCHEMA_MODEL_TYPE_HANDLE, modelHandle, bool, includePropertyPath);
@@ -89,7 +110,11 @@ public:
     MOCK_VOID_METHOD_END()
 };
 
-DECLARE_GLOBAL_MOCK_METHOD_2(CDataPublisherMock, , bool, Schema_ModelPropertyByPathExists, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle, const char*, propertyPath);
+DECLARE_GLOBAL_MOCK_METHOD_1(CDataPublisherMock, , SCHEMA_HANDLE, Schema_GetSchemaForModelType, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle);
+DECLARE_GLOBAL_MOCK_METHOD_1(CDataPublisherMock, , SCHEMA_RESULT, Schema_Freeze, SCHEMA_HANDLE, schemaHandle);
+DECLARE_GLOBAL_MOCK_METHOD_2(CDataPublisherMock, , SCHEMA_RESULT, Schema_GetModelPropertyIdCount, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle, size_t*, propertyIdCount);
+DECLARE_GLOBAL_MOCK_METHOD_3(CDataPublisherMock, , SCHEMA_RESULT, Schema_GetModelPropertyIdByPath, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle, const char*, propertyPath, size_t*, propertyId);
+DECLARE_GLOBAL_MOCK_METHOD_2(CDataPublisherMock, , const char*, Schema_GetModelPropertyPathById, SCHEMA_MODEL_TYPE_HANDLE, modelTypeHandle, size_t, propertyId);
 
 DECLARE_GLOBAL_MOCK_METHOD_2(CDataPublisherMock, , DATA_MARSHALLER_HANDLE, DataMarshaller_Create, SCHEMA_MODEL_TYPE_HANDLE, modelHandle, bool, includePropertyPath);
 DECLARE_GLOBAL_MOCK_METHOD_1(CDataPublisherMock, , void, DataMarshaller_Destroy, DATA_MARSHALLER_HANDLE, dataMarshallerHandle);
@@ -126,9 +151,6 @@ static bool operator==(_In_ const CMockValue<const DATA_MARSHALLER_VALUE*>& lhs,
     }
 }
 
-static const char* PropertyPath = "TestPropertyPath";
-static const char* PropertyPath_2 = "Test42PropertyPath";
-
 static MICROMOCK_GLOBAL_SEMAPHORE_HANDLE g_dllByDll;
 
 BEGIN_TEST_SUITE(DataPublisher_ut)
@@ -193,11 +215,17 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
         /* Tests_SRS_DATA_PUBLISHER_99_041:[ DataPublisher_Create shall create a new DataPublisher instance and return a non-NULL handle in case of success.] */
         /* Tests_SRS_DATA_PUBLISHER_99_043:[ DataPublisher_Create shall initialize and hold a handle to a DataMarshaller instance.] */
         /* Tests_SRS_DATA_PUBLISHER_01_001: [DataPublisher_Create shall pass the includePropertyPath argument to DataMarshaller_Create.] */
+        /* Tests_SRS_DATA_PUBLISHER_02_008: [DataPublisher_Create shall freeze the schema of the model by calling Schema_GetSchemaForModelType and Schema_Freeze.] */
+        /* Tests_SRS_DATA_PUBLISHER_02_009: [DataPublisher_Create shall get the number of property ids of the model by calling Schema_GetModelPropertyIdCount.] */
         TEST_FUNCTION(DataPublisher_Create_With_Valid_Arguments_Yields_A_non_NULL_Handle)
         {
             // arrange
             CDataPublisherMock dataPublisherMock;
 
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_Freeze(TEST_SCHEMA_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdCount(TEST_MODEL_HANDLE, IGNORED_PTR_ARG))
+                .IgnoreArgument(2);
             STRICT_EXPECTED_CALL(dataPublisherMock, DataMarshaller_Create(TEST_MODEL_HANDLE, true));
 
             // act
@@ -217,6 +245,10 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             // arrange
             CDataPublisherMock dataPublisherMock;
 
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_Freeze(TEST_SCHEMA_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdCount(TEST_MODEL_HANDLE, IGNORED_PTR_ARG))
+                .IgnoreArgument(2);
             STRICT_EXPECTED_CALL(dataPublisherMock, DataMarshaller_Create(TEST_MODEL_HANDLE, false));
 
             // act
@@ -237,8 +269,16 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             // arrange
             CDataPublisherMock dataPublisherMock;
 
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_Freeze(TEST_SCHEMA_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdCount(TEST_MODEL_HANDLE, IGNORED_PTR_ARG))
+                .IgnoreArgument(2);
             STRICT_EXPECTED_CALL(dataPublisherMock, DataMarshaller_Create(TEST_MODEL_HANDLE, true));
 
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_Freeze(TEST_SCHEMA_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdCount(TEST_MODEL_HANDLE, IGNORED_PTR_ARG))
+                .IgnoreArgument(2);
             STRICT_EXPECTED_CALL(dataPublisherMock, DataMarshaller_Create(TEST_MODEL_HANDLE, true));
 
             DATA_PUBLISHER_HANDLE handle1 = DataPublisher_Create(TEST_MODEL_HANDLE, true);
@@ -264,6 +304,10 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             // arrange
             CDataPublisherMock dataPublisherMock;
 
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_Freeze(TEST_SCHEMA_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdCount(TEST_MODEL_HANDLE, IGNORED_PTR_ARG))
+                .IgnoreArgument(2);
             STRICT_EXPECTED_CALL(dataPublisherMock, DataMarshaller_Create(TEST_MODEL_HANDLE, true))
                 .SetReturn((DATA_MARSHALLER_HANDLE)NULL);
 
@@ -274,6 +318,61 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             ASSERT_IS_NULL(handle);
         }
 
+        /* Tests_SRS_DATA_PUBLISHER_02_010: [If any of the Schema calls fails, DataPublisher_Create shall return NULL.] */
+        TEST_FUNCTION(DataPublisher_When_Schema_GetSchemaForModelType_Fails_DataPublisher_Create_Returns_NULL)
+        {
+            // arrange
+            CDataPublisherMock dataPublisherMock;
+
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE))
+                .SetReturn((SCHEMA_HANDLE)NULL);
+
+            // act
+            DATA_PUBLISHER_HANDLE handle = DataPublisher_Create(TEST_MODEL_HANDLE, true);
+
+            // assert
+            ASSERT_IS_NULL(handle);
+            dataPublisherMock.AssertActualAndExpectedCalls();
+        }
+
+        /* Tests_SRS_DATA_PUBLISHER_02_010: [If any of the Schema calls fails, DataPublisher_Create shall return NULL.] */
+        TEST_FUNCTION(DataPublisher_When_Schema_Freeze_Fails_DataPublisher_Create_Returns_NULL)
+        {
+            // arrange
+            CDataPublisherMock dataPublisherMock;
+
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_Freeze(TEST_SCHEMA_HANDLE))
+                .SetReturn(SCHEMA_ERROR);
+
+            // act
+            DATA_PUBLISHER_HANDLE handle = DataPublisher_Create(TEST_MODEL_HANDLE, true);
+
+            // assert
+            ASSERT_IS_NULL(handle);
+            dataPublisherMock.AssertActualAndExpectedCalls();
+        }
+
+        /* Tests_SRS_DATA_PUBLISHER_02_010: [If any of the Schema calls fails, DataPublisher_Create shall return NULL.] */
+        TEST_FUNCTION(DataPublisher_When_Schema_GetModelPropertyIdCount_Fails_DataPublisher_Create_Returns_NULL)
+        {
+            // arrange
+            CDataPublisherMock dataPublisherMock;
+
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_Freeze(TEST_SCHEMA_HANDLE));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdCount(TEST_MODEL_HANDLE, IGNORED_PTR_ARG))
+                .IgnoreArgument(2)
+                .SetReturn(SCHEMA_ERROR);
+
+            // act
+            DATA_PUBLISHER_HANDLE handle = DataPublisher_Create(TEST_MODEL_HANDLE, true);
+
+            // assert
+            ASSERT_IS_NULL(handle);
+            dataPublisherMock.AssertActualAndExpectedCalls();
+        }
+
         /* DataPublisher_Destroy */
 
         /* Tests_SRS_DATA_PUBLISHER_99_045:[ DataPublisher_Destroy shall free all resources associated with a DataPublisher instance.] */
@@ -409,6 +508,8 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
         }
 
         /* Tests_SRS_DATA_PUBLISHER_99_016:[ When DataPublisher_PublishTransacted is invoked, DataPublisher shall associate the data with the transaction identified by the transactionHandle argument and return DATA_PUBLISHER_OK. No data shall be dispatched at the time of the call.] */
+        /* Tests_SRS_DATA_PUBLISHER_02_012: [DataPublisher_PublishTransacted shall get the property id of propertyPath by calling Schema_GetModelPropertyIdByPath.] */
+        /* Tests_SRS_DATA_PUBLISHER_02_013: [The property path associated with the value shall be the one returned by Schema_GetModelPropertyPathById, no copy of propertyPath shall be made.] */
         TEST_FUNCTION(DataPublisher_PublishTransacted_With_Valid_Data_Succeeds)
         {
             // arrange
@@ -417,7 +518,9 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
             dataPublisherMock.ResetAllCalls();
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
             STRICT_EXPECTED_CALL(dataPublisherMock, Create_AGENT_DATA_TYPE_from_AGENT_DATA_TYPE(IGNORED_PTR_ARG, &data))
                 .IgnoreArgument(1);
             EXPECTED_CALL(dataPublisherMock, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
@@ -444,8 +547,9 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
             dataPublisherMock.ResetAllCalls();
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath))
-                .SetReturn(false);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3)
+                .SetReturn(SCHEMA_ELEMENT_NOT_FOUND);
 
             // act
             DATA_PUBLISHER_RESULT result = DataPublisher_PublishTransacted(transaction, PropertyPath, &data);
@@ -469,7 +573,9 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
             dataPublisherMock.ResetAllCalls();
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
             EXPECTED_CALL(dataPublisherMock, Create_AGENT_DATA_TYPE_from_AGENT_DATA_TYPE(IGNORED_PTR_ARG, &data))
                 .SetReturn(AGENT_DATA_TYPES_ERROR);
 
@@ -503,7 +609,9 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
 
             const DATA_MARSHALLER_VALUE value = { PropertyPath, &data };
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
 
             (void)DataPublisher_PublishTransacted(transaction, PropertyPath, &data2);
 
@@ -526,6 +634,159 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             DataPublisher_Destroy(handle);
         }
 
+        /* DataPublisher_PublishTransactedMove */
+
+        /* Tests_SRS_DATA_PUBLISHER_02_014: [If any of the arguments is NULL, DataPublisher_PublishTransactedMove shall return DATA_PUBLISHER_INVALID_ARG.] */
+        TEST_FUNCTION(DataPublisher_PublishTransactedMove_With_NULL_Transaction_Handle_Fails)
+        {
+            // arrange
+            CDataPublisherMock dataPublisherMock;
+
+            // act
+            DATA_PUBLISHER_RESULT result = DataPublisher_PublishTransactedMove(NULL, PropertyPath, &data);
+
+            // assert
+            ASSERT_ARE_EQUAL(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_INVALID_ARG, result);
+            dataPublisherMock.AssertActualAndExpectedCalls();
+        }
+
+        /* Tests_SRS_DATA_PUBLISHER_02_014: [If any of the arguments is NULL, DataPublisher_PublishTransactedMove shall return DATA_PUBLISHER_INVALID_ARG.] */
+        TEST_FUNCTION(DataPublisher_PublishTransactedMove_With_NULL_PropertyPath_Fails)
+        {
+            // arrange
+            CDataPublisherMock dataPublisherMock;
+            DATA_PUBLISHER_HANDLE handle = DataPublisher_Create(TEST_MODEL_HANDLE, true);
+            TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
+            dataPublisherMock.ResetAllCalls();
+
+            // act
+            DATA_PUBLISHER_RESULT result = DataPublisher_PublishTransactedMove(transaction, NULL, &data);
+
+            // assert
+            ASSERT_ARE_EQUAL(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_INVALID_ARG, result);
+            dataPublisherMock.AssertActualAndExpectedCalls();
+
+            // cleanup
+            (void)DataPublisher_CancelTransaction(transaction);
+            DataPublisher_Destroy(handle);
+        }
+
+        /* Tests_SRS_DATA_PUBLISHER_02_014: [If any of the arguments is NULL, DataPublisher_PublishTransactedMove shall return DATA_PUBLISHER_INVALID_ARG.] */
+        TEST_FUNCTION(DataPublisher_PublishTransactedMove_With_NULL_Data_Fails)
+        {
+            // arrange
+            CDataPublisherMock dataPublisherMock;
+            DATA_PUBLISHER_HANDLE handle = DataPublisher_Create(TEST_MODEL_HANDLE, true);
+            TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
+            dataPublisherMock.ResetAllCalls();
+
+            // act
+            DATA_PUBLISHER_RESULT result = DataPublisher_PublishTransactedMove(transaction, PropertyPath, NULL);
+
+            // assert
+            ASSERT_ARE_EQUAL(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_INVALID_ARG, result);
+            dataPublisherMock.AssertActualAndExpectedCalls();
+
+            // cleanup
+            (void)DataPublisher_CancelTransaction(transaction);
+            DataPublisher_Destroy(handle);
+        }
+
+        /* Tests_SRS_DATA_PUBLISHER_02_016: [DataPublisher_PublishTransactedMove shall take ownership of the content of data without copying it and shall set the type of data to EDM_NO_TYPE.] */
+        /* Tests_SRS_DATA_PUBLISHER_02_017: [On success DataPublisher_PublishTransactedMove shall return DATA_PUBLISHER_OK.] */
+        TEST_FUNCTION(DataPublisher_PublishTransactedMove_Takes_The_Value_Without_Copying_It)
+        {
+            // arrange
+            CDataPublisherMock dataPublisherMock;
+            DATA_PUBLISHER_HANDLE handle = DataPublisher_Create(TEST_MODEL_HANDLE, true);
+            unsigned char* destination;
+            size_t destinationSize;
+            TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
+            dataPublisherMock.ResetAllCalls();
+
+            AGENT_DATA_TYPE data2;
+            data2.type = EDM_SINGLE_TYPE;
+            data2.value.edmSingle.value = 3.5f;
+
+            const DATA_MARSHALLER_VALUE value = { PropertyPath, &data };
+
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
+            STRICT_EXPECTED_CALL(dataPublisherMock, DataMarshaller_SendData(TEST_DATA_MARSHALLER_HANDLE, 1, &value, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+                .IgnoreArgument(4)
+                .IgnoreArgument(5);
+            EXPECTED_CALL(dataPublisherMock, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+            // act
+            DATA_PUBLISHER_RESULT result = DataPublisher_PublishTransactedMove(transaction, PropertyPath, &data2);
+
+            // assert
+            ASSERT_ARE_EQUAL(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_OK, result);
+            ASSERT_ARE_EQUAL(int, (int)EDM_NO_TYPE, (int)data2.type);
+            ASSERT_ARE_EQUAL(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_OK, DataPublisher_EndTransaction(transaction, &destination, &destinationSize));
+            dataPublisherMock.AssertActualAndExpectedCalls();
+
+            // cleanup
+            DataPublisher_Destroy(handle);
+        }
+
+        /* Tests_SRS_DATA_PUBLISHER_02_015: [DataPublisher_PublishTransactedMove shall find the slot of propertyPath the same way DataPublisher_PublishTransacted does and fail the same way when it cannot.] */
+        TEST_FUNCTION(DataPublisher_When_The_Property_Does_Not_Exist_PublishTransactedMove_Fails_And_Leaves_The_Value_Alone)
+        {
+            // arrange
+            CDataPublisherMock dataPublisherMock;
+            DATA_PUBLISHER_HANDLE handle = DataPublisher_Create(TEST_MODEL_HANDLE, true);
+            TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
+            dataPublisherMock.ResetAllCalls();
+
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3)
+                .SetReturn(SCHEMA_ELEMENT_NOT_FOUND);
+
+            // act
+            DATA_PUBLISHER_RESULT result = DataPublisher_PublishTransactedMove(transaction, PropertyPath, &data);
+
+            // assert
+            ASSERT_ARE_EQUAL(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_SCHEMA_FAILED, result);
+            ASSERT_ARE_EQUAL(int, (int)EDM_SINGLE_TYPE, (int)data.type);
+            dataPublisherMock.AssertActualAndExpectedCalls();
+
+            // cleanup
+            (void)DataPublisher_CancelTransaction(transaction);
+            DataPublisher_Destroy(handle);
+        }
+
+        /* Tests_SRS_DATA_PUBLISHER_99_019:[ If the same property is associated twice with a transaction, then the last value shall be kept associated with the transaction.] */
+        TEST_FUNCTION(DataPublisher_PublishTransactedMove_Over_A_Copied_Value_Destroys_The_Copied_Value)
+        {
+            // arrange
+            CDataPublisherMock dataPublisherMock;
+            DATA_PUBLISHER_HANDLE handle = DataPublisher_Create(TEST_MODEL_HANDLE, true);
+            TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
+            (void)DataPublisher_PublishTransacted(transaction, PropertyPath, &data);
+            dataPublisherMock.ResetAllCalls();
+
+            AGENT_DATA_TYPE data2;
+            data2.type = EDM_SINGLE_TYPE;
+            data2.value.edmSingle.value = 3.7f;
+
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            EXPECTED_CALL(dataPublisherMock, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+            // act
+            DATA_PUBLISHER_RESULT result = DataPublisher_PublishTransactedMove(transaction, PropertyPath, &data2);
+
+            // assert
+            ASSERT_ARE_EQUAL(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_OK, result);
+            dataPublisherMock.AssertActualAndExpectedCalls();
+
+            // cleanup
+            (void)DataPublisher_CancelTransaction(transaction);
+            DataPublisher_Destroy(handle);
+        }
+
         /* DataPublisher_EndTransaction */
 
         /* Tests_SRS_DATA_PUBLISHER_99_011:[ If the transactionHandle argument is NULL, DataPublisher_EndTransaction shall return DATA_PUBLISHER_INVALID_ARG.] */
@@ -627,7 +888,9 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
 
             const DATA_MARSHALLER_VALUE value = { PropertyPath, &data };
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
 
             (void)DataPublisher_PublishTransacted(transaction, PropertyPath, &data);
 
@@ -662,7 +925,9 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
 
             const DATA_MARSHALLER_VALUE value = { PropertyPath, &data };
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
 
             (void)DataPublisher_PublishTransacted(transaction, PropertyPath, &data);
 
@@ -703,11 +968,14 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             const DATA_MARSHALLER_VALUE value = { PropertyPath, &data2 };
             g_ExpectedDataSentValues = &value;
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
             EXPECTED_CALL(dataPublisherMock, Create_AGENT_DATA_TYPE_from_AGENT_DATA_TYPE(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
             EXPECTED_CALL(dataPublisherMock, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
             EXPECTED_CALL(dataPublisherMock, Create_AGENT_DATA_TYPE_from_AGENT_DATA_TYPE(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
             EXPECTED_CALL(dataPublisherMock, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
 
@@ -756,11 +1024,15 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
 
             g_ExpectedDataSentValues = values;
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
             EXPECTED_CALL(dataPublisherMock, Create_AGENT_DATA_TYPE_from_AGENT_DATA_TYPE(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
             EXPECTED_CALL(dataPublisherMock, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath_2));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath_2, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 1));
             EXPECTED_CALL(dataPublisherMock, Create_AGENT_DATA_TYPE_from_AGENT_DATA_TYPE(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
             EXPECTED_CALL(dataPublisherMock, Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
 
@@ -802,11 +1074,14 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
 
             const DATA_MARSHALLER_VALUE value = { PropertyPath, &data };
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
             STRICT_EXPECTED_CALL(dataPublisherMock, Create_AGENT_DATA_TYPE_from_AGENT_DATA_TYPE(IGNORED_PTR_ARG, &data))
                 .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath_2))
-                .SetReturn(false);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath_2, IGNORED_PTR_ARG))
+                .IgnoreArgument(3)
+                .SetReturn(SCHEMA_ELEMENT_NOT_FOUND);
             STRICT_EXPECTED_CALL(dataPublisherMock, DataMarshaller_SendData(TEST_DATA_MARSHALLER_HANDLE, 1, &value, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
                 .IgnoreArgument(4)
                 .IgnoreArgument(5);
@@ -837,7 +1112,9 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
             dataPublisherMock.ResetAllCalls();
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
 
             DATA_PUBLISHER_RESULT result = DataPublisher_PublishTransacted(transaction, PropertyPath, &data);
 
@@ -868,7 +1145,9 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
             dataPublisherMock.ResetAllCalls();
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
 
             (void)DataPublisher_PublishTransacted(transaction, PropertyPath, &data);
 
@@ -908,7 +1187,9 @@ BEGIN_TEST_SUITE(DataPublisher_ut)
             TRANSACTION_HANDLE transaction = DataPublisher_StartTransaction(handle);
             dataPublisherMock.ResetAllCalls();
 
-            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_ModelPropertyByPathExists(TEST_MODEL_HANDLE, PropertyPath));
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyIdByPath(TEST_MODEL_HANDLE, PropertyPath, IGNORED_PTR_ARG))
+                .IgnoreArgument(3);
+            STRICT_EXPECTED_CALL(dataPublisherMock, Schema_GetModelPropertyPathById(TEST_MODEL_HANDLE, 0));
 
             // act
             DATA_PUBLISHER_RESULT result = DataPublisher_PublishTransacted(transaction, PropertyPath, &data);
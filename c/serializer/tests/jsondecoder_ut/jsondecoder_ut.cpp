@@ -9,6 +9,7 @@
 #include "testrunnerswitcher.h"
 #include "micromock.h"
 #include "micromockcharstararenullterminatedstrings.h"
+#include <string>
 #include "multitree.h"
 
 /*this is what we test*/
@@ -41,6 +42,77 @@ DECLARE_GLOBAL_MOCK_METHOD_2(CJSONDecoderMocks, , MULTITREE_RESULT, MultiTree_Se
 
 static const char* emptyJSONobject = "{}";
 
+/* JSONDecoder_Parse callbacks record every event in saxEvents */
+static std::string saxEvents;
+static const char* saxJSON;
+static const char* saxFailOn;
+
+static JSON_DECODER_RESULT RecordEvent(const std::string& event)
+{
+    saxEvents += event;
+    saxEvents += ";";
+    return ((saxFailOn != NULL) && (event == saxFailOn)) ? JSON_DECODER_ERROR : JSON_DECODER_OK;
+}
+
+static std::string Offset(const char* position)
+{
+    char offset[16];
+    (void)sprintf(offset, "%d", (int)(position - saxJSON));
+    return offset;
+}
+
+static JSON_DECODER_RESULT TestOnObjectBegin(void* context, const char* position)
+{
+    (void)context;
+    return RecordEvent("{@" + Offset(position));
+}
+
+static JSON_DECODER_RESULT TestOnObjectEnd(void* context, const char* position)
+{
+    (void)context;
+    return RecordEvent("}@" + Offset(position));
+}
+
+static JSON_DECODER_RESULT TestOnArrayBegin(void* context, const char* position)
+{
+    (void)context;
+    return RecordEvent("[@" + Offset(position));
+}
+
+static JSON_DECODER_RESULT TestOnArrayEnd(void* context, const char* position)
+{
+    (void)context;
+    return RecordEvent("]@" + Offset(position));
+}
+
+static JSON_DECODER_RESULT TestOnMemberName(void* context, const char* name, size_t nameLength)
+{
+    (void)context;
+    return RecordEvent("N:" + std::string(name, nameLength));
+}
+
+static JSON_DECODER_RESULT TestOnValue(void* context, const char* value, size_t valueLength)
+{
+    (void)context;
+    return RecordEvent("V:" + std::string(value, valueLength));
+}
+
+static const JSON_DECODER_CALLBACKS testCallbacks =
+{
+    TestOnObjectBegin,
+    TestOnObjectEnd,
+    TestOnArrayBegin,
+    TestOnArrayEnd,
+    TestOnMemberName,
+    TestOnValue
+};
+
+static JSON_DECODER_RESULT TestParse(const char* json, size_t jsonLength, const JSON_DECODER_CALLBACKS* callbacks)
+{
+    saxJSON = json;
+    return JSONDecoder_Parse(json, jsonLength, callbacks, NULL);
+}
+
 MICROMOCK_ENUM_TO_STRING(JSON_DECODER_RESULT_TAG,
     L"JSON_DECODER_OK",
     L"JSON_DECODER_INVALID_ARG",
@@ -62,6 +134,13 @@ TEST_SUITE_INITIALIZE(BeforeSuite)
     ASSERT_IS_NOT_NULL(g_testByTest);
 }
 
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    saxEvents.clear();
+    saxJSON = NULL;
+    saxFailOn = NULL;
+}
+
 TEST_SUITE_CLEANUP(TestClassCleanup)
 {
     MicroMockDestroyMutex(g_testByTest);
@@ -2593,4 +2672,217 @@ TEST_FUNCTION(JSONDecoder_When_String_Has_Several_Escaped_Chars_Decoding_Succeed
     TestSpecialCharacter_Success(json);
 }
 
+/* JSONDecoder_Parse */
+
+/* Tests_SRS_JSON_DECODER_02_001: [ If json or callbacks is NULL then JSONDecoder_Parse shall return JSON_DECODER_INVALID_ARG. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_with_NULL_json_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_Parse(NULL, 2, &testCallbacks, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, "", saxEvents.c_str());
+}
+
+/* Tests_SRS_JSON_DECODER_02_001: [ If json or callbacks is NULL then JSONDecoder_Parse shall return JSON_DECODER_INVALID_ARG. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_with_NULL_callbacks_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_Parse("{}", 2, NULL, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result);
+}
+
+/* Tests_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_with_zero_length_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse("{}", 0, &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, "", saxEvents.c_str());
+}
+
+/* Tests_SRS_JSON_DECODER_02_003: [ JSONDecoder_Parse shall report the JSON structure by calling the callbacks in document order. Callbacks that are NULL shall be skipped. ]*/
+/* Tests_SRS_JSON_DECODER_02_005: [ OnObjectBegin and OnArrayBegin shall be called with a pointer to the '{' or '[' that opens the object or array. ]*/
+/* Tests_SRS_JSON_DECODER_02_006: [ OnObjectEnd and OnArrayEnd shall be called with a pointer to the character following the '}' or ']' that closes the object or array. ]*/
+/* Tests_SRS_JSON_DECODER_02_007: [ OnMemberName shall be called with a pointer to the first character of the member name and its length, the quotation marks excluded. ]*/
+/* Tests_SRS_JSON_DECODER_02_008: [ OnValue shall be called for every string, number and literal name with a pointer to the first character of the value and its length, quotation marks included for strings. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_reports_all_events_in_document_order)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = " {\"a\":-1.5e3, \"b\":[true,\"x\\\"y\",null], \"c\":{}, \"d\":false} ";
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, strlen(json), &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, "{@1;N:a;V:-1.5e3;N:b;[@18;V:true;V:\"x\\\"y\";V:null;]@36;N:c;{@42;}@44;N:d;V:false;}@56;", saxEvents.c_str());
+}
+
+/* Tests_SRS_JSON_DECODER_02_003: [ JSONDecoder_Parse shall report the JSON structure by calling the callbacks in document order. Callbacks that are NULL shall be skipped. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_with_NULL_callbacks_skips_them)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = "[{\"a\":1},[2]]";
+    JSON_DECODER_CALLBACKS valuesOnly = { NULL, NULL, NULL, NULL, NULL, TestOnValue };
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, strlen(json), &valuesOnly);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, "V:1;V:2;", saxEvents.c_str());
+}
+
+/* Tests_SRS_JSON_DECODER_02_002: [ JSONDecoder_Parse shall parse the jsonLength characters at json without modifying them and without allocating memory. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_does_not_modify_the_json)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    char json[] = "{\"a\":\"b\",\"c\":[1,2]}";
+    char original[sizeof(json)];
+    (void)memcpy(original, json, sizeof(json));
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, strlen(json), &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(original, json, sizeof(json)));
+}
+
+/* Tests_SRS_JSON_DECODER_02_002: [ JSONDecoder_Parse shall parse the jsonLength characters at json without modifying them and without allocating memory. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_stops_at_jsonLength)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = "{\"a\":12}garbage";
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, 8, &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, "{@0;N:a;V:12;}@8;", saxEvents.c_str());
+}
+
+/* Tests_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_with_a_value_cut_by_jsonLength_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = "[true]";
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, 4, &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+}
+
+/* Tests_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_with_trailing_characters_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = "{} x";
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, strlen(json), &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+}
+
+/* Tests_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_with_a_missing_comma_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = "{\"a\":1 \"b\":2}";
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, strlen(json), &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+}
+
+/* Tests_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_with_a_trailing_comma_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = "[1,]";
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, strlen(json), &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+}
+
+/* Tests_SRS_JSON_DECODER_02_004: [ If the JSON is malformed then JSONDecoder_Parse shall return JSON_DECODER_PARSE_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_with_a_scalar_top_level_value_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = "42";
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, strlen(json), &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, "", saxEvents.c_str());
+}
+
+/* Tests_SRS_JSON_DECODER_02_009: [ If a callback returns anything else than JSON_DECODER_OK then JSONDecoder_Parse shall stop parsing and return that value. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_stops_when_a_callback_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = "{\"a\":1,\"b\":2,\"c\":3}";
+    saxFailOn = "N:b";
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, strlen(json), &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, "{@0;N:a;V:1;N:b;", saxEvents.c_str());
+}
+
+/* Tests_SRS_JSON_DECODER_02_009: [ If a callback returns anything else than JSON_DECODER_OK then JSONDecoder_Parse shall stop parsing and return that value. ]*/
+TEST_FUNCTION(JSONDecoder_Parse_stops_when_OnObjectBegin_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    const char* json = "[{\"a\":1},2]";
+    saxFailOn = "{@1";
+
+    ///act
+    JSON_DECODER_RESULT result = TestParse(json, strlen(json), &testCallbacks);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, "[@0;{@1;", saxEvents.c_str());
+}
+
 END_TEST_SUITE(JSONDecoder_ut)
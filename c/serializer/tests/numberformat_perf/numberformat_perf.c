@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <stdint.h>
+#include <time.h>
+#include "numberformat.h"
+
+/*
+ * Compares NumberFormat against the printf based formatting previously used by AgentDataTypes_ToString.
+ * Prints ns/op and the average output length for each formatter. The exit code is 0 unless a value
+ * produced by NumberFormat_Double does not read back as the value that was formatted.
+ */
+
+#define VALUE_COUNT 4096
+#define ROUNDS 256
+
+static double values[VALUE_COUNT];
+static volatile size_t sink;
+
+typedef size_t(*FORMAT_FUNCTION)(char* destination, double value);
+
+static size_t FormatWithNumberFormat(char* destination, double value)
+{
+    return NumberFormat_Double(destination, value);
+}
+
+static size_t FormatWithFixedDblDig(char* destination, double value)
+{
+    /*this is what AgentDataTypes_ToString used to do; destination is large enough for every value in the data set*/
+    return (size_t)sprintf(destination, "%.*f", DBL_DIG, value);
+}
+
+static size_t FormatWithPrecision17(char* destination, double value)
+{
+    return (size_t)sprintf(destination, "%.17g", value);
+}
+
+static void MeasureFormatter(const char* name, FORMAT_FUNCTION format)
+{
+    char buffer[512];
+    size_t totalLength = 0;
+    size_t round;
+    clock_t start = clock();
+    clock_t elapsed;
+    double nsPerOp;
+
+    for (round = 0; round < ROUNDS; round++)
+    {
+        size_t i;
+        for (i = 0; i < VALUE_COUNT; i++)
+        {
+            totalLength += format(buffer, values[i]);
+        }
+    }
+    elapsed = clock() - start;
+    sink = totalLength;
+
+    nsPerOp = ((double)elapsed / CLOCKS_PER_SEC) * 1e9 / ((double)ROUNDS * VALUE_COUNT);
+    (void)printf("%-24s %10.1f ns/op %8.2f chars/value\n", name, nsPerOp, (double)totalLength / ((double)ROUNDS * VALUE_COUNT));
+}
+
+int main(void)
+{
+    int result = 0;
+    size_t i;
+    char buffer[NUMBER_FORMAT_DOUBLE_BUFFER_SIZE];
+
+    /*telemetry-like values: a few decimals, a range of magnitudes*/
+    srand(42);
+    for (i = 0; i < VALUE_COUNT; i++)
+    {
+        double magnitude = (double)(1 << (rand() % 16));
+        values[i] = ((double)rand() / RAND_MAX - 0.5) * magnitude;
+    }
+
+    for (i = 0; i < VALUE_COUNT; i++)
+    {
+        (void)NumberFormat_Double(buffer, values[i]);
+        if (strtod(buffer, NULL) != values[i])
+        {
+            (void)printf("%s does not read back as %.17g\n", buffer, values[i]);
+            result = __LINE__;
+            break;
+        }
+    }
+
+    MeasureFormatter("NumberFormat_Double", FormatWithNumberFormat);
+    MeasureFormatter("sprintf %.*f DBL_DIG", FormatWithFixedDblDig);
+    MeasureFormatter("sprintf %.17g", FormatWithPrecision17);
+
+    return result;
+}
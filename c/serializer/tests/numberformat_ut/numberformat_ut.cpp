@@ -0,0 +1,213 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <cstdlib>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <cstring>
+#include <string>
+#include "testrunnerswitcher.h"
+#include "micromock.h"
+#include "numberformat.h"
+
+static MICROMOCK_MUTEX_HANDLE g_testByTest;
+static MICROMOCK_GLOBAL_SEMAPHORE_HANDLE g_dllByDll;
+
+/*the property tests go through this many random bit patterns*/
+#define ROUND_TRIP_ITERATIONS 200000
+
+/*xorshift64 - deterministic so that a failure can be reproduced*/
+static uint64_t randomState;
+static uint64_t NextRandom(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return randomState;
+}
+
+static std::string FormatDouble(double value)
+{
+    char buffer[NUMBER_FORMAT_DOUBLE_BUFFER_SIZE];
+    size_t length = NumberFormat_Double(buffer, value);
+    ASSERT_ARE_EQUAL(size_t, strlen(buffer), length);
+    return std::string(buffer);
+}
+
+static std::string FormatSingle(float value)
+{
+    char buffer[NUMBER_FORMAT_DOUBLE_BUFFER_SIZE];
+    size_t length = NumberFormat_Single(buffer, value);
+    ASSERT_ARE_EQUAL(size_t, strlen(buffer), length);
+    return std::string(buffer);
+}
+
+static std::string FormatInt64(int64_t value)
+{
+    char buffer[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+    size_t length = NumberFormat_Int64(buffer, value);
+    ASSERT_ARE_EQUAL(size_t, strlen(buffer), length);
+    return std::string(buffer);
+}
+
+BEGIN_TEST_SUITE(NumberFormat_ut)
+
+    TEST_SUITE_INITIALIZE(TestClassInitialize)
+    {
+        TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+        g_testByTest = MicroMockCreateMutex();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+    }
+
+    TEST_SUITE_CLEANUP(TestClassCleanup)
+    {
+        MicroMockDestroyMutex(g_testByTest);
+        TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    }
+
+    TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+    {
+        if (!MicroMockAcquireMutex(g_testByTest))
+        {
+            ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+        }
+        randomState = 88172645463325252ULL;
+    }
+
+    TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+    {
+        if (!MicroMockReleaseMutex(g_testByTest))
+        {
+            ASSERT_FAIL("failure in test framework at ReleaseMutex");
+        }
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_003: [If value is 0, NumberFormat_Double shall write "0.0" (or "-0.0" for negative zero).]*/
+    TEST_FUNCTION(NumberFormat_Double_zero)
+    {
+        ASSERT_ARE_EQUAL(char_ptr, "0.0", FormatDouble(0.0).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "-0.0", FormatDouble(-0.0).c_str());
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_004: [If the decimal exponent of value is between -6 and 21 then the number shall be written in fixed notation with at least one digit after the decimal point for integral values (e.g. "100.0", "0.000125", "3.14").]*/
+    TEST_FUNCTION(NumberFormat_Double_fixed_notation)
+    {
+        ASSERT_ARE_EQUAL(char_ptr, "1.0", FormatDouble(1.0).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "100.0", FormatDouble(100.0).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "-2.5", FormatDouble(-2.5).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "0.1", FormatDouble(0.1).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "3.14159", FormatDouble(3.14159).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "0.000001", FormatDouble(0.000001).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "328647.47547929373", FormatDouble(328647.47547929373980211).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "100000000000000000000.0", FormatDouble(1e20).c_str());
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_005: [Otherwise the number shall be written in exponential notation, with the exponent written without a '+' sign and without leading zeroes (e.g. "1e21", "1.5e-7", "2.2250738585072014e-308").]*/
+    TEST_FUNCTION(NumberFormat_Double_exponential_notation)
+    {
+        ASSERT_ARE_EQUAL(char_ptr, "1e21", FormatDouble(1e21).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "1e-7", FormatDouble(1e-7).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "-1.5e-7", FormatDouble(-1.5e-7).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "5e-324", FormatDouble(5e-324).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "2.2250738585072014e-308", FormatDouble(2.2250738585072014e-308).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "1.7976931348623157e308", FormatDouble(1.7976931348623157e308).c_str());
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_002: [NumberFormat_Double shall write to destination a '\0' terminated decimal representation of value that strtod converts back to value and shall return the number of characters written, not counting the '\0'.]*/
+    TEST_FUNCTION(NumberFormat_Double_round_trips_random_values)
+    {
+        size_t i;
+        for (i = 0; i < ROUND_TRIP_ITERATIONS; i++)
+        {
+            uint64_t bits = NextRandom();
+            double value;
+            double readBack;
+            if (((bits >> 52) & 0x7FF) == 0x7FF)
+            {
+                /*NaN and infinities are not formatted by NumberFormat*/
+                continue;
+            }
+            (void)memcpy(&value, &bits, sizeof(value));
+
+            std::string text = FormatDouble(value);
+            readBack = strtod(text.c_str(), NULL);
+
+            ASSERT_ARE_EQUAL(int, 0, memcmp(&value, &readBack, sizeof(value)));
+        }
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_006: [NumberFormat_Single shall write value following the same rules as NumberFormat_Double, except that the digits shall be those that strtof converts back to value.]*/
+    TEST_FUNCTION(NumberFormat_Single_produces_float_digits)
+    {
+        ASSERT_ARE_EQUAL(char_ptr, "0.1", FormatSingle(0.1f).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "42.5", FormatSingle(42.5f).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "42.589123", FormatSingle(42.589123f).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "16777216.0", FormatSingle(16777216.0f).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "3.4028235e38", FormatSingle(3.4028235e38f).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "1e-45", FormatSingle(1e-45f).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "-0.0", FormatSingle(-0.0f).c_str());
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_006: [NumberFormat_Single shall write value following the same rules as NumberFormat_Double, except that the digits shall be those that strtof converts back to value.]*/
+    TEST_FUNCTION(NumberFormat_Single_round_trips_random_values)
+    {
+        size_t i;
+        for (i = 0; i < ROUND_TRIP_ITERATIONS; i++)
+        {
+            uint32_t bits = (uint32_t)NextRandom();
+            float value;
+            float readBack;
+            if (((bits >> 23) & 0xFF) == 0xFF)
+            {
+                continue;
+            }
+            (void)memcpy(&value, &bits, sizeof(value));
+
+            std::string text = FormatSingle(value);
+            readBack = strtof(text.c_str(), NULL);
+
+            ASSERT_ARE_EQUAL(int, 0, memcmp(&value, &readBack, sizeof(value)));
+        }
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_007: [NumberFormat_Int64 and NumberFormat_UInt64 shall write to destination the '\0' terminated decimal representation of value, with a leading '-' for negative values and no leading zeroes, and shall return the number of characters written, not counting the '\0'.]*/
+    TEST_FUNCTION(NumberFormat_Int64_values)
+    {
+        ASSERT_ARE_EQUAL(char_ptr, "0", FormatInt64(0).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "9", FormatInt64(9).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "10", FormatInt64(10).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "-1", FormatInt64(-1).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "-1234567", FormatInt64(-1234567).c_str());
+        ASSERT_ARE_EQUAL(char_ptr, "9223372036854775807", FormatInt64(9223372036854775807LL).c_str());
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_008: [NumberFormat_Int64 shall write INT64_MIN as "-9223372036854775808".]*/
+    TEST_FUNCTION(NumberFormat_Int64_minimum_value)
+    {
+        ASSERT_ARE_EQUAL(char_ptr, "-9223372036854775808", FormatInt64(-9223372036854775807LL - 1).c_str());
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_007: [NumberFormat_Int64 and NumberFormat_UInt64 shall write to destination the '\0' terminated decimal representation of value, with a leading '-' for negative values and no leading zeroes, and shall return the number of characters written, not counting the '\0'.]*/
+    TEST_FUNCTION(NumberFormat_UInt64_maximum_value)
+    {
+        char buffer[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+        size_t length = NumberFormat_UInt64(buffer, 18446744073709551615ULL);
+        ASSERT_ARE_EQUAL(char_ptr, "18446744073709551615", buffer);
+        ASSERT_ARE_EQUAL(size_t, 20, length);
+    }
+
+    /*Tests_SRS_NUMBER_FORMAT_02_007: [NumberFormat_Int64 and NumberFormat_UInt64 shall write to destination the '\0' terminated decimal representation of value, with a leading '-' for negative values and no leading zeroes, and shall return the number of characters written, not counting the '\0'.]*/
+    TEST_FUNCTION(NumberFormat_Int64_round_trips_random_values)
+    {
+        size_t i;
+        for (i = 0; i < ROUND_TRIP_ITERATIONS; i++)
+        {
+            int64_t value = (int64_t)NextRandom();
+            std::string text = FormatInt64(value);
+            ASSERT_ARE_EQUAL(int, 1, (value == (int64_t)strtoll(text.c_str(), NULL, 10)) ? 1 : 0);
+        }
+    }
+
+END_TEST_SUITE(NumberFormat_ut)
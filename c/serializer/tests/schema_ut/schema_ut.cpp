@@ -3821,4 +3821,423 @@ BEGIN_TEST_SUITE(Schema_ut)
         ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result);
     }
 
+    /* Schema_Freeze */
+
+    /* Tests_SRS_SCHEMA_02_006: [ If schemaHandle is NULL, Schema_Freeze shall return SCHEMA_INVALID_ARG. ]*/
+    TEST_FUNCTION(Schema_Freeze_With_NULL_Handle_Fails)
+    {
+        ///arrange
+
+        ///act
+        SCHEMA_RESULT result = Schema_Freeze(NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_INVALID_ARG, result);
+    }
+
+    /* Tests_SRS_SCHEMA_02_008: [ Schema_Freeze shall build a hash index of the model types and one of the struct types of the schema. ]*/
+    /* Tests_SRS_SCHEMA_02_009: [ For every model type, Schema_Freeze shall build a hash index of its properties, one of its actions and one of its models. ]*/
+    /* Tests_SRS_SCHEMA_02_012: [ Otherwise Schema_Freeze shall mark the schema as frozen and return SCHEMA_OK. ]*/
+    /* Tests_SRS_SCHEMA_02_013: [ Once the schema is frozen, Schema_GetModelPropertyByName, Schema_GetModelActionByName, Schema_GetModelModelByName, Schema_GetModelByName and Schema_GetStructTypeByName shall find the element through the hash indexes built by Schema_Freeze instead of comparing the name with every element. ]*/
+    TEST_FUNCTION(Schema_Freeze_Keeps_All_Elements_Reachable_By_Name)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        SCHEMA_MODEL_TYPE_HANDLE mediumModel = Schema_CreateModelType(schemaHandle, "someMediumModel");
+        SCHEMA_STRUCT_TYPE_HANDLE structType = Schema_CreateStructType(schemaHandle, "someStruct");
+        SCHEMA_ACTION_HANDLE action = Schema_CreateModelAction(bigModel, "someAction");
+        char propertyName[] = "property00";
+        size_t i;
+        for (i = 0; i < 100; i++)
+        {
+            propertyName[8] = (char)('0' + (i / 10));
+            propertyName[9] = (char)('0' + (i % 10));
+            (void)Schema_AddModelProperty(bigModel, propertyName, "int");
+        }
+        (void)Schema_AddModelModel(bigModel, "theMediumModel", mediumModel);
+
+        ///act
+        SCHEMA_RESULT result = Schema_Freeze(schemaHandle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result);
+        ASSERT_ARE_EQUAL(void_ptr, bigModel, Schema_GetModelByName(schemaHandle, "someBigModel"));
+        ASSERT_ARE_EQUAL(void_ptr, mediumModel, Schema_GetModelByName(schemaHandle, "someMediumModel"));
+        ASSERT_IS_NULL(Schema_GetModelByName(schemaHandle, "someOtherModel"));
+        ASSERT_ARE_EQUAL(void_ptr, structType, Schema_GetStructTypeByName(schemaHandle, "someStruct"));
+        ASSERT_IS_NULL(Schema_GetStructTypeByName(schemaHandle, "someBigModel"));
+        ASSERT_ARE_EQUAL(void_ptr, action, Schema_GetModelActionByName(bigModel, "someAction"));
+        ASSERT_IS_NULL(Schema_GetModelActionByName(mediumModel, "someAction"));
+        ASSERT_ARE_EQUAL(void_ptr, mediumModel, Schema_GetModelModelByName(bigModel, "theMediumModel"));
+        ASSERT_IS_NULL(Schema_GetModelModelByName(bigModel, "property1"));
+        for (i = 0; i < 100; i++)
+        {
+            propertyName[8] = (char)('0' + (i / 10));
+            propertyName[9] = (char)('0' + (i % 10));
+            ASSERT_ARE_EQUAL(void_ptr, Schema_GetModelPropertyByIndex(bigModel, i), Schema_GetModelPropertyByName(bigModel, propertyName));
+        }
+        ASSERT_IS_NULL(Schema_GetModelPropertyByName(bigModel, "property100"));
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_007: [ If the schema is already frozen, Schema_Freeze shall return SCHEMA_OK without doing anything. ]*/
+    TEST_FUNCTION(Schema_Freeze_Twice_Succeeds)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        (void)Schema_AddModelProperty(bigModel, "propertyName", "type");
+        (void)Schema_Freeze(schemaHandle);
+
+        ///act
+        SCHEMA_RESULT result = Schema_Freeze(schemaHandle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result);
+        ASSERT_IS_TRUE(Schema_ModelPropertyByPathExists(bigModel, "propertyName"));
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_008: [ Schema_Freeze shall build a hash index of the model types and one of the struct types of the schema. ]*/
+    TEST_FUNCTION(Schema_Freeze_An_Empty_Schema_Succeeds)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+
+        ///act
+        SCHEMA_RESULT result = Schema_Freeze(schemaHandle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result);
+        ASSERT_IS_NULL(Schema_GetModelByName(schemaHandle, MODEL_NAME));
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_011: [ If any error occurs, Schema_Freeze shall release everything it built, leave the schema unfrozen and return SCHEMA_ERROR. ]*/
+    TEST_FUNCTION(Schema_Freeze_With_Models_In_Models_Nested_Too_Deep_Fails)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        SCHEMA_MODEL_TYPE_HANDLE mediumModel = Schema_CreateModelType(schemaHandle, "someMediumModel");
+        (void)Schema_AddModelModel(bigModel, "theMediumModel", mediumModel);
+        (void)Schema_AddModelModel(mediumModel, "theBigModel", bigModel);
+
+        ///act
+        SCHEMA_RESULT result = Schema_Freeze(schemaHandle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ERROR, result);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, Schema_AddModelProperty(bigModel, "propertyName", "type"));
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_001: [ If the model type belongs to a frozen schema, Schema_AddModelProperty shall fail and return SCHEMA_ERROR. ]*/
+    /* Tests_SRS_SCHEMA_02_002: [ If the schema is frozen, Schema_CreateModelType shall fail and return NULL. ]*/
+    /* Tests_SRS_SCHEMA_02_003: [ If the model type belongs to a frozen schema, Schema_CreateModelAction shall fail and return NULL. ]*/
+    /* Tests_SRS_SCHEMA_02_004: [ If the schema is frozen, Schema_CreateStructType shall fail and return NULL. ]*/
+    /* Tests_SRS_SCHEMA_02_005: [ If the model type identified by modelTypeHandle belongs to a frozen schema, Schema_AddModelModel shall fail and return SCHEMA_ERROR. ]*/
+    TEST_FUNCTION(Schema_A_Frozen_Schema_Cannot_Be_Changed)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        SCHEMA_MODEL_TYPE_HANDLE mediumModel = Schema_CreateModelType(schemaHandle, "someMediumModel");
+        (void)Schema_Freeze(schemaHandle);
+
+        ///act
+        SCHEMA_RESULT addPropertyResult = Schema_AddModelProperty(bigModel, "propertyName", "type");
+        SCHEMA_MODEL_TYPE_HANDLE newModel = Schema_CreateModelType(schemaHandle, "someSmallModel");
+        SCHEMA_ACTION_HANDLE newAction = Schema_CreateModelAction(bigModel, "someAction");
+        SCHEMA_STRUCT_TYPE_HANDLE newStructType = Schema_CreateStructType(schemaHandle, "someStruct");
+        SCHEMA_RESULT addModelResult = Schema_AddModelModel(bigModel, "theMediumModel", mediumModel);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ERROR, addPropertyResult);
+        ASSERT_IS_NULL(newModel);
+        ASSERT_IS_NULL(newAction);
+        ASSERT_IS_NULL(newStructType);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ERROR, addModelResult);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_014: [ Once the schema is frozen, Schema_ModelPropertyByPathExists shall look the whole path up in the property id index of the model instead of walking the path one segment at a time. ]*/
+    TEST_FUNCTION(Schema_ModelPropertyByPathExists_On_A_Frozen_Schema_Finds_Properties_And_Models)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        SCHEMA_MODEL_TYPE_HANDLE mediumModel = Schema_CreateModelType(schemaHandle, "someMediumModel");
+        (void)Schema_AddModelModel(bigModel, "theMediumModel", mediumModel);
+        (void)Schema_AddModelProperty(mediumModel, "propertyName", "type");
+        (void)Schema_Freeze(schemaHandle);
+
+        ///act
+        bool result1 = Schema_ModelPropertyByPathExists(bigModel, "theMediumModel/propertyName");
+        bool result2 = Schema_ModelPropertyByPathExists(bigModel, "/theMediumModel/propertyName");
+        bool result3 = Schema_ModelPropertyByPathExists(bigModel, "theMediumModel");
+        bool result4 = Schema_ModelPropertyByPathExists(bigModel, "theMediumModel/otherPropertyName");
+        bool result5 = Schema_ModelPropertyByPathExists(bigModel, "propertyName");
+
+        ///assert
+        ASSERT_IS_TRUE(result1);
+        ASSERT_IS_TRUE(result2);
+        ASSERT_IS_TRUE(result3);
+        ASSERT_IS_FALSE(result4);
+        ASSERT_IS_FALSE(result5);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Schema_GetModelPropertyIdCount */
+
+    /* Tests_SRS_SCHEMA_02_015: [ If any of the arguments is NULL, Schema_GetModelPropertyIdCount shall return SCHEMA_INVALID_ARG. ]*/
+    TEST_FUNCTION(Schema_GetModelPropertyIdCount_With_NULL_Arguments_Fails)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        size_t propertyIdCount;
+        (void)Schema_Freeze(schemaHandle);
+
+        ///act
+        SCHEMA_RESULT result1 = Schema_GetModelPropertyIdCount(NULL, &propertyIdCount);
+        SCHEMA_RESULT result2 = Schema_GetModelPropertyIdCount(bigModel, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_INVALID_ARG, result1);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_INVALID_ARG, result2);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_016: [ If the model type does not belong to a frozen schema, Schema_GetModelPropertyIdCount shall return SCHEMA_ERROR. ]*/
+    TEST_FUNCTION(Schema_GetModelPropertyIdCount_On_A_Schema_Not_Frozen_Fails)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        size_t propertyIdCount;
+
+        ///act
+        SCHEMA_RESULT result = Schema_GetModelPropertyIdCount(bigModel, &propertyIdCount);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ERROR, result);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_010: [ For every model type, Schema_Freeze shall assign a property id to every path accepted by Schema_ModelPropertyByPathExists: the model's properties in the order they were added, then every model in model, each followed by the paths inside that model. ]*/
+    /* Tests_SRS_SCHEMA_02_017: [ Schema_GetModelPropertyIdCount shall provide in propertyIdCount the number of property ids of the model type and return SCHEMA_OK. Property ids are 0 to propertyIdCount - 1. ]*/
+    TEST_FUNCTION(Schema_GetModelPropertyIdCount_Counts_Properties_And_Models_In_Models)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        SCHEMA_MODEL_TYPE_HANDLE mediumModel = Schema_CreateModelType(schemaHandle, "someMediumModel");
+        SCHEMA_MODEL_TYPE_HANDLE smallModel = Schema_CreateModelType(schemaHandle, "someSmallModel");
+        (void)Schema_AddModelProperty(bigModel, "bigProperty", "type");
+        (void)Schema_AddModelModel(bigModel, "theMediumModel", mediumModel);
+        (void)Schema_AddModelProperty(mediumModel, "mediumProperty1", "type");
+        (void)Schema_AddModelProperty(mediumModel, "mediumProperty2", "type");
+        (void)Schema_AddModelModel(mediumModel, "theSmallModel", smallModel);
+        (void)Schema_AddModelProperty(smallModel, "smallProperty", "type");
+        (void)Schema_Freeze(schemaHandle);
+        size_t bigCount;
+        size_t mediumCount;
+        size_t smallCount;
+
+        ///act
+        SCHEMA_RESULT result1 = Schema_GetModelPropertyIdCount(bigModel, &bigCount);
+        SCHEMA_RESULT result2 = Schema_GetModelPropertyIdCount(mediumModel, &mediumCount);
+        SCHEMA_RESULT result3 = Schema_GetModelPropertyIdCount(smallModel, &smallCount);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result1);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result2);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result3);
+        ASSERT_ARE_EQUAL(size_t, 6, bigCount);
+        ASSERT_ARE_EQUAL(size_t, 4, mediumCount);
+        ASSERT_ARE_EQUAL(size_t, 1, smallCount);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Schema_GetModelPropertyIdByPath */
+
+    /* Tests_SRS_SCHEMA_02_018: [ If any of the arguments is NULL, Schema_GetModelPropertyIdByPath shall return SCHEMA_INVALID_ARG. ]*/
+    TEST_FUNCTION(Schema_GetModelPropertyIdByPath_With_NULL_Arguments_Fails)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        (void)Schema_AddModelProperty(bigModel, "propertyName", "type");
+        (void)Schema_Freeze(schemaHandle);
+        size_t propertyId;
+
+        ///act
+        SCHEMA_RESULT result1 = Schema_GetModelPropertyIdByPath(NULL, "propertyName", &propertyId);
+        SCHEMA_RESULT result2 = Schema_GetModelPropertyIdByPath(bigModel, NULL, &propertyId);
+        SCHEMA_RESULT result3 = Schema_GetModelPropertyIdByPath(bigModel, "propertyName", NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_INVALID_ARG, result1);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_INVALID_ARG, result2);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_INVALID_ARG, result3);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_019: [ If the model type does not belong to a frozen schema, Schema_GetModelPropertyIdByPath shall return SCHEMA_ERROR. ]*/
+    TEST_FUNCTION(Schema_GetModelPropertyIdByPath_On_A_Schema_Not_Frozen_Fails)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        (void)Schema_AddModelProperty(bigModel, "propertyName", "type");
+        size_t propertyId;
+
+        ///act
+        SCHEMA_RESULT result = Schema_GetModelPropertyIdByPath(bigModel, "propertyName", &propertyId);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ERROR, result);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_010: [ For every model type, Schema_Freeze shall assign a property id to every path accepted by Schema_ModelPropertyByPathExists: the model's properties in the order they were added, then every model in model, each followed by the paths inside that model. ]*/
+    /* Tests_SRS_SCHEMA_02_020: [ A single slash ('/') at the beginning of propertyPath shall be ignored. ]*/
+    /* Tests_SRS_SCHEMA_02_021: [ Schema_GetModelPropertyIdByPath shall provide in propertyId the property id of propertyPath and return SCHEMA_OK. ]*/
+    TEST_FUNCTION(Schema_GetModelPropertyIdByPath_Returns_Ids_In_Model_Order)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        SCHEMA_MODEL_TYPE_HANDLE mediumModel = Schema_CreateModelType(schemaHandle, "someMediumModel");
+        (void)Schema_AddModelModel(bigModel, "theMediumModel", mediumModel);
+        (void)Schema_AddModelProperty(bigModel, "bigProperty1", "type");
+        (void)Schema_AddModelProperty(bigModel, "bigProperty2", "type");
+        (void)Schema_AddModelProperty(mediumModel, "mediumProperty", "type");
+        (void)Schema_Freeze(schemaHandle);
+        size_t propertyId1;
+        size_t propertyId2;
+        size_t propertyId3;
+        size_t propertyId4;
+
+        ///act
+        SCHEMA_RESULT result1 = Schema_GetModelPropertyIdByPath(bigModel, "bigProperty1", &propertyId1);
+        SCHEMA_RESULT result2 = Schema_GetModelPropertyIdByPath(bigModel, "/bigProperty2", &propertyId2);
+        SCHEMA_RESULT result3 = Schema_GetModelPropertyIdByPath(bigModel, "theMediumModel", &propertyId3);
+        SCHEMA_RESULT result4 = Schema_GetModelPropertyIdByPath(bigModel, "theMediumModel/mediumProperty", &propertyId4);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result1);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result2);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result3);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result4);
+        ASSERT_ARE_EQUAL(size_t, 0, propertyId1);
+        ASSERT_ARE_EQUAL(size_t, 1, propertyId2);
+        ASSERT_ARE_EQUAL(size_t, 2, propertyId3);
+        ASSERT_ARE_EQUAL(size_t, 3, propertyId4);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_022: [ If propertyPath does not exist in the model type, Schema_GetModelPropertyIdByPath shall return SCHEMA_ELEMENT_NOT_FOUND. ]*/
+    TEST_FUNCTION(Schema_GetModelPropertyIdByPath_With_Unknown_Path_Fails)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        SCHEMA_MODEL_TYPE_HANDLE mediumModel = Schema_CreateModelType(schemaHandle, "someMediumModel");
+        (void)Schema_AddModelModel(bigModel, "theMediumModel", mediumModel);
+        (void)Schema_AddModelProperty(mediumModel, "propertyName", "type");
+        (void)Schema_Freeze(schemaHandle);
+        size_t propertyId;
+
+        ///act
+        SCHEMA_RESULT result1 = Schema_GetModelPropertyIdByPath(bigModel, "propertyName", &propertyId);
+        SCHEMA_RESULT result2 = Schema_GetModelPropertyIdByPath(bigModel, "theMediumModel/", &propertyId);
+        SCHEMA_RESULT result3 = Schema_GetModelPropertyIdByPath(bigModel, "theMediumModel/propertyName/", &propertyId);
+
+        ///assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ELEMENT_NOT_FOUND, result1);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ELEMENT_NOT_FOUND, result2);
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ELEMENT_NOT_FOUND, result3);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Schema_GetModelPropertyPathById */
+
+    /* Tests_SRS_SCHEMA_02_023: [ If modelTypeHandle is NULL, the model type does not belong to a frozen schema or propertyId is not a property id of the model type, Schema_GetModelPropertyPathById shall return NULL. ]*/
+    TEST_FUNCTION(Schema_GetModelPropertyPathById_With_Invalid_Arguments_Fails)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        (void)Schema_AddModelProperty(bigModel, "propertyName", "type");
+
+        ///act
+        const char* result1 = Schema_GetModelPropertyPathById(bigModel, 0);
+        (void)Schema_Freeze(schemaHandle);
+        const char* result2 = Schema_GetModelPropertyPathById(NULL, 0);
+        const char* result3 = Schema_GetModelPropertyPathById(bigModel, 1);
+
+        ///assert
+        ASSERT_IS_NULL(result1);
+        ASSERT_IS_NULL(result2);
+        ASSERT_IS_NULL(result3);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_02_024: [ Otherwise Schema_GetModelPropertyPathById shall return the path, without a leading slash, that has the property id propertyId. The path stays valid until the schema is destroyed. ]*/
+    TEST_FUNCTION(Schema_GetModelPropertyPathById_Returns_The_Path_Of_Every_Id)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        SCHEMA_MODEL_TYPE_HANDLE mediumModel = Schema_CreateModelType(schemaHandle, "someMediumModel");
+        (void)Schema_AddModelProperty(bigModel, "bigProperty", "type");
+        (void)Schema_AddModelModel(bigModel, "theMediumModel", mediumModel);
+        (void)Schema_AddModelProperty(mediumModel, "mediumProperty", "type");
+        (void)Schema_Freeze(schemaHandle);
+
+        ///act
+        const char* result1 = Schema_GetModelPropertyPathById(bigModel, 0);
+        const char* result2 = Schema_GetModelPropertyPathById(bigModel, 1);
+        const char* result3 = Schema_GetModelPropertyPathById(bigModel, 2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, "bigProperty", result1);
+        ASSERT_ARE_EQUAL(char_ptr, "theMediumModel", result2);
+        ASSERT_ARE_EQUAL(char_ptr, "theMediumModel/mediumProperty", result3);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
 END_TEST_SUITE(Schema_ut)
@@ -0,0 +1,300 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "azure_c_shared_utility/strings.h"
+#include "serializer.h"
+#include "datamarshaller.h"
+#include "multitree.h"
+#include "jsonencoder.h"
+#include "jsondecoder.h"
+#include "commanddecoder.h"
+#include "agenttypesystem.h"
+#include "micro_benchmark.h"
+
+/*
+ * Measures the serializer hot paths with a telemetry-like model of a few properties and one action:
+ *  - CodeFirst_SendAsync (what SERIALIZE does), DataMarshaller_SendData and JSONEncoder_EncodeTree on the same values
+ *  - JSONDecoder_JSON_To_MultiTree and CommandDecoder_ExecuteCommand on the same command
+ *  - AgentDataTypes_ToString for a double and for a string
+ * Every operation includes the release of what it produced. The results are compared against the baseline file
+ * given on the command line (serializer_perf_baseline.txt next to this file), see micro_benchmark.h.
+ */
+
+#define VALUE_COUNT 4
+
+BEGIN_NAMESPACE(SerializerPerf);
+
+DECLARE_MODEL(Thermostat,
+    WITH_DATA(ascii_char_ptr, DeviceId),
+    WITH_DATA(int, Temperature),
+    WITH_DATA(double, Humidity),
+    WITH_DATA(int, Pressure),
+    WITH_ACTION(SetTemperature, int, Temperature)
+);
+
+END_NAMESPACE(SerializerPerf);
+
+EXECUTE_COMMAND_RESULT SetTemperature(Thermostat* device, int Temperature)
+{
+    device->Temperature = Temperature;
+    return EXECUTE_COMMAND_SUCCESS;
+}
+
+static const char COMMAND[] = "{\"Name\":\"SetTemperature\",\"Parameters\":{\"Temperature\":21}}";
+static const char* const PROPERTY_NAMES[VALUE_COUNT] = { "DeviceId", "Temperature", "Humidity", "Pressure" };
+
+typedef struct SERIALIZER_PERF_TAG
+{
+    Thermostat* device;
+    DATA_MARSHALLER_HANDLE dataMarshaller;
+    COMMAND_DECODER_HANDLE commandDecoder;
+    MULTITREE_HANDLE tree;
+    AGENT_DATA_TYPE agentData[VALUE_COUNT];
+    DATA_MARSHALLER_VALUE values[VALUE_COUNT];
+    char commandCopy[sizeof(COMMAND)];
+} SERIALIZER_PERF;
+
+static int NoCloneFunction(void** destination, const void* source)
+{
+    *destination = (void*)source;
+    return 0;
+}
+
+static void NoFreeFunction(void* value)
+{
+    (void)value;
+}
+
+static EXECUTE_COMMAND_RESULT ActionCallback(void* actionCallbackContext, const char* relativeActionPath, const char* actionName, size_t argCount, const AGENT_DATA_TYPE* args)
+{
+    (void)actionCallbackContext;
+    (void)relativeActionPath;
+    (void)actionName;
+    (void)args;
+    return (argCount == 1) ? EXECUTE_COMMAND_SUCCESS : EXECUTE_COMMAND_ERROR;
+}
+
+static int MeasureCodeFirstSendAsync(void* context)
+{
+    SERIALIZER_PERF* perf = (SERIALIZER_PERF*)context;
+    unsigned char* destination;
+    size_t destinationSize;
+    int result;
+    if (SERIALIZE(&destination, &destinationSize, perf->device->DeviceId, perf->device->Temperature, perf->device->Humidity, perf->device->Pressure) != IOT_AGENT_OK)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        free(destination);
+        result = 0;
+    }
+    return result;
+}
+
+static int MeasureDataMarshallerSendData(void* context)
+{
+    SERIALIZER_PERF* perf = (SERIALIZER_PERF*)context;
+    unsigned char* destination;
+    size_t destinationSize;
+    int result;
+    if (DataMarshaller_SendData(perf->dataMarshaller, VALUE_COUNT, perf->values, &destination, &destinationSize) != DATA_MARSHALLER_OK)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        free(destination);
+        result = 0;
+    }
+    return result;
+}
+
+static int MeasureJSONEncoderEncodeTree(void* context)
+{
+    SERIALIZER_PERF* perf = (SERIALIZER_PERF*)context;
+    STRING_HANDLE destination = STRING_new();
+    int result;
+    if (destination == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = (JSONEncoder_EncodeTree(perf->tree, destination, (JSON_ENCODER_TOSTRING_FUNC)AgentDataTypes_ToString) == JSON_ENCODER_OK) ? 0 : __LINE__;
+        STRING_delete(destination);
+    }
+    return result;
+}
+
+static int MeasureJSONDecoderToMultiTree(void* context)
+{
+    SERIALIZER_PERF* perf = (SERIALIZER_PERF*)context;
+    MULTITREE_HANDLE tree;
+    int result;
+    /*the decoder works in place*/
+    (void)memcpy(perf->commandCopy, COMMAND, sizeof(COMMAND));
+    if (JSONDecoder_JSON_To_MultiTree(perf->commandCopy, &tree) != JSON_DECODER_OK)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        MultiTree_Destroy(tree);
+        result = 0;
+    }
+    return result;
+}
+
+static int MeasureCommandDecoderExecuteCommand(void* context)
+{
+    SERIALIZER_PERF* perf = (SERIALIZER_PERF*)context;
+    return (CommandDecoder_ExecuteCommand(perf->commandDecoder, COMMAND) == EXECUTE_COMMAND_SUCCESS) ? 0 : __LINE__;
+}
+
+static int MeasureToString(const AGENT_DATA_TYPE* value)
+{
+    STRING_HANDLE destination = STRING_new();
+    int result;
+    if (destination == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = (AgentDataTypes_ToString(destination, value) == AGENT_DATA_TYPES_OK) ? 0 : __LINE__;
+        STRING_delete(destination);
+    }
+    return result;
+}
+
+static int MeasureAgentDataTypesToStringDouble(void* context)
+{
+    return MeasureToString(&((SERIALIZER_PERF*)context)->agentData[2]);
+}
+
+static int MeasureAgentDataTypesToStringCharz(void* context)
+{
+    return MeasureToString(&((SERIALIZER_PERF*)context)->agentData[0]);
+}
+
+static int CreateValues(SERIALIZER_PERF* perf)
+{
+    int result;
+    size_t i;
+    if ((Create_AGENT_DATA_TYPE_from_charz(&perf->agentData[0], perf->device->DeviceId) != AGENT_DATA_TYPES_OK) ||
+        (Create_AGENT_DATA_TYPE_from_SINT32(&perf->agentData[1], perf->device->Temperature) != AGENT_DATA_TYPES_OK) ||
+        (Create_AGENT_DATA_TYPE_from_DOUBLE(&perf->agentData[2], perf->device->Humidity) != AGENT_DATA_TYPES_OK) ||
+        (Create_AGENT_DATA_TYPE_from_SINT32(&perf->agentData[3], perf->device->Pressure) != AGENT_DATA_TYPES_OK) ||
+        ((perf->tree = MultiTree_Create(NoCloneFunction, NoFreeFunction)) == NULL))
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+        for (i = 0; i < VALUE_COUNT; i++)
+        {
+            perf->values[i].PropertyPath = PROPERTY_NAMES[i];
+            perf->values[i].Value = &perf->agentData[i];
+            if (MultiTree_AddLeaf(perf->tree, PROPERTY_NAMES[i], &perf->agentData[i]) != MULTITREE_OK)
+            {
+                result = __LINE__;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+/*a failed operation is counted by micro_benchmark_compare*/
+static void RunBenchmarks(MICRO_BENCHMARK_HANDLE benchmark, SERIALIZER_PERF* perf)
+{
+    (void)micro_benchmark_run(benchmark, "CodeFirst_SendAsync", MeasureCodeFirstSendAsync, perf);
+    (void)micro_benchmark_run(benchmark, "DataMarshaller_SendData", MeasureDataMarshallerSendData, perf);
+    (void)micro_benchmark_run(benchmark, "JSONEncoder_EncodeTree", MeasureJSONEncoderEncodeTree, perf);
+    (void)micro_benchmark_run(benchmark, "JSONDecoder_JSON_To_MultiTree", MeasureJSONDecoderToMultiTree, perf);
+    (void)micro_benchmark_run(benchmark, "CommandDecoder_ExecuteCommand", MeasureCommandDecoderExecuteCommand, perf);
+    (void)micro_benchmark_run(benchmark, "AgentDataTypes_ToString/double", MeasureAgentDataTypesToStringDouble, perf);
+    (void)micro_benchmark_run(benchmark, "AgentDataTypes_ToString/charz", MeasureAgentDataTypesToStringCharz, perf);
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    MICRO_BENCHMARK_HANDLE benchmark = micro_benchmark_create(argc, argv);
+    if (benchmark == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        if (serializer_init(NULL) != SERIALIZER_OK)
+        {
+            (void)printf("serializer_init failed\n");
+            result = __LINE__;
+        }
+        else
+        {
+            SERIALIZER_PERF perf;
+            size_t i;
+            (void)memset(&perf, 0, sizeof(perf));
+            if ((perf.device = CREATE_MODEL_INSTANCE(SerializerPerf, Thermostat)) == NULL)
+            {
+                (void)printf("CREATE_MODEL_INSTANCE failed\n");
+                result = __LINE__;
+            }
+            else
+            {
+                SCHEMA_MODEL_TYPE_HANDLE modelHandle = GET_MODEL_HANDLE(SerializerPerf, Thermostat);
+                perf.device->DeviceId = "serializer_perf";
+                perf.device->Temperature = 21;
+                perf.device->Humidity = 47.25;
+                perf.device->Pressure = 1013;
+
+                if ((modelHandle == NULL) ||
+                    ((perf.dataMarshaller = DataMarshaller_Create(modelHandle, false)) == NULL) ||
+                    ((perf.commandDecoder = CommandDecoder_Create(modelHandle, ActionCallback, NULL)) == NULL) ||
+                    (CreateValues(&perf) != 0))
+                {
+                    (void)printf("unable to set up the benchmark\n");
+                    result = __LINE__;
+                }
+                else
+                {
+                    RunBenchmarks(benchmark, &perf);
+                    result = micro_benchmark_compare(benchmark);
+                }
+
+                if (perf.tree != NULL)
+                {
+                    MultiTree_Destroy(perf.tree);
+                }
+                for (i = 0; i < VALUE_COUNT; i++)
+                {
+                    if (perf.agentData[i].type != EDM_NO_TYPE)
+                    {
+                        Destroy_AGENT_DATA_TYPE(&perf.agentData[i]);
+                    }
+                }
+                if (perf.commandDecoder != NULL)
+                {
+                    CommandDecoder_Destroy(perf.commandDecoder);
+                }
+                if (perf.dataMarshaller != NULL)
+                {
+                    DataMarshaller_Destroy(perf.dataMarshaller);
+                }
+                DESTROY_MODEL_INSTANCE(perf.device);
+            }
+            serializer_deinit();
+        }
+        micro_benchmark_destroy(benchmark);
+    }
+    return result;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_standin.h
+*	@brief A local stand-in for the device side of an IoT Hub, for benchmarks
+*		   and load tests that must run without network access.
+*
+*	@details The stand-in listens on 127.0.0.1 with TLS and speaks enough of the
+*			 HTTP, MQTT and AMQP surfaces of IoT Hub for the transports of the
+*			 SDK: it accepts and acknowledges events, sends cloud to device
+*			 messages and injects faults (a latency before every acknowledgement,
+*			 dropped events and throttled events). It authenticates nobody and
+*			 keeps nothing but counters. One thread serves all the connections.
+*
+*			 Connect a client with IoTHubClient_LL_Create, "127.0.0.1" as
+*			 protocolGatewayHostName (append ":port" for HTTP when it does not
+*			 listen on 443; MQTT always uses 8883 and AMQP 5671) and the PEM of
+*			 ::iothub_standin_get_certificate as the "TrustedCerts" option.
+*/
+
+#ifndef IOTHUB_STANDIN_H
+#define IOTHUB_STANDIN_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C"
+{
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+typedef struct IOTHUB_STANDIN_TAG* IOTHUB_STANDIN_HANDLE;
+
+typedef struct IOTHUB_STANDIN_CONFIG_TAG
+{
+    /*PEM files of the certificate and its key, both NULL for a self-signed certificate of 127.0.0.1*/
+    const char* certificateFile;
+    const char* privateKeyFile;
+
+    /*0 does not listen for the protocol*/
+    uint16_t httpPort;
+    uint16_t mqttPort;
+    uint16_t amqpPort;
+
+    /*the delay of every acknowledgement of an event*/
+    unsigned int ackLatencyMs;
+
+    /*the percentage of the events that are never acknowledged*/
+    unsigned int dropPercent;
+
+    /*the percentage of the events that are refused: HTTP 429, the MQTT connection is closed, AMQP rejected with amqp:resource-limit-exceeded*/
+    unsigned int throttlePercent;
+
+    /*every connection that listens for cloud to device messages gets one of c2dSize bytes every c2dIntervalMs, 0 sends none*/
+    unsigned int c2dIntervalMs;
+    size_t c2dSize;
+
+    /*the seed of the faults, the same seed gives the same faults to the same events*/
+    unsigned int seed;
+} IOTHUB_STANDIN_CONFIG;
+
+typedef struct IOTHUB_STANDIN_STATS_TAG
+{
+    uint64_t connections;
+    uint64_t eventsReceived;
+    uint64_t eventsAcknowledged;
+    uint64_t eventsDropped;
+    uint64_t eventsThrottled;
+    uint64_t bytesReceived;
+    uint64_t c2dSent;
+    uint64_t c2dSettled;
+} IOTHUB_STANDIN_STATS;
+
+/**
+* @brief	Fills @p config with the defaults: a self-signed certificate, HTTP on 443,
+*			MQTT on 8883, AMQP on 5671, no fault and no cloud to device message.
+*/
+extern void iothub_standin_config_init(IOTHUB_STANDIN_CONFIG* config);
+
+/**
+* @brief	Listens on the ports of @p config and starts the thread that serves them.
+*
+* @return	A handle to the stand-in, NULL if a port cannot be bound or on failure.
+*/
+extern IOTHUB_STANDIN_HANDLE iothub_standin_start(const IOTHUB_STANDIN_CONFIG* config);
+
+/**
+* @brief	Stops the thread, closes all the connections and frees the stand-in.
+*/
+extern void iothub_standin_stop(IOTHUB_STANDIN_HANDLE standin);
+
+/**
+* @brief	The certificate of the stand-in in PEM, to be trusted by the clients.
+*			Valid until ::iothub_standin_stop.
+*/
+extern const char* iothub_standin_get_certificate(IOTHUB_STANDIN_HANDLE standin);
+
+/**
+* @brief	Copies the counters of the stand-in to @p stats. Can be called from any thread.
+*
+* @return	0 on success, non-zero if an argument is NULL.
+*/
+extern int iothub_standin_get_stats(IOTHUB_STANDIN_HANDLE standin, IOTHUB_STANDIN_STATS* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_STANDIN_H */
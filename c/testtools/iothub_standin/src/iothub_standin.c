@@ -0,0 +1,961 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*for rand_r and clock_gettime*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
+
+#include "iothub_standin.h"
+#include "iothub_standin_private.h"
+
+#define POLL_INTERVAL_MS 50
+#define READ_CHUNK_SIZE 16384
+#define LISTEN_BACKLOG 64
+#define MAX_LISTENERS 3
+
+/*bytes waiting for their time: acknowledgements delayed by the latency, and whatever was sent after them*/
+typedef struct DELAYED_SEND_TAG
+{
+    struct DELAYED_SEND_TAG* next;
+    uint64_t dueMs;
+    size_t events;
+    size_t length;
+    unsigned char bytes[1];
+} DELAYED_SEND;
+
+typedef struct LISTENER_TAG
+{
+    int socket;
+    const STANDIN_PROTOCOL* protocol;
+} LISTENER;
+
+typedef struct IOTHUB_STANDIN_TAG
+{
+    IOTHUB_STANDIN_CONFIG config;
+    SSL_CTX* sslContext;
+    char* certificate;
+    LISTENER listeners[MAX_LISTENERS];
+    size_t listenerCount;
+    STANDIN_CONNECTION* connections;
+    THREAD_HANDLE thread;
+    volatile int stop;
+    LOCK_HANDLE lock;
+    IOTHUB_STANDIN_STATS stats;
+    /*the following are touched only by the thread*/
+    unsigned int seed;
+    uint64_t lastC2dId;
+} IOTHUB_STANDIN;
+
+struct STANDIN_CONNECTION_TAG
+{
+    STANDIN_CONNECTION* next;
+    IOTHUB_STANDIN* standin;
+    const STANDIN_PROTOCOL* protocol;
+    void* protocolState;
+    int socket;
+    SSL* ssl;
+    bool handshakeDone;
+    bool closing;
+    bool closed;
+    STANDIN_BUFFER input;
+    STANDIN_BUFFER output;
+    DELAYED_SEND* delayedHead;
+    DELAYED_SEND* delayedTail;
+    uint64_t nextC2dMs;
+};
+
+void standin_buffer_init(STANDIN_BUFFER* buffer)
+{
+    buffer->bytes = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+    buffer->failed = false;
+}
+
+void standin_buffer_deinit(STANDIN_BUFFER* buffer)
+{
+    free(buffer->bytes);
+    standin_buffer_init(buffer);
+}
+
+void standin_buffer_append(STANDIN_BUFFER* buffer, const void* bytes, size_t length)
+{
+    if (!buffer->failed && length > 0)
+    {
+        if (buffer->length + length > buffer->capacity)
+        {
+            size_t capacity = (buffer->capacity == 0) ? 256 : buffer->capacity;
+            unsigned char* newBytes;
+            while (capacity < buffer->length + length)
+            {
+                capacity *= 2;
+            }
+            if ((newBytes = (unsigned char*)realloc(buffer->bytes, capacity)) == NULL)
+            {
+                LogError("unable to grow a buffer to %zu bytes", capacity);
+                buffer->failed = true;
+                return;
+            }
+            buffer->bytes = newBytes;
+            buffer->capacity = capacity;
+        }
+        (void)memcpy(buffer->bytes + buffer->length, bytes, length);
+        buffer->length += length;
+    }
+}
+
+void standin_buffer_append_byte(STANDIN_BUFFER* buffer, unsigned char value)
+{
+    standin_buffer_append(buffer, &value, 1);
+}
+
+void standin_buffer_consume(STANDIN_BUFFER* buffer, size_t length)
+{
+    if (length >= buffer->length)
+    {
+        buffer->length = 0;
+    }
+    else
+    {
+        (void)memmove(buffer->bytes, buffer->bytes + length, buffer->length - length);
+        buffer->length -= length;
+    }
+}
+
+uint64_t standin_now_ms(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+static void count(IOTHUB_STANDIN* standin, uint64_t* counter, uint64_t value)
+{
+    if (Lock(standin->lock) != LOCK_OK)
+    {
+        LogError("unable to lock the stats");
+    }
+    else
+    {
+        *counter += value;
+        (void)Unlock(standin->lock);
+    }
+}
+
+static int append_delayed(STANDIN_CONNECTION* connection, const void* bytes, size_t length, size_t events, uint64_t dueMs)
+{
+    int result;
+    DELAYED_SEND* delayed = (DELAYED_SEND*)malloc(sizeof(DELAYED_SEND) + length);
+    if (delayed == NULL)
+    {
+        LogError("unable to allocate a delayed send");
+        result = __LINE__;
+    }
+    else
+    {
+        delayed->next = NULL;
+        delayed->dueMs = dueMs;
+        delayed->events = events;
+        delayed->length = length;
+        (void)memcpy(delayed->bytes, bytes, length);
+        if (connection->delayedTail == NULL)
+        {
+            connection->delayedHead = delayed;
+        }
+        else
+        {
+            connection->delayedTail->next = delayed;
+        }
+        connection->delayedTail = delayed;
+        result = 0;
+    }
+    return result;
+}
+
+int standin_connection_send(STANDIN_CONNECTION* connection, const void* bytes, size_t length)
+{
+    int result;
+    if (connection->delayedHead != NULL)
+    {
+        /*due at once, but behind the delayed acknowledgements*/
+        result = append_delayed(connection, bytes, length, 0, 0);
+    }
+    else
+    {
+        standin_buffer_append(&connection->output, bytes, length);
+        result = connection->output.failed ? __LINE__ : 0;
+    }
+    return result;
+}
+
+int standin_connection_send_ack(STANDIN_CONNECTION* connection, const void* bytes, size_t length, size_t events)
+{
+    int result;
+    if (connection->standin->config.ackLatencyMs > 0 || connection->delayedHead != NULL)
+    {
+        result = append_delayed(connection, bytes, length, events, standin_now_ms() + connection->standin->config.ackLatencyMs);
+    }
+    else
+    {
+        standin_buffer_append(&connection->output, bytes, length);
+        if (connection->output.failed)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            count(connection->standin, &connection->standin->stats.eventsAcknowledged, events);
+            result = 0;
+        }
+    }
+    return result;
+}
+
+void standin_connection_close(STANDIN_CONNECTION* connection)
+{
+    connection->closing = true;
+}
+
+STANDIN_FAULT standin_connection_receive_events(STANDIN_CONNECTION* connection, size_t events, size_t bytes)
+{
+    IOTHUB_STANDIN* standin = connection->standin;
+    STANDIN_FAULT result;
+    unsigned int roll = (unsigned int)(rand_r(&standin->seed) % 100);
+
+    if (roll < standin->config.dropPercent)
+    {
+        result = STANDIN_FAULT_DROP;
+    }
+    else if (roll < standin->config.dropPercent + standin->config.throttlePercent)
+    {
+        result = STANDIN_FAULT_THROTTLE;
+    }
+    else
+    {
+        result = STANDIN_FAULT_NONE;
+    }
+
+    if (Lock(standin->lock) != LOCK_OK)
+    {
+        LogError("unable to lock the stats");
+    }
+    else
+    {
+        standin->stats.eventsReceived += events;
+        standin->stats.bytesReceived += bytes;
+        if (result == STANDIN_FAULT_DROP)
+        {
+            standin->stats.eventsDropped += events;
+        }
+        else if (result == STANDIN_FAULT_THROTTLE)
+        {
+            standin->stats.eventsThrottled += events;
+        }
+        (void)Unlock(standin->lock);
+    }
+    return result;
+}
+
+bool standin_connection_take_c2d(STANDIN_CONNECTION* connection, uint64_t nowMs, uint64_t* id)
+{
+    bool result;
+    IOTHUB_STANDIN* standin = connection->standin;
+    if (standin->config.c2dIntervalMs == 0)
+    {
+        result = false;
+    }
+    else if (nowMs < connection->nextC2dMs)
+    {
+        result = false;
+    }
+    else
+    {
+        connection->nextC2dMs += standin->config.c2dIntervalMs;
+        if (connection->nextC2dMs <= nowMs)
+        {
+            /*a slow client does not get a burst*/
+            connection->nextC2dMs = nowMs + standin->config.c2dIntervalMs;
+        }
+        *id = ++standin->lastC2dId;
+        count(standin, &standin->stats.c2dSent, 1);
+        result = true;
+    }
+    return result;
+}
+
+size_t standin_connection_get_c2d_size(STANDIN_CONNECTION* connection)
+{
+    return connection->standin->config.c2dSize;
+}
+
+void standin_connection_c2d_settled(STANDIN_CONNECTION* connection)
+{
+    count(connection->standin, &connection->standin->stats.c2dSettled, 1);
+}
+
+static int set_non_blocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) ? __LINE__ : 0;
+}
+
+static int listen_on(IOTHUB_STANDIN* standin, uint16_t port, const STANDIN_PROTOCOL* protocol)
+{
+    int result;
+    int fd;
+    if (port == 0)
+    {
+        result = 0;
+    }
+    else if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    {
+        LogError("unable to create the %s socket, errno %d", protocol->name, errno);
+        result = __LINE__;
+    }
+    else
+    {
+        struct sockaddr_in address;
+        int reuse = 1;
+        (void)memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+        {
+            LogError("unable to bind %s to 127.0.0.1:%u, errno %d", protocol->name, (unsigned int)port, errno);
+            (void)close(fd);
+            result = __LINE__;
+        }
+        else if (listen(fd, LISTEN_BACKLOG) != 0 || set_non_blocking(fd) != 0)
+        {
+            LogError("unable to listen for %s, errno %d", protocol->name, errno);
+            (void)close(fd);
+            result = __LINE__;
+        }
+        else
+        {
+            standin->listeners[standin->listenerCount].socket = fd;
+            standin->listeners[standin->listenerCount].protocol = protocol;
+            standin->listenerCount++;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static char* read_file(const char* path)
+{
+    char* result;
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        LogError("unable to open %s", path);
+        result = NULL;
+    }
+    else
+    {
+        long size;
+        if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0)
+        {
+            LogError("unable to size %s", path);
+            result = NULL;
+        }
+        else if ((result = (char*)malloc((size_t)size + 1)) == NULL)
+        {
+            LogError("unable to allocate %ld bytes", size + 1);
+        }
+        else if (fread(result, 1, (size_t)size, file) != (size_t)size)
+        {
+            LogError("unable to read %s", path);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result[size] = '\0';
+        }
+        (void)fclose(file);
+    }
+    return result;
+}
+
+static int add_extension(X509* certificate, int nid, const char* value)
+{
+    int result;
+    X509V3_CTX context;
+    X509_EXTENSION* extension;
+    X509V3_set_ctx(&context, certificate, certificate, NULL, NULL, 0);
+    if ((extension = X509V3_EXT_conf_nid(NULL, &context, nid, (char*)value)) == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = (X509_add_ext(certificate, extension, -1) == 1) ? 0 : __LINE__;
+        X509_EXTENSION_free(extension);
+    }
+    return result;
+}
+
+/*a self-signed certificate of 127.0.0.1 and localhost, valid for a year*/
+static int use_self_signed_certificate(IOTHUB_STANDIN* standin)
+{
+    int result;
+    EVP_PKEY* key = NULL;
+    EVP_PKEY_CTX* keyContext = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, NULL);
+    X509* certificate = NULL;
+
+    if (keyContext == NULL ||
+        EVP_PKEY_keygen_init(keyContext) <= 0 ||
+        EVP_PKEY_CTX_set_rsa_keygen_bits(keyContext, 2048) <= 0 ||
+        EVP_PKEY_keygen(keyContext, &key) <= 0)
+    {
+        LogError("unable to generate the key");
+        result = __LINE__;
+    }
+    else if ((certificate = X509_new()) == NULL)
+    {
+        LogError("unable to create the certificate");
+        result = __LINE__;
+    }
+    else
+    {
+        X509_NAME* name = X509_get_subject_name(certificate);
+        if (X509_set_version(certificate, 2) != 1 ||
+            ASN1_INTEGER_set(X509_get_serialNumber(certificate), (long)time(NULL)) != 1 ||
+            X509_gmtime_adj(X509_get_notBefore(certificate), -3600) == NULL ||
+            X509_gmtime_adj(X509_get_notAfter(certificate), 365L * 24 * 3600) == NULL ||
+            X509_set_pubkey(certificate, key) != 1 ||
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0) != 1 ||
+            X509_set_issuer_name(certificate, name) != 1 ||
+            add_extension(certificate, NID_basic_constraints, "critical,CA:TRUE") != 0 ||
+            add_extension(certificate, NID_subject_alt_name, "IP:127.0.0.1,DNS:localhost") != 0 ||
+            X509_sign(certificate, key, EVP_sha256()) == 0)
+        {
+            LogError("unable to build the certificate");
+            result = __LINE__;
+        }
+        else if (SSL_CTX_use_certificate(standin->sslContext, certificate) != 1 ||
+            SSL_CTX_use_PrivateKey(standin->sslContext, key) != 1)
+        {
+            LogError("unable to use the certificate");
+            result = __LINE__;
+        }
+        else
+        {
+            BIO* bio = BIO_new(BIO_s_mem());
+            char* pem;
+            long pemLength;
+            if (bio == NULL || PEM_write_bio_X509(bio, certificate) != 1 || (pemLength = BIO_get_mem_data(bio, &pem)) <= 0)
+            {
+                LogError("unable to write the certificate");
+                result = __LINE__;
+            }
+            else if ((standin->certificate = (char*)malloc((size_t)pemLength + 1)) == NULL)
+            {
+                LogError("unable to allocate the certificate");
+                result = __LINE__;
+            }
+            else
+            {
+                (void)memcpy(standin->certificate, pem, (size_t)pemLength);
+                standin->certificate[pemLength] = '\0';
+                result = 0;
+            }
+            BIO_free(bio);
+        }
+    }
+
+    X509_free(certificate);
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(keyContext);
+    return result;
+}
+
+static int create_ssl_context(IOTHUB_STANDIN* standin)
+{
+    int result;
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    (void)SSL_library_init();
+    SSL_load_error_strings();
+    standin->sslContext = SSL_CTX_new(SSLv23_server_method());
+#else
+    standin->sslContext = SSL_CTX_new(TLS_server_method());
+#endif
+    if (standin->sslContext == NULL)
+    {
+        LogError("unable to create the TLS context");
+        result = __LINE__;
+    }
+    else
+    {
+        (void)SSL_CTX_set_mode(standin->sslContext, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+        if (standin->config.certificateFile == NULL || standin->config.privateKeyFile == NULL)
+        {
+            result = use_self_signed_certificate(standin);
+        }
+        else if (SSL_CTX_use_certificate_chain_file(standin->sslContext, standin->config.certificateFile) != 1 ||
+            SSL_CTX_use_PrivateKey_file(standin->sslContext, standin->config.privateKeyFile, SSL_FILETYPE_PEM) != 1)
+        {
+            LogError("unable to load %s and %s", standin->config.certificateFile, standin->config.privateKeyFile);
+            result = __LINE__;
+        }
+        else if ((standin->certificate = read_file(standin->config.certificateFile)) == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static void destroy_connection(STANDIN_CONNECTION* connection)
+{
+    DELAYED_SEND* delayed = connection->delayedHead;
+    while (delayed != NULL)
+    {
+        DELAYED_SEND* next = delayed->next;
+        free(delayed);
+        delayed = next;
+    }
+    if (connection->protocolState != NULL)
+    {
+        connection->protocol->destroy(connection->protocolState);
+    }
+    if (connection->ssl != NULL)
+    {
+        if (connection->handshakeDone)
+        {
+            (void)SSL_shutdown(connection->ssl);
+        }
+        SSL_free(connection->ssl);
+    }
+    (void)close(connection->socket);
+    standin_buffer_deinit(&connection->input);
+    standin_buffer_deinit(&connection->output);
+    free(connection);
+}
+
+static void accept_connections(IOTHUB_STANDIN* standin, const LISTENER* listener)
+{
+    int fd;
+    while ((fd = accept(listener->socket, NULL, NULL)) >= 0)
+    {
+        STANDIN_CONNECTION* connection;
+        int noDelay = 1;
+        (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        if (set_non_blocking(fd) != 0)
+        {
+            LogError("unable to make a %s connection non blocking", listener->protocol->name);
+            (void)close(fd);
+        }
+        else if ((connection = (STANDIN_CONNECTION*)calloc(1, sizeof(STANDIN_CONNECTION))) == NULL)
+        {
+            LogError("unable to allocate a %s connection", listener->protocol->name);
+            (void)close(fd);
+        }
+        else
+        {
+            connection->standin = standin;
+            connection->protocol = listener->protocol;
+            connection->socket = fd;
+            /*the first cloud to device message is due one interval after the connection*/
+            connection->nextC2dMs = standin_now_ms() + standin->config.c2dIntervalMs;
+            standin_buffer_init(&connection->input);
+            standin_buffer_init(&connection->output);
+            if ((connection->ssl = SSL_new(standin->sslContext)) == NULL ||
+                SSL_set_fd(connection->ssl, fd) != 1 ||
+                (connection->protocolState = listener->protocol->create(connection)) == NULL)
+            {
+                LogError("unable to set up a %s connection", listener->protocol->name);
+                destroy_connection(connection);
+            }
+            else
+            {
+                SSL_set_accept_state(connection->ssl);
+                connection->next = standin->connections;
+                standin->connections = connection;
+                count(standin, &standin->stats.connections, 1);
+            }
+        }
+    }
+}
+
+/*false when the TLS session failed and the connection is to be closed*/
+static bool is_ssl_retry(SSL* ssl, int returned)
+{
+    int error = SSL_get_error(ssl, returned);
+    return (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE);
+}
+
+static void read_input(STANDIN_CONNECTION* connection)
+{
+    unsigned char chunk[READ_CHUNK_SIZE];
+    int received;
+    while ((received = SSL_read(connection->ssl, chunk, sizeof(chunk))) > 0)
+    {
+        standin_buffer_append(&connection->input, chunk, (size_t)received);
+    }
+    if (!is_ssl_retry(connection->ssl, received) || connection->input.failed)
+    {
+        /*the peer closed or the session failed: nothing more can be sent either*/
+        connection->closed = true;
+    }
+    else
+    {
+        while (!connection->closing && connection->input.length > 0)
+        {
+            size_t consumed = 0;
+            if (connection->protocol->on_bytes(connection->protocolState, connection->input.bytes, connection->input.length, &consumed) != 0)
+            {
+                connection->closing = true;
+            }
+            else if (consumed == 0)
+            {
+                break;
+            }
+            else
+            {
+                standin_buffer_consume(&connection->input, consumed);
+            }
+        }
+    }
+}
+
+static void release_delayed(STANDIN_CONNECTION* connection, uint64_t nowMs)
+{
+    size_t events = 0;
+    while (connection->delayedHead != NULL && connection->delayedHead->dueMs <= nowMs)
+    {
+        DELAYED_SEND* delayed = connection->delayedHead;
+        standin_buffer_append(&connection->output, delayed->bytes, delayed->length);
+        events += delayed->events;
+        connection->delayedHead = delayed->next;
+        if (connection->delayedHead == NULL)
+        {
+            connection->delayedTail = NULL;
+        }
+        free(delayed);
+    }
+    if (events > 0)
+    {
+        count(connection->standin, &connection->standin->stats.eventsAcknowledged, events);
+    }
+}
+
+static void write_output(STANDIN_CONNECTION* connection)
+{
+    while (connection->output.length > 0)
+    {
+        int length = (connection->output.length > INT_MAX) ? INT_MAX : (int)connection->output.length;
+        int written = SSL_write(connection->ssl, connection->output.bytes, length);
+        if (written > 0)
+        {
+            standin_buffer_consume(&connection->output, (size_t)written);
+        }
+        else
+        {
+            if (!is_ssl_retry(connection->ssl, written))
+            {
+                connection->closed = true;
+            }
+            break;
+        }
+    }
+}
+
+static void serve_connection(STANDIN_CONNECTION* connection, uint64_t nowMs)
+{
+    if (!connection->handshakeDone)
+    {
+        int accepted = SSL_accept(connection->ssl);
+        if (accepted == 1)
+        {
+            connection->handshakeDone = true;
+        }
+        else if (!is_ssl_retry(connection->ssl, accepted))
+        {
+            /*a client that does not trust the certificate ends here*/
+            LogError("TLS handshake of a %s connection failed", connection->protocol->name);
+            ERR_clear_error();
+            connection->closed = true;
+        }
+    }
+
+    if (connection->handshakeDone && !connection->closed)
+    {
+        read_input(connection);
+        if (!connection->closed)
+        {
+            if (!connection->closing)
+            {
+                connection->protocol->on_tick(connection->protocolState, nowMs);
+            }
+            release_delayed(connection, nowMs);
+            if (connection->output.failed)
+            {
+                connection->closed = true;
+            }
+            else
+            {
+                write_output(connection);
+                if (connection->closing && connection->output.length == 0 && connection->delayedHead == NULL)
+                {
+                    connection->closed = true;
+                }
+            }
+        }
+    }
+}
+
+static bool wants_write(const STANDIN_CONNECTION* connection)
+{
+    return connection->output.length > 0 || (!connection->handshakeDone && SSL_want_write(connection->ssl));
+}
+
+static int standin_thread(void* arg)
+{
+    IOTHUB_STANDIN* standin = (IOTHUB_STANDIN*)arg;
+    struct pollfd* fds = NULL;
+    size_t fdCapacity = 0;
+
+    while (!standin->stop)
+    {
+        size_t fdCount = standin->listenerCount;
+        size_t i;
+        int timeoutMs = POLL_INTERVAL_MS;
+        uint64_t nowMs = standin_now_ms();
+        STANDIN_CONNECTION** link;
+        STANDIN_CONNECTION* connection;
+
+        for (connection = standin->connections; connection != NULL; connection = connection->next)
+        {
+            fdCount++;
+            if (connection->delayedHead != NULL)
+            {
+                uint64_t waitMs = (connection->delayedHead->dueMs > nowMs) ? connection->delayedHead->dueMs - nowMs : 0;
+                if (waitMs < (uint64_t)timeoutMs)
+                {
+                    timeoutMs = (int)waitMs;
+                }
+            }
+        }
+
+        if (fdCount > fdCapacity)
+        {
+            struct pollfd* newFds = (struct pollfd*)realloc(fds, fdCount * sizeof(struct pollfd));
+            if (newFds == NULL)
+            {
+                LogError("unable to allocate %zu poll descriptors", fdCount);
+                ThreadAPI_Sleep(POLL_INTERVAL_MS);
+                continue;
+            }
+            fds = newFds;
+            fdCapacity = fdCount;
+        }
+
+        for (i = 0; i < standin->listenerCount; i++)
+        {
+            fds[i].fd = standin->listeners[i].socket;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        for (connection = standin->connections; connection != NULL; connection = connection->next, i++)
+        {
+            fds[i].fd = connection->socket;
+            fds[i].events = (short)(POLLIN | (wants_write(connection) ? POLLOUT : 0));
+            fds[i].revents = 0;
+        }
+
+        if (poll(fds, (nfds_t)fdCount, timeoutMs) < 0 && errno != EINTR)
+        {
+            LogError("poll failed, errno %d", errno);
+            ThreadAPI_Sleep(POLL_INTERVAL_MS);
+            continue;
+        }
+
+        for (i = 0; i < standin->listenerCount; i++)
+        {
+            if ((fds[i].revents & POLLIN) != 0)
+            {
+                accept_connections(standin, &standin->listeners[i]);
+            }
+        }
+
+        /*every connection is served on every turn: TLS may hold decrypted bytes that poll does not see*/
+        nowMs = standin_now_ms();
+        link = &standin->connections;
+        while ((connection = *link) != NULL)
+        {
+            serve_connection(connection, nowMs);
+            if (connection->closed)
+            {
+                *link = connection->next;
+                destroy_connection(connection);
+            }
+            else
+            {
+                link = &connection->next;
+            }
+        }
+    }
+
+    while (standin->connections != NULL)
+    {
+        STANDIN_CONNECTION* next = standin->connections->next;
+        destroy_connection(standin->connections);
+        standin->connections = next;
+    }
+    free(fds);
+    return 0;
+}
+
+static void destroy_standin(IOTHUB_STANDIN* standin)
+{
+    size_t i;
+    for (i = 0; i < standin->listenerCount; i++)
+    {
+        (void)close(standin->listeners[i].socket);
+    }
+    if (standin->lock != NULL)
+    {
+        (void)Lock_Deinit(standin->lock);
+    }
+    if (standin->sslContext != NULL)
+    {
+        SSL_CTX_free(standin->sslContext);
+    }
+    free(standin->certificate);
+    free(standin);
+}
+
+void iothub_standin_config_init(IOTHUB_STANDIN_CONFIG* config)
+{
+    if (config != NULL)
+    {
+        (void)memset(config, 0, sizeof(IOTHUB_STANDIN_CONFIG));
+        config->httpPort = 443;
+        config->mqttPort = 8883;
+        config->amqpPort = 5671;
+        config->c2dSize = 64;
+        config->seed = 1;
+    }
+}
+
+IOTHUB_STANDIN_HANDLE iothub_standin_start(const IOTHUB_STANDIN_CONFIG* config)
+{
+    IOTHUB_STANDIN* result;
+    if (config == NULL || config->dropPercent + config->throttlePercent > 100)
+    {
+        LogError("invalid arg (config=%p)", config);
+        result = NULL;
+    }
+    else if ((result = (IOTHUB_STANDIN*)calloc(1, sizeof(IOTHUB_STANDIN))) == NULL)
+    {
+        LogError("unable to allocate the stand-in");
+    }
+    else
+    {
+        result->config = *config;
+        result->seed = config->seed;
+
+        /*a peer that goes away while a response is written must not kill the process*/
+        (void)signal(SIGPIPE, SIG_IGN);
+
+        if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("unable to create the lock");
+            destroy_standin(result);
+            result = NULL;
+        }
+        else if (create_ssl_context(result) != 0 ||
+            listen_on(result, config->httpPort, &standin_http_protocol) != 0 ||
+            listen_on(result, config->mqttPort, &standin_mqtt_protocol) != 0 ||
+            listen_on(result, config->amqpPort, &standin_amqp_protocol) != 0)
+        {
+            destroy_standin(result);
+            result = NULL;
+        }
+        else if (ThreadAPI_Create(&result->thread, standin_thread, result) != THREADAPI_OK)
+        {
+            LogError("unable to start the thread");
+            destroy_standin(result);
+            result = NULL;
+        }
+    }
+    return result;
+}
+
+void iothub_standin_stop(IOTHUB_STANDIN_HANDLE standin)
+{
+    if (standin != NULL)
+    {
+        int threadResult;
+        standin->stop = 1;
+        if (ThreadAPI_Join(standin->thread, &threadResult) != THREADAPI_OK)
+        {
+            LogError("unable to join the thread");
+        }
+        destroy_standin(standin);
+    }
+}
+
+const char* iothub_standin_get_certificate(IOTHUB_STANDIN_HANDLE standin)
+{
+    return (standin == NULL) ? NULL : standin->certificate;
+}
+
+int iothub_standin_get_stats(IOTHUB_STANDIN_HANDLE standin, IOTHUB_STANDIN_STATS* stats)
+{
+    int result;
+    if (standin == NULL || stats == NULL)
+    {
+        LogError("invalid arg (standin=%p, stats=%p)", standin, stats);
+        result = __LINE__;
+    }
+    else if (Lock(standin->lock) != LOCK_OK)
+    {
+        LogError("unable to lock the stats");
+        result = __LINE__;
+    }
+    else
+    {
+        *stats = standin->stats;
+        (void)Unlock(standin->lock);
+        result = 0;
+    }
+    return result;
+}
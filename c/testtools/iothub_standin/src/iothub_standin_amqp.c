@@ -0,0 +1,1349 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "iothub_standin_private.h"
+
+/*
+ * The part of AMQP 1.0 that the AMQP transport of the SDK uses, written by hand because uAMQP has no
+ * server side SASL:
+ *  - SASL with any mechanism (the mechanism of the SDK is MSSBCBS) always succeeds, a client that skips
+ *    SASL is served as well
+ *  - a put-token on the $cbs node always gets status-code 200
+ *  - a link that the client attaches to send is an event link: every message is an event, accepted after
+ *    the latency, never settled when it is dropped and rejected with amqp:resource-limit-exceeded when it
+ *    is throttled
+ *  - a link that the client attaches to receive, other than $cbs, gets the cloud to device messages while
+ *    it has credit; their dispositions settle them
+ * One connection has at most MAX_SESSIONS sessions of at most MAX_LINKS links.
+ */
+
+#define MAX_SESSIONS 4
+#define MAX_LINKS 8
+#define MAX_FIELDS 12
+#define LINK_CREDIT 1000
+#define WINDOW 0x7FFFFFFF
+#define OUR_MAX_FRAME_SIZE 65536
+#define FRAME_OVERHEAD 64
+#define CBS_ADDRESS "$cbs"
+
+#define FRAME_TYPE_AMQP 0
+#define FRAME_TYPE_SASL 1
+
+/*descriptor codes*/
+#define AMQP_OPEN               0x10
+#define AMQP_BEGIN              0x11
+#define AMQP_ATTACH             0x12
+#define AMQP_FLOW               0x13
+#define AMQP_TRANSFER           0x14
+#define AMQP_DISPOSITION        0x15
+#define AMQP_DETACH             0x16
+#define AMQP_END                0x17
+#define AMQP_CLOSE              0x18
+#define AMQP_ERROR              0x1D
+#define AMQP_ACCEPTED           0x24
+#define AMQP_REJECTED           0x25
+#define AMQP_SOURCE             0x28
+#define AMQP_TARGET             0x29
+#define SASL_MECHANISMS         0x40
+#define SASL_INIT               0x41
+#define SASL_OUTCOME            0x44
+#define SECTION_PROPERTIES      0x73
+#define SECTION_APPLICATION_PROPERTIES 0x74
+#define SECTION_DATA            0x75
+
+typedef enum AMQP_PHASE_TAG
+{
+    AMQP_PHASE_HEADER,
+    AMQP_PHASE_SASL,
+    AMQP_PHASE_FRAMES
+} AMQP_PHASE;
+
+typedef enum LINK_KIND_TAG
+{
+    LINK_KIND_EVENTS,
+    LINK_KIND_CBS_REQUESTS,
+    LINK_KIND_CBS_REPLIES,
+    LINK_KIND_C2D
+} LINK_KIND;
+
+/*an encoded value as it is in the frame, length 0 when the field is absent*/
+typedef struct AMQP_FIELD_TAG
+{
+    const unsigned char* bytes;
+    size_t length;
+} AMQP_FIELD;
+
+typedef struct AMQP_LINK_TAG
+{
+    bool used;
+    uint32_t handle;
+    LINK_KIND kind;
+    uint32_t deliveryCount;
+    uint32_t credit; /*that the stand-in has to send, or that it granted to the client*/
+    bool transferActive;
+    uint32_t transferDeliveryId;
+    bool transferSettled;
+    STANDIN_BUFFER transfer;
+} AMQP_LINK;
+
+typedef struct AMQP_SESSION_TAG
+{
+    bool used;
+    uint16_t channel;
+    uint32_t nextIncomingId;
+    uint32_t nextOutgoingId;
+    uint32_t nextDeliveryId;
+    STANDIN_BUFFER pendingCbsReplies; /*messages waiting for credit, each one prefixed with its 4 bytes length*/
+    AMQP_LINK links[MAX_LINKS];
+} AMQP_SESSION;
+
+typedef struct AMQP_STATE_TAG
+{
+    STANDIN_CONNECTION* connection;
+    AMQP_PHASE phase;
+    uint32_t remoteMaxFrameSize;
+    uint32_t remoteIdleTimeoutMs;
+    uint64_t lastSendMs;
+    AMQP_SESSION sessions[MAX_SESSIONS];
+} AMQP_STATE;
+
+static uint32_t read_uint32(const unsigned char* bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+/*the size of the encoded value at bytes, 0 if it is malformed or longer than length*/
+static size_t value_size(const unsigned char* bytes, size_t length)
+{
+    size_t result;
+    if (length == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        unsigned char code = bytes[0];
+        if (code == 0x00)
+        {
+            size_t descriptorSize = value_size(bytes + 1, length - 1);
+            size_t describedSize = (descriptorSize == 0) ? 0 : value_size(bytes + 1 + descriptorSize, length - 1 - descriptorSize);
+            result = (describedSize == 0) ? 0 : 1 + descriptorSize + describedSize;
+        }
+        else if (code >= 0x40 && code <= 0x45)
+        {
+            result = 1;
+        }
+        else if (code >= 0x50 && code <= 0x56)
+        {
+            result = 2;
+        }
+        else if (code == 0x60 || code == 0x61)
+        {
+            result = 3;
+        }
+        else if (code >= 0x70 && code <= 0x74)
+        {
+            result = 5;
+        }
+        else if (code >= 0x80 && code <= 0x84)
+        {
+            result = 9;
+        }
+        else if (code == 0x94 || code == 0x98)
+        {
+            result = 17;
+        }
+        else if (code == 0xA0 || code == 0xA1 || code == 0xA3 || code == 0xC0 || code == 0xC1 || code == 0xE0)
+        {
+            result = (length < 2) ? 0 : 2 + (size_t)bytes[1];
+        }
+        else if (code == 0xB0 || code == 0xB1 || code == 0xB3 || code == 0xD0 || code == 0xD1 || code == 0xF0)
+        {
+            result = (length < 5) ? 0 : 5 + (size_t)read_uint32(bytes + 1);
+        }
+        else
+        {
+            result = 0;
+        }
+
+        if (result > length)
+        {
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/*splits the list at bytes in its first maxFields fields, the others are ignored*/
+static int decode_list(const unsigned char* bytes, size_t length, AMQP_FIELD* fields, size_t maxFields)
+{
+    int result;
+    size_t size = value_size(bytes, length);
+    size_t position;
+    uint32_t count;
+    uint32_t i;
+
+    (void)memset(fields, 0, maxFields * sizeof(AMQP_FIELD));
+    if (size == 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        switch (bytes[0])
+        {
+        case 0x45:
+            count = 0;
+            position = 1;
+            result = 0;
+            break;
+        case 0xC0:
+            count = (size < 3) ? 0 : bytes[2];
+            position = 3;
+            result = (size < 3) ? __LINE__ : 0;
+            break;
+        case 0xD0:
+            count = (size < 9) ? 0 : read_uint32(bytes + 5);
+            position = 9;
+            result = (size < 9) ? __LINE__ : 0;
+            break;
+        default:
+            count = 0;
+            position = 0;
+            result = __LINE__;
+            break;
+        }
+
+        for (i = 0; i < count && result == 0; i++)
+        {
+            size_t fieldSize = value_size(bytes + position, size - position);
+            if (fieldSize == 0)
+            {
+                result = __LINE__;
+            }
+            else
+            {
+                if (i < maxFields)
+                {
+                    fields[i].bytes = bytes + position;
+                    fields[i].length = fieldSize;
+                }
+                position += fieldSize;
+            }
+        }
+    }
+    return result;
+}
+
+/*decodes a described list, the descriptor being a small ulong (codes are all below 256)*/
+static int decode_described_list(const unsigned char* bytes, size_t length, uint32_t* descriptor, AMQP_FIELD* fields, size_t maxFields, size_t* size)
+{
+    int result;
+    if (length < 3 || bytes[0] != 0x00)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        size_t descriptorSize;
+        if (bytes[1] == 0x53)
+        {
+            *descriptor = bytes[2];
+            descriptorSize = 2;
+        }
+        else if (bytes[1] == 0x80 && length >= 10)
+        {
+            *descriptor = read_uint32(bytes + 6);
+            descriptorSize = 9;
+        }
+        else
+        {
+            descriptorSize = 0;
+        }
+
+        if (descriptorSize == 0 || decode_list(bytes + 1 + descriptorSize, length - 1 - descriptorSize, fields, maxFields) != 0)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            *size = 1 + descriptorSize + value_size(bytes + 1 + descriptorSize, length - 1 - descriptorSize);
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static bool field_is_null(const AMQP_FIELD* field)
+{
+    return field->length == 0 || field->bytes[0] == 0x40;
+}
+
+static uint32_t field_uint(const AMQP_FIELD* field, uint32_t defaultValue)
+{
+    uint32_t result;
+    if (field->length == 0)
+    {
+        result = defaultValue;
+    }
+    else
+    {
+        switch (field->bytes[0])
+        {
+        case 0x43:
+            result = 0;
+            break;
+        case 0x50:
+        case 0x52:
+            result = field->bytes[1];
+            break;
+        case 0x60:
+            result = ((uint32_t)field->bytes[1] << 8) | field->bytes[2];
+            break;
+        case 0x70:
+            result = read_uint32(field->bytes + 1);
+            break;
+        default:
+            result = defaultValue;
+            break;
+        }
+    }
+    return result;
+}
+
+static bool field_bool(const AMQP_FIELD* field, bool defaultValue)
+{
+    bool result;
+    if (field->length == 0)
+    {
+        result = defaultValue;
+    }
+    else if (field->bytes[0] == 0x41)
+    {
+        result = true;
+    }
+    else if (field->bytes[0] == 0x42)
+    {
+        result = false;
+    }
+    else if (field->bytes[0] == 0x56)
+    {
+        result = (field->bytes[1] != 0);
+    }
+    else
+    {
+        result = defaultValue;
+    }
+    return result;
+}
+
+/*true when the field is a string or a symbol equal to text*/
+static bool field_equals(const AMQP_FIELD* field, const char* text)
+{
+    size_t textLength = strlen(text);
+    bool result;
+    if (field->length >= 2 && (field->bytes[0] == 0xA1 || field->bytes[0] == 0xA3))
+    {
+        result = (field->length - 2 == textLength) && memcmp(field->bytes + 2, text, textLength) == 0;
+    }
+    else if (field->length >= 5 && (field->bytes[0] == 0xB1 || field->bytes[0] == 0xB3))
+    {
+        result = (field->length - 5 == textLength) && memcmp(field->bytes + 5, text, textLength) == 0;
+    }
+    else
+    {
+        result = false;
+    }
+    return result;
+}
+
+/*the address of a source or a target, the first field of its list*/
+static bool terminus_address_equals(const AMQP_FIELD* terminus, const char* address)
+{
+    AMQP_FIELD fields[1];
+    uint32_t descriptor;
+    size_t size;
+    return !field_is_null(terminus) &&
+        decode_described_list(terminus->bytes, terminus->length, &descriptor, fields, 1, &size) == 0 &&
+        field_equals(&fields[0], address);
+}
+
+static void put_uint32(STANDIN_BUFFER* buffer, uint32_t value)
+{
+    unsigned char bytes[4];
+    bytes[0] = (unsigned char)(value >> 24);
+    bytes[1] = (unsigned char)(value >> 16);
+    bytes[2] = (unsigned char)(value >> 8);
+    bytes[3] = (unsigned char)value;
+    standin_buffer_append(buffer, bytes, sizeof(bytes));
+}
+
+static void encode_null(STANDIN_BUFFER* buffer)
+{
+    standin_buffer_append_byte(buffer, 0x40);
+}
+
+static void encode_bool(STANDIN_BUFFER* buffer, bool value)
+{
+    standin_buffer_append_byte(buffer, value ? 0x41 : 0x42);
+}
+
+static void encode_ubyte(STANDIN_BUFFER* buffer, unsigned char value)
+{
+    standin_buffer_append_byte(buffer, 0x50);
+    standin_buffer_append_byte(buffer, value);
+}
+
+static void encode_ushort(STANDIN_BUFFER* buffer, uint16_t value)
+{
+    standin_buffer_append_byte(buffer, 0x60);
+    standin_buffer_append_byte(buffer, (unsigned char)(value >> 8));
+    standin_buffer_append_byte(buffer, (unsigned char)value);
+}
+
+static void encode_uint(STANDIN_BUFFER* buffer, uint32_t value)
+{
+    standin_buffer_append_byte(buffer, 0x70);
+    put_uint32(buffer, value);
+}
+
+static void encode_int(STANDIN_BUFFER* buffer, int32_t value)
+{
+    standin_buffer_append_byte(buffer, 0x71);
+    put_uint32(buffer, (uint32_t)value);
+}
+
+static void encode_text(STANDIN_BUFFER* buffer, unsigned char code32, const void* bytes, size_t length)
+{
+    standin_buffer_append_byte(buffer, code32);
+    put_uint32(buffer, (uint32_t)length);
+    standin_buffer_append(buffer, bytes, length);
+}
+
+static void encode_string(STANDIN_BUFFER* buffer, const char* value)
+{
+    encode_text(buffer, 0xB1, value, strlen(value));
+}
+
+static void encode_symbol(STANDIN_BUFFER* buffer, const char* value)
+{
+    encode_text(buffer, 0xB3, value, strlen(value));
+}
+
+static void encode_binary(STANDIN_BUFFER* buffer, const void* bytes, size_t length)
+{
+    encode_text(buffer, 0xB0, bytes, length);
+}
+
+static void encode_field(STANDIN_BUFFER* buffer, const AMQP_FIELD* field)
+{
+    if (field->length == 0)
+    {
+        encode_null(buffer);
+    }
+    else
+    {
+        standin_buffer_append(buffer, field->bytes, field->length);
+    }
+}
+
+static void encode_descriptor(STANDIN_BUFFER* buffer, unsigned char code)
+{
+    standin_buffer_append_byte(buffer, 0x00);
+    standin_buffer_append_byte(buffer, 0x53);
+    standin_buffer_append_byte(buffer, code);
+}
+
+/*list32 or map32 whose size and count are written by end_compound*/
+static size_t begin_compound(STANDIN_BUFFER* buffer, unsigned char code32)
+{
+    size_t result = buffer->length;
+    standin_buffer_append_byte(buffer, code32);
+    put_uint32(buffer, 0);
+    put_uint32(buffer, 0);
+    return result;
+}
+
+static void end_compound(STANDIN_BUFFER* buffer, size_t start, uint32_t count)
+{
+    if (!buffer->failed)
+    {
+        size_t size = buffer->length - start - 5;
+        buffer->bytes[start + 1] = (unsigned char)(size >> 24);
+        buffer->bytes[start + 2] = (unsigned char)(size >> 16);
+        buffer->bytes[start + 3] = (unsigned char)(size >> 8);
+        buffer->bytes[start + 4] = (unsigned char)size;
+        buffer->bytes[start + 5] = (unsigned char)(count >> 24);
+        buffer->bytes[start + 6] = (unsigned char)(count >> 16);
+        buffer->bytes[start + 7] = (unsigned char)(count >> 8);
+        buffer->bytes[start + 8] = (unsigned char)count;
+    }
+}
+
+static size_t begin_frame(STANDIN_BUFFER* buffer, unsigned char type, uint16_t channel)
+{
+    size_t result = buffer->length;
+    put_uint32(buffer, 0);
+    standin_buffer_append_byte(buffer, 2);
+    standin_buffer_append_byte(buffer, type);
+    standin_buffer_append_byte(buffer, (unsigned char)(channel >> 8));
+    standin_buffer_append_byte(buffer, (unsigned char)channel);
+    return result;
+}
+
+static void end_frame(STANDIN_BUFFER* buffer, size_t start)
+{
+    if (!buffer->failed)
+    {
+        size_t size = buffer->length - start;
+        buffer->bytes[start] = (unsigned char)(size >> 24);
+        buffer->bytes[start + 1] = (unsigned char)(size >> 16);
+        buffer->bytes[start + 2] = (unsigned char)(size >> 8);
+        buffer->bytes[start + 3] = (unsigned char)size;
+    }
+}
+
+static int send_buffer(AMQP_STATE* amqp, STANDIN_BUFFER* buffer)
+{
+    int result = buffer->failed ? __LINE__ : standin_connection_send(amqp->connection, buffer->bytes, buffer->length);
+    amqp->lastSendMs = standin_now_ms();
+    standin_buffer_deinit(buffer);
+    return result;
+}
+
+/*a frame whose performative is a list of empty fields (end, close, sasl-outcome is not one of them)*/
+static int send_empty_performative(AMQP_STATE* amqp, uint16_t channel, unsigned char code)
+{
+    STANDIN_BUFFER frame;
+    size_t frameStart;
+    standin_buffer_init(&frame);
+    frameStart = begin_frame(&frame, FRAME_TYPE_AMQP, channel);
+    encode_descriptor(&frame, code);
+    standin_buffer_append_byte(&frame, 0x45);
+    end_frame(&frame, frameStart);
+    return send_buffer(amqp, &frame);
+}
+
+static int send_flow(AMQP_STATE* amqp, AMQP_SESSION* session, AMQP_LINK* link)
+{
+    STANDIN_BUFFER frame;
+    size_t frameStart;
+    size_t listStart;
+    standin_buffer_init(&frame);
+    frameStart = begin_frame(&frame, FRAME_TYPE_AMQP, session->channel);
+    encode_descriptor(&frame, AMQP_FLOW);
+    listStart = begin_compound(&frame, 0xD0);
+    encode_uint(&frame, session->nextIncomingId);
+    encode_uint(&frame, WINDOW);
+    encode_uint(&frame, session->nextOutgoingId);
+    encode_uint(&frame, WINDOW);
+    encode_uint(&frame, link->handle);
+    encode_uint(&frame, link->deliveryCount);
+    encode_uint(&frame, link->credit);
+    end_compound(&frame, listStart, 7);
+    end_frame(&frame, frameStart);
+    return send_buffer(amqp, &frame);
+}
+
+static void encode_disposition(STANDIN_BUFFER* frame, uint16_t channel, uint32_t deliveryId, bool accepted)
+{
+    size_t frameStart = begin_frame(frame, FRAME_TYPE_AMQP, channel);
+    size_t listStart;
+    encode_descriptor(frame, AMQP_DISPOSITION);
+    listStart = begin_compound(frame, 0xD0);
+    encode_bool(frame, true);
+    encode_uint(frame, deliveryId);
+    encode_uint(frame, deliveryId);
+    encode_bool(frame, true);
+    if (accepted)
+    {
+        encode_descriptor(frame, AMQP_ACCEPTED);
+        standin_buffer_append_byte(frame, 0x45);
+    }
+    else
+    {
+        size_t rejectedStart;
+        size_t errorStart;
+        encode_descriptor(frame, AMQP_REJECTED);
+        rejectedStart = begin_compound(frame, 0xD0);
+        encode_descriptor(frame, AMQP_ERROR);
+        errorStart = begin_compound(frame, 0xD0);
+        encode_symbol(frame, "amqp:resource-limit-exceeded");
+        encode_string(frame, "throttled by the stand-in");
+        end_compound(frame, errorStart, 2);
+        end_compound(frame, rejectedStart, 1);
+    }
+    end_compound(frame, listStart, 5);
+    end_frame(frame, frameStart);
+}
+
+/*sends the message, split in as many transfer frames as the maximum frame size of the client requires*/
+static int send_transfer(AMQP_STATE* amqp, AMQP_SESSION* session, AMQP_LINK* link, const unsigned char* message, size_t length, bool settled)
+{
+    int result = 0;
+    size_t maxChunk = amqp->remoteMaxFrameSize - FRAME_OVERHEAD;
+    size_t position = 0;
+    uint32_t deliveryId = session->nextDeliveryId++;
+
+    do
+    {
+        STANDIN_BUFFER frame;
+        size_t chunk = (length - position > maxChunk) ? maxChunk : length - position;
+        bool first = (position == 0);
+        size_t frameStart;
+        size_t listStart;
+
+        standin_buffer_init(&frame);
+        frameStart = begin_frame(&frame, FRAME_TYPE_AMQP, session->channel);
+        encode_descriptor(&frame, AMQP_TRANSFER);
+        listStart = begin_compound(&frame, 0xD0);
+        encode_uint(&frame, link->handle);
+        if (first)
+        {
+            unsigned char tag[4];
+            tag[0] = (unsigned char)(deliveryId >> 24);
+            tag[1] = (unsigned char)(deliveryId >> 16);
+            tag[2] = (unsigned char)(deliveryId >> 8);
+            tag[3] = (unsigned char)deliveryId;
+            encode_uint(&frame, deliveryId);
+            encode_binary(&frame, tag, sizeof(tag));
+            encode_uint(&frame, 0);
+        }
+        else
+        {
+            encode_null(&frame);
+            encode_null(&frame);
+            encode_null(&frame);
+        }
+        encode_bool(&frame, settled);
+        encode_bool(&frame, position + chunk < length);
+        end_compound(&frame, listStart, 6);
+        standin_buffer_append(&frame, message + position, chunk);
+        end_frame(&frame, frameStart);
+
+        session->nextOutgoingId++;
+        position += chunk;
+        result = send_buffer(amqp, &frame);
+    } while (position < length && result == 0);
+
+    link->deliveryCount++;
+    link->credit--;
+    return result;
+}
+
+static AMQP_SESSION* find_session(AMQP_STATE* amqp, uint16_t channel)
+{
+    size_t i;
+    for (i = 0; i < MAX_SESSIONS; i++)
+    {
+        if (amqp->sessions[i].used && amqp->sessions[i].channel == channel)
+        {
+            return &amqp->sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static AMQP_LINK* find_link(AMQP_SESSION* session, uint32_t handle)
+{
+    size_t i;
+    for (i = 0; i < MAX_LINKS; i++)
+    {
+        if (session->links[i].used && session->links[i].handle == handle)
+        {
+            return &session->links[i];
+        }
+    }
+    return NULL;
+}
+
+static void free_link(AMQP_LINK* link)
+{
+    standin_buffer_deinit(&link->transfer);
+    (void)memset(link, 0, sizeof(AMQP_LINK));
+}
+
+static void free_session(AMQP_SESSION* session)
+{
+    size_t i;
+    for (i = 0; i < MAX_LINKS; i++)
+    {
+        free_link(&session->links[i]);
+    }
+    standin_buffer_deinit(&session->pendingCbsReplies);
+    (void)memset(session, 0, sizeof(AMQP_SESSION));
+}
+
+static void send_pending_cbs_replies(AMQP_STATE* amqp, AMQP_SESSION* session)
+{
+    size_t i;
+    for (i = 0; i < MAX_LINKS && session->pendingCbsReplies.length > 0; i++)
+    {
+        AMQP_LINK* link = &session->links[i];
+        if (link->used && link->kind == LINK_KIND_CBS_REPLIES)
+        {
+            while (link->credit > 0 && session->pendingCbsReplies.length >= 4)
+            {
+                size_t length = read_uint32(session->pendingCbsReplies.bytes);
+                /*replies are sent settled, the client does not answer them*/
+                if (send_transfer(amqp, session, link, session->pendingCbsReplies.bytes + 4, length, true) != 0)
+                {
+                    LogError("unable to send a put-token reply");
+                }
+                standin_buffer_consume(&session->pendingCbsReplies, 4 + length);
+            }
+        }
+    }
+}
+
+/*replies status-code 200 to a put-token, correlated by its message-id*/
+static int on_cbs_request(AMQP_STATE* amqp, AMQP_SESSION* session, const unsigned char* message, size_t length)
+{
+    int result;
+    AMQP_FIELD messageId = { NULL, 0 };
+    size_t position = 0;
+    STANDIN_BUFFER reply;
+    size_t listStart;
+
+    while (position < length)
+    {
+        AMQP_FIELD fields[1];
+        uint32_t descriptor;
+        size_t size;
+        if (decode_described_list(message + position, length - position, &descriptor, fields, 1, &size) == 0)
+        {
+            if (descriptor == SECTION_PROPERTIES)
+            {
+                messageId = fields[0];
+            }
+        }
+        else if ((size = value_size(message + position, length - position)) == 0)
+        {
+            break;
+        }
+        position += size;
+    }
+
+    standin_buffer_init(&reply);
+    put_uint32(&reply, 0);
+    encode_descriptor(&reply, SECTION_PROPERTIES);
+    listStart = begin_compound(&reply, 0xD0);
+    encode_null(&reply);
+    encode_null(&reply);
+    encode_null(&reply);
+    encode_null(&reply);
+    encode_null(&reply);
+    encode_field(&reply, &messageId);
+    end_compound(&reply, listStart, 6);
+    encode_descriptor(&reply, SECTION_APPLICATION_PROPERTIES);
+    listStart = begin_compound(&reply, 0xD1);
+    encode_string(&reply, "status-code");
+    encode_int(&reply, 200);
+    encode_string(&reply, "status-description");
+    encode_string(&reply, "OK");
+    end_compound(&reply, listStart, 4);
+
+    if (reply.failed)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        size_t replyLength = reply.length - 4;
+        reply.bytes[0] = (unsigned char)(replyLength >> 24);
+        reply.bytes[1] = (unsigned char)(replyLength >> 16);
+        reply.bytes[2] = (unsigned char)(replyLength >> 8);
+        reply.bytes[3] = (unsigned char)replyLength;
+        standin_buffer_append(&session->pendingCbsReplies, reply.bytes, reply.length);
+        result = session->pendingCbsReplies.failed ? __LINE__ : 0;
+        send_pending_cbs_replies(amqp, session);
+    }
+    standin_buffer_deinit(&reply);
+    return result;
+}
+
+static int on_message(AMQP_STATE* amqp, AMQP_SESSION* session, AMQP_LINK* link)
+{
+    int result;
+    STANDIN_BUFFER disposition;
+    standin_buffer_init(&disposition);
+
+    if (link->kind == LINK_KIND_CBS_REQUESTS)
+    {
+        result = on_cbs_request(amqp, session, link->transfer.bytes, link->transfer.length);
+        if (result == 0 && !link->transferSettled)
+        {
+            encode_disposition(&disposition, session->channel, link->transferDeliveryId, true);
+            result = send_buffer(amqp, &disposition);
+        }
+    }
+    else
+    {
+        switch (standin_connection_receive_events(amqp->connection, 1, link->transfer.length))
+        {
+        case STANDIN_FAULT_DROP:
+            result = 0;
+            break;
+        case STANDIN_FAULT_THROTTLE:
+            if (link->transferSettled)
+            {
+                result = 0;
+            }
+            else
+            {
+                encode_disposition(&disposition, session->channel, link->transferDeliveryId, false);
+                result = send_buffer(amqp, &disposition);
+            }
+            break;
+        default:
+            if (!link->transferSettled)
+            {
+                encode_disposition(&disposition, session->channel, link->transferDeliveryId, true);
+            }
+            result = disposition.failed ? __LINE__ : standin_connection_send_ack(amqp->connection, disposition.bytes, disposition.length, 1);
+            break;
+        }
+    }
+    standin_buffer_deinit(&disposition);
+    standin_buffer_consume(&link->transfer, link->transfer.length);
+    return result;
+}
+
+static int on_transfer(AMQP_STATE* amqp, AMQP_SESSION* session, const AMQP_FIELD* fields, const unsigned char* payload, size_t payloadLength)
+{
+    int result;
+    AMQP_LINK* link = find_link(session, field_uint(&fields[0], 0));
+    session->nextIncomingId++;
+    if (link == NULL || link->kind == LINK_KIND_CBS_REPLIES || link->kind == LINK_KIND_C2D)
+    {
+        LogError("transfer on a link that does not receive");
+        result = __LINE__;
+    }
+    else
+    {
+        if (!link->transferActive)
+        {
+            link->transferActive = true;
+            link->transferDeliveryId = field_uint(&fields[1], 0);
+            link->transferSettled = field_bool(&fields[4], false);
+        }
+        standin_buffer_append(&link->transfer, payload, payloadLength);
+        if (link->transfer.failed)
+        {
+            result = __LINE__;
+        }
+        else if (field_bool(&fields[5], false))
+        {
+            /*more frames to come*/
+            result = 0;
+        }
+        else
+        {
+            link->transferActive = false;
+            link->deliveryCount++;
+            link->credit--;
+            result = on_message(amqp, session, link);
+            if (result == 0 && link->credit < LINK_CREDIT / 2)
+            {
+                link->credit = LINK_CREDIT;
+                result = send_flow(amqp, session, link);
+            }
+        }
+    }
+    return result;
+}
+
+static int on_attach(AMQP_STATE* amqp, AMQP_SESSION* session, const AMQP_FIELD* fields)
+{
+    int result;
+    bool clientSends = !field_bool(&fields[2], false);
+    AMQP_LINK* link = NULL;
+    size_t i;
+
+    for (i = 0; i < MAX_LINKS; i++)
+    {
+        if (!session->links[i].used)
+        {
+            link = &session->links[i];
+            break;
+        }
+    }
+
+    if (link == NULL)
+    {
+        LogError("more than %d links in a session", MAX_LINKS);
+        result = __LINE__;
+    }
+    else
+    {
+        STANDIN_BUFFER frame;
+        size_t frameStart;
+        size_t listStart;
+
+        link->used = true;
+        link->handle = field_uint(&fields[1], 0);
+        if (clientSends)
+        {
+            link->kind = terminus_address_equals(&fields[6], CBS_ADDRESS) ? LINK_KIND_CBS_REQUESTS : LINK_KIND_EVENTS;
+            link->deliveryCount = field_uint(&fields[9], 0);
+        }
+        else
+        {
+            link->kind = terminus_address_equals(&fields[5], CBS_ADDRESS) ? LINK_KIND_CBS_REPLIES : LINK_KIND_C2D;
+        }
+        standin_buffer_init(&link->transfer);
+
+        /*the same handle on both sides, the opposite role, the terminus of the client*/
+        standin_buffer_init(&frame);
+        frameStart = begin_frame(&frame, FRAME_TYPE_AMQP, session->channel);
+        encode_descriptor(&frame, AMQP_ATTACH);
+        listStart = begin_compound(&frame, 0xD0);
+        encode_field(&frame, &fields[0]);
+        encode_uint(&frame, link->handle);
+        encode_bool(&frame, clientSends);
+        encode_field(&frame, &fields[3]);
+        encode_field(&frame, &fields[4]);
+        encode_field(&frame, &fields[5]);
+        encode_field(&frame, &fields[6]);
+        encode_null(&frame);
+        encode_bool(&frame, false);
+        if (clientSends)
+        {
+            encode_null(&frame);
+        }
+        else
+        {
+            encode_uint(&frame, 0);
+        }
+        end_compound(&frame, listStart, 10);
+        end_frame(&frame, frameStart);
+        result = send_buffer(amqp, &frame);
+
+        if (result == 0 && clientSends)
+        {
+            link->credit = LINK_CREDIT;
+            result = send_flow(amqp, session, link);
+        }
+    }
+    return result;
+}
+
+static void on_flow(AMQP_STATE* amqp, AMQP_SESSION* session, const AMQP_FIELD* fields)
+{
+    if (!field_is_null(&fields[4]))
+    {
+        AMQP_LINK* link = find_link(session, field_uint(&fields[4], 0));
+        if (link != NULL && (link->kind == LINK_KIND_CBS_REPLIES || link->kind == LINK_KIND_C2D))
+        {
+            /*the credit is counted from the delivery count the client has seen*/
+            uint32_t credit = field_uint(&fields[6], 0);
+            if (!field_is_null(&fields[5]))
+            {
+                uint32_t inFlight = link->deliveryCount - field_uint(&fields[5], link->deliveryCount);
+                credit = (credit > inFlight) ? credit - inFlight : 0;
+            }
+            link->credit = credit;
+            send_pending_cbs_replies(amqp, session);
+        }
+    }
+}
+
+static int on_sasl_frame(AMQP_STATE* amqp, uint32_t descriptor)
+{
+    int result;
+    if (descriptor != SASL_INIT)
+    {
+        LogError("unexpected SASL frame 0x%02x", (unsigned int)descriptor);
+        result = __LINE__;
+    }
+    else
+    {
+        STANDIN_BUFFER frame;
+        size_t frameStart;
+        size_t listStart;
+        standin_buffer_init(&frame);
+        frameStart = begin_frame(&frame, FRAME_TYPE_SASL, 0);
+        encode_descriptor(&frame, SASL_OUTCOME);
+        listStart = begin_compound(&frame, 0xD0);
+        encode_ubyte(&frame, 0);
+        end_compound(&frame, listStart, 1);
+        end_frame(&frame, frameStart);
+        result = send_buffer(amqp, &frame);
+        /*the client starts over with the AMQP header*/
+        amqp->phase = AMQP_PHASE_HEADER;
+    }
+    return result;
+}
+
+static int on_frame(AMQP_STATE* amqp, uint16_t channel, uint32_t descriptor, const AMQP_FIELD* fields, const unsigned char* payload, size_t payloadLength)
+{
+    int result;
+    AMQP_SESSION* session = find_session(amqp, channel);
+
+    switch (descriptor)
+    {
+    case AMQP_OPEN:
+    {
+        STANDIN_BUFFER frame;
+        size_t frameStart;
+        size_t listStart;
+        amqp->remoteMaxFrameSize = field_uint(&fields[2], 0xFFFFFFFF);
+        if (amqp->remoteMaxFrameSize < 512 + FRAME_OVERHEAD)
+        {
+            amqp->remoteMaxFrameSize = 512 + FRAME_OVERHEAD;
+        }
+        amqp->remoteIdleTimeoutMs = field_uint(&fields[4], 0);
+
+        standin_buffer_init(&frame);
+        frameStart = begin_frame(&frame, FRAME_TYPE_AMQP, 0);
+        encode_descriptor(&frame, AMQP_OPEN);
+        listStart = begin_compound(&frame, 0xD0);
+        encode_string(&frame, "iothub_standin");
+        encode_null(&frame);
+        encode_uint(&frame, OUR_MAX_FRAME_SIZE);
+        encode_ushort(&frame, MAX_SESSIONS - 1);
+        end_compound(&frame, listStart, 4);
+        end_frame(&frame, frameStart);
+        result = send_buffer(amqp, &frame);
+        break;
+    }
+    case AMQP_BEGIN:
+    {
+        size_t i;
+        session = NULL;
+        for (i = 0; i < MAX_SESSIONS; i++)
+        {
+            if (!amqp->sessions[i].used)
+            {
+                session = &amqp->sessions[i];
+                break;
+            }
+        }
+        if (session == NULL)
+        {
+            LogError("more than %d sessions", MAX_SESSIONS);
+            result = __LINE__;
+        }
+        else
+        {
+            STANDIN_BUFFER frame;
+            size_t frameStart;
+            size_t listStart;
+            session->used = true;
+            session->channel = channel;
+            session->nextIncomingId = field_uint(&fields[1], 0);
+            standin_buffer_init(&session->pendingCbsReplies);
+
+            /*the session uses the channel of the client on both sides*/
+            standin_buffer_init(&frame);
+            frameStart = begin_frame(&frame, FRAME_TYPE_AMQP, channel);
+            encode_descriptor(&frame, AMQP_BEGIN);
+            listStart = begin_compound(&frame, 0xD0);
+            encode_ushort(&frame, channel);
+            encode_uint(&frame, session->nextOutgoingId);
+            encode_uint(&frame, WINDOW);
+            encode_uint(&frame, WINDOW);
+            encode_uint(&frame, MAX_LINKS - 1);
+            end_compound(&frame, listStart, 5);
+            end_frame(&frame, frameStart);
+            result = send_buffer(amqp, &frame);
+        }
+        break;
+    }
+    case AMQP_ATTACH:
+        result = (session == NULL) ? __LINE__ : on_attach(amqp, session, fields);
+        break;
+    case AMQP_FLOW:
+        if (session != NULL)
+        {
+            on_flow(amqp, session, fields);
+        }
+        result = 0;
+        break;
+    case AMQP_TRANSFER:
+        result = (session == NULL) ? __LINE__ : on_transfer(amqp, session, fields, payload, payloadLength);
+        break;
+    case AMQP_DISPOSITION:
+        if (field_bool(&fields[0], false))
+        {
+            /*only the cloud to device messages are sent unsettled*/
+            uint32_t first = field_uint(&fields[1], 0);
+            uint32_t last = field_uint(&fields[2], first);
+            uint32_t id;
+            for (id = first; id != last + 1; id++)
+            {
+                standin_connection_c2d_settled(amqp->connection);
+            }
+        }
+        result = 0;
+        break;
+    case AMQP_DETACH:
+        if (session == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            STANDIN_BUFFER frame;
+            size_t frameStart;
+            size_t listStart;
+            uint32_t handle = field_uint(&fields[0], 0);
+            AMQP_LINK* link = find_link(session, handle);
+            if (link != NULL)
+            {
+                free_link(link);
+            }
+            standin_buffer_init(&frame);
+            frameStart = begin_frame(&frame, FRAME_TYPE_AMQP, channel);
+            encode_descriptor(&frame, AMQP_DETACH);
+            listStart = begin_compound(&frame, 0xD0);
+            encode_uint(&frame, handle);
+            encode_bool(&frame, true);
+            end_compound(&frame, listStart, 2);
+            end_frame(&frame, frameStart);
+            result = send_buffer(amqp, &frame);
+        }
+        break;
+    case AMQP_END:
+        if (session != NULL)
+        {
+            free_session(session);
+        }
+        result = send_empty_performative(amqp, channel, AMQP_END);
+        break;
+    case AMQP_CLOSE:
+        result = send_empty_performative(amqp, 0, AMQP_CLOSE);
+        standin_connection_close(amqp->connection);
+        break;
+    default:
+        LogError("unexpected AMQP frame 0x%02x", (unsigned int)descriptor);
+        result = __LINE__;
+        break;
+    }
+    return result;
+}
+
+static int on_protocol_header(AMQP_STATE* amqp, const unsigned char* bytes)
+{
+    int result;
+    if (memcmp(bytes, "AMQP", 4) != 0 || bytes[5] != 1 || (bytes[4] != 0 && bytes[4] != 3))
+    {
+        LogError("unsupported protocol header");
+        result = __LINE__;
+    }
+    else if (standin_connection_send(amqp->connection, bytes, 8) != 0)
+    {
+        result = __LINE__;
+    }
+    else if (bytes[4] == 0)
+    {
+        amqp->phase = AMQP_PHASE_FRAMES;
+        result = 0;
+    }
+    else
+    {
+        /*offer a few mechanisms, all of them succeed*/
+        static const char* const mechanisms[] = { "MSSBCBS", "ANONYMOUS", "PLAIN", "EXTERNAL" };
+        STANDIN_BUFFER frame;
+        size_t frameStart;
+        size_t listStart;
+        size_t arrayStart;
+        size_t i;
+
+        standin_buffer_init(&frame);
+        frameStart = begin_frame(&frame, FRAME_TYPE_SASL, 0);
+        encode_descriptor(&frame, SASL_MECHANISMS);
+        listStart = begin_compound(&frame, 0xD0);
+        arrayStart = frame.length;
+        standin_buffer_append_byte(&frame, 0xF0);
+        put_uint32(&frame, 0);
+        put_uint32(&frame, sizeof(mechanisms) / sizeof(mechanisms[0]));
+        standin_buffer_append_byte(&frame, 0xB3);
+        for (i = 0; i < sizeof(mechanisms) / sizeof(mechanisms[0]); i++)
+        {
+            put_uint32(&frame, (uint32_t)strlen(mechanisms[i]));
+            standin_buffer_append(&frame, mechanisms[i], strlen(mechanisms[i]));
+        }
+        /*an array has the layout of a list, plus its element constructor*/
+        end_compound(&frame, arrayStart, sizeof(mechanisms) / sizeof(mechanisms[0]));
+        end_compound(&frame, listStart, 1);
+        end_frame(&frame, frameStart);
+        amqp->phase = AMQP_PHASE_SASL;
+        result = send_buffer(amqp, &frame);
+    }
+    return result;
+}
+
+static void* amqp_create(STANDIN_CONNECTION* connection)
+{
+    AMQP_STATE* result = (AMQP_STATE*)calloc(1, sizeof(AMQP_STATE));
+    if (result == NULL)
+    {
+        LogError("unable to allocate the AMQP state");
+    }
+    else
+    {
+        result->connection = connection;
+        result->phase = AMQP_PHASE_HEADER;
+        result->remoteMaxFrameSize = 512 + FRAME_OVERHEAD;
+        result->lastSendMs = standin_now_ms();
+    }
+    return result;
+}
+
+static void amqp_destroy(void* state)
+{
+    AMQP_STATE* amqp = (AMQP_STATE*)state;
+    size_t i;
+    for (i = 0; i < MAX_SESSIONS; i++)
+    {
+        free_session(&amqp->sessions[i]);
+    }
+    free(amqp);
+}
+
+static int amqp_on_bytes(void* state, const unsigned char* bytes, size_t length, size_t* consumed)
+{
+    int result;
+    AMQP_STATE* amqp = (AMQP_STATE*)state;
+
+    if (amqp->phase == AMQP_PHASE_HEADER)
+    {
+        if (length < 8)
+        {
+            result = 0;
+        }
+        else
+        {
+            *consumed = 8;
+            result = on_protocol_header(amqp, bytes);
+        }
+    }
+    else if (length < 8)
+    {
+        result = 0;
+    }
+    else
+    {
+        uint32_t frameSize = read_uint32(bytes);
+        size_t dataOffset = (size_t)bytes[4] * 4;
+        if (frameSize < 8 || frameSize > OUR_MAX_FRAME_SIZE || dataOffset < 8 || dataOffset > frameSize)
+        {
+            LogError("malformed AMQP frame");
+            result = __LINE__;
+        }
+        else if (length < frameSize)
+        {
+            result = 0;
+        }
+        else
+        {
+            const unsigned char* body = bytes + dataOffset;
+            size_t bodyLength = frameSize - dataOffset;
+            uint16_t channel = (uint16_t)((bytes[6] << 8) | bytes[7]);
+            *consumed = frameSize;
+
+            if (bodyLength == 0)
+            {
+                /*an empty frame keeps the connection alive*/
+                result = 0;
+            }
+            else
+            {
+                AMQP_FIELD fields[MAX_FIELDS];
+                uint32_t descriptor;
+                size_t performativeSize;
+                if (decode_described_list(body, bodyLength, &descriptor, fields, MAX_FIELDS, &performativeSize) != 0)
+                {
+                    LogError("malformed AMQP performative");
+                    result = __LINE__;
+                }
+                else if (amqp->phase == AMQP_PHASE_SASL)
+                {
+                    result = on_sasl_frame(amqp, descriptor);
+                }
+                else
+                {
+                    result = on_frame(amqp, channel, descriptor, fields, body + performativeSize, bodyLength - performativeSize);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+static void amqp_on_tick(void* state, uint64_t nowMs)
+{
+    AMQP_STATE* amqp = (AMQP_STATE*)state;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < MAX_SESSIONS; i++)
+    {
+        AMQP_SESSION* session = &amqp->sessions[i];
+        for (j = 0; session->used && j < MAX_LINKS; j++)
+        {
+            AMQP_LINK* link = &session->links[j];
+            uint64_t id;
+            if (link->used && link->kind == LINK_KIND_C2D && link->credit > 0 && standin_connection_take_c2d(amqp->connection, nowMs, &id))
+            {
+                STANDIN_BUFFER message;
+                size_t size = standin_connection_get_c2d_size(amqp->connection);
+                char messageId[32];
+                size_t listStart;
+                size_t k;
+
+                (void)snprintf(messageId, sizeof(messageId), "%llu", (unsigned long long)id);
+                standin_buffer_init(&message);
+                encode_descriptor(&message, SECTION_PROPERTIES);
+                listStart = begin_compound(&message, 0xD0);
+                encode_string(&message, messageId);
+                encode_null(&message);
+                encode_null(&message);
+                encode_null(&message);
+                encode_null(&message);
+                encode_null(&message);
+                end_compound(&message, listStart, 6);
+                encode_descriptor(&message, SECTION_DATA);
+                standin_buffer_append_byte(&message, 0xB0);
+                put_uint32(&message, (uint32_t)size);
+                for (k = 0; k < size; k++)
+                {
+                    standin_buffer_append_byte(&message, (unsigned char)('a' + k % 26));
+                }
+                if (message.failed || send_transfer(amqp, session, link, message.bytes, message.length, false) != 0)
+                {
+                    LogError("unable to send a cloud to device message");
+                }
+                standin_buffer_deinit(&message);
+            }
+        }
+    }
+
+    if (amqp->remoteIdleTimeoutMs > 0 && nowMs - amqp->lastSendMs >= amqp->remoteIdleTimeoutMs / 2)
+    {
+        static const unsigned char emptyFrame[] = { 0, 0, 0, 8, 2, 0, 0, 0 };
+        (void)standin_connection_send(amqp->connection, emptyFrame, sizeof(emptyFrame));
+        amqp->lastSendMs = nowMs;
+    }
+}
+
+const STANDIN_PROTOCOL standin_amqp_protocol =
+{
+    "AMQP",
+    amqp_create,
+    amqp_destroy,
+    amqp_on_bytes,
+    amqp_on_tick
+};
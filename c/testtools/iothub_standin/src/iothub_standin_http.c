@@ -0,0 +1,307 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "iothub_standin_private.h"
+
+/*
+ * HTTP/1.1 with persistent connections, as IoT Hub speaks it to devices:
+ *  - POST .../messages/events is an event, or a batch of events when its content type is
+ *    application/vnd.microsoft.iothub.json (every "body" of the array is counted); it is answered 204 after
+ *    the latency. A dropped request is never answered: the connection is closed. A throttled request gets 429.
+ *  - GET .../messages/devicebound answers 200 with a message and its ETag when one is due, 204 otherwise
+ *  - DELETE .../messages/devicebound/{etag} completes or rejects a message, POST .../{etag}/abandon abandons it
+ *  - everything else gets 404
+ */
+
+#define MAX_HEADER_SIZE 65536
+#define BATCH_CONTENT_TYPE "application/vnd.microsoft.iothub.json"
+
+static const char NO_CONTENT[] = "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n";
+static const char NOT_FOUND[] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+static const char TOO_MANY_REQUESTS[] = "HTTP/1.1 429 Too Many Requests\r\nContent-Length: 0\r\n\r\n";
+static const char CONTINUE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+
+typedef struct HTTP_STATE_TAG
+{
+    STANDIN_CONNECTION* connection;
+    bool continueSent;
+} HTTP_STATE;
+
+typedef struct HTTP_REQUEST_TAG
+{
+    const char* method;
+    size_t methodLength;
+    const char* path; /*without the query*/
+    size_t pathLength;
+    size_t contentLength;
+    bool expectContinue;
+    bool isBatch;
+} HTTP_REQUEST;
+
+static void* http_create(STANDIN_CONNECTION* connection)
+{
+    HTTP_STATE* result = (HTTP_STATE*)calloc(1, sizeof(HTTP_STATE));
+    if (result == NULL)
+    {
+        LogError("unable to allocate the HTTP state");
+    }
+    else
+    {
+        result->connection = connection;
+    }
+    return result;
+}
+
+static void http_destroy(void* state)
+{
+    free(state);
+}
+
+static const char* find_bytes(const char* bytes, size_t length, const char* what)
+{
+    size_t whatLength = strlen(what);
+    size_t i;
+    for (i = 0; i + whatLength <= length; i++)
+    {
+        if (memcmp(bytes + i, what, whatLength) == 0)
+        {
+            return bytes + i;
+        }
+    }
+    return NULL;
+}
+
+static bool path_ends_with(const HTTP_REQUEST* request, const char* suffix)
+{
+    size_t suffixLength = strlen(suffix);
+    return request->pathLength >= suffixLength && memcmp(request->path + request->pathLength - suffixLength, suffix, suffixLength) == 0;
+}
+
+static bool is_method(const HTTP_REQUEST* request, const char* method)
+{
+    return request->methodLength == strlen(method) && memcmp(request->method, method, request->methodLength) == 0;
+}
+
+static int parse_request(const char* header, size_t headerLength, HTTP_REQUEST* request)
+{
+    int result;
+    const char* lineEnd = find_bytes(header, headerLength, "\r\n");
+    const char* space1 = (lineEnd == NULL) ? NULL : (const char*)memchr(header, ' ', (size_t)(lineEnd - header));
+    const char* space2 = (space1 == NULL) ? NULL : (const char*)memchr(space1 + 1, ' ', (size_t)(lineEnd - space1 - 1));
+
+    (void)memset(request, 0, sizeof(HTTP_REQUEST));
+    if (space2 == NULL)
+    {
+        LogError("malformed HTTP request line");
+        result = __LINE__;
+    }
+    else
+    {
+        const char* query = (const char*)memchr(space1 + 1, '?', (size_t)(space2 - space1 - 1));
+        const char* line = lineEnd + 2;
+        request->method = header;
+        request->methodLength = (size_t)(space1 - header);
+        request->path = space1 + 1;
+        request->pathLength = (size_t)(((query != NULL) ? query : space2) - request->path);
+
+        result = 0;
+        while (line < header + headerLength)
+        {
+            const char* end = find_bytes(line, (size_t)(header + headerLength - line), "\r\n");
+            const char* colon;
+            const char* value;
+            size_t nameLength;
+            size_t valueLength;
+            if (end == NULL)
+            {
+                end = header + headerLength;
+            }
+            if ((colon = (const char*)memchr(line, ':', (size_t)(end - line))) != NULL)
+            {
+                nameLength = (size_t)(colon - line);
+                value = colon + 1;
+                while (value < end && *value == ' ')
+                {
+                    value++;
+                }
+                valueLength = (size_t)(end - value);
+                if (nameLength == sizeof("Content-Length") - 1 && strncasecmp(line, "Content-Length", nameLength) == 0)
+                {
+                    request->contentLength = (size_t)strtoull(value, NULL, 10);
+                }
+                else if (nameLength == sizeof("Expect") - 1 && strncasecmp(line, "Expect", nameLength) == 0)
+                {
+                    request->expectContinue = (valueLength >= sizeof("100-continue") - 1 && strncasecmp(value, "100-continue", sizeof("100-continue") - 1) == 0);
+                }
+                else if (nameLength == sizeof("Content-Type") - 1 && strncasecmp(line, "Content-Type", nameLength) == 0)
+                {
+                    request->isBatch = (find_bytes(value, valueLength, BATCH_CONTENT_TYPE) != NULL);
+                }
+            }
+            line = end + 2;
+        }
+    }
+    return result;
+}
+
+static size_t count_batch_events(const char* body, size_t length)
+{
+    size_t result = 0;
+    const char* found;
+    while ((found = find_bytes(body, length, "\"body\"")) != NULL)
+    {
+        result++;
+        length -= (size_t)(found - body) + 1;
+        body = found + 1;
+    }
+    return result;
+}
+
+static int send_message(HTTP_STATE* http, uint64_t id)
+{
+    int result;
+    size_t size = standin_connection_get_c2d_size(http->connection);
+    char header[256];
+    int headerLength = snprintf(header, sizeof(header),
+        "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\nContent-Type: application/octet-stream\r\nETag: \"%llu\"\r\niothub-messageid: %llu\r\n\r\n",
+        size, (unsigned long long)id, (unsigned long long)id);
+    STANDIN_BUFFER response;
+    size_t i;
+
+    standin_buffer_init(&response);
+    standin_buffer_append(&response, header, (size_t)headerLength);
+    for (i = 0; i < size; i++)
+    {
+        standin_buffer_append_byte(&response, (unsigned char)('a' + i % 26));
+    }
+    result = response.failed ? __LINE__ : standin_connection_send(http->connection, response.bytes, response.length);
+    standin_buffer_deinit(&response);
+    return result;
+}
+
+static int on_request(HTTP_STATE* http, const HTTP_REQUEST* request, const char* body)
+{
+    int result;
+    uint64_t id;
+
+    if (is_method(request, "POST") && path_ends_with(request, "/messages/events"))
+    {
+        size_t events = request->isBatch ? count_batch_events(body, request->contentLength) : 1;
+        switch (standin_connection_receive_events(http->connection, events, request->contentLength))
+        {
+        case STANDIN_FAULT_DROP:
+            standin_connection_close(http->connection);
+            result = 0;
+            break;
+        case STANDIN_FAULT_THROTTLE:
+            result = standin_connection_send(http->connection, TOO_MANY_REQUESTS, sizeof(TOO_MANY_REQUESTS) - 1);
+            break;
+        default:
+            result = standin_connection_send_ack(http->connection, NO_CONTENT, sizeof(NO_CONTENT) - 1, events);
+            break;
+        }
+    }
+    else if (is_method(request, "GET") && path_ends_with(request, "/messages/devicebound"))
+    {
+        if (standin_connection_take_c2d(http->connection, standin_now_ms(), &id))
+        {
+            result = send_message(http, id);
+        }
+        else
+        {
+            result = standin_connection_send(http->connection, NO_CONTENT, sizeof(NO_CONTENT) - 1);
+        }
+    }
+    else if (is_method(request, "DELETE") && find_bytes(request->path, request->pathLength, "/messages/devicebound/") != NULL)
+    {
+        standin_connection_c2d_settled(http->connection);
+        result = standin_connection_send(http->connection, NO_CONTENT, sizeof(NO_CONTENT) - 1);
+    }
+    else if (is_method(request, "POST") && path_ends_with(request, "/abandon"))
+    {
+        result = standin_connection_send(http->connection, NO_CONTENT, sizeof(NO_CONTENT) - 1);
+    }
+    else
+    {
+        result = standin_connection_send(http->connection, NOT_FOUND, sizeof(NOT_FOUND) - 1);
+    }
+    return result;
+}
+
+static int http_on_bytes(void* state, const unsigned char* bytes, size_t length, size_t* consumed)
+{
+    int result;
+    HTTP_STATE* http = (HTTP_STATE*)state;
+    const char* text = (const char*)bytes;
+    const char* headerEnd = find_bytes(text, (length > MAX_HEADER_SIZE) ? MAX_HEADER_SIZE : length, "\r\n\r\n");
+    HTTP_REQUEST request;
+
+    if (headerEnd == NULL)
+    {
+        if (length >= MAX_HEADER_SIZE)
+        {
+            LogError("HTTP header over %d bytes", MAX_HEADER_SIZE);
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else if (parse_request(text, (size_t)(headerEnd - text), &request) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        size_t headerLength = (size_t)(headerEnd - text) + 4;
+        if (length - headerLength < request.contentLength)
+        {
+            /*wait for the body, telling the client to send it if it asked*/
+            if (request.expectContinue && !http->continueSent)
+            {
+                http->continueSent = true;
+                result = standin_connection_send(http->connection, CONTINUE, sizeof(CONTINUE) - 1);
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        else
+        {
+            http->continueSent = false;
+            *consumed = headerLength + request.contentLength;
+            result = on_request(http, &request, text + headerLength);
+        }
+    }
+    return result;
+}
+
+static void http_on_tick(void* state, uint64_t nowMs)
+{
+    /*HTTP clients poll, nothing is pushed*/
+    (void)state;
+    (void)nowMs;
+}
+
+const STANDIN_PROTOCOL standin_http_protocol =
+{
+    "HTTP",
+    http_create,
+    http_destroy,
+    http_on_bytes,
+    http_on_tick
+};
@@ -0,0 +1,176 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*runs the stand-in until SIGINT or SIGTERM, printing its counters every few seconds*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+
+#include "azure_c_shared_utility/threadapi.h"
+
+#include "iothub_standin.h"
+
+#define STATS_INTERVAL_MS 5000
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int signalNumber)
+{
+    (void)signalNumber;
+    g_stop = 1;
+}
+
+static void print_usage(const char* program)
+{
+    (void)printf("usage: %s [options]\n"
+        "  --http-port N          HTTP port, 0 disables it (default 443)\n"
+        "  --mqtt-port N          MQTT port, 0 disables it (default 8883)\n"
+        "  --amqp-port N          AMQP port, 0 disables it (default 5671)\n"
+        "  --latency-ms N         delay of every acknowledgement (default 0)\n"
+        "  --drop-percent N       events never acknowledged (default 0)\n"
+        "  --throttle-percent N   events refused (default 0)\n"
+        "  --c2d-interval-ms N    a cloud to device message every N ms per device, 0 for none (default 0)\n"
+        "  --c2d-size N           size of the cloud to device messages (default 64)\n"
+        "  --seed N               seed of the faults (default 1)\n"
+        "  --cert FILE --key FILE PEM certificate and key (default: self-signed for 127.0.0.1)\n"
+        "  --cert-out FILE        writes the certificate, for the TrustedCerts option of the clients\n",
+        program);
+}
+
+static void print_stats(IOTHUB_STANDIN_HANDLE standin)
+{
+    IOTHUB_STANDIN_STATS stats;
+    if (iothub_standin_get_stats(standin, &stats) == 0)
+    {
+        (void)printf("connections=%llu events received=%llu acknowledged=%llu dropped=%llu throttled=%llu bytes=%llu c2d sent=%llu settled=%llu\n",
+            (unsigned long long)stats.connections, (unsigned long long)stats.eventsReceived, (unsigned long long)stats.eventsAcknowledged,
+            (unsigned long long)stats.eventsDropped, (unsigned long long)stats.eventsThrottled, (unsigned long long)stats.bytesReceived,
+            (unsigned long long)stats.c2dSent, (unsigned long long)stats.c2dSettled);
+        (void)fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    IOTHUB_STANDIN_CONFIG config;
+    const char* certificateOut = NULL;
+    int i;
+
+    iothub_standin_config_init(&config);
+    result = 0;
+    for (i = 1; i < argc && result == 0; i++)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value == NULL)
+        {
+            result = 1;
+        }
+        else if (strcmp(argv[i], "--http-port") == 0)
+        {
+            config.httpPort = (uint16_t)atoi(value);
+        }
+        else if (strcmp(argv[i], "--mqtt-port") == 0)
+        {
+            config.mqttPort = (uint16_t)atoi(value);
+        }
+        else if (strcmp(argv[i], "--amqp-port") == 0)
+        {
+            config.amqpPort = (uint16_t)atoi(value);
+        }
+        else if (strcmp(argv[i], "--latency-ms") == 0)
+        {
+            config.ackLatencyMs = (unsigned int)atoi(value);
+        }
+        else if (strcmp(argv[i], "--drop-percent") == 0)
+        {
+            config.dropPercent = (unsigned int)atoi(value);
+        }
+        else if (strcmp(argv[i], "--throttle-percent") == 0)
+        {
+            config.throttlePercent = (unsigned int)atoi(value);
+        }
+        else if (strcmp(argv[i], "--c2d-interval-ms") == 0)
+        {
+            config.c2dIntervalMs = (unsigned int)atoi(value);
+        }
+        else if (strcmp(argv[i], "--c2d-size") == 0)
+        {
+            config.c2dSize = (size_t)atoi(value);
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            config.seed = (unsigned int)atoi(value);
+        }
+        else if (strcmp(argv[i], "--cert") == 0)
+        {
+            config.certificateFile = value;
+        }
+        else if (strcmp(argv[i], "--key") == 0)
+        {
+            config.privateKeyFile = value;
+        }
+        else if (strcmp(argv[i], "--cert-out") == 0)
+        {
+            certificateOut = value;
+        }
+        else
+        {
+            result = 1;
+        }
+        i++;
+    }
+
+    if (result != 0)
+    {
+        print_usage(argv[0]);
+    }
+    else
+    {
+        IOTHUB_STANDIN_HANDLE standin = iothub_standin_start(&config);
+        if (standin == NULL)
+        {
+            (void)printf("unable to start the stand-in\n");
+            result = 1;
+        }
+        else
+        {
+            unsigned int elapsedMs = 0;
+            if (certificateOut != NULL)
+            {
+                FILE* file = fopen(certificateOut, "w");
+                if (file == NULL || fputs(iothub_standin_get_certificate(standin), file) < 0)
+                {
+                    (void)printf("unable to write %s\n", certificateOut);
+                    result = 1;
+                }
+                if (file != NULL)
+                {
+                    (void)fclose(file);
+                }
+            }
+
+            if (result == 0)
+            {
+                (void)signal(SIGINT, on_signal);
+                (void)signal(SIGTERM, on_signal);
+                (void)printf("listening on 127.0.0.1: HTTP %u, MQTT %u, AMQP %u\n", (unsigned int)config.httpPort, (unsigned int)config.mqttPort, (unsigned int)config.amqpPort);
+                (void)fflush(stdout);
+                while (!g_stop)
+                {
+                    ThreadAPI_Sleep(100);
+                    elapsedMs += 100;
+                    if (elapsedMs % STATS_INTERVAL_MS == 0)
+                    {
+                        print_stats(standin);
+                    }
+                }
+                print_stats(standin);
+            }
+            iothub_standin_stop(standin);
+        }
+    }
+    return result;
+}
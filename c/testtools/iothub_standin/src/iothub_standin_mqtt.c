@@ -0,0 +1,350 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "iothub_standin_private.h"
+
+/*
+ * MQTT 3.1.1 as IoT Hub speaks it to devices:
+ *  - PUBLISH to devices/{id}/messages/events/... is an event, acknowledged by PUBACK after the latency; a
+ *    dropped event gets no PUBACK and a throttled event closes the connection, which is what IoT Hub does
+ *    when a device goes over its quota
+ *  - SUBSCRIBE to devices/{id}/messages/devicebound/# starts the cloud to device messages, sent with QoS 1;
+ *    their PUBACK settles them
+ *  - every other PUBLISH is acknowledged at once, CONNECT always succeeds
+ */
+
+#define MQTT_CONNECT        0x10
+#define MQTT_CONNACK        0x20
+#define MQTT_PUBLISH        0x30
+#define MQTT_PUBACK         0x40
+#define MQTT_SUBSCRIBE      0x80
+#define MQTT_SUBACK         0x90
+#define MQTT_UNSUBSCRIBE    0xA0
+#define MQTT_UNSUBACK       0xB0
+#define MQTT_PINGREQ        0xC0
+#define MQTT_PINGRESP       0xD0
+#define MQTT_DISCONNECT     0xE0
+
+#define EVENTS_TOPIC_PART "/messages/events/"
+#define C2D_FILTER_SUFFIX "/messages/devicebound/#"
+#define MAX_DEVICE_ID_LENGTH 128
+
+typedef struct MQTT_STATE_TAG
+{
+    STANDIN_CONNECTION* connection;
+    bool connected;
+    bool c2dSubscribed;
+    char deviceId[MAX_DEVICE_ID_LENGTH + 1];
+    uint16_t nextPacketId;
+} MQTT_STATE;
+
+static void* mqtt_create(STANDIN_CONNECTION* connection)
+{
+    MQTT_STATE* result = (MQTT_STATE*)calloc(1, sizeof(MQTT_STATE));
+    if (result == NULL)
+    {
+        LogError("unable to allocate the MQTT state");
+    }
+    else
+    {
+        result->connection = connection;
+        result->nextPacketId = 1;
+    }
+    return result;
+}
+
+static void mqtt_destroy(void* state)
+{
+    free(state);
+}
+
+static uint16_t read_uint16(const unsigned char* bytes)
+{
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+static int send_packet_with_id(STANDIN_CONNECTION* connection, unsigned char type, uint16_t packetId)
+{
+    unsigned char packet[4];
+    packet[0] = type;
+    packet[1] = 2;
+    packet[2] = (unsigned char)(packetId >> 8);
+    packet[3] = (unsigned char)(packetId & 0xFF);
+    return standin_connection_send(connection, packet, sizeof(packet));
+}
+
+static void append_remaining_length(STANDIN_BUFFER* buffer, size_t length)
+{
+    do
+    {
+        unsigned char encoded = (unsigned char)(length % 128);
+        length /= 128;
+        standin_buffer_append_byte(buffer, (unsigned char)(encoded | ((length > 0) ? 0x80 : 0)));
+    } while (length > 0);
+}
+
+static int on_publish(MQTT_STATE* state, unsigned char flags, const unsigned char* body, size_t length)
+{
+    int result;
+    unsigned int qos = (flags >> 1) & 0x03;
+    size_t topicLength;
+    size_t headerLength;
+
+    if (length < 2 || (topicLength = read_uint16(body)) + 2 + ((qos > 0) ? 2 : 0) > length)
+    {
+        LogError("malformed PUBLISH");
+        result = __LINE__;
+    }
+    else
+    {
+        uint16_t packetId = (qos > 0) ? read_uint16(body + 2 + topicLength) : 0;
+        unsigned char puback[4];
+        headerLength = 2 + topicLength + ((qos > 0) ? 2 : 0);
+        puback[0] = MQTT_PUBACK;
+        puback[1] = 2;
+        puback[2] = (unsigned char)(packetId >> 8);
+        puback[3] = (unsigned char)(packetId & 0xFF);
+
+        /*topics are not NUL terminated, look for the part in the bytes*/
+        bool isEvent = false;
+        size_t i;
+        for (i = 0; i + sizeof(EVENTS_TOPIC_PART) - 1 <= topicLength; i++)
+        {
+            if (memcmp(body + 2 + i, EVENTS_TOPIC_PART, sizeof(EVENTS_TOPIC_PART) - 1) == 0)
+            {
+                isEvent = true;
+                break;
+            }
+        }
+
+        if (!isEvent)
+        {
+            result = (qos > 0) ? standin_connection_send(state->connection, puback, sizeof(puback)) : 0;
+        }
+        else
+        {
+            switch (standin_connection_receive_events(state->connection, 1, length - headerLength))
+            {
+            case STANDIN_FAULT_DROP:
+                result = 0;
+                break;
+            case STANDIN_FAULT_THROTTLE:
+                standin_connection_close(state->connection);
+                result = 0;
+                break;
+            default:
+                /*a QoS 0 event is acknowledged by nothing, it is only counted*/
+                result = standin_connection_send_ack(state->connection, puback, (qos > 0) ? sizeof(puback) : 0, 1);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+static int on_subscribe(MQTT_STATE* state, const unsigned char* body, size_t length)
+{
+    int result;
+    if (length < 2)
+    {
+        LogError("malformed SUBSCRIBE");
+        result = __LINE__;
+    }
+    else
+    {
+        STANDIN_BUFFER suback;
+        size_t position = 2;
+        size_t grantedCount = 0;
+        unsigned char granted[64];
+
+        result = 0;
+        while (position < length && result == 0)
+        {
+            size_t filterLength;
+            if (position + 2 > length || position + 2 + (filterLength = read_uint16(body + position)) + 1 > length || grantedCount == sizeof(granted))
+            {
+                LogError("malformed SUBSCRIBE");
+                result = __LINE__;
+            }
+            else
+            {
+                const char* filter = (const char*)body + position + 2;
+                size_t suffixLength = sizeof(C2D_FILTER_SUFFIX) - 1;
+                if (filterLength > suffixLength + sizeof("devices/") - 1 &&
+                    memcmp(filter, "devices/", sizeof("devices/") - 1) == 0 &&
+                    memcmp(filter + filterLength - suffixLength, C2D_FILTER_SUFFIX, suffixLength) == 0)
+                {
+                    size_t idLength = filterLength - suffixLength - (sizeof("devices/") - 1);
+                    if (idLength <= MAX_DEVICE_ID_LENGTH)
+                    {
+                        (void)memcpy(state->deviceId, filter + sizeof("devices/") - 1, idLength);
+                        state->deviceId[idLength] = '\0';
+                        state->c2dSubscribed = true;
+                    }
+                }
+                granted[grantedCount++] = (body[position + 2 + filterLength] > 0) ? 1 : 0;
+                position += 2 + filterLength + 1;
+            }
+        }
+
+        if (result == 0)
+        {
+            standin_buffer_init(&suback);
+            standin_buffer_append_byte(&suback, MQTT_SUBACK);
+            append_remaining_length(&suback, 2 + grantedCount);
+            standin_buffer_append(&suback, body, 2);
+            standin_buffer_append(&suback, granted, grantedCount);
+            result = suback.failed ? __LINE__ : standin_connection_send(state->connection, suback.bytes, suback.length);
+            standin_buffer_deinit(&suback);
+        }
+    }
+    return result;
+}
+
+static int mqtt_on_bytes(void* state, const unsigned char* bytes, size_t length, size_t* consumed)
+{
+    int result;
+    MQTT_STATE* mqtt = (MQTT_STATE*)state;
+    size_t remainingLength = 0;
+    size_t multiplier = 1;
+    size_t position = 1;
+    bool complete = false;
+
+    while (position < length && position <= 4)
+    {
+        remainingLength += (bytes[position] & 0x7F) * multiplier;
+        multiplier *= 128;
+        if ((bytes[position++] & 0x80) == 0)
+        {
+            complete = true;
+            break;
+        }
+    }
+
+    if (!complete)
+    {
+        if (position > 4)
+        {
+            LogError("malformed remaining length");
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else if (length - position < remainingLength)
+    {
+        /*wait for the rest of the packet*/
+        result = 0;
+    }
+    else
+    {
+        const unsigned char* body = bytes + position;
+        unsigned char type = bytes[0] & 0xF0;
+        *consumed = position + remainingLength;
+
+        if (!mqtt->connected && type != MQTT_CONNECT)
+        {
+            LogError("MQTT packet 0x%02x before CONNECT", (unsigned int)type);
+            result = __LINE__;
+        }
+        else
+        {
+            switch (type)
+            {
+            case MQTT_CONNECT:
+            {
+                static const unsigned char connack[] = { MQTT_CONNACK, 2, 0, 0 };
+                mqtt->connected = true;
+                result = standin_connection_send(mqtt->connection, connack, sizeof(connack));
+                break;
+            }
+            case MQTT_PUBLISH:
+                result = on_publish(mqtt, bytes[0] & 0x0F, body, remainingLength);
+                break;
+            case MQTT_PUBACK:
+                standin_connection_c2d_settled(mqtt->connection);
+                result = 0;
+                break;
+            case MQTT_SUBSCRIBE:
+                result = on_subscribe(mqtt, body, remainingLength);
+                break;
+            case MQTT_UNSUBSCRIBE:
+                mqtt->c2dSubscribed = false;
+                result = (remainingLength < 2) ? __LINE__ : send_packet_with_id(mqtt->connection, MQTT_UNSUBACK, read_uint16(body));
+                break;
+            case MQTT_PINGREQ:
+            {
+                static const unsigned char pingresp[] = { MQTT_PINGRESP, 0 };
+                result = standin_connection_send(mqtt->connection, pingresp, sizeof(pingresp));
+                break;
+            }
+            case MQTT_DISCONNECT:
+                standin_connection_close(mqtt->connection);
+                result = 0;
+                break;
+            default:
+                LogError("unexpected MQTT packet 0x%02x", (unsigned int)type);
+                result = __LINE__;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+static void mqtt_on_tick(void* state, uint64_t nowMs)
+{
+    MQTT_STATE* mqtt = (MQTT_STATE*)state;
+    uint64_t id;
+    if (mqtt->c2dSubscribed && standin_connection_take_c2d(mqtt->connection, nowMs, &id))
+    {
+        char topic[MAX_DEVICE_ID_LENGTH * 2 + 128];
+        int topicLength = snprintf(topic, sizeof(topic), "devices/%s/messages/devicebound/%%24.to=%%2Fdevices%%2F%s%%2Fmessages%%2FdeviceBound&%%24.mid=%llu",
+            mqtt->deviceId, mqtt->deviceId, (unsigned long long)id);
+        size_t payloadSize = standin_connection_get_c2d_size(mqtt->connection);
+        STANDIN_BUFFER publish;
+        size_t i;
+
+        standin_buffer_init(&publish);
+        standin_buffer_append_byte(&publish, MQTT_PUBLISH | 0x02);
+        append_remaining_length(&publish, 2 + (size_t)topicLength + 2 + payloadSize);
+        standin_buffer_append_byte(&publish, (unsigned char)(topicLength >> 8));
+        standin_buffer_append_byte(&publish, (unsigned char)(topicLength & 0xFF));
+        standin_buffer_append(&publish, topic, (size_t)topicLength);
+        standin_buffer_append_byte(&publish, (unsigned char)(mqtt->nextPacketId >> 8));
+        standin_buffer_append_byte(&publish, (unsigned char)(mqtt->nextPacketId & 0xFF));
+        for (i = 0; i < payloadSize; i++)
+        {
+            standin_buffer_append_byte(&publish, (unsigned char)('a' + i % 26));
+        }
+        if (publish.failed || standin_connection_send(mqtt->connection, publish.bytes, publish.length) != 0)
+        {
+            LogError("unable to send a cloud to device message");
+        }
+        standin_buffer_deinit(&publish);
+
+        mqtt->nextPacketId = (mqtt->nextPacketId == 0xFFFF) ? 1 : (uint16_t)(mqtt->nextPacketId + 1);
+    }
+}
+
+const STANDIN_PROTOCOL standin_mqtt_protocol =
+{
+    "MQTT",
+    mqtt_create,
+    mqtt_destroy,
+    mqtt_on_bytes,
+    mqtt_on_tick
+};
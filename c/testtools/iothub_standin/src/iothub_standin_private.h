@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*what the core of the stand-in (iothub_standin.c) offers to the protocols and what it expects from them*/
+
+#ifndef IOTHUB_STANDIN_PRIVATE_H
+#define IOTHUB_STANDIN_PRIVATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct STANDIN_CONNECTION_TAG STANDIN_CONNECTION;
+
+typedef enum STANDIN_FAULT_TAG
+{
+    STANDIN_FAULT_NONE,
+    STANDIN_FAULT_DROP,
+    STANDIN_FAULT_THROTTLE
+} STANDIN_FAULT;
+
+typedef struct STANDIN_PROTOCOL_TAG
+{
+    const char* name;
+    void* (*create)(STANDIN_CONNECTION* connection);
+    void (*destroy)(void* state);
+    /*parses what it can of the bytes received so far, sets consumed to what it used; non-zero closes the connection*/
+    int (*on_bytes)(void* state, const unsigned char* bytes, size_t length, size_t* consumed);
+    /*called at least every 50 ms, for the cloud to device messages and the keep alives*/
+    void (*on_tick)(void* state, uint64_t nowMs);
+} STANDIN_PROTOCOL;
+
+extern const STANDIN_PROTOCOL standin_http_protocol;
+extern const STANDIN_PROTOCOL standin_mqtt_protocol;
+extern const STANDIN_PROTOCOL standin_amqp_protocol;
+
+/*a growable byte buffer; once an append failed, failed stays set and the buffer should be dropped*/
+typedef struct STANDIN_BUFFER_TAG
+{
+    unsigned char* bytes;
+    size_t length;
+    size_t capacity;
+    bool failed;
+} STANDIN_BUFFER;
+
+extern void standin_buffer_init(STANDIN_BUFFER* buffer);
+extern void standin_buffer_deinit(STANDIN_BUFFER* buffer);
+extern void standin_buffer_append(STANDIN_BUFFER* buffer, const void* bytes, size_t length);
+extern void standin_buffer_append_byte(STANDIN_BUFFER* buffer, unsigned char value);
+extern void standin_buffer_consume(STANDIN_BUFFER* buffer, size_t length);
+
+extern uint64_t standin_now_ms(void);
+
+/*queues bytes for the peer; bytes sent after a delayed send wait for it, so that the order is kept*/
+extern int standin_connection_send(STANDIN_CONNECTION* connection, const void* bytes, size_t length);
+
+/*queues bytes for the peer after the acknowledgement latency, and counts one acknowledged event per event*/
+extern int standin_connection_send_ack(STANDIN_CONNECTION* connection, const void* bytes, size_t length, size_t events);
+
+/*closes the connection once what is queued has been sent*/
+extern void standin_connection_close(STANDIN_CONNECTION* connection);
+
+/*counts events received and draws their fault, counting the dropped and the throttled ones*/
+extern STANDIN_FAULT standin_connection_receive_events(STANDIN_CONNECTION* connection, size_t events, size_t bytes);
+
+/*true when a cloud to device message is due on the connection, which the caller then sends; id numbers the messages of the stand-in*/
+extern bool standin_connection_take_c2d(STANDIN_CONNECTION* connection, uint64_t nowMs, uint64_t* id);
+extern size_t standin_connection_get_c2d_size(STANDIN_CONNECTION* connection);
+extern void standin_connection_c2d_settled(STANDIN_CONNECTION* connection);
+
+#endif /* IOTHUB_STANDIN_PRIVATE_H */
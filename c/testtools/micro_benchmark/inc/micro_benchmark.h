@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file micro_benchmark.h
+*    @brief A small harness for the microbenchmarks of the SDK hot paths.
+*
+*    @details Every operation is measured for ns/op (processor time, best of several
+*             repetitions) and, on Linux, for allocations/op and bytes/op (the sizes requested
+*             from malloc, calloc and realloc). The results are compared against a baseline
+*             file with one line per operation: "name ns/op allocations/op bytes/op". An
+*             allocation count or a byte count above the baseline is a regression and makes
+*             micro_benchmark_compare fail. A time above the baseline is only reported, since
+*             it depends on the machine.
+*/
+
+#ifndef MICRO_BENCHMARK_H
+#define MICRO_BENCHMARK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct MICRO_BENCHMARK_TAG* MICRO_BENCHMARK_HANDLE;
+
+/** @brief  One execution of the operation being measured. Returns 0 on success. */
+typedef int(*MICRO_BENCHMARK_OPERATION)(void* context);
+
+/**
+* @brief    Creates a benchmark suite from the command line of the benchmark executable:
+*           "[baselineFile [--write-baseline]]". With --write-baseline the results are written
+*           to baselineFile by micro_benchmark_compare instead of being compared with it.
+*
+* @return   A handle, or NULL when the command line is not valid or the baseline cannot be read.
+*/
+extern MICRO_BENCHMARK_HANDLE micro_benchmark_create(int argc, char** argv);
+
+/**
+* @brief    Measures @p operation and prints its results next to its baseline, if there is one.
+*           @p name cannot contain white space.
+*
+* @return   0 on success, non-zero when the operation failed.
+*/
+extern int micro_benchmark_run(MICRO_BENCHMARK_HANDLE handle, const char* name, MICRO_BENCHMARK_OPERATION operation, void* context);
+
+/**
+* @brief    Writes the baseline, or counts the regressions against it.
+*
+* @return   0 when every operation succeeded and none regressed, non-zero otherwise.
+*/
+extern int micro_benchmark_compare(MICRO_BENCHMARK_HANDLE handle);
+
+extern void micro_benchmark_destroy(MICRO_BENCHMARK_HANDLE handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MICRO_BENCHMARK_H */
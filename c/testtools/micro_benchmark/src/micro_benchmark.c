@@ -0,0 +1,345 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*gballoc.h is not included on purpose: this file counts the allocations of everything else*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "micro_benchmark.h"
+
+#define MAX_OPERATIONS 64
+#define MAX_NAME_LENGTH 63
+#define WARMUP_OPS 16
+#define COUNTED_OPS 64
+#define REPETITIONS 5
+#define MIN_BATCH_CLOCKS (CLOCKS_PER_SEC / 50)
+/*times above the baseline by more than this are flagged, but are not regressions*/
+#define SLOWER_TOLERANCE 0.25
+/*allocations/op and bytes/op are averages, this absorbs the rounding of the text baseline*/
+#define COUNT_TOLERANCE 0.01
+
+typedef struct MICRO_BENCHMARK_RECORD_TAG
+{
+    char name[MAX_NAME_LENGTH + 1];
+    double nsPerOp;
+    double allocationsPerOp; /*negative when allocations are not counted*/
+    double bytesPerOp;
+} MICRO_BENCHMARK_RECORD;
+
+typedef struct MICRO_BENCHMARK_TAG
+{
+    const char* baselineFile;
+    bool writeBaseline;
+    size_t baselineCount;
+    MICRO_BENCHMARK_RECORD baseline[MAX_OPERATIONS];
+    size_t resultCount;
+    MICRO_BENCHMARK_RECORD results[MAX_OPERATIONS];
+    size_t failures;
+    size_t regressions;
+} MICRO_BENCHMARK;
+
+#ifdef MICRO_BENCHMARK_COUNT_ALLOCATIONS
+/*the executables are linked with --wrap=malloc,calloc,realloc: every call made from the SDK and from the shared utility lands here*/
+static size_t allocationCount;
+static size_t allocatedBytes;
+
+extern void* __real_malloc(size_t size);
+extern void* __real_calloc(size_t nmemb, size_t size);
+extern void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    allocationCount++;
+    allocatedBytes += size;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size)
+{
+    allocationCount++;
+    allocatedBytes += nmemb * size;
+    return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    /*a realloc that shrinks or frees is still a call into the allocator, its requested size is counted as is*/
+    allocationCount++;
+    allocatedBytes += size;
+    return __real_realloc(ptr, size);
+}
+#endif
+
+static int read_baseline(MICRO_BENCHMARK* benchmark)
+{
+    int result;
+    FILE* file = fopen(benchmark->baselineFile, "r");
+    if (file == NULL)
+    {
+        /*no baseline yet: everything is reported as new*/
+        (void)printf("no baseline in %s\n", benchmark->baselineFile);
+        result = 0;
+    }
+    else
+    {
+        char line[256];
+        result = 0;
+        while (fgets(line, sizeof(line), file) != NULL)
+        {
+            MICRO_BENCHMARK_RECORD* record = &benchmark->baseline[benchmark->baselineCount];
+            if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+            {
+                /*comments and empty lines*/
+            }
+            else if (benchmark->baselineCount == MAX_OPERATIONS)
+            {
+                (void)printf("%s has more than %d operations\n", benchmark->baselineFile, MAX_OPERATIONS);
+                result = __LINE__;
+                break;
+            }
+            else if (sscanf(line, "%63s %lf %lf %lf", record->name, &record->nsPerOp, &record->allocationsPerOp, &record->bytesPerOp) != 4)
+            {
+                (void)printf("malformed baseline line: %s", line);
+                result = __LINE__;
+                break;
+            }
+            else
+            {
+                benchmark->baselineCount++;
+            }
+        }
+        (void)fclose(file);
+    }
+    return result;
+}
+
+static const MICRO_BENCHMARK_RECORD* find_baseline(const MICRO_BENCHMARK* benchmark, const char* name)
+{
+    size_t i;
+    for (i = 0; i < benchmark->baselineCount; i++)
+    {
+        if (strcmp(benchmark->baseline[i].name, name) == 0)
+        {
+            return &benchmark->baseline[i];
+        }
+    }
+    return NULL;
+}
+
+MICRO_BENCHMARK_HANDLE micro_benchmark_create(int argc, char** argv)
+{
+    MICRO_BENCHMARK* result;
+    if (argc > 3 || (argc == 3 && strcmp(argv[2], "--write-baseline") != 0))
+    {
+        (void)printf("usage: %s [baselineFile [--write-baseline]]\n", argv[0]);
+        result = NULL;
+    }
+    else if ((result = (MICRO_BENCHMARK*)calloc(1, sizeof(MICRO_BENCHMARK))) == NULL)
+    {
+        (void)printf("unable to allocate the benchmark\n");
+    }
+    else
+    {
+        result->baselineFile = (argc > 1) ? argv[1] : NULL;
+        result->writeBaseline = (argc == 3);
+        if ((result->baselineFile != NULL) && !result->writeBaseline && (read_baseline(result) != 0))
+        {
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            (void)printf("%-40s %12s %12s %12s\n", "operation", "ns/op", "allocs/op", "bytes/op");
+        }
+    }
+    return result;
+}
+
+static int run_batch(MICRO_BENCHMARK_OPERATION operation, void* context, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        if (operation(context) != 0)
+        {
+            return __LINE__;
+        }
+    }
+    return 0;
+}
+
+static int measure(MICRO_BENCHMARK_OPERATION operation, void* context, MICRO_BENCHMARK_RECORD* record)
+{
+    int result;
+
+    if (run_batch(operation, context, WARMUP_OPS) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+#ifdef MICRO_BENCHMARK_COUNT_ALLOCATIONS
+        allocationCount = 0;
+        allocatedBytes = 0;
+        result = run_batch(operation, context, COUNTED_OPS);
+        record->allocationsPerOp = (double)allocationCount / COUNTED_OPS;
+        record->bytesPerOp = (double)allocatedBytes / COUNTED_OPS;
+#else
+        result = 0;
+        record->allocationsPerOp = -1.0;
+        record->bytesPerOp = -1.0;
+#endif
+    }
+
+    if (result == 0)
+    {
+        /*grow the batch until it is long enough for clock(), then keep the fastest of a few repetitions*/
+        size_t batch = 1;
+        clock_t elapsed = 0;
+        size_t repetition;
+        double best = 0;
+
+        while (result == 0)
+        {
+            clock_t start = clock();
+            result = run_batch(operation, context, batch);
+            elapsed = clock() - start;
+            if (elapsed >= MIN_BATCH_CLOCKS)
+            {
+                break;
+            }
+            batch *= 2;
+        }
+
+        for (repetition = 0; (repetition < REPETITIONS) && (result == 0); repetition++)
+        {
+            double nsPerOp;
+            if (repetition > 0)
+            {
+                clock_t start = clock();
+                result = run_batch(operation, context, batch);
+                elapsed = clock() - start;
+            }
+            nsPerOp = ((double)elapsed / CLOCKS_PER_SEC) * 1e9 / (double)batch;
+            if ((repetition == 0) || (nsPerOp < best))
+            {
+                best = nsPerOp;
+            }
+        }
+        record->nsPerOp = best;
+    }
+    return result;
+}
+
+int micro_benchmark_run(MICRO_BENCHMARK_HANDLE handle, const char* name, MICRO_BENCHMARK_OPERATION operation, void* context)
+{
+    int result;
+    if ((handle == NULL) || (name == NULL) || (operation == NULL) || (strlen(name) > MAX_NAME_LENGTH) || (strpbrk(name, " \t") != NULL))
+    {
+        (void)printf("invalid arguments to micro_benchmark_run\n");
+        result = __LINE__;
+    }
+    else if (handle->resultCount == MAX_OPERATIONS)
+    {
+        (void)printf("more than %d operations\n", MAX_OPERATIONS);
+        result = __LINE__;
+    }
+    else
+    {
+        MICRO_BENCHMARK_RECORD* record = &handle->results[handle->resultCount];
+        (void)strcpy(record->name, name);
+        if (measure(operation, context, record) != 0)
+        {
+            (void)printf("%-40s failed\n", name);
+            handle->failures++;
+            result = __LINE__;
+        }
+        else
+        {
+            const MICRO_BENCHMARK_RECORD* baseline = find_baseline(handle, name);
+            handle->resultCount++;
+            if (record->allocationsPerOp < 0)
+            {
+                (void)printf("%-40s %12.1f %12s %12s", name, record->nsPerOp, "-", "-");
+            }
+            else
+            {
+                (void)printf("%-40s %12.1f %12.2f %12.1f", name, record->nsPerOp, record->allocationsPerOp, record->bytesPerOp);
+            }
+
+            if (handle->writeBaseline)
+            {
+                (void)printf("\n");
+            }
+            else if (baseline == NULL)
+            {
+                (void)printf("  (new)\n");
+            }
+            else
+            {
+                bool moreAllocations = (record->allocationsPerOp >= 0) && (baseline->allocationsPerOp >= 0) &&
+                    ((record->allocationsPerOp > baseline->allocationsPerOp + COUNT_TOLERANCE) || (record->bytesPerOp > baseline->bytesPerOp + COUNT_TOLERANCE));
+                double timeChange = (baseline->nsPerOp > 0) ? (record->nsPerOp / baseline->nsPerOp - 1.0) : 0.0;
+                (void)printf("  %+6.1f%% time%s%s\n", timeChange * 100.0,
+                    (timeChange > SLOWER_TOLERANCE) ? ", slower" : "",
+                    moreAllocations ? ", ALLOCATION REGRESSION" : "");
+                if (moreAllocations)
+                {
+                    (void)printf("%-40s baseline %12.2f allocs/op %12.1f bytes/op\n", "", baseline->allocationsPerOp, baseline->bytesPerOp);
+                    handle->regressions++;
+                }
+            }
+            result = 0;
+        }
+        (void)fflush(stdout);
+    }
+    return result;
+}
+
+int micro_benchmark_compare(MICRO_BENCHMARK_HANDLE handle)
+{
+    int result;
+    if (handle == NULL)
+    {
+        result = __LINE__;
+    }
+    else if (handle->writeBaseline)
+    {
+        FILE* file = fopen(handle->baselineFile, "w");
+        if (file == NULL)
+        {
+            (void)printf("unable to write %s\n", handle->baselineFile);
+            result = __LINE__;
+        }
+        else
+        {
+            size_t i;
+            (void)fprintf(file, "# name ns/op allocations/op bytes/op\n");
+            for (i = 0; i < handle->resultCount; i++)
+            {
+                const MICRO_BENCHMARK_RECORD* record = &handle->results[i];
+                (void)fprintf(file, "%s %.1f %.2f %.1f\n", record->name, record->nsPerOp, record->allocationsPerOp, record->bytesPerOp);
+            }
+            (void)fclose(file);
+            (void)printf("baseline written to %s\n", handle->baselineFile);
+            result = (handle->failures == 0) ? 0 : __LINE__;
+        }
+    }
+    else
+    {
+        if (handle->regressions != 0)
+        {
+            (void)printf("%lu operation(s) allocate more than their baseline\n", (unsigned long)handle->regressions);
+        }
+        result = ((handle->failures == 0) && (handle->regressions == 0)) ? 0 : __LINE__;
+    }
+    return result;
+}
+
+void micro_benchmark_destroy(MICRO_BENCHMARK_HANDLE handle)
+{
+    free(handle);
+}
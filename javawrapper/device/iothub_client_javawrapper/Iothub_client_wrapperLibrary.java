@@ -417,6 +417,7 @@ public interface Iothub_client_wrapperLibrary extends Library{
         public static final int IOTHUB_CLIENT_ERROR = 2;
         public static final int IOTHUB_CLIENT_INVALID_SIZE = 3;
         public static final int IOTHUB_CLIENT_INDEFINITE_TIME = 4;
+        public static final int IOTHUB_CLIENT_QUEUE_FULL = 5;
     }    
     
     public static interface IOTHUB_MESSAGE_RESULT 
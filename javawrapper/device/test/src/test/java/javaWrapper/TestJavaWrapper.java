@@ -78,6 +78,7 @@ public class TestJavaWrapper
         assertEquals(IOTHUB_CLIENT_RESULT.IOTHUB_CLIENT_ERROR, 2);
         assertEquals(IOTHUB_CLIENT_RESULT.IOTHUB_CLIENT_INVALID_SIZE, 3);
         assertEquals(IOTHUB_CLIENT_RESULT.IOTHUB_CLIENT_INDEFINITE_TIME, 4);
+        assertEquals(IOTHUB_CLIENT_RESULT.IOTHUB_CLIENT_QUEUE_FULL, 5);
     }
     
     @Test
@@ -40,6 +40,9 @@ echo copy iothub_client library to samples folder
 cp $build_folder/python/src/iothub_client.so ./python/device/samples/iothub_client.so
 echo copy iothub_client_mock library to tests folder
 cp $build_folder/python/test/iothub_client_mock.so ./python/device/tests/iothub_client_mock.so
+echo copy iothub_client_asyncio module to samples and tests folders
+cp ./python/device/iothub_client_asyncio/iothub_client_asyncio.py ./python/device/samples/iothub_client_asyncio.py
+cp ./python/device/iothub_client_asyncio/iothub_client_asyncio.py ./python/device/tests/iothub_client_asyncio.py
 
 cd $build_root/python/device/tests/
 echo "python${PYTHON_VERSION}" iothub_client_ut.py
@@ -48,4 +51,11 @@ echo "python${PYTHON_VERSION}" iothub_client_ut.py
 echo "python${PYTHON_VERSION}" iothub_client_map_test.py
 "python${PYTHON_VERSION}" iothub_client_map_test.py
 [ $? -eq 0 ] || exit $?
+# the asyncio client needs Python 3.5 or later
+if "python${PYTHON_VERSION}" -c "import sys; sys.exit(0 if sys.version_info >= (3, 5) else 1)"
+then
+    echo "python${PYTHON_VERSION}" iothub_client_asyncio_ut.py
+    "python${PYTHON_VERSION}" iothub_client_asyncio_ut.py
+    [ $? -eq 0 ] || exit $?
+fi
 cd $build_root
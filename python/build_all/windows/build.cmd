@@ -137,6 +137,11 @@ if not !ERRORLEVEL!==0 exit /b !ERRORLEVEL!
 @echo Copy iothub_client_mock.pyd to %build-root%\device\tests
 copy /Y %PYTHON_SOLUTION_PATH%\%build-config%\iothub_client_mock.pyd  %build-root%\device\tests\ 
 if not !ERRORLEVEL!==0 exit /b !ERRORLEVEL!
+@echo Copy iothub_client_asyncio.py to %build-root%\device\samples and %build-root%\device\tests
+copy /Y %build-root%\device\iothub_client_asyncio\iothub_client_asyncio.py  %build-root%\device\samples\ 
+if not !ERRORLEVEL!==0 exit /b !ERRORLEVEL!
+copy /Y %build-root%\device\iothub_client_asyncio\iothub_client_asyncio.py  %build-root%\device\tests\ 
+if not !ERRORLEVEL!==0 exit /b !ERRORLEVEL!
 
 rem -----------------------------------------------------------------------------
 rem -- Python library unit test
@@ -148,6 +153,12 @@ if %run-ut%==1 (
     if ERRORLEVEL 1 exit /b 1
     python iothub_client_map_test.py
     if ERRORLEVEL 1 exit /b 1
+    rem the asyncio client needs Python 3.5 or later
+    python -c "import sys; sys.exit(0 if sys.version_info >= (3, 5) else 1)"
+    if not ERRORLEVEL 1 (
+        python iothub_client_asyncio_ut.py
+        if ERRORLEVEL 1 exit /b 1
+    )
     echo Python unit test PASSED
 )
 
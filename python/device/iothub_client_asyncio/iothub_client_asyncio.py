@@ -0,0 +1,109 @@
+# Copyright (c) Microsoft. All rights reserved.
+# Licensed under the MIT license. See LICENSE file in the project root for
+# full license information.
+
+"""asyncio client for Azure IoT Hub (Python 3.5+).
+
+IoTHubClientAsync drives an IoTHubClientLL from the event loop: no thread runs
+in the background, do_work is called on the loop thread and the confirmations
+and messages complete futures there, so hundreds of clients can share one loop.
+
+The transports do not expose their sockets, so do_work runs on a deadline:
+right away after send_event, every busy_interval while events are in flight and
+every idle_interval otherwise, which bounds how late a message is received.
+do_work of the HTTP transport makes synchronous requests and stalls the loop,
+use MQTT or AMQP. Every event is sent with its own confirmation callback, which
+these transports call from do_work, so the future of send_event resolves on the
+loop thread.
+"""
+
+import asyncio
+import sys
+
+
+class IoTHubClientAsync(object):
+
+    def __init__(self, client, loop=None, busy_interval=0.01, idle_interval=0.1):
+        """Takes ownership of client, an IoTHubClientLL."""
+        self._client = client
+        self._module = sys.modules[type(client).__module__]
+        self._loop = loop if loop is not None else asyncio.get_event_loop()
+        self._busy_interval = busy_interval
+        self._idle_interval = idle_interval
+        self._in_flight = 0
+        # the queue must wake up receive() on the loop of this client, which is not
+        # always the current loop; Python 3.10 binds it to the loop that awaits it
+        if sys.version_info < (3, 10):
+            self._received = asyncio.Queue(loop=self._loop)
+        else:
+            self._received = asyncio.Queue()
+        self._timer = None
+        self._deadline = None
+        self._closed = False
+        self._client.set_message_callback(self._on_message, None)
+        self._schedule(self._idle_interval)
+
+    @classmethod
+    def from_connection_string(cls, connection_string, protocol, **kwargs):
+        import iothub_client
+        return cls(iothub_client.IoTHubClientLL(connection_string, protocol), **kwargs)
+
+    @property
+    def protocol(self):
+        return self._client.protocol
+
+    def set_option(self, option_name, option):
+        self._client.set_option(option_name, option)
+
+    async def send_event(self, message):
+        """Sends an IoTHubMessage, returns its IoTHubClientConfirmationResult."""
+        if self._closed:
+            raise RuntimeError("send_event on a closed client")
+        future = self._loop.create_future()
+        self._client.send_event_async(message, self._on_confirmation, future)
+        self._in_flight += 1
+        self._schedule(0)
+        return await future
+
+    async def receive(self):
+        """Returns the next IoTHubMessage received, the messages are accepted."""
+        return await self._received.get()
+
+    def close(self):
+        """Destroys the client, the events in flight complete with BECAUSE_DESTROY."""
+        if not self._closed:
+            self._closed = True
+            if self._timer is not None:
+                self._timer.cancel()
+                self._timer = None
+            self._client.destroy()
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, exc_type, exc, tb):
+        self.close()
+
+    def _schedule(self, delay):
+        deadline = self._loop.time() + delay
+        if self._timer is not None:
+            if self._deadline <= deadline:
+                return
+            self._timer.cancel()
+        self._deadline = deadline
+        self._timer = self._loop.call_at(deadline, self._do_work)
+
+    def _do_work(self):
+        self._timer = None
+        if not self._closed:
+            self._client.do_work()
+            self._schedule(self._busy_interval if self._in_flight > 0 else self._idle_interval)
+
+    def _on_confirmation(self, message, result, future):
+        self._in_flight -= 1
+        if not future.done():
+            future.set_result(result)
+
+    def _on_message(self, message, context):
+        self._received.put_nowait(message)
+        return self._module.IoTHubMessageDispositionResult.ACCEPTED
@@ -552,15 +552,19 @@ public:
     IoTHubMessage(PyObject *pyObject) :
         iotHubMapProperties(NULL)
     {
-        if (!PyByteArray_Check(pyObject)) {
-            PyErr_SetString(PyExc_TypeError, "expected type bytearray");
-            boost::python::throw_error_already_set();
-            return;
+#ifdef IS_PY3
+        if (PyUnicode_Check(pyObject))
+#else
+        if (PyString_Check(pyObject))
+#endif
+        {
+            std::string source = boost::python::extract<std::string>(pyObject);
+            iotHubMessageHandle = IoTHubMessage_CreateFromString(source.c_str());
+        }
+        else
+        {
+            iotHubMessageHandle = CreateHandleFromBuffer(pyObject, "expected type string, bytearray, bytes or an object with a contiguous buffer");
         }
-        PyByteArrayObject *pyByteArray = (PyByteArrayObject *)pyObject;
-        const unsigned char* byteArray = (const unsigned char*)pyByteArray->ob_bytes;
-        size_t size = Py_SIZE(pyByteArray);
-        iotHubMessageHandle = IoTHubMessage_CreateFromByteArray(byteArray, size);
         if (iotHubMessageHandle == NULL)
         {
             throw IoTHubMessageError(__func__, IOTHUB_MESSAGE_ERROR);
@@ -578,15 +582,24 @@ public:
 
     static IoTHubMessage *CreateFromByteArray(PyObject *pyObject)
     {
-        if (!PyByteArray_Check(pyObject)) {
-            PyErr_SetString(PyExc_TypeError, "CreateFromByteArray expected type bytearray");
+        return new IoTHubMessage(CreateHandleFromBuffer(pyObject, "CreateFromByteArray expected type bytearray, bytes or an object with a contiguous buffer"));
+    }
+
+    // the native message owns its payload, so the content of any object with the buffer protocol
+    // (bytearray, bytes, memoryview, numpy arrays...) is read in place and copied once
+    static IOTHUB_MESSAGE_HANDLE CreateHandleFromBuffer(PyObject *pyObject, const char *typeError)
+    {
+        Py_buffer view;
+        if (!PyObject_CheckBuffer(pyObject) || (PyObject_GetBuffer(pyObject, &view, PyBUF_SIMPLE) != 0))
+        {
+            PyErr_Clear();
+            PyErr_SetString(PyExc_TypeError, typeError);
             boost::python::throw_error_already_set();
             return NULL;
         }
-        PyByteArrayObject *pyByteArray = (PyByteArrayObject *)pyObject;
-        const unsigned char* byteArray = (const unsigned char*)pyByteArray->ob_bytes;
-        size_t size = Py_SIZE(pyByteArray);
-        return new IoTHubMessage(IoTHubMessage_CreateFromByteArray(byteArray, size));
+        IOTHUB_MESSAGE_HANDLE handle = IoTHubMessage_CreateFromByteArray((const unsigned char*)view.buf, (size_t)view.len);
+        PyBuffer_Release(&view);
+        return handle;
     }
 
     static IoTHubMessage *CreateFromString(std::string source)
@@ -621,6 +634,27 @@ public:
         return IoTHubMessage_GetString(iotHubMessageHandle);
     }
 
+    // the native payload, byte array or string, valid as long as the message
+    bool GetPayload(const unsigned char **buffer, size_t *size)
+    {
+        bool result;
+        if (IoTHubMessage_GetContentType(iotHubMessageHandle) == IOTHUBMESSAGE_STRING)
+        {
+            const char *string = IoTHubMessage_GetString(iotHubMessageHandle);
+            result = (string != NULL);
+            if (result)
+            {
+                *buffer = (const unsigned char*)string;
+                *size = strlen(string);
+            }
+        }
+        else
+        {
+            result = (IoTHubMessage_GetByteArray(iotHubMessageHandle, buffer, size) == IOTHUB_MESSAGE_OK);
+        }
+        return result;
+    }
+
     IOTHUBMESSAGE_CONTENT_TYPE GetContentType()
     {
         return IoTHubMessage_GetContentType(iotHubMessageHandle);
@@ -693,6 +727,47 @@ public:
 #endif
 };
 
+// IoTHubMessage exports its payload with the buffer protocol, read-only; a memoryview keeps the message alive
+
+extern "C"
+int
+IoTHubMessageGetBuffer(
+    PyObject *exporter,
+    Py_buffer *view,
+    int flags
+    )
+{
+    int result;
+    const unsigned char *buffer;
+    size_t size;
+    boost::python::extract<IoTHubMessage&> message(exporter);
+    if (!message.check())
+    {
+        PyErr_SetString(PyExc_BufferError, "expected type IoTHubMessage");
+        result = -1;
+    }
+    else if (!message().GetPayload(&buffer, &size))
+    {
+        PyErr_SetString(PyExc_BufferError, "message has no payload");
+        result = -1;
+    }
+    else
+    {
+        result = PyBuffer_FillInfo(view, exporter, (void*)buffer, (Py_ssize_t)size, 1, flags);
+    }
+    return result;
+}
+
+PyObject *IoTHubMessageGetMemoryview(boost::python::object &message)
+{
+    PyObject *pyObject = PyMemoryView_FromObject(message.ptr());
+    if (pyObject == NULL)
+    {
+        boost::python::throw_error_already_set();
+    }
+    return pyObject;
+}
+
 //
 //  iothub_client.h
 //
@@ -728,6 +803,7 @@ public:
         case IOTHUB_CLIENT_ERROR: s << "ERROR"; break;
         case IOTHUB_CLIENT_INVALID_SIZE: s << "INVALID_SIZE"; break;
         case IOTHUB_CLIENT_INDEFINITE_TIME: s << "INDEFINITE_TIME"; break;
+        case IOTHUB_CLIENT_QUEUE_FULL: s << "QUEUE_FULL"; break;
         }
         return s.str();
     }
@@ -760,13 +836,15 @@ struct IOTHUB_CONFIG
 
 // callbacks
 
+// the Python objects are released under the GIL, together with the context
 typedef struct
 {
     boost::python::object messageCallback;
     boost::python::object userContext;
-    IoTHubMessage *eventMessage;
+    boost::python::object eventMessage; // pinned while in flight, given back to messageCallback
 } SendContext;
 
+// every event has its own confirmation callback, so that no transport can drop a confirmation
 extern "C"
 void
 SendConfirmationCallback(
@@ -775,23 +853,17 @@ SendConfirmationCallback(
     )
 {
     SendContext *sendContext = (SendContext *)sendContextCallback;
-    IoTHubMessage *eventMessage = sendContext->eventMessage;
-    boost::python::object userContext = sendContext->userContext;
-    boost::python::object messageCallback = sendContext->messageCallback;
+    ScopedGILAcquire acquire;
+    try {
+        sendContext->messageCallback(sendContext->eventMessage, result, sendContext->userContext);
+    }
+    catch (const boost::python::error_already_set)
     {
-        ScopedGILAcquire acquire;
-        try {
-            messageCallback(eventMessage, result, userContext);
-        }
-        catch (const boost::python::error_already_set)
-        {
-            // Catch and ignore exception that is thrown in Python callback.
-            // There is nothing we can do about it here.
-            PyErr_Print();
-        }
+        // Catch and ignore exception that is thrown in Python callback.
+        // There is nothing we can do about it here.
+        PyErr_Print();
     }
     delete sendContext;
-    delete eventMessage;
 }
 
 typedef struct
@@ -807,15 +879,18 @@ ReceiveMessageCallback(
     void* receiveContextCallback
     )
 {
-    boost::python::object returnObject;
+    IOTHUBMESSAGE_DISPOSITION_RESULT result = IOTHUBMESSAGE_ABANDONED;
     ReceiveContext *receiveContext = (ReceiveContext *)receiveContextCallback;
-    boost::python::object userContext = receiveContext->userContext;
-    boost::python::object messageCallback = receiveContext->messageCallback;
-    IoTHubMessage *message = new IoTHubMessage(IoTHubMessage_Clone(messageHandle));
+    // the message is handed to Python without another copy; Python owns the clone, so the callback can keep it
+    IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_Clone(messageHandle);
+    if (clone != NULL)
     {
         ScopedGILAcquire acquire;
         try {
-            returnObject = messageCallback(message, userContext);
+            boost::python::manage_new_object::apply<IoTHubMessage*>::type toPython;
+            boost::python::object message(boost::python::handle<>(toPython(new IoTHubMessage(clone))));
+            boost::python::object returnObject = receiveContext->messageCallback(message, receiveContext->userContext);
+            result = boost::python::extract<IOTHUBMESSAGE_DISPOSITION_RESULT>(returnObject);
         }
         catch (const boost::python::error_already_set)
         {
@@ -824,8 +899,7 @@ ReceiveMessageCallback(
             PyErr_Print();
         }
     }
-    delete message;
-    return boost::python::extract<IOTHUBMESSAGE_DISPOSITION_RESULT>(returnObject);
+    return result;
 }
 
 typedef struct
@@ -859,8 +933,70 @@ BlobUploadConfirmationCallback(
     delete blobUploadContext;
 }
 
+// converts the option to what IoTHubClient_SetOption and IoTHubClient_LL_SetOption expect
+template <typename HANDLE>
+IOTHUB_CLIENT_RESULT
+SetOptionFromPython(
+    HANDLE handle,
+    IOTHUB_CLIENT_RESULT (*setOption)(HANDLE handle, const char* optionName, const void* value),
+    std::string &optionName,
+    boost::python::object& option
+    )
+{
+    IOTHUB_CLIENT_RESULT result = IOTHUB_CLIENT_OK;
+#ifdef IS_PY3
+    if (PyUnicode_Check(option.ptr()))
+    {
+        std::string stringValue = boost::python::extract<std::string>(option);
+        {
+            ScopedGILRelease release;
+            result = setOption(handle, optionName.c_str(), stringValue.c_str());
+        }
+    }
+    else if (PyLong_Check(option.ptr()))
+    {
+        // Cast to 64 bit value, as SetOption expects 64 bit for some integer options
+        uint64_t value = (uint64_t)boost::python::extract<long>(option);
+        {
+            ScopedGILRelease release;
+            result = setOption(handle, optionName.c_str(), &value);
+        }
+    }
+    else
+    {
+        PyErr_SetString(PyExc_TypeError, "set_option expected type long or unicode");
+        boost::python::throw_error_already_set();
+    }
+#else
+    if (PyString_Check(option.ptr()))
+    {
+        std::string stringValue = boost::python::extract<std::string>(option);
+        {
+            ScopedGILRelease release;
+            result = setOption(handle, optionName.c_str(), stringValue.c_str());
+        }
+    }
+    else if (PyInt_Check(option.ptr()))
+    {
+        // Cast to 64 bit value, as SetOption expects 64 bit for some integer options
+        uint64_t value = (uint64_t)boost::python::extract<int>(option);
+        {
+            ScopedGILRelease release;
+            result = setOption(handle, optionName.c_str(), &value);
+        }
+    }
+    else
+    {
+        PyErr_SetString(PyExc_TypeError, "set_option expected type int or string");
+        boost::python::throw_error_already_set();
+    }
+#endif
+    return result;
+}
+
 class IoTHubClient
 {
+    friend class IoTHubClientLL;
 
     static IOTHUB_CLIENT_TRANSPORT_PROVIDER
         GetProtocol(IOTHUB_TRANSPORT_PROVIDER _protocol)
@@ -994,11 +1130,18 @@ public:
     }
 
     void SendEventAsync(
-        IoTHubMessage &eventMessage,
+        boost::python::object& eventMessage,
         boost::python::object& messageCallback,
         boost::python::object& userContext
         )
     {
+        boost::python::extract<IoTHubMessage&> message(eventMessage);
+        if (!message.check())
+        {
+            PyErr_SetString(PyExc_TypeError, "send_event_async expected type IoTHubMessage");
+            boost::python::throw_error_already_set();
+            return;
+        }
         if (!PyCallable_Check(messageCallback.ptr()))
         {
             PyErr_SetString(PyExc_TypeError, "send_event_async expected type callable");
@@ -1006,16 +1149,18 @@ public:
             return;
         }
         IOTHUB_CLIENT_RESULT result;
+        IOTHUB_MESSAGE_HANDLE messageHandle = message().Handle();
         SendContext *sendContext = new SendContext();
         sendContext->messageCallback = messageCallback;
         sendContext->userContext = userContext;
-        sendContext->eventMessage = eventMessage.Clone();
+        sendContext->eventMessage = eventMessage;
         {
             ScopedGILRelease release;
-            result = IoTHubClient_SendEventAsync(iotHubClientHandle, eventMessage.Handle(), SendConfirmationCallback, sendContext);
+            result = IoTHubClient_SendEventAsync(iotHubClientHandle, messageHandle, SendConfirmationCallback, sendContext);
         }
         if (result != IOTHUB_CLIENT_OK)
         {
+            delete sendContext;
             throw IoTHubClientError(__func__, result);
         }
     }
@@ -1080,54 +1225,7 @@ public:
         boost::python::object& option
         )
     {
-        IOTHUB_CLIENT_RESULT result = IOTHUB_CLIENT_OK;
-#ifdef IS_PY3
-        if (PyUnicode_Check(option.ptr()))
-        {
-            std::string stringValue = boost::python::extract<std::string>(option);
-            {
-                ScopedGILRelease release;
-                result = IoTHubClient_SetOption(iotHubClientHandle, optionName.c_str(), stringValue.c_str());
-            }
-        }
-        else if (PyLong_Check(option.ptr()))
-        {
-            // Cast to 64 bit value, as SetOption expects 64 bit for some integer options
-            uint64_t value = (uint64_t)boost::python::extract<long>(option);
-            {
-                ScopedGILRelease release;
-                result = IoTHubClient_SetOption(iotHubClientHandle, optionName.c_str(), &value);
-            }
-        }
-        else
-        {
-            PyErr_SetString(PyExc_TypeError, "set_option expected type long or unicode");
-            boost::python::throw_error_already_set();
-        }
-#else
-        if (PyString_Check(option.ptr()))
-        {
-            std::string stringValue = boost::python::extract<std::string>(option);
-            {
-                ScopedGILRelease release;
-                result = IoTHubClient_SetOption(iotHubClientHandle, optionName.c_str(), stringValue.c_str());
-            }
-        }
-        else if (PyInt_Check(option.ptr()))
-        {
-            // Cast to 64 bit value, as SetOption expects 64 bit for some integer options
-            uint64_t value = (uint64_t)boost::python::extract<int>(option);
-            {
-                ScopedGILRelease release;
-                result = IoTHubClient_SetOption(iotHubClientHandle, optionName.c_str(), &value);
-            }
-        }
-        else
-        {
-            PyErr_SetString(PyExc_TypeError, "set_option expected type int or string");
-            boost::python::throw_error_already_set();
-        }
-#endif
+        IOTHUB_CLIENT_RESULT result = SetOptionFromPython(iotHubClientHandle, IoTHubClient_SetOption, optionName, option);
         if (result != IOTHUB_CLIENT_OK)
         {
             throw IoTHubClientError(__func__, result);
@@ -1178,6 +1276,170 @@ public:
 #endif
 };
 
+// the single threaded client: no thread runs in the background, DoWork sends, receives
+// and calls the callbacks on the calling thread, so that an event loop can drive it
+
+class IoTHubClientLL
+{
+
+    IOTHUB_CLIENT_LL_HANDLE iotHubClientLLHandle;
+
+public:
+
+    IOTHUB_TRANSPORT_PROVIDER protocol;
+
+    IoTHubClientLL(const IoTHubClientLL& client)
+    {
+        (void)client;
+        throw IoTHubClientError(__func__, IOTHUB_CLIENT_ERROR);
+    }
+
+    IoTHubClientLL(
+        std::string connectionString,
+        IOTHUB_TRANSPORT_PROVIDER _protocol
+        ) :
+        protocol(_protocol)
+    {
+        IOTHUB_CLIENT_TRANSPORT_PROVIDER transportProvider = IoTHubClient::GetProtocol(_protocol);
+        {
+            ScopedGILRelease release;
+            iotHubClientLLHandle = IoTHubClient_LL_CreateFromConnectionString(connectionString.c_str(), transportProvider);
+        }
+        if (iotHubClientLLHandle == NULL)
+        {
+            throw IoTHubClientError(__func__, IOTHUB_CLIENT_ERROR);
+        }
+    }
+
+    ~IoTHubClientLL()
+    {
+        Destroy();
+    }
+
+    void Destroy()
+    {
+        if (iotHubClientLLHandle != NULL)
+        {
+            {
+                // the events still waiting are confirmed with BECAUSE_DESTROY
+                ScopedGILRelease release;
+                IoTHubClient_LL_Destroy(iotHubClientLLHandle);
+            }
+            iotHubClientLLHandle = NULL;
+        }
+    }
+
+    void SendEventAsync(
+        boost::python::object& eventMessage,
+        boost::python::object& messageCallback,
+        boost::python::object& userContext
+        )
+    {
+        boost::python::extract<IoTHubMessage&> message(eventMessage);
+        if (!message.check())
+        {
+            PyErr_SetString(PyExc_TypeError, "send_event_async expected type IoTHubMessage");
+            boost::python::throw_error_already_set();
+            return;
+        }
+        if (!PyCallable_Check(messageCallback.ptr()))
+        {
+            PyErr_SetString(PyExc_TypeError, "send_event_async expected type callable");
+            boost::python::throw_error_already_set();
+            return;
+        }
+        IOTHUB_CLIENT_RESULT result;
+        IOTHUB_MESSAGE_HANDLE messageHandle = message().Handle();
+        SendContext *sendContext = new SendContext();
+        sendContext->messageCallback = messageCallback;
+        sendContext->userContext = userContext;
+        sendContext->eventMessage = eventMessage;
+        {
+            ScopedGILRelease release;
+            result = IoTHubClient_LL_SendEventAsync(iotHubClientLLHandle, messageHandle, SendConfirmationCallback, sendContext);
+        }
+        if (result != IOTHUB_CLIENT_OK)
+        {
+            delete sendContext;
+            throw IoTHubClientError(__func__, result);
+        }
+    }
+
+    void SetMessageCallback(
+        boost::python::object& messageCallback,
+        boost::python::object& userContext
+        )
+    {
+        if (!PyCallable_Check(messageCallback.ptr()))
+        {
+            PyErr_SetString(PyExc_TypeError, "set_message_callback expected type callable");
+            boost::python::throw_error_already_set();
+            return;
+        }
+        ReceiveContext *receiveContext = new ReceiveContext();
+        receiveContext->messageCallback = messageCallback;
+        receiveContext->userContext = userContext;
+        IOTHUB_CLIENT_RESULT result;
+        {
+            ScopedGILRelease release;
+            result = IoTHubClient_LL_SetMessageCallback(iotHubClientLLHandle, ReceiveMessageCallback, receiveContext);
+        }
+        if (result != IOTHUB_CLIENT_OK)
+        {
+            delete receiveContext;
+            throw IoTHubClientError(__func__, result);
+        }
+    }
+
+    void DoWork()
+    {
+        ScopedGILRelease release;
+        IoTHubClient_LL_DoWork(iotHubClientLLHandle);
+    }
+
+    IOTHUB_CLIENT_STATUS GetSendStatus()
+    {
+        IOTHUB_CLIENT_STATUS iotHubClientStatus;
+        IOTHUB_CLIENT_RESULT result;
+        {
+            ScopedGILRelease release;
+            result = IoTHubClient_LL_GetSendStatus(iotHubClientLLHandle, &iotHubClientStatus);
+        }
+        if (result != IOTHUB_CLIENT_OK)
+        {
+            throw IoTHubClientError(__func__, result);
+        }
+        return iotHubClientStatus;
+    }
+
+    time_t GetLastMessageReceiveTime()
+    {
+        time_t lastMessageReceiveTime;
+        IOTHUB_CLIENT_RESULT result;
+        {
+            ScopedGILRelease release;
+            result = IoTHubClient_LL_GetLastMessageReceiveTime(iotHubClientLLHandle, &lastMessageReceiveTime);
+        }
+        if (result != IOTHUB_CLIENT_OK)
+        {
+            throw IoTHubClientError(__func__, result);
+        }
+        return lastMessageReceiveTime;
+    }
+
+    void SetOption(
+        std::string optionName,
+        boost::python::object& option
+        )
+    {
+        IOTHUB_CLIENT_RESULT result = SetOptionFromPython(iotHubClientLLHandle, IoTHubClient_LL_SetOption, optionName, option);
+        if (result != IOTHUB_CLIENT_OK)
+        {
+            throw IoTHubClientError(__func__, result);
+        }
+    }
+};
+
 using namespace boost::python;
 
 static const char* iothub_client_docstring =
@@ -1249,6 +1511,7 @@ BOOST_PYTHON_MODULE(IMPORT_NAME)
         .value("ERROR", IOTHUB_CLIENT_ERROR)
         .value("INVALID_SIZE", IOTHUB_CLIENT_INVALID_SIZE)
         .value("INDEFINITE_TIME", IOTHUB_CLIENT_INDEFINITE_TIME)
+        .value("QUEUE_FULL", IOTHUB_CLIENT_QUEUE_FULL)
         ;
 
     enum_<IOTHUB_CLIENT_STATUS>("IoTHubClientStatus")
@@ -1304,10 +1567,11 @@ BOOST_PYTHON_MODULE(IMPORT_NAME)
 #endif
         ;
 
-    class_<IoTHubMessage>("IoTHubMessage", no_init)
+    class_<IoTHubMessage> iotHubMessageClass("IoTHubMessage", no_init);
+    iotHubMessageClass
         .def(init<PyObject *>())
-        .def(init<std::string>())
         .def("get_bytearray", &IoTHubMessage::GetBytearray)
+        .def("get_memoryview", &IoTHubMessageGetMemoryview)
         .def("get_string", &IoTHubMessage::GetString)
         .def("get_content_type", &IoTHubMessage::GetContentType)
         .def("properties", &IoTHubMessage::Properties, return_internal_reference<1>())
@@ -1319,6 +1583,12 @@ BOOST_PYTHON_MODULE(IMPORT_NAME)
         .def("__repr__", &IoTHubMessage::repr)
 #endif
         ;
+    // boost python classes are heap types, their buffer slots can be filled in after creation
+    PyTypeObject *iotHubMessageType = (PyTypeObject *)iotHubMessageClass.ptr();
+    iotHubMessageType->tp_as_buffer->bf_getbuffer = IoTHubMessageGetBuffer;
+#ifndef IS_PY3
+    iotHubMessageType->tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
 
     class_<IoTHubClient, boost::noncopyable>("IoTHubClient", no_init)
         .def(init<std::string, IOTHUB_TRANSPORT_PROVIDER>())
@@ -1336,5 +1606,18 @@ BOOST_PYTHON_MODULE(IMPORT_NAME)
         .def("__repr__", &IoTHubClient::repr)
 #endif
         ;
+
+    class_<IoTHubClientLL, boost::noncopyable>("IoTHubClientLL", no_init)
+        .def(init<std::string, IOTHUB_TRANSPORT_PROVIDER>())
+        .def("send_event_async", &IoTHubClientLL::SendEventAsync)
+        .def("set_message_callback", &IoTHubClientLL::SetMessageCallback)
+        .def("set_option", &IoTHubClientLL::SetOption)
+        .def("get_send_status", &IoTHubClientLL::GetSendStatus)
+        .def("get_last_message_receive_time", &IoTHubClientLL::GetLastMessageReceiveTime)
+        .def("do_work", &IoTHubClientLL::DoWork)
+        .def("destroy", &IoTHubClientLL::Destroy)
+        // attributes
+        .def_readonly("protocol", &IoTHubClientLL::protocol)
+        ;
 };
 
@@ -189,9 +189,14 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
     (void)iotHubClientHandle;
 }
 
+// events are confirmed at once
 IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
 {
-    (void)iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback;
+    (void)iotHubClientHandle, eventMessageHandle;
+    if (eventConfirmationCallback != NULL)
+    {
+        eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, userContextCallback);
+    }
     return IOTHUB_CLIENT_OK;
 }
 
@@ -336,6 +341,105 @@ void IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
     (void)iotHubMessageHandle;
 }
 
+// "iothub_client_ll.h"
+
+// the LL mock is a loopback: DoWork confirms the events sent since the last call, oldest first,
+// and gives each of them back to the message callback
+
+IOTHUB_CLIENT_LL_HANDLE mockClientLLHandle = (IOTHUB_CLIENT_LL_HANDLE)0x12345678;
+#define MOCKPENDINGSIZE 64
+IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK mockPendingCallback[MOCKPENDINGSIZE];
+void* mockPendingContext[MOCKPENDINGSIZE];
+size_t mockPendingCount = 0;
+IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC mockLLMessageCallback = NULL;
+void* mockLLMessageContext = NULL;
+
+static void MockLLConfirmPending(IOTHUB_CLIENT_CONFIRMATION_RESULT result, bool loopback)
+{
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK callbacks[MOCKPENDINGSIZE];
+    void* contexts[MOCKPENDINGSIZE];
+    size_t count = mockPendingCount;
+    for (size_t i = 0; i < count; i++)
+    {
+        callbacks[i] = mockPendingCallback[i];
+        contexts[i] = mockPendingContext[i];
+    }
+    mockPendingCount = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (callbacks[i] != NULL)
+        {
+            callbacks[i](result, contexts[i]);
+        }
+    }
+    if (loopback && (mockLLMessageCallback != NULL))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            (void)mockLLMessageCallback(mockMessageHandle, mockLLMessageContext);
+        }
+    }
+}
+
+IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateFromConnectionString(const char* connectionString, IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol)
+{
+    (void)connectionString, protocol;
+    mockPendingCount = 0;
+    mockLLMessageCallback = NULL;
+    return mockClientLLHandle;
+}
+
+void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    (void)iotHubClientHandle;
+    MockLLConfirmPending(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, false);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    (void)iotHubClientHandle, eventMessageHandle;
+    if (mockPendingCount == MOCKPENDINGSIZE)
+    {
+        return IOTHUB_CLIENT_QUEUE_FULL;
+    }
+    mockPendingCallback[mockPendingCount] = eventConfirmationCallback;
+    mockPendingContext[mockPendingCount++] = userContextCallback;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void* userContextCallback)
+{
+    (void)iotHubClientHandle;
+    mockLLMessageCallback = messageCallback;
+    mockLLMessageContext = userContextCallback;
+    return IOTHUB_CLIENT_OK;
+}
+
+void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    (void)iotHubClientHandle;
+    MockLLConfirmPending(IOTHUB_CLIENT_CONFIRMATION_OK, true);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetSendStatus(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATUS *iotHubClientStatus)
+{
+    (void)iotHubClientHandle;
+    *iotHubClientStatus = (mockPendingCount > 0) ? IOTHUB_CLIENT_SEND_STATUS_BUSY : IOTHUB_CLIENT_SEND_STATUS_IDLE;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetLastMessageReceiveTime(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, time_t* lastMessageReceiveTime)
+{
+    (void)iotHubClientHandle, lastMessageReceiveTime;
+    return IOTHUB_CLIENT_INDEFINITE_TIME;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, const char* optionName, const void* value)
+{
+    (void)iotHubClientHandle, optionName, value;
+    return IOTHUB_CLIENT_OK;
+}
+
 // "iothubtransporthttp.h"
 TRANSPORT_PROVIDER *mockProtocol = (TRANSPORT_PROVIDER *)0x12345678;
 const TRANSPORT_PROVIDER* HTTP_Protocol(void)
@@ -0,0 +1,68 @@
+#!/usr/bin/env python
+
+# Copyright (c) Microsoft. All rights reserved.
+# Licensed under the MIT license. See LICENSE file in the project root for
+# full license information.
+
+# Runs several clients on one asyncio event loop, without threads (Python 3.5+).
+# Every client sends message_count events and prints what it receives meanwhile.
+
+import asyncio
+import random
+import sys
+import iothub_client
+from iothub_client import *
+from iothub_client_args import *
+from iothub_client_asyncio import IoTHubClientAsync
+
+message_count = 5
+
+# chose AMQP or MQTT as transport protocol, do_work of HTTP blocks the event loop
+protocol = IoTHubTransportProvider.MQTT
+
+# String containing Hostname, Device Id & Device Key in the format:
+# "HostName=<host_name>;DeviceId=<device_id>;SharedAccessKey=<device_key>"
+# one client is run per connection string
+connection_strings = ["[device connection string]"]
+
+msg_txt = "{\"deviceId\": \"myPythonDevice\",\"windSpeed\": %.2f}"
+
+
+async def print_received(client, index):
+    while True:
+        message = await client.receive()
+        print("client %d received: %s" % (index, message.get_memoryview().tobytes()))
+
+
+async def run_device(connection_string, index):
+    async with IoTHubClientAsync.from_connection_string(connection_string, protocol) as client:
+        receiver = asyncio.ensure_future(print_received(client, index))
+        for i in range(0, message_count):
+            message = IoTHubMessage(bytearray(msg_txt % (10 + (random.random() * 4)), "utf8"))
+            result = await client.send_event(message)
+            print("client %d message %d confirmed: %s" % (index, i, result))
+        await asyncio.sleep(1)
+        receiver.cancel()
+
+
+def usage():
+    print("Usage: iothub_client_asyncio_sample.py -p <protocol> -c <connectionstring>")
+    print("    protocol        : <amqp, mqtt>")
+    print("    connectionstring: <HostName=<host_name>;DeviceId=<device_id>;SharedAccessKey=<device_key>>")
+
+
+if __name__ == '__main__':
+    print("\nPython %s" % sys.version)
+    print("IoT Hub for Python SDK Version: %s" % iothub_client.__version__)
+
+    try:
+        (connection_string, protocol) = get_iothub_opt(sys.argv[1:], connection_strings[0], protocol)
+        connection_strings[0] = connection_string
+    except OptionError as o:
+        print(o)
+        usage()
+        sys.exit(1)
+
+    loop = asyncio.get_event_loop()
+    loop.run_until_complete(asyncio.gather(*[run_device(c, i) for i, c in enumerate(connection_strings)]))
+    loop.close()
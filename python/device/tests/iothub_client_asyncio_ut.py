@@ -0,0 +1,73 @@
+#!/usr/bin/env python
+
+# Copyright (c) Microsoft. All rights reserved.
+# Licensed under the MIT license. See LICENSE file in the project root for
+# full license information.
+
+import asyncio
+import unittest
+from iothub_client_mock import *
+from iothub_client_asyncio import IoTHubClientAsync
+
+# connnection strings for mock testing
+connectionString = "HostName=mockhub.mock-devices.net;DeviceId=mockdevice;SharedAccessKey=1234567890123456789012345678901234567890ABCD"
+
+# the mock IoTHubClientLL confirms in do_work the events sent before and gives them back as received messages
+
+
+class TestIoTHubClientAsync(unittest.TestCase):
+
+    def setUp(self):
+        self.loop = asyncio.new_event_loop()
+
+    def tearDown(self):
+        self.loop.close()
+
+    def run_async(self, coroutine):
+        return self.loop.run_until_complete(asyncio.wait_for(coroutine, 5))
+
+    def create_client(self):
+        return IoTHubClientAsync(IoTHubClientLL(connectionString, IoTHubTransportProvider.MQTT), loop=self.loop)
+
+    def test_send_event(self):
+        async def test():
+            async with self.create_client() as client:
+                self.assertEqual(client.protocol, IoTHubTransportProvider.MQTT)
+                return await client.send_event(IoTHubMessage("myMessage"))
+        self.assertEqual(self.run_async(test()), IoTHubClientConfirmationResult.OK)
+
+    def test_send_events_concurrently(self):
+        async def test():
+            async with self.create_client() as client:
+                messages = [IoTHubMessage("myMessage") for i in range(10)]
+                return await asyncio.gather(*[client.send_event(message) for message in messages])
+        results = self.run_async(test())
+        self.assertEqual(results, [IoTHubClientConfirmationResult.OK] * 10)
+
+    def test_receive(self):
+        async def test():
+            async with self.create_client() as client:
+                await client.send_event(IoTHubMessage(bytearray("myMessage", "utf8")))
+                return await client.receive()
+        message = self.run_async(test())
+        self.assertIsInstance(message, IoTHubMessage)
+
+    def test_close_completes_events_in_flight(self):
+        async def test():
+            client = self.create_client()
+            sent = asyncio.ensure_future(client.send_event(IoTHubMessage("myMessage")))
+            await asyncio.sleep(0)
+            client.close()
+            return await sent
+        self.assertEqual(self.run_async(test()), IoTHubClientConfirmationResult.BECAUSE_DESTROY)
+
+    def test_send_event_after_close_fails(self):
+        async def test():
+            client = self.create_client()
+            client.close()
+            await client.send_event(IoTHubMessage("myMessage"))
+        with self.assertRaises(RuntimeError):
+            self.run_async(test())
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
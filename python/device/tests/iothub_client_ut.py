@@ -15,6 +15,7 @@ connectionString = "HostName=mockhub.mock-devices.net;DeviceId=mockdevice;Shared
 callback_key = ""
 callback_value = ""
 callback_message = ""
+send_confirmations = []
 
 
 def map_callback_ok(key, value):
@@ -40,6 +41,10 @@ def receive_message_callback(message, counter):
 def send_confirmation_callback(message, result, userContext):
     return
 
+
+def record_confirmation_callback(message, result, userContext):
+    send_confirmations.append((message, result, userContext))
+
 def blob_upload_callback(result, userContext):
     return
 
@@ -166,7 +171,8 @@ class TestEnumDefinitions(unittest.TestCase):
         self.assertEqual(IoTHubClientResult.ERROR, 2)
         self.assertEqual(IoTHubClientResult.INVALID_SIZE, 3)
         self.assertEqual(IoTHubClientResult.INDEFINITE_TIME, 4)
-        lastEnum = IoTHubClientResult.INDEFINITE_TIME + 1
+        self.assertEqual(IoTHubClientResult.QUEUE_FULL, 5)
+        lastEnum = IoTHubClientResult.QUEUE_FULL + 1
         with self.assertRaises(AttributeError):
             self.assertEqual(IoTHubClientResult.ANY, 0)
         clientResult = IoTHubClientResult()
@@ -367,10 +373,26 @@ class TestClassDefinitions(unittest.TestCase):
             message = IoTHubMessage()
         with self.assertRaises(Exception):
             message = IoTHubMessage(1)
-        with self.assertRaises(Exception):
-            message = IoTHubMessage(buffer(messageString))
         message = IoTHubMessage(messageString)
         self.assertIsInstance(message, IoTHubMessage)
+        # any object with a buffer
+        message = IoTHubMessage(memoryview(bytearray(messageString, "utf8")))
+        self.assertIsInstance(message, IoTHubMessage)
+        self.assertEqual(message.get_bytearray(), b"myMessage")
+        if sys.version_info >= (3, 0):
+            message = IoTHubMessage(bytes(messageString, "utf8"))
+            self.assertIsInstance(message, IoTHubMessage)
+            self.assertEqual(message.get_bytearray(), b"myMessage")
+        # get_memoryview
+        message = IoTHubMessage(bytearray(messageString, "utf8"))
+        with self.assertRaises(Exception):
+            message.get_memoryview(1)
+        view = message.get_memoryview()
+        self.assertTrue(view.readonly)
+        self.assertEqual(view.tobytes(), b"myMessage")
+        self.assertEqual(memoryview(message).tobytes(), b"myMessage")
+        message = IoTHubMessage(messageString)
+        self.assertEqual(message.get_memoryview().tobytes(), b"myMessage")
         # get_bytearray
         message = IoTHubMessage(bytearray(messageString, "utf8"))
         self.assertIsInstance(message, IoTHubMessage)
@@ -543,6 +565,15 @@ class TestClassDefinitions(unittest.TestCase):
         result = client.send_event_async(
             message, send_confirmation_callback, counter)
         self.assertIsNone(result)
+        # the confirmation gives back the message that was sent, not a copy
+        del send_confirmations[:]
+        result = client.send_event_async(
+            message, record_confirmation_callback, counter)
+        self.assertIsNone(result)
+        self.assertEqual(len(send_confirmations), 1)
+        self.assertIs(send_confirmations[0][0], message)
+        self.assertEqual(send_confirmations[0][1], IoTHubClientConfirmationResult.OK)
+        self.assertEqual(send_confirmations[0][2], counter)
         # get_send_status
         with self.assertRaises(AttributeError):
             client.GetSendStatus()
@@ -594,5 +625,57 @@ class TestClassDefinitions(unittest.TestCase):
         result = client.upload_blob_async(destinationFileName, source, size, send_confirmation_callback, None)
         self.assertIsNone(result)
 
+    def test_IoTHubClientLL(self):
+        # constructor
+        with self.assertRaises(Exception):
+            client = IoTHubClientLL()
+        with self.assertRaises(Exception):
+            client = IoTHubClientLL(connectionString)
+        with self.assertRaises(Exception):
+            client = IoTHubClientLL(connectionString, 1)
+        client = IoTHubClientLL(connectionString, IoTHubTransportProvider.AMQP)
+        self.assertIsInstance(client, IoTHubClientLL)
+        self.assertEqual(client.protocol, IoTHubTransportProvider.AMQP)
+        with self.assertRaises(AttributeError):
+            client.protocol = IoTHubTransportProvider.MQTT
+        # send_event_async: the confirmations come in do_work
+        counter = 1
+        message = IoTHubMessage("myMessage")
+        with self.assertRaises(Exception):
+            client.send_event_async(message, send_confirmation_callback)
+        with self.assertRaises(Exception):
+            client.send_event_async(send_confirmation_callback, message, counter)
+        del send_confirmations[:]
+        result = client.send_event_async(message, record_confirmation_callback, counter)
+        self.assertIsNone(result)
+        self.assertEqual(len(send_confirmations), 0)
+        self.assertEqual(client.get_send_status(), IoTHubClientStatus.BUSY)
+        # set_message_callback
+        with self.assertRaises(Exception):
+            client.set_message_callback(counter, receive_message_callback)
+        result = client.set_message_callback(receive_message_callback, counter)
+        self.assertIsNone(result)
+        # do_work
+        with self.assertRaises(Exception):
+            client.do_work(1)
+        result = client.do_work()
+        self.assertIsNone(result)
+        self.assertEqual(len(send_confirmations), 1)
+        self.assertIs(send_confirmations[0][0], message)
+        self.assertEqual(send_confirmations[0][1], IoTHubClientConfirmationResult.OK)
+        self.assertEqual(client.get_send_status(), IoTHubClientStatus.IDLE)
+        # set_option
+        with self.assertRaises(TypeError):
+            client.set_option("timeout", bytearray("241000", "utf8"))
+        result = client.set_option("timeout", "241000")
+        self.assertIsNone(result)
+        # destroy: the events still waiting are confirmed
+        del send_confirmations[:]
+        client.send_event_async(message, record_confirmation_callback, counter)
+        result = client.destroy()
+        self.assertIsNone(result)
+        self.assertEqual(len(send_confirmations), 1)
+        self.assertEqual(send_confirmations[0][1], IoTHubClientConfirmationResult.BECAUSE_DESTROY)
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)